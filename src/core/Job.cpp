@@ -36,15 +36,15 @@ static void setThreadName(const std::string& name) {
     std::wstring wide(name.begin(), name.end());
     SetThreadDescription(GetCurrentThread(), wide.c_str());
 }
+#else
+static void setThreadName(const std::string&) {}
+#endif
 static std::string threadName(uint32_t i) {
     if (i < 26)
         return std::string(1, char('A' + i));
     i -= 26;
     return std::string(1, char('A' + i / 26)) + char('A' + i % 26);
 }
-#else
-static void setThreadName(const std::string&) {}
-#endif
 
 namespace core {
 
@@ -95,6 +95,60 @@ namespace core {
         _cv.notify_one();
     }
 
+    void ThreadPool::parallel_for(uint32_t count, uint32_t grain, std::function<void(uint32_t, uint32_t)> fn) {
+        if (count == 0) return;
+        grain = std::max(grain, 1u);
+        uint32_t numChunks = (count + grain - 1) / grain;
+        if (numChunks == 1 || _workers.empty()) {
+            fn(0, count);
+            return;
+        }
+
+        // Shared with the helper tasks, which can start after the loop is over
+        struct State {
+            std::function<void(uint32_t, uint32_t)> fn;
+            uint32_t count;
+            uint32_t grain;
+            uint32_t numChunks;
+            std::atomic_uint32_t nextChunk{ 0 };
+            std::atomic_uint32_t doneChunks{ 0 };
+            std::mutex mutex;
+            std::condition_variable cv;
+
+            void run() {
+                uint32_t numDone = 0;
+                for (uint32_t c = nextChunk.fetch_add(1); c < numChunks; c = nextChunk.fetch_add(1)) {
+                    uint32_t begin = c * grain;
+                    fn(begin, std::min(begin + grain, count));
+                    ++numDone;
+                }
+                if (numDone && (doneChunks.fetch_add(numDone) + numDone) == numChunks) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cv.notify_all();
+                }
+            }
+        };
+        auto state = std::make_shared<State>();
+        state->fn = std::move(fn);
+        state->count = count;
+        state->grain = grain;
+        state->numChunks = numChunks;
+
+        uint32_t numHelpers = std::min(threadCount(), numChunks - 1);
+        for (uint32_t i = 0; i < numHelpers; ++i) {
+            enqueue([state]() { state->run(); });
+        }
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&]() { return state->doneChunks.load() == state->numChunks; });
+    }
+
+    ThreadPool& ThreadPool::shared() {
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        return pool;
+    }
+
     // -------------------------------------------------------------------------
     // Job
     // -------------------------------------------------------------------------
@@ -258,14 +312,13 @@ namespace core {
     // -------------------------------------------------------------------------
 
     JobScheduler::JobScheduler(uint32_t num_threads) {
+        // A one-shot graph blocks the worker running it while its jobs run on the others, keep at least 2
         if (num_threads == 0)
-            num_threads = std::thread::hardware_concurrency();
+            num_threads = std::max(std::thread::hardware_concurrency(), 2u);
         _pool = std::make_unique<ThreadPool>(num_threads);
     }
 
     JobScheduler::~JobScheduler() {
-        for (auto& [graph, future] : _oneshot)
-            delete future;
     }
 
     uint32_t JobScheduler::threadCount() const {
@@ -276,8 +329,8 @@ namespace core {
         _recurring.push_back(graph);
     }
 
-    JobFuture& JobScheduler::once(const JobGraphPtr& graph) {
-        auto* future = new JobFuture();
+    JobFuturePtr JobScheduler::once(const JobGraphPtr& graph) {
+        auto future = std::make_shared<JobFuture>();
         _oneshot.push_back({ graph, future });
 
         // Dispatch immediately to the pool — non-blocking.
@@ -295,7 +348,7 @@ namespace core {
             future->_state.store(JobFuture::State::Done, std::memory_order_release);
         });
 
-        return *future;
+        return future;
     }
 
     void JobScheduler::tick() {
@@ -303,15 +356,11 @@ namespace core {
         for (auto& graph : _recurring)
             graph->execute(*_pool);
 
-        // Collect completed one-shots
+        // Collect the completed one-shots, the caller shares the ownership of their future
         _oneshot.erase(
             std::remove_if(_oneshot.begin(), _oneshot.end(),
-                [](const std::pair<JobGraphPtr, JobFuture*>& entry) {
-                    if (entry.second->isDone()) {
-                        delete entry.second;
-                        return true;
-                    }
-                    return false;
+                [](const std::pair<JobGraphPtr, JobFuturePtr>& entry) {
+                    return entry.second->isDone();
                 }),
             _oneshot.end());
     }
@@ -619,11 +668,11 @@ void runJobTests() {
                 });
 
         JobScheduler scheduler;
-        JobFuture& future = scheduler.once(process->graph());
+        auto future = scheduler.once(process->graph());
 
         // Simulate a few frames polling for completion
         int frames = 0;
-        while (!future.isDone()) {
+        while (!future->isDone()) {
             scheduler.tick();   // drives recurring graphs (none here), collects done one-shots
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             ++frames;
@@ -634,7 +683,7 @@ void runJobTests() {
         assert(result.ready);
         assert(result.processed == "raw_data_processed");
         picoLogf("JobTest 6 passed: async load→process chain done in {} frames, {}us",
-            frames, future.elapsedUs());
+            frames, future->elapsedUs());
     }
 
     picoLog("JobTest: all tests passed.");
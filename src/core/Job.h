@@ -72,6 +72,14 @@ namespace core {
         void     enqueue(std::function<void()> fn);
         uint32_t threadCount() const { return static_cast<uint32_t>(_workers.size()); }
 
+        // Split [0, count) in chunks of grain elements and call fn(begin, end) for each chunk.
+        // The calling thread processes chunks too, returns once every chunk is done.
+        void     parallel_for(uint32_t count, uint32_t grain, std::function<void(uint32_t, uint32_t)> fn);
+
+        // Process wide pool for work happening outside of a JobScheduler (asset loading, batch processing)
+        // Created on first use with hardware_concurrency - 1 workers.
+        static ThreadPool& shared();
+
     private:
         std::vector<std::thread>          _workers;
         std::deque<std::function<void()>> _queue;
@@ -264,7 +272,7 @@ namespace core {
             _read_resolvers.push_back(SlotResolver {
                 [out]() -> void* {
                     assert(out._job->_output_slots[out._slot_index]->_ready.load(std::memory_order_acquire));
-                    return &out._job->accessOutput<T>(out._slot_index);
+                    return &out._job->template accessOutput<T>(out._slot_index);
                 }
             });
 
@@ -360,6 +368,7 @@ namespace core {
         std::atomic<State>    _state      { State::Pending };
         std::atomic<uint32_t> _elapsed_us { 0 };
     };
+    using JobFuturePtr = std::shared_ptr<JobFuture>;
 
     // WaitFn: platform-agnostic event wait. Returns true if the event fired,
     // false on timeout. Used by EventJob to block on e.g. vsync.
@@ -417,7 +426,7 @@ namespace core {
     // JobScheduler — drives JobGraphs, recurring or one-shot
     //
     //   scheduler.every_frame(graph);          // re-executed each tick()
-    //   auto& future = scheduler.once(graph);  // executed once, observable
+    //   auto future = scheduler.once(graph);   // executed once, observable as long as the caller holds it
     //   scheduler.tick();                      // call once per frame, blocks until done
     //   auto vsync = scheduler.createEventJob("vsync", waitFn);
     // -------------------------------------------------------------------------
@@ -429,7 +438,7 @@ namespace core {
         ~JobScheduler();
 
         void       every_frame(const JobGraphPtr& graph);
-        JobFuture& once(const JobGraphPtr& graph);
+        JobFuturePtr once(const JobGraphPtr& graph);
         void       tick();
 
         EventJobHandlePtr createEventJob(std::string_view name, WaitFn waitFn);
@@ -439,7 +448,7 @@ namespace core {
     private:
         std::unique_ptr<ThreadPool>                      _pool;
         std::vector<JobGraphPtr>                         _recurring;
-        std::vector<std::pair<JobGraphPtr, JobFuture*>>  _oneshot;
+        std::vector<std::pair<JobGraphPtr, JobFuturePtr>> _oneshot;
     };
 
 } // namespace core
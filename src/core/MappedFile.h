@@ -0,0 +1,63 @@
+// MappedFile.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "dllmain.h"
+
+namespace core {
+
+    // Read only view of a whole file mapped in memory, unmapped on destruction
+    class CORE_API MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::string& filename) { open(filename); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+
+        bool isOpen() const { return _data != nullptr; }
+        const uint8_t* data() const { return _data; }
+        uint64_t size() const { return _size; }
+
+    private:
+        const uint8_t* _data{ nullptr };
+        uint64_t _size{ 0 };
+#ifdef _WIN32
+        void* _file{ nullptr };
+        void* _mapping{ nullptr };
+#else
+        int _file{ -1 };
+#endif
+    };
+}
@@ -217,6 +217,37 @@ namespace core
         }
     };
 
+    // The 6 planes (normal, distance) of the view frustum in world space,
+    // normals point inside: dot(plane.xyz(), p) + plane.w >= 0 for a point p in the frustum.
+    // Order is left, right, bottom, top, near, far. An infinite far plane gets a null plane.
+    inline void frustum_planes(const View& view, const Projection& proj, vec4 planes[6]) {
+        vec4 eyePlanes[6];
+        if (proj.isOrtho()) {
+            float hw = 0.5f * proj.orthoWidth();
+            float hh = 0.5f * proj.orthoHeight();
+            eyePlanes[0] = vec4(1.0f, 0.0f, 0.0f, hw);
+            eyePlanes[1] = vec4(-1.0f, 0.0f, 0.0f, hw);
+            eyePlanes[2] = vec4(0.0f, 1.0f, 0.0f, hh);
+            eyePlanes[3] = vec4(0.0f, -1.0f, 0.0f, hh);
+            eyePlanes[4] = vec4(0.0f, 0.0f, -1.0f, -proj._orthoNear);
+            eyePlanes[5] = vec4(0.0f, 0.0f, 1.0f, proj._orthoFar);
+        } else {
+            // looking down -z, the side planes go through the eye
+            float tx = proj.fovHalfTan(false);
+            float ty = proj.fovHalfTan(true);
+            eyePlanes[0] = vec4(normalize(vec3(1.0f, 0.0f, -tx)), 0.0f);
+            eyePlanes[1] = vec4(normalize(vec3(-1.0f, 0.0f, -tx)), 0.0f);
+            eyePlanes[2] = vec4(normalize(vec3(0.0f, 1.0f, -ty)), 0.0f);
+            eyePlanes[3] = vec4(normalize(vec3(0.0f, -1.0f, -ty)), 0.0f);
+            eyePlanes[4] = vec4(0.0f, 0.0f, -1.0f, -proj.focal());
+            eyePlanes[5] = (proj._persFar > 0.0f ? vec4(0.0f, 0.0f, 1.0f, proj._persFar) : vec4(0.0f));
+        }
+        for (int i = 0; i < 6; ++i) {
+            vec3 n = rotateFrom(view._mat, eyePlanes[i].xyz());
+            planes[i] = vec4(n, eyePlanes[i].w - dot(n, view.eye()));
+        }
+    }
+
     struct ViewportRect {
         core::vec4 _rect{ 0.f, 0.f, 1280.f, 720.f}; // the rect of the viewport origin XY and Width Z & Height W
 
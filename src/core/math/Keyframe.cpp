@@ -0,0 +1,168 @@
+// Keyframe.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Keyframe.h"
+
+#include <vector>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include "../Log.h"
+
+// -------------------------------------------------------------------------
+// Simple test — call runKeyframeTests() to validate the key searches against
+// the linear scan and runKeyframeBenchmarks() to compare their cost
+// -------------------------------------------------------------------------
+
+namespace {
+    // The previous Key::ClipData::sampleInputTrack: linear scan from key 0
+    float linearInterval(const float* keys, uint32_t numKeys, float t, int32_t& i0, int32_t& i1) {
+        int idx0 = 0;
+        int idx1 = 0;
+        float val0 = keys[0];
+        float val1 = val0;
+        if (t >= val0) {
+            for (uint32_t i = 1; i < numKeys; ++i) {
+                float v = keys[i];
+                if (t < v) {
+                    val1 = v;
+                    idx1 = i;
+                    break;
+                }
+                val0 = v;
+                val1 = v;
+                idx0 = i;
+                idx1 = i;
+            }
+        }
+        float param = (val1 - val0);
+        if (param > 0.0f) {
+            param = (t - val0) / param;
+        } else {
+            idx1 = idx0;
+        }
+        i0 = idx0;
+        i1 = idx1;
+        return param;
+    }
+
+    // Keys every 1/30s, with a few repeated times as found in exported clips
+    std::vector<float> makeKeys(uint32_t numKeys) {
+        std::vector<float> keys(numKeys);
+        for (uint32_t i = 0; i < numKeys; ++i) {
+            keys[i] = float(i) / 30.0f;
+        }
+        for (uint32_t i = 7; i < numKeys; i += 97) {
+            keys[i] = keys[i - 1];
+        }
+        return keys;
+    }
+}
+
+void runKeyframeTests() {
+    using namespace core;
+    picoLog("KeyframeTest: starting...");
+
+    auto keys = makeKeys(1000);
+    const uint32_t numKeys = (uint32_t) keys.size();
+    const float duration = keys.back();
+
+    // --- Test 1: every search gives the linear scan interval ---
+    {
+        uint32_t cursor = 0;
+        for (int f = -10; f < 3200; ++f) {
+            // play forward at 60 fps, then jump around to exercise the fallback
+            float t = (f < 3000 ? f / 60.0f : fmodf(f * 7.31f, duration + 2.0f) - 1.0f);
+            int32_t r0, r1, i0, i1;
+            float rp = linearInterval(keys.data(), numKeys, t, r0, r1);
+            float p = keyframe_interval(keys.data(), numKeys, t, cursor, i0, i1);
+            assert(r0 == i0 && r1 == i1 && rp == p);
+            assert(keyframe_search(keys.data(), numKeys, t) == uint32_t(i0));
+        }
+        picoLog("KeyframeTest 1 passed: same intervals as the linear scan");
+    }
+
+    // --- Test 2: degenerate tracks ---
+    {
+        float single = 1.0f;
+        uint32_t cursor = 0;
+        int32_t i0, i1;
+        assert(keyframe_interval(&single, 1, 0.0f, cursor, i0, i1) == 0.0f && i0 == 0 && i1 == 0);
+        assert(keyframe_interval(&single, 1, 2.0f, cursor, i0, i1) == 0.0f && i0 == 0 && i1 == 0);
+
+        cursor = 12345; // stale cursor from a longer clip
+        assert(keyframe_interval(keys.data(), 10, 0.11f, cursor, i0, i1) > 0.0f && i0 == 3 && i1 == 4);
+        picoLog("KeyframeTest 2 passed: single key and stale cursor");
+    }
+
+    picoLog("KeyframeTest: all tests passed");
+}
+
+void runKeyframeBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    // Many concurrent anim instances playing the same track at different offsets
+    const uint32_t numChannels = 1024;
+    const uint32_t numFrames = 8;
+
+    for (uint32_t numKeys : { 100u, 1000u, 10000u, 100000u }) {
+        auto keys = makeKeys(numKeys);
+        float duration = keys.back();
+        std::vector<uint32_t> cursors(numChannels, 0);
+        std::vector<float> offsets(numChannels);
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            offsets[c] = duration * float(c) / float(numChannels);
+        }
+
+        double times[3] = { 0.0, 0.0, 0.0 };
+        float checksums[3] = { 0.0f, 0.0f, 0.0f };
+        for (int method = 0; method < 3; ++method) {
+            auto start = clock::now();
+            for (uint32_t f = 0; f < numFrames; ++f) {
+                for (uint32_t c = 0; c < numChannels; ++c) {
+                    float t = fmodf(offsets[c] + f / 60.0f, duration);
+                    int32_t i0, i1;
+                    float p;
+                    if (method == 0) {
+                        p = linearInterval(keys.data(), numKeys, t, i0, i1);
+                    } else if (method == 1) {
+                        uint32_t noCursor = 0xFFFFFFFF;
+                        p = keyframe_interval(keys.data(), numKeys, t, noCursor, i0, i1);
+                    } else {
+                        p = keyframe_interval(keys.data(), numKeys, t, cursors[c], i0, i1);
+                    }
+                    checksums[method] += p + float(i0);
+                }
+            }
+            times[method] = std::chrono::duration<double, std::nano>(clock::now() - start).count() / double(numFrames * numChannels);
+        }
+        assert(checksums[0] == checksums[1] && checksums[0] == checksums[2]);
+        picoLogf("KeyframeBench {} keys, {} channels: linear {:.1f} ns | binary search {:.1f} ns | cursor {:.1f} ns per channel",
+            numKeys, numChannels, times[0], times[1], times[2]);
+    }
+}
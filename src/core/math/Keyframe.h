@@ -0,0 +1,80 @@
+// Keyframe.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+
+#include "../dllmain.h"
+
+namespace core {
+
+    // Key time search in a sorted array of key times, the core of animation sampling.
+
+    // Index of the last key <= t, 0 if t is before the first key.
+    // Branchless binary search, the loop count only depends on numKeys.
+    inline uint32_t keyframe_search(const float* keys, uint32_t numKeys, float t) {
+        uint32_t base = 0;
+        uint32_t len = numKeys;
+        while (len > 1) {
+            uint32_t half = len >> 1;
+            base = (keys[base + half] <= t ? base + half : base);
+            len -= half;
+        }
+        return base;
+    }
+
+    // Same as keyframe_search starting from the key found by the previous call.
+    // Playing forward stays in the same or the next interval: O(1).
+    // Seeks and loops fall back to the binary search. The cursor is updated.
+    inline uint32_t keyframe_searchFrom(const float* keys, uint32_t numKeys, float t, uint32_t& cursor) {
+        uint32_t c = cursor;
+        if (c < numKeys && keys[c] <= t) {
+            if (c + 1 == numKeys || t < keys[c + 1]) {
+                return c;
+            }
+            if (c + 2 == numKeys || t < keys[c + 2]) {
+                cursor = c + 1;
+                return c + 1;
+            }
+        }
+        cursor = keyframe_search(keys, numKeys, t);
+        return cursor;
+    }
+
+    // The key interval [i0, i1] containing t and the interpolation param in it.
+    // Before the first key or after the last key, i0 = i1 is the clamped key and the param is 0.
+    inline float keyframe_interval(const float* keys, uint32_t numKeys, float t, uint32_t& cursor, int32_t& i0, int32_t& i1) {
+        uint32_t k = keyframe_searchFrom(keys, numKeys, t, cursor);
+        i0 = (int32_t) k;
+        i1 = (int32_t) k;
+        if (k + 1 < numKeys && keys[k] <= t) {
+            i1 = (int32_t) k + 1;
+            return (t - keys[k]) / (keys[k + 1] - keys[k]);
+        }
+        return 0.0f;
+    }
+}
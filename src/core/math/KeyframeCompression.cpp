@@ -0,0 +1,273 @@
+// KeyframeCompression.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "KeyframeCompression.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../Log.h"
+
+namespace core {
+
+    namespace {
+        // Greedy reduction: from the last kept key, extend the segment as long as
+        // the interpolation between its ends rebuilds every key it skips within tolerance
+        template <typename T, typename Interpolate, typename Distance>
+        uint32_t reduceKeys(const float* times, const T* values, uint32_t numKeys, float tolerance, std::vector<uint32_t>& kept,
+                            Interpolate interpolate, Distance distance) {
+            kept.clear();
+            if (numKeys == 0) return 0;
+            kept.push_back(0);
+
+            // A constant track only needs its first key
+            bool constant = true;
+            for (uint32_t i = 1; i < numKeys && constant; ++i) {
+                constant = distance(values[0], values[i]) <= tolerance;
+            }
+            if (constant) return 1;
+
+            uint32_t a = 0;
+            while (a + 1 < numKeys) {
+                uint32_t b = a + 1;
+                while (b + 1 < numKeys) {
+                    uint32_t c = b + 1;
+                    bool fits = true;
+                    for (uint32_t i = a + 1; i < c && fits; ++i) {
+                        float p = (times[i] - times[a]) / (times[c] - times[a]);
+                        fits = distance(interpolate(values[a], values[c], p), values[i]) <= tolerance;
+                    }
+                    if (!fits) break;
+                    b = c;
+                }
+                kept.push_back(b);
+                a = b;
+            }
+            return (uint32_t) kept.size();
+        }
+
+        // Offset of the key times in the compressed times, shared with a previous track if it has the same
+        uint32_t appendTimes(CompressedTracks& compressed, const std::vector<float>& times) {
+            for (const auto& track : compressed.tracks) {
+                if (track.numKeys != times.size()) continue;
+                if (std::equal(times.begin(), times.end(), compressed.times.begin() + track.timeOffset)) return track.timeOffset;
+            }
+            uint32_t offset = (uint32_t) compressed.times.size();
+            compressed.times.insert(compressed.times.end(), times.begin(), times.end());
+            return offset;
+        }
+
+        // Slerp between 2 keys about 180 degrees apart takes one way or the other on the sign of their dot product,
+        // a quantization error is enough to flip it. Split these intervals with the source midpoint.
+        void splitOpposedRotors(std::vector<float>& times, std::vector<rotor3>& values) {
+            const float OPPOSED_DOT = 0.25f;
+            for (size_t k = 1; k < values.size(); ++k) {
+                const auto& r0 = values[k - 1];
+                const auto& r1 = values[k];
+                float d = r0.a * r1.a + r0.b.xy * r1.b.xy + r0.b.xz * r1.b.xz + r0.b.yz * r1.b.yz;
+                if (std::fabs(d) < OPPOSED_DOT) {
+                    float t = 0.5f * (times[k - 1] + times[k]);
+                    rotor3 r = slerp(r0, r1, 0.5f);
+                    times.insert(times.begin() + k, t);
+                    values.insert(values.begin() + k, r);
+                    --k; // the first half can still be opposed
+                }
+            }
+        }
+    }
+
+    uint32_t keyframe_reduce(const float* times, const vec3* values, uint32_t numKeys, float tolerance, std::vector<uint32_t>& kept) {
+        return reduceKeys(times, values, numKeys, tolerance, kept,
+            [](const vec3& v0, const vec3& v1, float p) { return mix(v0, v1, p); },
+            [](const vec3& v0, const vec3& v1) { return length(v1 - v0); });
+    }
+
+    uint32_t keyframe_reduce(const float* times, const rotor3* values, uint32_t numKeys, float tolerance, std::vector<uint32_t>& kept) {
+        return reduceKeys(times, values, numKeys, tolerance, kept,
+            [](const rotor3& r0, const rotor3& r1, float p) { return slerp(r0, r1, p); },
+            [](const rotor3& r0, const rotor3& r1) { return rotor3_angle(r0, r1); });
+    }
+
+    uint32_t keyframe_compress(CompressedTracks& compressed, const float* times, const vec3* values, uint32_t numKeys, float tolerance) {
+        std::vector<uint32_t> kept;
+        keyframe_reduce(times, values, numKeys, tolerance, kept);
+
+        std::vector<float> keyTimes;
+        for (auto k : kept) keyTimes.push_back(times[k]);
+
+        KeyframeTrack track;
+        track.type = KEYFRAME_TRACK_VEC3;
+        track.numKeys = (uint32_t) kept.size();
+        track.timeOffset = appendTimes(compressed, keyTimes);
+        track.keyOffset = (uint32_t) compressed.keys.size();
+
+        vec3 rangeMax;
+        if (!kept.empty()) {
+            track.rangeMin = rangeMax = values[kept[0]];
+        }
+        for (auto k : kept) {
+            track.rangeMin = min(track.rangeMin, values[k]);
+            rangeMax = max(rangeMax, values[k]);
+        }
+        track.rangeExtent = rangeMax - track.rangeMin;
+
+        compressed.keys.resize(track.keyOffset + 3 * track.numKeys);
+        uint16_t* words = compressed.keys.data() + track.keyOffset;
+        for (auto k : kept) {
+            keyframe_pack48(values[k], track.rangeMin, track.rangeExtent, words);
+            words += 3;
+        }
+
+        compressed.tracks.push_back(track);
+        return (uint32_t) compressed.tracks.size() - 1;
+    }
+
+    uint32_t keyframe_compress(CompressedTracks& compressed, const float* times, const rotor3* values, uint32_t numKeys, float tolerance) {
+        std::vector<uint32_t> kept;
+        keyframe_reduce(times, values, numKeys, tolerance, kept);
+
+        std::vector<float> keyTimes;
+        std::vector<rotor3> keyValues;
+        for (auto k : kept) {
+            keyTimes.push_back(times[k]);
+            keyValues.push_back(values[k].normal());
+        }
+        splitOpposedRotors(keyTimes, keyValues);
+
+        KeyframeTrack track;
+        track.type = KEYFRAME_TRACK_ROTOR3;
+        track.numKeys = (uint32_t) keyValues.size();
+        track.timeOffset = appendTimes(compressed, keyTimes);
+        track.keyOffset = (uint32_t) compressed.keys.size();
+
+        compressed.keys.resize(track.keyOffset + 3 * track.numKeys);
+        uint16_t* words = compressed.keys.data() + track.keyOffset;
+        for (const auto& r : keyValues) {
+            keyframe_pack48(r, words);
+            words += 3;
+        }
+
+        compressed.tracks.push_back(track);
+        return (uint32_t) compressed.tracks.size() - 1;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runKeyframeCompressionTests() to validate the key
+// quantization and reduction against the uncompressed tracks
+// -------------------------------------------------------------------------
+
+namespace {
+    // Max error over a dense sampling of the track, uncompressed vs compressed
+    template <typename T, typename Interpolate, typename Distance>
+    float measureError(const core::CompressedTracks& compressed, uint32_t trackId, const std::vector<float>& times, const std::vector<T>& values,
+                       Interpolate interpolate, Distance distance) {
+        float maxError = 0.0f;
+        uint32_t cursor = 0, compressedCursor = 0;
+        float duration = times.back() - times.front();
+        for (uint32_t s = 0; s <= 1000; ++s) {
+            float t = times.front() + duration * (s / 1000.0f);
+            int32_t i0, i1;
+            float p = core::keyframe_interval(times.data(), (uint32_t) times.size(), t, cursor, i0, i1);
+            T v0, v1;
+            float cp = core::keyframe_decodeInterval(compressed, trackId, t, compressedCursor, v0, v1);
+            maxError = std::fmax(maxError, distance(interpolate(values[i0], values[i1], p), interpolate(v0, v1, cp)));
+        }
+        return maxError;
+    }
+}
+
+void runKeyframeCompressionTests() {
+    using namespace core;
+    picoLog("KeyframeCompressionTest: starting...");
+
+    auto mixVec3 = [](const vec3& v0, const vec3& v1, float p) { return mix(v0, v1, p); };
+    auto distVec3 = [](const vec3& v0, const vec3& v1) { return length(v1 - v0); };
+    auto slerpRotor = [](const rotor3& r0, const rotor3& r1, float p) { return slerp(r0, r1, p); };
+
+    // --- Test 1: 48 bits quantization round trip ---
+    {
+        float maxAngle = 0.0f;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            float f = float(i);
+            rotor3 r = rotor3(cos(f * 0.37f), sin(f * 1.3f), cos(f * 0.71f + 1.0f), sin(f * 0.23f + 2.0f) * 2.0f).normal();
+            uint16_t words[3];
+            keyframe_pack48(r, words);
+            maxAngle = std::fmax(maxAngle, rotor3_angle(r, keyframe_unpack48(words)));
+        }
+        assert(maxAngle < 2e-4f);
+
+        vec3 rangeMin(-10.0f, 0.0f, 5.0f), rangeExtent(20.0f, 0.0f, 1.0f);
+        vec3 v(3.3f, 0.0f, 5.7f);
+        uint16_t words[3];
+        keyframe_pack48(v, rangeMin, rangeExtent, words);
+        assert(length(keyframe_unpack48(words, rangeMin, rangeExtent) - v) < 2e-4f);
+        picoLogf("KeyframeCompressionTest 1 passed: 48 bits rotor max error {:.6f} rad", maxAngle);
+    }
+
+    // --- Test 2: reduction keeps the interpolated track within tolerance ---
+    {
+        const uint32_t numKeys = 300;
+        std::vector<float> times(numKeys);
+        std::vector<vec3> translations(numKeys), scales(numKeys);
+        std::vector<rotor3> rotations(numKeys);
+        for (uint32_t k = 0; k < numKeys; ++k) {
+            float t = k / 30.0f;
+            times[k] = t;
+            // linear segments, a curve and a constant
+            translations[k] = (t < 5.0f ? vec3(t, 0.0f, 2.0f * t) : vec3(5.0f, sin(t), 10.0f));
+            scales[k] = vec3(1.0f);
+            rotations[k] = rotor3::make_from_quaternion(vec4(0.0f, sin(0.1f * t), 0.0f, cos(0.1f * t)));
+        }
+
+        const float tolerance = 1e-3f;
+        std::vector<uint32_t> kept;
+        uint32_t numKept = keyframe_reduce(times.data(), translations.data(), numKeys, tolerance, kept);
+        assert(numKept < numKeys / 2 && kept.front() == 0 && kept.back() == numKeys - 1);
+        assert(keyframe_reduce(times.data(), scales.data(), numKeys, tolerance, kept) == 1);
+        // a rotation at constant speed is a slerp of its ends
+        assert(keyframe_reduce(times.data(), rotations.data(), numKeys, tolerance, kept) == 2);
+
+        CompressedTracks compressed;
+        auto tt = keyframe_compress(compressed, times.data(), translations.data(), numKeys, tolerance);
+        auto st = keyframe_compress(compressed, times.data(), scales.data(), numKeys, tolerance);
+        auto rt = keyframe_compress(compressed, times.data(), rotations.data(), numKeys, tolerance);
+
+        float translationError = measureError(compressed, tt, times, translations, mixVec3, distVec3);
+        float scaleError = measureError(compressed, st, times, scales, mixVec3, distVec3);
+        float rotationError = measureError(compressed, rt, times, rotations, slerpRotor, rotor3_angle);
+        // quantization adds half a step of the 16 bits range on top of the tolerance
+        assert(translationError < tolerance + 1e-3f);
+        assert(scaleError == 0.0f);
+        assert(rotationError < tolerance + 2e-4f);
+
+        uint64_t rawSize = numKeys * (3 * sizeof(float) + 3 * sizeof(vec3) + sizeof(rotor3));
+        picoLogf("KeyframeCompressionTest 2 passed: {} -> {} bytes (x{:.1f}), max error translation {:.5f} rotation {:.5f} rad",
+            rawSize, compressed.byteSize(), double(rawSize) / compressed.byteSize(), translationError, rotationError);
+    }
+
+    picoLog("KeyframeCompressionTest: all tests passed");
+}
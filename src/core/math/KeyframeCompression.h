@@ -0,0 +1,174 @@
+// KeyframeCompression.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include "Math3D.h"
+#include "Keyframe.h"
+#include "../dllmain.h"
+
+namespace core {
+
+    // Compressed keyframe tracks: the keys a linear interpolation can rebuild within a tolerance are dropped,
+    // the remaining values are quantized on 48 bits.
+    // - vec3 keys are quantized on 16 bits per component in the [min, min + extent] range of their track
+    // - rotor keys use the smallest three encoding: index of the largest component on 2 bits
+    //   and the 3 other components on 15 bits each, the largest one is rebuilt from the unit norm
+    // Key times are kept in float, the key interval search is the same as the uncompressed tracks.
+    // Tracks with the same key times share them.
+
+    enum KeyframeTrackType : uint32_t {
+        KEYFRAME_TRACK_EMPTY = 0,
+        KEYFRAME_TRACK_VEC3,
+        KEYFRAME_TRACK_ROTOR3,
+    };
+
+    struct KeyframeTrack {
+        uint32_t type{ KEYFRAME_TRACK_EMPTY };
+        uint32_t numKeys{ 0 };
+        uint32_t timeOffset{ 0 }; // first key time in CompressedTracks::times
+        uint32_t keyOffset{ 0 };  // first key value in CompressedTracks::keys, 3 words per key
+        vec3 rangeMin;            // vec3 tracks only
+        vec3 rangeExtent;
+    };
+
+    struct CompressedTracks {
+        std::vector<KeyframeTrack> tracks;
+        std::vector<float> times;
+        std::vector<uint16_t> keys;
+
+        uint64_t byteSize() const { return tracks.size() * sizeof(KeyframeTrack) + times.size() * sizeof(float) + keys.size() * sizeof(uint16_t); }
+    };
+
+    // 48 bits quantization of a vec3 in a range
+    inline void keyframe_pack48(const vec3& v, const vec3& rangeMin, const vec3& rangeExtent, uint16_t* words) {
+        for (int c = 0; c < 3; ++c) {
+            float n = (rangeExtent[c] > 0.0f ? (v[c] - rangeMin[c]) / rangeExtent[c] : 0.0f);
+            words[c] = (uint16_t) std::lround(std::fmin(std::fmax(n, 0.0f), 1.0f) * 65535.0f);
+        }
+    }
+    inline vec3 keyframe_unpack48(const uint16_t* words, const vec3& rangeMin, const vec3& rangeExtent) {
+        const float s = 1.0f / 65535.0f;
+        return vec3(rangeMin.x + rangeExtent.x * (words[0] * s),
+                    rangeMin.y + rangeExtent.y * (words[1] * s),
+                    rangeMin.z + rangeExtent.z * (words[2] * s));
+    }
+
+    // 48 bits smallest three quantization of a unit rotor. The components are encoded with the largest one positive,
+    // the last bit records the sign flip: r and -r are the same rotation but slerp takes a different path between keys
+    // 180 degrees apart.
+    inline void keyframe_pack48(const rotor3& r, uint16_t* words) {
+        const float q[4] = { r.a, r.b.xy, r.b.xz, r.b.yz };
+        uint32_t largest = 0;
+        for (uint32_t c = 1; c < 4; ++c) {
+            if (std::fabs(q[c]) > std::fabs(q[largest])) largest = c;
+        }
+        const float sign = (q[largest] < 0.0f ? -1.0f : 1.0f);
+        // the 3 smallest components are in [-1/sqrt(2), 1/sqrt(2)], quantized symmetrically so 0 is exact
+        const float scale = 1.41421356f * 16383.0f;
+
+        uint64_t bits = largest;
+        uint32_t shift = 2;
+        for (uint32_t c = 0; c < 4; ++c) {
+            if (c == largest) continue;
+            long n = std::lround(std::fmin(std::fmax(sign * q[c] * scale, -16383.0f), 16383.0f)) + 16383;
+            bits |= uint64_t(n) << shift;
+            shift += 15;
+        }
+        bits |= uint64_t(sign < 0.0f) << 47;
+        words[0] = uint16_t(bits);
+        words[1] = uint16_t(bits >> 16);
+        words[2] = uint16_t(bits >> 32);
+    }
+    inline rotor3 keyframe_unpack48(const uint16_t* words) {
+        uint64_t bits = uint64_t(words[0]) | (uint64_t(words[1]) << 16) | (uint64_t(words[2]) << 32);
+        uint32_t largest = uint32_t(bits & 3);
+        const float scale = 1.0f / (1.41421356f * 16383.0f);
+
+        float q[4];
+        float sum = 0.0f;
+        uint32_t shift = 2;
+        for (uint32_t c = 0; c < 4; ++c) {
+            if (c == largest) continue;
+            q[c] = float(int32_t((bits >> shift) & 0x7FFF) - 16383) * scale;
+            sum += q[c] * q[c];
+            shift += 15;
+        }
+        q[largest] = std::sqrt(std::fmax(1.0f - sum, 0.0f));
+        rotor3 r(q[0], q[1], q[2], q[3]);
+        return ((bits >> 47) & 1 ? -r : r);
+    }
+
+    // Angle in radians between the rotations of 2 unit rotors
+    // from the chord between the rotors, |r0 - r1| = 2 sin(angle / 4), accurate for the small angles
+    inline float rotor3_angle(const rotor3& r0, const rotor3& r1) {
+        float s = (r0.a * r1.a + r0.b.xy * r1.b.xy + r0.b.xz * r1.b.xz + r0.b.yz * r1.b.yz < 0.0f ? -1.0f : 1.0f);
+        float da = r0.a - s * r1.a, dxy = r0.b.xy - s * r1.b.xy, dxz = r0.b.xz - s * r1.b.xz, dyz = r0.b.yz - s * r1.b.yz;
+        float chord = std::sqrt(da * da + dxy * dxy + dxz * dxz + dyz * dyz);
+        return 4.0f * std::asin(std::fmin(0.5f * chord, 1.0f));
+    }
+
+    // Keyframe reduction: collect in kept the indices of the keys to keep so that the linear interpolation
+    // (slerp for the rotors) of the kept keys is within tolerance of every dropped key.
+    // The distance is the euclidian distance for vec3 and the rotation angle in radians for rotors.
+    // The first and last keys are always kept, returns the number of kept keys.
+    CORE_API uint32_t keyframe_reduce(const float* times, const vec3* values, uint32_t numKeys, float tolerance, std::vector<uint32_t>& kept);
+    CORE_API uint32_t keyframe_reduce(const float* times, const rotor3* values, uint32_t numKeys, float tolerance, std::vector<uint32_t>& kept);
+
+    // Reduce and quantize a track, appended to the compressed tracks. Returns the index of the track.
+    CORE_API uint32_t keyframe_compress(CompressedTracks& compressed, const float* times, const vec3* values, uint32_t numKeys, float tolerance);
+    CORE_API uint32_t keyframe_compress(CompressedTracks& compressed, const float* times, const rotor3* values, uint32_t numKeys, float tolerance);
+    // A track with no key, keeps the track indices aligned with the source tracks which are not compressed
+    inline uint32_t keyframe_compressEmpty(CompressedTracks& compressed) {
+        compressed.tracks.emplace_back();
+        return (uint32_t) compressed.tracks.size() - 1;
+    }
+
+    // Decode the key interval around t of a compressed track, same semantic as keyframe_interval.
+    // Returns the interpolation param between v0 and v1.
+    inline float keyframe_decodeInterval(const CompressedTracks& compressed, uint32_t trackId, float t, uint32_t& cursor, vec3& v0, vec3& v1) {
+        const auto& track = compressed.tracks[trackId];
+        int32_t i0, i1;
+        float p = keyframe_interval(compressed.times.data() + track.timeOffset, track.numKeys, t, cursor, i0, i1);
+        const uint16_t* keys = compressed.keys.data() + track.keyOffset;
+        v0 = keyframe_unpack48(keys + 3 * i0, track.rangeMin, track.rangeExtent);
+        v1 = keyframe_unpack48(keys + 3 * i1, track.rangeMin, track.rangeExtent);
+        return p;
+    }
+    inline float keyframe_decodeInterval(const CompressedTracks& compressed, uint32_t trackId, float t, uint32_t& cursor, rotor3& r0, rotor3& r1) {
+        const auto& track = compressed.tracks[trackId];
+        int32_t i0, i1;
+        float p = keyframe_interval(compressed.times.data() + track.timeOffset, track.numKeys, t, cursor, i0, i1);
+        const uint16_t* keys = compressed.keys.data() + track.keyOffset;
+        r0 = keyframe_unpack48(keys + 3 * i0);
+        r1 = keyframe_unpack48(keys + 3 * i1);
+        return p;
+    }
+}
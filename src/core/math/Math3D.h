@@ -109,6 +109,26 @@ namespace core
         mat4x3 m;
         return translation_rotation(m, t, r);
     }
+
+    // Scale of an RTS transform: the length of the rotation columns
+    inline vec3 scaling(const mat4x3& mat) {
+        return vec3(length(mat.x()), length(mat.y()), length(mat.z()));
+    }
+    // Set the length of the rotation columns keeping their direction, a null column restarts from its axis
+    inline mat4x3& scaling(mat4x3& mat, const vec3& s) {
+        const vec3 axes[3] = { vec3::X, vec3::Y, vec3::Z };
+        for (int c = 0; c < 3; ++c) {
+            float l = length(mat._columns[c]);
+            mat._columns[c] = (l > 0.0f ? mat._columns[c] * (s[c] / l) : axes[c] * s[c]);
+        }
+        return mat;
+    }
+    inline mat4x3& rotation_scaling(mat4x3& mat, const rotor3& r, const vec3& s) {
+        mat.x() = r.rotate_X() * s.x;
+        mat.y() = r.rotate_Y() * s.y;
+        mat.z() = r.rotate_Z() * s.z;
+        return mat;
+    }
     inline mat4x3& rotate(mat4x3& mat, const rotor3& r) {
         mat.x() = r.rotate(mat.x());
         mat.y() = r.rotate(mat.y());
@@ -222,6 +242,20 @@ namespace core
 #endif
     }
 
+    // Inverse of an affine transform with scale (transformTo is the inverse of a rigid transform only)
+    inline mat4x3 inverse(const mat4x3& m) {
+        // the rows of the inverted 3x3 are the cross products of the columns over the determinant
+        vec3 r0 = cross(m.y(), m.z());
+        vec3 r1 = cross(m.z(), m.x());
+        vec3 r2 = cross(m.x(), m.y());
+        float invDet = 1.0f / dot(m.x(), r0);
+        r0 = r0 * invDet;
+        r1 = r1 * invDet;
+        r2 = r2 * invDet;
+        vec3 t = -vec3(dot(r0, m.w()), dot(r1, m.w()), dot(r2, m.w()));
+        return mat4x3(vec3(r0.x, r1.x, r2.x), vec3(r0.y, r1.y, r2.y), vec3(r0.z, r1.z, r2.z), t);
+    }
+
     // Set the orientation part of a transform from the right (X) and up (Y) dirs
     inline mat4x3& transform_set_orientation_from_right_up(mat4x3& mat, const core::vec3& right, const core::vec3& up) {
         mat.x() = normalize(right); // make sure Right is normalized
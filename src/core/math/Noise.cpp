@@ -0,0 +1,484 @@
+// Noise.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Noise.h"
+
+#include <bit>
+
+#include "../Job.h"
+
+// The noise functions are written once as inline functions made of selects only, no branch and no table,
+// so the row kernels below inline them and vectorize 8 or 16 wide (see PICO_SIMD_AVX2), while the scalar
+// entry points run the exact same operations one sample at a time.
+// This file is compiled without floating point contraction (no fused multiply add) to keep the results
+// identical across compilers and instruction sets.
+
+// simplex3 is over the default inlining budget of the compilers
+#if defined(_MSC_VER)
+#define NOISE_INLINE __forceinline
+#else
+#define NOISE_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace {
+    using namespace core;
+
+    NOISE_INLINE int32_t floorToInt(float x) {
+        int32_t i = int32_t(x);
+        return i - int32_t(float(i) > x);
+    }
+
+    // quintic fade 6t^5 - 15t^4 + 10t^3
+    NOISE_INLINE float fade(float t) {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    NOISE_INLINE float lerp(float a, float b, float t) {
+        return a + t * (b - a);
+    }
+
+    // lattice hash to [-1, 1]
+    NOISE_INLINE float hashToFloat(uint32_t h) {
+        return float(h >> 8) * (2.0f / 16777215.0f) - 1.0f;
+    }
+
+    // Bitwise select and negate: the same on every compiler, and kept as masks by the vectorizer where
+    // a ternary over the hash bits can turn into branches or a lookup table
+    NOISE_INLINE float selectIf(uint32_t condition, float a, float b) {
+        uint32_t mask = 0u - condition;
+        return std::bit_cast<float>((std::bit_cast<uint32_t>(a) & mask) | (std::bit_cast<uint32_t>(b) & ~mask));
+    }
+
+    NOISE_INLINE float negateIf(uint32_t condition, float a) {
+        return std::bit_cast<float>(std::bit_cast<uint32_t>(a) ^ (condition << 31));
+    }
+
+    // max(t, 0) as a mask on the sign bit, compilers turn the plain max into a branch skipping the corner
+    NOISE_INLINE float positivePart(float t) {
+        uint32_t bits = std::bit_cast<uint32_t>(t);
+        return std::bit_cast<float>(bits & ~uint32_t(int32_t(bits) >> 31));
+    }
+
+    // dot of one of the 4 diagonal gradients (+-1, +-1) with (x, y)
+    NOISE_INLINE float grad2(uint32_t h, float x, float y) {
+        return negateIf(h & 1, x) + negateIf((h >> 1) & 1, y);
+    }
+
+    // dot of one of the 12 edge gradients of the cube with (x, y, z), Perlin's improved noise
+    NOISE_INLINE float grad3(uint32_t h, float x, float y, float z) {
+        h &= 15;
+        float u = selectIf(h < 8, x, y);
+        float v = selectIf(h < 4, y, selectIf((h & 13) == 12, x, z)); // x for h 12 and 14
+        return negateIf(h & 1, u) + negateIf((h >> 1) & 1, v);
+    }
+
+    NOISE_INLINE float value2(float x, float y, uint32_t seed) {
+        int32_t xi = floorToInt(x), yi = floorToInt(y);
+        float u = fade(x - float(xi)), v = fade(y - float(yi));
+        float n00 = hashToFloat(noise2D(xi, yi, seed));
+        float n10 = hashToFloat(noise2D(xi + 1, yi, seed));
+        float n01 = hashToFloat(noise2D(xi, yi + 1, seed));
+        float n11 = hashToFloat(noise2D(xi + 1, yi + 1, seed));
+        return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v);
+    }
+
+    NOISE_INLINE float value3(float x, float y, float z, uint32_t seed) {
+        int32_t xi = floorToInt(x), yi = floorToInt(y), zi = floorToInt(z);
+        float u = fade(x - float(xi)), v = fade(y - float(yi)), w = fade(z - float(zi));
+        float n000 = hashToFloat(noise3D(xi, yi, zi, seed));
+        float n100 = hashToFloat(noise3D(xi + 1, yi, zi, seed));
+        float n010 = hashToFloat(noise3D(xi, yi + 1, zi, seed));
+        float n110 = hashToFloat(noise3D(xi + 1, yi + 1, zi, seed));
+        float n001 = hashToFloat(noise3D(xi, yi, zi + 1, seed));
+        float n101 = hashToFloat(noise3D(xi + 1, yi, zi + 1, seed));
+        float n011 = hashToFloat(noise3D(xi, yi + 1, zi + 1, seed));
+        float n111 = hashToFloat(noise3D(xi + 1, yi + 1, zi + 1, seed));
+        return lerp(lerp(lerp(n000, n100, u), lerp(n010, n110, u), v),
+                    lerp(lerp(n001, n101, u), lerp(n011, n111, u), v), w);
+    }
+
+    NOISE_INLINE float gradient2(float x, float y, uint32_t seed) {
+        int32_t xi = floorToInt(x), yi = floorToInt(y);
+        float fx = x - float(xi), fy = y - float(yi);
+        float u = fade(fx), v = fade(fy);
+        float n00 = grad2(noise2D(xi, yi, seed), fx, fy);
+        float n10 = grad2(noise2D(xi + 1, yi, seed), fx - 1.0f, fy);
+        float n01 = grad2(noise2D(xi, yi + 1, seed), fx, fy - 1.0f);
+        float n11 = grad2(noise2D(xi + 1, yi + 1, seed), fx - 1.0f, fy - 1.0f);
+        return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v);
+    }
+
+    NOISE_INLINE float gradient3(float x, float y, float z, uint32_t seed) {
+        int32_t xi = floorToInt(x), yi = floorToInt(y), zi = floorToInt(z);
+        float fx = x - float(xi), fy = y - float(yi), fz = z - float(zi);
+        float u = fade(fx), v = fade(fy), w = fade(fz);
+        float n000 = grad3(noise3D(xi, yi, zi, seed), fx, fy, fz);
+        float n100 = grad3(noise3D(xi + 1, yi, zi, seed), fx - 1.0f, fy, fz);
+        float n010 = grad3(noise3D(xi, yi + 1, zi, seed), fx, fy - 1.0f, fz);
+        float n110 = grad3(noise3D(xi + 1, yi + 1, zi, seed), fx - 1.0f, fy - 1.0f, fz);
+        float n001 = grad3(noise3D(xi, yi, zi + 1, seed), fx, fy, fz - 1.0f);
+        float n101 = grad3(noise3D(xi + 1, yi, zi + 1, seed), fx - 1.0f, fy, fz - 1.0f);
+        float n011 = grad3(noise3D(xi, yi + 1, zi + 1, seed), fx, fy - 1.0f, fz - 1.0f);
+        float n111 = grad3(noise3D(xi + 1, yi + 1, zi + 1, seed), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+        return lerp(lerp(lerp(n000, n100, u), lerp(n010, n110, u), v),
+                    lerp(lerp(n001, n101, u), lerp(n011, n111, u), v), w);
+    }
+
+    // contribution of a simplex corner at offset (x, y), falloff radius^2 0.5
+    NOISE_INLINE float simplexCorner2(uint32_t h, float x, float y) {
+        float t = 0.5f - x * x - y * y;
+        t = positivePart(t);
+        t *= t;
+        return t * t * grad2(h, x, y);
+    }
+
+    NOISE_INLINE float simplex2(float x, float y, uint32_t seed) {
+        const float F2 = 0.36602540378f; // (sqrt(3) - 1) / 2
+        const float G2 = 0.21132486540f; // (3 - sqrt(3)) / 6
+        float s = (x + y) * F2;
+        int32_t i = floorToInt(x + s), j = floorToInt(y + s);
+        float t = float(i + j) * G2;
+        float x0 = x - (float(i) - t), y0 = y - (float(j) - t);
+        // lower or upper triangle of the skewed cell
+        int32_t i1 = int32_t(x0 > y0), j1 = 1 - i1;
+        float x1 = x0 - float(i1) + G2, y1 = y0 - float(j1) + G2;
+        float x2 = x0 - 1.0f + 2.0f * G2, y2 = y0 - 1.0f + 2.0f * G2;
+        float n = simplexCorner2(noise2D(i, j, seed), x0, y0)
+                + simplexCorner2(noise2D(i + i1, j + j1, seed), x1, y1)
+                + simplexCorner2(noise2D(i + 1, j + 1, seed), x2, y2);
+        return 70.0f * n;
+    }
+
+    // contribution of a simplex corner at offset (x, y, z), falloff radius^2 0.6
+    NOISE_INLINE float simplexCorner3(uint32_t h, float x, float y, float z) {
+        float t = 0.6f - x * x - y * y - z * z;
+        t = positivePart(t);
+        t *= t;
+        return t * t * grad3(h, x, y, z);
+    }
+
+    NOISE_INLINE float simplex3(float x, float y, float z, uint32_t seed) {
+        const float F3 = 1.0f / 3.0f;
+        const float G3 = 1.0f / 6.0f;
+        float s = (x + y + z) * F3;
+        int32_t i = floorToInt(x + s), j = floorToInt(y + s), k = floorToInt(z + s);
+        float t = float(i + j + k) * G3;
+        float x0 = x - (float(i) - t), y0 = y - (float(j) - t), z0 = z - (float(k) - t);
+        // the 2 middle corners of the simplex, from the rank of the offsets
+        int32_t xy = int32_t(x0 >= y0), yz = int32_t(y0 >= z0), xz = int32_t(x0 >= z0);
+        int32_t i1 = xy & xz, j1 = (1 - xy) & yz, k1 = (1 - xz) & (1 - yz);
+        int32_t i2 = xy | xz, j2 = (1 - xy) | yz, k2 = 1 - (xz & yz);
+        float x1 = x0 - float(i1) + G3, y1 = y0 - float(j1) + G3, z1 = z0 - float(k1) + G3;
+        float x2 = x0 - float(i2) + 2.0f * G3, y2 = y0 - float(j2) + 2.0f * G3, z2 = z0 - float(k2) + 2.0f * G3;
+        float x3 = x0 - 1.0f + 3.0f * G3, y3 = y0 - 1.0f + 3.0f * G3, z3 = z0 - 1.0f + 3.0f * G3;
+        float n = simplexCorner3(noise3D(i, j, k, seed), x0, y0, z0)
+                + simplexCorner3(noise3D(i + i1, j + j1, k + k1, seed), x1, y1, z1)
+                + simplexCorner3(noise3D(i + i2, j + j2, k + k2, seed), x2, y2, z2)
+                + simplexCorner3(noise3D(i + 1, j + 1, k + 1, seed), x3, y3, z3);
+        return 32.0f * n;
+    }
+
+    template <NoiseType T>
+    NOISE_INLINE float eval2(float x, float y, uint32_t seed) {
+        if constexpr (T == NoiseType::Value) return value2(x, y, seed);
+        else if constexpr (T == NoiseType::Gradient) return gradient2(x, y, seed);
+        else return simplex2(x, y, seed);
+    }
+
+    template <NoiseType T>
+    NOISE_INLINE float eval3(float x, float y, float z, uint32_t seed) {
+        if constexpr (T == NoiseType::Value) return value3(x, y, z, seed);
+        else if constexpr (T == NoiseType::Gradient) return gradient3(x, y, z, seed);
+        else return simplex3(x, y, z, seed);
+    }
+
+    template <NoiseType T>
+    float fbm2(const NoiseFbm& fbm, float x, float y) {
+        float frequency = fbm.frequency, amplitude = 1.0f, sum = 0.0f, total = 0.0f;
+        for (uint32_t o = 0; o < fbm.octaves; ++o) {
+            total += amplitude * eval2<T>(x * frequency, y * frequency, noise1D(int32_t(o), fbm.seed));
+            sum += amplitude;
+            amplitude *= fbm.gain;
+            frequency *= fbm.lacunarity;
+        }
+        return total * (1.0f / sum);
+    }
+
+    template <NoiseType T>
+    float fbm3(const NoiseFbm& fbm, float x, float y, float z) {
+        float frequency = fbm.frequency, amplitude = 1.0f, sum = 0.0f, total = 0.0f;
+        for (uint32_t o = 0; o < fbm.octaves; ++o) {
+            total += amplitude * eval3<T>(x * frequency, y * frequency, z * frequency, noise1D(int32_t(o), fbm.seed));
+            sum += amplitude;
+            amplitude *= fbm.gain;
+            frequency *= fbm.lacunarity;
+        }
+        return total * (1.0f / sum);
+    }
+
+    // One octave over a row of n samples: o[i] += amplitude * noise((ox + i * sx) * frequency, y, z)
+    template <NoiseType T>
+    void kernel_octave_row2(uint32_t n, float ox, float sx, float frequency, float y, float amplitude, uint32_t seed, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] += amplitude * eval2<T>((ox + float(i) * sx) * frequency, y, seed);
+        }
+    }
+
+    template <NoiseType T>
+    void kernel_octave_row3(uint32_t n, float ox, float sx, float frequency, float y, float z, float amplitude, uint32_t seed, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] += amplitude * eval3<T>((ox + float(i) * sx) * frequency, y, z, seed);
+        }
+    }
+
+    void kernel_scale_row(uint32_t n, float s, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] *= s;
+        }
+    }
+
+    // Rows of grid.width samples, at (y, z) of the row
+    template <NoiseType T>
+    void fbm_row(const NoiseFbm& fbm, const NoiseGrid& grid, float y, float z, bool is3D, float* o) {
+        std::fill(o, o + grid.width, 0.0f);
+        float frequency = fbm.frequency, amplitude = 1.0f, sum = 0.0f;
+        for (uint32_t oct = 0; oct < fbm.octaves; ++oct) {
+            uint32_t seed = noise1D(int32_t(oct), fbm.seed);
+            if (is3D) {
+                kernel_octave_row3<T>(grid.width, grid.originX, grid.stepX, frequency, y * frequency, z * frequency, amplitude, seed, o);
+            } else {
+                kernel_octave_row2<T>(grid.width, grid.originX, grid.stepX, frequency, y * frequency, amplitude, seed, o);
+            }
+            sum += amplitude;
+            amplitude *= fbm.gain;
+            frequency *= fbm.lacunarity;
+        }
+        kernel_scale_row(grid.width, 1.0f / sum, o);
+    }
+
+    void noise_grid(const NoiseFbm& fbm, const NoiseGrid& grid, bool is3D, float* out) {
+        uint32_t numRows = grid.height * (is3D ? grid.depth : 1);
+        if (grid.width == 0 || numRows == 0) {
+            return;
+        }
+        auto rowFn = (fbm.type == NoiseType::Value ? &fbm_row<NoiseType::Value> :
+                     (fbm.type == NoiseType::Gradient ? &fbm_row<NoiseType::Gradient> : &fbm_row<NoiseType::Simplex>));
+
+        // about 4k samples per task
+        uint32_t grain = std::max(1u, 4096u / (grid.width * std::max(1u, fbm.octaves)));
+        ThreadPool::shared().parallel_for(numRows, grain, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t r = begin; r < end; ++r) {
+                float y = grid.originY + float(r % grid.height) * grid.stepY;
+                float z = grid.originZ + float(r / grid.height) * grid.stepZ;
+                rowFn(fbm, grid, y, z, is3D, out + uint64_t(r) * grid.width);
+            }
+        });
+    }
+}
+
+namespace core {
+
+    float noise2D(NoiseType type, float x, float y, uint32_t seed) {
+        switch (type) {
+        case NoiseType::Value: return value2(x, y, seed);
+        case NoiseType::Gradient: return gradient2(x, y, seed);
+        default: return simplex2(x, y, seed);
+        }
+    }
+
+    float noise3D(NoiseType type, float x, float y, float z, uint32_t seed) {
+        switch (type) {
+        case NoiseType::Value: return value3(x, y, z, seed);
+        case NoiseType::Gradient: return gradient3(x, y, z, seed);
+        default: return simplex3(x, y, z, seed);
+        }
+    }
+
+    float fbm2D(const NoiseFbm& fbm, float x, float y) {
+        switch (fbm.type) {
+        case NoiseType::Value: return fbm2<NoiseType::Value>(fbm, x, y);
+        case NoiseType::Gradient: return fbm2<NoiseType::Gradient>(fbm, x, y);
+        default: return fbm2<NoiseType::Simplex>(fbm, x, y);
+        }
+    }
+
+    float fbm3D(const NoiseFbm& fbm, float x, float y, float z) {
+        switch (fbm.type) {
+        case NoiseType::Value: return fbm3<NoiseType::Value>(fbm, x, y, z);
+        case NoiseType::Gradient: return fbm3<NoiseType::Gradient>(fbm, x, y, z);
+        default: return fbm3<NoiseType::Simplex>(fbm, x, y, z);
+        }
+    }
+
+    void noise_grid2D(const NoiseFbm& fbm, const NoiseGrid& grid, float* out) {
+        noise_grid(fbm, grid, false, out);
+    }
+
+    void noise_grid3D(const NoiseFbm& fbm, const NoiseGrid& grid, float* out) {
+        noise_grid(fbm, grid, true, out);
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runNoiseTests() to validate the batched noise against the
+// scalar functions and runNoiseBenchmarks() to compare their samples per ns
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+#include "../Log.h"
+
+namespace {
+    const char* noiseTypeName(NoiseType type) {
+        switch (type) {
+        case NoiseType::Value: return "value";
+        case NoiseType::Gradient: return "gradient";
+        default: return "simplex";
+        }
+    }
+
+    uint32_t hashSamples(const std::vector<float>& samples) {
+        uint32_t h = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            h = noise1D(int32_t(std::bit_cast<uint32_t>(samples[i])), h);
+        }
+        return h;
+    }
+}
+
+void runNoiseTests() {
+    using namespace core;
+    picoLog("NoiseTest: starting...");
+
+    const NoiseType types[] = { NoiseType::Value, NoiseType::Gradient, NoiseType::Simplex };
+
+    // --- Test 1: the batched grids are bitwise equal to the scalar fbm ---
+    for (auto type : types) {
+        NoiseFbm fbm{ type, 5, 0.02f, 2.0f, 0.5f, 1234 };
+        NoiseGrid grid{ -37.5f, 12.25f, -3.0f, 0.75f, 1.5f, 2.0f, 67, 23, 5 };
+
+        std::vector<float> grid2(grid.width * grid.height);
+        noise_grid2D(fbm, grid, grid2.data());
+        std::vector<float> grid3(grid.width * grid.height * grid.depth);
+        noise_grid3D(fbm, grid, grid3.data());
+
+        for (uint32_t k = 0; k < grid.depth; ++k) {
+            for (uint32_t j = 0; j < grid.height; ++j) {
+                for (uint32_t i = 0; i < grid.width; ++i) {
+                    float x = grid.originX + float(i) * grid.stepX;
+                    float y = grid.originY + float(j) * grid.stepY;
+                    float z = grid.originZ + float(k) * grid.stepZ;
+                    if (k == 0) {
+                        assert(grid2[j * grid.width + i] == fbm2D(fbm, x, y));
+                    }
+                    assert(grid3[(k * grid.height + j) * grid.width + i] == fbm3D(fbm, x, y, z));
+                }
+            }
+        }
+    }
+    picoLog("NoiseTest 1 passed: batched grids match the scalar fbm");
+
+    // --- Test 2: range, continuity and lattice behavior ---
+    for (auto type : types) {
+        float minValue = 1.0f, maxValue = -1.0f, maxStep = 0.0f;
+        float previous = noise2D(type, -20.0f, 3.3f, 7);
+        for (int i = 1; i < 40000; ++i) {
+            float x = -20.0f + float(i) * 0.001f;
+            float n = noise2D(type, x, 3.3f, 7);
+            float n3 = noise3D(type, x, 3.3f, 0.6f * x, 7);
+            minValue = std::min(minValue, std::min(n, n3));
+            maxValue = std::max(maxValue, std::max(n, n3));
+            maxStep = std::max(maxStep, fabsf(n - previous));
+            previous = n;
+        }
+        assert(minValue >= -1.1f && maxValue <= 1.1f && maxValue - minValue > 0.5f);
+        assert(maxStep < 0.02f); // no jump between neighbor samples
+        if (type == NoiseType::Gradient) {
+            assert(noise2D(type, 5.0f, -8.0f, 7) == 0.0f && noise3D(type, 5.0f, -8.0f, 2.0f, 7) == 0.0f);
+        }
+        assert(noise2D(type, 1.37f, 2.71f, 7) != noise2D(type, 1.37f, 2.71f, 8)); // the seed matters
+    }
+    picoLog("NoiseTest 2 passed: bounded and continuous noise");
+
+    // --- Test 3: reproducible across runs and thread splits ---
+    {
+        NoiseFbm fbm{ NoiseType::Simplex, 6, 0.01f, 2.0f, 0.5f, 42 };
+        NoiseGrid grid{ 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 256, 256, 1 };
+        std::vector<float> a(grid.width * grid.height), b(grid.width * grid.height);
+        noise_grid2D(fbm, grid, a.data());
+        noise_grid2D(fbm, grid, b.data());
+        assert(a == b);
+        // golden value, the same for every compiler, instruction set and optimization level
+        assert(hashSamples(a) == 0xf02702bf);
+    }
+    picoLog("NoiseTest 3 passed: reproducible grids");
+
+    picoLog("NoiseTest: all tests passed");
+}
+
+void runNoiseBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    const NoiseType types[] = { NoiseType::Value, NoiseType::Gradient, NoiseType::Simplex };
+    for (bool is3D : { false, true }) {
+        NoiseGrid grid{ -100.0f, -100.0f, -100.0f, 0.37f, 0.37f, 0.37f, 512, is3D ? 64u : 512u, is3D ? 64u : 1u };
+        uint64_t numSamples = uint64_t(grid.width) * grid.height * grid.depth;
+        std::vector<float> scalar(numSamples), batched(numSamples);
+
+        for (auto type : types) {
+            NoiseFbm fbm{ type, 4, 0.05f, 2.0f, 0.5f, 99 };
+
+            auto start = clock::now();
+            for (uint32_t k = 0; k < grid.depth; ++k) {
+                float z = grid.originZ + float(k) * grid.stepZ;
+                for (uint32_t j = 0; j < grid.height; ++j) {
+                    float y = grid.originY + float(j) * grid.stepY;
+                    float* row = scalar.data() + (uint64_t(k) * grid.height + j) * grid.width;
+                    for (uint32_t i = 0; i < grid.width; ++i) {
+                        float x = grid.originX + float(i) * grid.stepX;
+                        row[i] = (is3D ? fbm3D(fbm, x, y, z) : fbm2D(fbm, x, y));
+                    }
+                }
+            }
+            double scalarNs = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+            start = clock::now();
+            if (is3D) {
+                noise_grid3D(fbm, grid, batched.data());
+            } else {
+                noise_grid2D(fbm, grid, batched.data());
+            }
+            double batchedNs = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            assert(scalar == batched);
+
+            picoLogf("NoiseBench {} {}D fbm x{} octaves, {} samples: scalar {:.3f} samples/ns | batched {:.3f} samples/ns | x{:.2f}",
+                noiseTypeName(type), (is3D ? 3 : 2), fbm.octaves, numSamples,
+                double(numSamples) / scalarNs, double(numSamples) / batchedNs, scalarNs / batchedNs);
+        }
+    }
+}
@@ -26,6 +26,7 @@
 //
 #pragma once
 #include "math.h"
+#include "../dllmain.h"
 
 namespace core 
 {
@@ -56,4 +57,47 @@ namespace core
         const int32_t PRIME_NUMBER2 = 6542989;
         return noise1D(x + (PRIME_NUMBER1 * y) + (PRIME_NUMBER2 * z), seed);
     }
+
+    // Coherent noise, built on the hash above at the integer lattice points.
+    // The results are in about [-1, 1] and only depend on the position and the seed:
+    // Noise.cpp is built without floating point contraction, so a seed produces the same values
+    // on every platform and for the scalar and the batched evaluation.
+    enum class NoiseType : uint8_t {
+        Value = 0,  // interpolated random values
+        Gradient,   // Perlin gradient noise
+        Simplex,    // gradient noise over the simplex grid
+    };
+
+    CORE_API float noise2D(NoiseType type, float x, float y, uint32_t seed);
+    CORE_API float noise3D(NoiseType type, float x, float y, float z, uint32_t seed);
+
+    // Fractal sum of octaves of noise, normalized by the sum of the amplitudes.
+    // Octave o samples the noise at position * frequency * lacunarity^o with the seed noise1D(o, seed),
+    // and is weighted by gain^o.
+    struct NoiseFbm {
+        NoiseType type{ NoiseType::Gradient };
+        uint32_t octaves{ 1 };
+        float frequency{ 1.0f };
+        float lacunarity{ 2.0f };
+        float gain{ 0.5f };
+        uint32_t seed{ 0 };
+    };
+
+    CORE_API float fbm2D(const NoiseFbm& fbm, float x, float y);
+    CORE_API float fbm3D(const NoiseFbm& fbm, float x, float y, float z);
+
+    // Regular grid of samples, sample (i, j, k) is at (origin.x + float(i) * step.x, origin.y + float(j) * step.y, origin.z + float(k) * step.z).
+    struct NoiseGrid {
+        float originX{ 0.0f }, originY{ 0.0f }, originZ{ 0.0f };
+        float stepX{ 1.0f }, stepY{ 1.0f }, stepZ{ 1.0f };
+        uint32_t width{ 1 };
+        uint32_t height{ 1 };
+        uint32_t depth{ 1 };
+    };
+
+    // Batched fbm over a grid, written row major in out (width * height samples, and * depth for the 3D flavor).
+    // Rows are evaluated by vectorized kernels and split across the ThreadPool.
+    // The values are bitwise equal to fbm2D / fbm3D at the grid positions.
+    CORE_API void noise_grid2D(const NoiseFbm& fbm, const NoiseGrid& grid, float* out);
+    CORE_API void noise_grid3D(const NoiseFbm& fbm, const NoiseGrid& grid, float* out);
 }
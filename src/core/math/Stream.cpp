@@ -0,0 +1,415 @@
+// Stream.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Stream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include "../Log.h"
+
+// The kernels are plain loops over the padded count, taking __restrict pointer arguments
+// (compilers only trust restrict reliably on parameters). No remainder and no branch in the
+// loop body (selects only), so MSVC /arch:AVX2 or gcc/clang -O3 -mavx2 -mfma
+// (see PICO_SIMD_AVX2) turn each of them into 8 or 16 wide code.
+
+namespace {
+
+    // o[i] = r.x * x[i] + r.y * y[i] + r.z * z[i] + t
+    void kernel_row_uniform(uint32_t n, float rx, float ry, float rz, float t,
+        const float* __restrict x, const float* __restrict y, const float* __restrict z, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] = rx * x[i] + ry * y[i] + rz * z[i] + t;
+        }
+    }
+
+    // o[i] = r0[i] * x[i] + r1[i] * y[i] + r2[i] * z[i] + t[i] (t optional)
+    void kernel_row(uint32_t n, const float* __restrict r0, const float* __restrict r1, const float* __restrict r2, const float* __restrict t,
+        const float* __restrict x, const float* __restrict y, const float* __restrict z, float* __restrict o) {
+        if (t) {
+            for (uint32_t i = 0; i < n; ++i) {
+                o[i] = r0[i] * x[i] + r1[i] * y[i] + r2[i] * z[i] + t[i];
+            }
+        } else {
+            for (uint32_t i = 0; i < n; ++i) {
+                o[i] = r0[i] * x[i] + r1[i] * y[i] + r2[i] * z[i];
+            }
+        }
+    }
+
+    // o[i] = |r0[i]| * x[i] + |r1[i]| * y[i] + |r2[i]| * z[i]
+    void kernel_abs_row(uint32_t n, const float* __restrict r0, const float* __restrict r1, const float* __restrict r2,
+        const float* __restrict x, const float* __restrict y, const float* __restrict z, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] = std::fabs(r0[i]) * x[i] + std::fabs(r1[i]) * y[i] + std::fabs(r2[i]) * z[i];
+        }
+    }
+
+    // o[i] = a[i] + (b[i] - a[i]) * t[i]
+    void kernel_mix(uint32_t n, const float* __restrict a, const float* __restrict b, const float* __restrict t, float* __restrict o) {
+        for (uint32_t i = 0; i < n; ++i) {
+            o[i] = a[i] + (b[i] - a[i]) * t[i];
+        }
+    }
+
+    // Same math as the scalar slerp, with the two branches turned into selects:
+    // r1 is negated to take the short path, and close rotors fall back to a linear blend
+    // (sin(angle) would be a near zero denominator).
+    // The padding lanes are zero rotors, cosTheta = 0 there so the result is a clean zero.
+    void kernel_slerp(uint32_t n, const float* __restrict t,
+        const float* __restrict a0, const float* __restrict xy0, const float* __restrict xz0, const float* __restrict yz0,
+        const float* __restrict a1, const float* __restrict xy1, const float* __restrict xz1, const float* __restrict yz1,
+        float* __restrict oa, float* __restrict oxy, float* __restrict oxz, float* __restrict oyz) {
+        constexpr float LINEAR_THRESHOLD = 0.9995f;
+        for (uint32_t i = 0; i < n; ++i) {
+            float cosTheta = a0[i] * a1[i] + xy0[i] * xy1[i] + xz0[i] * xz1[i] + yz0[i] * yz1[i];
+            float sign = (cosTheta < 0.0f ? -1.0f : 1.0f);
+            cosTheta = std::fabs(cosTheta);
+            bool linear = cosTheta > LINEAR_THRESHOLD;
+            float angle = std::acos(linear ? 0.0f : cosTheta);
+            float sinAngleInv = 1.0f / std::sin(angle);
+            float f0 = linear ? 1.0f - t[i] : std::sin((1.0f - t[i]) * angle) * sinAngleInv;
+            float f1 = sign * (linear ? t[i] : std::sin(t[i] * angle) * sinAngleInv);
+            oa[i] = a0[i] * f0 + a1[i] * f1;
+            oxy[i] = xy0[i] * f0 + xy1[i] * f1;
+            oxz[i] = xz0[i] * f0 + xz1[i] * f1;
+            oyz[i] = yz0[i] * f0 + yz1[i] * f1;
+        }
+    }
+
+    void kernel_normalize(uint32_t n, float* __restrict a, float* __restrict xy, float* __restrict xz, float* __restrict yz) {
+        for (uint32_t i = 0; i < n; ++i) {
+            float l2 = a[i] * a[i] + xy[i] * xy[i] + xz[i] * xz[i] + yz[i] * yz[i];
+            // keep the zero padding lanes at zero instead of producing NaNs
+            float linv = (l2 > 0.0f ? 1.0f / std::sqrt(l2) : 0.0f);
+            a[i] *= linv; xy[i] *= linv; xz[i] *= linv; yz[i] *= linv;
+        }
+    }
+
+    void kernel_bound(uint32_t n, const float* __restrict c, const float* __restrict h, float& minPos, float& maxPos) {
+        float lo = c[0] - h[0];
+        float hi = c[0] + h[0];
+        for (uint32_t i = 1; i < n; ++i) {
+            lo = std::min(lo, c[i] - h[i]);
+            hi = std::max(hi, c[i] + h[i]);
+        }
+        minPos = lo;
+        maxPos = hi;
+    }
+}
+
+namespace core {
+
+    void stream_transformFrom(const mat4x3& mat, const vec3_stream& p, vec3_stream& out) {
+        out.resize(p.size());
+        const uint32_t n = p.padded_size();
+        const vec3 rx = mat.row_x(), ry = mat.row_y(), rz = mat.row_z(), t = mat.w();
+        kernel_row_uniform(n, rx.x, rx.y, rx.z, t.x, p.x.data(), p.y.data(), p.z.data(), out.x.data());
+        kernel_row_uniform(n, ry.x, ry.y, ry.z, t.y, p.x.data(), p.y.data(), p.z.data(), out.y.data());
+        kernel_row_uniform(n, rz.x, rz.y, rz.z, t.z, p.x.data(), p.y.data(), p.z.data(), out.z.data());
+    }
+
+    void stream_transformFrom(const mat4x3_stream& mat, const vec3_stream& p, vec3_stream& out) {
+        assert(mat.size() == p.size());
+        out.resize(p.size());
+        const uint32_t n = p.padded_size();
+        const auto& c = mat._columns;
+        kernel_row(n, c[0].x.data(), c[1].x.data(), c[2].x.data(), c[3].x.data(), p.x.data(), p.y.data(), p.z.data(), out.x.data());
+        kernel_row(n, c[0].y.data(), c[1].y.data(), c[2].y.data(), c[3].y.data(), p.x.data(), p.y.data(), p.z.data(), out.y.data());
+        kernel_row(n, c[0].z.data(), c[1].z.data(), c[2].z.data(), c[3].z.data(), p.x.data(), p.y.data(), p.z.data(), out.z.data());
+    }
+
+    void stream_aabox_transformFrom(const mat4x3& mat, const aabox3_stream& b, aabox3_stream& out) {
+        out.resize(b.size());
+        stream_transformFrom(mat, b.center, out.center);
+
+        const uint32_t n = b.padded_size();
+        const auto& h = b.half_size;
+        const vec3 rx = abs(mat.row_x()), ry = abs(mat.row_y()), rz = abs(mat.row_z());
+        kernel_row_uniform(n, rx.x, rx.y, rx.z, 0.0f, h.x.data(), h.y.data(), h.z.data(), out.half_size.x.data());
+        kernel_row_uniform(n, ry.x, ry.y, ry.z, 0.0f, h.x.data(), h.y.data(), h.z.data(), out.half_size.y.data());
+        kernel_row_uniform(n, rz.x, rz.y, rz.z, 0.0f, h.x.data(), h.y.data(), h.z.data(), out.half_size.z.data());
+    }
+
+    void stream_aabox_transformFrom(const mat4x3_stream& mat, const aabox3_stream& b, aabox3_stream& out) {
+        assert(mat.size() == b.size());
+        out.resize(b.size());
+        stream_transformFrom(mat, b.center, out.center);
+
+        const uint32_t n = b.padded_size();
+        const auto& h = b.half_size;
+        const auto& c = mat._columns;
+        kernel_abs_row(n, c[0].x.data(), c[1].x.data(), c[2].x.data(), h.x.data(), h.y.data(), h.z.data(), out.half_size.x.data());
+        kernel_abs_row(n, c[0].y.data(), c[1].y.data(), c[2].y.data(), h.x.data(), h.y.data(), h.z.data(), out.half_size.y.data());
+        kernel_abs_row(n, c[0].z.data(), c[1].z.data(), c[2].z.data(), h.x.data(), h.y.data(), h.z.data(), out.half_size.z.data());
+    }
+
+    bool stream_aabox_bound(const aabox3_stream& b, aabox3& bound) {
+        // Only the valid count is reduced, the padding would pull the box towards the origin
+        const uint32_t n = b.size();
+        if (n == 0) return false;
+
+        vec3 minPos, maxPos;
+        kernel_bound(n, b.center.x.data(), b.half_size.x.data(), minPos.x, maxPos.x);
+        kernel_bound(n, b.center.y.data(), b.half_size.y.data(), minPos.y, maxPos.y);
+        kernel_bound(n, b.center.z.data(), b.half_size.z.data(), minPos.z, maxPos.z);
+        bound = aabox3::fromMinMax(minPos, maxPos);
+        return true;
+    }
+
+    void stream_mul(const mat4x3_stream& parent, const mat4x3_stream& local, mat4x3_stream& out) {
+        assert(parent.size() == local.size());
+        out.resize(local.size());
+        const uint32_t n = local.padded_size();
+        const auto& a = parent._columns;
+
+        // out column c = rotateFrom(parent, local column c), the translation column also adds the parent translation
+        for (int c = 0; c < 4; ++c) {
+            const auto& b = local._columns[c];
+            auto& o = out._columns[c];
+            const float* tx = (c == 3 ? a[3].x.data() : nullptr);
+            const float* ty = (c == 3 ? a[3].y.data() : nullptr);
+            const float* tz = (c == 3 ? a[3].z.data() : nullptr);
+            kernel_row(n, a[0].x.data(), a[1].x.data(), a[2].x.data(), tx, b.x.data(), b.y.data(), b.z.data(), o.x.data());
+            kernel_row(n, a[0].y.data(), a[1].y.data(), a[2].y.data(), ty, b.x.data(), b.y.data(), b.z.data(), o.y.data());
+            kernel_row(n, a[0].z.data(), a[1].z.data(), a[2].z.data(), tz, b.x.data(), b.y.data(), b.z.data(), o.z.data());
+        }
+    }
+
+    void stream_mix(const vec3_stream& v0, const vec3_stream& v1, const float_array& t, vec3_stream& out) {
+        assert(v0.size() == v1.size() && t.size() >= v0.padded_size());
+        out.resize(v0.size());
+        const uint32_t n = v0.padded_size();
+        kernel_mix(n, v0.x.data(), v1.x.data(), t.data(), out.x.data());
+        kernel_mix(n, v0.y.data(), v1.y.data(), t.data(), out.y.data());
+        kernel_mix(n, v0.z.data(), v1.z.data(), t.data(), out.z.data());
+    }
+
+    void stream_slerp(const rotor3_stream& r0, const rotor3_stream& r1, const float_array& t, rotor3_stream& out) {
+        assert(r0.size() == r1.size() && t.size() >= r0.padded_size());
+        out.resize(r0.size());
+        kernel_slerp(r0.padded_size(), t.data(),
+            r0.a.data(), r0.xy.data(), r0.xz.data(), r0.yz.data(),
+            r1.a.data(), r1.xy.data(), r1.xz.data(), r1.yz.data(),
+            out.a.data(), out.xy.data(), out.xz.data(), out.yz.data());
+    }
+
+    void stream_normalize(rotor3_stream& r) {
+        kernel_normalize(r.padded_size(), r.a.data(), r.xy.data(), r.xz.data(), r.yz.data());
+    }
+
+} // namespace core
+
+// -------------------------------------------------------------------------
+// Simple test — call runMathStreamTests() to validate the stream kernels
+// against the scalar math, and runMathStreamBenchmarks() to time them
+// -------------------------------------------------------------------------
+
+namespace {
+    using namespace core;
+
+    // Deterministic pseudo random values in [-1, 1]
+    struct TestRandom {
+        uint32_t _state{ 0x12345678u };
+        float next() {
+            _state = _state * 1664525u + 1013904223u;
+            return float(_state >> 8) / float(1u << 23) - 1.0f;
+        }
+        vec3 next_vec3() { return vec3(next(), next(), next()); }
+        rotor3 next_rotor3() { return rotor3(next(), next(), next(), next()).normal(); }
+        mat4x3 next_mat4x3() {
+            mat4x3 m;
+            translation_rotation(m, next_vec3() * 10.0f, next_rotor3());
+            return m;
+        }
+    };
+
+    bool near_equal(float a, float b, float eps = 1e-4f) { return std::fabs(a - b) <= eps * (1.0f + std::fabs(a) + std::fabs(b)); }
+    bool near_equal(const vec3& a, const vec3& b) { return near_equal(a.x, b.x) && near_equal(a.y, b.y) && near_equal(a.z, b.z); }
+    bool near_equal(const rotor3& a, const rotor3& b) { return near_equal(a.a, b.a) && near_equal(a.b.xy, b.b.xy) && near_equal(a.b.xz, b.b.xz) && near_equal(a.b.yz, b.b.yz); }
+    bool near_equal(const mat4x3& a, const mat4x3& b) {
+        return near_equal(a.x(), b.x()) && near_equal(a.y(), b.y()) && near_equal(a.z(), b.z()) && near_equal(a.w(), b.w());
+    }
+}
+
+void runMathStreamTests() {
+    picoLog("MathStreamTest: starting...");
+
+    TestRandom rnd;
+    const uint32_t N = 37; // not a multiple of STREAM_LANES on purpose
+
+    // --- Test 1: padding and alignment ---
+    {
+        vec3_stream s;
+        s.resize(N);
+        assert(s.size() == N);
+        assert(s.padded_size() % STREAM_LANES == 0 && s.padded_size() >= N);
+        assert((reinterpret_cast<uintptr_t>(s.x.data()) % STREAM_ALIGNMENT) == 0);
+        picoLog("MathStreamTest 1 passed: streams padded and aligned");
+    }
+
+    // --- Test 2: points and boxes by one or N matrices ---
+    {
+        std::vector<mat4x3> mats(N);
+        std::vector<aabox3> boxes(N);
+        mat4x3_stream matStream; matStream.resize(N);
+        aabox3_stream boxStream; boxStream.resize(N);
+        for (uint32_t i = 0; i < N; ++i) {
+            mats[i] = rnd.next_mat4x3();
+            boxes[i] = aabox3(rnd.next_vec3() * 5.0f, abs(rnd.next_vec3()));
+            matStream.set(i, mats[i]);
+            boxStream.set(i, boxes[i]);
+        }
+
+        vec3_stream points;
+        aabox3_stream outBoxes;
+        stream_transformFrom(mats[0], boxStream.center, points);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(points.get(i), transformFrom(mats[0], boxes[i].center)));
+
+        stream_transformFrom(matStream, boxStream.center, points);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(points.get(i), transformFrom(mats[i], boxes[i].center)));
+
+        stream_aabox_transformFrom(mats[0], boxStream, outBoxes);
+        for (uint32_t i = 0; i < N; ++i) {
+            auto ref = aabox_transformFrom(mats[0], boxes[i]);
+            assert(near_equal(outBoxes.center.get(i), ref.center) && near_equal(outBoxes.half_size.get(i), ref.half_size));
+        }
+
+        stream_aabox_transformFrom(matStream, boxStream, outBoxes);
+        aabox3 refBound = aabox_transformFrom(mats[0], boxes[0]);
+        for (uint32_t i = 0; i < N; ++i) {
+            auto ref = aabox_transformFrom(mats[i], boxes[i]);
+            assert(near_equal(outBoxes.center.get(i), ref.center) && near_equal(outBoxes.half_size.get(i), ref.half_size));
+            refBound = aabox3::fromBound(refBound, ref);
+        }
+
+        aabox3 bound;
+        assert(stream_aabox_bound(outBoxes, bound));
+        assert(near_equal(bound.center, refBound.center) && near_equal(bound.half_size, refBound.half_size));
+        picoLog("MathStreamTest 2 passed: points and boxes match transformFrom / aabox_transformFrom");
+    }
+
+    // --- Test 3: parent / local composition ---
+    {
+        std::vector<mat4x3> parents(N), locals(N);
+        mat4x3_stream parentStream, localStream, worldStream;
+        parentStream.resize(N); localStream.resize(N);
+        for (uint32_t i = 0; i < N; ++i) {
+            parents[i] = rnd.next_mat4x3();
+            locals[i] = rnd.next_mat4x3();
+            parentStream.set(i, parents[i]);
+            localStream.set(i, locals[i]);
+        }
+        stream_mul(parentStream, localStream, worldStream);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(worldStream.get(i), mul(parents[i], locals[i])));
+        picoLog("MathStreamTest 3 passed: stream_mul matches mul");
+    }
+
+    // --- Test 4: rotor slerp / normalize and vec3 mix ---
+    {
+        std::vector<rotor3> r0(N), r1(N);
+        rotor3_stream r0Stream, r1Stream, outStream;
+        vec3_stream v0Stream, v1Stream, vOut;
+        float_array t;
+        r0Stream.resize(N); r1Stream.resize(N); v0Stream.resize(N); v1Stream.resize(N);
+        stream_resize(t, N);
+        for (uint32_t i = 0; i < N; ++i) {
+            r0[i] = rnd.next_rotor3();
+            r1[i] = rnd.next_rotor3();
+            if (i == 0) r1[i] = r0[i]; // identical rotors take the linear path
+            r0Stream.set(i, r0[i]);
+            r1Stream.set(i, r1[i]);
+            v0Stream.set(i, rnd.next_vec3());
+            v1Stream.set(i, rnd.next_vec3());
+            t[i] = 0.5f * (rnd.next() + 1.0f);
+        }
+
+        stream_slerp(r0Stream, r1Stream, t, outStream);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(outStream.get(i), slerp(r0[i], r1[i], t[i])));
+
+        stream_mix(v0Stream, v1Stream, t, vOut);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(vOut.get(i), mix(v0Stream.get(i), v1Stream.get(i), t[i])));
+
+        for (uint32_t i = 0; i < N; ++i) r0Stream.set(i, scale(r0[i], 3.0f));
+        stream_normalize(r0Stream);
+        for (uint32_t i = 0; i < N; ++i) assert(near_equal(r0Stream.get(i), r0[i]));
+        for (uint32_t i = N; i < r0Stream.padded_size(); ++i) assert(r0Stream.a[i] == 0.0f);
+        picoLog("MathStreamTest 4 passed: slerp, mix and normalize match the scalar versions");
+    }
+
+    picoLog("MathStreamTest: all tests passed");
+}
+
+void runMathStreamBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+
+    // Sized to stay in L2 so the numbers measure the kernels rather than the memory bus
+    const uint32_t N = 1 << 12;
+    const int NUM_RUNS = 512;
+    TestRandom rnd;
+
+    std::vector<mat4x3> parents(N), locals(N), worlds(N);
+    std::vector<aabox3> boxes(N), worldBoxes(N);
+    std::vector<rotor3> r0(N), r1(N), rOut(N);
+    mat4x3_stream parentStream, localStream, worldStream;
+    aabox3_stream boxStream, worldBoxStream;
+    rotor3_stream r0Stream, r1Stream, rOutStream;
+    float_array t;
+    parentStream.resize(N); localStream.resize(N); boxStream.resize(N); r0Stream.resize(N); r1Stream.resize(N);
+    stream_resize(t, N);
+    for (uint32_t i = 0; i < N; ++i) {
+        parents[i] = rnd.next_mat4x3(); parentStream.set(i, parents[i]);
+        locals[i] = rnd.next_mat4x3(); localStream.set(i, locals[i]);
+        boxes[i] = aabox3(rnd.next_vec3(), abs(rnd.next_vec3())); boxStream.set(i, boxes[i]);
+        r0[i] = rnd.next_rotor3(); r0Stream.set(i, r0[i]);
+        r1[i] = rnd.next_rotor3(); r1Stream.set(i, r1[i]);
+        t[i] = 0.5f * (rnd.next() + 1.0f);
+    }
+
+    auto report = [&](const char* name, auto&& scalarKernel, auto&& streamKernel) {
+        auto start = clock::now();
+        for (int r = 0; r < NUM_RUNS; ++r) scalarKernel();
+        double scalarNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        start = clock::now();
+        for (int r = 0; r < NUM_RUNS; ++r) streamKernel();
+        double streamNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        double numElements = double(N) * NUM_RUNS;
+        picoLogf("MathStreamBench {:<20} scalar {:8.3f} elements/ns | stream {:8.3f} elements/ns | x{:.2f}",
+            name, numElements / scalarNs, numElements / streamNs, scalarNs / streamNs);
+    };
+
+    report("mul",
+        [&]() { for (uint32_t i = 0; i < N; ++i) worlds[i] = mul(parents[i], locals[i]); },
+        [&]() { stream_mul(parentStream, localStream, worldStream); });
+    report("aabox_transformFrom",
+        [&]() { for (uint32_t i = 0; i < N; ++i) worldBoxes[i] = aabox_transformFrom(parents[i], boxes[i]); },
+        [&]() { stream_aabox_transformFrom(parentStream, boxStream, worldBoxStream); });
+    report("slerp",
+        [&]() { for (uint32_t i = 0; i < N; ++i) rOut[i] = slerp(r0[i], r1[i], t[i]); },
+        [&]() { stream_slerp(r0Stream, r1Stream, t, rOutStream); });
+}
@@ -0,0 +1,161 @@
+// Stream.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <cstddef>
+
+#include "Math3D.h"
+#include "../dllmain.h"
+
+namespace core {
+
+    // Streams are the SoA (structure of arrays) counterpart of the math types:
+    // each component lives in its own contiguous float array.
+    // Arrays are aligned on 64 bytes and padded to a multiple of STREAM_LANES elements
+    // so the kernels can run full AVX2 (8 lanes) or AVX-512 (16 lanes) iterations
+    // without a remainder loop. Padding elements are zeroed and never read back.
+    constexpr uint32_t STREAM_LANES = 16;
+    constexpr uint32_t STREAM_ALIGNMENT = 64;
+
+    inline uint32_t stream_padded_count(uint32_t count) { return (count + STREAM_LANES - 1) & ~(STREAM_LANES - 1); }
+
+    template <typename T, size_t A>
+    struct aligned_allocator {
+        using value_type = T;
+        template <typename U> struct rebind { using other = aligned_allocator<U, A>; };
+
+        aligned_allocator() = default;
+        template <typename U> aligned_allocator(const aligned_allocator<U, A>&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(A))); }
+        void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(A)); }
+
+        template <typename U> bool operator==(const aligned_allocator<U, A>&) const { return true; }
+        template <typename U> bool operator!=(const aligned_allocator<U, A>&) const { return false; }
+    };
+
+    using float_array = std::vector<float, aligned_allocator<float, STREAM_ALIGNMENT>>;
+
+    // Resize to the padded count of elements and zero the padding lanes
+    inline void stream_resize(float_array& a, uint32_t count) {
+        a.resize(stream_padded_count(count));
+        std::fill(a.begin() + count, a.end(), 0.0f);
+    }
+
+    struct vec3_stream {
+        float_array x, y, z;
+        uint32_t _count{ 0 };
+
+        uint32_t size() const { return _count; }
+        uint32_t padded_size() const { return (uint32_t) x.size(); }
+
+        void resize(uint32_t count) {
+            _count = count;
+            stream_resize(x, count); stream_resize(y, count); stream_resize(z, count);
+        }
+
+        inline void set(uint32_t i, const vec3& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+        inline vec3 get(uint32_t i) const { return vec3(x[i], y[i], z[i]); }
+    };
+
+    struct rotor3_stream {
+        float_array a, xy, xz, yz;
+        uint32_t _count{ 0 };
+
+        uint32_t size() const { return _count; }
+        uint32_t padded_size() const { return (uint32_t) a.size(); }
+
+        void resize(uint32_t count) {
+            _count = count;
+            stream_resize(a, count); stream_resize(xy, count); stream_resize(xz, count); stream_resize(yz, count);
+        }
+
+        inline void set(uint32_t i, const rotor3& r) { a[i] = r.a; xy[i] = r.b.xy; xz[i] = r.b.xz; yz[i] = r.b.yz; }
+        inline rotor3 get(uint32_t i) const { return rotor3(a[i], xy[i], xz[i], yz[i]); }
+    };
+
+    // Same column layout as mat4x3: 3 rotation/scale columns and the translation column
+    struct mat4x3_stream {
+        vec3_stream _columns[4];
+
+        uint32_t size() const { return _columns[0].size(); }
+        uint32_t padded_size() const { return _columns[0].padded_size(); }
+
+        void resize(uint32_t count) {
+            for (auto& c : _columns) c.resize(count);
+        }
+
+        inline void set(uint32_t i, const mat4x3& m) {
+            for (int c = 0; c < 4; ++c) _columns[c].set(i, m._columns[c]);
+        }
+        inline mat4x3 get(uint32_t i) const {
+            return mat4x3(_columns[0].get(i), _columns[1].get(i), _columns[2].get(i), _columns[3].get(i));
+        }
+    };
+
+    struct aabox3_stream {
+        vec3_stream center;
+        vec3_stream half_size;
+
+        uint32_t size() const { return center.size(); }
+        uint32_t padded_size() const { return center.padded_size(); }
+
+        void resize(uint32_t count) { center.resize(count); half_size.resize(count); }
+
+        inline void set(uint32_t i, const aabox3& b) { center.set(i, b.center); half_size.set(i, b.half_size); }
+        inline aabox3 get(uint32_t i) const { return aabox3(center.get(i), half_size.get(i)); }
+    };
+
+    // Stream kernels, the output streams are resized to match the input count.
+    // Input and output streams must not alias unless stated otherwise.
+
+    // out[i] = transformFrom(mat, p[i]) or transformFrom(mat[i], p[i])
+    CORE_API void stream_transformFrom(const mat4x3& mat, const vec3_stream& p, vec3_stream& out);
+    CORE_API void stream_transformFrom(const mat4x3_stream& mat, const vec3_stream& p, vec3_stream& out);
+
+    // out[i] = aabox_transformFrom(mat, b[i]) or aabox_transformFrom(mat[i], b[i])
+    CORE_API void stream_aabox_transformFrom(const mat4x3& mat, const aabox3_stream& b, aabox3_stream& out);
+    CORE_API void stream_aabox_transformFrom(const mat4x3_stream& mat, const aabox3_stream& b, aabox3_stream& out);
+
+    // Reduce a box stream to the containing box, returns false if the stream is empty
+    CORE_API bool stream_aabox_bound(const aabox3_stream& b, aabox3& bound);
+
+    // out[i] = mul(parent[i], local[i])
+    CORE_API void stream_mul(const mat4x3_stream& parent, const mat4x3_stream& local, mat4x3_stream& out);
+
+    // out[i] = mix(v0[i], v1[i], t[i])
+    CORE_API void stream_mix(const vec3_stream& v0, const vec3_stream& v1, const float_array& t, vec3_stream& out);
+
+    // out[i] = slerp(r0[i], r1[i], t[i])
+    CORE_API void stream_slerp(const rotor3_stream& r0, const rotor3_stream& r1, const float_array& t, rotor3_stream& out);
+
+    // r[i] = r[i].normal(), in place
+    CORE_API void stream_normalize(rotor3_stream& r);
+}
@@ -0,0 +1,341 @@
+// Adjacency.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Adjacency.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <unordered_map>
+
+#include "../Log.h"
+#include "../Job.h"
+#include "../stl/RadixSort.h"
+
+namespace core {
+
+    static const uint32_t ADJACENCY_INVALID = 0xFFFFFFFF;
+    static const uint32_t ADJACENCY_GRAIN = 16384;
+
+    void mesh_buildAdjacency(const uint32_t* indices, uint32_t numTriangles, const uint32_t* mainVertexIndices, MeshAdjacency& adjacency) {
+        adjacency.edges.clear();
+        adjacency.faces.resize(numTriangles);
+        adjacency.numBoundaryEdges = 0;
+        adjacency.numSeamEdges = 0;
+        adjacency.numNonManifoldEdges = 0;
+
+        const uint32_t numHalfEdges = 3 * numTriangles;
+        if (numHalfEdges == 0) {
+            return;
+        }
+        auto& pool = ThreadPool::shared();
+
+        uint32_t maxVertex = *std::max_element(indices, indices + numHalfEdges);
+        const uint32_t vertexBits = std::max(1u, (uint32_t) std::bit_width(maxVertex));
+        auto edgeKey = [vertexBits](uint32_t a, uint32_t b) -> uint64_t {
+            return (uint64_t(std::min(a, b)) << vertexBits) | uint64_t(std::max(a, b));
+        };
+
+        // Half edge h = 3 * t + k goes from vertex k to vertex (k + 1) % 3 of triangle t
+        std::vector<uint64_t> keys(numHalfEdges);
+        std::vector<uint32_t> halfEdges(numHalfEdges);
+        pool.parallel_for(numTriangles, ADJACENCY_GRAIN, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t t = begin; t < end; ++t) {
+                const uint32_t* tri = indices + 3 * t;
+                for (uint32_t k = 0; k < 3; ++k) {
+                    keys[3 * t + k] = edgeKey(tri[k], tri[(k + 1) % 3]);
+                    halfEdges[3 * t + k] = 3 * t + k;
+                }
+            }
+        });
+
+        // Half edges sharing a vertex pair are now contiguous, in increasing order thanks to the stable sort
+        radix_sort(keys, halfEdges, 2 * vertexBits);
+
+        // Pair the half edges of each run, the first half edge of a pair is the head of the edge record
+        std::vector<uint32_t> heads(numHalfEdges);
+        std::vector<uint32_t> twins(numHalfEdges, ADJACENCY_INVALID);
+        for (uint32_t i = 0; i < numHalfEdges;) {
+            uint32_t j = i + 1;
+            while (j < numHalfEdges && keys[j] == keys[i]) ++j;
+            if (j - i > 2) {
+                adjacency.numNonManifoldEdges++;
+            }
+            for (uint32_t r = i; r < j; r += 2) {
+                uint32_t head = halfEdges[r];
+                heads[head] = head;
+                if (r + 1 < j) {
+                    heads[halfEdges[r + 1]] = head;
+                    twins[head] = halfEdges[r + 1];
+                }
+            }
+            i = j;
+        }
+        keys.clear();
+        keys.shrink_to_fit();
+
+        // Number the edges in half edge order, reuse halfEdges as head half edge -> edge index
+        std::vector<uint32_t>& edgeIndices = halfEdges;
+        uint32_t numEdges = 0;
+        for (uint32_t h = 0; h < numHalfEdges; ++h) {
+            edgeIndices[h] = (heads[h] == h ? numEdges++ : ADJACENCY_INVALID);
+        }
+
+        adjacency.edges.resize(numEdges);
+        pool.parallel_for(numHalfEdges, ADJACENCY_GRAIN, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t h = begin; h < end; ++h) {
+                if (heads[h] != h) {
+                    continue;
+                }
+                uint32_t t = h / 3;
+                uint32_t a = indices[h];
+                uint32_t b = indices[3 * t + (h + 1) % 3];
+                adjacency.edges[edgeIndices[h]] = ivec4(std::min(a, b), std::max(a, b), t, (twins[h] == ADJACENCY_INVALID ? -1 : int32_t(twins[h] / 3)));
+            }
+        });
+        pool.parallel_for(numTriangles, ADJACENCY_GRAIN, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t t = begin; t < end; ++t) {
+                adjacency.faces[t] = ivec4(edgeIndices[heads[3 * t]], edgeIndices[heads[3 * t + 1]], edgeIndices[heads[3 * t + 2]], 0);
+            }
+        });
+
+        // Attribute seams: a main vertex pair carried by exactly 2 half edges, both on boundary edges,
+        // links the 2 edges as neighbors.
+        if (mainVertexIndices) {
+            std::vector<uint64_t> mainKeys(numEdges);
+            std::vector<uint32_t> mainEdges(numEdges);
+            pool.parallel_for(numEdges, ADJACENCY_GRAIN, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t e = begin; e < end; ++e) {
+                    const auto& edge = adjacency.edges[e];
+                    mainKeys[e] = edgeKey(mainVertexIndices[edge.x], mainVertexIndices[edge.y]);
+                    mainEdges[e] = e;
+                }
+            });
+            radix_sort(mainKeys, mainEdges, 2 * vertexBits);
+
+            for (uint32_t i = 0; i < numEdges;) {
+                uint32_t j = i + 1;
+                while (j < numEdges && mainKeys[j] == mainKeys[i]) ++j;
+                if (j - i == 2) {
+                    auto& e0 = adjacency.edges[mainEdges[i]];
+                    auto& e1 = adjacency.edges[mainEdges[i + 1]];
+                    if (e0.w == -1 && e1.w == -1) {
+                        e0.w = -(1 + e1.z);
+                        e1.w = -(1 + e0.z);
+                        adjacency.numSeamEdges += 2;
+                    }
+                }
+                i = j;
+            }
+        }
+
+        for (const auto& edge : adjacency.edges) {
+            adjacency.numBoundaryEdges += (edge.w == -1);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runMeshAdjacencyTests() to validate the adjacency builder
+// and runMeshAdjacencyBenchmarks() to compare it with a hash map based builder
+// -------------------------------------------------------------------------
+
+namespace {
+    // Grid of w x h quads sharing (w+1) x (h+1) vertices
+    void makeGrid(uint32_t w, uint32_t h, std::vector<uint32_t>& indices) {
+        indices.clear();
+        indices.reserve(6 * w * h);
+        for (uint32_t y = 0; y < h; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                uint32_t v0 = y * (w + 1) + x;
+                uint32_t v1 = v0 + 1;
+                uint32_t v2 = v0 + (w + 1);
+                uint32_t v3 = v2 + 1;
+                uint32_t quad[6] = { v0, v1, v2, v2, v1, v3 };
+                for (auto q : quad) indices.push_back(q);
+            }
+        }
+    }
+
+    // The previous ModelDrawFactory builder: hash map of the edges, then hash map of the main edges
+    void buildAdjacencyMap(const std::vector<uint32_t>& indices, const uint32_t* mainVertexIndices, core::MeshAdjacency& adjacency) {
+        struct LookupEdge { uint32_t index; };
+        std::unordered_map<uint64_t, LookupEdge> edgeMap;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> mainEdgeMap;
+        auto key = [](uint32_t a, uint32_t b) { return (uint64_t(std::min(a, b)) << 32) | std::max(a, b); };
+
+        uint32_t numTriangles = (uint32_t) indices.size() / 3;
+        adjacency.edges.clear();
+        adjacency.faces.resize(numTriangles);
+        for (uint32_t t = 0; t < numTriangles; ++t) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint32_t a = indices[3 * t + k];
+                uint32_t b = indices[3 * t + (k + 1) % 3];
+                auto it = edgeMap.find(key(a, b));
+                uint32_t e;
+                if (it == edgeMap.end()) {
+                    e = (uint32_t) adjacency.edges.size();
+                    adjacency.edges.emplace_back(core::ivec4(std::min(a, b), std::max(a, b), t, -1));
+                    edgeMap.insert({ key(a, b), { e } });
+                } else {
+                    e = it->second.index;
+                    adjacency.edges[e].w = t;
+                }
+                adjacency.faces[t][k] = e;
+                if (mainVertexIndices) {
+                    mainEdgeMap[key(mainVertexIndices[a], mainVertexIndices[b])].emplace_back(e);
+                }
+            }
+        }
+        if (mainVertexIndices) {
+            for (uint32_t e = 0; e < adjacency.edges.size(); ++e) {
+                auto& edge = adjacency.edges[e];
+                if (edge.w != -1) continue;
+                const auto& bucket = mainEdgeMap[key(mainVertexIndices[edge.x], mainVertexIndices[edge.y])];
+                if (bucket.size() == 2) {
+                    uint32_t other = (bucket[0] == e ? bucket[1] : bucket[0]);
+                    edge.w = -(1 + adjacency.edges[other].z);
+                }
+            }
+        }
+    }
+
+    bool sameAdjacency(const core::MeshAdjacency& a, const core::MeshAdjacency& b) {
+        if (a.edges.size() != b.edges.size() || a.faces.size() != b.faces.size()) return false;
+        for (size_t i = 0; i < a.edges.size(); ++i) {
+            for (int c = 0; c < 4; ++c) if (a.edges[i][c] != b.edges[i][c]) return false;
+        }
+        for (size_t i = 0; i < a.faces.size(); ++i) {
+            for (int c = 0; c < 3; ++c) if (a.faces[i][c] != b.faces[i][c]) return false;
+        }
+        return true;
+    }
+}
+
+void runMeshAdjacencyTests() {
+    using namespace core;
+    picoLog("MeshAdjacencyTest: starting...");
+
+    // --- Test 1: closed tetrahedron, every edge has 2 triangles ---
+    {
+        std::vector<uint32_t> indices = { 0, 1, 2,  0, 3, 1,  1, 3, 2,  2, 3, 0 };
+        MeshAdjacency adjacency;
+        mesh_buildAdjacency(indices.data(), 4, nullptr, adjacency);
+        assert(adjacency.edges.size() == 6);
+        assert(adjacency.numBoundaryEdges == 0 && adjacency.numNonManifoldEdges == 0);
+        for (uint32_t t = 0; t < 4; ++t) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                const auto& edge = adjacency.edges[adjacency.faces[t][k]];
+                assert(edge.z == int32_t(t) || edge.w == int32_t(t));
+                assert(edge.w >= 0);
+            }
+        }
+        picoLog("MeshAdjacencyTest 1 passed: closed mesh");
+    }
+
+    // --- Test 2: open grid, same edges, faces and order as the hash map builder ---
+    {
+        std::vector<uint32_t> indices;
+        makeGrid(17, 9, indices);
+        MeshAdjacency adjacency, reference;
+        mesh_buildAdjacency(indices.data(), (uint32_t) indices.size() / 3, nullptr, adjacency);
+        buildAdjacencyMap(indices, nullptr, reference);
+        assert(sameAdjacency(adjacency, reference));
+        assert(adjacency.numBoundaryEdges == 2 * (17 + 9));
+        picoLog("MeshAdjacencyTest 2 passed: open grid matches the reference");
+    }
+
+    // --- Test 3: attribute seam, the grid is cut along a column with duplicated vertices ---
+    {
+        const uint32_t w = 8, h = 4, cut = 3;
+        std::vector<uint32_t> indices;
+        makeGrid(w, h, indices);
+        uint32_t numGridVertices = (w + 1) * (h + 1);
+        std::vector<uint32_t> mainVertexIndices(numGridVertices);
+        for (uint32_t v = 0; v < numGridVertices; ++v) mainVertexIndices[v] = v;
+        // the quads right of the cut column use a copy of the column vertices
+        for (uint32_t y = 0; y < h; ++y) {
+            for (uint32_t q = 0; q < 6; ++q) {
+                auto& index = indices[6 * (y * w + cut) + q];
+                if (index % (w + 1) == cut) {
+                    uint32_t copy = numGridVertices + index / (w + 1);
+                    if (mainVertexIndices.size() <= copy) mainVertexIndices.resize(copy + 1);
+                    mainVertexIndices[copy] = index;
+                    index = copy;
+                }
+            }
+        }
+        MeshAdjacency adjacency, reference;
+        mesh_buildAdjacency(indices.data(), (uint32_t) indices.size() / 3, mainVertexIndices.data(), adjacency);
+        buildAdjacencyMap(indices, mainVertexIndices.data(), reference);
+        assert(sameAdjacency(adjacency, reference));
+        assert(adjacency.numSeamEdges == 2 * h);
+        picoLog("MeshAdjacencyTest 3 passed: seam edges are linked");
+    }
+
+    // --- Test 4: non-manifold fin, 3 triangles on one edge ---
+    {
+        std::vector<uint32_t> indices = { 0, 1, 2,  1, 0, 3,  0, 1, 4 };
+        MeshAdjacency adjacency;
+        mesh_buildAdjacency(indices.data(), 3, nullptr, adjacency);
+        assert(adjacency.numNonManifoldEdges == 1);
+        const auto& e0 = adjacency.edges[adjacency.faces[0][0]];
+        const auto& e2 = adjacency.edges[adjacency.faces[2][0]];
+        assert(e0.x == 0 && e0.y == 1 && e0.z == 0 && e0.w == 1);
+        assert(adjacency.faces[1][0] == adjacency.faces[0][0]);
+        assert(e2.z == 2 && e2.w == -1);
+        assert(adjacency.edges.size() == 8);
+        picoLog("MeshAdjacencyTest 4 passed: non-manifold edge split");
+    }
+
+    picoLog("MeshAdjacencyTest: all tests passed");
+}
+
+void runMeshAdjacencyBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<uint32_t> indices;
+    makeGrid(768, 768, indices); // 1.18M triangles
+    uint32_t numTriangles = (uint32_t) indices.size() / 3;
+    std::vector<uint32_t> mainVertexIndices(769 * 769);
+    for (uint32_t v = 0; v < mainVertexIndices.size(); ++v) mainVertexIndices[v] = v;
+
+    auto start = clock::now();
+    MeshAdjacency reference;
+    buildAdjacencyMap(indices, mainVertexIndices.data(), reference);
+    double mapMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    MeshAdjacency adjacency;
+    mesh_buildAdjacency(indices.data(), numTriangles, mainVertexIndices.data(), adjacency);
+    double sortMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    assert(sameAdjacency(adjacency, reference));
+    picoLogf("MeshAdjacencyBench {} triangles: unordered_map {:.2f} ms | radix sort {:.2f} ms ({} threads) | x{:.2f}",
+        numTriangles, mapMs, sortMs, ThreadPool::shared().threadCount() + 1, mapMs / sortMs);
+}
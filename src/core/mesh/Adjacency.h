@@ -0,0 +1,63 @@
+// Adjacency.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../math/Vec.h"
+#include "../dllmain.h"
+
+namespace core {
+
+    // Edge and face adjacency of an indexed triangle list.
+    //
+    // edges[e] = (v0, v1, t0, t1):
+    //   v0 < v1 the 2 vertex indices of the edge,
+    //   t0 the first triangle using the edge,
+    //   t1 the second triangle or
+    //      -1 on a boundary edge,
+    //      -(1 + t) on an attribute seam, t is the t0 of the other boundary edge sharing the same main vertices.
+    // faces[t] = (e0, e1, e2, 0): the edges v0->v1, v1->v2, v2->v0 of triangle t.
+    //
+    // Edges are numbered in order of first appearance in the index stream.
+    // A vertex pair shared by more than 2 triangles (non-manifold) is split in several edges,
+    // pairing the triangles in index order, an odd triangle out gets a boundary edge.
+    struct MeshAdjacency {
+        std::vector<ivec4> edges;
+        std::vector<ivec4> faces;
+
+        uint32_t numBoundaryEdges{ 0 };    // edges with a single triangle, seams excluded
+        uint32_t numSeamEdges{ 0 };        // boundary edges linked through their main vertices
+        uint32_t numNonManifoldEdges{ 0 }; // vertex pairs shared by more than 2 triangles
+    };
+
+    // Build the adjacency by radix sorting the packed (v0, v1) key of every half edge.
+    // mainVertexIndices (optional) maps each vertex to the first vertex at the same position,
+    // used to link the boundary edges split by an attribute seam.
+    CORE_API void mesh_buildAdjacency(const uint32_t* indices, uint32_t numTriangles, const uint32_t* mainVertexIndices, MeshAdjacency& adjacency);
+}
@@ -0,0 +1,356 @@
+// Meshlet.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include "../Log.h"
+#include "../math/CameraTransform.h"
+
+namespace core {
+
+    namespace {
+        inline vec3 meshlet_position(const float* positions, uint32_t stride, uint32_t v) {
+            const float* p = (const float*) (((const uint8_t*) positions) + size_t(v) * stride);
+            return vec3(p[0], p[1], p[2]);
+        }
+
+        MeshletBounds meshlet_computeBounds(const MeshletSet& set, const Meshlet& m, const float* positions, uint32_t stride) {
+            MeshletBounds bounds;
+
+            // Sphere around the box of the vertices
+            vec3 minPos = meshlet_position(positions, stride, set.vertices[m.vertexOffset]);
+            vec3 maxPos = minPos;
+            for (uint32_t i = 1; i < m.numVertices; ++i) {
+                vec3 p = meshlet_position(positions, stride, set.vertices[m.vertexOffset + i]);
+                minPos = min(minPos, p);
+                maxPos = max(maxPos, p);
+            }
+            vec3 center = (minPos + maxPos) * 0.5f;
+            float radius = 0.0f;
+            for (uint32_t i = 0; i < m.numVertices; ++i) {
+                radius = std::max(radius, length(meshlet_position(positions, stride, set.vertices[m.vertexOffset + i]) - center));
+            }
+            bounds.sphere = vec4(center, radius);
+
+            // Cone around the triangle normals, degenerate triangles are ignored
+            vec3 normals[MESHLET_MAX_TRIANGLES];
+            uint32_t numNormals = 0;
+            vec3 axis(0.0f);
+            for (uint32_t t = 0; t < m.numTriangles && numNormals < MESHLET_MAX_TRIANGLES; ++t) {
+                uint32_t packed = set.triangles[m.triangleOffset + t];
+                vec3 p0 = meshlet_position(positions, stride, set.vertices[m.vertexOffset + meshlet_triangleIndex(packed, 0)]);
+                vec3 p1 = meshlet_position(positions, stride, set.vertices[m.vertexOffset + meshlet_triangleIndex(packed, 1)]);
+                vec3 p2 = meshlet_position(positions, stride, set.vertices[m.vertexOffset + meshlet_triangleIndex(packed, 2)]);
+                vec3 n = cross(p1 - p0, p2 - p0);
+                float l = length(n);
+                if (l > 0.0f) {
+                    normals[numNormals] = n * (1.0f / l);
+                    axis = axis + normals[numNormals];
+                    numNormals++;
+                }
+            }
+
+            // No cone (cutoff 1 never culls) if the normals spread over more than ~84 degrees from the axis
+            bounds.cone = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            float axisLength = length(axis);
+            if (numNormals && axisLength > 0.0f) {
+                axis = axis * (1.0f / axisLength);
+                float minDot = 1.0f;
+                for (uint32_t i = 0; i < numNormals; ++i) {
+                    minDot = std::min(minDot, dot(normals[i], axis));
+                }
+                if (minDot > 0.1f) {
+                    bounds.cone = vec4(axis, sqrtf(1.0f - minDot * minDot));
+                }
+            }
+            return bounds;
+        }
+    }
+
+    uint32_t mesh_buildMeshlets(const uint32_t* indices, uint32_t numIndices, const float* positions, uint32_t positionStride, MeshletSet& set,
+        uint32_t maxVertices, uint32_t maxTriangles) {
+        assert(maxVertices <= 256 && maxTriangles <= MESHLET_MAX_TRIANGLES); // local indices are packed on 8 bits
+        const uint16_t NOT_IN_MESHLET = 0xFFFF;
+        const uint32_t firstMeshlet = set.size();
+        const uint32_t numTriangles = numIndices / 3;
+        if (numTriangles == 0) {
+            return 0;
+        }
+
+        // Mesh vertex -> local vertex in the current meshlet, sized on the range of referenced vertices.
+        // 16 bits so that the local index 255 of a full 256 vertices meshlet is not taken for the sentinel.
+        uint32_t maxVertex = *std::max_element(indices, indices + numIndices);
+        std::vector<uint16_t> localIndices(maxVertex + 1, NOT_IN_MESHLET);
+
+        Meshlet current;
+        current.vertexOffset = (uint32_t) set.vertices.size();
+        current.triangleOffset = (uint32_t) set.triangles.size();
+
+        auto flush = [&]() {
+            for (uint32_t i = 0; i < current.numVertices; ++i) {
+                localIndices[set.vertices[current.vertexOffset + i]] = NOT_IN_MESHLET;
+            }
+            set.meshlets.emplace_back(current);
+            set.bounds.emplace_back(meshlet_computeBounds(set, current, positions, positionStride));
+            current = Meshlet{ (uint32_t) set.vertices.size(), (uint32_t) set.triangles.size(), 0, 0 };
+        };
+
+        for (uint32_t t = 0; t < numTriangles; ++t) {
+            const uint32_t* tri = indices + 3 * t;
+            uint32_t numNew = (localIndices[tri[0]] == NOT_IN_MESHLET) + (localIndices[tri[1]] == NOT_IN_MESHLET) + (localIndices[tri[2]] == NOT_IN_MESHLET);
+            if (tri[1] == tri[0] || tri[2] == tri[0]) numNew -= (localIndices[tri[0]] == NOT_IN_MESHLET);
+            if (tri[2] == tri[1] && tri[1] != tri[0]) numNew -= (localIndices[tri[1]] == NOT_IN_MESHLET);
+
+            if (current.numVertices + numNew > maxVertices || current.numTriangles + 1 > maxTriangles) {
+                flush();
+            }
+
+            uint32_t local[3];
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint16_t& l = localIndices[tri[k]];
+                if (l == NOT_IN_MESHLET) {
+                    l = (uint16_t) current.numVertices++;
+                    set.vertices.emplace_back(tri[k]);
+                }
+                local[k] = l;
+            }
+            set.triangles.emplace_back(meshlet_packTriangle(local[0], local[1], local[2]));
+            current.numTriangles++;
+        }
+        flush();
+
+        return set.size() - firstMeshlet;
+    }
+
+    uint32_t mesh_cullMeshlets(const MeshletBounds* bounds, uint32_t first, uint32_t count, const mat4x3& transform,
+        const vec4 planes[6], const vec3& eye, std::vector<uint32_t>& visible) {
+        float scale = std::max(length(transform.x()), std::max(length(transform.y()), length(transform.z())));
+        uint32_t numVisible = 0;
+        for (uint32_t i = first; i < first + count; ++i) {
+            const auto& b = bounds[i];
+            vec3 center = transformFrom(transform, b.sphere.xyz());
+            float radius = b.sphere.w * scale;
+
+            bool culled = false;
+            for (int p = 0; p < 6 && !culled; ++p) {
+                culled = (dot(planes[p].xyz(), center) + planes[p].w < -radius);
+            }
+            if (!culled && b.cone.w < 1.0f) {
+                vec3 axis = normalize(rotateFrom(transform, b.cone.xyz()));
+                vec3 toCenter = center - eye;
+                culled = (dot(toCenter, axis) >= b.cone.w * length(toCenter) + radius);
+            }
+            if (!culled) {
+                visible.emplace_back(i);
+                numVisible++;
+            }
+        }
+        return numVisible;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runMeshletTests() to validate the meshlet builder and
+// the cluster culling, runMeshletBenchmarks() for the build timing
+// -------------------------------------------------------------------------
+
+namespace {
+    // Grid of w x h quads in the z = 0 plane, facing +z.
+    // Quads are emitted by tiles of tile x tile quads, the locality a vertex cache optimized mesh would have.
+    void makeGrid(uint32_t w, uint32_t h, uint32_t tile, std::vector<core::vec4>& positions, std::vector<uint32_t>& indices) {
+        positions.clear();
+        indices.clear();
+        for (uint32_t y = 0; y <= h; ++y) {
+            for (uint32_t x = 0; x <= w; ++x) {
+                positions.emplace_back(core::vec4(float(x), float(y), 0.0f, 0.0f));
+            }
+        }
+        for (uint32_t ty = 0; ty < h; ty += tile) {
+            for (uint32_t tx = 0; tx < w; tx += tile) {
+                for (uint32_t y = ty; y < std::min(h, ty + tile); ++y) {
+                    for (uint32_t x = tx; x < std::min(w, tx + tile); ++x) {
+                        uint32_t v0 = y * (w + 1) + x;
+                        uint32_t v1 = v0 + 1;
+                        uint32_t v2 = v0 + (w + 1);
+                        uint32_t v3 = v2 + 1;
+                        uint32_t quad[6] = { v0, v1, v2, v2, v1, v3 };
+                        for (auto q : quad) indices.push_back(q);
+                    }
+                }
+            }
+        }
+    }
+
+    core::View makeView(const core::vec3& eye, const core::vec3& front) {
+        core::View view;
+        view.setEye(eye);
+        view.setOrientationFromFrontUp(front, core::vec3(0.0f, 1.0f, 0.0f));
+        return view;
+    }
+}
+
+void runMeshletTests() {
+    using namespace core;
+    picoLog("MeshletTest: starting...");
+
+    std::vector<vec4> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(40, 40, 6, positions, indices);
+
+    MeshletSet set;
+    uint32_t numMeshlets = mesh_buildMeshlets(indices.data(), (uint32_t) indices.size(), &positions[0].x, sizeof(vec4), set);
+
+    // --- Test 1: limits are respected and the meshlets give back the index stream ---
+    {
+        assert(numMeshlets == set.size() && numMeshlets >= 3200 / MESHLET_MAX_TRIANGLES);
+        uint32_t i = 0;
+        for (const auto& m : set.meshlets) {
+            assert(m.numVertices <= MESHLET_MAX_VERTICES && m.numTriangles <= MESHLET_MAX_TRIANGLES);
+            for (uint32_t t = 0; t < m.numTriangles; ++t) {
+                for (uint32_t k = 0; k < 3; ++k) {
+                    uint32_t local = meshlet_triangleIndex(set.triangles[m.triangleOffset + t], k);
+                    assert(local < m.numVertices);
+                    assert(set.vertices[m.vertexOffset + local] == indices[i++]);
+                }
+            }
+        }
+        assert(i == indices.size());
+        picoLog("MeshletTest 1 passed: meshlets cover the index stream");
+    }
+
+    // --- Test 2: bounds contain the vertices, the cone of a flat grid is +z ---
+    {
+        for (uint32_t mi = 0; mi < numMeshlets; ++mi) {
+            const auto& m = set.meshlets[mi];
+            const auto& b = set.bounds[mi];
+            for (uint32_t v = 0; v < m.numVertices; ++v) {
+                assert(length(positions[set.vertices[m.vertexOffset + v]].xyz() - b.sphere.xyz()) <= b.sphere.w * 1.0001f);
+            }
+            assert(b.cone.z > 0.999f && b.cone.w < 0.01f);
+        }
+        picoLog("MeshletTest 2 passed: bounding spheres and normal cones");
+    }
+
+    // --- Test 3: culling, frustum and back facing cones ---
+    {
+        Projection proj;
+        proj.setFov(1.0f);
+        mat4x3 identity;
+        std::vector<uint32_t> visible;
+
+        // in front of the grid looking at it, everything is visible
+        auto view = makeView(vec3(20.0f, 20.0f, 60.0f), vec3(0.0f, 0.0f, -1.0f));
+        vec4 planes[6];
+        frustum_planes(view, proj, planes);
+        assert(mesh_cullMeshlets(set.bounds.data(), 0, numMeshlets, identity, planes, view.eye(), visible) == numMeshlets);
+
+        // behind the grid looking at it, every meshlet is back facing
+        visible.clear();
+        view = makeView(vec3(20.0f, 20.0f, -60.0f), vec3(0.0f, 0.0f, 1.0f));
+        frustum_planes(view, proj, planes);
+        assert(mesh_cullMeshlets(set.bounds.data(), 0, numMeshlets, identity, planes, view.eye(), visible) == 0);
+
+        // in front looking away, out of the frustum
+        visible.clear();
+        view = makeView(vec3(20.0f, 20.0f, 60.0f), vec3(0.0f, 0.0f, 1.0f));
+        frustum_planes(view, proj, planes);
+        assert(mesh_cullMeshlets(set.bounds.data(), 0, numMeshlets, identity, planes, view.eye(), visible) == 0);
+
+        // close to a corner, only part of the grid is in the frustum
+        visible.clear();
+        view = makeView(vec3(2.0f, 2.0f, 5.0f), vec3(0.0f, 0.0f, -1.0f));
+        frustum_planes(view, proj, planes);
+        uint32_t numVisible = mesh_cullMeshlets(set.bounds.data(), 0, numMeshlets, identity, planes, view.eye(), visible);
+        assert(numVisible > 0 && numVisible < numMeshlets / 2);
+
+        // the same grid flipped by the transform is back facing
+        visible.clear();
+        mat4x3 flip(vec3(-1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(40.0f, 0.0f, 0.0f)); // half turn around y
+        view = makeView(vec3(20.0f, 20.0f, 60.0f), vec3(0.0f, 0.0f, -1.0f));
+        frustum_planes(view, proj, planes);
+        assert(mesh_cullMeshlets(set.bounds.data(), 0, numMeshlets, flip, planes, view.eye(), visible) == 0);
+        picoLog("MeshletTest 3 passed: frustum and cone culling");
+    }
+
+    // --- Test 4: a full 256 vertices meshlet, the vertex of local index 255 is found again by the next triangle ---
+    {
+        std::vector<uint32_t> soupIndices;
+        for (uint32_t v = 0; v < 255; ++v) {
+            soupIndices.push_back(v); // 85 triangles, no vertex shared
+        }
+        for (uint32_t v : { 0u, 1u, 255u, 255u, 2u, 3u }) {
+            soupIndices.push_back(v);
+        }
+        std::vector<vec4> soupPositions(256);
+        for (uint32_t v = 0; v < soupPositions.size(); ++v) {
+            soupPositions[v] = vec4(float(v % 3), float(v / 3), 0.0f, 0.0f);
+        }
+        MeshletSet soup;
+        assert(mesh_buildMeshlets(soupIndices.data(), (uint32_t) soupIndices.size(), &soupPositions[0].x, sizeof(vec4), soup, 256) == 1);
+        const auto& m = soup.meshlets[0];
+        assert(m.numVertices == 256 && m.numTriangles == 87 && soup.vertices.size() == 256);
+        for (uint32_t i = 0; i < soupIndices.size(); ++i) {
+            uint32_t local = meshlet_triangleIndex(soup.triangles[i / 3], i % 3);
+            assert(soup.vertices[local] == soupIndices[i]);
+        }
+        picoLog("MeshletTest 4 passed: 256 vertices meshlet");
+    }
+
+    picoLog("MeshletTest: all tests passed");
+}
+
+void runMeshletBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<vec4> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(768, 768, 6, positions, indices);
+
+    auto start = clock::now();
+    MeshletSet set;
+    mesh_buildMeshlets(indices.data(), (uint32_t) indices.size(), &positions[0].x, sizeof(vec4), set);
+    double buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    Projection proj;
+    proj.setFov(1.0f);
+    auto view = makeView(vec3(100.0f, 100.0f, 50.0f), vec3(0.0f, 0.0f, -1.0f));
+    vec4 planes[6];
+    frustum_planes(view, proj, planes);
+    std::vector<uint32_t> visible;
+    visible.reserve(set.size());
+    start = clock::now();
+    uint32_t numVisible = mesh_cullMeshlets(set.bounds.data(), 0, set.size(), mat4x3(), planes, view.eye(), visible);
+    double cullMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    picoLogf("MeshletBench {} triangles: {} meshlets built in {:.2f} ms | {} visible culled in {:.3f} ms",
+        indices.size() / 3, set.size(), buildMs, numVisible, cullMs);
+}
@@ -0,0 +1,78 @@
+// Meshlet.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../math/Math3D.h"
+#include "../dllmain.h"
+
+namespace core {
+
+    // Meshlets: clusters of at most 64 vertices and 124 triangles of an indexed triangle list,
+    // each with a bounding sphere and a normal cone to cull the whole cluster at once.
+
+    constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+    constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+    struct Meshlet {
+        uint32_t vertexOffset{ 0 };   // first vertex in MeshletSet::vertices
+        uint32_t triangleOffset{ 0 }; // first triangle in MeshletSet::triangles
+        uint32_t numVertices{ 0 };
+        uint32_t numTriangles{ 0 };
+    };
+
+    struct MeshletBounds {
+        vec4 sphere; // center, radius
+        vec4 cone;   // axis, cutoff: the meshlet is back facing if dot(center - eye, axis) >= cutoff * length(center - eye) + radius
+    };
+
+    struct MeshletSet {
+        std::vector<Meshlet> meshlets;
+        std::vector<MeshletBounds> bounds;
+        std::vector<uint32_t> vertices;  // meshlet local vertex -> mesh vertex
+        std::vector<uint32_t> triangles; // 3 meshlet local vertices packed in 8 bits each
+
+        uint32_t size() const { return (uint32_t) meshlets.size(); }
+    };
+
+    inline uint32_t meshlet_packTriangle(uint32_t i0, uint32_t i1, uint32_t i2) { return i0 | (i1 << 8) | (i2 << 16); }
+    inline uint32_t meshlet_triangleIndex(uint32_t packed, uint32_t k) { return (packed >> (8 * k)) & 0xFF; }
+
+    // Split the triangles in meshlets, in index order, and append them to the set.
+    // Positions are 3 floats every positionStride bytes.
+    // Returns the number of meshlets appended.
+    CORE_API uint32_t mesh_buildMeshlets(const uint32_t* indices, uint32_t numIndices, const float* positions, uint32_t positionStride, MeshletSet& set,
+        uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+    // CPU reference culling of the meshlets [first, first + count) of a mesh placed in world by transform.
+    // A meshlet is kept if its sphere intersects the frustum (see frustum_planes) and its cone is not back facing the eye.
+    // Indices of the kept meshlets are appended to visible, returns the number of meshlets kept.
+    CORE_API uint32_t mesh_cullMeshlets(const MeshletBounds* bounds, uint32_t first, uint32_t count, const mat4x3& transform,
+        const vec4 planes[6], const vec3& eye, std::vector<uint32_t>& visible);
+}
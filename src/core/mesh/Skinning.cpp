@@ -0,0 +1,324 @@
+// Skinning.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Skinning.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "../Log.h"
+#include "../Job.h"
+
+// The skin kernel is a plain loop over the padded count like the Stream.cpp kernels,
+// the joint matrix loads are indexed so AVX2 builds turn them into gathers.
+
+namespace {
+    static_assert(sizeof(core::mat4x3) == 12 * sizeof(float), "the skin kernel reads the mat4x3 as 12 floats");
+
+    static const uint32_t SKIN_GRAIN = 4096; // vertices per job, a multiple of STREAM_LANES
+
+    void kernel_skin(uint32_t n, const float* __restrict m,
+        const uint32_t* __restrict j0, const uint32_t* __restrict j1, const uint32_t* __restrict j2, const uint32_t* __restrict j3,
+        const float* __restrict w0, const float* __restrict w1, const float* __restrict w2, const float* __restrict w3,
+        const float* __restrict x, const float* __restrict y, const float* __restrict z,
+        float* __restrict ox, float* __restrict oy, float* __restrict oz) {
+        for (uint32_t i = 0; i < n; ++i) {
+            // blend the 4 skin matrices then transform the position once
+            const float* m0 = m + 12 * j0[i];
+            const float* m1 = m + 12 * j1[i];
+            const float* m2 = m + 12 * j2[i];
+            const float* m3 = m + 12 * j3[i];
+            float b[12];
+            for (uint32_t c = 0; c < 12; ++c) {
+                b[c] = w0[i] * m0[c] + w1[i] * m1[c] + w2[i] * m2[c] + w3[i] * m3[c];
+            }
+            ox[i] = b[0] * x[i] + b[3] * y[i] + b[6] * z[i] + b[9];
+            oy[i] = b[1] * x[i] + b[4] * y[i] + b[7] * z[i] + b[10];
+            oz[i] = b[2] * x[i] + b[5] * y[i] + b[8] * z[i] + b[11];
+        }
+    }
+}
+
+namespace core {
+
+    void skin_unpack(const uint32_t* packedWeights, const uint32_t* packedJoints, uint32_t stride, uint32_t count, skin_stream& out) {
+        out.resize(count);
+        const uint8_t* w = (const uint8_t*) packedWeights;
+        const uint8_t* j = (const uint8_t*) packedJoints;
+        for (uint32_t i = 0; i < count; ++i, w += stride, j += stride) {
+            uint32_t sw = *(const uint32_t*) w;
+            uint32_t sj = *(const uint32_t*) j;
+            float weights[SKIN_MAX_INFLUENCES];
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+                weights[k] = skin_unpackWeight(sw, k);
+                sum += weights[k];
+            }
+            float norm = (sum > 0.0f ? 1.0f / sum : 0.0f);
+            for (uint32_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+                out.weights[k][i] = weights[k] * norm;
+                out.joints[k][i] = skin_unpackJoint(sj, k);
+            }
+            if (sum <= 0.0f) {
+                out.weights[0][i] = 1.0f;
+                out.joints[0][i] = 0;
+            }
+        }
+    }
+
+    void stream_skin(const mat4x3* skinMatrices, const skin_stream& skin, const vec3_stream& p, vec3_stream& out) {
+        out.resize(p.size());
+        uint32_t n = p.padded_size();
+        const float* m = (const float*) skinMatrices;
+        ThreadPool::shared().parallel_for(n, SKIN_GRAIN, [&](uint32_t begin, uint32_t end) {
+            kernel_skin(end - begin, m,
+                skin.joints[0].data() + begin, skin.joints[1].data() + begin, skin.joints[2].data() + begin, skin.joints[3].data() + begin,
+                skin.weights[0].data() + begin, skin.weights[1].data() + begin, skin.weights[2].data() + begin, skin.weights[3].data() + begin,
+                p.x.data() + begin, p.y.data() + begin, p.z.data() + begin,
+                out.x.data() + begin, out.y.data() + begin, out.z.data() + begin);
+        });
+    }
+
+    void skin_buildJointBounds(const skin_stream& skin, const vec3_stream& p, const mat4x3* invBindMatrices, uint32_t numJoints, SkinJointBounds& bounds) {
+        std::vector<vec3> minPos(numJoints, vec3(std::numeric_limits<float>::max()));
+        std::vector<vec3> maxPos(numJoints, vec3(-std::numeric_limits<float>::max()));
+        for (uint32_t i = 0; i < p.size(); ++i) {
+            vec3 v = p.get(i);
+            for (uint32_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+                if (skin.weights[k][i] <= 0.0f) continue;
+                uint32_t j = skin.joints[k][i];
+                vec3 jv = transformFrom(invBindMatrices[j], v);
+                minPos[j] = min(minPos[j], jv);
+                maxPos[j] = max(maxPos[j], jv);
+            }
+        }
+
+        bounds.joints.clear();
+        bounds.boxes.clear();
+        for (uint32_t j = 0; j < numJoints; ++j) {
+            if (minPos[j].x > maxPos[j].x) continue;
+            bounds.joints.push_back(j);
+            bounds.boxes.push_back(aabox3::fromMinMax(minPos[j], maxPos[j]));
+        }
+    }
+
+    aabox3 skin_bound(const SkinJointBounds& bounds, const mat4x3* jointMatrices) {
+        if (bounds.joints.empty()) return aabox3();
+        aabox3 bound = aabox_transformFrom(jointMatrices[bounds.joints[0]], bounds.boxes[0]);
+        for (size_t b = 1; b < bounds.joints.size(); ++b) {
+            bound = aabox3::fromBound(bound, aabox_transformFrom(jointMatrices[bounds.joints[b]], bounds.boxes[b]));
+        }
+        return bound;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runSkinningTests() to validate the skin kernel and the
+// joint bounds, runSkinningBenchmarks() to measure them against a scalar
+// per vertex skinning and the exact skinned bound
+// -------------------------------------------------------------------------
+
+namespace {
+    struct SkinTestRig {
+        std::vector<core::vec3> positions;
+        std::vector<uint32_t> packed; // sw, sj interleaved as in the vertex attribs
+        std::vector<core::mat4x3> invBindMatrices;
+        std::vector<core::mat4x3> jointMatrices;
+        std::vector<core::mat4x3> skinMatrices;
+    };
+
+    // Cylinder along Y skinned on a chain of numJoints joints, each vertex blended between its 2 closest joints
+    void makeRig(uint32_t numRings, uint32_t numSegments, uint32_t numJoints, float bendAngle, SkinTestRig& rig) {
+        const float height = 4.0f;
+        const float spacing = height / float(numJoints);
+        for (uint32_t r = 0; r < numRings; ++r) {
+            float y = height * float(r) / float(numRings - 1);
+            float jf = std::min(y / spacing, float(numJoints - 1) - 0.001f);
+            uint32_t j = uint32_t(jf);
+            float t = jf - float(j);
+            uint32_t w0 = uint32_t(255 * (1.0f - t));
+            uint32_t w1 = uint32_t(255 * t);
+            for (uint32_t s = 0; s < numSegments; ++s) {
+                float a = 6.2831853f * float(s) / float(numSegments);
+                rig.positions.push_back(core::vec3(0.3f * std::cos(a), y, 0.3f * std::sin(a)));
+                rig.packed.push_back(w0 | (w1 << 8));
+                rig.packed.push_back(j | ((j + 1 < numJoints ? j + 1 : j) << 8));
+            }
+        }
+
+        core::mat4x3 parent;
+        for (uint32_t j = 0; j < numJoints; ++j) {
+            rig.invBindMatrices.push_back(core::translation(core::vec3(0.0f, -spacing * j, 0.0f)));
+            // each joint bends its chain around Z
+            core::mat4x3 local = core::translation_rotation(core::vec3(0.0f, (j ? spacing : 0.0f), 0.0f),
+                core::rotor3::make_from_quaternion(core::vec4(0.0f, 0.0f, std::sin(0.5f * bendAngle), std::cos(0.5f * bendAngle))));
+            parent = core::mul(parent, local);
+            rig.jointMatrices.push_back(parent);
+            rig.skinMatrices.push_back(core::mul(parent, rig.invBindMatrices.back()));
+        }
+    }
+
+    core::vec3_stream makePositionStream(const std::vector<core::vec3>& positions) {
+        core::vec3_stream p;
+        p.resize((uint32_t) positions.size());
+        for (uint32_t i = 0; i < positions.size(); ++i) p.set(i, positions[i]);
+        return p;
+    }
+
+    // Per vertex scalar skinning, the way the vertex shader does it
+    void skinScalar(const SkinTestRig& rig, std::vector<core::vec3>& out) {
+        out.resize(rig.positions.size());
+        for (size_t i = 0; i < rig.positions.size(); ++i) {
+            uint32_t sw = rig.packed[2 * i];
+            uint32_t sj = rig.packed[2 * i + 1];
+            float sum = 0.0f;
+            core::vec3 p(0.0f);
+            for (uint32_t k = 0; k < core::SKIN_MAX_INFLUENCES; ++k) {
+                float w = core::skin_unpackWeight(sw, k);
+                sum += w;
+                p = p + core::transformFrom(rig.skinMatrices[core::skin_unpackJoint(sj, k)], rig.positions[i]) * w;
+            }
+            out[i] = p * (1.0f / sum);
+        }
+    }
+
+    core::aabox3 exactBound(const core::vec3_stream& p) {
+        core::vec3 lo = p.get(0), hi = p.get(0);
+        for (uint32_t i = 1; i < p.size(); ++i) {
+            lo = core::min(lo, p.get(i));
+            hi = core::max(hi, p.get(i));
+        }
+        return core::aabox3::fromMinMax(lo, hi);
+    }
+
+    bool contains(const core::aabox3& b, const core::aabox3& inner, float eps) {
+        return core::length(core::max(b.minPos() - inner.minPos(), core::vec3(0.0f))) <= eps
+            && core::length(core::max(inner.maxPos() - b.maxPos(), core::vec3(0.0f))) <= eps;
+    }
+}
+
+void runSkinningTests() {
+    using namespace core;
+    picoLog("SkinningTest: starting...");
+
+    SkinTestRig rig;
+    makeRig(33, 16, 5, 0.4f, rig);
+    uint32_t numVertices = (uint32_t) rig.positions.size();
+
+    skin_stream skin;
+    skin_unpack(&rig.packed[0], &rig.packed[1], 2 * sizeof(uint32_t), numVertices, skin);
+    auto bindPositions = makePositionStream(rig.positions);
+
+    // --- Test 1: unpacked weights are normalized ---
+    {
+        for (uint32_t i = 0; i < numVertices; ++i) {
+            float sum = skin.weights[0][i] + skin.weights[1][i] + skin.weights[2][i] + skin.weights[3][i];
+            assert(std::fabs(sum - 1.0f) < 1e-5f);
+        }
+        assert(skin.weights[0][skin.padded_size() - 1] == 0.0f);
+        picoLog("SkinningTest 1 passed: unpacked weights sum to 1");
+    }
+
+    // --- Test 2: the stream kernel matches the per vertex skinning ---
+    {
+        std::vector<vec3> reference;
+        skinScalar(rig, reference);
+        vec3_stream skinned;
+        stream_skin(rig.skinMatrices.data(), skin, bindPositions, skinned);
+        assert(skinned.size() == numVertices);
+        for (uint32_t i = 0; i < numVertices; ++i) {
+            assert(length(skinned.get(i) - reference[i]) < 1e-4f);
+        }
+        picoLog("SkinningTest 2 passed: stream_skin matches the scalar skinning");
+    }
+
+    // --- Test 3: the joint bounds contain the skinned vertices ---
+    {
+        SkinJointBounds jointBounds;
+        skin_buildJointBounds(skin, bindPositions, rig.invBindMatrices.data(), (uint32_t) rig.invBindMatrices.size(), jointBounds);
+        assert(jointBounds.joints.size() == rig.invBindMatrices.size());
+
+        vec3_stream skinned;
+        stream_skin(rig.skinMatrices.data(), skin, bindPositions, skinned);
+        auto exact = exactBound(skinned);
+        auto bound = skin_bound(jointBounds, rig.jointMatrices.data());
+        assert(contains(bound, exact, 1e-4f));
+        // in bind pose the joint bounds rebuild the exact bound
+        std::vector<mat4x3> bindJoints(rig.invBindMatrices.size());
+        for (size_t j = 0; j < bindJoints.size(); ++j) bindJoints[j] = inverse(rig.invBindMatrices[j]);
+        auto bindBound = skin_bound(jointBounds, bindJoints.data());
+        auto bindExact = exactBound(bindPositions);
+        assert(length(bindBound.center - bindExact.center) < 1e-4f && length(bindBound.half_size - bindExact.half_size) < 1e-4f);
+        picoLog("SkinningTest 3 passed: joint bounds contain the skinned vertices");
+    }
+
+    picoLog("SkinningTest: all tests passed");
+}
+
+void runSkinningBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    SkinTestRig rig;
+    makeRig(2048, 128, 24, 0.1f, rig);
+    uint32_t numVertices = (uint32_t) rig.positions.size();
+
+    skin_stream skin;
+    skin_unpack(&rig.packed[0], &rig.packed[1], 2 * sizeof(uint32_t), numVertices, skin);
+    auto bindPositions = makePositionStream(rig.positions);
+    SkinJointBounds jointBounds;
+    skin_buildJointBounds(skin, bindPositions, rig.invBindMatrices.data(), (uint32_t) rig.invBindMatrices.size(), jointBounds);
+
+    auto time = [](auto&& fn) {
+        auto start = clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    };
+
+    std::vector<vec3> reference;
+    double scalarMs = time([&]() { skinScalar(rig, reference); });
+
+    vec3_stream skinned;
+    double streamMs = time([&]() { stream_skin(rig.skinMatrices.data(), skin, bindPositions, skinned); });
+
+    aabox3 exact, bound;
+    double exactMs = time([&]() { exact = exactBound(skinned); });
+    double boundMs = time([&]() { bound = skin_bound(jointBounds, rig.jointMatrices.data()); });
+
+    // How much larger the joint bound is than the exact bound of the skinned vertices
+    float boundError = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        boundError = std::max(boundError, (bound.half_size[c] - exact.half_size[c]) / exact.half_size[c]);
+    }
+
+    picoLogf("SkinningBench {} vertices {} joints, {} threads: scalar {:.0f} vertices/ms | stream_skin {:.0f} vertices/ms | x{:.2f}",
+        numVertices, rig.invBindMatrices.size(), ThreadPool::shared().threadCount(), numVertices / scalarMs, numVertices / streamMs, scalarMs / streamMs);
+    picoLogf("SkinningBench bound: exact {:.3f} ms | joint bounds {:.4f} ms, {:.1f}% larger than exact",
+        exactMs, boundMs, 100.0f * boundError);
+}
@@ -0,0 +1,89 @@
+// Skinning.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../math/Math3D.h"
+#include "../math/Stream.h"
+#include "../dllmain.h"
+
+namespace core {
+
+    // CPU linear blend skinning: each vertex is placed by the weighted sum of up to 4 joint skin matrices.
+    // The vertex influences are unpacked once in SoA streams, then skinned every frame by a stream kernel.
+
+    static const uint32_t SKIN_MAX_INFLUENCES = 4;
+
+    // Vertex skin params packed in 2 words: 4 weights in unorm8 and 4 joint indices in 8 bits,
+    // the layout of the model vertex attribs, see unpackSkinParamFrom2U in Mesh_inc.hlsl
+    inline float skin_unpackWeight(uint32_t packedWeights, uint32_t k) { return float((packedWeights >> (k * 8)) & 0xFF) * (1.0f / 255.0f); }
+    inline uint32_t skin_unpackJoint(uint32_t packedJoints, uint32_t k) { return (packedJoints >> (k * 8)) & 0xFF; }
+
+    using uint_array = std::vector<uint32_t, aligned_allocator<uint32_t, STREAM_ALIGNMENT>>;
+
+    // SoA vertex influences, same padding rules as the math streams: padding lanes have joint 0 and weight 0
+    struct skin_stream {
+        uint_array joints[SKIN_MAX_INFLUENCES];
+        float_array weights[SKIN_MAX_INFLUENCES];
+        uint32_t _count{ 0 };
+
+        uint32_t size() const { return _count; }
+        uint32_t padded_size() const { return (uint32_t) weights[0].size(); }
+
+        void resize(uint32_t count) {
+            _count = count;
+            for (uint32_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+                stream_resize(weights[k], count);
+                joints[k].resize(stream_padded_count(count));
+                std::fill(joints[k].begin() + count, joints[k].end(), 0);
+            }
+        }
+    };
+
+    // Unpack count packed skin params read every stride bytes.
+    // The 8 bits weights are renormalized to sum to 1, a vertex with no weight is bound to joint 0.
+    CORE_API void skin_unpack(const uint32_t* packedWeights, const uint32_t* packedJoints, uint32_t stride, uint32_t count, skin_stream& out);
+
+    // out[i] = sum_k weights[k][i] * transformFrom(skinMatrices[joints[k][i]], p[i])
+    // Split in blocks on the shared thread pool, the joint indices must be valid in skinMatrices.
+    CORE_API void stream_skin(const mat4x3* skinMatrices, const skin_stream& skin, const vec3_stream& p, vec3_stream& out);
+
+    // Bounds of the vertices influenced by each joint, in the joint space: boxes[b] bounds invBindMatrices[joints[b]] * p
+    // for the vertices with a weight on joints[b]. The joints without influence are skipped.
+    struct SkinJointBounds {
+        std::vector<uint32_t> joints;
+        std::vector<aabox3> boxes;
+    };
+    CORE_API void skin_buildJointBounds(const skin_stream& skin, const vec3_stream& p, const mat4x3* invBindMatrices, uint32_t numJoints, SkinJointBounds& bounds);
+
+    // Conservative bound of the skinned vertices from the joint bounds placed by the joint matrices
+    // (the skin matrices without the inverse bind matrices): a skinned vertex is a convex combination
+    // of points in the joint boxes. Cost is per joint, not per vertex.
+    CORE_API aabox3 skin_bound(const SkinJointBounds& bounds, const mat4x3* jointMatrices);
+}
@@ -0,0 +1,296 @@
+// VertexCache.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "VertexCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <random>
+
+#include "../Log.h"
+
+namespace core {
+
+    VertexCacheStats mesh_analyzeVertexCache(const uint32_t* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+        VertexCacheStats stats;
+        stats.numTriangles = numIndices / 3;
+
+        // A vertex is in the FIFO if it entered it less than cacheSize misses ago
+        std::vector<uint32_t> cacheTimes(numVertices, 0);
+        uint32_t timestamp = cacheSize + 1;
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            uint32_t v = indices[i];
+            if (cacheTimes[v] == 0) {
+                stats.numVertices++;
+            }
+            if (timestamp - cacheTimes[v] > cacheSize) {
+                cacheTimes[v] = timestamp++;
+                stats.numTransformed++;
+            }
+        }
+        return stats;
+    }
+
+    void mesh_optimizeVertexCache(uint32_t* destination, const uint32_t* indices, uint32_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+        const uint32_t numTriangles = numIndices / 3;
+        if (numTriangles == 0) {
+            return;
+        }
+
+        // Work from a copy when optimizing in place
+        std::vector<uint32_t> source;
+        if (destination == indices) {
+            source.assign(indices, indices + numIndices);
+            indices = source.data();
+        }
+
+        // Vertex -> triangles adjacency, live counts the triangles of the vertex not emitted yet
+        std::vector<uint32_t> live(numVertices, 0);
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            live[indices[i]]++;
+        }
+        std::vector<uint32_t> offsets(numVertices + 1, 0);
+        for (uint32_t v = 0; v < numVertices; ++v) {
+            offsets[v + 1] = offsets[v] + live[v];
+        }
+        std::vector<uint32_t> vertexTriangles(numIndices);
+        {
+            std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+            for (uint32_t i = 0; i < numIndices; ++i) {
+                vertexTriangles[cursors[indices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<uint32_t> cacheTimes(numVertices, 0);
+        std::vector<uint8_t> emitted(numTriangles, 0);
+        std::vector<uint32_t> deadEnds;   // recently referenced vertices, to restart from when the fanning runs dry
+        std::vector<uint32_t> candidates; // 1-ring of the current fanning vertex
+        deadEnds.reserve(numIndices);
+        candidates.reserve(64);
+
+        uint32_t timestamp = cacheSize + 1;
+        uint32_t cursor = 0; // input order scan, the last resort to find a live vertex
+        uint32_t numEmitted = 0;
+
+        auto nextLiveVertex = [&]() -> uint32_t {
+            while (!deadEnds.empty()) {
+                uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0) return v;
+            }
+            while (cursor < numVertices) {
+                if (live[cursor] > 0) return cursor;
+                ++cursor;
+            }
+            return VERTEX_CACHE_INVALID_INDEX;
+        };
+
+        uint32_t fanning = nextLiveVertex();
+        while (fanning != VERTEX_CACHE_INVALID_INDEX) {
+            // Emit all the triangles around the fanning vertex
+            candidates.clear();
+            for (uint32_t o = offsets[fanning]; o < offsets[fanning + 1]; ++o) {
+                uint32_t t = vertexTriangles[o];
+                if (emitted[t]) {
+                    continue;
+                }
+                emitted[t] = 1;
+                for (uint32_t k = 0; k < 3; ++k) {
+                    uint32_t v = indices[3 * t + k];
+                    destination[3 * numEmitted + k] = v;
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (timestamp - cacheTimes[v] > cacheSize) {
+                        cacheTimes[v] = timestamp++;
+                    }
+                }
+                numEmitted++;
+            }
+
+            // Next fanning vertex: the oldest candidate still in cache once its remaining triangles are emitted
+            uint32_t best = VERTEX_CACHE_INVALID_INDEX;
+            int32_t bestPriority = -1;
+            for (auto v : candidates) {
+                if (live[v] == 0) {
+                    continue;
+                }
+                int32_t priority = 0;
+                uint32_t age = timestamp - cacheTimes[v];
+                if (age + 2 * live[v] <= cacheSize) {
+                    priority = int32_t(age);
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    best = v;
+                }
+            }
+            fanning = (best != VERTEX_CACHE_INVALID_INDEX ? best : nextLiveVertex());
+        }
+        assert(numEmitted == numTriangles);
+    }
+
+    uint32_t mesh_optimizeVertexFetchRemap(uint32_t* indices, uint32_t numIndices, uint32_t numVertices, std::vector<uint32_t>& remap) {
+        remap.assign(numVertices, VERTEX_CACHE_INVALID_INDEX);
+        uint32_t numRemapped = 0;
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            uint32_t& r = remap[indices[i]];
+            if (r == VERTEX_CACHE_INVALID_INDEX) {
+                r = numRemapped++;
+            }
+            indices[i] = r;
+        }
+        return numRemapped;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runMeshVertexCacheTests() to validate the vertex cache
+// and fetch optimizations, runMeshVertexCacheBenchmarks() for the timings
+// -------------------------------------------------------------------------
+
+namespace {
+    // Grid of w x h quads sharing (w+1) x (h+1) vertices, the triangles are shuffled
+    uint32_t makeShuffledGrid(uint32_t w, uint32_t h, std::vector<uint32_t>& indices) {
+        std::vector<uint32_t> triangles;
+        for (uint32_t y = 0; y < h; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                uint32_t v0 = y * (w + 1) + x;
+                uint32_t v1 = v0 + 1;
+                uint32_t v2 = v0 + (w + 1);
+                uint32_t v3 = v2 + 1;
+                uint32_t quad[6] = { v0, v1, v2, v2, v1, v3 };
+                for (auto q : quad) triangles.push_back(q);
+            }
+        }
+        std::vector<uint32_t> order(triangles.size() / 3);
+        for (uint32_t t = 0; t < order.size(); ++t) order[t] = t;
+        std::shuffle(order.begin(), order.end(), std::mt19937(7));
+        indices.clear();
+        for (auto t : order) {
+            for (uint32_t k = 0; k < 3; ++k) indices.push_back(triangles[3 * t + k]);
+        }
+        return (w + 1) * (h + 1);
+    }
+
+    // Triangles as sorted triplets starting at their smallest index, to compare meshes up to the triangle order
+    std::vector<uint64_t> canonicalTriangles(const std::vector<uint32_t>& indices) {
+        std::vector<uint64_t> triangles;
+        for (uint32_t t = 0; t < indices.size() / 3; ++t) {
+            uint32_t i0 = indices[3 * t], i1 = indices[3 * t + 1], i2 = indices[3 * t + 2];
+            while (i0 > i1 || i0 > i2) { std::swap(i0, i1); std::swap(i1, i2); } // rotate, keeps the winding
+            triangles.push_back((uint64_t(i0) << 42) | (uint64_t(i1) << 21) | uint64_t(i2));
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+void runMeshVertexCacheTests() {
+    using namespace core;
+    picoLog("MeshVertexCacheTest: starting...");
+
+    std::vector<uint32_t> indices;
+    uint32_t numVertices = makeShuffledGrid(64, 64, indices);
+    uint32_t numIndices = (uint32_t) indices.size();
+
+    // --- Test 1: analysis of a known stream ---
+    {
+        std::vector<uint32_t> fan = { 0, 1, 2,  0, 2, 3 };
+        auto stats = mesh_analyzeVertexCache(fan.data(), 6, 4, 16);
+        assert(stats.numTriangles == 2 && stats.numVertices == 4 && stats.numTransformed == 4);
+        stats = mesh_analyzeVertexCache(fan.data(), 6, 4, 2);
+        assert(stats.numTransformed == 5); // vertex 0 is evicted by 1 and 2 before the second triangle
+        picoLog("MeshVertexCacheTest 1 passed: FIFO simulation");
+    }
+
+    // --- Test 2: the optimized order is the same set of triangles with a much lower ACMR ---
+    {
+        std::vector<uint32_t> optimized(numIndices);
+        mesh_optimizeVertexCache(optimized.data(), indices.data(), numIndices, numVertices);
+        assert(canonicalTriangles(optimized) == canonicalTriangles(indices));
+
+        auto before = mesh_analyzeVertexCache(indices.data(), numIndices, numVertices);
+        auto after = mesh_analyzeVertexCache(optimized.data(), numIndices, numVertices);
+        picoLogf("MeshVertexCacheTest: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", before.acmr(), after.acmr(), before.atvr(), after.atvr());
+        assert(after.acmr() < 0.75f && after.acmr() < 0.5f * before.acmr());
+
+        // in place gives the same result
+        std::vector<uint32_t> inPlace = indices;
+        mesh_optimizeVertexCache(inPlace.data(), inPlace.data(), numIndices, numVertices);
+        assert(inPlace == optimized);
+        picoLog("MeshVertexCacheTest 2 passed: vertex cache order");
+    }
+
+    // --- Test 3: the fetch remap numbers vertices in first reference order ---
+    {
+        std::vector<uint32_t> remapped = indices;
+        std::vector<uint32_t> remap;
+        uint32_t numRemapped = mesh_optimizeVertexFetchRemap(remapped.data(), numIndices, numVertices + 5, remap);
+        assert(numRemapped == numVertices);
+        assert(remap[numVertices] == VERTEX_CACHE_INVALID_INDEX);
+        uint32_t next = 0;
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            assert(remapped[i] <= next);
+            if (remapped[i] == next) next++;
+        }
+
+        std::vector<uint32_t> vertexIds(numVertices + 5);
+        for (uint32_t v = 0; v < vertexIds.size(); ++v) vertexIds[v] = v;
+        mesh_remapVertices(vertexIds, remap, numRemapped);
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            assert(vertexIds[remapped[i]] == indices[i]);
+        }
+        picoLog("MeshVertexCacheTest 3 passed: vertex fetch order");
+    }
+
+    picoLog("MeshVertexCacheTest: all tests passed");
+}
+
+void runMeshVertexCacheBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<uint32_t> indices;
+    uint32_t numVertices = makeShuffledGrid(768, 768, indices);
+    uint32_t numIndices = (uint32_t) indices.size();
+
+    auto start = clock::now();
+    std::vector<uint32_t> optimized(numIndices);
+    mesh_optimizeVertexCache(optimized.data(), indices.data(), numIndices, numVertices);
+    double cacheMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    std::vector<uint32_t> remap;
+    mesh_optimizeVertexFetchRemap(optimized.data(), numIndices, numVertices, remap);
+    double fetchMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    auto before = mesh_analyzeVertexCache(indices.data(), numIndices, numVertices);
+    auto after = mesh_analyzeVertexCache(optimized.data(), numIndices, numVertices);
+    picoLogf("MeshVertexCacheBench {} triangles: cache order {:.2f} ms, fetch remap {:.2f} ms | ACMR {:.3f} -> {:.3f} | ATVR {:.3f} -> {:.3f}",
+        numIndices / 3, cacheMs, fetchMs, before.acmr(), after.acmr(), before.atvr(), after.atvr());
+}
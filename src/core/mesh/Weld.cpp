@@ -0,0 +1,156 @@
+// Weld.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Weld.h"
+
+#include <cassert>
+#include <chrono>
+#include <unordered_map>
+
+#include "../Log.h"
+#include "../stl/Hash.h"
+
+// -------------------------------------------------------------------------
+// Simple test — call runMeshWeldTests() to validate the vertex welding
+// and runMeshWeldBenchmarks() to compare it with a node based hash map weld
+// -------------------------------------------------------------------------
+
+namespace {
+    struct TestVertex {
+        float px, py, pz;
+        uint32_t n;
+        float u, v;
+        uint32_t sw, sj;
+    };
+
+    // Worst possible hash, every vertex lands in the same bucket
+    struct CollidingHash {
+        uint64_t operator()(const TestVertex&) const { return 0; }
+    };
+
+    // Grid of (w+1) x (h+1) vertices, triangles referencing duplicated copies of the corners
+    void makeGrid(uint32_t w, uint32_t h, std::vector<TestVertex>& vertices, std::vector<uint32_t>& indices) {
+        vertices.clear();
+        indices.clear();
+        for (uint32_t y = 0; y < h; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                uint32_t base = (uint32_t) vertices.size();
+                for (uint32_t c = 0; c < 4; ++c) {
+                    float fx = float(x + (c & 1));
+                    float fy = float(y + (c >> 1));
+                    vertices.push_back({ fx, fy, 0.0f, 0x7FFF0000u, fx / float(w), fy / float(h), 0, 0 });
+                }
+                uint32_t quad[6] = { 0, 1, 2, 2, 1, 3 };
+                for (auto q : quad) indices.push_back(base + q);
+            }
+        }
+    }
+}
+
+void runMeshWeldTests() {
+    using namespace core;
+    picoLog("MeshWeldTest: starting...");
+
+    // --- Test 1: grid corners are merged, order of first reference is kept ---
+    {
+        std::vector<TestVertex> vertices;
+        std::vector<uint32_t> indices;
+        makeGrid(4, 3, vertices, indices);
+
+        WeldResult result;
+        weld(vertices.data(), (uint32_t) vertices.size(), indices.data(), (uint32_t) indices.size(), result);
+        assert(result.vertices.size() == 5 * 4);
+        assert(result.indices.size() == indices.size());
+        for (uint32_t i = 0; i < indices.size(); ++i) {
+            assert(memcmp(&vertices[result.vertices[result.indices[i]]], &vertices[indices[i]], sizeof(TestVertex)) == 0);
+        }
+        assert(result.vertices[0] == indices[0] && result.indices[0] == 0);
+        picoLog("MeshWeldTest 1 passed: grid welded to (w+1)x(h+1) vertices");
+    }
+
+    // --- Test 2: hash collisions never merge different vertices ---
+    {
+        std::vector<TestVertex> vertices;
+        std::vector<uint32_t> indices;
+        makeGrid(3, 3, vertices, indices);
+        vertices[indices[4]].u += 0.5f; // an attribute seam, same position different uv
+
+        WeldResult ref, colliding;
+        weld(vertices.data(), (uint32_t) vertices.size(), indices.data(), (uint32_t) indices.size(), ref);
+        weld<TestVertex, CollidingHash>(vertices.data(), (uint32_t) vertices.size(), indices.data(), (uint32_t) indices.size(), colliding);
+        assert(ref.vertices.size() == 4 * 4 + 1);
+        assert(ref.indices == colliding.indices && ref.vertices == colliding.vertices);
+        picoLog("MeshWeldTest 2 passed: colliding hashes keep distinct vertices apart");
+    }
+
+    // --- Test 3: weld a vertex array without index stream ---
+    {
+        std::vector<TestVertex> vertices;
+        std::vector<uint32_t> indices;
+        makeGrid(2, 2, vertices, indices);
+
+        WeldResult result;
+        weld(vertices.data(), (uint32_t) vertices.size(), result);
+        assert(result.vertices.size() == 3 * 3);
+        assert(result.indices.size() == vertices.size());
+        picoLog("MeshWeldTest 3 passed: vertex array welded");
+    }
+
+    picoLog("MeshWeldTest: all tests passed");
+}
+
+void runMeshWeldBenchmarks() {
+    using namespace core;
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<TestVertex> vertices;
+    std::vector<uint32_t> indices;
+    makeGrid(512, 512, vertices, indices);
+
+    // The previous ModelDrawFactory weld: node based map keyed by the hash only
+    auto start = clock::now();
+    std::unordered_map<size_t, uint32_t> map;
+    std::vector<uint32_t> mapIndices(indices.size());
+    uint32_t numMapVertices = 0;
+    for (uint32_t i = 0; i < indices.size(); ++i) {
+        const auto& v = vertices[indices[i]];
+        auto k = core::hash<float, float, float, uint32_t, float, float>{}(v.px, v.py, v.pz, v.n, v.u, v.v);
+        auto it = map.find(k);
+        if (it == map.end()) {
+            it = map.insert({ k, numMapVertices++ }).first;
+        }
+        mapIndices[i] = it->second;
+    }
+    double mapMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    WeldResult result;
+    weld(vertices.data(), (uint32_t) vertices.size(), indices.data(), (uint32_t) indices.size(), result);
+    double weldMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    picoLogf("MeshWeldBench {} indices: unordered_map {:.2f} ms ({} vertices) | weld {:.2f} ms ({} vertices) | x{:.2f}",
+        indices.size(), mapMs, numMapVertices, weldMs, result.vertices.size(), mapMs / weldMs);
+}
@@ -0,0 +1,159 @@
+// Weld.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../dllmain.h"
+
+namespace core {
+
+    // Vertex welding: collapse the bitwise identical vertices referenced by an index stream.
+    // The vertex type V is compared as raw bytes, it must be trivially copyable and free of padding.
+
+    static const uint32_t WELD_INVALID_INDEX = 0xFFFFFFFF;
+
+    // Hash the bytes of a vertex, 32 bits words at a time
+    template <typename V>
+    struct weld_hash {
+        static_assert(sizeof(V) % sizeof(uint32_t) == 0, "weld_hash expects a vertex made of 32 bits words");
+
+        inline uint64_t operator()(const V& v) const {
+            uint32_t words[sizeof(V) / sizeof(uint32_t)];
+            memcpy(words, &v, sizeof(V));
+            uint64_t h = 0x9E3779B97F4A7C15ull;
+            for (auto w : words) {
+                h ^= w;
+                h *= 0xFF51AFD7ED558CCDull;
+                h ^= h >> 32;
+            }
+            return h;
+        }
+    };
+
+    // Open addressing table (linear probing) of indices into an external vertex array.
+    // Slots only store the vertex index, a hit is confirmed by comparing the full vertex
+    // so two different vertices sharing a hash are never merged.
+    template <typename V, typename H = weld_hash<V>>
+    class WeldTable {
+    public:
+        static_assert(std::is_trivially_copyable_v<V>, "WeldTable vertex type must be trivially copyable");
+
+        // Prepare the table for up to maxVertices unique vertices
+        void reset(uint32_t maxVertices) {
+            uint32_t capacity = 16;
+            while (capacity < 2 * maxVertices) capacity <<= 1; // keep the load factor under 0.5
+            _mask = capacity - 1;
+            _slots.assign(capacity, WELD_INVALID_INDEX);
+        }
+
+        // Look for v in the table, if not found record it as vertex index 'candidate' of 'vertices'.
+        // Returns the index of the vertex equal to v.
+        inline uint32_t findOrInsert(const V& v, const V* vertices, uint32_t candidate) {
+            uint32_t slot = uint32_t(_hasher(v)) & _mask;
+            while (true) {
+                uint32_t index = _slots[slot];
+                if (index == WELD_INVALID_INDEX) {
+                    _slots[slot] = candidate;
+                    return candidate;
+                }
+                if (memcmp(vertices + index, &v, sizeof(V)) == 0) {
+                    return index;
+                }
+                slot = (slot + 1) & _mask;
+            }
+        }
+
+    private:
+        std::vector<uint32_t> _slots;
+        uint32_t _mask{ 0 };
+        H _hasher;
+    };
+
+    struct WeldResult {
+        std::vector<uint32_t> indices;  // the welded index stream, same length as the source index stream
+        std::vector<uint32_t> vertices; // unique vertex -> source vertex index, in order of first reference
+    };
+
+    // Weld the vertices referenced by the index stream.
+    // Unique vertices are numbered in order of first appearance in the index stream,
+    // unreferenced source vertices are dropped.
+    template <typename V, typename H = weld_hash<V>>
+    void weld(const V* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices, WeldResult& result) {
+        result.indices.resize(numIndices);
+        result.vertices.clear();
+
+        // source vertex -> unique vertex, spares the hash lookup for the vertices shared by several triangles
+        std::vector<uint32_t> remap(numVertices, WELD_INVALID_INDEX);
+        std::vector<V> uniques;
+        uniques.reserve(numVertices);
+
+        WeldTable<V, H> table;
+        table.reset(numVertices);
+
+        for (uint32_t i = 0; i < numIndices; ++i) {
+            uint32_t src = indices[i];
+            uint32_t u = remap[src];
+            if (u == WELD_INVALID_INDEX) {
+                const V& v = vertices[src];
+                uint32_t candidate = (uint32_t) uniques.size();
+                u = table.findOrInsert(v, uniques.data(), candidate);
+                if (u == candidate) {
+                    uniques.emplace_back(v);
+                    result.vertices.emplace_back(src);
+                }
+                remap[src] = u;
+            }
+            result.indices[i] = u;
+        }
+    }
+
+    // Weld the whole vertex array, result.indices maps each source vertex to its unique vertex
+    template <typename V, typename H = weld_hash<V>>
+    void weld(const V* vertices, uint32_t numVertices, WeldResult& result) {
+        result.indices.resize(numVertices);
+        result.vertices.clear();
+
+        WeldTable<V, H> table;
+        table.reset(numVertices);
+
+        std::vector<V> uniques;
+        uniques.reserve(numVertices);
+        for (uint32_t i = 0; i < numVertices; ++i) {
+            uint32_t candidate = (uint32_t) uniques.size();
+            uint32_t u = table.findOrInsert(vertices[i], uniques.data(), candidate);
+            if (u == candidate) {
+                uniques.emplace_back(vertices[i]);
+                result.vertices.emplace_back(i);
+            }
+            result.indices[i] = u;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+// RadixSort.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RadixSort.h"
+
+#include <array>
+#include <algorithm>
+
+#include "../Job.h"
+
+namespace core {
+
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, uint32_t keyBits) {
+        constexpr uint32_t DIGIT_BITS = 8;
+        constexpr uint32_t NUM_BUCKETS = 1 << DIGIT_BITS;
+        constexpr uint32_t BLOCK_SIZE = 1 << 16; // below this a single block, the threading cost is not worth it
+
+        const uint32_t count = (uint32_t) keys.size();
+        if (count < 2) {
+            return;
+        }
+
+        auto& pool = ThreadPool::shared();
+        const uint32_t numBlocks = std::max(1u, std::min((count + BLOCK_SIZE - 1) / BLOCK_SIZE, pool.threadCount() + 1));
+        const uint32_t blockSize = (count + numBlocks - 1) / numBlocks;
+
+        std::vector<uint64_t> tempKeys(count);
+        std::vector<uint32_t> tempValues(count);
+        std::vector<std::array<uint32_t, NUM_BUCKETS>> histograms(numBlocks);
+
+        uint64_t* srcKeys = keys.data();
+        uint32_t* srcValues = values.data();
+        uint64_t* dstKeys = tempKeys.data();
+        uint32_t* dstValues = tempValues.data();
+
+        const uint32_t numPasses = (std::min(keyBits, 64u) + DIGIT_BITS - 1) / DIGIT_BITS;
+        for (uint32_t pass = 0; pass < numPasses; ++pass) {
+            const uint32_t shift = pass * DIGIT_BITS;
+
+            // Count the digits of each block
+            pool.parallel_for(numBlocks, 1, [&](uint32_t blockBegin, uint32_t blockEnd) {
+                for (uint32_t b = blockBegin; b < blockEnd; ++b) {
+                    auto& h = histograms[b];
+                    h.fill(0);
+                    const uint32_t end = std::min(count, (b + 1) * blockSize);
+                    for (uint32_t i = b * blockSize; i < end; ++i) {
+                        h[(srcKeys[i] >> shift) & (NUM_BUCKETS - 1)]++;
+                    }
+                }
+            });
+
+            // Exclusive scan digit major then block major, block b writes a digit after the blocks before it: stable
+            uint32_t offset = 0;
+            bool skip = false;
+            for (uint32_t d = 0; d < NUM_BUCKETS; ++d) {
+                uint32_t digitCount = 0;
+                for (uint32_t b = 0; b < numBlocks; ++b) {
+                    uint32_t c = histograms[b][d];
+                    histograms[b][d] = offset;
+                    offset += c;
+                    digitCount += c;
+                }
+                if (digitCount == count) {
+                    skip = true; // every key has the same digit, the pass would be a copy
+                    break;
+                }
+            }
+            if (skip) {
+                continue;
+            }
+
+            // Scatter each block to its offsets
+            pool.parallel_for(numBlocks, 1, [&](uint32_t blockBegin, uint32_t blockEnd) {
+                for (uint32_t b = blockBegin; b < blockEnd; ++b) {
+                    auto& h = histograms[b];
+                    const uint32_t end = std::min(count, (b + 1) * blockSize);
+                    for (uint32_t i = b * blockSize; i < end; ++i) {
+                        uint32_t dst = h[(srcKeys[i] >> shift) & (NUM_BUCKETS - 1)]++;
+                        dstKeys[dst] = srcKeys[i];
+                        dstValues[dst] = srcValues[i];
+                    }
+                }
+            });
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcValues, dstValues);
+        }
+
+        // Odd number of effective passes, the sorted result lives in the temporaries
+        if (srcKeys != keys.data()) {
+            keys.swap(tempKeys);
+            values.swap(tempValues);
+        }
+    }
+}
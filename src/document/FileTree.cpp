@@ -0,0 +1,423 @@
+// FileTree.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "FileTree.h"
+
+#include <filesystem>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <core/Log.h>
+#include <core/Job.h>
+
+namespace fs = std::filesystem;
+
+namespace document
+{
+    namespace {
+        struct ScanFolder {
+            std::string path;
+            ScanFolder* parent{ nullptr };
+            FileTree::Entries files;
+            std::vector<ScanFolder*> folders;   // in listing order
+            std::atomic<int64_t> size{ 0 };     // files of the folder, then the sub folders as they complete
+            std::atomic<int32_t> pending{ 0 };  // sub folders not complete yet, + 1 while the folder itself is listed
+        };
+
+        // Folders to list, the owner pops from the back (depth first, stays local), thieves steal from the front (big subtrees)
+        struct ScanQueue {
+            std::mutex mutex;
+            std::deque<ScanFolder*> folders;
+        };
+
+        void listFileSystemFolder(const std::string& path, FileTree::Entries& entries) {
+            std::error_code ec;
+            for (fs::directory_iterator it(path, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+                const auto& entry = *it;
+                std::error_code entryEc;
+                if (entry.is_symlink(entryEc)) {
+                    continue;
+                }
+                if (entry.is_directory(entryEc)) {
+                    entries.push_back({ entry.path().generic_string(), 0, true });
+                } else if (entry.is_regular_file(entryEc)) {
+                    auto size = entry.file_size(entryEc);
+                    entries.push_back({ entry.path().generic_string(), (entryEc ? 0 : int64_t(size)), false });
+                }
+            }
+            if (ec) {
+                picoLogf("FileTree: failed to list {}: {}", path, ec.message());
+            }
+        }
+
+        // The folder and its ancestors whose last pending sub folder it was are complete,
+        // their sizes go up the tree
+        void completeFolder(ScanFolder* folder) {
+            while (folder && folder->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (folder->parent) {
+                    folder->parent->size.fetch_add(folder->size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                folder = folder->parent;
+            }
+        }
+    }
+
+    FileTreePointer FileTree::scan(const std::string& rootPath) {
+        std::error_code ec;
+        if (!fs::is_directory(rootPath, ec)) {
+            picoLogf("FileTree: {} is not a folder", rootPath);
+            return nullptr;
+        }
+        return scan(rootPath, listFileSystemFolder);
+    }
+
+    FileTreePointer FileTree::scan(const std::string& rootPath, const ListFolder& listFolder) {
+        auto& pool = core::ThreadPool::shared();
+        const uint32_t numWorkers = pool.threadCount() + 1;
+
+        // Folders are allocated in the storage of the worker listing their parent, deque keeps them in place
+        std::vector<std::deque<ScanFolder>> storages(numWorkers);
+        std::unique_ptr<ScanQueue[]> queues(new ScanQueue[numWorkers]);
+        std::atomic<int64_t> numQueued{ 1 };
+
+        ScanFolder& root = storages[0].emplace_back();
+        root.path = rootPath;
+        queues[0].folders.push_back(&root);
+
+        auto popFolder = [&](uint32_t worker) -> ScanFolder* {
+            {
+                std::lock_guard<std::mutex> lock(queues[worker].mutex);
+                auto& own = queues[worker].folders;
+                if (!own.empty()) {
+                    auto folder = own.back();
+                    own.pop_back();
+                    return folder;
+                }
+            }
+            for (uint32_t i = 1; i < numWorkers; ++i) {
+                auto& victim = queues[(worker + i) % numWorkers];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.folders.empty()) {
+                    auto folder = victim.folders.front();
+                    victim.folders.pop_front();
+                    return folder;
+                }
+            }
+            return nullptr;
+        };
+
+        pool.parallel_for(numWorkers, 1, [&](uint32_t begin, uint32_t end) {
+            Entries entries;
+            for (uint32_t worker = begin; worker < end; ++worker) {
+                auto& storage = storages[worker];
+                while (true) {
+                    ScanFolder* folder = popFolder(worker);
+                    if (!folder) {
+                        if (numQueued.load(std::memory_order_acquire) == 0) break;
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    entries.clear();
+                    listFolder(folder->path, entries);
+
+                    int64_t filesSize = 0;
+                    for (auto& entry : entries) {
+                        if (entry.isFolder) {
+                            ScanFolder& sub = storage.emplace_back();
+                            sub.path = std::move(entry.path);
+                            sub.parent = folder;
+                            folder->folders.push_back(&sub);
+                        } else {
+                            filesSize += entry.size;
+                            folder->files.push_back(std::move(entry));
+                        }
+                    }
+                    folder->size.fetch_add(filesSize, std::memory_order_relaxed);
+                    folder->pending.store(int32_t(folder->folders.size()) + 1, std::memory_order_relaxed);
+
+                    if (!folder->folders.empty()) {
+                        numQueued.fetch_add(int64_t(folder->folders.size()), std::memory_order_relaxed);
+                        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+                        // pushed in reverse so the owner pops them in listing order
+                        queues[worker].folders.insert(queues[worker].folders.end(), folder->folders.rbegin(), folder->folders.rend());
+                    }
+                    completeFolder(folder);
+                    numQueued.fetch_sub(1, std::memory_order_acq_rel);
+                }
+            }
+        });
+
+        // Flatten breadth first, the children of a folder are its files then its sub folders
+        auto tree = std::make_shared<FileTree>();
+        auto& nodes = tree->_nodes;
+        std::vector<ScanFolder*> nodeFolders;
+        std::vector<uint32_t> nodeDepths;
+        size_t numNodes = 1;
+        for (const auto& storage : storages) {
+            for (const auto& f : storage) numNodes += f.files.size() + f.folders.size();
+        }
+        nodes.reserve(numNodes);
+        nodeFolders.reserve(numNodes);
+        nodeDepths.reserve(numNodes);
+
+        nodes.push_back({ rootPath, root.size.load() });
+        nodeFolders.push_back(&root);
+        nodeDepths.push_back(0);
+        tree->_levelOffsets = { 0 };
+        for (int32_t n = 0; n < (int32_t) nodes.size(); ++n) {
+            if (n > 0 && nodeDepths[n] != nodeDepths[n - 1]) {
+                tree->_levelOffsets.push_back(n);
+            }
+            ScanFolder* folder = nodeFolders[n];
+            if (!folder || (folder->files.empty() && folder->folders.empty())) {
+                continue;
+            }
+            int32_t childBegin = (int32_t) nodes.size();
+            for (auto& file : folder->files) {
+                nodes.push_back({ std::move(file.path), file.size, n });
+                nodeFolders.push_back(nullptr);
+                nodeDepths.push_back(nodeDepths[n] + 1);
+            }
+            for (auto sub : folder->folders) {
+                nodes.push_back({ std::move(sub->path), sub->size.load(), n });
+                nodeFolders.push_back(sub);
+                nodeDepths.push_back(nodeDepths[n] + 1);
+            }
+            int32_t childEnd = (int32_t) nodes.size() - 1;
+            nodes[n].childBegin = childBegin;
+            nodes[n].childEnd = childEnd;
+            for (int32_t c = childBegin; c < childEnd; ++c) {
+                nodes[c].sybling = c + 1;
+            }
+        }
+        tree->_levelOffsets.push_back((uint32_t) nodes.size());
+        return tree;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runFileTreeTests() to validate the parallel scan against
+// a serial walk and runFileTreeBenchmarks() to time the scan of a 1M entries tree
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <set>
+
+using namespace document;
+
+namespace {
+    // The single threaded walk pico_treemap used before the FileTree, sizes summed up the traversal path
+    struct ReferenceNode {
+        std::string path;
+        int64_t size{ 0 };
+        int32_t parent{ -1 };
+        bool isFolder{ false };
+    };
+
+    std::vector<ReferenceNode> scanReference(const std::string& rootPath) {
+        std::vector<ReferenceNode> tree;
+        std::vector<std::pair<std::string, int32_t>> queue = { { rootPath, -1 } };
+        while (!queue.empty()) {
+            auto [path, parent] = queue.back();
+            queue.pop_back();
+            int32_t id = (int32_t) tree.size();
+            tree.push_back({ path, 0, parent, true });
+
+            std::vector<std::string> subfolders;
+            int64_t filesSize = 0;
+            for (const auto& entry : fs::directory_iterator(path)) {
+                if (entry.is_directory()) {
+                    subfolders.emplace_back(entry.path().generic_string());
+                } else if (entry.is_regular_file()) {
+                    tree.push_back({ entry.path().generic_string(), int64_t(entry.file_size()), id, false });
+                    filesSize += entry.file_size();
+                }
+            }
+            for (int32_t p = id; p >= 0; p = tree[p].parent) {
+                tree[p].size += filesSize;
+            }
+            for (auto it = subfolders.rbegin(); it != subfolders.rend(); ++it) {
+                queue.push_back({ *it, id });
+            }
+        }
+        return tree;
+    }
+
+    // Folder tree on disk: numFolders sub folders per folder down to depth, numFiles files per folder
+    uint64_t createTestFolder(const fs::path& path, uint32_t depth, uint32_t numFolders, uint32_t numFiles, uint64_t& numEntries) {
+        fs::create_directories(path);
+        uint64_t size = 0;
+        for (uint32_t f = 0; f < numFiles; ++f) {
+            uint32_t fileSize = (uint32_t(path.string().size()) * 131 + f * 977) % 2000;
+            std::ofstream file(path / ("file" + std::to_string(f) + ".bin"), std::ios::binary);
+            std::string content(fileSize, 'p');
+            file.write(content.data(), content.size());
+            size += fileSize;
+            ++numEntries;
+        }
+        if (depth > 0) {
+            for (uint32_t d = 0; d < numFolders; ++d) {
+                size += createTestFolder(path / ("folder" + std::to_string(d)), depth - 1, numFolders, numFiles, numEntries);
+                ++numEntries;
+            }
+        }
+        return size;
+    }
+
+    // Synthetic tree listed from the path alone: 8 sub folders per folder down to depth 5, ~26 files per folder,
+    // 37449 folders and about 1M entries
+    uint64_t syntheticHash(const std::string& s) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : s) { h ^= uint8_t(c); h *= 0x100000001b3ull; }
+        return h;
+    }
+
+    void listSyntheticFolder(const std::string& path, FileTree::Entries& entries) {
+        uint32_t depth = (uint32_t) std::count(path.begin(), path.end(), '/');
+        uint64_t h = syntheticHash(path);
+        uint32_t numFiles = 18 + uint32_t(h % 17);
+        for (uint32_t f = 0; f < numFiles; ++f) {
+            entries.push_back({ path + "/f" + std::to_string(f), int64_t((h >> (f % 48)) % 100000) + 1, false });
+        }
+        if (depth < 5) {
+            for (uint32_t d = 0; d < 8; ++d) {
+                entries.push_back({ path + "/" + std::to_string(d), 0, true });
+            }
+        }
+    }
+
+    void checkTree(const FileTree& tree) {
+        const auto& nodes = tree._nodes;
+        assert(tree._levelOffsets.front() == 0 && tree._levelOffsets.back() == nodes.size());
+        for (uint32_t level = 0; level < tree.numLevels(); ++level) {
+            for (uint32_t n = tree._levelOffsets[level]; n < tree._levelOffsets[level + 1]; ++n) {
+                assert(nodes[n].parent < 0 || (uint32_t(nodes[n].parent) >= tree._levelOffsets[level - 1] && uint32_t(nodes[n].parent) < tree._levelOffsets[level]));
+            }
+        }
+        for (int32_t n = 0; n < (int32_t) nodes.size(); ++n) {
+            const auto& node = nodes[n];
+            if (node.childBegin < 0) continue;
+            int64_t sum = 0;
+            for (int32_t c = node.childBegin; c <= node.childEnd; ++c) {
+                assert(nodes[c].parent == n && c > n);
+                assert(nodes[c].sybling == (c < node.childEnd ? c + 1 : -1));
+                sum += nodes[c].size;
+            }
+            assert(sum == node.size);
+        }
+    }
+}
+
+void runFileTreeTests() {
+    picoLog("FileTreeTest: starting...");
+
+    // --- Test 1: a folder on disk, same entries and sizes as the serial walk ---
+    {
+        fs::path root = fs::temp_directory_path() / "pico_filetree_test";
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        uint64_t numEntries = 0;
+        uint64_t totalSize = createTestFolder(root, 3, 3, 4, numEntries);
+
+        auto tree = FileTree::scan(root.generic_string());
+        assert(tree);
+        checkTree(*tree);
+        assert(tree->numNodes() == numEntries + 1);
+        assert(tree->_nodes[0].size == int64_t(totalSize));
+        assert(tree->numLevels() == 5);
+
+        auto reference = scanReference(root.generic_string());
+        assert(reference.size() == tree->numNodes());
+        std::set<std::pair<std::string, int64_t>> scanned, expected;
+        for (const auto& n : tree->_nodes) scanned.insert({ n.path, n.size });
+        for (const auto& n : reference) expected.insert({ n.path, n.size });
+        assert(scanned == expected);
+
+        fs::remove_all(root, ec);
+        assert(!FileTree::scan(root.generic_string()));
+    }
+    picoLog("FileTreeTest 1 passed: filesystem scan matches the serial walk");
+
+    // --- Test 2: the synthetic tree scans to the same nodes every time ---
+    {
+        auto listSmall = [](const std::string& path, FileTree::Entries& entries) {
+            listSyntheticFolder(path, entries);
+            if (std::count(path.begin(), path.end(), '/') >= 3) {
+                std::erase_if(entries, [](const FileTree::Entry& e) { return e.isFolder; });
+            }
+        };
+        auto a = FileTree::scan("root", listSmall);
+        auto b = FileTree::scan("root", listSmall);
+        checkTree(*a);
+        assert(a->numNodes() == b->numNodes() && a->_levelOffsets == b->_levelOffsets);
+        for (uint32_t n = 0; n < a->numNodes(); ++n) {
+            assert(a->_nodes[n].path == b->_nodes[n].path && a->_nodes[n].size == b->_nodes[n].size);
+        }
+        assert(a->numLevels() == 5 && a->_levelOffsets[4] - a->_levelOffsets[3] > 0);
+    }
+    picoLog("FileTreeTest 2 passed: deterministic parallel scan");
+
+    picoLog("FileTreeTest: all tests passed");
+}
+
+void runFileTreeBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+
+    // Synthetic listing, measures the traversal, the size accumulation and the flattening
+    {
+        auto start = clock::now();
+        auto tree = FileTree::scan("root", listSyntheticFolder);
+        double scanMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        picoLogf("FileTreeBench synthetic {} entries, {} levels: scan {:.1f} ms on {} workers",
+            tree->numNodes(), tree->numLevels(), scanMs, core::ThreadPool::shared().threadCount() + 1);
+    }
+
+    // Filesystem, the serial walk against the parallel scan
+    {
+        fs::path root = fs::temp_directory_path() / "pico_filetree_bench";
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        uint64_t numEntries = 0;
+        createTestFolder(root, 4, 5, 12, numEntries);
+
+        auto start = clock::now();
+        auto reference = scanReference(root.generic_string());
+        double referenceMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        auto tree = FileTree::scan(root.generic_string());
+        double scanMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        picoLogf("FileTreeBench filesystem {} entries: serial walk {:.1f} ms | parallel scan {:.1f} ms | x{:.2f}",
+            tree->numNodes(), referenceMs, scanMs, referenceMs / scanMs);
+        fs::remove_all(root, ec);
+    }
+}
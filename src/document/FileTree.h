@@ -0,0 +1,84 @@
+// FileTree.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <document/dllmain.h>
+
+namespace document
+{
+    class FileTree;
+    using FileTreePointer = std::shared_ptr<FileTree>;
+
+    // The files and folders under a root folder, each folder with the accumulated size of its content.
+    // Nodes are in breadth first order: the root is node 0, the children of a folder are contiguous
+    // and stored after their parent, the files first then the sub folders, in listing order.
+    class DOCUMENT_API FileTree {
+    public:
+        struct Node {
+            std::string path;
+            int64_t size{ 0 };
+            int32_t parent{ -1 };
+            int32_t sybling{ -1 };
+            int32_t childBegin{ -1 };
+            int32_t childEnd{ -1 };   // last child, included
+        };
+        using Nodes = std::vector<Node>;
+
+        struct Entry {
+            std::string path;
+            int64_t size{ 0 };
+            bool isFolder{ false };
+        };
+        using Entries = std::vector<Entry>;
+
+        // List the content of a folder, appending to entries
+        using ListFolder = std::function<void(const std::string& path, Entries& entries)>;
+
+        // Scan the filesystem under rootPath, the symbolic links to folders are not followed
+        static FileTreePointer scan(const std::string& rootPath);
+
+        // Scan with a custom listing, the folders are listed in parallel on the shared ThreadPool:
+        // every worker pops the folders of its own queue and steals from the others when empty.
+        // Sizes are accumulated up the tree with atomics as the last sub folder of a folder completes.
+        // The result does not depend on the scheduling.
+        static FileTreePointer scan(const std::string& rootPath, const ListFolder& listFolder);
+
+        uint32_t numNodes() const { return (uint32_t) _nodes.size(); }
+        uint32_t numLevels() const { return (uint32_t) _levelOffsets.size() - 1; }
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+        Nodes _nodes;
+        std::vector<uint32_t> _levelOffsets; // nodes of depth d are in [_levelOffsets[d], _levelOffsets[d + 1])
+#pragma warning(pop)
+    };
+}
@@ -0,0 +1,501 @@
+// Heightmap.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Heightmap.h"
+
+#include <filesystem>
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+#include <core/Log.h>
+#include <core/Job.h>
+#include <core/MappedFile.h>
+
+namespace document
+{
+    namespace {
+        // USGS DEM layout: a record A of 1024 bytes then one record B per profile,
+        // each starting on a new block with a 144 bytes header followed by 6 chars elevations.
+        const uint32_t DEM_BLOCK_SIZE = 1024;
+        const uint32_t DEM_PROFILE_HEADER_SIZE = 144;
+        const uint32_t DEM_FIRST_BLOCK_NUM_VALUES = 146; // (1024 - 144 - 4) / 6
+        const uint32_t DEM_BLOCK_NUM_VALUES = 170;       // (1024 - 4) / 6
+        const int32_t DEM_VOID_ELEVATION = -32767;
+
+        const uint32_t HMAP_MAGIC = 0x504D4850; // "PHMP"
+        const uint32_t HMAP_VERSION = 1;
+
+        struct HeightmapFileHeader {
+            uint32_t magic{ HMAP_MAGIC };
+            uint32_t version{ HMAP_VERSION };
+            uint32_t width{ 0 };
+            uint32_t height{ 0 };
+            float spacing{ 1.0f };
+            float minHeight{ 0.0f };
+            float maxHeight{ 0.0f };
+            uint32_t tileSize{ Heightmap::TILE_SIZE };
+        };
+
+        // Right justified integer field
+        int32_t demInt(const char* c, uint32_t width) {
+            const char* end = c + width;
+            while (c < end && *c == ' ') ++c;
+            int32_t v = 0;
+            std::from_chars(c, end, v);
+            return v;
+        }
+
+        // Real field, the DEM writes the exponent with a 'D'
+        double demReal(const char* c, uint32_t width) {
+            char buffer[32];
+            uint32_t n = 0;
+            for (uint32_t i = 0; i < width && n < sizeof(buffer); ++i) {
+                char ch = c[i];
+                if (ch == ' ') continue;
+                buffer[n++] = (ch == 'D' || ch == 'd' ? 'E' : ch);
+            }
+            double v = 0.0;
+            std::from_chars(buffer, buffer + n, v);
+            return v;
+        }
+
+        uint32_t demProfileNumBlocks(uint32_t numValues) {
+            if (numValues <= DEM_FIRST_BLOCK_NUM_VALUES) {
+                return 1;
+            }
+            return 1 + (numValues - DEM_FIRST_BLOCK_NUM_VALUES + DEM_BLOCK_NUM_VALUES - 1) / DEM_BLOCK_NUM_VALUES;
+        }
+
+        struct DEMProfile {
+            const char* begin{ nullptr }; // first char of the elevations
+            const char* end{ nullptr };
+            uint32_t numValues{ 0 };
+            uint32_t firstRow{ 0 };
+            double northing{ 0.0 };
+            double datum{ 0.0 };
+        };
+    }
+
+    HeightmapPointer Heightmap::createFromDEM(const std::string& filename) {
+        core::MappedFile file;
+        if (!file.open(filename)) {
+            picoLog("DEM file " + filename + " can't be opened");
+            return nullptr;
+        }
+        const char* data = (const char*) file.data();
+        uint64_t size = file.size();
+        if (size < DEM_BLOCK_SIZE) {
+            picoLog("DEM file " + filename + " is too small");
+            return nullptr;
+        }
+
+        // Record A
+        auto elevationUnit = demInt(data + 534, 6);
+        auto yResolution = demReal(data + 828, 12);
+        auto zResolution = demReal(data + 840, 12);
+        auto numProfiles = (uint32_t) demInt(data + 858, 6);
+        float spacing = (float) demReal(data + 816, 12);
+        double elevationScale = (elevationUnit == 1 ? 0.3048 : 1.0); // feet or meters
+        if (numProfiles == 0 || yResolution <= 0.0) {
+            picoLog("DEM file " + filename + " has no profile");
+            return nullptr;
+        }
+
+        // Locate the profiles, the block count of a profile is given by its number of elevations
+        std::vector<DEMProfile> profiles;
+        profiles.reserve(numProfiles);
+        uint64_t offset = DEM_BLOCK_SIZE;
+        double minNorthing = std::numeric_limits<double>::max();
+        for (uint32_t p = 0; p < numProfiles && offset + DEM_PROFILE_HEADER_SIZE <= size; ++p) {
+            const char* record = data + offset;
+            DEMProfile profile;
+            profile.numValues = (uint32_t) demInt(record + 12, 6);
+            profile.northing = demReal(record + 48, 24);
+            profile.datum = demReal(record + 72, 24);
+            profile.begin = record + DEM_PROFILE_HEADER_SIZE;
+            offset += uint64_t(demProfileNumBlocks(profile.numValues)) * DEM_BLOCK_SIZE;
+            profile.end = data + std::min(offset, size);
+            minNorthing = std::min(minNorthing, profile.northing);
+            profiles.emplace_back(profile);
+        }
+        if (profiles.size() != numProfiles) {
+            picoLogf("DEM file {}: {} profiles found, {} expected", filename, profiles.size(), numProfiles);
+        }
+
+        // The profiles start at different northings, they become the rows of the heightmap
+        uint32_t width = 1;
+        for (auto& profile : profiles) {
+            profile.firstRow = (uint32_t) std::lround((profile.northing - minNorthing) / yResolution);
+            width = std::max(width, profile.firstRow + profile.numValues);
+        }
+        uint32_t height = (uint32_t) profiles.size();
+
+        std::vector<float> heights(uint64_t(width) * height, std::numeric_limits<float>::quiet_NaN());
+        core::ThreadPool::shared().parallel_for(height, 8, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t p = begin; p < end; ++p) {
+                const auto& profile = profiles[p];
+                float* row = heights.data() + uint64_t(p) * width + profile.firstRow;
+                const char* c = profile.begin;
+                for (uint32_t v = 0; v < profile.numValues; ++v) {
+                    while (c < profile.end && (*c == ' ' || *c == '\n' || *c == '\r')) ++c;
+                    int32_t elevation = DEM_VOID_ELEVATION;
+                    auto result = std::from_chars(c, profile.end, elevation);
+                    if (result.ec != std::errc()) {
+                        break;
+                    }
+                    c = result.ptr;
+                    if (elevation != DEM_VOID_ELEVATION) {
+                        row[v] = float((profile.datum + elevation * zResolution) * elevationScale);
+                    }
+                }
+            }
+        });
+
+        // Void and missing samples are set to the lowest elevation
+        float minHeight = std::numeric_limits<float>::max();
+        for (auto h : heights) {
+            if (!std::isnan(h)) minHeight = std::min(minHeight, h);
+        }
+        if (minHeight == std::numeric_limits<float>::max()) {
+            minHeight = 0.0f;
+        }
+        for (auto& h : heights) {
+            if (std::isnan(h)) h = minHeight;
+        }
+
+        auto heightmap = createFromHeights(width, height, spacing, heights.data());
+        heightmap->_name = std::filesystem::path(filename).stem().string();
+        return heightmap;
+    }
+
+    HeightmapPointer Heightmap::createFromHeights(uint32_t width, uint32_t height, float spacing, const float* heights) {
+        auto heightmap = std::make_shared<Heightmap>();
+        heightmap->_width = width;
+        heightmap->_height = height;
+        heightmap->_spacing = spacing;
+
+        uint32_t numTilesX = heightmap->numTilesX();
+        uint32_t numTilesY = heightmap->numTilesY();
+        heightmap->_tiles.resize(numTilesX * numTilesY);
+        heightmap->_samples.resize(uint64_t(numTilesX) * numTilesY * TILE_SIZE * TILE_SIZE, 0);
+
+        core::ThreadPool::shared().parallel_for(numTilesY, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t ty = begin; ty < end; ++ty) {
+                for (uint32_t tx = 0; tx < numTilesX; ++tx) {
+                    uint32_t x0 = tx * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, width);
+                    uint32_t y0 = ty * TILE_SIZE, y1 = std::min(y0 + TILE_SIZE, height);
+
+                    Tile tile{ std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+                    for (uint32_t y = y0; y < y1; ++y) {
+                        for (uint32_t x = x0; x < x1; ++x) {
+                            float h = heights[uint64_t(y) * width + x];
+                            tile.minHeight = std::min(tile.minHeight, h);
+                            tile.maxHeight = std::max(tile.maxHeight, h);
+                        }
+                    }
+
+                    uint32_t t = ty * numTilesX + tx;
+                    heightmap->_tiles[t] = tile;
+                    float range = tile.maxHeight - tile.minHeight;
+                    float scale = (range > 0.0f ? 65535.0f / range : 0.0f);
+                    uint16_t* samples = heightmap->_samples.data() + uint64_t(t) * TILE_SIZE * TILE_SIZE;
+                    for (uint32_t y = y0; y < y1; ++y) {
+                        for (uint32_t x = x0; x < x1; ++x) {
+                            float h = heights[uint64_t(y) * width + x];
+                            samples[(y - y0) * TILE_SIZE + (x - x0)] = (uint16_t) std::lround((h - tile.minHeight) * scale);
+                        }
+                    }
+                }
+            }
+        });
+
+        heightmap->_minHeight = std::numeric_limits<float>::max();
+        heightmap->_maxHeight = -std::numeric_limits<float>::max();
+        for (const auto& tile : heightmap->_tiles) {
+            heightmap->_minHeight = std::min(heightmap->_minHeight, tile.minHeight);
+            heightmap->_maxHeight = std::max(heightmap->_maxHeight, tile.maxHeight);
+        }
+        return heightmap;
+    }
+
+    HeightmapPointer Heightmap::createFromFile(const std::string& filename) {
+        core::MappedFile file;
+        if (!file.open(filename)) {
+            return nullptr;
+        }
+        HeightmapFileHeader header;
+        if (file.size() < sizeof(header)) {
+            return nullptr;
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        if (header.magic != HMAP_MAGIC || header.version != HMAP_VERSION || header.tileSize != TILE_SIZE) {
+            picoLog("heightmap file " + filename + " has an unknown format");
+            return nullptr;
+        }
+
+        auto heightmap = std::make_shared<Heightmap>();
+        heightmap->_width = header.width;
+        heightmap->_height = header.height;
+        heightmap->_spacing = header.spacing;
+        heightmap->_minHeight = header.minHeight;
+        heightmap->_maxHeight = header.maxHeight;
+
+        uint64_t numTiles = uint64_t(heightmap->numTilesX()) * heightmap->numTilesY();
+        uint64_t tilesSize = numTiles * sizeof(Tile);
+        uint64_t samplesSize = numTiles * TILE_SIZE * TILE_SIZE * sizeof(uint16_t);
+        if (file.size() != sizeof(header) + tilesSize + samplesSize) {
+            picoLog("heightmap file " + filename + " is truncated");
+            return nullptr;
+        }
+        const uint8_t* tiles = file.data() + sizeof(header);
+        heightmap->_tiles.resize(numTiles);
+        memcpy(heightmap->_tiles.data(), tiles, tilesSize);
+        heightmap->_samples.resize(numTiles * TILE_SIZE * TILE_SIZE);
+        memcpy(heightmap->_samples.data(), tiles + tilesSize, samplesSize);
+
+        heightmap->_name = std::filesystem::path(filename).stem().string();
+        return heightmap;
+    }
+
+    bool Heightmap::save(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        HeightmapFileHeader header;
+        header.width = _width;
+        header.height = _height;
+        header.spacing = _spacing;
+        header.minHeight = _minHeight;
+        header.maxHeight = _maxHeight;
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) _tiles.data(), _tiles.size() * sizeof(Tile));
+        file.write((const char*) _samples.data(), _samples.size() * sizeof(uint16_t));
+        return file.good();
+    }
+
+    HeightmapPointer Heightmap::load(const std::string& demFilename) {
+        if (!std::filesystem::exists(demFilename)) {
+            picoLog("DEM file " + demFilename + " doesn't exist");
+            return nullptr;
+        }
+        auto nativeFilename = demFilename + ".hmap";
+        std::error_code ec;
+        if (std::filesystem::exists(nativeFilename, ec) &&
+            std::filesystem::last_write_time(nativeFilename, ec) >= std::filesystem::last_write_time(demFilename, ec)) {
+            auto heightmap = createFromFile(nativeFilename);
+            if (heightmap) {
+                return heightmap;
+            }
+        }
+
+        auto heightmap = createFromDEM(demFilename);
+        if (heightmap && !heightmap->save(nativeFilename)) {
+            picoLog("heightmap file " + nativeFilename + " can't be written");
+        }
+        return heightmap;
+    }
+
+    float Heightmap::getHeight(uint32_t x, uint32_t y) const {
+        uint32_t t = (y / TILE_SIZE) * numTilesX() + (x / TILE_SIZE);
+        const auto& tile = _tiles[t];
+        uint16_t q = _samples[uint64_t(t) * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE)];
+        return tile.minHeight + q * ((tile.maxHeight - tile.minHeight) / 65535.0f);
+    }
+
+    void Heightmap::decode(std::vector<float>& heights) const {
+        heights.resize(uint64_t(_width) * _height);
+        uint32_t numTilesX = this->numTilesX();
+        core::ThreadPool::shared().parallel_for(numTilesY(), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t ty = begin; ty < end; ++ty) {
+                for (uint32_t tx = 0; tx < numTilesX; ++tx) {
+                    uint32_t t = ty * numTilesX + tx;
+                    const auto& tile = _tiles[t];
+                    float scale = (tile.maxHeight - tile.minHeight) / 65535.0f;
+                    const uint16_t* samples = _samples.data() + uint64_t(t) * TILE_SIZE * TILE_SIZE;
+                    uint32_t x0 = tx * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, _width);
+                    uint32_t y0 = ty * TILE_SIZE, y1 = std::min(y0 + TILE_SIZE, _height);
+                    for (uint32_t y = y0; y < y1; ++y) {
+                        float* row = heights.data() + uint64_t(y) * _width;
+                        for (uint32_t x = x0; x < x1; ++x) {
+                            row[x] = tile.minHeight + samples[(y - y0) * TILE_SIZE + (x - x0)] * scale;
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runHeightmapTests() to validate the tiled heightmap and
+// the DEM loader, runHeightmapBenchmarks() to time the loading of the DEM
+// assets against the stream parsing and the native file
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <sstream>
+
+namespace {
+    const char* DEM_FILES[] = { "../asset/dem/8955_75m.dem", "../asset/dem/8997_75m.dem", "../asset/dem/9008_75m.dem", "../asset/dem/9502_75m.dem" };
+
+    // The previous pico_terrain parsing: the whole file through a stringstream, a std::stoi per elevation.
+    // Returns the elevations of each profile and the elevation unit scale.
+    float streamParseDEM(const std::string& filename, std::vector<std::vector<int32_t>>& profiles) {
+        std::ifstream file(filename, std::ifstream::in);
+        std::stringstream asciiStream;
+        asciiStream << file.rdbuf();
+        std::string text = asciiStream.str();
+
+        profiles.clear();
+        uint32_t numProfiles = (uint32_t) std::stoi(text.substr(858, 6));
+        uint64_t offset = 1024;
+        for (uint32_t p = 0; p < numProfiles && offset + 144 <= text.size(); ++p) {
+            uint32_t numValues = (uint32_t) std::stoi(text.substr(offset + 12, 6));
+            uint32_t numBlocks = (numValues <= 146 ? 1 : 1 + (numValues - 146 + 169) / 170);
+            std::stringstream dataStream(text.substr(offset + 144, numBlocks * 1024 - 144));
+            std::string token;
+            auto& elevations = profiles.emplace_back();
+            for (uint32_t v = 0; v < numValues; ++v) {
+                dataStream >> token;
+                elevations.push_back(std::stoi(token));
+            }
+            offset += numBlocks * 1024;
+        }
+        return (std::stoi(text.substr(534, 6)) == 1 ? 0.3048f : 1.0f);
+    }
+}
+
+void runHeightmapTests() {
+    using namespace document;
+    picoLog("HeightmapTest: starting...");
+
+    // --- Test 1: quantization error under half a step of the tile range ---
+    {
+        const uint32_t width = 150, height = 97;
+        std::vector<float> heights(width * height);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                heights[y * width + x] = 100.0f * sinf(x * 0.05f) * cosf(y * 0.07f) + 0.01f * x * y;
+            }
+        }
+        auto heightmap = Heightmap::createFromHeights(width, height, 2.0f, heights.data());
+        assert(heightmap->numTilesX() == 3 && heightmap->numTilesY() == 2);
+
+        std::vector<float> decoded;
+        heightmap->decode(decoded);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const auto& tile = heightmap->_tiles[(y / Heightmap::TILE_SIZE) * heightmap->numTilesX() + x / Heightmap::TILE_SIZE];
+                float step = (tile.maxHeight - tile.minHeight) / 65535.0f;
+                assert(fabsf(decoded[y * width + x] - heights[y * width + x]) <= 0.5f * step + 1e-4f);
+                assert(decoded[y * width + x] == heightmap->getHeight(x, y));
+            }
+        }
+        picoLog("HeightmapTest 1 passed: tiles quantize within half a step");
+
+        // --- Test 2: the native file reopens the same heightmap ---
+        auto path = (std::filesystem::temp_directory_path() / "pico_heightmap_test.hmap").string();
+        assert(heightmap->save(path));
+        auto reopened = Heightmap::createFromFile(path);
+        assert(reopened && reopened->width() == width && reopened->height() == height && reopened->spacing() == 2.0f);
+        assert(reopened->_samples == heightmap->_samples);
+        assert(memcmp(reopened->_tiles.data(), heightmap->_tiles.data(), heightmap->_tiles.size() * sizeof(Heightmap::Tile)) == 0);
+        std::filesystem::remove(path);
+        picoLog("HeightmapTest 2 passed: native file round trip");
+    }
+
+    // --- Test 3: the DEM assets parse to the same elevations as the stream parsing ---
+    for (const char* file : DEM_FILES) {
+        auto heightmap = Heightmap::createFromDEM(file);
+        if (!heightmap) {
+            picoLogf("HeightmapTest 3 skipped {}: not found", file);
+            continue;
+        }
+        std::vector<std::vector<int32_t>> profiles;
+        float unitScale = streamParseDEM(file, profiles);
+        assert(profiles.size() == heightmap->height());
+
+        // each profile is found in its row, at the offset of its northing
+        float tolerance = (heightmap->maxHeight() - heightmap->minHeight()) / 65535.0f + 1e-2f;
+        uint64_t numElevations = 0;
+        for (uint32_t y = 0; y < heightmap->height(); ++y) {
+            const auto& elevations = profiles[y];
+            numElevations += elevations.size();
+            bool found = false;
+            for (uint32_t x0 = 0; !found && x0 + elevations.size() <= heightmap->width(); ++x0) {
+                found = true;
+                for (uint32_t v = 0; found && v < elevations.size(); ++v) {
+                    found = fabsf(heightmap->getHeight(x0 + v, y) - elevations[v] * unitScale) <= tolerance;
+                }
+            }
+            assert(found);
+        }
+        picoLogf("HeightmapTest 3 {}: {} x {} samples, {} elevations, height [{:.1f}, {:.1f}]",
+            file, heightmap->width(), heightmap->height(), numElevations, heightmap->minHeight(), heightmap->maxHeight());
+    }
+    picoLog("HeightmapTest 3 passed: DEM assets loaded");
+
+    picoLog("HeightmapTest: all tests passed");
+}
+
+void runHeightmapBenchmarks() {
+    using namespace document;
+    using clock = std::chrono::high_resolution_clock;
+
+    for (const char* file : DEM_FILES) {
+        if (!std::filesystem::exists(file)) {
+            picoLogf("HeightmapBench skipped {}: not found", file);
+            continue;
+        }
+        auto start = clock::now();
+        std::vector<std::vector<int32_t>> profiles;
+        streamParseDEM(file, profiles);
+        double streamMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        auto heightmap = Heightmap::createFromDEM(file);
+        double demMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        auto path = (std::filesystem::temp_directory_path() / "pico_heightmap_bench.hmap").string();
+        heightmap->save(path);
+        start = clock::now();
+        auto native = Heightmap::createFromFile(path);
+        std::vector<float> heights;
+        native->decode(heights);
+        double nativeMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        std::filesystem::remove(path);
+
+        picoLogf("HeightmapBench {} ({} x {}), {} threads: stream parse {:.2f} ms | DEM {:.2f} ms x{:.1f} | native open + decode {:.2f} ms x{:.1f}",
+            file, heightmap->width(), heightmap->height(), core::ThreadPool::shared().threadCount(),
+            streamMs, demMs, streamMs / demMs, nativeMs, streamMs / nativeMs);
+    }
+}
@@ -0,0 +1,99 @@
+// Heightmap.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <document/dllmain.h>
+
+namespace document
+{
+    class Heightmap;
+    using HeightmapPointer = std::shared_ptr<Heightmap>;
+
+    // Regular grid of elevations stored in square tiles of 16 bits samples,
+    // each tile quantizes its samples between its own min and max heights.
+    // The native file (.hmap) is the header, the tiles and the samples as laid out in memory
+    // so it opens without any parsing.
+    class DOCUMENT_API Heightmap {
+    public:
+        static const uint32_t TILE_SIZE = 64;
+
+        // USGS DEM (ascii, 1024 bytes blocks): the DEM profiles are the rows of the heightmap,
+        // placed from their first elevation northing. Void and missing samples get the lowest elevation.
+        static HeightmapPointer createFromDEM(const std::string& filename);
+
+        // Native heightmap file
+        static HeightmapPointer createFromFile(const std::string& filename);
+
+        // Quantize an array of width x height elevations, row major
+        static HeightmapPointer createFromHeights(uint32_t width, uint32_t height, float spacing, const float* heights);
+
+        // Open the native heightmap next to the DEM file (filename + ".hmap"),
+        // converting the DEM and writing the native file the first time
+        static HeightmapPointer load(const std::string& demFilename);
+
+        bool save(const std::string& filename) const;
+
+        struct Tile {
+            float minHeight{ 0.0f };
+            float maxHeight{ 0.0f };
+        };
+
+        uint32_t width() const { return _width; }
+        uint32_t height() const { return _height; }
+        float spacing() const { return _spacing; }
+        uint32_t numTilesX() const { return (_width + TILE_SIZE - 1) / TILE_SIZE; }
+        uint32_t numTilesY() const { return (_height + TILE_SIZE - 1) / TILE_SIZE; }
+
+        float minHeight() const { return _minHeight; }
+        float maxHeight() const { return _maxHeight; }
+
+        // Elevation of the sample at x, y
+        float getHeight(uint32_t x, uint32_t y) const;
+
+        // Decode all the elevations, row major, one tile row per job
+        void decode(std::vector<float>& heights) const;
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+        uint32_t _width{ 0 };
+        uint32_t _height{ 0 };
+        float _spacing{ 1.0f };
+        float _minHeight{ 0.0f };
+        float _maxHeight{ 0.0f };
+
+        std::vector<Tile> _tiles;        // numTilesX x numTilesY
+        std::vector<uint16_t> _samples;  // TILE_SIZE x TILE_SIZE per tile, the tiles on the border are padded
+
+        // name assigned to the document
+        std::string _name;
+#pragma warning(pop)
+    };
+}
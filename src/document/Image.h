@@ -30,6 +30,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <document/dllmain.h>
 
 namespace document {
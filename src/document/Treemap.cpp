@@ -0,0 +1,375 @@
+// Treemap.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "Treemap.h"
+
+#include <algorithm>
+
+#include <core/Log.h>
+#include <core/Job.h>
+
+namespace document
+{
+    void Treemap::build(const FileTree& tree) {
+        _tree = &tree;
+        const auto& nodes = tree._nodes;
+        _orders.resize(nodes.size());
+
+        core::ThreadPool::shared().parallel_for((uint32_t) nodes.size(), 1024, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t n = begin; n < end; ++n) {
+                const auto& node = nodes[n];
+                if (node.childBegin < 0) continue;
+                auto first = _orders.begin() + node.childBegin;
+                auto last = _orders.begin() + node.childEnd + 1;
+                for (int32_t c = node.childBegin; c <= node.childEnd; ++c) {
+                    _orders[c] = c;
+                }
+                // decreasing size, the listing order between equal sizes
+                std::sort(first, last, [&](int32_t a, int32_t b) {
+                    return (nodes[a].size != nodes[b].size ? nodes[a].size > nodes[b].size : a < b);
+                });
+            }
+        });
+    }
+
+    void Treemap::layout(const core::vec2& origin, const core::vec2& size, std::vector<core::vec4>& rects) const {
+        if (!_tree || _tree->_nodes.empty()) {
+            rects.clear();
+            return;
+        }
+        rects.resize(_tree->_nodes.size());
+        rects[0] = { origin.x, origin.y, size.x, size.y };
+
+        // The last level has no children to lay out
+        for (uint32_t level = 0; level + 1 < _tree->numLevels(); ++level) {
+            uint32_t levelBegin = _tree->_levelOffsets[level];
+            uint32_t levelEnd = _tree->_levelOffsets[level + 1];
+            core::ThreadPool::shared().parallel_for(levelEnd - levelBegin, 256, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t n = begin; n < end; ++n) {
+                    layoutChildren(int32_t(levelBegin + n), rects);
+                }
+            });
+        }
+    }
+
+    // Squarify the children of a node: fill rows along the short side of the space left,
+    // a row takes children in decreasing size while that improves its worst aspect ratio.
+    void Treemap::layoutChildren(int32_t node, std::vector<core::vec4>& rects) const {
+        const auto& nodes = _tree->_nodes;
+        const auto& parent = nodes[node];
+        if (parent.childBegin < 0) {
+            return;
+        }
+        const core::vec4 rootRect = rects[node];
+        if (parent.size <= 0) {
+            for (int32_t c = parent.childBegin; c <= parent.childEnd; ++c) {
+                rects[c] = { rootRect.x, rootRect.y, 0.0f, 0.0f };
+            }
+            return;
+        }
+
+        const int32_t* order = _orders.data() + parent.childBegin;
+        const int32_t numChildren = parent.childEnd - parent.childBegin + 1;
+        const double sizeToArea = double(rootRect.z) * double(rootRect.w) / double(parent.size);
+        auto area = [&](int32_t i) { return double(nodes[order[i]].size) * sizeToArea; };
+
+        // worst aspect ratio of a row of areas in [minArea, maxArea] summing to totalArea along a side of width
+        auto worst = [](double maxArea, double minArea, double width, double totalArea) {
+            double width2 = width * width;
+            double totalArea2 = totalArea * totalArea;
+            return std::max(width2 * maxArea / totalArea2, totalArea2 / (width2 * minArea));
+        };
+
+        int32_t next = 0;
+        core::vec2 cornerOffset(0.0f);
+        while (next < numChildren) {
+            int32_t rowBegin = next;
+            double rowArea = area(next);
+            double maxArea = rowArea; // sorted by decreasing size, the first of the row is the biggest
+            next++;
+
+            // next row direction based on the remaining space shape
+            core::vec2 rootSize(rootRect.z - cornerOffset.x, rootRect.w - cornerOffset.y);
+            int32_t direction = (rootSize.x > rootSize.y ? 1 : 0);
+            double rootSide = rootSize[direction];
+
+            if (next < numChildren) {
+                double bestAspectRatio = worst(maxArea, rowArea, rootSide, rowArea);
+                while (next < numChildren) {
+                    // the candidate is the smallest of the row, measured against the area of the row without it
+                    double candidate = area(next);
+                    double aspectRatio = worst(maxArea, candidate, rootSide, rowArea);
+                    if (aspectRatio > bestAspectRatio) {
+                        break;
+                    }
+                    bestAspectRatio = aspectRatio;
+                    rowArea += candidate;
+                    next++;
+                }
+            }
+
+            // place the rects of the row, the rows of empty nodes are empty
+            int32_t otherDirection = !direction;
+            double rowOtherSide = (rootSide > 0.0 ? rowArea / rootSide : 0.0);
+            double sideOffset = cornerOffset[direction];
+            double otherSideOffset = cornerOffset[otherDirection];
+            for (int32_t i = rowBegin; i < next; ++i) {
+                double rectSide = (rowArea > 0.0 ? rootSide * area(i) / rowArea : 0.0);
+                auto& rect = rects[order[i]];
+                rect[direction] = rootRect[direction] + sideOffset;
+                rect[otherDirection] = rootRect[otherDirection] + otherSideOffset;
+                rect[2 + direction] = rectSide;
+                rect[2 + otherDirection] = rowOtherSide;
+                sideOffset += rectSide;
+            }
+            cornerOffset[otherDirection] += rowOtherSide;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runTreemapTests() to validate the layout against the
+// pico_treemap squarified layout and runTreemapBenchmarks() to time a relayout
+// of a 1M entries tree
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace document;
+
+namespace {
+    using IDs = std::vector<int32_t>;
+    using RectAreas = std::vector<double>;
+    using Nodes = FileTree::Nodes;
+
+    // The layout pico_treemap ran before the Treemap: gather, sort and squarify every node from scratch
+    IDs gatherChildren(const Nodes& tree, int32_t node) {
+        IDs children;
+        for (int32_t next = tree[node].childBegin; next >= 0; next = (next == tree[node].childEnd ? -1 : tree[next].sybling)) {
+            children.emplace_back(next);
+        }
+        return children;
+    }
+
+    double layoutWorst(const RectAreas& collection, IDs& row, double width, double totalArea) {
+        double width2 = width * width;
+        double totalArea2 = totalArea * totalArea;
+        double maxArea = collection[row[0]], minArea = collection[row[0]];
+        for (size_t i = 1; i < row.size(); ++i) {
+            maxArea = std::max(maxArea, collection[row[i]]);
+            minArea = std::min(minArea, collection[row[i]]);
+        }
+        return std::max(width2 * maxArea / totalArea2, totalArea2 / (width2 * minArea));
+    }
+
+    void layoutRow(std::vector<core::vec4>& treemap, const IDs& collectionIDs, const RectAreas& collectionAreas, const IDs& collectionOrder, const core::vec4& rootRect, int32_t& next, core::vec2& cornerOffset) {
+        IDs row = { collectionOrder[next] };
+        double rowArea = collectionAreas[collectionOrder[next]];
+        next++;
+        core::vec2 rootSize(rootRect.z - cornerOffset.x, rootRect.w - cornerOffset.y);
+        int32_t direction = (rootSize.x > rootSize.y ? 1 : 0);
+        double rootSide = rootSize[direction];
+        if (next < (int32_t) collectionIDs.size()) {
+            double bestaspectratio = layoutWorst(collectionAreas, row, rootSide, rowArea);
+            while (next < (int32_t) collectionIDs.size()) {
+                row.emplace_back(collectionOrder[next]);
+                double newaspectratio = layoutWorst(collectionAreas, row, rootSide, rowArea);
+                if (newaspectratio > bestaspectratio) {
+                    row.pop_back();
+                    break;
+                }
+                bestaspectratio = newaspectratio;
+                rowArea += collectionAreas[collectionOrder[next]];
+                next++;
+            }
+        }
+        int32_t otherDirection = !direction;
+        double rowOtherSide = rowArea / rootSide;
+        double sideOffset = cornerOffset[direction];
+        double otherSideOffset = cornerOffset[otherDirection];
+        for (auto i : row) {
+            double rectSide = rootSide * collectionAreas[i] / rowArea;
+            auto& rect = treemap[collectionIDs[i]];
+            rect[direction] = rootRect[direction] + sideOffset;
+            rect[otherDirection] = rootRect[otherDirection] + otherSideOffset;
+            rect[2 + direction] = rectSide;
+            rect[2 + otherDirection] = rowOtherSide;
+            sideOffset += rectSide;
+        }
+        cornerOffset[otherDirection] += rowOtherSide;
+    }
+
+    IDs layoutRect(const Nodes& tree, std::vector<core::vec4>& treemap, int32_t root) {
+        auto collectionIDs = gatherChildren(tree, root);
+        if (collectionIDs.empty()) return collectionIDs;
+        RectAreas collectionAreas;
+        const auto& rootRect = treemap[root];
+        double rootSizeInv = double(rootRect.z) * double(rootRect.w) / (double) tree[root].size;
+        for (auto id : collectionIDs) collectionAreas.emplace_back((double) tree[id].size * rootSizeInv);
+        IDs indices(collectionIDs.size());
+        for (int32_t i = 0; i < (int32_t) indices.size(); ++i) indices[i] = i;
+        std::sort(indices.begin(), indices.end(), [&](int32_t a, int32_t b) { return collectionAreas[a] > collectionAreas[b]; });
+        int32_t next = 0;
+        core::vec2 offset(0.0f);
+        while (next < (int32_t) collectionIDs.size()) {
+            layoutRow(treemap, collectionIDs, collectionAreas, indices, rootRect, next, offset);
+        }
+        return collectionIDs;
+    }
+
+    std::vector<core::vec4> buildTreemapReference(const Nodes& tree, const core::vec2& origin, const core::vec2& size) {
+        std::vector<core::vec4> treemap(tree.size());
+        treemap[0] = { origin.x, origin.y, size.x, size.y };
+        IDs queue = { 0 };
+        while (queue.size()) {
+            auto collection = layoutRect(tree, treemap, queue.back());
+            queue.pop_back();
+            queue.insert(queue.begin(), collection.begin(), collection.end());
+        }
+        return treemap;
+    }
+
+    // numFolders folders per folder down to depth, numFiles files per folder, distinct sizes
+    void listTestFolder(const std::string& path, FileTree::Entries& entries, uint32_t maxDepth, uint32_t numFolders, uint32_t numFiles) {
+        uint32_t depth = (uint32_t) std::count(path.begin(), path.end(), '/');
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : path) { h ^= uint8_t(c); h *= 0x100000001b3ull; }
+        for (uint32_t f = 0; f < numFiles; ++f) {
+            entries.push_back({ path + "/f" + std::to_string(f), int64_t(((h >> (f % 32)) % 1000000) * 64 + f + 1), false });
+        }
+        if (depth < maxDepth) {
+            for (uint32_t d = 0; d < numFolders; ++d) {
+                entries.push_back({ path + "/" + std::to_string(d), 0, true });
+            }
+        }
+    }
+}
+
+void runTreemapTests() {
+    picoLog("TreemapTest: starting...");
+
+    auto tree = FileTree::scan("root", [](const std::string& path, FileTree::Entries& entries) { listTestFolder(path, entries, 3, 4, 7); });
+
+    // --- Test 1: same rects as the pico_treemap layout ---
+    {
+        Treemap treemap;
+        treemap.build(*tree);
+        std::vector<core::vec4> rects;
+        treemap.layout({ 10.0f, 20.0f }, { 640.0f, 480.0f }, rects);
+        auto reference = buildTreemapReference(tree->_nodes, { 10.0f, 20.0f }, { 640.0f, 480.0f });
+        assert(rects.size() == reference.size());
+        for (size_t n = 0; n < rects.size(); ++n) {
+            for (int c = 0; c < 4; ++c) {
+                assert(rects[n][c] == reference[n][c]);
+            }
+        }
+    }
+    picoLog("TreemapTest 1 passed: matches the squarified layout");
+
+    // --- Test 2: children tile their parent, a relayout gives the layout of a fresh build ---
+    {
+        Treemap treemap;
+        treemap.build(*tree);
+        std::vector<core::vec4> rects;
+        treemap.layout({ 0.0f, 0.0f }, { 640.0f, 480.0f }, rects);
+        treemap.layout({ 0.0f, 0.0f }, { 1913.0f, 1071.0f }, rects);
+
+        Treemap fresh;
+        fresh.build(*tree);
+        std::vector<core::vec4> freshRects;
+        fresh.layout({ 0.0f, 0.0f }, { 1913.0f, 1071.0f }, freshRects);
+        assert(rects.size() == freshRects.size() && memcmp(rects.data(), freshRects.data(), rects.size() * sizeof(core::vec4)) == 0);
+
+        for (const auto& node : tree->_nodes) {
+            if (node.childBegin < 0) continue;
+            const auto& p = rects[&node - tree->_nodes.data()];
+            double area = 0.0;
+            for (int32_t c = node.childBegin; c <= node.childEnd; ++c) {
+                const auto& r = rects[c];
+                assert(r.x >= p.x - 1e-2f && r.y >= p.y - 1e-2f && r.x + r.z <= p.x + p.z + 1e-2f && r.y + r.w <= p.y + p.w + 1e-2f);
+                assert(fabs(double(r.z) * r.w - double(p.z) * p.w * double(tree->_nodes[c].size) / double(node.size)) <= 1e-3 * double(p.z) * p.w + 1e-3);
+                area += double(r.z) * r.w;
+            }
+            assert(fabs(area - double(p.z) * p.w) <= 1e-3 * double(p.z) * p.w + 1e-3);
+        }
+    }
+    picoLog("TreemapTest 2 passed: relayout tiles the parents");
+
+    // --- Test 3: empty folders and empty files get empty rects ---
+    {
+        auto withEmpty = FileTree::scan("root", [](const std::string& path, FileTree::Entries& entries) {
+            if (path == "root") {
+                entries.push_back({ "root/a", 100, false });
+                entries.push_back({ "root/b", 0, false });
+                entries.push_back({ "root/empty", 0, true });
+            }
+        });
+        Treemap treemap;
+        treemap.build(*withEmpty);
+        std::vector<core::vec4> rects;
+        treemap.layout({ 0.0f, 0.0f }, { 100.0f, 50.0f }, rects);
+        assert(rects[1].x == 0.0f && rects[1].y == 0.0f && rects[1].z == 100.0f && rects[1].w == 50.0f);
+        for (int i = 2; i < 4; ++i) {
+            assert(rects[i].z * rects[i].w == 0.0f && !std::isnan(rects[i].x) && !std::isnan(rects[i].z));
+        }
+    }
+    picoLog("TreemapTest 3 passed: empty nodes");
+
+    picoLog("TreemapTest: all tests passed");
+}
+
+void runTreemapBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+
+    // 8 sub folders down to depth 5 and 26 files per folder: 37449 folders, 1011123 entries
+    auto start = clock::now();
+    auto tree = FileTree::scan("root", [](const std::string& path, FileTree::Entries& entries) { listTestFolder(path, entries, 5, 8, 26); });
+    double scanMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    auto reference = buildTreemapReference(tree->_nodes, { 0.0f, 0.0f }, { 1920.0f, 1080.0f });
+    double referenceMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    Treemap treemap;
+    start = clock::now();
+    treemap.build(*tree);
+    double buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    std::vector<core::vec4> rects;
+    treemap.layout({ 0.0f, 0.0f }, { 640.0f, 480.0f }, rects);
+    const uint32_t numRelayouts = 10;
+    start = clock::now();
+    for (uint32_t r = 0; r < numRelayouts; ++r) {
+        treemap.layout({ 0.0f, 0.0f }, { 1920.0f - 32.0f * r, 1080.0f - 16.0f * r }, rects);
+    }
+    double layoutMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numRelayouts;
+
+    picoLogf("TreemapBench {} entries (scan {:.1f} ms): full layout {:.1f} ms | build {:.1f} ms, relayout {:.1f} ms | x{:.2f} per resize",
+        tree->numNodes(), scanMs, referenceMs, buildMs, layoutMs, referenceMs / layoutMs);
+}
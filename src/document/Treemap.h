@@ -0,0 +1,59 @@
+// Treemap.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <core/math/Math3D.h>
+#include <document/dllmain.h>
+#include <document/FileTree.h>
+
+namespace document
+{
+    // Squarified treemap of a FileTree: each node gets a rect (x, y, width, height)
+    // with an area proportional to its size, tiling the rect of its parent.
+    //
+    // build() sorts the children of every node by decreasing size once,
+    // layout() only recomputes the rects from these orders and runs for every new size of the treemap.
+    class DOCUMENT_API Treemap {
+    public:
+        void build(const FileTree& tree);
+
+        // Rects of all the nodes of the tree, the root covers (origin, size).
+        // The nodes of a level are laid out in parallel, their parents are done in the previous level.
+        void layout(const core::vec2& origin, const core::vec2& size, std::vector<core::vec4>& rects) const;
+
+    private:
+        void layoutChildren(int32_t node, std::vector<core::vec4>& rects) const;
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+        const FileTree* _tree{ nullptr };
+        std::vector<int32_t> _orders; // children of a node, by decreasing size, at the range of the children [childBegin, childEnd]
+#pragma warning(pop)
+    };
+}
@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
 namespace document
 {
@@ -44,6 +45,10 @@ namespace document
 
     }
 
+    void TriangleSoup::buildAdjacency(core::MeshAdjacency& adjacency) const {
+        core::mesh_buildAdjacency(_indices.data(), (uint32_t) _indices.size() / 3, nullptr, adjacency);
+    }
+
     TriangleSoupPointer TriangleSoup::createFromPLY(const std::string& filename) {
 
         if (filename.empty()) {
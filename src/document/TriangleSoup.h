@@ -30,6 +30,7 @@
 #include <vector>
 #include <memory>
 #include <core/math/Math3D.h>
+#include <core/mesh/Adjacency.h>
 #include <document/dllmain.h>
 
 namespace document
@@ -56,6 +57,9 @@ namespace document
         
         // A continous array of the Indices describing the triangle soup
         using Indices = std::vector<uint32_t>;
+
+        // Edge and face adjacency of the triangles
+        void buildAdjacency(core::MeshAdjacency& adjacency) const;
         
 #pragma warning(push)
 #pragma warning(disable: 4251)
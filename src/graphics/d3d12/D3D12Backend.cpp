@@ -349,6 +349,13 @@ D3D12Backend::D3D12Backend() {
 
     _device = CreateDevice(dxgiAdapter4);
 
+    _bufferHeapPool = std::make_shared<ResourceHeapPool>(ResourceHeapPoolInit(), [this](uint64_t size) {
+        return createResourceHeap(size, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+    });
+    _textureHeapPool = std::make_shared<ResourceHeapPool>(ResourceHeapPoolInit(), [this](uint64_t size) {
+        return createResourceHeap(size, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES);
+    });
+
     // Check if the D3D12 device actually supports ray tracing.
     D3D12_FEATURE_DATA_D3D12_OPTIONS5 caps = {};
     auto hr = _device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &caps, sizeof(caps));
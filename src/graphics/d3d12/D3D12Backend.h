@@ -158,6 +158,14 @@ namespace graphics {
 
         // Global Descriptor Heap
         DescriptorHeapPointer getDescriptorHeap() override;
+
+        // The buffers and the sampled textures are placed resources in pooled heaps,
+        // the render targets and the resources over the max allocation size are committed
+        ResourceHeapPoolPointer getBufferHeapPool() override { return _bufferHeapPool; }
+        ResourceHeapPoolPointer getTextureHeapPool() override { return _textureHeapPool; }
+        ResourceHeapPoolPointer _bufferHeapPool;
+        ResourceHeapPoolPointer _textureHeapPool;
+        ResourceHeapPool::NativeHeap createResourceHeap(uint64_t size, D3D12_HEAP_FLAGS flags);
         DescriptorHeapPointer _descriptorHeap;
 
         // Separate shader and pipeline state compilation as functions in order
@@ -274,11 +282,13 @@ namespace graphics {
 
         void draw(uint32_t numPrimitives, uint32_t startIndex) override;
         void drawIndexed(uint32_t numPrimitives, uint32_t startIndex) override;
+        void drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) override;
 
         void uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) override;
 
         void copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) override;
         void uploadBuffer(const BufferPointer& dest) override;
+        void uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) override;
 
         void dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) override;
 
@@ -436,6 +436,10 @@ void D3D12BatchBackend::drawIndexed(uint32_t numPrimitives, uint32_t startIndex)
     _commandList->DrawIndexedInstanced(numPrimitives, 1, startIndex, 0, 0);
 }
 
+void D3D12BatchBackend::drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) {
+    _commandList->DrawInstanced(numPrimitives, numInstances, startIndex, 0);
+}
+
 void D3D12BatchBackend::uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayouts, const BufferPointer& src) {
     auto srcBackend = static_cast<D3D12BufferBackend*>(src.get());
     auto dstBackend = static_cast<D3D12TextureBackend*>(dest.get());
@@ -567,6 +571,13 @@ void D3D12BatchBackend::uploadBuffer(const BufferPointer& dest) {
     dstBackend->notifyUploaded();
 }
 
+void D3D12BatchBackend::uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) {
+    auto dstBackend = static_cast<D3D12BufferBackend*>(dest.get());
+
+    // upload the region of the cpuDataBuffer into dest
+    _commandList->CopyBufferRegion(dstBackend->_resource.Get(), offset, dstBackend->_cpuDataResource.Get(), offset, size);
+}
+
 
 void D3D12BatchBackend::dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) {
     _commandList->Dispatch(numThreadsX, numThreadsY, numThreadsZ);
@@ -306,6 +306,9 @@ void D3D12Backend::resizeTexture(const TexturePointer& texture, uint32_t width,
 
     auto newTex = createTexture(d3d12Tex->_init);
     d3d12Tex->_resource = static_cast<D3D12TextureBackend*>(newTex.get())->_resource;
+    // the heap range follows the resource, the previous one goes away with newTex
+    std::swap(d3d12Tex->_heapPool, newTex->_heapPool);
+    std::swap(d3d12Tex->_heapAllocation, newTex->_heapAllocation);
 }
 
 void D3D12Backend::resizeFramebuffer(const FramebufferPointer& framebuffer, uint32_t width, uint32_t height) {
@@ -25,11 +25,36 @@
 // SOFTWARE.
 //
 #include "D3D12Backend.h"
+#include "gpu/PipelineCache.h"
 
 using namespace graphics;
 
 #ifdef _WINDOWS
 
+namespace {
+    // Create the pipeline from the blob cached by a previous run if any, store the blob of a new one.
+    // A blob of another driver or adapter is refused by the device: evict it and create the pipeline from scratch.
+    template <typename Desc, typename Create>
+    HRESULT createCachedPipelineState(const PipelineCachePointer& cache, uint64_t key, Desc& psoDesc, ComPtr<ID3D12PipelineState>& pipelineState, Create create) {
+        PipelineCacheBlob cachedBlob;
+        if (key && cache->find(key, cachedBlob)) {
+            psoDesc.CachedPSO = { cachedBlob.data(), cachedBlob.size() };
+            HRESULT hr = create(psoDesc, pipelineState);
+            if (SUCCEEDED(hr)) {
+                return hr;
+            }
+            cache->evict(key);
+            psoDesc.CachedPSO = {};
+        }
+        HRESULT hr = create(psoDesc, pipelineState);
+        ComPtr<ID3DBlob> blob;
+        if (SUCCEEDED(hr) && key && SUCCEEDED(pipelineState->GetCachedBlob(&blob))) {
+            cache->store(key, blob->GetBufferPointer(), blob->GetBufferSize());
+        }
+        return hr;
+    }
+}
+
 
 D3D12PipelineStateBackend::D3D12PipelineStateBackend() {
 
@@ -108,7 +133,15 @@ bool D3D12Backend::realizePipelineState(PipelineState* pipeline) {
             else {
                 psoDesc.DSVFormat = DXGI_FORMAT_UNKNOWN;
             }
-            D3D12Backend_Check(_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)));
+            if (_pipelineCache) {
+                pso->_cacheKey = PipelineCache::evalPipelineKey(init);
+                D3D12Backend_Check(createCachedPipelineState(_pipelineCache, pso->_cacheKey, psoDesc, pipelineState,
+                    [&](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& state) {
+                        return _device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&state));
+                    }));
+            } else {
+                D3D12Backend_Check(_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)));
+            }
 
             pso->_primitive_topology = D3D12BatchBackend::PrimitiveTopologies[(int)init.primitiveTopology];
         }
@@ -153,7 +186,15 @@ bool D3D12Backend::realizePipelineState(PipelineState* pipeline) {
 
         psoDesc.CS = { reinterpret_cast<UINT8*>(computeShaderBlob.Get()->GetBufferPointer()), computeShaderBlob.Get()->GetBufferSize() };
 
-        D3D12Backend_Check(_device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)));
+        if (_pipelineCache) {
+            pso->_cacheKey = PipelineCache::evalPipelineKey(init);
+            D3D12Backend_Check(createCachedPipelineState(_pipelineCache, pso->_cacheKey, psoDesc, pipelineState,
+                [&](const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& state) {
+                    return _device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&state));
+                }));
+        } else {
+            D3D12Backend_Check(_device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState)));
+        }
 
         // update these
         if (pso->_pipelineState) {
@@ -30,6 +30,24 @@ using namespace graphics;
 
 #ifdef _WINDOWS
 
+ResourceHeapPool::NativeHeap D3D12Backend::createResourceHeap(uint64_t size, D3D12_HEAP_FLAGS flags) {
+    D3D12_HEAP_DESC desc{};
+    desc.SizeInBytes = size;
+    desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    desc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    desc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    desc.Properties.CreationNodeMask = 1;
+    desc.Properties.VisibleNodeMask = 1;
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    desc.Flags = flags;
+
+    ID3D12Heap* heap = nullptr;
+    if (FAILED(_device->CreateHeap(&desc, __uuidof(ID3D12Heap), (void**)&heap))) {
+        return nullptr;
+    }
+    return ResourceHeapPool::NativeHeap(heap, [](void* h) { static_cast<ID3D12Heap*>(h)->Release(); });
+}
+
 D3D12BufferBackend::D3D12BufferBackend() {
 
 }
@@ -133,9 +151,22 @@ BufferPointer D3D12Backend::_createBuffer(const BufferInit& init, const std::str
     bufferBackend->_cpuDataResource;
     bufferBackend->_bufferSize = bufferSize;
 
-    D3D12Backend_Check(_device->CreateCommittedResource(
-        &heapProp, heapFlags, &desc, res_states, NULL,
-        __uuidof(bufferBackend->_resource), (void**)&(bufferBackend->_resource)));
+    // The default heap buffers are placed in the pool, a committed resource is 64KB aligned all the same
+    if (heapProp.Type == D3D12_HEAP_TYPE_DEFAULT) {
+        auto allocation = _bufferHeapPool->allocate(bufferSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        if (allocation.isValid()) {
+            D3D12Backend_Check(_device->CreatePlacedResource(
+                static_cast<ID3D12Heap*>(allocation.nativeHeap), allocation.allocation.offset, &desc, res_states, NULL,
+                __uuidof(bufferBackend->_resource), (void**)&(bufferBackend->_resource)));
+            bufferBackend->_heapPool = _bufferHeapPool;
+            bufferBackend->_heapAllocation = allocation;
+        }
+    }
+    if (!bufferBackend->_resource) {
+        D3D12Backend_Check(_device->CreateCommittedResource(
+            &heapProp, heapFlags, &desc, res_states, NULL,
+            __uuidof(bufferBackend->_resource), (void**)&(bufferBackend->_resource)));
+    }
 
     bufferBackend->_resource->SetName(core::to_wstring(name).c_str());
 
@@ -305,9 +336,23 @@ D3D12TextureBackend* CreateTexture(D3D12Backend* backend, const TextureInit& ini
         d3d12TextureBackend->notifyUploaded(); 
     }
 
-    D3D12Backend_Check(backend->_device->CreateCommittedResource(
-        &heap_props, heap_flags, &desc, res_states, p_clear_value,
-        __uuidof(d3d12TextureBackend->_resource), (void**)&(d3d12TextureBackend->_resource)));
+    // The sampled textures are placed in the pool, the render targets and uav are committed
+    if (!p_clear_value && !(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)) {
+        auto info = backend->_device->GetResourceAllocationInfo(0, 1, &desc);
+        auto allocation = backend->_textureHeapPool->allocate(info.SizeInBytes, info.Alignment);
+        if (allocation.isValid()) {
+            D3D12Backend_Check(backend->_device->CreatePlacedResource(
+                static_cast<ID3D12Heap*>(allocation.nativeHeap), allocation.allocation.offset, &desc, res_states, NULL,
+                __uuidof(d3d12TextureBackend->_resource), (void**)&(d3d12TextureBackend->_resource)));
+            d3d12TextureBackend->_heapPool = backend->_textureHeapPool;
+            d3d12TextureBackend->_heapAllocation = allocation;
+        }
+    }
+    if (!d3d12TextureBackend->_resource) {
+        D3D12Backend_Check(backend->_device->CreateCommittedResource(
+            &heap_props, heap_flags, &desc, res_states, p_clear_value,
+            __uuidof(d3d12TextureBackend->_resource), (void**)&(d3d12TextureBackend->_resource)));
+    }
 
     d3d12TextureBackend->_shaderResourceViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     d3d12TextureBackend->_shaderResourceViewDesc.Format = d3d12Format;
@@ -25,6 +25,7 @@
 // SOFTWARE.
 //
 #include "D3D12Backend.h"
+#include "gpu/PipelineCache.h"
 #include <fstream>
 #include <sstream>
 
@@ -163,12 +164,16 @@ bool PicoDXCCompileShader(Shader* shader, const std::string& source) {
     arguments.push_back(const_cast<LPWSTR>(DXC_ARG_WARNINGS_ARE_ERRORS)); //-WX
     arguments.push_back(const_cast<LPWSTR>(DXC_ARG_DEBUG)); //-Zi
     arguments.push_back(const_cast<LPWSTR>(DXC_ARG_PACK_MATRIX_ROW_MAJOR)); //-Zp
-    /*
-        for (const std::wstring& define : defines)
-        {
-            arguments.push_back(L"-D");
-            arguments.push_back(define.c_str());
-        }*/
+
+    //-D for the defines (eg. USE_SKIN=1)
+    std::vector<std::wstring> wdefines;
+    for (const auto& define : shader->getShaderDesc().defines) {
+        wdefines.emplace_back(core::to_wstring(define));
+    }
+    for (const auto& wdefine : wdefines) {
+        arguments.push_back(const_cast<LPWSTR>(L"-D"));
+        arguments.push_back((LPWSTR)wdefine.c_str());
+    }
 
     DxcBuffer sourceBuffer;
     sourceBuffer.Ptr = pSource->GetBufferPointer();
@@ -311,6 +316,34 @@ bool D3D12Backend::compileShader(Shader* shader, const std::string& source) {
     }
 
 #ifdef USE_DXC
+    // Same preprocessed source, entry point, profile and defines as a previous run? reuse its bytecode
+    auto d3d12Shader = static_cast<D3D12ShaderBackend*>(shader);
+    d3d12Shader->_cacheKey = 0;
+    if (_pipelineCache) {
+        std::string target(D3D12ShaderBackend::ShaderTypes[(int)shader->getShaderDesc().type]);
+        auto preprocessed = PipelineCache::preprocessShaderSource(source, shader->getShaderDesc().includes);
+        auto key = PipelineCache::evalShaderKey(shader->getShaderDesc(), preprocessed, target);
+
+        PipelineCacheBlob bytecode;
+        if (_pipelineCache->find(key, bytecode)) {
+            ComPtr<IDxcUtils> pUtils;
+            D3D12Backend_Check(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(pUtils.GetAddressOf())));
+            ComPtr<IDxcBlobEncoding> blob;
+            D3D12Backend_Check(pUtils->CreateBlob(bytecode.data(), (uint32_t)bytecode.size(), 0, blob.GetAddressOf()));
+            d3d12Shader->_shaderBlob = blob;
+            d3d12Shader->_cacheKey = key;
+            return true;
+        }
+        if (!PicoDXCCompileShader(shader, source)) {
+            return false;
+        }
+        auto& compiled = d3d12Shader->_shaderBlob;
+        if (compiled && compiled->GetBufferSize()) {
+            _pipelineCache->store(key, compiled->GetBufferPointer(), compiled->GetBufferSize());
+            d3d12Shader->_cacheKey = key;
+        }
+        return true;
+    }
     return PicoDXCCompileShader(shader, source);
 #else
     return PicoFXCCompileShader(shader, source);
@@ -55,6 +55,17 @@
 //using namespace view3d;
 namespace graphics
 {
+    Heightmap Heightmap::createFromDocument(const document::Heightmap& heightmap) {
+        Heightmap map;
+        map.map_width = heightmap.width();
+        map.map_height = heightmap.height();
+        map.map_spacing = heightmap.spacing();
+        map.mesh_resolutionX = heightmap.width();
+        map.mesh_resolutionY = heightmap.height();
+        map.mesh_spacing = heightmap.spacing();
+        heightmap.decode(map.heights);
+        return map;
+    }
 
     HeightmapDrawFactory::HeightmapDrawFactory(const graphics::DevicePointer& device) :
         _sharedUniforms(std::make_shared<HeightmapDrawUniforms>()) {
@@ -76,8 +87,15 @@ namespace graphics
         uint32_t mesh_width{ 0 };
         uint32_t mesh_height{ 0 };
         float mesh_spacing{ 0 };
+
+        uint32_t chunk_level{ 0 };
+        uint32_t chunk_x{ 0 };
+        uint32_t chunk_y{ 0 };
     };
 
+    // Scale applied to the heights by fetchHeight in Heightmap_vert.hlsl, the quadtree bounds and errors must match it
+    static const float HEIGHTMAP_HEIGHT_SCALE = 0.2f;
+
     void HeightmapDrawFactory::allocateGPUShared(const graphics::DevicePointer& device) {
 
         // Let's describe the pipeline Descriptors layout
@@ -127,6 +145,43 @@ namespace graphics
       //  pipelineInit.rasterizer.fillMode = graphics::FillMode::LINE;
         _HeightmapPipeline = device->createGraphicsPipelineState(pipelineInit);
 
+        {
+            // The chunks of the quadtree are indexed triangle lists, same layout and pixel shader
+            graphics::ShaderInit chunkShaderInit{ graphics::ShaderType::VERTEX, "mainChunk", Heightmap_vert::getSource, Heightmap_vert::getSourceFilename(), include };
+            graphics::ShaderPointer chunkShader = device->createShader(chunkShaderInit);
+
+            graphics::ProgramInit chunkProgramInit{ chunkShader, pixelShader };
+            graphics::ShaderPointer chunkProgramShader = device->createProgram(chunkProgramInit);
+
+            graphics::GraphicsPipelineStateInit chunkPipelineInit{
+                        chunkProgramShader,
+                        rootDescriptorLayout,
+                        StreamLayout(),
+                        graphics::PrimitiveTopology::TRIANGLE,
+                        RasterizerState(),
+                        {true}, // enable depth
+                        BlendState()
+            };
+            _HeightmapChunkPipeline = device->createGraphicsPipelineState(chunkPipelineInit);
+
+            // One index buffer holding the triangle lists of the 16 stitch variants back to back
+            std::vector<uint32_t> indices;
+            std::vector<uint32_t> stitchIndices;
+            _chunkIndexOffsets.assign(1, 0);
+            for (uint32_t s = 0; s < 16; ++s) {
+                TerrainQuadtree::chunkIndices((uint8_t) s, stitchIndices);
+                indices.insert(indices.end(), stitchIndices.begin(), stitchIndices.end());
+                _chunkIndexOffsets.push_back((uint32_t) indices.size());
+            }
+
+            graphics::BufferInit indexBufferInit{};
+            indexBufferInit.usage = graphics::ResourceUsage::INDEX_BUFFER;
+            indexBufferInit.hostVisible = true;
+            indexBufferInit.bufferSize = indices.size() * sizeof(uint32_t);
+            _chunkIndexBuffer = device->createBuffer(indexBufferInit);
+            memcpy(_chunkIndexBuffer->_cpuMappedAddress, indices.data(), indexBufferInit.bufferSize);
+        }
+
 
         {
             // Let's describe the Compute pipeline Descriptors layout
@@ -173,6 +228,13 @@ namespace graphics
              memcpy(heightmapDraw._heightBuffer->_cpuMappedAddress, heightmap.heights.data(), hbresourceBufferInit.bufferSize);
         }
 
+        // The heights known on the cpu are drawn with the chunks of the quadtree,
+        // the heights computed on the gpu (ocean) keep the full grid
+        if (heightmap.heights.size() >= numHeights) {
+            heightmapDraw._quadtree = std::make_shared<TerrainQuadtree>();
+            heightmapDraw._quadtree->build(heightmap.heights.data(), heightmap.map_width, heightmap.map_height, heightmap.map_spacing, HEIGHTMAP_HEIGHT_SCALE);
+        }
+
         allocateDrawcallObject(device, heightmapDraw);
 
         return heightmapDraw;
@@ -210,9 +272,13 @@ namespace graphics
         device->updateDescriptorSet(descriptorSet, descriptorObjects);
         auto compute_pipeline = this->_computePipeline;
         auto pipeline = this->_HeightmapPipeline;
+        auto chunk_pipeline = this->_HeightmapChunkPipeline;
+        auto chunk_indices = this->_chunkIndexBuffer;
+        auto chunk_offsets = this->_chunkIndexOffsets;
 
         // And now a render callback where we describe the rendering sequence
-        draw._drawcall = [draw, doCompute, compDescriptorSet, compute_pipeline, descriptorSet, pipeline](const NodeID node, RenderArgs& args) {
+        draw._drawcall = [draw, doCompute, compDescriptorSet, compute_pipeline, descriptorSet, pipeline,
+                          chunk_pipeline, chunk_indices, chunk_offsets](const NodeID node, RenderArgs& args) {
   
             static uint32_t frameNum = 0;
             frameNum++;
@@ -230,6 +296,29 @@ namespace graphics
             }
 
             odata.nodeID = node;
+
+            const auto& quadtree = draw.getQuadtree();
+            if (quadtree && draw._uniforms->chunked && args.camera && args.scene) {
+                // Select the chunks for the camera seen from the terrain space
+                auto view = args.camera->getView();
+                view._mat = core::mul(core::inverse(args.scene->_nodes.getNodeTransform(node).world), view._mat);
+                TerrainQuadtree::Chunks chunks;
+                quadtree->select(view, args.camera->getProjection(), args.camera->getViewportHeight(), draw._uniforms->maxPixelError, chunks);
+
+                args.batch->bindPipeline(chunk_pipeline);
+                args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, args.viewPassDescriptorSet);
+                args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, descriptorSet);
+                args.batch->bindIndexBuffer(chunk_indices);
+                for (const auto& chunk : chunks) {
+                    odata.chunk_level = chunk.level;
+                    odata.chunk_x = chunk.x;
+                    odata.chunk_y = chunk.y;
+                    args.batch->bindPushUniform(graphics::PipelineType::GRAPHICS, 0, sizeof(HeightmapObjectData), (const uint8_t*)&odata);
+                    args.batch->drawIndexed(chunk_offsets[chunk.stitch + 1] - chunk_offsets[chunk.stitch], chunk_offsets[chunk.stitch]);
+                }
+                return;
+            }
+
             args.batch->bindPipeline(pipeline);
             args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, args.viewPassDescriptorSet);
             args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, descriptorSet);
@@ -28,10 +28,12 @@
 
 #include <memory>
 #include <core/math/Math3D.h>
+#include <document/Heightmap.h>
 #include "dllmain.h"
 
 #include <render/Scene.h>
 #include <render/Draw.h>
+#include <render/TerrainLod.h>
 
 namespace graphics {
     class Device;
@@ -68,9 +70,15 @@ namespace graphics {
  
         std::vector<float> heights;
 
+        // Map and mesh over the samples of a heightmap document, its elevations decoded
+        static Heightmap createFromDocument(const document::Heightmap& heightmap);
     };
 
     struct VISUALIZATION_API HeightmapDrawUniforms {
+        // Draw the chunks of the terrain quadtree picked for the camera, else the full grid of the mesh
+        bool chunked{ true };
+        // A chunk is refined while its error covers more than maxPixelError pixels on screen
+        float maxPixelError{ 2.0f };
     };
     using HeightmapDrawUniformsPointer = std::shared_ptr<HeightmapDrawUniforms>;
 
@@ -90,6 +98,12 @@ namespace graphics {
         HeightmapDrawUniformsPointer _sharedUniforms;
         graphics::PipelineStatePointer _HeightmapPipeline;
 
+        // The chunks are triangle lists indexed in the shared index buffer,
+        // the indices of the stitch variant s are in [_chunkIndexOffsets[s], _chunkIndexOffsets[s + 1])
+        graphics::PipelineStatePointer _HeightmapChunkPipeline;
+        graphics::BufferPointer _chunkIndexBuffer;
+        std::vector<uint32_t> _chunkIndexOffsets;
+
         graphics::PipelineStatePointer _computePipeline;
 
         // Cache the shaders and pipeline to share them accross multiple instances of drawcalls
@@ -110,12 +124,16 @@ namespace graphics {
 
         graphics::BufferPointer getHeightBuffer() const { return _heightBuffer; }
 
+        // The chunked LOD quadtree over the map, only when the heights are known on the cpu
+        const TerrainQuadtreePointer& getQuadtree() const { return _quadtree; }
+
         const Heightmap& getDesc() const { return _heightmap; }
 
     protected:
         friend class HeightmapDrawFactory;
         Heightmap _heightmap;
         graphics::BufferPointer _heightBuffer;
+        TerrainQuadtreePointer _quadtree;
         HeightmapDrawUniformsPointer _uniforms;
         DrawObjectCallback _drawcall;
 
@@ -9,6 +9,9 @@ cbuffer UniformBlock1 : register(b1) {
     int  _mesh_width;
     int  _mesh_height;
     float _mesh_spacing;
+    int  _chunk_level;
+    int  _chunk_x;
+    int  _chunk_y;
 }
 
 
@@ -189,3 +192,34 @@ VertexShaderOutput main(uint ivid : SV_VertexID)
     return OUT;
 }
 
+// Chunk of the terrain quadtree, indexed grid of (CHUNK_CELLS + 1)^2 vertices,
+// the cells of a chunk at level L span 2^L samples of the map
+#define CHUNK_CELLS 32
+
+VertexShaderOutput mainChunk(uint ivid : SV_VertexID)
+{
+    VertexShaderOutput OUT;
+
+    int2 ij = int2(ivid % (CHUNK_CELLS + 1), ivid / (CHUNK_CELLS + 1));
+    int step = 1 << _chunk_level;
+    int2 sample = min(int2(_chunk_x, _chunk_y) * CHUNK_CELLS * step + ij * step, int2(_map_width - 1, _map_height - 1));
+
+    float3 position = float3((sample.x - 0.5 * _map_width) * _map_spacing, fetchHeight(sample), (sample.y - 0.5 * _map_height) * _map_spacing);
+    float2 uv = float2(sample) / float2(_map_width, _map_height);
+    float3 normal = getSmoothNormal(uv);
+
+    float3 color = float3(uv.x, 0.0, uv.y);
+
+    Transform _model = node_getWorldTransform(_nodeID);
+
+    position = worldFromObjectSpace(_model, position);
+    float3 eyePosition = eyeFromWorldSpace(cam_view(), position);
+    float4 clipPos = clipFromEyeSpace(cam_projection(), eyePosition);
+
+    OUT.Position = clipPos;
+    OUT.WPos = position;
+    OUT.Color = float4(color, 1.0f);
+    OUT.Normal = normal;
+
+    return OUT;
+}
@@ -25,8 +25,18 @@
 // SOFTWARE.
 //
 #include "ModelDraw.h"
+#include "ModelDrawCache.h"
 
 #include "core/stl/Hash.h"
+#include "core/mesh/Weld.h"
+#include "core/mesh/Adjacency.h"
+#include "core/mesh/VertexCache.h"
+#include "core/mesh/Meshlet.h"
+#include "core/mesh/Skinning.h"
+#include "core/Job.h"
+
+#include <algorithm>
+#include <chrono>
 #include "gpu/Device.h"
 #include "gpu/Batch.h"
 #include "gpu/Shader.h"
@@ -34,6 +44,7 @@
 #include "gpu/Pipeline.h"
 #include "gpu/Descriptor.h"
 #include "gpu/Swapchain.h"
+#include "gpu/StreamingQueue.h"
 
 #include "render/Renderer.h"
 #include "render/Camera.h"
@@ -80,6 +91,67 @@ namespace graphics
         return displayedColor | (lightShading ? 0x80 : 0);
     }
 
+    bool ModelDraw::isGeometryResident() const {
+        return !_geometryResidency || _geometryResidency->isResident();
+    }
+
+    bool ModelDraw::isTextureResident() const {
+        return !_textureResidency || _textureResidency->isResident();
+    }
+
+    uint32_t ModelDraw::cullPartMeshlets(uint32_t part, const core::mat4x3& transform, const core::View& view, const core::Projection& projection, std::vector<uint32_t>& visible) const {
+        if (part >= _partMeshlets.size()) {
+            return 0;
+        }
+        core::vec4 planes[6];
+        core::frustum_planes(view, projection, planes);
+        const auto& range = _partMeshlets[part];
+        return core::mesh_cullMeshlets(_meshletBounds.data(), range.meshletOffset, range.numMeshlets, transform, planes, view.eye(), visible);
+    }
+
+    void ModelDraw::evalSkinMatrices(uint32_t skin, uint32_t meshNode, const NodeStore& nodes, NodeID modelNode,
+        std::vector<core::mat4x3>& jointMatrices, std::vector<core::mat4x3>& skinMatrices) const {
+        const auto& s = _skins[skin];
+        jointMatrices.resize(s.numJoints);
+        skinMatrices.resize(s.numJoints);
+
+        auto meshWorldInv = core::inverse(nodes.getNodeTransform(modelNode + 1 + meshNode).world);
+        for (uint32_t j = 0; j < s.numJoints; ++j) {
+            const auto& binding = _skinJointBindings[s.jointOffset + j];
+            const auto& jointWorld = nodes.getNodeTransform(modelNode + 1 + binding.bone.x).world;
+            jointMatrices[j] = core::mul(meshWorldInv, jointWorld);
+            skinMatrices[j] = core::mul(jointMatrices[j], binding.invBindingPose);
+        }
+    }
+
+    void ModelDraw::skinPart(uint32_t partSkin, const NodeStore& nodes, NodeID modelNode, core::vec3_stream& positions) const {
+        const auto& ps = _partSkins[partSkin];
+        std::vector<core::mat4x3> jointMatrices, skinMatrices;
+        evalSkinMatrices(ps.skin, ps.node, nodes, modelNode, jointMatrices, skinMatrices);
+        core::stream_skin(skinMatrices.data(), ps.influences, ps.bindPositions, positions);
+    }
+
+    void ModelDraw::evalPartBounds(const NodeStore& nodes, NodeID modelNode, std::vector<core::aabox3>& partBounds) const {
+        partBounds = _partAABBs;
+        std::vector<core::mat4x3> jointMatrices, skinMatrices;
+        for (const auto& ps : _partSkins) {
+            evalSkinMatrices(ps.skin, ps.node, nodes, modelNode, jointMatrices, skinMatrices);
+            partBounds[ps.part] = core::skin_bound(ps.jointBounds, jointMatrices.data());
+        }
+    }
+
+    void ModelDraw::updateSkinnedBounds(ItemStore& items, const NodeStore& nodes) const {
+        std::vector<core::aabox3> partBounds;
+        for (const auto& instance : _skinnedInstances) {
+            evalPartBounds(nodes, instance.modelNode, partBounds);
+            for (uint32_t k = 0; k < _partSkins.size(); ++k) {
+                if (instance.partSkinItems[k] != INVALID_ITEM_ID) {
+                    items.setLocalBound(instance.partSkinItems[k], partBounds[_partSkins[k].part]);
+                }
+            }
+        }
+    }
+
     // Custom data uniforms
     struct ModelObjectData {
         uint32_t nodeID{0};
@@ -88,6 +160,7 @@ namespace graphics
         uint32_t numParts{ 0 };
         uint32_t numMaterials{ 0 };
         uint32_t drawMode{ 0 };
+        int32_t firstInstance{ -1 }; // the nodes of the instances are in the viewport instance buffer from there
     };
 
     void ModelDrawFactory::allocateGPUShared(const graphics::DevicePointer& device) {
@@ -159,36 +232,256 @@ namespace graphics
         _pipeline = device->createGraphicsPipelineState(pipelineInit);
     }
 
-    size_t hashV(ModelVertex& v) {
-            core::hash<float, float, float, int> hasher;
-            return hasher(v.px, v.py, v.pz, v.n);
+    // Strided view on the elements of a glTF accessor
+    struct AccessorView {
+        const uint8_t* data{ nullptr };
+        uint32_t stride{ 0 };
+        uint32_t count{ 0 };
+        uint32_t componentSize{ 0 };
+        uint32_t numComponents{ 0 };
+        document::model::ComponentType componentType{ document::model::ComponentType::Float };
+
+        AccessorView() {}
+        AccessorView(const document::Model& model, uint32_t accessorId) {
+            if (accessorId >= model._accessors.size()) return;
+            const auto& access = model._accessors[accessorId];
+            if (access._bufferView >= model._bufferViews.size()) return;
+            const auto& view = model._bufferViews[access._bufferView];
+            if (view._buffer >= model._buffers.size()) return;
+            const auto& buffer = model._buffers[view._buffer];
+            uint32_t elementSize = document::model::componentTypeSize(access._componentType) * document::model::elementTypeComponentCount(access._elementType);
+            uint32_t elementStride = (view._byteStride ? view._byteStride : elementSize);
+            uint64_t begin = view._byteOffset + access._byteOffset;
+            uint64_t end = begin + (access._elementCount ? uint64_t(elementStride) * (access._elementCount - 1) + elementSize : 0);
+            // A buffer which failed to load (missing bin file) is empty, the view stays invalid then
+            if (end > buffer._bytes.size()) return;
+            componentType = access._componentType;
+            componentSize = document::model::componentTypeSize(access._componentType);
+            numComponents = document::model::elementTypeComponentCount(access._elementType);
+            stride = elementStride;
+            count = access._elementCount;
+            data = buffer._bytes.data() + begin;
+        }
+
+        bool isValid() const { return data != nullptr; }
+        template <typename T> const T* element(uint32_t i) const { return reinterpret_cast<const T*>(data + size_t(stride) * i); }
+    };
+
+    // The welded vertex, position + normal and attributes compared as one 32 bytes key
+    struct WeldVertex {
+        ModelVertex v;
+        ModelVertexAttrib a;
+    };
+
+    template <typename C> void decodeIndices(const AccessorView& view, std::vector<ModelIndex>& indices) {
+        indices.resize(view.count);
+        for (uint32_t i = 0; i < view.count; ++i) {
+            indices[i] = *view.element<C>(i);
+        }
+    }
+
+    template <typename C> void decodeTexcoords(const AccessorView& view, float scale, std::vector<WeldVertex>& vertices) {
+        for (uint32_t i = 0; i < (uint32_t) vertices.size(); ++i) {
+            const C* t = view.element<C>(i);
+            vertices[i].a.u = t[0] * scale;
+            vertices[i].a.v = t[1] * scale;
+        }
     }
-    size_t hashA(ModelVertexAttrib& a) {
-            return  *reinterpret_cast<uint64_t*>((uint64_t*)&a);
+
+    template <typename C> void decodeJoints(const AccessorView& view, std::vector<core::ivec4>& joints) {
+        joints.resize(view.count);
+        for (uint32_t i = 0; i < view.count; ++i) {
+            const C* j = view.element<C>(i);
+            joints[i] = core::ivec4(j[0], j[1], j[2], j[3]);
+        }
+    }
+
+    template <typename C> void decodeWeights(const AccessorView& view, float scale, std::vector<core::vec4>& weights) {
+        weights.resize(view.count);
+        for (uint32_t i = 0; i < view.count; ++i) {
+            const C* w = view.element<C>(i);
+            weights[i] = core::vec4(w[0] * scale, w[1] * scale, w[2] * scale, w[3] * scale);
+        }
+    }
+
+    // Decode the vertices and the index stream of a primitive and weld them
+    // Vertices are decoded once per source vertex with typed strided loops.
+    // A primitive with an attribute shorter than its positions or an index out of them is rejected,
+    // vertices and indices are left empty and false is returned.
+    bool weldPrimitive(const document::Model& model, const document::model::Primitive& p, std::vector<WeldVertex>& vertices, std::vector<ModelIndex>& indices) {
+        using document::model::ComponentType;
+
+        AccessorView positions(model, p._positions);
+        uint32_t numSourceVertices = positions.count;
+        if (positions.isValid() && (positions.componentType != ComponentType::Float || positions.numComponents < 3)) {
+            return false;
+        }
+
+        AccessorView normals(model, p._normals);
+        AccessorView texcoords(model, p._texcoords);
+        AccessorView weightView(model, p._weights);
+        AccessorView jointView(model, p._joints);
+        // An attribute referenced by the primitive must be readable for every position
+        auto covers = [numSourceVertices](const AccessorView& view, uint32_t accessorId, uint32_t minComponents) {
+            if (accessorId == document::model::INVALID_INDEX) return true;
+            return view.isValid() && view.count >= numSourceVertices && view.numComponents >= minComponents;
+        };
+        auto normalizedOrFloat = [](const AccessorView& view) {
+            return !view.isValid() || view.componentType == ComponentType::UInt8 || view.componentType == ComponentType::UInt16 || view.componentType == ComponentType::Float;
+        };
+        if (!covers(normals, p._normals, 3) || !covers(texcoords, p._texcoords, 2) || !covers(weightView, p._weights, 4) || !covers(jointView, p._joints, 4)
+            || (normals.isValid() && normals.componentType != ComponentType::Float)
+            || !normalizedOrFloat(texcoords) || !normalizedOrFloat(weightView)) {
+            return false;
+        }
+
+        std::vector<ModelIndex> sourceIndices;
+        AccessorView indexView(model, p._indices);
+        if (indexView.isValid()) {
+            switch (indexView.componentSize) {
+            case 1: decodeIndices<uint8_t>(indexView, sourceIndices); break;
+            case 2: decodeIndices<uint16_t>(indexView, sourceIndices); break;
+            default: decodeIndices<uint32_t>(indexView, sourceIndices); break;
+            }
+            for (auto index : sourceIndices) {
+                if (index >= numSourceVertices) {
+                    return false;
+                }
+            }
+        } else {
+            sourceIndices.resize(numSourceVertices);
+            for (uint32_t i = 0; i < numSourceVertices; ++i) {
+                sourceIndices[i] = i;
+            }
+        }
+
+        std::vector<WeldVertex> sourceVertices(numSourceVertices, WeldVertex{});
+        for (uint32_t i = 0; i < numSourceVertices; ++i) {
+            const float* pos = positions.element<float>(i);
+            sourceVertices[i].v.px = pos[0];
+            sourceVertices[i].v.py = pos[1];
+            sourceVertices[i].v.pz = pos[2];
+        }
+
+        if (normals.isValid()) {
+            for (uint32_t i = 0; i < numSourceVertices; ++i) {
+                const float* nor = normals.element<float>(i);
+                sourceVertices[i].v.n = core::packNormal32I(core::vec3(nor[0], nor[1], nor[2]));
+            }
+        }
+
+        // Normalized integer texcoords are allowed as well
+        if (texcoords.isValid()) {
+            switch (texcoords.componentType) {
+            case ComponentType::UInt8: decodeTexcoords<uint8_t>(texcoords, 1.0f / 255.0f, sourceVertices); break;
+            case ComponentType::UInt16: decodeTexcoords<uint16_t>(texcoords, 1.0f / 65535.0f, sourceVertices); break;
+            default: decodeTexcoords<float>(texcoords, 1.0f, sourceVertices); break;
+            }
+        }
+
+        if (weightView.isValid() && jointView.isValid()) {
+            std::vector<core::vec4> weights;
+            switch (weightView.componentType) {
+            case ComponentType::UInt8: decodeWeights<uint8_t>(weightView, 1.0f / 255.0f, weights); break;
+            case ComponentType::UInt16: decodeWeights<uint16_t>(weightView, 1.0f / 65535.0f, weights); break;
+            default: decodeWeights<float>(weightView, 1.0f, weights); break;
+            }
+            std::vector<core::ivec4> joints;
+            switch (jointView.componentSize) {
+            case 1: decodeJoints<uint8_t>(jointView, joints); break;
+            case 2: decodeJoints<uint16_t>(jointView, joints); break;
+            default: decodeJoints<uint32_t>(jointView, joints); break;
+            }
+
+            for (uint32_t i = 0; i < numSourceVertices; ++i) {
+                const auto& vw = weights[i];
+                const auto& vj = joints[i];
+                float sumWeight = core::dot(vw, 1.0f);
+                uint32_t viw = 0;
+                uint32_t vij = 0;
+                if (sumWeight > 0.0f) {
+                    for (int c = 0; c < 4; ++c) {
+                        uint32_t iw = (0xff & (uint32_t)(255 * vw[c]));
+                        uint32_t ij = (0xff & (uint32_t)(vj[c]));
+                        viw = viw | ((iw) << (c * 8));
+                        vij = vij | ((ij) << (c * 8));
+                    }
+                }
+                sourceVertices[i].a.sw = viw;
+                sourceVertices[i].a.sj = vij;
+            }
+        }
+
+        core::WeldResult welded;
+        core::weld(sourceVertices.data(), numSourceVertices, sourceIndices.data(), (uint32_t) sourceIndices.size(), welded);
+
+        vertices.resize(welded.vertices.size());
+        for (uint32_t u = 0; u < welded.vertices.size(); ++u) {
+            vertices[u] = sourceVertices[welded.vertices[u]];
+        }
+        indices = std::move(welded.indices);
+        return true;
     }
 
     graphics::ModelDraw* ModelDrawFactory::createModel(const graphics::DevicePointer& device, const document::ModelPointer& model) {
 
         auto modelDraw = new graphics::ModelDraw();
 
-        modelDraw->_name = model->_name;
+        std::vector<document::Image> images;
+        buildModel(*model, *modelDraw, images);
+        allocateModelGPU(device, *modelDraw, images);
+
+        return modelDraw;
+    }
+
+    graphics::ModelDraw* ModelDrawFactory::createModelFromFile(const graphics::DevicePointer& device, const std::string& filename) {
+        auto sourceHash = ModelDrawCache::hashSource(filename);
+        if (!sourceHash) {
+            picoLog("model file " + filename + " can't be opened");
+            return nullptr;
+        }
+
+        auto modelDraw = new graphics::ModelDraw();
+
+        std::vector<document::Image> images;
+        auto cacheFilename = filename + ModelDrawCache::EXTENSION;
+        if (!ModelDrawCache::load(cacheFilename, sourceHash, *modelDraw, images)) {
+            auto model = document::model::Model::createFromGLTF(filename);
+            if (!model) {
+                delete modelDraw;
+                return nullptr;
+            }
+            buildModel(*model, *modelDraw, images);
+            if (!ModelDrawCache::save(cacheFilename, sourceHash, *modelDraw, images)) {
+                picoLog("model cache file " + cacheFilename + " can't be written");
+            }
+        }
+        allocateModelGPU(device, *modelDraw, images);
+
+        return modelDraw;
+    }
 
-        if (model->_scenes.size())
-            modelDraw->_localRootNodes = model->_scenes[0]._nodes;
+    void ModelDrawFactory::buildModel(document::Model& model, graphics::ModelDraw& draw, std::vector<document::Image>& images) {
+        auto modelDraw = &draw;
+
+        modelDraw->_name = model._name;
+
+        if (model._scenes.size())
+            modelDraw->_localRootNodes = model._scenes[0]._nodes;
 
         // Define the local nodes used by the model with the original transforms and the parents
-        modelDraw->_localNodeTransforms.reserve(model->_nodes.size());
-        modelDraw->_localNodeParents.reserve(model->_nodes.size());
-        modelDraw->_localNodeNames.reserve(model->_nodes.size());
-        for (const auto& n : model->_nodes) {
+        modelDraw->_localNodeTransforms.reserve(model._nodes.size());
+        modelDraw->_localNodeParents.reserve(model._nodes.size());
+        modelDraw->_localNodeNames.reserve(model._nodes.size());
+        for (const auto& n : model._nodes) {
             modelDraw->_localNodeTransforms.emplace_back(n._transform);
             modelDraw->_localNodeParents.emplace_back(n._parent);
             modelDraw->_localNodeNames.emplace_back(n._name);
         }
 
         // Define the items
-        modelDraw->_localItems.reserve(model->_items.size());
-        for (const auto& si : model->_items) {
+        modelDraw->_localItems.reserve(model._items.size());
+        for (const auto& si : model._items) {
             modelDraw->_localItems.emplace_back(ModelItem{
                 .node = si._node,
                 .shape = si._mesh,
@@ -197,14 +490,14 @@ namespace graphics
         }
 
         // Define the shapes
-        modelDraw->_shapes.reserve(model->_meshes.size());
-        for (const auto& m : model->_meshes) {
+        modelDraw->_shapes.reserve(model._meshes.size());
+        for (const auto& m : model._meshes) {
             modelDraw->_shapes.emplace_back(ModelShape{ m._primitiveStart, m._primitiveCount });
         }
 
         // Define the cameras
-        modelDraw->_localCameras.reserve(model->_cameras.size());
-        for (const auto& cam : model->_cameras) {
+        modelDraw->_localCameras.reserve(model._cameras.size());
+        for (const auto& cam : model._cameras) {
             modelDraw->_localCameras.emplace_back(ModelCamera{ cam._projection });
         }
 
@@ -217,322 +510,356 @@ namespace graphics
         std::vector<core::aabox3> partAABBs;
         core::aabox3 bound;
 
-        std::vector<uint32_t> mainVertexIndices;
-
-        using LookupAttribArray = std::vector<std::pair<size_t, uint32_t>>;
-        using LookupVertex = struct { uint32_t index; LookupAttribArray attribs; };
-        using LookupVertexIndexTable = std::unordered_map<size_t, LookupVertex>;
-        LookupVertexIndexTable indexedVertexMap;
-
         std::vector<ModelEdge> edge_buffer;
         std::vector<ModelFace> face_buffer;
 
-        struct LookupEdge { uint32_t index; uint32_t t0; uint32_t t1{ (uint32_t) -1 }; };
-        using LookupEdgeIndexedTable = std::unordered_map<size_t, LookupEdge >;
-        LookupEdgeIndexedTable indexedEdgeMap;
+        std::vector<ModelPartMeshlets> partMeshlets;
+        core::MeshletSet meshlets;
+
+        auto weldStart = std::chrono::high_resolution_clock::now();
+
+        // Decode and weld every primitive on its own, in parallel.
+        // Then reorder its triangles for the post transform vertex cache and its vertices in fetch order.
+        uint32_t numPrimitives = (uint32_t) model._primitives.size();
+        std::vector<std::vector<WeldVertex>> primitiveVertices(numPrimitives);
+        std::vector<std::vector<ModelIndex>> primitiveIndices(numPrimitives);
+        std::vector<core::VertexCacheStats> primitiveCacheStats(2 * numPrimitives);
+        std::vector<uint8_t> primitiveWelded(numPrimitives, 0);
+        core::ThreadPool::shared().parallel_for(numPrimitives, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t pi = begin; pi < end; ++pi) {
+                auto& vertices = primitiveVertices[pi];
+                auto& indices = primitiveIndices[pi];
+                primitiveWelded[pi] = weldPrimitive(model, model._primitives[pi], vertices, indices);
+
+                uint32_t numIndices = (uint32_t) indices.size();
+                uint32_t numVertices = (uint32_t) vertices.size();
+                primitiveCacheStats[2 * pi] = core::mesh_analyzeVertexCache(indices.data(), numIndices, numVertices);
+                core::mesh_optimizeVertexCache(indices.data(), indices.data(), numIndices, numVertices);
+                std::vector<uint32_t> remap;
+                uint32_t numRemapped = core::mesh_optimizeVertexFetchRemap(indices.data(), numIndices, numVertices, remap);
+                core::mesh_remapVertices(vertices, remap, numRemapped);
+                primitiveCacheStats[2 * pi + 1] = core::mesh_analyzeVertexCache(indices.data(), numIndices, numRemapped);
+            }
+        });
+
+        // Then merge: weld again the unique vertices of all the primitives in primitive order.
+        // Vertices shared across primitives stay shared, and the vertex order is the order of
+        // first reference, the same as welding everything sequentially: the fetch order of
+        // each primitive is kept in the merged vertex buffer.
+        std::vector<uint32_t> primitiveVertexOffsets(numPrimitives, 0);
+        std::vector<WeldVertex> allVertices;
+        for (uint32_t pi = 0; pi < numPrimitives; ++pi) {
+            primitiveVertexOffsets[pi] = (uint32_t) allVertices.size();
+            allVertices.insert(allVertices.end(), primitiveVertices[pi].begin(), primitiveVertices[pi].end());
+            primitiveVertices[pi].clear();
+            primitiveVertices[pi].shrink_to_fit();
+        }
+        core::WeldResult merged;
+        core::weld(allVertices.data(), (uint32_t) allVertices.size(), merged);
+
+        vertex_buffer.resize(merged.vertices.size());
+        vertex_attrib_buffer.resize(merged.vertices.size());
+        for (uint32_t u = 0; u < merged.vertices.size(); ++u) {
+            vertex_buffer[u] = allVertices[merged.vertices[u]].v;
+            vertex_attrib_buffer[u] = allVertices[merged.vertices[u]].a;
+        }
 
+        // The main vertex of a vertex is the first vertex with the same position and normal,
+        // vertices only differing by their attributes share the same main vertex
+        core::WeldResult mainWeld;
+        core::weld(vertex_buffer.data(), (uint32_t) vertex_buffer.size(), mainWeld);
+        std::vector<uint32_t> mainVertexIndices(vertex_buffer.size());
+        for (uint32_t u = 0; u < vertex_buffer.size(); ++u) {
+            mainVertexIndices[u] = mainWeld.vertices[mainWeld.indices[u]];
+        }
 
-        bool first = true;
-        for (const auto& p : model->_primitives) {
-            // Index accessor
-            std::vector<ModelIndex> partIndices;
-            if (p._indices != document::model::INVALID_INDEX) {
-                const auto& indexAccess = model->_accessors[p._indices];
-                const auto& indexView = model->_bufferViews[indexAccess._bufferView];
-                const auto& indexBuffer = model->_buffers[indexView._buffer];
+        auto weldDuration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - weldStart);
+        picoLogf("ModelDrawFactory::createModel {}: welded {} primitives into {} vertices in {:.2f} ms", model._name, numPrimitives, vertex_buffer.size(), weldDuration.count());
 
-                auto indexStride = (indexView._byteStride ? indexView._byteStride : document::model::componentTypeSize(indexAccess._componentType));
-                uint32_t indexMask = document::model::componentTypeInt32Mask(indexAccess._componentType);
-                for (uint32_t i = 0; i < indexAccess._elementCount; ++i) {
-                    auto index = (*(uint32_t*)(indexBuffer._bytes.data() + indexView._byteOffset + indexAccess._byteOffset + indexStride * i)) & indexMask;
-                    partIndices.emplace_back(index);
-                }
-            }
-            else {
-                auto indexCount = model->_accessors[p._positions]._elementCount;
-                partIndices.reserve(indexCount);
-                for (uint32_t i = 0; i < indexCount; ++i) {
-                   partIndices.emplace_back(i);
-                }
-            }
+        core::VertexCacheStats sourceCache, optimizedCache;
+        auto accumulate = [](core::VertexCacheStats& total, const core::VertexCacheStats& stats) {
+            total.numTriangles += stats.numTriangles;
+            total.numVertices += stats.numVertices;
+            total.numTransformed += stats.numTransformed;
+        };
+        for (uint32_t pi = 0; pi < numPrimitives; ++pi) {
+            accumulate(sourceCache, primitiveCacheStats[2 * pi]);
+            accumulate(optimizedCache, primitiveCacheStats[2 * pi + 1]);
+        }
+        picoLogf("ModelDrawFactory::createModel {}: vertex cache ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", model._name,
+            sourceCache.acmr(), optimizedCache.acmr(), sourceCache.atvr(), optimizedCache.atvr());
+
+        // A rejected primitive stays as an empty part, the part indices of the meshes are kept
+        auto numRejected = std::count(primitiveWelded.begin(), primitiveWelded.end(), 0);
+        if (numRejected) {
+            auto firstRejected = std::find(primitiveWelded.begin(), primitiveWelded.end(), 0) - primitiveWelded.begin();
+            picoLogf("ModelDrawFactory::createModel {}: {} primitives rejected from primitive {}, an attribute is not readable for every position or an index is out of range", model._name, numRejected, firstRejected);
+        }
 
-            // Position accessor
-            const auto& posAccess = model->_accessors[p._positions];
-            const auto& posView = model->_bufferViews[posAccess._bufferView];
-            const auto& posBuffer = model->_buffers[posView._buffer];
-            auto posStride = (posView._byteStride ? posView._byteStride : document::model::elementTypeComponentCount(posAccess._elementType) * sizeof(float));
-            std::function<core::vec3(uint32_t)> positionGetter = [&](uint32_t index) {
-                auto pos = (float*)(posBuffer._bytes.data() + posView._byteOffset + posAccess._byteOffset + posStride * index);
-                return core::vec3(*pos, *(pos + 1), *(pos + 2));
-            };
+        bool first = true;
+        for (uint32_t pi = 0; pi < numPrimitives; ++pi) {
+            const auto& p = model._primitives[pi];
 
-            // Normal accessor
-            std::function<uint32_t(uint32_t)> normalGetter = [](uint32_t index) { return 0; };
-            if (p._normals != document::model::INVALID_INDEX) {
-                const auto& norAccess = model->_accessors[p._normals];
-                const auto& norView = model->_bufferViews[norAccess._bufferView];
-                const auto& norBuffer = model->_buffers[norView._buffer];
-                auto norStride = (norView._byteStride ? norView._byteStride : document::model::elementTypeComponentCount(norAccess._elementType) * sizeof(float));
-                normalGetter = [&](uint32_t index) {
-                    auto nor = (float*)(norBuffer._bytes.data() + norView._byteOffset + norAccess._byteOffset + norStride * index);
-                    auto normal = core::vec3(*nor, *(nor + 1), *(nor + 2));
-                    return core::packNormal32I(normal);
-                };
+            // Welded indices of the primitive in the merged vertex buffer
+            std::vector<ModelIndex> partIndices = std::move(primitiveIndices[pi]);
+            for (auto& index : partIndices) {
+                index = merged.indices[primitiveVertexOffsets[pi] + index];
             }
 
-            // Texcoord accessor
-            std::function<core::vec2(uint32_t)> texcoordGetter = [](uint32_t index) { return core::vec2(); };
-            if (p._texcoords != document::model::INVALID_INDEX) {
-                const auto& texcoordAccess = model->_accessors[p._texcoords];
-                const auto& texcoordView = model->_bufferViews[texcoordAccess._bufferView];
-                const auto& texcoordBuffer = model->_buffers[texcoordView._buffer];
-                auto texcoordStride = (texcoordView._byteStride ? texcoordView._byteStride : document::model::elementTypeComponentCount(texcoordAccess._elementType) * sizeof(float));
-                texcoordGetter = [&](uint32_t index) {
-                    auto texcoord = (float*)(texcoordBuffer._bytes.data() + texcoordView._byteOffset + texcoordAccess._byteOffset + texcoordStride * index);
-                    return core::vec2(*texcoord, *(texcoord + 1));
-                };
+            // Record edge and face, the face edge indices point in the global edge buffer
+            core::MeshAdjacency adjacency;
+            core::mesh_buildAdjacency(partIndices.data(), (uint32_t) partIndices.size() / 3, mainVertexIndices.data(), adjacency);
+            if (adjacency.numNonManifoldEdges) {
+                picoLogf("ModelDrawFactory::createModel {}: primitive {} has {} non-manifold edges", model._name, pi, adjacency.numNonManifoldEdges);
+            }
+            // Split the part in meshlets, the vertex cache order keeps them compact
+            ModelPartMeshlets partMeshletRange{ meshlets.size(), 0 };
+            partMeshletRange.numMeshlets = core::mesh_buildMeshlets(partIndices.data(), (uint32_t) partIndices.size(), (const float*) vertex_buffer.data(), sizeof(ModelVertex), meshlets);
+            partMeshlets.emplace_back(partMeshletRange);
+
+            int32_t partEdgeOffset = (int32_t) edge_buffer.size();
+            for (auto& f : adjacency.faces) {
+                f = core::ivec4(f.x + partEdgeOffset, f.y + partEdgeOffset, f.z + partEdgeOffset, 0);
             }
 
-            // Skin weight and joint accessor
-            std::function<core::ivec2(uint32_t)> skinWeightJointGetter = [](uint32_t index) { return core::ivec2(); };
-            if ((p._weights != document::model::INVALID_INDEX) && (p._joints != document::model::INVALID_INDEX)) {
-                const auto& weightAccess = model->_accessors[p._weights];
-                const auto& weightView = model->_bufferViews[weightAccess._bufferView];
-                const auto& weightBuffer = model->_buffers[weightView._buffer];
-                auto weightComponentSize = document::model::componentTypeSize(weightAccess._componentType);
-                auto weightElementCount = document::model::elementTypeComponentCount(weightAccess._elementType);
-                auto weightStride = (weightView._byteStride ? weightView._byteStride : weightComponentSize * weightElementCount);
-
-                const auto& jointAccess = model->_accessors[p._joints];
-                const auto& jointView = model->_bufferViews[jointAccess._bufferView];
-                const auto& jointBuffer = model->_buffers[jointView._buffer];
-                auto jointComponentSize = document::model::componentTypeSize(jointAccess._componentType);
-                auto jointElementCount = document::model::elementTypeComponentCount(jointAccess._elementType);
-                auto jointStride = (jointView._byteStride ? jointView._byteStride : jointComponentSize * jointElementCount);
-                auto jointMask = document::model::componentTypeInt32Mask(jointAccess._componentType);
+            ModelPart part{
+                .numIndices = (uint32_t)partIndices.size(),
+                .indexOffset = (uint32_t)index_buffer.size(),
+                .vertexOffset = 0,
+                .attribOffset =  0,
+                .material = p._material,
+                .numEdges = (uint32_t)adjacency.edges.size(),
+                .edgeOffset = 0,
+                .skinOffset = MODEL_INVALID_INDEX };
+             parts.emplace_back(part);
 
-                skinWeightJointGetter = [&](uint32_t index) {
-                    auto weight_m = (weightBuffer._bytes.data() + weightView._byteOffset + weightAccess._byteOffset + weightStride * index);
-                    core::vec4 vw;
-                    vw.x = *(float*)(weight_m + 0);
-                    vw.y = *(float*)(weight_m + 1 * weightComponentSize);
-                    vw.z = *(float*)(weight_m + 2 * weightComponentSize);
-                    vw.w = *(float*)(weight_m + 3 * weightComponentSize);
-
-                    auto joint_m = (jointBuffer._bytes.data() + jointView._byteOffset + jointAccess._byteOffset + jointStride * index);
-                    core::ivec4 vj;
-                    vj.x = jointMask & *((int32_t*)(joint_m + 0));
-                    vj.y = jointMask & *((int32_t*)(joint_m + 1 * jointComponentSize));
-                    vj.z = jointMask & *((int32_t*)(joint_m + 2 * jointComponentSize));
-                    vj.w = jointMask & *((int32_t*)(joint_m + 3 * jointComponentSize));
-
-                    float sumWeight = core::dot(vw, 1.0f);
-                    uint32_t viw = 0;
-                    uint32_t vij = 0;
-                    if (sumWeight > 0.0f) {
-                        for (int i = 0; i < 4; ++i) {
-                            uint32_t iw = (0xff & (uint32_t)(255 * vw[i]));
-                            uint32_t ij = (0xff & (uint32_t)(vj[i]));
-                            viw = viw | ((iw) << (i * 8));
-                            vij = vij | ((ij) << (i * 8));
-                        }
-                    }
-                    return core::ivec2(viw, vij);
-                };
+            // Fill the index_buffer with the true indices
+            for (auto i : partIndices) {
+                index_buffer.emplace_back(i);
             }
+            // Fill the edge and face buffers
+            edge_buffer.insert(edge_buffer.end(), adjacency.edges.begin(), adjacency.edges.end());
+            face_buffer.insert(face_buffer.end(), adjacency.faces.begin(), adjacency.faces.end());
 
-            std::vector<ModelVertex> partVerts;
-            std::vector<ModelVertexAttrib> partAttribs;
+            if (!primitiveWelded[pi]) {
+                partAABBs.emplace_back();
+                continue;
+            }
+            const auto& posAccess = model._accessors[p._positions];
+            partAABBs.emplace_back(posAccess._aabb);
+            if (first) {
+                bound = posAccess._aabb;
+                first = false;
+            }
+            else {
+                bound = core::aabox3::fromBound(bound, posAccess._aabb);
+            }
+        }
 
-            for (uint32_t i = 0; i < partIndices.size(); ++i) {
-                uint32_t index = partIndices[i];
-                auto vp = positionGetter(index);
-                auto vn = normalGetter(index);
-                auto vt = texcoordGetter(index);
+        // Also need a version of the mesh and parts and their bound on the cpu side
+        modelDraw->_vertices = std::move(vertex_buffer);
+        modelDraw->_vertex_attribs = std::move(vertex_attrib_buffer);
+        modelDraw->_indices = std::move(index_buffer);
+        modelDraw->_parts = std::move(parts);
+        modelDraw->_partAABBs = std::move(partAABBs);
+        modelDraw->_edges = std::move(edge_buffer);
+        modelDraw->_faces = std::move(face_buffer);
+        modelDraw->_partMeshlets = std::move(partMeshlets);
+        modelDraw->_meshlets = std::move(meshlets.meshlets);
+        modelDraw->_meshletBounds = std::move(meshlets.bounds);
+        modelDraw->_meshletVertices = std::move(meshlets.vertices);
+        modelDraw->_meshletTriangles = std::move(meshlets.triangles);
 
-                auto swj = skinWeightJointGetter(index);
+        // Materials
+        for (const auto& m : model._materials) {
+            ModelMaterial mm;
+            mm.color = m._baseColor;
+            mm.metallic = m._metallicFactor;
+            mm.roughness = m._roughnessFactor;
+            mm.baseColorTexture = m._baseColorTexture;
+            mm.normalTexture = m._normalTexture;
+            mm.rmaoTexture = m._roughnessMetallicTexture;
+            mm.emissiveTexture = m._emissiveTexture;
+            modelDraw->_materials.emplace_back(mm);
+        }
 
-                ModelVertex v{ vp.x, vp.y, vp.z, vn };
-                partVerts.emplace_back(v);
+        // The images become the slices of the material texture
+        images = std::move(model._images);
 
-                ModelVertexAttrib a{ vt.x, vt.y, (uint32_t)swj.x, (uint32_t)swj.y };
-                partAttribs.emplace_back(a);
+        // Skins
+        for (const auto& s : model._skins) {
+            ModelSkin skin = { .jointOffset = (uint32_t) modelDraw->_skinJointBindings.size(),
+                                .numJoints = (uint32_t) s._joints.size() };
+            modelDraw->_skins.emplace_back(skin);
 
-                //hash a key on vector pos and normal
-                size_t kv = hashV(v);
-                size_t ka = hashA(a);
+            const auto& accessor = model._accessors[s._inverseBindMatrices];
+            const auto& bufferView = model._bufferViews[accessor._bufferView];
+            const auto& buffer = model._buffers[bufferView._buffer];
 
-                auto v_bucket = indexedVertexMap.find(kv);
-                if (v_bucket == indexedVertexMap.end()) {
-                    index = vertex_buffer.size();
+            struct JointMat {
+                float m[16];
+            };
+            for (int i = 0; i < s._joints.size(); ++i) {
+                int32_t jointNodeId = s._joints[i];
+                JointMat m = document::model::FetchBuffer<JointMat>(i, accessor, bufferView, buffer);
+//                core::mat4x4 inBindMat = document::model::FetchBuffer<core::mat4x4>(i, accessor, bufferView, buffer);
+                ModelSkinJointBinding binding;
+                for (int c = 0; c < 4; c++) {
+                    for (int r = 0; r < 3; r++) {
+                        binding.invBindingPose._columns[c][r] = m.m[c * 4 + r];
+                    }
+                }
+                binding.bone = { jointNodeId, (int32_t) s._skeleton, 0 , 0};
 
-                    vertex_buffer.emplace_back(v);
-                    vertex_attrib_buffer.emplace_back(a);
+                modelDraw->_skinJointBindings.emplace_back(binding);
+            }
+        }
 
-                    indexedVertexMap.insert({ kv, { index, {{ka, index}} } });
+        // CPU skinning data of the parts drawn by the skinned items
+        modelDraw->buildPartSkins();
 
-                    mainVertexIndices.emplace_back(index);
-                } else {
-                    auto& bucket = v_bucket->second.attribs;
-                    index = -1;
-                    for (auto& va : bucket) {
-                        if (va.first == ka) {
-                            index = va.second;
-                            break;
-                        }
-                    }
-                    if (index == -1) {
-                        index = vertex_buffer.size();
-                        vertex_buffer.emplace_back(v);
-                        vertex_attrib_buffer.emplace_back(a);
-                        bucket.emplace_back(std::pair(ka, index));
+        // add a dummy joint binding to have a valid buffer even if not used
+        if (modelDraw->_skinJointBindings.empty())
+        {
+            modelDraw->_skinJointBindings.emplace_back(ModelSkinJointBinding());
+        }
 
-                        mainVertexIndices.emplace_back(v_bucket->second.index);
-                    }
+        // Model local bound is the containing box for all the local items of the model
+        core::aabox3 model_aabb;
+        for (const auto& i : modelDraw->_localItems) {
+            if (i.shape != MODEL_INVALID_INDEX) {
+                auto nodeIdx = i.node;
+                core::mat4x3 transform = modelDraw->_localNodeTransforms[nodeIdx];
+                nodeIdx = modelDraw->_localNodeParents[nodeIdx];
+                while(nodeIdx != INVALID_NODE_ID) {
+                    transform = core::mul(modelDraw->_localNodeTransforms[nodeIdx], transform);
+                    nodeIdx = modelDraw->_localNodeParents[nodeIdx];
                 }
 
-                // update the index buffer index
-                partIndices[i] = index;
+                const auto& s = modelDraw->_shapes[i.shape];
+                core::aabox3 shape_aabb = modelDraw->_partAABBs[s.partOffset];
+                for (int p = 1; p < s.numParts; ++p) {
+                    shape_aabb = core::aabox3::fromBound(shape_aabb, modelDraw->_partAABBs[p + s.partOffset]);
+                };
+                shape_aabb = core::aabox_transformFrom(transform, shape_aabb);
+                model_aabb = core::aabox3::fromBound(model_aabb, shape_aabb);
             }
+        }
+        modelDraw->_bound = model_aabb;
 
-            // Record edge and face:
-            std::vector<uint32_t> partEdges;
-            std::vector<ModelFace> partFaces;
-            std::unordered_map<size_t, std::vector<uint32_t>> partMainEdges;
-            int32_t numTriangles = partIndices.size() / 3;
-            partFaces.reserve(numTriangles);
 
-            for (uint32_t ti = 0; ti < numTriangles; ++ti) {
-                uint32_t baseFaceVertexIdx = 3 * ti;
-                core::ivec3 triangleVertIds(
-                    partIndices[baseFaceVertexIdx + 0],
-                    partIndices[baseFaceVertexIdx + 1],
-                    partIndices[baseFaceVertexIdx + 2]);
+        auto [clipData, clips] = Key::createClipsFromGLTF(model);
 
-                core::ivec2 edgeVertIndices[3] = {
-                  {triangleVertIds.x, triangleVertIds.y},
-                  {triangleVertIds.y, triangleVertIds.z},
-                  {triangleVertIds.z, triangleVertIds.x}
-                };
+        // Keep the animation clips in compressed form, sampled directly from it
+        auto compressedClipData = Key::compressClips(clipData, clips);
+        if (!clips.empty()) {
+            picoLogf("ModelDrawFactory::createModel {}: {} animation clips compressed {} -> {} bytes", model._name, clips.size(), clipData.byteSize(), compressedClipData.byteSize());
+        }
 
-                core::ivec4 faceEdges;
-                for (uint32_t vi = 0; vi < 3; ++vi) {
-                    uint32_t edgeIdx = baseFaceVertexIdx + vi;
-                    uint32_t edge_index = edgeIdx;
-
-                    auto edge = core::sort_increasing(edgeVertIndices[vi]);
-                    auto ek = *reinterpret_cast<uint64_t*>(&edge);
-
-                    auto e_bucket = indexedEdgeMap.find(ek);
-                    if (e_bucket == indexedEdgeMap.end()) {
-                        edge_index = edge_buffer.size();
-                        edge_buffer.emplace_back(core::ivec4{ edge.x, edge.y, (int32_t) ti, -1});
-                        indexedEdgeMap.insert({ ek, {edge_index, ti} });
-                    } else {
-                        picoAssert( (((int32_t) e_bucket->second.t1) == (-1))); // "we have a problem, more than 2 triangles for that edge ???"
-                        
-                        edge_index = e_bucket->second.index;
-                        e_bucket->second.t1 = ti;
-                        edge_buffer[edge_index].w = ti;
-                    }
+        modelDraw->_animations = std::make_shared<graphics::Key> ();
+        modelDraw->_animations->_data = std::move(compressedClipData);
+        modelDraw->_animations->_clips = std::move(clips);
+        modelDraw->_animations->_skeleton = Key::createSkeleton(modelDraw->_localNodeParents);
+    }
 
-                    partEdges.emplace_back(edge_index);
-                    faceEdges[vi] = edge_index;
-
-                    
-                    core::ivec2 mainEdge{ (int32_t) mainVertexIndices[edge.x], (int32_t) mainVertexIndices[edge.y] };
-                    mainEdge = core::sort_increasing(mainEdge);
-                    auto mek = *reinterpret_cast<uint64_t*>(&mainEdge);
-                    auto me_bucket = partMainEdges.find(mek);
-                    if (me_bucket == partMainEdges.end()) {
-                        partMainEdges.insert({ mek, {edge_index} });
-                    } else {
-                        me_bucket->second.emplace_back(edge_index);
-                    }
-                }
-                partFaces.emplace_back(faceEdges);
+    void ModelDraw::buildPartSkins() {
+        _partSkins.clear();
+        for (const auto& li : _localItems) {
+            if (li.shape == MODEL_INVALID_INDEX || li.skin == MODEL_INVALID_INDEX) {
+                continue;
+            }
+            const auto& skin = _skins[li.skin];
+            std::vector<core::mat4x3> invBindMatrices(skin.numJoints);
+            for (uint32_t j = 0; j < skin.numJoints; ++j) {
+                invBindMatrices[j] = _skinJointBindings[skin.jointOffset + j].invBindingPose;
             }
 
+            const auto& s = _shapes[li.shape];
+            for (uint32_t p = s.partOffset; p < s.partOffset + s.numParts; ++p) {
+                const auto& part = _parts[p];
+                ModelPartSkin ps{ .part = p, .skin = li.skin, .node = li.node };
+
+                // the unique vertices referenced by the part
+                auto firstIndex = _indices.begin() + part.indexOffset;
+                ps.vertices.assign(firstIndex, firstIndex + part.numIndices);
+                std::sort(ps.vertices.begin(), ps.vertices.end());
+                ps.vertices.erase(std::unique(ps.vertices.begin(), ps.vertices.end()), ps.vertices.end());
+
+                uint32_t numVertices = (uint32_t) ps.vertices.size();
+                std::vector<uint32_t> packed(2 * numVertices);
+                ps.bindPositions.resize(numVertices);
+                for (uint32_t v = 0; v < numVertices; ++v) {
+                    const auto& vertex = _vertices[part.vertexOffset + ps.vertices[v]];
+                    const auto& attrib = _vertex_attribs[part.attribOffset + ps.vertices[v]];
+                    ps.bindPositions.set(v, { vertex.px, vertex.py, vertex.pz });
+                    packed[2 * v] = attrib.sw;
+                    packed[2 * v + 1] = attrib.sj;
+                }
+                core::skin_unpack(packed.data(), packed.data() + 1, 2 * sizeof(uint32_t), numVertices, ps.influences);
 
-            
-            for (uint32_t ei = 0; ei < partEdges.size(); ++ei) {
-                auto edgeId = partEdges[ei];
-                auto& edge = edge_buffer[edgeId];
-
-                if (edge.w == -1) {
-                    core::ivec2 mainEdge{ (int32_t)mainVertexIndices[edge.x], (int32_t)mainVertexIndices[edge.y] };
-                    mainEdge = core::sort_increasing(mainEdge);
-                    auto mek = *reinterpret_cast<uint64_t*>(&mainEdge);
-                    auto me_bucket = partMainEdges.find(mek);
-                    if (me_bucket != partMainEdges.end()) {
-                        if (me_bucket->second.size() > 1) {
-                            if (me_bucket->second.size() == 2) {
-                                for (auto lei : me_bucket->second) {
-                                    if (lei != edgeId) {
-                                        // go get that other edge and find the neighbor
-                                        auto t1 = edge_buffer[lei].z;
-                                        edge.w = -(1 + t1);
-                                    }
-                                }
-                            }
-                        }
+                bool validJoints = true;
+                for (uint32_t k = 0; k < core::SKIN_MAX_INFLUENCES; ++k) {
+                    for (uint32_t v = 0; v < numVertices; ++v) {
+                        validJoints &= (ps.influences.joints[k][v] < skin.numJoints);
                     }
                 }
+                if (!validJoints) {
+                    picoLogf("ModelDrawFactory::createModel {}: part {} skin joint index out of range, no cpu skinning", _name, p);
+                    continue;
+                }
+                core::skin_buildJointBounds(ps.influences, ps.bindPositions, invBindMatrices.data(), skin.numJoints, ps.jointBounds);
+                _partSkins.emplace_back(std::move(ps));
             }
+        }
+    }
 
-            ModelPart part{
-                .numIndices = (uint32_t)partIndices.size(),
-                .indexOffset = (uint32_t)index_buffer.size(),
-                .vertexOffset = 0,
-                .attribOffset =  0,
-                .material = p._material,
-                .numEdges = (uint32_t)partEdges.size(),
-                .edgeOffset = 0,
-                .skinOffset = MODEL_INVALID_INDEX };
-             parts.emplace_back(part);
-            
-            // Fill the index_buffer with the true indices
-            for (auto i : partIndices) {
-                index_buffer.emplace_back(i);
-            }
-            // Fill the face_edge_buffer with the true indices
-            for (auto i : partFaces) {
-                face_buffer.emplace_back(i);
-            }
-
-            partAABBs.emplace_back(posAccess._aabb);
-            if (first) {
-                bound = posAccess._aabb;
-                first = false;
-            }
-            else {
-                bound = core::aabox3::fromBound(bound, posAccess._aabb);
-            }
+    void ModelDrawFactory::allocateModelGPU(const graphics::DevicePointer& device, graphics::ModelDraw& draw, std::vector<document::Image>& images) {
+        auto modelDraw = &draw;
+        const auto& parts = modelDraw->_parts;
+        const auto& vertex_buffer = modelDraw->_vertices;
+        const auto& vertex_attrib_buffer = modelDraw->_vertex_attribs;
+        const auto& index_buffer = modelDraw->_indices;
+        const auto& edge_buffer = modelDraw->_edges;
+        const auto& face_buffer = modelDraw->_faces;
+        const auto& materials = modelDraw->_materials;
+
+        // Streamed, the buffers are device local and their content goes through the streaming queue,
+        // otherwise they are host visible and written right away
+        const bool streamed = (_streamingQueue != nullptr);
+        if (streamed) {
+            modelDraw->_geometryResidency = std::make_shared<StreamResidency>();
         }
+        auto initBuffer = [&](const BufferPointer& buffer, const void* data, uint64_t size) {
+            if (streamed) {
+                _streamingQueue->enqueueBuffer(buffer, data, size, StreamingQueue::HIGH_PRIORITY, modelDraw->_geometryResidency);
+            } else {
+                memcpy(buffer->_cpuMappedAddress, data, size);
+            }
+        };
 
         // parts
         BufferInit partBufferInit;
         partBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         partBufferInit.bufferSize = parts.size() * sizeof(ModelPart);
-        partBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        partBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         partBufferInit.firstElement = 0;
         partBufferInit.numElements = parts.size();
         partBufferInit.structStride = sizeof(ModelPart);
 
         auto pbuniformBuffer = device->createBuffer(partBufferInit);
-        memcpy(pbuniformBuffer->_cpuMappedAddress, parts.data(), partBufferInit.bufferSize);
+        initBuffer(pbuniformBuffer, parts.data(), partBufferInit.bufferSize);
 
         // vertex buffer
         BufferInit vertexBufferInit;
         vertexBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         vertexBufferInit.bufferSize = vertex_buffer.size() * sizeof(core::vec4);
-        vertexBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        vertexBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         vertexBufferInit.firstElement = 0;
         vertexBufferInit.numElements = vertex_buffer.size();
         vertexBufferInit.structStride = sizeof(core::vec4);
 
         auto vbresourceBuffer = device->createBuffer(vertexBufferInit);
-        memcpy(vbresourceBuffer->_cpuMappedAddress, vertex_buffer.data(), vertexBufferInit.bufferSize);
+        initBuffer(vbresourceBuffer, vertex_buffer.data(), vertexBufferInit.bufferSize);
 
         // vertex attrib buffer
         BufferInit vertexattribBufferInit;
@@ -540,56 +867,54 @@ namespace graphics
         if (vertex_attrib_buffer.size()) {
             vertexattribBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
             vertexattribBufferInit.bufferSize = vertex_attrib_buffer.size() * sizeof(core::vec4);
-            vertexattribBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+            vertexattribBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
             vertexattribBufferInit.firstElement = 0;
             vertexattribBufferInit.numElements = vertex_attrib_buffer.size();
             vertexattribBufferInit.structStride = sizeof(core::vec4);
 
             vabresourceBuffer = device->createBuffer(vertexattribBufferInit);
-            memcpy(vabresourceBuffer->_cpuMappedAddress, vertex_attrib_buffer.data(), vertexattribBufferInit.bufferSize);
+            initBuffer(vabresourceBuffer, vertex_attrib_buffer.data(), vertexattribBufferInit.bufferSize);
         }
 
         // index buffer
         BufferInit indexBufferInit;
         indexBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         indexBufferInit.bufferSize = index_buffer.size() * sizeof(ModelIndex);
-        indexBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        indexBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         indexBufferInit.firstElement = 0;
         indexBufferInit.numElements = index_buffer.size();
         indexBufferInit.structStride = sizeof(ModelIndex);
 
         auto ibresourceBuffer = device->createBuffer(indexBufferInit);
-        memcpy(ibresourceBuffer->_cpuMappedAddress, index_buffer.data(), indexBufferInit.bufferSize);
+        initBuffer(ibresourceBuffer, index_buffer.data(), indexBufferInit.bufferSize);
 
 
         // edge buffer
         BufferInit edgeBufferInit;
         edgeBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         edgeBufferInit.bufferSize = edge_buffer.size() * sizeof(ModelEdge);
-        edgeBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        edgeBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         edgeBufferInit.firstElement = 0;
         edgeBufferInit.numElements = edge_buffer.size();
         edgeBufferInit.structStride = sizeof(ModelEdge);
 
         auto ebuniformBuffer = device->createBuffer(edgeBufferInit);
-        memcpy(ebuniformBuffer->_cpuMappedAddress, edge_buffer.data(), edgeBufferInit.bufferSize);
+        initBuffer(ebuniformBuffer, edge_buffer.data(), edgeBufferInit.bufferSize);
 
-        modelDraw->_edges = std::move(edge_buffer);
         modelDraw->_edgeBuffer = ebuniformBuffer;
 
         // Face buffer
         BufferInit faceBufferInit;
         faceBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         faceBufferInit.bufferSize = face_buffer.size() * sizeof(ModelFace);
-        faceBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        faceBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         faceBufferInit.firstElement = 0;
         faceBufferInit.numElements = face_buffer.size();
         faceBufferInit.structStride = sizeof(ModelFace);
 
         auto fbuniformBuffer = device->createBuffer(faceBufferInit);
-        memcpy(fbuniformBuffer->_cpuMappedAddress, face_buffer.data(), faceBufferInit.bufferSize);
+        initBuffer(fbuniformBuffer, face_buffer.data(), faceBufferInit.bufferSize);
 
-        modelDraw->_faces = std::move(face_buffer);
         modelDraw->_faceBuffer = fbuniformBuffer;
 
 
@@ -599,13 +924,6 @@ namespace graphics
         modelDraw->_vertexAttribBuffer = vabresourceBuffer;
         modelDraw->_partBuffer = pbuniformBuffer;
 
-        // Also need a version of the mesh and parts and their bound on the cpu side
-        modelDraw->_vertices = std::move(vertex_buffer);
-        modelDraw->_vertex_attribs = std::move(vertex_attrib_buffer);
-        modelDraw->_indices = std::move(index_buffer);
-        modelDraw->_parts = std::move(parts);
-        modelDraw->_partAABBs = std::move(partAABBs);
-
 
 
         //// Ray tracing data structure
@@ -630,51 +948,37 @@ namespace graphics
         };
         auto geometry = device->createGeometry(geometryInit);
 
-        
-        modelDraw->_geometry = geometry;
 
+        modelDraw->_geometry = geometry;
 
 
-        // Materials
-        std::vector<ModelMaterial> materials;
-        for (const auto& m : model->_materials) {
-            ModelMaterial mm;
-            mm.color = m._baseColor;
-            mm.metallic = m._metallicFactor;
-            mm.roughness = m._roughnessFactor;
-            mm.baseColorTexture = m._baseColorTexture;
-            mm.normalTexture = m._normalTexture;
-            mm.rmaoTexture = m._roughnessMetallicTexture;
-            mm.emissiveTexture = m._emissiveTexture;
-            materials.emplace_back(mm);
-        }
 
         // material buffer
         BufferInit materialBufferInit;
         materialBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
         materialBufferInit.bufferSize = materials.size() * sizeof(ModelMaterial);
-        materialBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
+        materialBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
         materialBufferInit.firstElement = 0;
         materialBufferInit.numElements = materials.size();
         materialBufferInit.structStride = sizeof(ModelMaterial);
 
         auto mbresourceBuffer = device->createBuffer(materialBufferInit);
-        memcpy(mbresourceBuffer->_cpuMappedAddress, materials.data(), materialBufferInit.bufferSize);
+        initBuffer(mbresourceBuffer, materials.data(), materialBufferInit.bufferSize);
 
         modelDraw->_materialBuffer = mbresourceBuffer;
 
         // Allocate the textures
-        if (model->_images.size()) {
-            uint32_t numImages = model->_images.size();
+        if (images.size()) {
+            uint32_t numImages = images.size();
             uint32_t maxWidth = 0;
             uint32_t maxHeight = 0;
             std::vector<std::vector<uint8_t>> pixels;
-            for (auto& i : model->_images) {
+            for (auto& i : images) {
                 maxWidth = core::max(maxWidth, i._desc.width);
                 maxHeight = core::max(maxHeight, i._desc.height);
                 pixels.emplace_back(std::move(i._pixels));
             }
-            
+
             if (maxWidth > 0 && maxHeight > 0 && numImages > 0) {
                 TextureInit texInit;
                 texInit.width = maxWidth;
@@ -683,94 +987,29 @@ namespace graphics
                 texInit.initData = std::move(pixels);
                 texInit.format = graphics::PixelFormat::R8G8B8A8_UNORM_SRGB;
                 auto albedoresourceTexture = device->createTexture(texInit);
-
-                modelDraw->_albedoTexture = albedoresourceTexture;
-            }
-        }
-
-        // Skin buffer
-        {
-            for (const auto& s : model->_skins) {
-                ModelSkin skin = { .jointOffset = (uint32_t) modelDraw->_skinJointBindings.size(),
-                                    .numJoints = (uint32_t) s._joints.size() };
-                modelDraw->_skins.emplace_back(skin);
-
-                const auto& accessor = model->_accessors[s._inverseBindMatrices];
-                const auto& bufferView = model->_bufferViews[accessor._bufferView];
-                const auto& buffer = model->_buffers[bufferView._buffer];
-
-                struct JointMat {
-                    float m[16];
-                };
-                for (int i = 0; i < s._joints.size(); ++i) {
-                    int32_t jointNodeId = s._joints[i];
-                    JointMat m = document::model::FetchBuffer<JointMat>(i, accessor, bufferView, buffer);
-//                    core::mat4x4 inBindMat = document::model::FetchBuffer<core::mat4x4>(i, accessor, bufferView, buffer);
-                    ModelSkinJointBinding binding;
-                    for (int c = 0; c < 4; c++) {
-                        for (int r = 0; r < 3; r++) {
-                            binding.invBindingPose._columns[c][r] = m.m[c * 4 + r];
-                        }
-                    }
-                    binding.bone = { jointNodeId, (int32_t) s._skeleton, 0 , 0};
-
-                    modelDraw->_skinJointBindings.emplace_back(binding);
+                if (streamed) {
+                    modelDraw->_textureResidency = std::make_shared<StreamResidency>();
+                    _streamingQueue->enqueueTexture(albedoresourceTexture, StreamingQueue::LOW_PRIORITY, modelDraw->_textureResidency);
                 }
-            }
 
-            // add a dummy joint binding to have a valid buffer even if not used
-            if (modelDraw->_skinJointBindings.empty())
-            {
-                modelDraw->_skinJointBindings.emplace_back(ModelSkinJointBinding());
-            }
-            // skin buffer
-            BufferInit skinBufferInit;
-            int32_t skinJointElementPerStruct = 4;
-            skinBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
-            skinBufferInit.bufferSize = modelDraw->_skinJointBindings.size() * sizeof(ModelSkinJointBinding);
-            skinBufferInit.hostVisible = true; // TODO Change this to immutable and initialized value
-            skinBufferInit.firstElement = 0;
-            skinBufferInit.numElements = modelDraw->_skinJointBindings.size() * skinJointElementPerStruct;
-            skinBufferInit.structStride = sizeof(ModelSkinJointBinding) / skinJointElementPerStruct;
-
-            auto sbresourceBuffer = device->createBuffer(skinBufferInit);
-            memcpy(sbresourceBuffer->_cpuMappedAddress, modelDraw->_skinJointBindings.data(), skinBufferInit.bufferSize);
-
-            modelDraw->_skinBuffer = sbresourceBuffer;
-        }
-
-        // Model local bound is the containing box for all the local items of the model
-        core::aabox3 model_aabb;
-        for (const auto& i : modelDraw->_localItems) {
-            if (i.shape != MODEL_INVALID_INDEX) {
-                auto nodeIdx = i.node;
-                core::mat4x3 transform = modelDraw->_localNodeTransforms[nodeIdx];
-                nodeIdx = modelDraw->_localNodeParents[nodeIdx];
-                while(nodeIdx != INVALID_NODE_ID) {
-                    transform = core::mul(modelDraw->_localNodeTransforms[nodeIdx], transform);
-                    nodeIdx = modelDraw->_localNodeParents[nodeIdx];
-                }
-
-                const auto& s = modelDraw->_shapes[i.shape];
-                core::aabox3 shape_aabb = modelDraw->_partAABBs[s.partOffset];
-                for (int p = 1; p < s.numParts; ++p) {
-                    shape_aabb = core::aabox3::fromBound(shape_aabb, modelDraw->_partAABBs[p + s.partOffset]);
-                };
-                shape_aabb = core::aabox_transformFrom(transform, shape_aabb);
-                model_aabb = core::aabox3::fromBound(model_aabb, shape_aabb);
+                modelDraw->_albedoTexture = albedoresourceTexture;
             }
         }
-        modelDraw->_bound = model_aabb;
 
+        // skin buffer
+        BufferInit skinBufferInit;
+        int32_t skinJointElementPerStruct = 4;
+        skinBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
+        skinBufferInit.bufferSize = modelDraw->_skinJointBindings.size() * sizeof(ModelSkinJointBinding);
+        skinBufferInit.hostVisible = !streamed; // TODO Change this to immutable and initialized value
+        skinBufferInit.firstElement = 0;
+        skinBufferInit.numElements = modelDraw->_skinJointBindings.size() * skinJointElementPerStruct;
+        skinBufferInit.structStride = sizeof(ModelSkinJointBinding) / skinJointElementPerStruct;
 
-        auto [clipData, clips] = Key::createClipsFromGLTF(*model);
+        auto sbresourceBuffer = device->createBuffer(skinBufferInit);
+        initBuffer(sbresourceBuffer, modelDraw->_skinJointBindings.data(), skinBufferInit.bufferSize);
 
-        
-        modelDraw->_animations = std::make_shared<graphics::Key> ();
-        modelDraw->_animations->_data = std::move(clipData);
-        modelDraw->_animations->_clips = std::move(clips);
-
-        return modelDraw;
+        modelDraw->_skinBuffer = sbresourceBuffer;
     }
 
    void ModelDrawFactory::allocateDrawcallObject(
@@ -795,19 +1034,40 @@ namespace graphics
        samplerInit._filter = graphics::Filter::MIN_MAG_LINEAR_MIP_POINT;
        auto samplerL = device->createSampler(samplerInit);
 
-       graphics::DescriptorObjects descriptorObjects = {
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getPartBuffer()},
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getIndexBuffer() },
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getVertexBuffer() },
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getVertexAttribBuffer() },
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getSkinBuffer() },
-            { graphics::DescriptorType::RESOURCE_BUFFER, model.getMaterialBuffer() },
-            { graphics::DescriptorType::RESOURCE_TEXTURE, model.getAlbedoTexture() },
-            { sampler },
-            { samplerL }
+       auto makeDescriptorObjects = [&](const TexturePointer& albedoTexture) -> graphics::DescriptorObjects {
+           return {
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getPartBuffer()},
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getIndexBuffer() },
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getVertexBuffer() },
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getVertexAttribBuffer() },
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getSkinBuffer() },
+                { graphics::DescriptorType::RESOURCE_BUFFER, model.getMaterialBuffer() },
+                { graphics::DescriptorType::RESOURCE_TEXTURE, albedoTexture },
+                { sampler },
+                { samplerL }
+           };
        };
+       auto descriptorObjects = makeDescriptorObjects(model.getAlbedoTexture());
        device->updateDescriptorSet(descriptorSet, descriptorObjects);
 
+       // Streamed, the same descriptors with the placeholder texture until the albedo texture is resident
+       DescriptorSetPointer placeholderSet;
+       if (model._textureResidency) {
+           if (!_placeholderTexture) {
+               TextureInit texInit;
+               texInit.width = 1;
+               texInit.height = 1;
+               texInit.numSlices = 1;
+               texInit.initData = { { 0xFF, 0xFF, 0xFF, 0xFF } };
+               texInit.format = graphics::PixelFormat::R8G8B8A8_UNORM_SRGB;
+               _placeholderTexture = device->createTexture(texInit);
+           }
+           placeholderSet = device->createDescriptorSet(descriptorSetInit);
+           auto placeholderObjects = makeDescriptorObjects(_placeholderTexture);
+           device->updateDescriptorSet(placeholderSet, placeholderObjects);
+       }
+       model._placeholderDescriptorSet = placeholderSet;
+
 
        auto numVertices = model.getVertexBuffer()->numElements();
        auto numIndices = model.getIndexBuffer()->numElements();
@@ -820,23 +1080,45 @@ namespace graphics
 
        auto pipeline = this->_pipeline;
        auto albedoTex = model.getAlbedoTexture();
+       auto placeholderTex = (placeholderSet ? _placeholderTexture : nullptr);
+       auto textureResidency = model._textureResidency;
+       auto geometryResidency = model._geometryResidency;
+
+       // The texture bound by the drawcall is uploaded on first use, before the pass,
+       // and the skinned parts get their bounds in the pose of the frame
+       auto pmodel = (model._partSkins.empty() ? nullptr : &model);
+       graphics::DrawPrepareCallback prepareCallback = [albedoTex, placeholderTex, textureResidency, pmodel](RenderArgs& args) {
+            if (pmodel) {
+                pmodel->updateSkinnedBounds(args.scene->_items, args.scene->_nodes);
+            }
+
+            // the residency only changes when the streaming queue is drained, before the draws are prepared
+            bool textureResident = !textureResidency || textureResidency->isResident();
+            const auto& texture = (textureResident ? albedoTex : placeholderTex);
+
+            if (texture && texture->needUpload() && texture->claimUpload()) {
+                args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, texture);
+                args.batch->uploadTexture(texture);
+                args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, texture);
+            }
+       };
 
        // And now a render callback where we describe the rendering sequence
-       graphics::DrawObjectCallback drawCallback = [descriptorSet, pipeline, albedoTex](
+       graphics::DrawObjectCallback drawCallback = [descriptorSet, placeholderSet, pipeline, textureResidency](
            const NodeID node, RenderArgs& args) {
-            
-            if (albedoTex && albedoTex->needUpload()) {
-                args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, albedoTex);
-                args.batch->uploadTexture(albedoTex);
-                args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, albedoTex);
-            }
+            // the residency only changes when the streaming queue is drained, before the drawcalls are recorded
+            bool textureResident = !textureResidency || textureResidency->isResident();
 
             args.batch->bindPipeline(pipeline);
 
             args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, args.viewPassDescriptorSet);
-            args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, descriptorSet);
+            args.batch->bindDescriptorSet(graphics::PipelineType::GRAPHICS, (textureResident ? descriptorSet : placeholderSet));
        };
+       // The root drawcall binds the state shared by all the parts of all the instances,
+       // the render queue groups the parts behind it
        model._drawcall = drawCallback;
+       model._preparecall = prepareCallback;
+       model._stateKey = makeDrawStateKey(pipeline.get());
        model._drawID = scene->createDraw(model).id();
 
        if (model._animations && model._animations->_clips.size()) {
@@ -854,13 +1136,27 @@ namespace graphics
 
             auto partNumIndices = model._parts[d].numIndices;
            // And now a render callback where we describe the rendering sequence
-            part._drawcall = [d, uniforms, partNumIndices, numNodes, numParts, numMaterials, descriptorSet, pipeline](
+            part._drawcall = [d, uniforms, partNumIndices, numNodes, numParts, numMaterials, geometryResidency](
                const NodeID node, RenderArgs& args) {
+                   if (geometryResidency && !geometryResidency->isResident()) {
+                       return;
+                   }
                    ModelObjectData odata{ (uint32_t)node, (uint32_t)d, (uint32_t)numNodes, (uint32_t)numParts, (uint32_t)numMaterials, (uint32_t)uniforms->makeDrawMode() };
                    args.batch->bindPushUniform(graphics::PipelineType::GRAPHICS, 0, sizeof(ModelObjectData), (const uint8_t*)&odata);
                    args.batch->draw(partNumIndices, 0);
            };
+            // The same part of several instances of the model in one draw
+            part._instancesDrawcall = [d, uniforms, partNumIndices, numNodes, numParts, numMaterials, geometryResidency](
+               uint32_t firstInstance, uint32_t numInstances, RenderArgs& args) {
+                   if (geometryResidency && !geometryResidency->isResident()) {
+                       return;
+                   }
+                   ModelObjectData odata{ 0, (uint32_t)d, (uint32_t)numNodes, (uint32_t)numParts, (uint32_t)numMaterials, (uint32_t)uniforms->makeDrawMode(), (int32_t)firstInstance };
+                   args.batch->bindPushUniform(graphics::PipelineType::GRAPHICS, 0, sizeof(ModelObjectData), (const uint8_t*)&odata);
+                   args.batch->drawInstanced(partNumIndices, numInstances, 0);
+           };
 
+           part._stateKey = model._stateKey;
            auto partDraw = scene->createDraw(part);
            drawables.emplace_back(partDraw.id());
        }
@@ -898,6 +1194,8 @@ namespace graphics
         auto rootItemId = scene->createItem(init).id();
         items.emplace_back(rootItemId);
 
+        ModelDraw::SkinnedInstance skinned{ rootNode.id(), ItemIDs(model._partSkins.size(), INVALID_ITEM_ID) };
+
         for (const auto& li : model._localItems) {
             if (li.shape != MODEL_INVALID_INDEX) {
                 const auto& s = model._shapes[li.shape];
@@ -908,6 +1206,11 @@ namespace graphics
                         .group = rootItemId,
                         .name = model._localNodeNames[li.node],
                         }).id());
+                    for (uint32_t k = 0; k < model._partSkins.size(); ++k) {
+                        if (model._partSkins[k].part == si + s.partOffset && model._partSkins[k].node == li.node) {
+                            skinned.partSkinItems[k] = items.back();
+                        }
+                    }
                 }
             }
             if (li.camera != MODEL_INVALID_INDEX) {
@@ -915,8 +1218,310 @@ namespace graphics
             }
         }
 
+        if (!model._partSkins.empty()) {
+            model._skinnedInstances.emplace_back(std::move(skinned));
+        }
+
         return items; 
    }
 
 
-} // !namespace graphics
\ No newline at end of file
+} // !namespace graphics
+// -------------------------------------------------------------------------
+// Simple test — call runModelDrawTests() to validate the decoding of the primitive
+// accessors and runModelDrawBenchmarks() to compare the primitive weld with the
+// previous per index getter weld on the sample models
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+    using namespace document::model;
+
+    // Append the bytes as a buffer with its own view and an accessor on it, return the accessor
+    template <typename T> Index addAccessor(document::Model& model, const std::vector<T>& values, uint32_t count, ComponentType componentType, ElementType elementType) {
+        Buffer buffer;
+        buffer._bytes.resize(values.size() * sizeof(T));
+        memcpy(buffer._bytes.data(), values.data(), buffer._bytes.size());
+        buffer._byteLength = buffer._bytes.size();
+        model._buffers.emplace_back(std::move(buffer));
+
+        BufferView view;
+        view._buffer = (Index) model._buffers.size() - 1;
+        view._byteLength = model._buffers.back()._byteLength;
+        model._bufferViews.emplace_back(view);
+
+        Accessor accessor;
+        accessor._bufferView = (Index) model._bufferViews.size() - 1;
+        accessor._elementCount = count;
+        accessor._componentType = componentType;
+        accessor._elementType = elementType;
+        model._accessors.emplace_back(accessor);
+        return (Index) model._accessors.size() - 1;
+    }
+
+    // A quad of 4 vertices, 2 triangles, float texcoords in [0, 1]
+    Primitive makeQuad(document::Model& model) {
+        Primitive p;
+        p._positions = addAccessor<float>(model, { 0, 0, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0 }, 4, ComponentType::Float, ElementType::Vec3);
+        p._normals = addAccessor<float>(model, { 0, 0, 1,  0, 0, 1,  0, 0, 1,  0, 0, 1 }, 4, ComponentType::Float, ElementType::Vec3);
+        p._texcoords = addAccessor<float>(model, { 0, 0,  1, 0,  0, 0.5f,  1, 1 }, 4, ComponentType::Float, ElementType::Vec2);
+        p._indices = addAccessor<uint16_t>(model, { 0, 1, 2, 2, 1, 3 }, 6, ComponentType::UInt16, ElementType::Scalar);
+        return p;
+    }
+}
+
+void runModelDrawTests() {
+    using namespace graphics;
+    picoLog("ModelDrawTest: starting...");
+
+    // --- Test 1: normalized UNSIGNED_SHORT and UNSIGNED_BYTE texcoords decode like the float ones ---
+    {
+        document::Model model;
+        auto p = makeQuad(model);
+        std::vector<WeldVertex> refVertices;
+        std::vector<ModelIndex> refIndices;
+        assert(weldPrimitive(model, p, refVertices, refIndices));
+        assert(refVertices.size() == 4 && refIndices.size() == 6);
+
+        auto p16 = p;
+        p16._texcoords = addAccessor<uint16_t>(model, { 0, 0,  65535, 0,  0, 32768,  65535, 65535 }, 4, ComponentType::UInt16, ElementType::Vec2);
+        auto p8 = p;
+        p8._texcoords = addAccessor<uint8_t>(model, { 0, 0,  255, 0,  0, 128,  255, 255 }, 4, ComponentType::UInt8, ElementType::Vec2);
+
+        for (const auto& pn : { p16, p8 }) {
+            std::vector<WeldVertex> vertices;
+            std::vector<ModelIndex> indices;
+            assert(weldPrimitive(model, pn, vertices, indices));
+            assert(vertices.size() == refVertices.size() && indices == refIndices);
+            for (size_t v = 0; v < vertices.size(); ++v) {
+                assert(std::abs(vertices[v].a.u - refVertices[v].a.u) < 0.01f);
+                assert(std::abs(vertices[v].a.v - refVertices[v].a.v) < 0.01f);
+            }
+        }
+        picoLog("ModelDrawTest 1 passed: normalized integer texcoords decoded by component type");
+    }
+
+    // --- Test 2: an index out of the positions rejects the primitive ---
+    {
+        document::Model model;
+        auto p = makeQuad(model);
+        p._indices = addAccessor<uint16_t>(model, { 0, 1, 2, 2, 1, 4 }, 6, ComponentType::UInt16, ElementType::Scalar);
+        std::vector<WeldVertex> vertices;
+        std::vector<ModelIndex> indices;
+        assert(!weldPrimitive(model, p, vertices, indices));
+        assert(vertices.empty() && indices.empty());
+        picoLog("ModelDrawTest 2 passed: out of range index rejected");
+    }
+
+    // --- Test 3: an attribute accessor shorter than the positions rejects the primitive ---
+    {
+        document::Model model;
+        auto p = makeQuad(model);
+        auto shortNormals = p;
+        shortNormals._normals = addAccessor<float>(model, { 0, 0, 1,  0, 0, 1,  0, 0, 1 }, 3, ComponentType::Float, ElementType::Vec3);
+        auto shortTexcoords = p;
+        shortTexcoords._texcoords = addAccessor<float>(model, { 0, 0,  1, 0 }, 2, ComponentType::Float, ElementType::Vec2);
+        auto shortJoints = p;
+        shortJoints._weights = addAccessor<float>(model, std::vector<float>(16, 0.25f), 4, ComponentType::Float, ElementType::Vec4);
+        shortJoints._joints = addAccessor<uint8_t>(model, std::vector<uint8_t>(4, 0), 1, ComponentType::UInt8, ElementType::Vec4);
+        // An accessor claiming more elements than its buffer holds is not readable
+        auto overrun = p;
+        overrun._texcoords = addAccessor<float>(model, { 0, 0,  1, 0 }, 4, ComponentType::Float, ElementType::Vec2);
+
+        for (const auto& pn : { shortNormals, shortTexcoords, shortJoints, overrun }) {
+            std::vector<WeldVertex> vertices;
+            std::vector<ModelIndex> indices;
+            assert(!weldPrimitive(model, pn, vertices, indices));
+            assert(vertices.empty() && indices.empty());
+        }
+        picoLog("ModelDrawTest 3 passed: short attribute accessors rejected");
+    }
+
+    picoLog("ModelDrawTest: all tests passed");
+}
+
+namespace {
+    // The previous ModelDrawFactory weld: sequential over the primitives, one std::function
+    // getter call per index and per attribute, a node based map keyed by the position hash
+    // with a list of attribute hashes per bucket
+    size_t weldSequentialGetters(const document::Model& model) {
+        using namespace graphics;
+        std::vector<ModelVertex> vertex_buffer;
+        std::vector<ModelVertexAttrib> vertex_attrib_buffer;
+        std::vector<ModelIndex> index_buffer;
+        std::vector<uint32_t> mainVertexIndices;
+
+        using LookupAttribArray = std::vector<std::pair<size_t, uint32_t>>;
+        struct LookupVertex { uint32_t index; LookupAttribArray attribs; };
+        std::unordered_map<size_t, LookupVertex> indexedVertexMap;
+
+        auto elementPtr = [&](Index accessorId, uint32_t index) {
+            const auto& access = model._accessors[accessorId];
+            const auto& view = model._bufferViews[access._bufferView];
+            const auto& buffer = model._buffers[view._buffer];
+            auto stride = (view._byteStride ? view._byteStride : elementTypeComponentCount(access._elementType) * componentTypeSize(access._componentType));
+            return buffer._bytes.data() + view._byteOffset + access._byteOffset + stride * index;
+        };
+
+        for (const auto& p : model._primitives) {
+            std::vector<ModelIndex> partIndices;
+            if (p._indices != INVALID_INDEX) {
+                const auto& indexAccess = model._accessors[p._indices];
+                uint32_t indexMask = componentTypeInt32Mask(indexAccess._componentType);
+                for (uint32_t i = 0; i < indexAccess._elementCount; ++i) {
+                    uint32_t index = 0;
+                    memcpy(&index, elementPtr(p._indices, i), componentTypeSize(indexAccess._componentType));
+                    partIndices.emplace_back(index & indexMask);
+                }
+            } else {
+                for (uint32_t i = 0; i < model._accessors[p._positions]._elementCount; ++i) {
+                    partIndices.emplace_back(i);
+                }
+            }
+
+            std::function<core::vec3(uint32_t)> positionGetter = [&](uint32_t index) {
+                auto pos = (const float*) elementPtr(p._positions, index);
+                return core::vec3(pos[0], pos[1], pos[2]);
+            };
+            std::function<uint32_t(uint32_t)> normalGetter = [](uint32_t) { return 0u; };
+            if (p._normals != INVALID_INDEX) {
+                normalGetter = [&](uint32_t index) {
+                    auto nor = (const float*) elementPtr(p._normals, index);
+                    return core::packNormal32I(core::vec3(nor[0], nor[1], nor[2]));
+                };
+            }
+            std::function<core::vec2(uint32_t)> texcoordGetter = [](uint32_t) { return core::vec2(); };
+            if (p._texcoords != INVALID_INDEX) {
+                texcoordGetter = [&](uint32_t index) {
+                    auto texcoord = (const float*) elementPtr(p._texcoords, index);
+                    return core::vec2(texcoord[0], texcoord[1]);
+                };
+            }
+            std::function<core::ivec2(uint32_t)> skinWeightJointGetter = [](uint32_t) { return core::ivec2(); };
+            if (p._weights != INVALID_INDEX && p._joints != INVALID_INDEX) {
+                skinWeightJointGetter = [&](uint32_t index) {
+                    auto weightSize = componentTypeSize(model._accessors[p._weights]._componentType);
+                    auto jointSize = componentTypeSize(model._accessors[p._joints]._componentType);
+                    auto jointMask = componentTypeInt32Mask(model._accessors[p._joints]._componentType);
+                    auto weight_m = elementPtr(p._weights, index);
+                    auto joint_m = elementPtr(p._joints, index);
+                    uint32_t viw = 0;
+                    uint32_t vij = 0;
+                    for (int c = 0; c < 4; ++c) {
+                        float w = 0.0f;
+                        uint32_t j = 0;
+                        memcpy(&w, weight_m + c * weightSize, sizeof(float));
+                        memcpy(&j, joint_m + c * jointSize, jointSize);
+                        viw = viw | ((0xff & (uint32_t)(255 * w)) << (c * 8));
+                        vij = vij | ((0xff & (j & jointMask)) << (c * 8));
+                    }
+                    return core::ivec2(viw, vij);
+                };
+            }
+
+            for (uint32_t i = 0; i < partIndices.size(); ++i) {
+                uint32_t index = partIndices[i];
+                auto vp = positionGetter(index);
+                auto vn = normalGetter(index);
+                auto vt = texcoordGetter(index);
+                auto swj = skinWeightJointGetter(index);
+                ModelVertex v{ vp.x, vp.y, vp.z, vn };
+                ModelVertexAttrib a{ vt.x, vt.y, (uint32_t) swj.x, (uint32_t) swj.y };
+
+                size_t kv = core::hash<float, float, float, int>{}(v.px, v.py, v.pz, v.n);
+                uint64_t ka = 0;
+                memcpy(&ka, &a, sizeof(uint64_t));
+
+                auto v_bucket = indexedVertexMap.find(kv);
+                if (v_bucket == indexedVertexMap.end()) {
+                    index = (uint32_t) vertex_buffer.size();
+                    vertex_buffer.emplace_back(v);
+                    vertex_attrib_buffer.emplace_back(a);
+                    indexedVertexMap.insert({ kv, { index, {{ ka, index }} } });
+                    mainVertexIndices.emplace_back(index);
+                } else {
+                    auto& bucket = v_bucket->second.attribs;
+                    index = (uint32_t) -1;
+                    for (auto& va : bucket) {
+                        if (va.first == ka) {
+                            index = va.second;
+                            break;
+                        }
+                    }
+                    if (index == (uint32_t) -1) {
+                        index = (uint32_t) vertex_buffer.size();
+                        vertex_buffer.emplace_back(v);
+                        vertex_attrib_buffer.emplace_back(a);
+                        bucket.emplace_back(ka, index);
+                        mainVertexIndices.emplace_back(v_bucket->second.index);
+                    }
+                }
+                index_buffer.emplace_back(index);
+            }
+        }
+        return vertex_buffer.size();
+    }
+
+    // The current weld: typed decode and weld of each primitive in parallel, then the merge weld
+    size_t weldPrimitives(const document::Model& model) {
+        using namespace graphics;
+        uint32_t numPrimitives = (uint32_t) model._primitives.size();
+        std::vector<std::vector<WeldVertex>> primitiveVertices(numPrimitives);
+        std::vector<std::vector<ModelIndex>> primitiveIndices(numPrimitives);
+        core::ThreadPool::shared().parallel_for(numPrimitives, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t pi = begin; pi < end; ++pi) {
+                weldPrimitive(model, model._primitives[pi], primitiveVertices[pi], primitiveIndices[pi]);
+            }
+        });
+        std::vector<WeldVertex> allVertices;
+        for (auto& vertices : primitiveVertices) {
+            allVertices.insert(allVertices.end(), vertices.begin(), vertices.end());
+        }
+        core::WeldResult merged;
+        core::weld(allVertices.data(), (uint32_t) allVertices.size(), merged);
+        return merged.vertices.size();
+    }
+}
+
+void runModelDrawBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+    const char* files[] = {
+        "../asset/gltf/toycar/ToyCar.gltf",
+        "../asset/gltf/AntiqueCamera.gltf",
+        "../asset/gltf/Boombox/BoomBoxWithAxes.gltf",
+        "../asset/gltf/DamagedHelmet/DamagedHelmet.gltf",
+        "../asset/gltf/Lantern/Lantern.gltf",
+    };
+
+    for (const auto* f : files) {
+        auto model = document::model::Model::createFromGLTF(f);
+        if (!model) {
+            picoLogf("ModelDrawBench {}: can't be loaded, skipped", f);
+            continue;
+        }
+        size_t numIndices = 0;
+        for (const auto& p : model->_primitives) {
+            numIndices += (p._indices != document::model::INVALID_INDEX ? model->_accessors[p._indices]._elementCount : model->_accessors[p._positions]._elementCount);
+        }
+
+        // Best of a few runs, the first one also pages the buffers in
+        constexpr int NUM_RUNS = 5;
+        double beforeMs = 1e30, afterMs = 1e30;
+        size_t beforeVertices = 0, afterVertices = 0;
+        for (int r = 0; r < NUM_RUNS; ++r) {
+            auto start = clock::now();
+            beforeVertices = weldSequentialGetters(*model);
+            beforeMs = std::min(beforeMs, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+            start = clock::now();
+            afterVertices = weldPrimitives(*model);
+            afterMs = std::min(afterMs, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+        picoLogf("ModelDrawBench {}: {} primitives {} indices, getters + map weld {:.2f} ms ({} vertices), primitive weld {:.2f} ms ({} vertices), x{:.2f}",
+            model->_name, model->_primitives.size(), numIndices, beforeMs, beforeVertices, afterMs, afterVertices, beforeMs / afterMs);
+    }
+}
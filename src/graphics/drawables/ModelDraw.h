@@ -28,6 +28,9 @@
 
 #include <memory>
 #include <core/math/Math3D.h>
+#include <core/math/CameraTransform.h>
+#include <core/mesh/Meshlet.h>
+#include <core/mesh/Skinning.h>
 #include "dllmain.h"
 #include <document/Model.h>
 #include <render/Scene.h>
@@ -41,6 +44,10 @@ namespace graphics {
     using BufferPointer = std::shared_ptr<Buffer>;
     class PipelineState;
     using PipelineStatePointer = std::shared_ptr<PipelineState>;
+    class StreamingQueue;
+    using StreamingQueuePointer = std::shared_ptr<StreamingQueue>;
+    class StreamResidency;
+    using StreamResidencyPointer = std::shared_ptr<StreamResidency>;
 
     class ModelDraw;
     class ModelDrawPart;
@@ -64,6 +71,14 @@ namespace graphics {
         // Create ModelDraw for a given Model document
         graphics::ModelDraw* createModel(const graphics::DevicePointer& device, const document::ModelPointer& model);
 
+        // Create ModelDraw for a glTF file, the processed model is saved next to the file
+        // and loaded back instead of the document as long as the sources are unchanged (see ModelDrawCache.h)
+        graphics::ModelDraw* createModelFromFile(const graphics::DevicePointer& device, const std::string& filename);
+
+        // CPU side of createModel: the geometry, meshlets, skins, local nodes, materials and animations of the model.
+        // The decoded images are moved out of the document into images.
+        static void buildModel(document::Model& model, graphics::ModelDraw& draw, std::vector<document::Image>& images);
+
         // Create Drawcall object drawing the ModelDraw in the rendering context
         void allocateDrawcallObject(
             const graphics::DevicePointer& device,
@@ -78,12 +93,24 @@ namespace graphics {
         ModelDrawUniforms& editUniforms() { return (*_sharedUniforms); }
         ModelDrawUniformsPointer getUniformsPtr() const { return _sharedUniforms; }
 
+        // With a streaming queue, the models created next upload their buffers and textures through it,
+        // the geometry first then the textures. The parts are not drawn until their geometry is resident
+        // and a placeholder texture is bound until the albedo texture is.
+        void setStreamingQueue(const graphics::StreamingQueuePointer& queue) { _streamingQueue = queue; }
+        const graphics::StreamingQueuePointer& getStreamingQueue() const { return _streamingQueue; }
+
     protected:
         ModelDrawUniformsPointer _sharedUniforms;
         graphics::PipelineStatePointer _pipeline;
 
+        graphics::StreamingQueuePointer _streamingQueue;
+        graphics::TexturePointer _placeholderTexture; // 1 white texel, bound in place of the albedo texture while streamed
+
         // Cache the shaders and pipeline to share them accross multiple instances of drawcalls
         void allocateGPUShared(const graphics::DevicePointer& device);
+
+        // GPU side of createModel: the buffers, material textures and ray tracing geometry of a built model
+        void allocateModelGPU(const graphics::DevicePointer& device, graphics::ModelDraw& draw, std::vector<document::Image>& images);
     };
     using ModelDrawFactoryPointer = std::shared_ptr< ModelDrawFactory>;
 
@@ -110,6 +137,12 @@ namespace graphics {
         uint32_t skinOffset{ MODEL_INVALID_INDEX };
     };
 
+    // Range of the meshlets of a part in the model meshlet arrays
+    struct ModelPartMeshlets {
+        uint32_t meshletOffset{ 0 };
+        uint32_t numMeshlets{ 0 };
+    };
+
     struct ModelMaterial {
         core::vec4 color{0.5f, 0.5f, 0.5f, 1.0f};
         float metallic{ 1.0f };
@@ -157,6 +190,18 @@ namespace graphics {
         core::ivec4  bone; // also contains the joint id in joint.x
     };
 
+    // CPU side of a skinned part: the bind pose and influences of its vertices in SoA streams
+    // and the bounds of these vertices per joint, see core/mesh/Skinning.h
+    struct ModelPartSkin {
+        uint32_t part{ MODEL_INVALID_INDEX };
+        uint32_t skin{ MODEL_INVALID_INDEX };
+        uint32_t node{ MODEL_INVALID_INDEX }; // local node of the item drawing the part, skinned positions are in its space
+        std::vector<uint32_t> vertices;       // part skin vertex -> index in _vertices
+        core::vec3_stream bindPositions;
+        core::skin_stream influences;
+        core::SkinJointBounds jointBounds;
+    };
+
     class VISUALIZATION_API ModelDraw {
     public:
         virtual ~ModelDraw() {}
@@ -165,6 +210,8 @@ namespace graphics {
 
         DrawBound getBound() const { return _bound; }
         DrawObjectCallback getDrawcall() const { return _drawcall; }
+        DrawStateKey getStateKey() const { return _stateKey; }
+        DrawPrepareCallback getPreparecall() const { return _preparecall; }
 
         // immutable buffer containing the vertices, indices, parts and materials of the model
         graphics::BufferPointer getVertexBuffer() const { return _vertexBuffer; }
@@ -175,6 +222,13 @@ namespace graphics {
         graphics::BufferPointer getMaterialBuffer() const { return _materialBuffer; }
         graphics::TexturePointer getAlbedoTexture() const { return _albedoTexture; }
 
+        // A streamed model is drawn once its geometry is resident, with its albedo texture once resident.
+        // Always resident when not streamed.
+        bool isGeometryResident() const;
+        bool isTextureResident() const;
+
+        std::vector<ModelMaterial> _materials;
+
         std::vector<ModelVertex> _vertices;
         std::vector<ModelVertexAttrib> _vertex_attribs;
         std::vector<ModelIndex> _indices;
@@ -182,6 +236,17 @@ namespace graphics {
         std::vector<core::aabox3> _partAABBs;
         std::vector<ModelShape> _shapes;
 
+        // Meshlets of the parts, up to 64 vertices and 124 triangles with their culling bounds
+        std::vector<ModelPartMeshlets> _partMeshlets;
+        std::vector<core::Meshlet> _meshlets;
+        std::vector<core::MeshletBounds> _meshletBounds;
+        std::vector<uint32_t> _meshletVertices;  // meshlet vertex -> index in _vertices
+        std::vector<uint32_t> _meshletTriangles; // 3 meshlet vertices packed in 8 bits each
+
+        // CPU cluster culling of a part placed by transform, appends the visible meshlet indices.
+        // Returns the number of visible meshlets.
+        uint32_t cullPartMeshlets(uint32_t part, const core::mat4x3& transform, const core::View& view, const core::Projection& projection, std::vector<uint32_t>& visible) const;
+
         // Connectivity information of the meshes
         graphics::BufferPointer getEdgeBuffer() const { return _edgeBuffer; }
         graphics::BufferPointer getFaceBuffer() const { return _faceBuffer; }
@@ -193,15 +258,44 @@ namespace graphics {
         std::vector<ModelSkinJointBinding> _skinJointBindings;
         graphics::BufferPointer getSkinBuffer() const { return _skinBuffer; }
 
+        // CPU skinning of the parts drawn by a skinned item
+        std::vector<ModelPartSkin> _partSkins;
+
+        // Build the _partSkins of the skinned items from the vertices and the skin joint bindings
+        void buildPartSkins();
+
+        // Joint matrices (joint to mesh node space) and skin matrices (joint matrices * inverse bind pose)
+        // of a skin for the model instance under modelNode, the local node i is the scene node modelNode + 1 + i.
+        void evalSkinMatrices(uint32_t skin, uint32_t meshNode, const NodeStore& nodes, NodeID modelNode,
+            std::vector<core::mat4x3>& jointMatrices, std::vector<core::mat4x3>& skinMatrices) const;
+
+        // Skin the vertices of _partSkins[partSkin] in the current pose, in the order of ModelPartSkin::vertices
+        void skinPart(uint32_t partSkin, const NodeStore& nodes, NodeID modelNode, core::vec3_stream& positions) const;
+
+        // Part bounds of the model instance in the current pose: the bind pose _partAABBs for the rigid parts
+        // and the joint bounds placed by the joint matrices for the skinned parts, no vertex is touched.
+        void evalPartBounds(const NodeStore& nodes, NodeID modelNode, std::vector<core::aabox3>& partBounds) const;
+
+        // The instances of a skinned model, the item drawing each of the _partSkins under the model node
+        struct SkinnedInstance {
+            NodeID modelNode{ INVALID_NODE_ID };
+            ItemIDs partSkinItems;
+        };
+        std::vector<SkinnedInstance> _skinnedInstances;
+
+        // Set the local bound of the skinned part items of every instance to its bound in the current pose,
+        // done by the prepare call of the model draw once the node transforms of the frame are updated
+        void updateSkinnedBounds(ItemStore& items, const NodeStore& nodes) const;
+
         // Utility mesh connectivity information:
         // For each part, we create one draw
         DrawIDs _partDraws;
 
         // Self DrawID
-        DrawID _drawID;
+        DrawID _drawID{ INVALID_DRAW_ID };
 
-        // Self AnimID
-        AnimID _animID;
+        // Self AnimID, stays invalid for a model without animation
+        AnimID _animID{ INVALID_ANIM_ID };
 
         // Local nodes hierarchy in the model, used to create concrete instances of scene nodes when
         // instanciating a model in the scene 
@@ -228,6 +322,7 @@ namespace graphics {
     protected:
         friend class ModelDrawFactory;
         friend class ModelDrawInspectorFactory;
+        friend class ModelDrawCache;
 
         graphics::BufferPointer _vertexBuffer; // core vertex attribs: pos
         graphics::BufferPointer _vertexAttribBuffer; // extra vertex attribs texcoord, ...
@@ -243,9 +338,16 @@ namespace graphics {
         graphics::BufferPointer _skinBuffer;
 
         graphics::DescriptorSetPointer  _descriptorSet;
+        graphics::DescriptorSetPointer  _placeholderDescriptorSet; // bound until the albedo texture is resident
+
+        // The pending uploads of the streamed buffers and textures, null when not streamed
+        graphics::StreamResidencyPointer _geometryResidency;
+        graphics::StreamResidencyPointer _textureResidency;
 
         ModelDrawUniformsPointer _uniforms;
         DrawObjectCallback _drawcall;
+        DrawPrepareCallback _preparecall;
+        DrawStateKey _stateKey{ UNSORTED_DRAW_STATE_KEY };
         core::aabox3 _bound;
     };
     using ModelDrawPointer = std::shared_ptr< ModelDraw>;
@@ -255,11 +357,14 @@ namespace graphics {
     public:
         DrawBound getBound() const { return _bound; }
         DrawObjectCallback getDrawcall() const { return _drawcall; }
-        
+        DrawStateKey getStateKey() const { return _stateKey; }
+        DrawInstancesCallback getInstancesDrawcall() const { return _instancesDrawcall; }
         
     protected:
         friend class ModelDrawFactory;
         DrawObjectCallback _drawcall;
+        DrawInstancesCallback _instancesDrawcall;
+        DrawStateKey _stateKey{ UNSORTED_DRAW_STATE_KEY };
         core::aabox3 _bound;
     };
     
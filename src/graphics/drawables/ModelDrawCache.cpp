@@ -0,0 +1,775 @@
+// ModelDrawCache.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ModelDrawCache.h"
+#include "ModelDraw.h"
+
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+#include <core/MappedFile.h>
+#include <core/json/json.h>
+#include <core/Log.h>
+
+namespace graphics
+{
+    namespace {
+        const uint32_t MODEL_CACHE_MAGIC = 0x43444D50; // "PMDC"
+        const uint32_t MODEL_CACHE_VERSION = 2;
+        const uint64_t MODEL_CACHE_ALIGNMENT = 16;
+
+        enum Section : uint32_t {
+            NAME_OFFSETS = 0, // string table: the model name, the local node names then the clip names
+            NAME_CHARS,
+            VERTICES,
+            VERTEX_ATTRIBS,
+            INDICES,
+            PARTS,
+            PART_AABBS,
+            SHAPES,
+            PART_MESHLETS,
+            MESHLETS,
+            MESHLET_BOUNDS,
+            MESHLET_VERTICES,
+            MESHLET_TRIANGLES,
+            EDGES,
+            FACES,
+            SKINS,
+            SKIN_JOINT_BINDINGS,
+            NODE_TRANSFORMS,
+            NODE_PARENTS,
+            ROOT_NODES,
+            ITEMS,
+            CAMERAS,
+            MATERIALS,
+            BOUND,
+            CLIP_BUFFER,
+            CLIP_ACCESSORS,
+            CLIP_SAMPLERS,
+            CLIP_TRACKS,
+            CLIP_TIMES,
+            CLIP_KEYS,
+            CLIPS,
+            CLIP_CHANNELS,
+            IMAGE_DESCS,
+            IMAGE_PIXELS,
+            NUM_SECTIONS
+        };
+
+        struct ModelCacheFileHeader {
+            uint32_t magic{ MODEL_CACHE_MAGIC };
+            uint32_t version{ MODEL_CACHE_VERSION };
+            uint32_t importerVersion{ ModelDrawCache::IMPORTER_VERSION };
+            uint32_t numSections{ NUM_SECTIONS };
+            uint64_t sourceHash{ 0 };
+            uint64_t fileSize{ 0 };
+            uint64_t checksum{ 0 }; // of the bytes after the header, the section table and the sections
+        };
+
+        struct ModelCacheSection {
+            uint64_t offset{ 0 };
+            uint64_t size{ 0 };
+        };
+
+        // A clip without its name and channels, these are in the string table and the CLIP_CHANNELS section
+        struct ModelCacheClip {
+            float beginTime{ 0.0f };
+            float endTime{ 0.0f };
+            uint32_t channelOffset{ 0 };
+            uint32_t numChannels{ 0 };
+        };
+
+        // Hash 64 bits words at a time, the tail bytes are zero padded.
+        // The bytes can be given in several chunks, the key is the same as in one go
+        struct ByteHasher {
+            uint64_t h;
+            uint64_t size{ 0 };
+            uint64_t tail{ 0 };
+
+            void mix(uint64_t w) {
+                h ^= w;
+                h *= 0xFF51AFD7ED558CCDull;
+                h ^= h >> 32;
+            }
+            ByteHasher& bytes(const uint8_t* data, uint64_t n) {
+                uint64_t numTailBytes = size % sizeof(uint64_t);
+                size += n;
+                if (numTailBytes) {
+                    uint64_t c = std::min(n, sizeof(uint64_t) - numTailBytes);
+                    memcpy(reinterpret_cast<uint8_t*>(&tail) + numTailBytes, data, c);
+                    data += c;
+                    n -= c;
+                    if (numTailBytes + c < sizeof(uint64_t)) {
+                        return *this;
+                    }
+                    mix(tail);
+                    tail = 0;
+                }
+                uint64_t numWords = n / sizeof(uint64_t);
+                for (uint64_t i = 0; i < numWords; ++i) {
+                    uint64_t w;
+                    memcpy(&w, data + i * sizeof(uint64_t), sizeof(uint64_t));
+                    mix(w);
+                }
+                memcpy(&tail, data + numWords * sizeof(uint64_t), n - numWords * sizeof(uint64_t));
+                return *this;
+            }
+            uint64_t key() {
+                mix(tail);
+                mix(size);
+                return h;
+            }
+        };
+
+        uint64_t hashBytes(const uint8_t* data, uint64_t size, uint64_t h) {
+            return ByteHasher{ h }.bytes(data, size).key();
+        }
+
+        const uint64_t MODEL_CACHE_CHECKSUM_SEED = 0xC2B2AE3D27D4EB4Full;
+
+        // The chunks of bytes written one after the other in a section
+        struct SectionWriter {
+            std::vector<std::pair<const void*, uint64_t>> chunks[NUM_SECTIONS];
+
+            template <typename T> void add(Section s, const std::vector<T>& v) {
+                static_assert(std::is_standard_layout_v<T>, "cached arrays are copied as raw bytes");
+                chunks[s].emplace_back(v.data(), v.size() * sizeof(T));
+            }
+            template <typename T> void add(Section s, const T& v) {
+                static_assert(std::is_standard_layout_v<T>, "cached values are copied as raw bytes");
+                chunks[s].emplace_back(&v, sizeof(T));
+            }
+        };
+
+        // The sections of a mapped cache file, checked against the file size
+        struct SectionReader {
+            const uint8_t* data{ nullptr };
+            ModelCacheSection sections[NUM_SECTIONS];
+
+            template <typename T> uint64_t count(Section s) const { return sections[s].size / sizeof(T); }
+            template <typename T> bool isArrayOf(Section s) const { return (sections[s].size % sizeof(T)) == 0; }
+            template <typename T> void read(Section s, std::vector<T>& v) const {
+                v.resize(count<T>(s));
+                memcpy(v.data(), data + sections[s].offset, sections[s].size);
+            }
+            template <typename T> const T* view(Section s) const { return reinterpret_cast<const T*>(data + sections[s].offset); }
+        };
+    }
+
+    uint64_t ModelDrawCache::hashSource(const std::string& filename) {
+        core::MappedFile file;
+        if (!file.open(filename)) {
+            return 0;
+        }
+        uint64_t h = hashBytes(file.data(), file.size(), 0x9E3779B97F4A7C15ull);
+
+        // The buffers and images in external files are part of the content
+        core::json gltf;
+        try {
+            gltf = core::json::parse(file.data(), file.data() + file.size());
+        }
+        catch (...) {
+            return h;
+        }
+        if (!gltf.is_object()) {
+            return h;
+        }
+        auto root = std::filesystem::path(filename).parent_path();
+        for (const char* key : { "buffers", "images" }) {
+            auto it = gltf.find(key);
+            if (it == gltf.end() || !it->is_array()) {
+                continue;
+            }
+            for (const auto& element : *it) {
+                auto uri = element.find("uri");
+                if (uri == element.end() || !uri->is_string()) {
+                    continue;
+                }
+                const auto& uriString = uri->get_ref<const std::string&>();
+                if (uriString.rfind("data:", 0) == 0) {
+                    continue; // embedded, already hashed with the gltf
+                }
+                core::MappedFile dependency;
+                if (dependency.open((root / uriString).string())) {
+                    h = hashBytes(dependency.data(), dependency.size(), h);
+                } else {
+                    h = hashBytes((const uint8_t*) uriString.data(), uriString.size(), ~h); // missing file
+                }
+            }
+        }
+        return (h ? h : 1);
+    }
+
+    bool ModelDrawCache::save(const std::string& filename, uint64_t sourceHash, const ModelDraw& draw, const std::vector<document::Image>& images) {
+        // Flatten the strings, the clips and the images
+        std::vector<uint32_t> nameOffsets;
+        std::string nameChars;
+        auto addName = [&](const std::string& name) {
+            nameOffsets.emplace_back((uint32_t) nameChars.size());
+            nameChars += name;
+        };
+        addName(draw._name);
+        for (const auto& n : draw._localNodeNames) {
+            addName(n);
+        }
+
+        std::vector<ModelCacheClip> clips;
+        std::vector<Key::Channel> clipChannels;
+        const Key::ClipData* clipData = nullptr;
+        if (draw._animations) {
+            clipData = &draw._animations->_data;
+            for (const auto& c : draw._animations->_clips) {
+                addName(c._name);
+                clips.emplace_back(ModelCacheClip{ c._beginTime, c._endTime, (uint32_t) clipChannels.size(), (uint32_t) c._channels.size() });
+                clipChannels.insert(clipChannels.end(), c._channels.begin(), c._channels.end());
+            }
+        }
+        nameOffsets.emplace_back((uint32_t) nameChars.size());
+
+        std::vector<document::ImageDesc> imageDescs;
+        for (const auto& i : images) {
+            imageDescs.emplace_back(i._desc);
+            imageDescs.back().pixels_size = i._pixels.size();
+        }
+
+        SectionWriter writer;
+        writer.add(NAME_OFFSETS, nameOffsets);
+        writer.chunks[NAME_CHARS].emplace_back(nameChars.data(), nameChars.size());
+        writer.add(VERTICES, draw._vertices);
+        writer.add(VERTEX_ATTRIBS, draw._vertex_attribs);
+        writer.add(INDICES, draw._indices);
+        writer.add(PARTS, draw._parts);
+        writer.add(PART_AABBS, draw._partAABBs);
+        writer.add(SHAPES, draw._shapes);
+        writer.add(PART_MESHLETS, draw._partMeshlets);
+        writer.add(MESHLETS, draw._meshlets);
+        writer.add(MESHLET_BOUNDS, draw._meshletBounds);
+        writer.add(MESHLET_VERTICES, draw._meshletVertices);
+        writer.add(MESHLET_TRIANGLES, draw._meshletTriangles);
+        writer.add(EDGES, draw._edges);
+        writer.add(FACES, draw._faces);
+        writer.add(SKINS, draw._skins);
+        writer.add(SKIN_JOINT_BINDINGS, draw._skinJointBindings);
+        writer.add(NODE_TRANSFORMS, draw._localNodeTransforms);
+        writer.add(NODE_PARENTS, draw._localNodeParents);
+        writer.add(ROOT_NODES, draw._localRootNodes);
+        writer.add(ITEMS, draw._localItems);
+        writer.add(CAMERAS, draw._localCameras);
+        writer.add(MATERIALS, draw._materials);
+        writer.add(BOUND, draw._bound);
+        if (clipData) {
+            writer.add(CLIP_BUFFER, clipData->_buffer);
+            writer.add(CLIP_ACCESSORS, clipData->_accessors);
+            writer.add(CLIP_SAMPLERS, clipData->_samplers);
+            writer.add(CLIP_TRACKS, clipData->_compressed.tracks);
+            writer.add(CLIP_TIMES, clipData->_compressed.times);
+            writer.add(CLIP_KEYS, clipData->_compressed.keys);
+        }
+        writer.add(CLIPS, clips);
+        writer.add(CLIP_CHANNELS, clipChannels);
+        writer.add(IMAGE_DESCS, imageDescs);
+        for (const auto& i : images) {
+            writer.add(IMAGE_PIXELS, i._pixels);
+        }
+
+        // Lay the sections out after the header and the table
+        ModelCacheFileHeader header;
+        header.sourceHash = sourceHash;
+        ModelCacheSection sections[NUM_SECTIONS];
+        uint64_t offset = sizeof(header) + sizeof(sections);
+        for (uint32_t s = 0; s < NUM_SECTIONS; ++s) {
+            offset = (offset + MODEL_CACHE_ALIGNMENT - 1) & ~(MODEL_CACHE_ALIGNMENT - 1);
+            sections[s].offset = offset;
+            for (const auto& c : writer.chunks[s]) {
+                sections[s].size += c.second;
+            }
+            offset += sections[s].size;
+        }
+        header.fileSize = offset;
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        // The header goes again once the checksum of what follows is known
+        file.write((const char*) &header, sizeof(header));
+        ByteHasher checksum{ MODEL_CACHE_CHECKSUM_SEED };
+        auto write = [&](const void* data, uint64_t size) {
+            file.write((const char*) data, size);
+            checksum.bytes((const uint8_t*) data, size);
+        };
+        write(sections, sizeof(sections));
+        uint64_t written = sizeof(header) + sizeof(sections);
+        const char padding[MODEL_CACHE_ALIGNMENT] = {};
+        for (uint32_t s = 0; s < NUM_SECTIONS; ++s) {
+            write(padding, sections[s].offset - written);
+            for (const auto& c : writer.chunks[s]) {
+                write(c.first, c.second);
+            }
+            written = sections[s].offset + sections[s].size;
+        }
+        header.checksum = checksum.key();
+        file.seekp(0);
+        file.write((const char*) &header, sizeof(header));
+        return file.good();
+    }
+
+    bool ModelDrawCache::load(const std::string& filename, uint64_t sourceHash, ModelDraw& draw, std::vector<document::Image>& images) {
+        core::MappedFile file;
+        if (!file.open(filename)) {
+            return false;
+        }
+        ModelCacheFileHeader header;
+        SectionReader reader;
+        if (file.size() < sizeof(header) + sizeof(reader.sections)) {
+            return false;
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        if (header.magic != MODEL_CACHE_MAGIC || header.version != MODEL_CACHE_VERSION || header.numSections != NUM_SECTIONS ||
+            header.importerVersion != IMPORTER_VERSION || header.sourceHash != sourceHash) {
+            return false;
+        }
+        if (header.fileSize != file.size()) {
+            picoLog("model cache file " + filename + " is truncated");
+            return false;
+        }
+        if (hashBytes(file.data() + sizeof(header), file.size() - sizeof(header), MODEL_CACHE_CHECKSUM_SEED) != header.checksum) {
+            picoLog("model cache file " + filename + " is corrupted");
+            return false;
+        }
+        reader.data = file.data();
+        memcpy(reader.sections, file.data() + sizeof(header), sizeof(reader.sections));
+        for (const auto& s : reader.sections) {
+            if (s.offset % MODEL_CACHE_ALIGNMENT || s.offset > file.size() || s.size > file.size() - s.offset) {
+                picoLog("model cache file " + filename + " is corrupted");
+                return false;
+            }
+        }
+
+        // Check every array before touching the draw
+        bool valid = reader.isArrayOf<uint32_t>(NAME_OFFSETS) && reader.isArrayOf<ModelVertex>(VERTICES) && reader.isArrayOf<ModelVertexAttrib>(VERTEX_ATTRIBS)
+            && reader.isArrayOf<ModelIndex>(INDICES) && reader.isArrayOf<ModelPart>(PARTS) && reader.isArrayOf<core::aabox3>(PART_AABBS)
+            && reader.isArrayOf<ModelShape>(SHAPES) && reader.isArrayOf<ModelPartMeshlets>(PART_MESHLETS) && reader.isArrayOf<core::Meshlet>(MESHLETS)
+            && reader.isArrayOf<core::MeshletBounds>(MESHLET_BOUNDS) && reader.isArrayOf<uint32_t>(MESHLET_VERTICES) && reader.isArrayOf<uint32_t>(MESHLET_TRIANGLES)
+            && reader.isArrayOf<ModelEdge>(EDGES) && reader.isArrayOf<ModelFace>(FACES) && reader.isArrayOf<ModelSkin>(SKINS)
+            && reader.isArrayOf<ModelSkinJointBinding>(SKIN_JOINT_BINDINGS) && reader.isArrayOf<core::mat4x3>(NODE_TRANSFORMS) && reader.isArrayOf<uint32_t>(NODE_PARENTS)
+            && reader.isArrayOf<uint32_t>(ROOT_NODES) && reader.isArrayOf<ModelItem>(ITEMS) && reader.isArrayOf<ModelCamera>(CAMERAS)
+            && reader.isArrayOf<ModelMaterial>(MATERIALS) && reader.sections[BOUND].size == sizeof(core::aabox3)
+            && reader.isArrayOf<Key::Accessor>(CLIP_ACCESSORS) && reader.isArrayOf<Key::Sampler>(CLIP_SAMPLERS) && reader.isArrayOf<core::KeyframeTrack>(CLIP_TRACKS)
+            && reader.isArrayOf<float>(CLIP_TIMES) && reader.isArrayOf<uint16_t>(CLIP_KEYS) && reader.isArrayOf<ModelCacheClip>(CLIPS)
+            && reader.isArrayOf<Key::Channel>(CLIP_CHANNELS) && reader.isArrayOf<document::ImageDesc>(IMAGE_DESCS);
+
+        uint64_t numNodes = reader.count<uint32_t>(NODE_PARENTS);
+        uint64_t numClips = reader.count<ModelCacheClip>(CLIPS);
+        uint64_t numNames = 1 + numNodes + numClips;
+        valid = valid && reader.count<core::mat4x3>(NODE_TRANSFORMS) == numNodes && reader.count<uint32_t>(NAME_OFFSETS) == numNames + 1;
+        const uint32_t* nameOffsets = reader.view<uint32_t>(NAME_OFFSETS);
+        for (uint64_t n = 0; valid && n < numNames; ++n) {
+            valid = nameOffsets[n] <= nameOffsets[n + 1];
+        }
+        valid = valid && nameOffsets[numNames] == reader.sections[NAME_CHARS].size;
+
+        const ModelCacheClip* clips = reader.view<ModelCacheClip>(CLIPS);
+        uint64_t numClipChannels = reader.count<Key::Channel>(CLIP_CHANNELS);
+        for (uint64_t c = 0; valid && c < numClips; ++c) {
+            valid = uint64_t(clips[c].channelOffset) + clips[c].numChannels <= numClipChannels;
+        }
+
+        const document::ImageDesc* imageDescs = reader.view<document::ImageDesc>(IMAGE_DESCS);
+        uint64_t numImages = reader.count<document::ImageDesc>(IMAGE_DESCS);
+        uint64_t pixelsSize = 0;
+        for (uint64_t i = 0; valid && i < numImages; ++i) {
+            pixelsSize += imageDescs[i].pixels_size;
+        }
+        valid = valid && pixelsSize == reader.sections[IMAGE_PIXELS].size;
+
+        // Then the indices between the arrays, the node tree and the skins are walked as soon as the draw is loaded
+        const uint32_t* nodeParents = reader.view<uint32_t>(NODE_PARENTS);
+        for (uint64_t n = 0; valid && n < numNodes; ++n) {
+            valid = nodeParents[n] == INVALID_NODE_ID || nodeParents[n] < numNodes;
+        }
+        // and the tree has no cycle, every node is reached from the roots
+        Key::Skeleton skeleton;
+        if (valid) {
+            skeleton = Key::createSkeleton(NodeIDs(nodeParents, nodeParents + numNodes));
+            valid = skeleton.joints.size() == numNodes;
+        }
+        const uint32_t* rootNodes = reader.view<uint32_t>(ROOT_NODES);
+        for (uint64_t r = 0; valid && r < reader.count<uint32_t>(ROOT_NODES); ++r) {
+            valid = rootNodes[r] < numNodes;
+        }
+
+        uint64_t numVertices = reader.count<ModelVertex>(VERTICES);
+        uint64_t numAttribs = reader.count<ModelVertexAttrib>(VERTEX_ATTRIBS);
+        uint64_t numIndices = reader.count<ModelIndex>(INDICES);
+        uint64_t numParts = reader.count<ModelPart>(PARTS);
+        const ModelIndex* indices = reader.view<ModelIndex>(INDICES);
+        const ModelPart* parts = reader.view<ModelPart>(PARTS);
+        valid = valid && reader.count<core::aabox3>(PART_AABBS) == numParts;
+        for (uint64_t p = 0; valid && p < numParts; ++p) {
+            const auto& part = parts[p];
+            valid = uint64_t(part.indexOffset) + part.numIndices <= numIndices
+                && (part.material == MODEL_INVALID_INDEX || part.material < reader.count<ModelMaterial>(MATERIALS))
+                && (part.edgeOffset == MODEL_INVALID_INDEX || uint64_t(part.edgeOffset) + part.numEdges <= reader.count<ModelEdge>(EDGES));
+            for (uint32_t i = 0; valid && i < part.numIndices; ++i) {
+                auto index = indices[part.indexOffset + i];
+                valid = uint64_t(part.vertexOffset) + index < numVertices
+                    && (part.attribOffset == MODEL_INVALID_INDEX || uint64_t(part.attribOffset) + index < numAttribs);
+            }
+        }
+        const ModelPartMeshlets* partMeshlets = reader.view<ModelPartMeshlets>(PART_MESHLETS);
+        for (uint64_t p = 0; valid && p < reader.count<ModelPartMeshlets>(PART_MESHLETS); ++p) {
+            valid = uint64_t(partMeshlets[p].meshletOffset) + partMeshlets[p].numMeshlets <= reader.count<core::Meshlet>(MESHLETS);
+        }
+        uint64_t numShapes = reader.count<ModelShape>(SHAPES);
+        const ModelShape* shapes = reader.view<ModelShape>(SHAPES);
+        for (uint64_t s = 0; valid && s < numShapes; ++s) {
+            valid = uint64_t(shapes[s].partOffset) + shapes[s].numParts <= numParts;
+        }
+
+        uint64_t numSkins = reader.count<ModelSkin>(SKINS);
+        const ModelSkin* skins = reader.view<ModelSkin>(SKINS);
+        const ModelSkinJointBinding* jointBindings = reader.view<ModelSkinJointBinding>(SKIN_JOINT_BINDINGS);
+        for (uint64_t s = 0; valid && s < numSkins; ++s) {
+            valid = uint64_t(skins[s].jointOffset) + skins[s].numJoints <= reader.count<ModelSkinJointBinding>(SKIN_JOINT_BINDINGS);
+            for (uint32_t j = 0; valid && j < skins[s].numJoints; ++j) {
+                auto jointNode = jointBindings[skins[s].jointOffset + j].bone.x;
+                valid = jointNode >= 0 && uint64_t(jointNode) < numNodes;
+            }
+        }
+
+        const ModelItem* items = reader.view<ModelItem>(ITEMS);
+        for (uint64_t i = 0; valid && i < reader.count<ModelItem>(ITEMS); ++i) {
+            const auto& item = items[i];
+            valid = item.node < numNodes
+                && (item.shape == MODEL_INVALID_INDEX || item.shape < numShapes)
+                && (item.skin == MODEL_INVALID_INDEX || item.skin < numSkins)
+                && (item.camera == MODEL_INVALID_INDEX || item.camera < reader.count<ModelCamera>(CAMERAS));
+            // a skinned part reads the attribs of its vertices
+            for (uint32_t p = 0; valid && item.shape != MODEL_INVALID_INDEX && item.skin != MODEL_INVALID_INDEX && p < shapes[item.shape].numParts; ++p) {
+                valid = parts[shapes[item.shape].partOffset + p].attribOffset != MODEL_INVALID_INDEX;
+            }
+        }
+
+        uint64_t numSamplers = reader.count<Key::Sampler>(CLIP_SAMPLERS);
+        const Key::Channel* channels = reader.view<Key::Channel>(CLIP_CHANNELS);
+        for (uint64_t c = 0; valid && c < numClipChannels; ++c) {
+            valid = channels[c]._samplerId >= 0 && uint64_t(channels[c]._samplerId) < numSamplers && channels[c]._targetId < numNodes;
+        }
+        if (!valid) {
+            picoLog("model cache file " + filename + " is corrupted");
+            return false;
+        }
+
+        const char* nameChars = reader.view<char>(NAME_CHARS);
+        auto name = [&](uint64_t n) { return std::string(nameChars + nameOffsets[n], nameChars + nameOffsets[n + 1]); };
+        draw._name = name(0);
+        draw._localNodeNames.resize(numNodes);
+        for (uint64_t n = 0; n < numNodes; ++n) {
+            draw._localNodeNames[n] = name(1 + n);
+        }
+
+        reader.read(VERTICES, draw._vertices);
+        reader.read(VERTEX_ATTRIBS, draw._vertex_attribs);
+        reader.read(INDICES, draw._indices);
+        reader.read(PARTS, draw._parts);
+        reader.read(PART_AABBS, draw._partAABBs);
+        reader.read(SHAPES, draw._shapes);
+        reader.read(PART_MESHLETS, draw._partMeshlets);
+        reader.read(MESHLETS, draw._meshlets);
+        reader.read(MESHLET_BOUNDS, draw._meshletBounds);
+        reader.read(MESHLET_VERTICES, draw._meshletVertices);
+        reader.read(MESHLET_TRIANGLES, draw._meshletTriangles);
+        reader.read(EDGES, draw._edges);
+        reader.read(FACES, draw._faces);
+        reader.read(SKINS, draw._skins);
+        reader.read(SKIN_JOINT_BINDINGS, draw._skinJointBindings);
+        reader.read(NODE_TRANSFORMS, draw._localNodeTransforms);
+        reader.read(NODE_PARENTS, draw._localNodeParents);
+        reader.read(ROOT_NODES, draw._localRootNodes);
+        reader.read(ITEMS, draw._localItems);
+        reader.read(CAMERAS, draw._localCameras);
+        reader.read(MATERIALS, draw._materials);
+        draw._bound = *reader.view<core::aabox3>(BOUND);
+
+        draw._animations = std::make_shared<Key>();
+        auto& clipData = draw._animations->_data;
+        reader.read(CLIP_BUFFER, clipData._buffer);
+        reader.read(CLIP_ACCESSORS, clipData._accessors);
+        reader.read(CLIP_SAMPLERS, clipData._samplers);
+        reader.read(CLIP_TRACKS, clipData._compressed.tracks);
+        reader.read(CLIP_TIMES, clipData._compressed.times);
+        reader.read(CLIP_KEYS, clipData._compressed.keys);
+        const Key::Channel* clipChannels = reader.view<Key::Channel>(CLIP_CHANNELS);
+        draw._animations->_clips.resize(numClips);
+        for (uint64_t c = 0; c < numClips; ++c) {
+            auto& clip = draw._animations->_clips[c];
+            clip._name = name(1 + numNodes + c);
+            clip._beginTime = clips[c].beginTime;
+            clip._endTime = clips[c].endTime;
+            clip._channels.assign(clipChannels + clips[c].channelOffset, clipChannels + clips[c].channelOffset + clips[c].numChannels);
+        }
+        draw._animations->_skeleton = std::move(skeleton);
+
+        images.resize(numImages);
+        const uint8_t* pixels = reader.view<uint8_t>(IMAGE_PIXELS);
+        for (uint64_t i = 0; i < numImages; ++i) {
+            images[i]._desc = imageDescs[i];
+            images[i]._pixels.assign(pixels, pixels + imageDescs[i].pixels_size);
+            pixels += imageDescs[i].pixels_size;
+        }
+
+        // The part skins are streams sized for the kernels, rebuilt rather than stored
+        draw.buildPartSkins();
+        return true;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runModelDrawCacheTests() to validate the round trip of a model
+// through the cache and runModelDrawCacheBenchmarks() to compare the cold and warm opens
+// of the sample models
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+
+namespace {
+    template <typename T> bool sameBytes(const std::vector<T>& a, const std::vector<T>& b) {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    bool sameModel(const graphics::ModelDraw& a, const graphics::ModelDraw& b) {
+        auto boundA = a.getBound();
+        auto boundB = b.getBound();
+        bool same = a._name == b._name && a._localNodeNames == b._localNodeNames
+            && sameBytes(a._vertices, b._vertices) && sameBytes(a._vertex_attribs, b._vertex_attribs) && sameBytes(a._indices, b._indices)
+            && sameBytes(a._parts, b._parts) && sameBytes(a._partAABBs, b._partAABBs) && sameBytes(a._shapes, b._shapes)
+            && sameBytes(a._partMeshlets, b._partMeshlets) && sameBytes(a._meshlets, b._meshlets) && sameBytes(a._meshletBounds, b._meshletBounds)
+            && sameBytes(a._meshletVertices, b._meshletVertices) && sameBytes(a._meshletTriangles, b._meshletTriangles)
+            && sameBytes(a._edges, b._edges) && sameBytes(a._faces, b._faces) && sameBytes(a._skins, b._skins) && sameBytes(a._skinJointBindings, b._skinJointBindings)
+            && sameBytes(a._localNodeTransforms, b._localNodeTransforms) && sameBytes(a._localNodeParents, b._localNodeParents)
+            && sameBytes(a._localRootNodes, b._localRootNodes) && sameBytes(a._localItems, b._localItems) && sameBytes(a._localCameras, b._localCameras)
+            && sameBytes(a._materials, b._materials) && memcmp(&boundA, &boundB, sizeof(core::aabox3)) == 0;
+
+        const auto& ka = *a._animations;
+        const auto& kb = *b._animations;
+        same = same && sameBytes(ka._data._buffer, kb._data._buffer) && sameBytes(ka._data._accessors, kb._data._accessors)
+            && sameBytes(ka._data._samplers, kb._data._samplers) && sameBytes(ka._data._compressed.tracks, kb._data._compressed.tracks)
+            && sameBytes(ka._data._compressed.times, kb._data._compressed.times) && sameBytes(ka._data._compressed.keys, kb._data._compressed.keys)
+            && ka._skeleton.joints == kb._skeleton.joints && ka._skeleton.parents == kb._skeleton.parents && ka._clips.size() == kb._clips.size();
+        for (size_t c = 0; same && c < ka._clips.size(); ++c) {
+            same = ka._clips[c]._name == kb._clips[c]._name && ka._clips[c]._beginTime == kb._clips[c]._beginTime
+                && ka._clips[c]._endTime == kb._clips[c]._endTime && sameBytes(ka._clips[c]._channels, kb._clips[c]._channels);
+        }
+
+        same = same && a._partSkins.size() == b._partSkins.size();
+        for (size_t p = 0; same && p < a._partSkins.size(); ++p) {
+            same = a._partSkins[p].part == b._partSkins[p].part && a._partSkins[p].vertices == b._partSkins[p].vertices;
+        }
+        return same;
+    }
+
+    bool sameImages(const std::vector<document::Image>& a, const std::vector<document::Image>& b) {
+        bool same = a.size() == b.size();
+        for (size_t i = 0; same && i < a.size(); ++i) {
+            same = a[i]._desc.width == b[i]._desc.width && a[i]._desc.height == b[i]._desc.height && a[i]._pixels == b[i]._pixels;
+        }
+        return same;
+    }
+
+    std::string tempPath(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::vector<uint8_t> readFile(const std::string& filename) {
+        std::vector<uint8_t> bytes(std::filesystem::file_size(filename));
+        std::ifstream(filename, std::ios::binary).read((char*) bytes.data(), bytes.size());
+        return bytes;
+    }
+
+    void writeFile(const std::string& filename, const std::vector<uint8_t>& bytes) {
+        std::ofstream(filename, std::ios::binary | std::ios::trunc).write((const char*) bytes.data(), bytes.size());
+    }
+}
+
+void runModelDrawCacheTests() {
+    using namespace graphics;
+    picoLog("ModelDrawCacheTest: starting...");
+
+    const std::string foxFile("../asset/gltf/Fox/Fox.gltf");
+    auto cacheFile = tempPath("pico_modeldraw_test.pmdc");
+
+    // --- Test 1: a skinned and animated model comes back identical from the cache ---
+    {
+        auto model = document::model::Model::createFromGLTF(foxFile);
+        assert(model);
+        ModelDraw built;
+        std::vector<document::Image> builtImages;
+        ModelDrawFactory::buildModel(*model, built, builtImages);
+        assert(!built._partSkins.empty() && !built._animations->_clips.empty() && !builtImages.empty());
+
+        auto sourceHash = ModelDrawCache::hashSource(foxFile);
+        assert(sourceHash != 0);
+        assert(ModelDrawCache::save(cacheFile, sourceHash, built, builtImages));
+
+        ModelDraw loaded;
+        std::vector<document::Image> loadedImages;
+        assert(ModelDrawCache::load(cacheFile, sourceHash, loaded, loadedImages));
+        assert(sameModel(built, loaded));
+        assert(sameImages(builtImages, loadedImages));
+        picoLog("ModelDrawCacheTest 1 passed: geometry, skins, nodes, clips and images round trip");
+    }
+
+    // --- Test 2: a stale or damaged cache file is rejected and leaves the draw untouched ---
+    {
+        auto sourceHash = ModelDrawCache::hashSource(foxFile);
+        ModelDraw draw;
+        std::vector<document::Image> images;
+        assert(!ModelDrawCache::load(cacheFile, sourceHash + 1, draw, images));
+        assert(!ModelDrawCache::load(tempPath("pico_modeldraw_missing.pmdc"), sourceHash, draw, images));
+
+        auto size = std::filesystem::file_size(cacheFile);
+        std::filesystem::resize_file(cacheFile, size - 1);
+        assert(!ModelDrawCache::load(cacheFile, sourceHash, draw, images));
+        assert(draw._vertices.empty() && draw._name.empty() && images.empty());
+        std::filesystem::remove(cacheFile);
+        picoLog("ModelDrawCacheTest 2 passed: stale, missing and truncated cache files rejected");
+    }
+
+    // --- Test 3: the source hash follows the content of the referenced files ---
+    {
+        auto dir = std::filesystem::temp_directory_path() / "pico_modeldraw_test";
+        std::filesystem::create_directories(dir);
+        for (const char* f : { "Duck.gltf", "Duck0.bin", "DuckCM.png" }) {
+            std::filesystem::copy_file(std::filesystem::path("../asset/gltf/Duck") / f, dir / f, std::filesystem::copy_options::overwrite_existing);
+        }
+        auto gltfFile = (dir / "Duck.gltf").string();
+        auto h0 = ModelDrawCache::hashSource(gltfFile);
+        assert(h0 != 0 && h0 == ModelDrawCache::hashSource(gltfFile));
+
+        auto bytes = readFile((dir / "Duck0.bin").string());
+        bytes[bytes.size() / 2] ^= 1;
+        writeFile((dir / "Duck0.bin").string(), bytes);
+        auto h1 = ModelDrawCache::hashSource(gltfFile);
+        assert(h1 != 0 && h1 != h0);
+
+        std::filesystem::remove(dir / "DuckCM.png");
+        auto h2 = ModelDrawCache::hashSource(gltfFile);
+        assert(h2 != 0 && h2 != h1);
+        assert(ModelDrawCache::hashSource((dir / "Missing.gltf").string()) == 0);
+        std::filesystem::remove_all(dir);
+        picoLog("ModelDrawCacheTest 3 passed: source hash covers the buffers and images");
+    }
+
+    // --- Test 4: a cache file damaged in place is rejected, by its checksum or by the range of its indices ---
+    {
+        auto model = document::model::Model::createFromGLTF(foxFile);
+        ModelDraw built;
+        std::vector<document::Image> builtImages;
+        ModelDrawFactory::buildModel(*model, built, builtImages);
+        auto sourceHash = ModelDrawCache::hashSource(foxFile);
+        assert(ModelDrawCache::save(cacheFile, sourceHash, built, builtImages));
+        auto bytes = readFile(cacheFile);
+
+        ModelDraw draw;
+        std::vector<document::Image> images;
+        auto flipped = bytes;
+        flipped[bytes.size() / 2] ^= 0x10;
+        writeFile(cacheFile, flipped);
+        assert(!ModelDrawCache::load(cacheFile, sourceHash, draw, images));
+
+        // a node parent out of range, with a checksum matching the damage
+        graphics::ModelCacheFileHeader header;
+        graphics::ModelCacheSection sections[graphics::NUM_SECTIONS];
+        memcpy(&header, bytes.data(), sizeof(header));
+        memcpy(sections, bytes.data() + sizeof(header), sizeof(sections));
+        assert(sections[graphics::NODE_PARENTS].size >= 2 * sizeof(uint32_t));
+        auto parents = bytes;
+        uint32_t badParent = 1000000;
+        memcpy(parents.data() + sections[graphics::NODE_PARENTS].offset + sizeof(uint32_t), &badParent, sizeof(uint32_t));
+        header.checksum = graphics::hashBytes(parents.data() + sizeof(header), parents.size() - sizeof(header), graphics::MODEL_CACHE_CHECKSUM_SEED);
+        memcpy(parents.data(), &header, sizeof(header));
+        writeFile(cacheFile, parents);
+        assert(!ModelDrawCache::load(cacheFile, sourceHash, draw, images));
+        assert(draw._vertices.empty() && draw._name.empty() && images.empty());
+
+        writeFile(cacheFile, bytes);
+        assert(ModelDrawCache::load(cacheFile, sourceHash, draw, images) && sameModel(built, draw));
+        std::filesystem::remove(cacheFile);
+        picoLog("ModelDrawCacheTest 4 passed: flipped byte and out of range node parent rejected");
+    }
+
+    picoLog("ModelDrawCacheTest: all tests passed");
+}
+
+void runModelDrawCacheBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    const char* files[] = {
+        "../asset/gltf/Fox/Fox.gltf",
+        "../asset/gltf/Duck/Duck.gltf",
+        "../asset/gltf/DamagedHelmet/DamagedHelmet.gltf",
+        "../asset/gltf/Boombox/BoomBoxWithAxes.gltf",
+        "../asset/gltf/AntiqueCamera.gltf",
+        "../asset/gltf/Buggy.gltf",
+    };
+    for (const char* f : files) {
+        auto cacheFile = tempPath("pico_modeldraw_bench.pmdc");
+
+        // Cold: parse the document, decode the images and process the geometry
+        auto start = clock::now();
+        auto model = document::model::Model::createFromGLTF(f);
+        if (!model) {
+            continue;
+        }
+        ModelDraw built;
+        std::vector<document::Image> builtImages;
+        ModelDrawFactory::buildModel(*model, built, builtImages);
+        double coldMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        auto sourceHash = ModelDrawCache::hashSource(f);
+        start = clock::now();
+        ModelDrawCache::save(cacheFile, sourceHash, built, builtImages);
+        double saveMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        // Warm: hash the sources and load the cache file
+        start = clock::now();
+        auto warmHash = ModelDrawCache::hashSource(f);
+        double hashMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        ModelDraw loaded;
+        std::vector<document::Image> loadedImages;
+        bool hit = ModelDrawCache::load(cacheFile, warmHash, loaded, loadedImages);
+        double warmMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        picoLogf("ModelDrawCacheBench {}: {} vertices {:.1f} MB | cold {:.2f} ms | save {:.2f} ms | warm {:.2f} ms (hash {:.2f} ms){} | x{:.1f}",
+            built._name, built._vertices.size(), std::filesystem::file_size(cacheFile) / (1024.0 * 1024.0), coldMs, saveMs, warmMs, hashMs,
+            (hit ? "" : " MISS"), coldMs / warmMs);
+        std::filesystem::remove(cacheFile);
+    }
+}
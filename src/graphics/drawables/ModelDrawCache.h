@@ -0,0 +1,59 @@
+// ModelDrawCache.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "dllmain.h"
+#include <document/Image.h>
+
+namespace graphics {
+    class ModelDraw;
+
+    // On disk cache of a ModelDraw processed by ModelDrawFactory::buildModel.
+    // The file is a header, a table of sections and the sections, each one the raw bytes of an array
+    // of the ModelDraw aligned on 16 bytes: a warm load maps the file and copies the arrays back,
+    // only the part skins and the skeleton are rebuilt.
+    // A cache file is valid for the source content hash and the importer version it was saved with,
+    // a checksum of its content and the range of the indices between its arrays are checked on load.
+    class VISUALIZATION_API ModelDrawCache {
+    public:
+        static constexpr const char* EXTENSION = ".pmdc";
+
+        // Bump when the output of buildModel changes, the cache files of the previous versions are rebuilt
+        static const uint32_t IMPORTER_VERSION = 1;
+
+        // Hash of the content of the glTF file and of the buffer and image files it references, 0 if it can't be read
+        static uint64_t hashSource(const std::string& filename);
+
+        static bool save(const std::string& filename, uint64_t sourceHash, const ModelDraw& draw, const std::vector<document::Image>& images);
+
+        // False if the file is missing, stale or invalid, draw and images are then left untouched
+        static bool load(const std::string& filename, uint64_t sourceHash, ModelDraw& draw, std::vector<document::Image>& images);
+    };
+}
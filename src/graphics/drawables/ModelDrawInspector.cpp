@@ -417,6 +417,11 @@ namespace graphics
         modelDraw->_indices = srcDraw->_indices;
         modelDraw->_parts = srcDraw->_parts;
         modelDraw->_partAABBs = srcDraw->_partAABBs;
+        modelDraw->_partMeshlets = srcDraw->_partMeshlets;
+        modelDraw->_meshlets = srcDraw->_meshlets;
+        modelDraw->_meshletBounds = srcDraw->_meshletBounds;
+        modelDraw->_meshletVertices = srcDraw->_meshletVertices;
+        modelDraw->_meshletTriangles = srcDraw->_meshletTriangles;
 
         modelDraw->_edgeBuffer = srcDraw->_edgeBuffer;
         modelDraw->_faceBuffer = srcDraw->_faceBuffer;
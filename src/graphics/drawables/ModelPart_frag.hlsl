@@ -85,6 +85,7 @@ cbuffer UniformBlock1 : register(b1) {
     int _numParts;
     int _numMaterials;
     int _drawMode;
+    int _firstInstance;
 }
 
 struct PixelShaderInput{
@@ -8,6 +8,8 @@ cbuffer UniformBlock1 : register(b1) {
     int _numNodes;
     int _numParts;
     int _numMaterials;
+    int _drawMode;
+    int _firstInstance; // < 0 when not instanced
 }
 
 struct VertexShaderOutput
@@ -27,7 +29,9 @@ Transform evalSkinMatrix(int j, int modelNodeRootIndex) {
    // return mul(skinBindPose, jointGlobalTransform);
 }
 
-VertexShaderOutput main(uint vidx : SV_VertexID) {
+VertexShaderOutput main(uint vidx : SV_VertexID, uint iidx : SV_InstanceID) {
+
+    int nodeID = (_firstInstance < 0 ? _nodeID : instance_getNodeID(_firstInstance, iidx));
 
     // Fetch the part data
     Part p = part_array[_partID];
@@ -60,7 +64,7 @@ VertexShaderOutput main(uint vidx : SV_VertexID) {
     float3 skinnedPos = 0;
     int skinJointNodeId = 0;
 
-    Transform rootGlobalTransform = node_getWorldTransform(_nodeID);
+    Transform rootGlobalTransform = node_getWorldTransform(nodeID);
     // rootGlobalTransform.identity();
     Transform invGlobalMatrix = transform_inverse(rootGlobalTransform);
 
@@ -95,7 +99,7 @@ VertexShaderOutput main(uint vidx : SV_VertexID) {
 
   //  position += 0.09f * (barycenter - position);
 
-    Transform _model = node_getWorldTransform(_nodeID);
+    Transform _model = node_getWorldTransform(nodeID);
     Transform _view = cam_view();
     Projection _projection = cam_projection();
 
@@ -24,7 +24,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#include "PointCloudDraw.h"
+#include "PointcloudDraw.h"
 
 #include "gpu/Device.h"
 #include "gpu/Batch.h"
@@ -41,7 +41,7 @@
 #include "render/Viewport.h"
 #include "render/Mesh.h"
 
-#include <document/pointcloud.h>
+#include <document/PointCloud.h>
 
 
 #include "Transform_inc.h"
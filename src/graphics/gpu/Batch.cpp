@@ -27,6 +27,8 @@
 #include "Batch.h"
 #include "Resource.h"
 
+#include <cstring>
+
 namespace graphics
 {
 
@@ -77,6 +79,7 @@ void Batch::bindVertexBuffers(uint32_t num, const BufferPointer* buffers) {}
 
 void Batch::draw(uint32_t numPrimitives, uint32_t startIndex) {}
 void Batch::drawIndexed(uint32_t numPrimitives, uint32_t startIndex) {}
+void Batch::drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) {}
 
 void Batch::uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) {}
 void Batch::uploadTexture(const TexturePointer& dest) {
@@ -110,6 +113,7 @@ void Batch::uploadTextureFromInitdata(const DevicePointer& device, const Texture
 
 void Batch::copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) {}
 void Batch::uploadBuffer(const BufferPointer& dest) {}
+void Batch::uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) {}
 
 void Batch::dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) {}
 void Batch::dispatchRays(const DispatchRaysArgs& args) {}
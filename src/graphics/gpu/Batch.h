@@ -127,12 +127,16 @@ namespace graphics {
 
         virtual void draw(uint32_t numPrimitives, uint32_t startIndex);
         virtual void drawIndexed(uint32_t numPrimitives, uint32_t startIndex);
+        // SV_InstanceID goes from 0 to numInstances - 1, the shader offsets it to fetch its per instance data
+        virtual void drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex);
 
         virtual void uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src);
         virtual void uploadTexture(const TexturePointer& dest);
         virtual void uploadTextureFromInitdata(const DevicePointer& device, const TexturePointer& dest, const std::vector<uint32_t>& subresources = std::vector<uint32_t>());
 
         virtual void uploadBuffer(const BufferPointer& dest);
+        // Upload the bytes [offset, offset + size) of the cpu copy of a cpuDouble buffer
+        virtual void uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size);
         virtual void copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size);
 
         virtual void* nativeCommandList() { return nullptr; }
@@ -0,0 +1,942 @@
+// CommandStream.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "CommandStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "Swapchain.h"
+#include "Framebuffer.h"
+
+using namespace graphics;
+
+namespace {
+    enum CommandType : uint8_t {
+        CMD_BEGIN_PASS_SWAPCHAIN = 0,
+        CMD_BEGIN_PASS_FRAMEBUFFER,
+        CMD_END_PASS,
+        CMD_COPY_TEXTURE,
+        CMD_CLEAR_SWAPCHAIN,
+        CMD_CLEAR_FRAMEBUFFER,
+        CMD_TRANSITION_SWAPCHAIN,
+        CMD_TRANSITION_BUFFER,
+        CMD_TRANSITION_TEXTURE,
+        CMD_RW_BUFFER,
+        CMD_RW_TEXTURE,
+        CMD_VIEWPORT,
+        CMD_SCISSOR,
+        CMD_BIND_FRAMEBUFFER,
+        CMD_BIND_ROOT_DESCRIPTOR_LAYOUT,
+        CMD_BIND_PIPELINE,
+        CMD_BIND_DESCRIPTOR_SET,
+        CMD_BIND_PUSH_UNIFORM,
+        CMD_BIND_INDEX_BUFFER,
+        CMD_BIND_VERTEX_BUFFERS,
+        CMD_DRAW,
+        CMD_DRAW_INDEXED,
+        CMD_DRAW_INSTANCED,
+        CMD_UPLOAD_TEXTURE,
+        CMD_UPLOAD_BUFFER,
+        CMD_UPLOAD_BUFFER_REGION,
+        CMD_COPY_BUFFER_REGION,
+        CMD_DISPATCH,
+        CMD_DISPATCH_RAYS,
+    };
+
+    // Every command starts with a header, followed by its payload as 32 bits words
+    struct CommandHeader {
+        uint8_t type;
+        uint8_t pipelineType;
+        uint16_t size; // in bytes, header included
+    };
+    static_assert(sizeof(CommandHeader) == 4, "CommandHeader must be 4 bytes");
+
+    constexpr uint32_t commandSize(uint32_t numWords) { return (uint32_t) sizeof(CommandHeader) + numWords * 4; }
+
+    inline void writeFloats(uint32_t* dst, const float* src, uint32_t num) { memcpy(dst, src, num * sizeof(float)); }
+    inline core::vec4 readVec4(const uint32_t* src) {
+        core::vec4 v;
+        memcpy(&v, src, sizeof(core::vec4));
+        return v;
+    }
+
+    using ResourceKey = CommandStreamReplayState::ResourceKey;
+
+    // A full transition to the state the resource is already in is dropped,
+    // split and per subresource transitions go through and forget the state of the resource
+    bool isRedundantTransition(CommandStreamReplayState& state, ResourceBarrierFlag flag, ResourceState before, ResourceState after,
+        const void* resource, uint64_t index, uint32_t subresource) {
+        if (before == after) {
+            return true;
+        }
+        ResourceKey key{ resource, index };
+        if (flag != ResourceBarrierFlag::NONE || subresource != (uint32_t) -1) {
+            state.resourceStates.erase(key);
+            return false;
+        }
+        auto found = state.resourceStates.find(key);
+        if (found != state.resourceStates.end() && found->second == after) {
+            return true;
+        }
+        state.resourceStates[key] = after;
+        return false;
+    }
+}
+
+uint32_t CommandStreamStats::numFiltered() const {
+    return numFilteredPipelines + numFilteredRootDescriptorLayouts + numFilteredDescriptorSets + numFilteredPushUniforms
+        + numFilteredBuffers + numFilteredRects + numFilteredTransitions;
+}
+
+CommandStreamStats& CommandStreamStats::operator+= (const CommandStreamStats& s) {
+    numCommands += s.numCommands;
+    numBytes += s.numBytes;
+    numReplayed += s.numReplayed;
+    numFilteredPipelines += s.numFilteredPipelines;
+    numFilteredRootDescriptorLayouts += s.numFilteredRootDescriptorLayouts;
+    numFilteredDescriptorSets += s.numFilteredDescriptorSets;
+    numFilteredPushUniforms += s.numFilteredPushUniforms;
+    numFilteredBuffers += s.numFilteredBuffers;
+    numFilteredRects += s.numFilteredRects;
+    numFilteredTransitions += s.numFilteredTransitions;
+    return *this;
+}
+
+std::string CommandStreamStats::toString() const {
+    std::ostringstream s;
+    s << "commands " << numCommands << " (" << numBytes << " B) | replayed " << numReplayed
+      << " | filtered " << numFiltered() << ": pipelines " << numFilteredPipelines
+      << ", root layouts " << numFilteredRootDescriptorLayouts << ", descriptor sets " << numFilteredDescriptorSets
+      << ", push uniforms " << numFilteredPushUniforms << ", buffers " << numFilteredBuffers
+      << ", rects " << numFilteredRects << ", transitions " << numFilteredTransitions;
+    return s.str();
+}
+
+void CommandStreamReplayState::reset() {
+    resetBindings();
+    resourceStates.clear();
+    lastRWBarrier = ResourceKey();
+}
+
+void CommandStreamReplayState::resetBindings() {
+    pipeline = nullptr;
+    for (uint32_t t = 0; t < NUM_PIPELINE_TYPES; ++t) {
+        rootDescriptorLayouts[t] = nullptr;
+        resetRootBindings((PipelineType) t);
+    }
+    indexBuffer = nullptr;
+    numVertexBuffers = 0;
+    validViewport = false;
+    validScissor = false;
+}
+
+void CommandStreamReplayState::resetRootBindings(PipelineType type) {
+    for (auto& s : descriptorSets[(uint32_t)type]) s = nullptr;
+    samplerSets[(uint32_t)type] = nullptr;
+    for (auto& u : pushUniforms[(uint32_t)type]) u.clear();
+}
+
+CommandStream::CommandStream() {
+}
+
+CommandStream::~CommandStream() {
+}
+
+void CommandStream::reset() {
+    _arenaSize = 0;
+    _numCommands = 0;
+    _swapchains.objects.clear();
+    _framebuffers.objects.clear();
+    _buffers.objects.clear();
+    _textures.objects.clear();
+    _pipelines.objects.clear();
+    _rootDescriptorLayouts.objects.clear();
+    _descriptorSets.objects.clear();
+    _uploadLayouts.clear();
+    _dispatchRays.clear();
+}
+
+uint32_t* CommandStream::emit(uint8_t type, PipelineType pipelineType, uint32_t size) {
+    assert((size & 3) == 0 && size <= 0xFFFF);
+    auto offset = _arenaSize;
+    _arenaSize += size;
+    if (_arenaSize > _arena.size()) {
+        _arena.resize(std::max<size_t>(_arenaSize, 2 * _arena.size()));
+    }
+    auto header = reinterpret_cast<CommandHeader*>(_arena.data() + offset);
+    header->type = type;
+    header->pipelineType = (uint8_t) pipelineType;
+    header->size = (uint16_t) size;
+    _numCommands++;
+    return reinterpret_cast<uint32_t*>(header + 1);
+}
+
+void CommandStream::begin(uint8_t currentIndex, const BatchTimerPointer& timer) {
+    reset();
+}
+
+void CommandStream::end() {
+}
+
+void CommandStream::beginPass(const SwapchainPointer& swapchain, uint8_t currentIndex) {
+    auto p = emit(CMD_BEGIN_PASS_SWAPCHAIN, PipelineType::GRAPHICS, commandSize(2));
+    p[0] = _swapchains.index(swapchain);
+    p[1] = currentIndex;
+}
+
+void CommandStream::beginPass(const FramebufferPointer& framebuffer) {
+    emit(CMD_BEGIN_PASS_FRAMEBUFFER, PipelineType::GRAPHICS, commandSize(1))[0] = _framebuffers.index(framebuffer);
+}
+
+void CommandStream::endPass() {
+    emit(CMD_END_PASS, PipelineType::GRAPHICS, commandSize(0));
+}
+
+void CommandStream::copyTexture(const TexturePointer& src, const SwapchainPointer& dst, uint8_t dstIndex) {
+    auto p = emit(CMD_COPY_TEXTURE, PipelineType::GRAPHICS, commandSize(3));
+    p[0] = _textures.index(src);
+    p[1] = _swapchains.index(dst);
+    p[2] = dstIndex;
+}
+
+void CommandStream::clear(const SwapchainPointer& swapchain, uint8_t index, const core::vec4& color, float depth) {
+    auto p = emit(CMD_CLEAR_SWAPCHAIN, PipelineType::GRAPHICS, commandSize(7));
+    p[0] = _swapchains.index(swapchain);
+    p[1] = index;
+    writeFloats(p + 2, &color.x, 4);
+    writeFloats(p + 6, &depth, 1);
+}
+
+void CommandStream::clear(const FramebufferPointer& framebuffer, const core::vec4& color, float depth) {
+    auto p = emit(CMD_CLEAR_FRAMEBUFFER, PipelineType::GRAPHICS, commandSize(6));
+    p[0] = _framebuffers.index(framebuffer);
+    writeFloats(p + 1, &color.x, 4);
+    writeFloats(p + 5, &depth, 1);
+}
+
+void CommandStream::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const SwapchainPointer& swapchain, uint8_t currentIndex, uint32_t subresource) {
+    auto p = emit(CMD_TRANSITION_SWAPCHAIN, PipelineType::GRAPHICS, commandSize(6));
+    p[0] = (uint32_t) flag;
+    p[1] = (uint32_t) stateBefore;
+    p[2] = (uint32_t) stateAfter;
+    p[3] = _swapchains.index(swapchain);
+    p[4] = currentIndex;
+    p[5] = subresource;
+}
+
+void CommandStream::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const BufferPointer& buffer) {
+    auto p = emit(CMD_TRANSITION_BUFFER, PipelineType::GRAPHICS, commandSize(4));
+    p[0] = (uint32_t) flag;
+    p[1] = (uint32_t) stateBefore;
+    p[2] = (uint32_t) stateAfter;
+    p[3] = _buffers.index(buffer);
+}
+
+void CommandStream::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const TexturePointer& texture, uint32_t subresource) {
+    auto p = emit(CMD_TRANSITION_TEXTURE, PipelineType::GRAPHICS, commandSize(5));
+    p[0] = (uint32_t) flag;
+    p[1] = (uint32_t) stateBefore;
+    p[2] = (uint32_t) stateAfter;
+    p[3] = _textures.index(texture);
+    p[4] = subresource;
+}
+
+void CommandStream::resourceBarrierRW(ResourceBarrierFlag flag, const BufferPointer& buffer) {
+    auto p = emit(CMD_RW_BUFFER, PipelineType::GRAPHICS, commandSize(2));
+    p[0] = (uint32_t) flag;
+    p[1] = _buffers.index(buffer);
+}
+
+void CommandStream::resourceBarrierRW(ResourceBarrierFlag flag, const TexturePointer& texture, uint32_t subresource) {
+    auto p = emit(CMD_RW_TEXTURE, PipelineType::GRAPHICS, commandSize(3));
+    p[0] = (uint32_t) flag;
+    p[1] = _textures.index(texture);
+    p[2] = subresource;
+}
+
+void CommandStream::_setViewport(const core::vec4& viewport) {
+    writeFloats(emit(CMD_VIEWPORT, PipelineType::GRAPHICS, commandSize(4)), &viewport.x, 4);
+}
+
+void CommandStream::_setScissor(const core::vec4& scissor) {
+    writeFloats(emit(CMD_SCISSOR, PipelineType::GRAPHICS, commandSize(4)), &scissor.x, 4);
+}
+
+void CommandStream::bindFramebuffer(const FramebufferPointer& framebuffer) {
+    emit(CMD_BIND_FRAMEBUFFER, PipelineType::GRAPHICS, commandSize(1))[0] = _framebuffers.index(framebuffer);
+}
+
+void CommandStream::bindRootDescriptorLayout(PipelineType type, const RootDescriptorLayoutPointer& rootDescriptorLayout) {
+    emit(CMD_BIND_ROOT_DESCRIPTOR_LAYOUT, type, commandSize(1))[0] = _rootDescriptorLayouts.index(rootDescriptorLayout);
+}
+
+void CommandStream::bindPipeline(const PipelineStatePointer& pipeline) {
+    emit(CMD_BIND_PIPELINE, pipeline->getType(), commandSize(1))[0] = _pipelines.index(pipeline);
+}
+
+void CommandStream::bindDescriptorSet(PipelineType type, const DescriptorSetPointer& descriptorSet) {
+    emit(CMD_BIND_DESCRIPTOR_SET, type, commandSize(1))[0] = _descriptorSets.index(descriptorSet);
+}
+
+void CommandStream::bindPushUniform(PipelineType type, uint32_t slot, uint32_t size, const uint8_t* data) {
+    auto p = emit(CMD_BIND_PUSH_UNIFORM, type, commandSize(2 + (size + 3) / 4));
+    p[0] = slot;
+    p[1] = size;
+    memcpy(p + 2, data, size);
+}
+
+void CommandStream::bindIndexBuffer(const BufferPointer& buffer) {
+    emit(CMD_BIND_INDEX_BUFFER, PipelineType::GRAPHICS, commandSize(1))[0] = _buffers.index(buffer);
+}
+
+void CommandStream::bindVertexBuffers(uint32_t num, const BufferPointer* buffers) {
+    auto p = emit(CMD_BIND_VERTEX_BUFFERS, PipelineType::GRAPHICS, commandSize(1 + num));
+    p[0] = num;
+    for (uint32_t i = 0; i < num; ++i) {
+        p[1 + i] = _buffers.index(buffers[i]);
+    }
+}
+
+void CommandStream::draw(uint32_t numPrimitives, uint32_t startIndex) {
+    auto p = emit(CMD_DRAW, PipelineType::GRAPHICS, commandSize(2));
+    p[0] = numPrimitives;
+    p[1] = startIndex;
+}
+
+void CommandStream::drawIndexed(uint32_t numPrimitives, uint32_t startIndex) {
+    auto p = emit(CMD_DRAW_INDEXED, PipelineType::GRAPHICS, commandSize(2));
+    p[0] = numPrimitives;
+    p[1] = startIndex;
+}
+
+void CommandStream::drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) {
+    auto p = emit(CMD_DRAW_INSTANCED, PipelineType::GRAPHICS, commandSize(3));
+    p[0] = numPrimitives;
+    p[1] = numInstances;
+    p[2] = startIndex;
+}
+
+void CommandStream::uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) {
+    auto p = emit(CMD_UPLOAD_TEXTURE, PipelineType::GRAPHICS, commandSize(3));
+    p[0] = _textures.index(dest);
+    p[1] = (uint32_t) _uploadLayouts.size();
+    p[2] = _buffers.index(src);
+    _uploadLayouts.emplace_back(subresourceLayout);
+}
+
+void CommandStream::uploadBuffer(const BufferPointer& dest) {
+    emit(CMD_UPLOAD_BUFFER, PipelineType::GRAPHICS, commandSize(1))[0] = _buffers.index(dest);
+}
+
+void CommandStream::uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) {
+    auto p = emit(CMD_UPLOAD_BUFFER_REGION, PipelineType::GRAPHICS, commandSize(3));
+    p[0] = _buffers.index(dest);
+    p[1] = offset;
+    p[2] = size;
+}
+
+void CommandStream::copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) {
+    auto p = emit(CMD_COPY_BUFFER_REGION, PipelineType::GRAPHICS, commandSize(5));
+    p[0] = _buffers.index(dest);
+    p[1] = destOffset;
+    p[2] = _buffers.index(src);
+    p[3] = srcOffset;
+    p[4] = size;
+}
+
+void CommandStream::dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) {
+    auto p = emit(CMD_DISPATCH, PipelineType::COMPUTE, commandSize(3));
+    p[0] = numThreadsX;
+    p[1] = numThreadsY;
+    p[2] = numThreadsZ;
+}
+
+void CommandStream::dispatchRays(const DispatchRaysArgs& args) {
+    emit(CMD_DISPATCH_RAYS, PipelineType::RAYTRACING, commandSize(1))[0] = (uint32_t) _dispatchRays.size();
+    _dispatchRays.emplace_back(args);
+}
+
+CommandStreamStats CommandStream::replay(const BatchPointer& target) const {
+    CommandStreamReplayState state;
+    return replay(target, state);
+}
+
+CommandStreamStats CommandStream::replay(const BatchPointer& target, CommandStreamReplayState& state) const {
+    CommandStreamStats stats;
+    stats.numCommands = _numCommands;
+    stats.numBytes = _arenaSize;
+
+    auto batch = target.get();
+    const uint8_t* c = _arena.data();
+    const uint8_t* end = c + _arenaSize;
+    while (c < end) {
+        auto header = reinterpret_cast<const CommandHeader*>(c);
+        auto p = reinterpret_cast<const uint32_t*>(header + 1);
+        auto type = (PipelineType) header->pipelineType;
+        uint32_t t = (uint32_t) type;
+        c += header->size;
+
+        // Back to back RW barriers on the same resource, only the first one is needed
+        auto lastRWBarrier = state.lastRWBarrier;
+        state.lastRWBarrier = ResourceKey();
+
+        switch (header->type) {
+        case CMD_BEGIN_PASS_SWAPCHAIN: {
+            state.resetBindings();
+            batch->beginPass(_swapchains.objects[p[0]], (uint8_t) p[1]);
+        } break;
+        case CMD_BEGIN_PASS_FRAMEBUFFER: {
+            state.resetBindings();
+            batch->beginPass(_framebuffers.objects[p[0]]);
+        } break;
+        case CMD_END_PASS: {
+            state.resetBindings();
+            batch->endPass();
+        } break;
+        case CMD_COPY_TEXTURE: {
+            state.resetBindings();
+            batch->copyTexture(_textures.objects[p[0]], _swapchains.objects[p[1]], (uint8_t) p[2]);
+        } break;
+        case CMD_CLEAR_SWAPCHAIN: {
+            float depth;
+            memcpy(&depth, p + 6, sizeof(float));
+            state.resetBindings();
+            batch->clear(_swapchains.objects[p[0]], (uint8_t) p[1], readVec4(p + 2), depth);
+        } break;
+        case CMD_CLEAR_FRAMEBUFFER: {
+            float depth;
+            memcpy(&depth, p + 5, sizeof(float));
+            state.resetBindings();
+            batch->clear(_framebuffers.objects[p[0]], readVec4(p + 1), depth);
+        } break;
+        case CMD_TRANSITION_SWAPCHAIN: {
+            const auto& swapchain = _swapchains.objects[p[3]];
+            if (isRedundantTransition(state, (ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], swapchain.get(), p[4], p[5])) {
+                stats.numFilteredTransitions++;
+                continue;
+            }
+            batch->resourceBarrierTransition((ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], swapchain, (uint8_t) p[4], p[5]);
+        } break;
+        case CMD_TRANSITION_BUFFER: {
+            const auto& buffer = _buffers.objects[p[3]];
+            if (isRedundantTransition(state, (ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], buffer.get(), 0, (uint32_t) -1)) {
+                stats.numFilteredTransitions++;
+                continue;
+            }
+            batch->resourceBarrierTransition((ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], buffer);
+        } break;
+        case CMD_TRANSITION_TEXTURE: {
+            const auto& texture = _textures.objects[p[3]];
+            if (isRedundantTransition(state, (ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], texture.get(), 0, p[4])) {
+                stats.numFilteredTransitions++;
+                continue;
+            }
+            batch->resourceBarrierTransition((ResourceBarrierFlag) p[0], (ResourceState) p[1], (ResourceState) p[2], texture, p[4]);
+        } break;
+        case CMD_RW_BUFFER: {
+            const auto& buffer = _buffers.objects[p[1]];
+            state.lastRWBarrier = ResourceKey{ buffer.get(), 0 };
+            if ((ResourceBarrierFlag) p[0] == ResourceBarrierFlag::NONE && lastRWBarrier == state.lastRWBarrier) {
+                stats.numFilteredTransitions++;
+                continue;
+            }
+            batch->resourceBarrierRW((ResourceBarrierFlag) p[0], buffer);
+        } break;
+        case CMD_RW_TEXTURE: {
+            const auto& texture = _textures.objects[p[1]];
+            state.lastRWBarrier = ResourceKey{ texture.get(), p[2] };
+            if ((ResourceBarrierFlag) p[0] == ResourceBarrierFlag::NONE && lastRWBarrier == state.lastRWBarrier) {
+                stats.numFilteredTransitions++;
+                continue;
+            }
+            batch->resourceBarrierRW((ResourceBarrierFlag) p[0], texture, p[2]);
+        } break;
+        case CMD_VIEWPORT: {
+            auto viewport = readVec4(p);
+            if (state.validViewport && memcmp(&state.viewport, &viewport, sizeof(core::vec4)) == 0) {
+                stats.numFilteredRects++;
+                continue;
+            }
+            state.viewport = viewport;
+            state.validViewport = true;
+            batch->setViewport(viewport);
+        } break;
+        case CMD_SCISSOR: {
+            auto scissor = readVec4(p);
+            if (state.validScissor && memcmp(&state.scissor, &scissor, sizeof(core::vec4)) == 0) {
+                stats.numFilteredRects++;
+                continue;
+            }
+            state.scissor = scissor;
+            state.validScissor = true;
+            batch->setScissor(scissor);
+        } break;
+        case CMD_BIND_FRAMEBUFFER: {
+            batch->bindFramebuffer(_framebuffers.objects[p[0]]);
+        } break;
+        case CMD_BIND_ROOT_DESCRIPTOR_LAYOUT: {
+            const auto& layout = _rootDescriptorLayouts.objects[p[0]];
+            if (state.rootDescriptorLayouts[t] == layout.get()) {
+                stats.numFilteredRootDescriptorLayouts++;
+                continue;
+            }
+            state.rootDescriptorLayouts[t] = layout.get();
+            state.resetRootBindings(type);
+            batch->bindRootDescriptorLayout(type, layout);
+        } break;
+        case CMD_BIND_PIPELINE: {
+            const auto& pipeline = _pipelines.objects[p[0]];
+            if (state.pipeline == pipeline.get()) {
+                stats.numFilteredPipelines++;
+                continue;
+            }
+            // The native batches rebind the root layout of the pipeline, dropping the bindings
+            state.pipeline = pipeline.get();
+            state.rootDescriptorLayouts[t] = pipeline->getRootDescriptorLayout().get();
+            state.resetRootBindings(type);
+            batch->bindPipeline(pipeline);
+        } break;
+        case CMD_BIND_DESCRIPTOR_SET: {
+            const auto& descriptorSet = _descriptorSets.objects[p[0]];
+            auto set = descriptorSet.get();
+            int32_t slot = set->_init._bindSetSlot;
+            bool hasResources = slot >= 0;
+            bool hasSamplers = set->_samplerOffset >= 0 || set->_init._bindSamplers;
+            if (slot < (int32_t) CommandStreamReplayState::MAX_BOUND_DESCRIPTOR_SETS && (hasResources || hasSamplers)
+                && (!hasResources || state.descriptorSets[t][slot] == set)
+                && (!hasSamplers || state.samplerSets[t] == set)) {
+                stats.numFilteredDescriptorSets++;
+                continue;
+            }
+            if (hasResources && slot < (int32_t) CommandStreamReplayState::MAX_BOUND_DESCRIPTOR_SETS) {
+                state.descriptorSets[t][slot] = set;
+            }
+            if (hasSamplers) {
+                state.samplerSets[t] = set;
+            }
+            batch->bindDescriptorSet(type, descriptorSet);
+        } break;
+        case CMD_BIND_PUSH_UNIFORM: {
+            uint32_t slot = p[0];
+            uint32_t size = p[1];
+            auto data = reinterpret_cast<const uint8_t*>(p + 2);
+            if (slot < CommandStreamReplayState::MAX_PUSH_UNIFORM_SLOTS) {
+                auto& bound = state.pushUniforms[t][slot];
+                if (bound.size() == size && memcmp(bound.data(), data, size) == 0) {
+                    stats.numFilteredPushUniforms++;
+                    continue;
+                }
+                bound.assign(data, data + size);
+            }
+            batch->bindPushUniform(type, slot, size, data);
+        } break;
+        case CMD_BIND_INDEX_BUFFER: {
+            const auto& buffer = _buffers.objects[p[0]];
+            if (state.indexBuffer == buffer.get()) {
+                stats.numFilteredBuffers++;
+                continue;
+            }
+            state.indexBuffer = buffer.get();
+            batch->bindIndexBuffer(buffer);
+        } break;
+        case CMD_BIND_VERTEX_BUFFERS: {
+            uint32_t num = p[0];
+            BufferPointer buffers[CommandStreamReplayState::MAX_VERTEX_BUFFERS];
+            if (num <= CommandStreamReplayState::MAX_VERTEX_BUFFERS) {
+                bool same = (num == state.numVertexBuffers);
+                for (uint32_t i = 0; i < num; ++i) {
+                    buffers[i] = _buffers.objects[p[1 + i]];
+                    same = same && (state.vertexBuffers[i] == buffers[i].get());
+                    state.vertexBuffers[i] = buffers[i].get();
+                }
+                state.numVertexBuffers = num;
+                if (same && num) {
+                    stats.numFilteredBuffers++;
+                    continue;
+                }
+                batch->bindVertexBuffers(num, buffers);
+            } else {
+                std::vector<BufferPointer> many(num);
+                for (uint32_t i = 0; i < num; ++i) {
+                    many[i] = _buffers.objects[p[1 + i]];
+                }
+                state.numVertexBuffers = 0;
+                batch->bindVertexBuffers(num, many.data());
+            }
+        } break;
+        case CMD_DRAW: {
+            batch->draw(p[0], p[1]);
+        } break;
+        case CMD_DRAW_INDEXED: {
+            batch->drawIndexed(p[0], p[1]);
+        } break;
+        case CMD_DRAW_INSTANCED: {
+            batch->drawInstanced(p[0], p[1], p[2]);
+        } break;
+        case CMD_UPLOAD_TEXTURE: {
+            state.resetBindings();
+            batch->uploadTexture(_textures.objects[p[0]], _uploadLayouts[p[1]], _buffers.objects[p[2]]);
+        } break;
+        case CMD_UPLOAD_BUFFER: {
+            state.resetBindings();
+            batch->uploadBuffer(_buffers.objects[p[0]]);
+        } break;
+        case CMD_UPLOAD_BUFFER_REGION: {
+            state.resetBindings();
+            batch->uploadBufferRegion(_buffers.objects[p[0]], p[1], p[2]);
+        } break;
+        case CMD_COPY_BUFFER_REGION: {
+            state.resetBindings();
+            batch->copyBufferRegion(_buffers.objects[p[0]], p[1], _buffers.objects[p[2]], p[3], p[4]);
+        } break;
+        case CMD_DISPATCH: {
+            batch->dispatch(p[0], p[1], p[2]);
+        } break;
+        case CMD_DISPATCH_RAYS: {
+            batch->dispatchRays(_dispatchRays[p[0]]);
+        } break;
+        default:
+            assert(false);
+        }
+        stats.numReplayed++;
+    }
+    return stats;
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runCommandStreamTests() to validate the recording and
+// the replay of the command streams on the headless backend, and
+// runCommandStreamBenchmarks() to measure the recording throughput and
+// the binds filtered out by the replay
+// -------------------------------------------------------------------------
+
+#include <chrono>
+
+#include <core/Log.h>
+
+#include "headless/HeadlessBackend.h"
+
+namespace {
+    using namespace graphics;
+
+    HeadlessBatchBackend* headlessOf(const BatchPointer& batch) {
+        return static_cast<HeadlessBatchBackend*>(batch.get());
+    }
+
+    // The resources of a ModelDraw like drawcall: one pipeline, a view set, a model set
+    struct TestResources {
+        DevicePointer device;
+        RootDescriptorLayoutPointer layout;
+        PipelineStatePointer pipeline;
+        PipelineStatePointer otherPipeline;
+        DescriptorSetPointer viewSet;
+        DescriptorSetPointer modelSet;
+        BufferPointer vertexBuffer;
+        BufferPointer indexBuffer;
+        BufferPointer buffer;
+        TexturePointer texture;
+        FramebufferPointer framebuffer;
+    };
+
+    TestResources makeTestResources() {
+        TestResources r;
+        r.device = Device::createDevice({ "Headless" });
+        r.layout = r.device->createRootDescriptorLayout({});
+        GraphicsPipelineStateInit pipelineInit;
+        pipelineInit.rootDescriptorLayout = r.layout;
+        r.pipeline = r.device->createGraphicsPipelineState(pipelineInit);
+        r.otherPipeline = r.device->createGraphicsPipelineState(pipelineInit);
+        r.viewSet = r.device->createDescriptorSet({ r.layout, 0, false, { { DescriptorType::RESOURCE_BUFFER, ShaderStage::VERTEX, 0, 1 } } });
+        r.modelSet = r.device->createDescriptorSet({ r.layout, 1, false, { { DescriptorType::RESOURCE_BUFFER, ShaderStage::VERTEX, 1, 1 } } });
+
+        BufferInit bufferInit;
+        bufferInit.usage = ResourceUsage::VERTEX_BUFFER;
+        bufferInit.bufferSize = 1024;
+        r.vertexBuffer = r.device->createBuffer(bufferInit);
+        bufferInit.usage = ResourceUsage::INDEX_BUFFER;
+        r.indexBuffer = r.device->createBuffer(bufferInit);
+        bufferInit.usage = ResourceUsage::RESOURCE_BUFFER;
+        r.buffer = r.device->createBuffer(bufferInit);
+
+        TextureInit textureInit;
+        textureInit.width = 4;
+        textureInit.height = 4;
+        r.texture = r.device->createTexture(textureInit);
+        FramebufferInit framebufferInit;
+        framebufferInit.colorTargets = { r.texture };
+        r.framebuffer = r.device->createFramebuffer(framebufferInit);
+        return r;
+    }
+
+    // One call of every kind, nothing redundant
+    void recordEverything(const BatchPointer& batch, const TestResources& r) {
+        batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::SHADER_RESOURCE, ResourceState::RENDER_TARGET, r.texture);
+        batch->clear(r.framebuffer, core::vec4(0.5f, 0.25f, 0.125f, 1.0f), 1.0f);
+        batch->beginPass(r.framebuffer);
+        batch->setViewport(core::vec4(0.0f, 0.0f, 4.0f, 4.0f));
+        batch->setScissor(core::vec4(1.0f, 1.0f, 2.0f, 2.0f));
+        batch->bindPipeline(r.pipeline);
+        batch->bindDescriptorSet(PipelineType::GRAPHICS, r.viewSet);
+        batch->bindDescriptorSet(PipelineType::GRAPHICS, r.modelSet);
+        batch->bindVertexBuffers(1, &r.vertexBuffer);
+        batch->bindIndexBuffer(r.indexBuffer);
+        uint8_t push[6] = { 1, 2, 3, 4, 5, 6 }; // not a multiple of 4
+        batch->bindPushUniform(PipelineType::GRAPHICS, 2, sizeof(push), push);
+        batch->draw(36, 3);
+        batch->drawIndexed(120, 12);
+        batch->drawInstanced(36, 7, 3);
+        batch->endPass();
+        batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::RENDER_TARGET, ResourceState::SHADER_RESOURCE, r.texture);
+        batch->resourceBarrierRW(ResourceBarrierFlag::NONE, r.buffer);
+        batch->uploadBufferRegion(r.buffer, 16, 32);
+        batch->copyBufferRegion(r.buffer, 64, r.vertexBuffer, 0, 128);
+        batch->dispatch(8, 4, 2);
+    }
+
+    bool sameLogs(const HeadlessBatchBackend* a, const HeadlessBatchBackend* b) {
+        if (a->commands().size() != b->commands().size() || a->pushData() != b->pushData()) {
+            return false;
+        }
+        for (size_t i = 0; i < a->commands().size(); ++i) {
+            const auto& ca = a->commands()[i];
+            const auto& cb = b->commands()[i];
+            if (ca.type != cb.type || ca.pipelineType != cb.pipelineType || ca.slot != cb.slot || ca.object != cb.object
+                || memcmp(ca.args, cb.args, sizeof(ca.args)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // numItems ModelDraw like drawcalls, each binding its whole state
+    void recordModelDraws(const BatchPointer& batch, const TestResources& r, uint32_t numItems) {
+        for (uint32_t i = 0; i < numItems; ++i) {
+            batch->bindPipeline(r.pipeline);
+            batch->bindDescriptorSet(PipelineType::GRAPHICS, r.viewSet);
+            batch->bindDescriptorSet(PipelineType::GRAPHICS, r.modelSet);
+            uint32_t push[4] = { i, i / 2, 0, 1 };
+            batch->bindPushUniform(PipelineType::GRAPHICS, 0, sizeof(push), (const uint8_t*) push);
+            batch->draw(300, 0);
+        }
+    }
+}
+
+void runCommandStreamTests() {
+    using namespace graphics;
+    picoLog("CommandStreamTest: starting...");
+
+    // --- Test 1: a replayed stream produces the same native calls as the direct recording ---
+    {
+        auto r = makeTestResources();
+        auto direct = r.device->createBatch({});
+        direct->begin(0);
+        recordEverything(direct, r);
+        direct->end();
+
+        auto stream = std::make_shared<CommandStream>();
+        stream->begin(0);
+        recordEverything(stream, r);
+        stream->end();
+        assert(stream->numCommands() == 20 && stream->numBytes() % 4 == 0);
+
+        auto replayed = r.device->createBatch({});
+        replayed->begin(0);
+        auto stats = stream->replay(replayed);
+        replayed->end();
+        assert(stats.numCommands == 20 && stats.numReplayed == 20 && stats.numFiltered() == 0);
+        assert(sameLogs(headlessOf(direct), headlessOf(replayed)));
+        picoLog("CommandStreamTest 1 passed: replay matches the direct recording, " + stats.toString());
+    }
+
+    // --- Test 2: the repeated binds are filtered out of the replay ---
+    {
+        auto r = makeTestResources();
+        const uint32_t numItems = 10;
+
+        auto stream = std::make_shared<CommandStream>();
+        stream->begin(0);
+        stream->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::COPY_DEST, ResourceState::SHADER_RESOURCE, r.buffer);
+        stream->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::COPY_DEST, ResourceState::SHADER_RESOURCE, r.buffer);
+        stream->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::SHADER_RESOURCE, ResourceState::SHADER_RESOURCE, r.texture);
+        stream->resourceBarrierRW(ResourceBarrierFlag::NONE, r.buffer);
+        stream->resourceBarrierRW(ResourceBarrierFlag::NONE, r.buffer);
+        stream->setViewport(core::vec4(0.0f, 0.0f, 4.0f, 4.0f));
+        stream->setViewport(core::vec4(0.0f, 0.0f, 4.0f, 4.0f));
+        recordModelDraws(stream, r, numItems);
+        stream->end();
+
+        auto batch = r.device->createBatch({});
+        batch->begin(0);
+        auto stats = stream->replay(batch);
+        batch->end();
+
+        assert(stats.numFilteredPipelines == numItems - 1);
+        assert(stats.numFilteredDescriptorSets == 2 * (numItems - 1));
+        assert(stats.numFilteredPushUniforms == 0);
+        assert(stats.numFilteredTransitions == 3 && stats.numFilteredRects == 1);
+        assert(stats.numReplayed + stats.numFiltered() == stats.numCommands);
+
+        const auto& s = headlessOf(batch)->stats();
+        assert(s.numDraws == numItems && s.numPushUniforms == numItems && s.numBarriers == 2);
+        assert(s.numPipelineBinds == 1 && s.numRedundantPipelineBinds == 0);
+        assert(s.numDescriptorSetBinds == 2 && s.numRedundantDescriptorSetBinds == 0);
+
+        // the same push data twice in a row goes once
+        stream->begin(0);
+        uint32_t push = 7;
+        stream->bindPushUniform(PipelineType::GRAPHICS, 0, push);
+        stream->draw(3, 0);
+        stream->bindPushUniform(PipelineType::GRAPHICS, 0, push);
+        stream->draw(3, 0);
+        stream->end();
+        batch->begin(0);
+        auto pushStats = stream->replay(batch);
+        batch->end();
+        assert(pushStats.numFilteredPushUniforms == 1 && headlessOf(batch)->stats().numPushUniforms == 1);
+        picoLog("CommandStreamTest 2 passed: redundant binds filtered, " + stats.toString());
+    }
+
+    // --- Test 3: the bindings do not survive a pass nor a pipeline change, the state can span several streams ---
+    {
+        auto r = makeTestResources();
+        auto stream = std::make_shared<CommandStream>();
+        stream->begin(0);
+        stream->beginPass(r.framebuffer);
+        recordModelDraws(stream, r, 1);
+        stream->endPass();
+        stream->beginPass(r.framebuffer);
+        recordModelDraws(stream, r, 1);
+        stream->bindPipeline(r.otherPipeline);
+        stream->bindDescriptorSet(PipelineType::GRAPHICS, r.viewSet);
+        stream->draw(3, 0);
+        stream->endPass();
+        stream->end();
+
+        auto batch = r.device->createBatch({});
+        batch->begin(0);
+        auto stats = stream->replay(batch);
+        batch->end();
+        assert(stats.numFiltered() == 0);
+        assert(headlessOf(batch)->stats().numDescriptorSetBinds == 5);
+
+        // Two streams replayed one after the other with a shared state
+        auto first = std::make_shared<CommandStream>();
+        auto second = std::make_shared<CommandStream>();
+        first->begin(0);
+        recordModelDraws(first, r, 4);
+        first->end();
+        second->begin(0);
+        recordModelDraws(second, r, 4);
+        second->end();
+
+        CommandStreamReplayState state;
+        batch->begin(0);
+        stats = first->replay(batch, state);
+        stats += second->replay(batch, state);
+        batch->end();
+        assert(stats.numFilteredPipelines == 7 && stats.numFilteredDescriptorSets == 14);
+        assert(headlessOf(batch)->stats().numPipelineBinds == 1 && headlessOf(batch)->stats().numDraws == 8);
+
+        // The stream keeps its resources alive until the next begin
+        std::weak_ptr<Buffer> watched;
+        {
+            BufferInit bufferInit;
+            bufferInit.bufferSize = 64;
+            auto transient = r.device->createBuffer(bufferInit);
+            watched = transient;
+            first->begin(0);
+            first->uploadBuffer(transient);
+            first->end();
+        }
+        assert(!watched.expired());
+        batch->begin(0);
+        first->replay(batch);
+        batch->end();
+        assert(headlessOf(batch)->stats().bytesUploaded == 64);
+        first->begin(0);
+        assert(watched.expired() && first->empty());
+        picoLog("CommandStreamTest 3 passed: bindings reset at pass boundaries, state shared across streams");
+    }
+
+    picoLog("CommandStreamTest: all tests passed");
+}
+
+void runCommandStreamBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    auto r = makeTestResources();
+    const uint32_t numItems = 100000;
+    const uint32_t numRuns = 10;
+
+    auto direct = r.device->createBatch({});
+    auto replayed = r.device->createBatch({});
+    auto stream = std::make_shared<CommandStream>();
+
+    double directMs = 0.0, recordMs = 0.0, replayMs = 0.0;
+    CommandStreamStats stats;
+    for (uint32_t run = 0; run < numRuns; ++run) {
+        auto start = clock::now();
+        direct->begin(0);
+        recordModelDraws(direct, r, numItems);
+        direct->end();
+        directMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        stream->begin(0);
+        recordModelDraws(stream, r, numItems);
+        stream->end();
+        recordMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        replayed->begin(0);
+        stats = stream->replay(replayed);
+        replayed->end();
+        replayMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+    directMs /= numRuns;
+    recordMs /= numRuns;
+    replayMs /= numRuns;
+
+    const auto& d = headlessOf(direct)->stats();
+    const auto& s = headlessOf(replayed)->stats();
+    picoLogf("CommandStreamBench {} drawcalls: headless direct {:.2f} ms ({:.1f} commands/us) | stream record {:.2f} ms ({:.1f} commands/us, {} KB) + replay {:.2f} ms",
+        numItems, directMs, d.numCommands / (directMs * 1000.0), recordMs, stats.numCommands / (recordMs * 1000.0), stats.numBytes / 1024, replayMs);
+    picoLogf("CommandStreamBench native calls {} -> {} | redundant pipelines {} -> {} | redundant descriptor sets {} -> {} | {}",
+        d.numCommands, s.numCommands, d.numRedundantPipelineBinds, s.numRedundantPipelineBinds,
+        d.numRedundantDescriptorSetBinds, s.numRedundantDescriptorSetBinds, stats.toString());
+}
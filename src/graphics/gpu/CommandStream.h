@@ -0,0 +1,214 @@
+// CommandStream.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <unordered_map>
+
+#include "gpu.h"
+#include "Batch.h"
+#include "Resource.h"
+
+namespace graphics {
+
+    // CommandStream: a Batch which does not talk to any gpu api.
+    // Every call is encoded as a small POD command appended to a linear byte arena,
+    // the resources are kept alive in per type tables and the commands refer to them by index.
+    // replay() translates the stream into a native batch, filtering out the redundant
+    // state binds and transitions on the way.
+    // A stream is not tied to a device, it can be recorded on any thread (one thread per stream).
+
+    struct VISUALIZATION_API CommandStreamStats {
+        uint32_t numCommands{ 0 };  // recorded
+        uint32_t numBytes{ 0 };     // size of the recorded arena
+        uint32_t numReplayed{ 0 };  // translated into the native batch
+
+        uint32_t numFilteredPipelines{ 0 };
+        uint32_t numFilteredRootDescriptorLayouts{ 0 };
+        uint32_t numFilteredDescriptorSets{ 0 };
+        uint32_t numFilteredPushUniforms{ 0 };
+        uint32_t numFilteredBuffers{ 0 };       // index and vertex buffers
+        uint32_t numFilteredRects{ 0 };         // viewports and scissors
+        uint32_t numFilteredTransitions{ 0 };   // no op transitions and back to back RW barriers
+
+        uint32_t numFiltered() const;
+        CommandStreamStats& operator+= (const CommandStreamStats& s);
+        std::string toString() const;
+    };
+
+    // The state bound on the native batch as known by replay().
+    // Carry one state across several replays into the same batch to filter the binds between streams.
+    struct VISUALIZATION_API CommandStreamReplayState {
+        static const uint32_t MAX_BOUND_DESCRIPTOR_SETS = 8;
+        static const uint32_t MAX_PUSH_UNIFORM_SLOTS = 8;
+        static const uint32_t MAX_VERTEX_BUFFERS = 4;
+        static const uint32_t NUM_PIPELINE_TYPES = (uint32_t)PipelineType::COUNT;
+
+        const PipelineState* pipeline{ nullptr };
+        const RootDescriptorLayout* rootDescriptorLayouts[NUM_PIPELINE_TYPES]{};
+        const DescriptorSet* descriptorSets[NUM_PIPELINE_TYPES][MAX_BOUND_DESCRIPTOR_SETS]{};
+        const DescriptorSet* samplerSets[NUM_PIPELINE_TYPES]{}; // the sampler table is shared by all the sets
+        std::vector<uint8_t> pushUniforms[NUM_PIPELINE_TYPES][MAX_PUSH_UNIFORM_SLOTS];
+
+        const Buffer* indexBuffer{ nullptr };
+        const Buffer* vertexBuffers[MAX_VERTEX_BUFFERS]{};
+        uint32_t numVertexBuffers{ 0 };
+
+        core::vec4 viewport;
+        core::vec4 scissor;
+        bool validViewport{ false };
+        bool validScissor{ false };
+
+        // Last state set by a full (not split) transition of all the subresources of a resource,
+        // the swapchain buffers are told apart by their index
+        struct ResourceKey {
+            const void* resource{ nullptr };
+            uint64_t subresource{ 0 };
+            bool operator== (const ResourceKey& k) const { return resource == k.resource && subresource == k.subresource; }
+        };
+        struct ResourceKeyHash {
+            size_t operator()(const ResourceKey& k) const { return std::hash<const void*>()(k.resource) ^ (size_t)(k.subresource * 0x9E3779B97F4A7C15ull); }
+        };
+        std::unordered_map<ResourceKey, ResourceState, ResourceKeyHash> resourceStates;
+        ResourceKey lastRWBarrier;
+
+        // Forget everything, the next binds all go through
+        void reset();
+
+        // The bindings do not survive a pass, a clear or a copy (a new encoder on metal)
+        void resetBindings();
+
+        // A different root layout (or pipeline) invalidates the descriptor sets and push uniforms
+        void resetRootBindings(PipelineType type);
+    };
+
+    class VISUALIZATION_API CommandStream : public Batch {
+    public:
+        CommandStream();
+        ~CommandStream();
+
+        // begin starts a new recording, dropping the previous commands and resources
+        void begin(uint8_t currentIndex, const BatchTimerPointer& timer = nullptr) override;
+        void end() override;
+
+        void beginPass(const SwapchainPointer& swapchain, uint8_t currentIndex) override;
+        void beginPass(const FramebufferPointer& framebuffer) override;
+        void endPass() override;
+
+        void copyTexture(const TexturePointer& src, const SwapchainPointer& dst, uint8_t dstIndex) override;
+
+        void clear(const SwapchainPointer& swapchain, uint8_t index, const core::vec4& color, float depth = 0.0f) override;
+        void clear(const FramebufferPointer& framebuffer, const core::vec4& color, float depth = 0.0f) override;
+
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const SwapchainPointer& swapchain, uint8_t currentIndex, uint32_t subresource) override;
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const BufferPointer& buffer) override;
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const TexturePointer& texture, uint32_t subresource = -1) override;
+
+        void resourceBarrierRW(ResourceBarrierFlag flag, const BufferPointer& buffer) override;
+        void resourceBarrierRW(ResourceBarrierFlag flag, const TexturePointer& texture, uint32_t subresource) override;
+
+        void bindFramebuffer(const FramebufferPointer& framebuffer) override;
+
+        void bindRootDescriptorLayout(PipelineType type, const RootDescriptorLayoutPointer& rootDescriptorLayout) override;
+        void bindPipeline(const PipelineStatePointer& pipeline) override;
+
+        void bindDescriptorSet(PipelineType type, const DescriptorSetPointer& descriptorSet) override;
+        void bindPushUniform(PipelineType type, uint32_t slot, uint32_t size, const uint8_t* data) override;
+        using Batch::bindPushUniform;
+        void bindIndexBuffer(const BufferPointer& buffer) override;
+        void bindVertexBuffers(uint32_t num, const BufferPointer* buffers) override;
+
+        void draw(uint32_t numPrimitives, uint32_t startIndex) override;
+        void drawIndexed(uint32_t numPrimitives, uint32_t startIndex) override;
+        void drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) override;
+
+        void uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) override;
+        using Batch::uploadTexture;
+        void uploadBuffer(const BufferPointer& dest) override;
+        void uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) override;
+        void copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) override;
+
+        void dispatch(uint32_t numThreadsX, uint32_t numThreadsY = 1, uint32_t numThreadsZ = 1) override;
+        void dispatchRays(const DispatchRaysArgs& args) override;
+
+        // Drop the recorded commands and release the resources, the arena memory is kept
+        void reset();
+
+        // Translate the recorded commands into the target batch, which must be between begin() and end().
+        // Returns the stats of the recording and of this replay.
+        CommandStreamStats replay(const BatchPointer& target) const;
+        CommandStreamStats replay(const BatchPointer& target, CommandStreamReplayState& state) const;
+
+        inline uint32_t numCommands() const { return _numCommands; }
+        inline uint32_t numBytes() const { return _arenaSize; }
+        inline bool empty() const { return _numCommands == 0; }
+
+    protected:
+        void _setViewport(const core::vec4& viewport) override;
+        void _setScissor(const core::vec4& scissor) override;
+
+        // Append a command of 'size' bytes (header included) to the arena, returns its payload
+        uint32_t* emit(uint8_t type, PipelineType pipelineType, uint32_t size);
+
+        std::vector<uint8_t> _arena; // grows but never shrinks, _arenaSize bytes in use
+        uint32_t _arenaSize{ 0 };
+        uint32_t _numCommands{ 0 };
+
+        // Resource tables, a command refers to its resources by index in the table of their type
+        template <typename P>
+        struct ObjectTable {
+            std::vector<P> objects;
+
+            // The same few resources tend to come back, look for them at the end of the table first
+            inline uint32_t index(const P& object) {
+                uint32_t size = (uint32_t) objects.size();
+                for (uint32_t i = size, e = (size > 4 ? size - 4 : 0); i > e; --i) {
+                    if (objects[i - 1] == object) return i - 1;
+                }
+                objects.emplace_back(object);
+                return size;
+            }
+        };
+        ObjectTable<SwapchainPointer> _swapchains;
+        ObjectTable<FramebufferPointer> _framebuffers;
+        ObjectTable<BufferPointer> _buffers;
+        ObjectTable<TexturePointer> _textures;
+        ObjectTable<PipelineStatePointer> _pipelines;
+        ObjectTable<RootDescriptorLayoutPointer> _rootDescriptorLayouts;
+        ObjectTable<DescriptorSetPointer> _descriptorSets;
+
+        // The rare commands with a variable or 64 bits payload keep it out of the arena
+        std::vector<UploadSubresourceLayoutArray> _uploadLayouts;
+        std::vector<DispatchRaysArgs> _dispatchRays;
+    };
+    using CommandStreamPointer = std::shared_ptr<CommandStream>;
+}
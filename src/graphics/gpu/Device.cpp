@@ -27,6 +27,7 @@
 #include "Device.h"
 
 #include "Swapchain.h"
+#include "PipelineCache.h"
 
 #ifdef _WINDOWS
 #include "../d3d12/D3D12Backend.h"
@@ -38,6 +39,10 @@ namespace graphics {
 }
 #endif
 
+namespace graphics {
+    DeviceBackend* createHeadlessBackend();
+}
+
 
 graphics::PixelFormat graphics::defaultColorBufferFormat() {
     // sRGB format — the GPU handles linear→sRGB conversion on write
@@ -60,6 +65,16 @@ DevicePointer Device::createDevice(const DeviceInit& init) {
         device = std::make_shared<Device>(createMetalBackend());
     }
 #endif
+    if (init.backend.compare("Headless") == 0) {
+        device = std::make_shared<Device>(createHeadlessBackend());
+    }
+
+    // Load the cache before any shader or pipeline gets created
+    if (device && !init.pipelineCachePath.empty()) {
+        auto cache = std::make_shared<PipelineCache>(PipelineCacheInit{ init.pipelineCachePath });
+        cache->load();
+        device->_backend->_pipelineCache = cache;
+    }
     return device;
 }
 
@@ -133,6 +148,18 @@ DescriptorHeapPointer Device::getDescriptorHeap() {
     return _backend->getDescriptorHeap();
 }
 
+ResourceHeapPoolPointer Device::getBufferHeapPool() {
+    return _backend->getBufferHeapPool();
+}
+
+ResourceHeapPoolPointer Device::getTextureHeapPool() {
+    return _backend->getTextureHeapPool();
+}
+
+PipelineCachePointer Device::getPipelineCache() {
+    return _backend->_pipelineCache;
+}
+
 DescriptorSetPointer Device::createDescriptorSet(const DescriptorSetInit& init) {
     return _backend->createDescriptorSet(init);
 }
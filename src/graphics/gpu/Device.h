@@ -34,11 +34,16 @@
 namespace graphics {
     
     struct VISUALIZATION_API DeviceInit {
-#ifdef __APPLE__
+#if defined(__APPLE__)
         std::string backend{ "Metal" };
-#else
+#elif defined(_WINDOWS)
         std::string backend{ "D3D12" };
+#else
+        std::string backend{ "Headless" }; // no gpu api, cpu recording only
 #endif
+
+        // Directory of the persistent shader and pipeline cache, no cache when empty
+        std::string pipelineCachePath;
     };
 
     // Device concrete backend implementation
@@ -76,6 +81,13 @@ namespace graphics {
         virtual DescriptorHeapPointer createDescriptorHeap(const DescriptorHeapInit& init) = 0;
         virtual DescriptorHeapPointer getDescriptorHeap() = 0;
 
+        // The pools the buffers and textures are placed in, null when every resource gets its own allocation
+        virtual ResourceHeapPoolPointer getBufferHeapPool() { return nullptr; }
+        virtual ResourceHeapPoolPointer getTextureHeapPool() { return nullptr; }
+
+        // The compiled shaders and pipelines are looked up here before building them, null without cache
+        PipelineCachePointer _pipelineCache;
+
         virtual DescriptorSetPointer createDescriptorSet(const DescriptorSetInit& init) = 0;
 
         virtual ShaderEntry getShaderEntry(const PipelineStatePointer& pipeline, const std::string& entry) = 0;
@@ -136,6 +148,13 @@ namespace graphics {
         DescriptorHeapPointer createDescriptorHeap(const DescriptorHeapInit& init);
         DescriptorHeapPointer getDescriptorHeap();
 
+        // The small buffers and textures are suballocated in large heaps, see ResourceHeapPool
+        ResourceHeapPoolPointer getBufferHeapPool();
+        ResourceHeapPoolPointer getTextureHeapPool();
+
+        // The shaders and pipelines persisted on disk, see PipelineCache. Null if DeviceInit has no path.
+        PipelineCachePointer getPipelineCache();
+
         DescriptorSetPointer createDescriptorSet(const DescriptorSetInit& init);
 
         ShaderEntry getShaderEntry(const PipelineStatePointer& pipeline, const std::string& entry);
@@ -0,0 +1,624 @@
+// HeapAllocator.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HeapAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <sstream>
+
+using namespace graphics;
+
+namespace {
+    inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+std::string HeapAllocatorStats::toString() const {
+    std::ostringstream s;
+    s << "allocations " << numAllocations << " | used " << usedBytes << " B of " << capacity << " B"
+      << " | free blocks " << numFreeBlocks << " (largest " << largestFreeBlock << " B) | fragmentation " << fragmentation();
+    return s.str();
+}
+
+TLSFAllocator::TLSFAllocator(uint64_t capacity) {
+    reset(capacity);
+}
+
+void TLSFAllocator::reset(uint64_t capacity) {
+    _blocks.clear();
+    _unusedBlocks.clear();
+    _flBitmap = 0;
+    std::fill(std::begin(_slBitmaps), std::end(_slBitmaps), 0);
+    std::fill(&_freeHeads[0][0], &_freeHeads[0][0] + FL_COUNT * SL_COUNT, NO_BLOCK);
+    _capacity = capacity & ~(MIN_ALIGNMENT - 1);
+    _usedBytes = 0;
+    _numAllocations = 0;
+    _numFreeBlocks = 0;
+    _firstBlock = NO_BLOCK;
+
+    if (_capacity) {
+        _firstBlock = newBlock();
+        _blocks[_firstBlock].size = _capacity;
+        insertFree(_firstBlock);
+    }
+}
+
+void TLSFAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    if (size < SMALL_SIZE) {
+        fl = 0;
+        sl = uint32_t(size / (SMALL_SIZE / SL_COUNT));
+    } else {
+        uint32_t f = 63 - std::countl_zero(size);
+        sl = uint32_t(size >> (f - SL_LOG2)) ^ SL_COUNT;
+        fl = f - SMALL_LOG2 + 1;
+    }
+}
+
+uint32_t TLSFAllocator::findFree(uint64_t size) const {
+    // Round the size up to the next class, any block of that class is big enough
+    if (size >= SMALL_SIZE) {
+        uint32_t f = 63 - std::countl_zero(size);
+        size += (1ull << (f - SL_LOG2)) - 1;
+    }
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    if (fl >= FL_COUNT) {
+        return NO_BLOCK;
+    }
+
+    uint32_t slMap = _slBitmaps[fl] & (~0u << sl);
+    if (!slMap) {
+        uint64_t flMap = (fl + 1 < 64 ? _flBitmap & (~0ull << (fl + 1)) : 0);
+        if (!flMap) {
+            return NO_BLOCK;
+        }
+        fl = std::countr_zero(flMap);
+        slMap = _slBitmaps[fl];
+    }
+    sl = std::countr_zero(slMap);
+    return _freeHeads[fl][sl];
+}
+
+void TLSFAllocator::insertFree(uint32_t block) {
+    auto& b = _blocks[block];
+    uint32_t fl, sl;
+    mapping(b.size, fl, sl);
+    b.free = true;
+    b.prevFree = NO_BLOCK;
+    b.nextFree = _freeHeads[fl][sl];
+    if (b.nextFree != NO_BLOCK) {
+        _blocks[b.nextFree].prevFree = block;
+    }
+    _freeHeads[fl][sl] = block;
+    _slBitmaps[fl] |= 1u << sl;
+    _flBitmap |= 1ull << fl;
+    _numFreeBlocks++;
+}
+
+void TLSFAllocator::removeFree(uint32_t block) {
+    auto& b = _blocks[block];
+    uint32_t fl, sl;
+    mapping(b.size, fl, sl);
+    if (b.prevFree != NO_BLOCK) {
+        _blocks[b.prevFree].nextFree = b.nextFree;
+    } else {
+        _freeHeads[fl][sl] = b.nextFree;
+        if (b.nextFree == NO_BLOCK) {
+            _slBitmaps[fl] &= ~(1u << sl);
+            if (!_slBitmaps[fl]) {
+                _flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+    if (b.nextFree != NO_BLOCK) {
+        _blocks[b.nextFree].prevFree = b.prevFree;
+    }
+    b.free = false;
+    b.prevFree = b.nextFree = NO_BLOCK;
+    _numFreeBlocks--;
+}
+
+uint32_t TLSFAllocator::newBlock() {
+    if (!_unusedBlocks.empty()) {
+        uint32_t block = _unusedBlocks.back();
+        _unusedBlocks.pop_back();
+        _blocks[block] = Block();
+        return block;
+    }
+    _blocks.emplace_back();
+    return (uint32_t) _blocks.size() - 1;
+}
+
+void TLSFAllocator::releaseBlock(uint32_t block) {
+    _blocks[block].size = 0;
+    _unusedBlocks.emplace_back(block);
+}
+
+uint32_t TLSFAllocator::useFreeBlock(uint32_t block, uint64_t size, uint64_t alignment) {
+    removeFree(block);
+
+    // The front padding up to the aligned offset stays free
+    uint64_t padding = alignUp(_blocks[block].offset, alignment) - _blocks[block].offset;
+    if (padding) {
+        uint32_t pad = newBlock();
+        auto& p = _blocks[pad];
+        auto& b = _blocks[block];
+        p.offset = b.offset;
+        p.size = padding;
+        p.prevPhysical = b.prevPhysical;
+        p.nextPhysical = block;
+        if (b.prevPhysical != NO_BLOCK) {
+            _blocks[b.prevPhysical].nextPhysical = pad;
+        }
+        b.prevPhysical = pad;
+        b.offset += padding;
+        b.size -= padding;
+        insertFree(pad);
+    }
+
+    // The remainder goes back to the free lists
+    if (_blocks[block].size > size) {
+        uint32_t rest = newBlock();
+        auto& r = _blocks[rest];
+        auto& b = _blocks[block];
+        r.offset = b.offset + size;
+        r.size = b.size - size;
+        r.prevPhysical = block;
+        r.nextPhysical = b.nextPhysical;
+        if (b.nextPhysical != NO_BLOCK) {
+            _blocks[b.nextPhysical].prevPhysical = rest;
+        }
+        b.nextPhysical = rest;
+        b.size = size;
+        insertFree(rest);
+    }
+
+    auto& b = _blocks[block];
+    b.alignment = alignment;
+    _usedBytes += b.size;
+    _numAllocations++;
+    return block;
+}
+
+HeapAllocation TLSFAllocator::allocate(uint64_t size, uint64_t alignment) {
+    assert(std::has_single_bit(alignment));
+    size = alignUp(std::max<uint64_t>(size, 1), MIN_ALIGNMENT);
+    alignment = std::max(alignment, MIN_ALIGNMENT);
+
+    // Look for room for the worst padding, the first block of the class might not be aligned
+    uint32_t block = findFree(size + alignment - MIN_ALIGNMENT);
+    if (block == NO_BLOCK) {
+        return {};
+    }
+    block = useFreeBlock(block, size, alignment);
+    return { block, _blocks[block].offset, _blocks[block].size };
+}
+
+void TLSFAllocator::free(uint32_t block) {
+    assert(block < _blocks.size() && !_blocks[block].free && _blocks[block].size);
+    _usedBytes -= _blocks[block].size;
+    _numAllocations--;
+
+    // Merge with the free neighbors
+    uint32_t prev = _blocks[block].prevPhysical;
+    if (prev != NO_BLOCK && _blocks[prev].free) {
+        removeFree(prev);
+        _blocks[prev].size += _blocks[block].size;
+        _blocks[prev].nextPhysical = _blocks[block].nextPhysical;
+        if (_blocks[block].nextPhysical != NO_BLOCK) {
+            _blocks[_blocks[block].nextPhysical].prevPhysical = prev;
+        }
+        releaseBlock(block);
+        block = prev;
+    }
+    uint32_t next = _blocks[block].nextPhysical;
+    if (next != NO_BLOCK && _blocks[next].free) {
+        removeFree(next);
+        _blocks[block].size += _blocks[next].size;
+        _blocks[block].nextPhysical = _blocks[next].nextPhysical;
+        if (_blocks[next].nextPhysical != NO_BLOCK) {
+            _blocks[_blocks[next].nextPhysical].prevPhysical = block;
+        }
+        releaseBlock(next);
+    }
+    insertFree(block);
+}
+
+uint32_t TLSFAllocator::defragment(const MoveCallback& onMove, uint32_t maxMoves) {
+    // The allocations from the end of the heap
+    std::vector<uint32_t> candidates;
+    for (uint32_t b = _firstBlock; b != NO_BLOCK; b = _blocks[b].nextPhysical) {
+        if (!_blocks[b].free) {
+            candidates.emplace_back(b);
+        }
+    }
+
+    uint32_t numMoves = 0;
+    for (auto c = candidates.rbegin(); c != candidates.rend() && numMoves < maxMoves; ++c) {
+        const auto from = _blocks[*c];
+        for (uint32_t f = _firstBlock; f != NO_BLOCK && _blocks[f].offset < from.offset; f = _blocks[f].nextPhysical) {
+            const auto& hole = _blocks[f];
+            if (hole.free && alignUp(hole.offset, from.alignment) + from.size <= hole.offset + hole.size) {
+                uint32_t to = useFreeBlock(f, from.size, from.alignment);
+                onMove({ { *c, from.offset, from.size }, { to, _blocks[to].offset, _blocks[to].size } });
+                this->free(*c);
+                numMoves++;
+                break;
+            }
+        }
+    }
+    return numMoves;
+}
+
+HeapAllocatorStats TLSFAllocator::stats() const {
+    HeapAllocatorStats s;
+    s.capacity = _capacity;
+    s.usedBytes = _usedBytes;
+    s.freeBytes = _capacity - _usedBytes;
+    s.numAllocations = _numAllocations;
+    s.numFreeBlocks = _numFreeBlocks;
+    if (_flBitmap) {
+        // The largest free block is in the highest class
+        uint32_t fl = 63 - std::countl_zero(_flBitmap);
+        uint32_t sl = 31 - std::countl_zero(_slBitmaps[fl]);
+        for (uint32_t b = _freeHeads[fl][sl]; b != NO_BLOCK; b = _blocks[b].nextFree) {
+            s.largestFreeBlock = std::max(s.largestFreeBlock, _blocks[b].size);
+        }
+    }
+    return s;
+}
+
+std::string ResourceHeapPoolStats::toString() const {
+    std::ostringstream s;
+    s << "heaps " << numHeaps << " | " << heaps.toString();
+    return s.str();
+}
+
+ResourceHeapPool::ResourceHeapPool(const ResourceHeapPoolInit& init, CreateHeapFunction createHeap) :
+    _init(init),
+    _createHeap(createHeap)
+{
+}
+
+ResourceHeapPool::~ResourceHeapPool() {
+}
+
+ResourceHeapAllocation ResourceHeapPool::allocate(uint64_t size, uint64_t alignment) {
+    if (size > _init.maxAllocationSize || size > _init.heapSize) {
+        return {};
+    }
+
+    const std::lock_guard<std::mutex> lock(_access);
+    for (uint32_t h = 0; h < _heaps.size(); ++h) {
+        auto allocation = _heaps[h]->allocator.allocate(size, alignment);
+        if (allocation.isValid()) {
+            return { h, allocation, _heaps[h]->native.get() };
+        }
+    }
+
+    // A new heap
+    auto native = _createHeap(_init.heapSize);
+    if (!native) {
+        return {};
+    }
+    auto heap = std::make_unique<Heap>();
+    heap->allocator.reset(_init.heapSize);
+    heap->native = native;
+    auto allocation = heap->allocator.allocate(size, alignment);
+    if (!allocation.isValid()) {
+        return {};
+    }
+    _heaps.emplace_back(std::move(heap));
+    return { (uint32_t) _heaps.size() - 1, allocation, native.get() };
+}
+
+void ResourceHeapPool::free(const ResourceHeapAllocation& allocation) {
+    if (!allocation.isValid()) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(_access);
+    _heaps[allocation.heap]->allocator.free(allocation.allocation);
+}
+
+uint32_t ResourceHeapPool::defragment(const MoveCallback& onMove, uint32_t maxMoves) {
+    const std::lock_guard<std::mutex> lock(_access);
+    uint32_t numMoves = 0;
+    for (uint32_t h = 0; h < _heaps.size() && numMoves < maxMoves; ++h) {
+        numMoves += _heaps[h]->allocator.defragment([&](const TLSFAllocator::Move& move) { onMove(h, move); }, maxMoves - numMoves);
+    }
+    return numMoves;
+}
+
+ResourceHeapPoolStats ResourceHeapPool::stats() const {
+    const std::lock_guard<std::mutex> lock(_access);
+    ResourceHeapPoolStats s;
+    s.numHeaps = (uint32_t) _heaps.size();
+    for (const auto& heap : _heaps) {
+        auto h = heap->allocator.stats();
+        s.heaps.capacity += h.capacity;
+        s.heaps.usedBytes += h.usedBytes;
+        s.heaps.freeBytes += h.freeBytes;
+        s.heaps.numAllocations += h.numAllocations;
+        s.heaps.numFreeBlocks += h.numFreeBlocks;
+        s.heaps.largestFreeBlock = std::max(s.heaps.largestFreeBlock, h.largestFreeBlock);
+    }
+    return s;
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runHeapAllocatorTests() to validate the TLSF heap
+// allocator and the resource pools of the headless device, and
+// runHeapAllocatorBenchmarks() to compare it with a first fit allocator
+// -------------------------------------------------------------------------
+
+#include <chrono>
+#include <map>
+#include <random>
+
+#include <core/Log.h>
+
+#include "Device.h"
+#include "Resource.h"
+
+namespace {
+    using namespace graphics;
+
+    // The allocations do not overlap, are aligned and the stats add up
+    bool checkAllocations(const TLSFAllocator& allocator, const std::vector<std::pair<HeapAllocation, uint64_t>>& allocations) {
+        std::map<uint64_t, uint64_t> ranges;
+        uint64_t used = 0;
+        for (const auto& [a, alignment] : allocations) {
+            if (a.offset % alignment || a.offset + a.size > allocator.capacity()) return false;
+            ranges[a.offset] = a.size;
+            used += a.size;
+        }
+        uint64_t end = 0;
+        for (const auto& [offset, size] : ranges) {
+            if (offset < end) return false;
+            end = offset + size;
+        }
+        auto s = allocator.stats();
+        return s.usedBytes == used && s.numAllocations == allocations.size() && s.freeBytes == s.capacity - used;
+    }
+
+    // The textbook first fit: free ranges in an ordered map, merged on free
+    class FirstFitAllocator {
+    public:
+        FirstFitAllocator(uint64_t capacity) { _free[0] = capacity; }
+
+        uint64_t allocate(uint64_t size, uint64_t alignment) {
+            for (auto it = _free.begin(); it != _free.end(); ++it) {
+                uint64_t offset = (it->first + alignment - 1) & ~(alignment - 1);
+                uint64_t end = it->first + it->second;
+                if (offset + size <= end) {
+                    uint64_t start = it->first;
+                    _free.erase(it);
+                    if (offset > start) _free[start] = offset - start;
+                    if (offset + size < end) _free[offset + size] = end - offset - size;
+                    return offset;
+                }
+            }
+            return ~0ull;
+        }
+
+        void free(uint64_t offset, uint64_t size) {
+            auto it = _free.emplace(offset, size).first;
+            auto next = std::next(it);
+            if (next != _free.end() && offset + size == next->first) {
+                it->second += next->second;
+                _free.erase(next);
+            }
+            if (it != _free.begin()) {
+                auto prev = std::prev(it);
+                if (prev->first + prev->second == it->first) {
+                    prev->second += it->second;
+                    _free.erase(it);
+                }
+            }
+        }
+
+        size_t numFreeBlocks() const { return _free.size(); }
+
+    private:
+        std::map<uint64_t, uint64_t> _free;
+    };
+}
+
+void runHeapAllocatorTests() {
+    using namespace graphics;
+    picoLog("HeapAllocatorTest: starting...");
+
+    // --- Test 1: aligned allocations, the freed blocks merge back into one ---
+    {
+        TLSFAllocator allocator(1024 * 1024);
+        auto a = allocator.allocate(100);
+        auto b = allocator.allocate(1000, 256);
+        auto c = allocator.allocate(64 * 1024, 64 * 1024);
+        assert(a.isValid() && b.isValid() && c.isValid());
+        assert(a.offset == 0 && a.size == 112 && b.offset == 256 && c.offset == 64 * 1024);
+        auto s = allocator.stats();
+        assert(s.numAllocations == 3 && s.usedBytes == 112 + 1008 + 64 * 1024 && s.numFreeBlocks == 3); // 2 paddings and the end
+        assert(!allocator.allocate(1024 * 1024).isValid());
+
+        allocator.free(b);
+        allocator.free(a);
+        allocator.free(c);
+        s = allocator.stats();
+        assert(s.numAllocations == 0 && s.numFreeBlocks == 1 && s.largestFreeBlock == 1024 * 1024 && s.fragmentation() == 0.0f);
+        assert(allocator.allocate(1024 * 1024).offset == 0);
+        picoLog("HeapAllocatorTest 1 passed: aligned allocations merged back on free");
+    }
+
+    // --- Test 2: random allocations and frees never overlap, whatever the sizes and alignments ---
+    {
+        const uint64_t capacity = 64 * 1024 * 1024;
+        TLSFAllocator allocator(capacity);
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<uint64_t> pickSize(1, 256 * 1024);
+        std::uniform_int_distribution<uint32_t> pickAlignment(4, 16);
+        std::vector<std::pair<HeapAllocation, uint64_t>> allocations;
+        uint32_t numFailed = 0;
+        for (uint32_t i = 0; i < 20000; ++i) {
+            if (allocations.size() && rng() % 3 == 0) {
+                auto index = rng() % allocations.size();
+                allocator.free(allocations[index].first);
+                allocations[index] = allocations.back();
+                allocations.pop_back();
+            } else {
+                uint64_t alignment = 1ull << pickAlignment(rng);
+                auto a = allocator.allocate(pickSize(rng), alignment);
+                if (a.isValid()) {
+                    allocations.emplace_back(a, alignment);
+                } else {
+                    numFailed++;
+                }
+            }
+            if (i % 1000 == 0) {
+                assert(checkAllocations(allocator, allocations));
+            }
+        }
+        assert(checkAllocations(allocator, allocations));
+        auto s = allocator.stats();
+        for (const auto& a : allocations) {
+            allocator.free(a.first);
+        }
+        assert(allocator.stats().numFreeBlocks == 1 && allocator.stats().largestFreeBlock == capacity);
+        picoLog("HeapAllocatorTest 2 passed: " + std::to_string(numFailed) + " failed, " + s.toString());
+    }
+
+    // --- Test 3: the defragmentation moves the last allocations into the holes ---
+    {
+        TLSFAllocator allocator(64 * 1024);
+        std::vector<HeapAllocation> allocations;
+        for (uint32_t i = 0; i < 16; ++i) {
+            allocations.emplace_back(allocator.allocate(1024, 1024));
+        }
+        for (uint32_t i = 0; i < 16; i += 2) {
+            allocator.free(allocations[i]);
+        }
+        auto before = allocator.stats();
+        assert(before.numFreeBlocks == 9 && before.largestFreeBlock == 48 * 1024);
+
+        uint32_t numMoves = allocator.defragment([&](const TLSFAllocator::Move& move) {
+            assert(move.to.offset + move.to.size <= move.from.offset && move.to.offset % 1024 == 0);
+        });
+        auto after = allocator.stats();
+        assert(numMoves == 4 && after.numAllocations == 8 && after.numFreeBlocks == 1);
+        assert(after.largestFreeBlock == 56 * 1024 && after.fragmentation() == 0.0f && before.fragmentation() > 0.0f);
+        picoLog("HeapAllocatorTest 3 passed: " + std::to_string(numMoves) + " moves, fragmentation " + std::to_string(before.fragmentation()) + " -> " + std::to_string(after.fragmentation()));
+    }
+
+    // --- Test 4: the buffers of the headless device are placed in the pool, given back on release ---
+    {
+        auto device = Device::createDevice({ "Headless" });
+        auto pool = device->getBufferHeapPool();
+        assert(pool);
+
+        std::vector<BufferPointer> buffers;
+        BufferInit init;
+        init.usage = ResourceUsage::RESOURCE_BUFFER;
+        init.bufferSize = 3000;
+        for (uint32_t i = 0; i < 100; ++i) {
+            buffers.emplace_back(device->createBuffer(init));
+            assert(buffers.back()->isPlaced());
+        }
+        auto s = pool->stats();
+        assert(s.numHeaps == 1 && s.heaps.numAllocations == 100);
+
+        // the upload buffers and the big buffers are not pooled
+        init.hostVisible = true;
+        assert(!device->createBuffer(init)->isPlaced());
+        init.hostVisible = false;
+        init.bufferSize = pool->init().maxAllocationSize + 1;
+        assert(!device->createBuffer(init)->isPlaced());
+
+        buffers.clear();
+        assert(pool->stats().heaps.numAllocations == 0);
+        picoLog("HeapAllocatorTest 4 passed: 100 buffers placed in " + std::to_string(s.numHeaps) + " heap");
+    }
+
+    picoLog("HeapAllocatorTest: all tests passed");
+}
+
+void runHeapAllocatorBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    // Allocations and frees of random sizes in a 256MB heap, against a first fit on an ordered map
+    const uint64_t capacity = 256 * 1024 * 1024;
+    const uint32_t numOps = 200000;
+    for (uint64_t alignment : { 256ull, 64 * 1024ull }) {
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<uint64_t> pickSize(16, 512 * 1024);
+        std::vector<uint64_t> sizes(numOps);
+        std::vector<uint32_t> picks(numOps);
+        for (uint32_t i = 0; i < numOps; ++i) {
+            sizes[i] = pickSize(rng);
+            picks[i] = rng();
+        }
+
+        TLSFAllocator tlsf(capacity);
+        std::vector<HeapAllocation> live;
+        auto start = clock::now();
+        for (uint32_t i = 0; i < numOps; ++i) {
+            if (live.size() && picks[i] % 3 == 0) {
+                auto index = picks[i] % live.size();
+                tlsf.free(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            } else {
+                auto a = tlsf.allocate(sizes[i], alignment);
+                if (a.isValid()) live.emplace_back(a);
+            }
+        }
+        double tlsfMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        auto s = tlsf.stats();
+
+        FirstFitAllocator firstFit(capacity);
+        std::vector<std::pair<uint64_t, uint64_t>> liveRanges;
+        start = clock::now();
+        for (uint32_t i = 0; i < numOps; ++i) {
+            if (liveRanges.size() && picks[i] % 3 == 0) {
+                auto index = picks[i] % liveRanges.size();
+                firstFit.free(liveRanges[index].first, liveRanges[index].second);
+                liveRanges[index] = liveRanges.back();
+                liveRanges.pop_back();
+            } else {
+                uint64_t size = (sizes[i] + 15) & ~15ull;
+                auto offset = firstFit.allocate(size, alignment);
+                if (offset != ~0ull) liveRanges.emplace_back(offset, size);
+            }
+        }
+        double firstFitMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        picoLogf("HeapAllocatorBench {} ops, {} B alignment: tlsf {:.1f} ns/op, {} live, {} free blocks, fragmentation {:.3f} | first fit {:.1f} ns/op, {} live, {} free blocks | x{:.1f}",
+            numOps, alignment, tlsfMs * 1e6 / numOps, live.size(), s.numFreeBlocks, s.fragmentation(),
+            firstFitMs * 1e6 / numOps, liveRanges.size(), firstFit.numFreeBlocks(), firstFitMs / tlsfMs);
+    }
+}
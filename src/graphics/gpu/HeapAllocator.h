@@ -0,0 +1,199 @@
+// HeapAllocator.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gpu.h"
+
+namespace graphics {
+
+    // TLSFAllocator: Two Level Segregated Fit allocator of the ranges of a memory heap.
+    // Pure bookkeeping of offsets, the memory itself belongs to the caller.
+    // The free blocks are listed by size class: a first level per power of 2, split in SL_COUNT linear
+    // second levels, two bitmaps find the class of a free block big enough in constant time.
+    // The neighbor free blocks are merged on free.
+
+    struct VISUALIZATION_API HeapAllocation {
+        static const uint32_t INVALID_BLOCK = 0xFFFFFFFF;
+
+        uint32_t block{ INVALID_BLOCK }; // handle of the allocation in the allocator
+        uint64_t offset{ 0 };
+        uint64_t size{ 0 };
+
+        inline bool isValid() const { return block != INVALID_BLOCK; }
+    };
+
+    struct VISUALIZATION_API HeapAllocatorStats {
+        uint64_t capacity{ 0 };
+        uint64_t usedBytes{ 0 };         // allocated, the sizes rounded to MIN_ALIGNMENT
+        uint64_t freeBytes{ 0 };         // alignment paddings included
+        uint32_t numAllocations{ 0 };
+        uint32_t numFreeBlocks{ 0 };
+        uint64_t largestFreeBlock{ 0 };
+
+        // 0 when the free memory is in one block, toward 1 when it is scattered in small blocks
+        inline float fragmentation() const { return (freeBytes ? 1.0f - float(largestFreeBlock) / float(freeBytes) : 0.0f); }
+
+        std::string toString() const;
+    };
+
+    class VISUALIZATION_API TLSFAllocator {
+    public:
+        static constexpr uint64_t MIN_ALIGNMENT = 16; // granularity of the block sizes and offsets
+
+        TLSFAllocator(uint64_t capacity = 0);
+
+        // Forget all the allocations, the heap is one free block of capacity bytes
+        void reset(uint64_t capacity);
+
+        // Allocate a range of size bytes starting at a multiple of the alignment (a power of 2),
+        // an invalid allocation if there is no free block big enough.
+        HeapAllocation allocate(uint64_t size, uint64_t alignment = MIN_ALIGNMENT);
+        void free(uint32_t block);
+        inline void free(const HeapAllocation& allocation) { free(allocation.block); }
+
+        // Defragmentation hook: the allocations at the end of the heap are moved to the lowest free block they fit in,
+        // from and to never overlap. onMove copies the content and updates the owner of the allocation,
+        // the from block is released after the call. Returns the number of moves, at most maxMoves.
+        struct Move {
+            HeapAllocation from;
+            HeapAllocation to;
+        };
+        using MoveCallback = std::function<void(const Move& move)>;
+        uint32_t defragment(const MoveCallback& onMove, uint32_t maxMoves = 0xFFFFFFFF);
+
+        inline uint64_t capacity() const { return _capacity; }
+        inline uint32_t numAllocations() const { return _numAllocations; }
+        HeapAllocatorStats stats() const;
+
+    private:
+        static const uint32_t SL_LOG2 = 4;
+        static const uint32_t SL_COUNT = 1 << SL_LOG2;
+        static const uint32_t SMALL_LOG2 = 8; // under 256 bytes, one first level in steps of MIN_ALIGNMENT
+        static const uint64_t SMALL_SIZE = 1ull << SMALL_LOG2;
+        static const uint32_t FL_COUNT = 64 - SMALL_LOG2 + 1;
+        static constexpr uint32_t NO_BLOCK = HeapAllocation::INVALID_BLOCK;
+
+        struct Block {
+            uint64_t offset{ 0 };
+            uint64_t size{ 0 };
+            uint64_t alignment{ MIN_ALIGNMENT };
+            uint32_t prevPhysical{ NO_BLOCK };
+            uint32_t nextPhysical{ NO_BLOCK };
+            uint32_t prevFree{ NO_BLOCK };
+            uint32_t nextFree{ NO_BLOCK };
+            bool free{ false };
+        };
+
+        static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+        uint32_t findFree(uint64_t size) const;
+        void insertFree(uint32_t block);
+        void removeFree(uint32_t block);
+        uint32_t newBlock();
+        void releaseBlock(uint32_t block);
+        uint32_t useFreeBlock(uint32_t block, uint64_t size, uint64_t alignment);
+
+        std::vector<Block> _blocks;
+        std::vector<uint32_t> _unusedBlocks;
+        uint32_t _firstBlock{ NO_BLOCK }; // the block at offset 0, never merged into a previous one
+
+        uint64_t _flBitmap{ 0 };
+        uint32_t _slBitmaps[FL_COUNT]{};
+        uint32_t _freeHeads[FL_COUNT][SL_COUNT]{};
+
+        uint64_t _capacity{ 0 };
+        uint64_t _usedBytes{ 0 };
+        uint32_t _numAllocations{ 0 };
+        uint32_t _numFreeBlocks{ 0 };
+    };
+
+    // ResourceHeapPool: the memory heaps of a backend suballocated by TLSF.
+    // The heaps are created on demand by the backend, heapSize bytes each,
+    // the resources bigger than maxAllocationSize are not pooled and get their own dedicated memory.
+    // Thread safe.
+
+    struct VISUALIZATION_API ResourceHeapPoolInit {
+        uint64_t heapSize{ 64 * 1024 * 1024 };
+        uint64_t maxAllocationSize{ 16 * 1024 * 1024 };
+    };
+
+    struct VISUALIZATION_API ResourceHeapAllocation {
+        static const uint32_t INVALID_HEAP = 0xFFFFFFFF;
+
+        uint32_t heap{ INVALID_HEAP };
+        HeapAllocation allocation;
+        void* nativeHeap{ nullptr }; // the backend heap holding the allocation
+
+        inline bool isValid() const { return heap != INVALID_HEAP; }
+    };
+
+    struct VISUALIZATION_API ResourceHeapPoolStats {
+        uint32_t numHeaps{ 0 };
+        HeapAllocatorStats heaps; // summed over the heaps, largest free block of any heap
+
+        std::string toString() const;
+    };
+
+    class VISUALIZATION_API ResourceHeapPool {
+    public:
+        // The backend heap, released with the pool once its last resource is gone
+        using NativeHeap = std::shared_ptr<void>;
+        using CreateHeapFunction = std::function<NativeHeap(uint64_t size)>;
+
+        ResourceHeapPool(const ResourceHeapPoolInit& init, CreateHeapFunction createHeap);
+        ~ResourceHeapPool();
+
+        // An invalid allocation if the size is over maxAllocationSize or the backend failed to create a heap
+        ResourceHeapAllocation allocate(uint64_t size, uint64_t alignment);
+        void free(const ResourceHeapAllocation& allocation);
+
+        // Defragment the heaps one after the other, onMove is called under the lock of the pool
+        using MoveCallback = std::function<void(uint32_t heap, const TLSFAllocator::Move& move)>;
+        uint32_t defragment(const MoveCallback& onMove, uint32_t maxMoves = 0xFFFFFFFF);
+
+        inline const ResourceHeapPoolInit& init() const { return _init; }
+        ResourceHeapPoolStats stats() const;
+
+    private:
+        struct Heap {
+            TLSFAllocator allocator;
+            NativeHeap native;
+        };
+
+        ResourceHeapPoolInit _init;
+        CreateHeapFunction _createHeap;
+
+        mutable std::mutex _access;
+        std::vector<std::unique_ptr<Heap>> _heaps;
+    };
+}
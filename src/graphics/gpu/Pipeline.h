@@ -91,6 +91,8 @@ namespace graphics {
 
         PipelineRealizer _pipelineRealizer;
 
+        uint64_t _cacheKey{ 0 };
+
 //        union {
             GraphicsPipelineStateInit _graphics;
             ComputePipelineStateInit _compute;
@@ -104,6 +106,9 @@ namespace graphics {
         RootDescriptorLayoutPointer getRootDescriptorLayout() const;
         RootDescriptorLayoutPointer getLocalRootDescriptorLayout() const { return _localRootDescriptorLayout; }
 
+        // Key of the pipeline blob in the PipelineCache, 0 when the device has no cache
+        uint64_t getCacheKey() const { return _cacheKey; }
+
         bool realize();
 
         static void registerToWatcher(const PipelineStatePointer& pipeline, PipelineRealizer pipelineRealizer);
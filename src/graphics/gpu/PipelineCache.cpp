@@ -0,0 +1,700 @@
+// PipelineCache.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "PipelineCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <unordered_set>
+
+#include <core/Job.h>
+#include <core/MappedFile.h>
+#include <core/Log.h>
+
+#include "Descriptor.h"
+#include "Pipeline.h"
+
+using namespace graphics;
+
+namespace {
+    const uint32_t PIPELINE_CACHE_MAGIC = 0x43505050; // "PPPC"
+    const uint32_t PIPELINE_CACHE_FORMAT = 1;
+
+    struct PipelineCacheFileHeader {
+        uint32_t magic{ PIPELINE_CACHE_MAGIC };
+        uint32_t format{ PIPELINE_CACHE_FORMAT };
+        uint32_t version{ 0 }; // PipelineCacheInit::version
+        uint32_t _spare{ 0 };
+        uint64_t key{ 0 };
+        uint64_t size{ 0 };
+        uint64_t checksum{ 0 };
+    };
+
+    uint64_t evalChecksum(const void* data, uint64_t size) {
+        return PipelineCacheHasher().bytes(data, size).key();
+    }
+
+    // Parse a line '#include "name"' or '#include <name>', the ./ prefix is dropped like the dxc include handler does
+    bool parseInclude(std::string_view line, std::string& name) {
+        auto p = line.find_first_not_of(" \t");
+        if (p == std::string_view::npos || line.compare(p, 8, "#include") != 0) {
+            return false;
+        }
+        p = line.find_first_of("\"<", p + 8);
+        if (p == std::string_view::npos) {
+            return false;
+        }
+        auto e = line.find(line[p] == '"' ? '"' : '>', p + 1);
+        if (e == std::string_view::npos) {
+            return false;
+        }
+        name = std::string(line.substr(p + 1, e - p - 1));
+        if (name.rfind("./", 0) == 0) {
+            name = name.substr(2);
+        }
+        return true;
+    }
+
+    void inlineIncludes(const std::string& source, const ShaderIncludeLib& includes, std::unordered_set<std::string>& included, std::string& out) {
+        size_t begin = 0;
+        std::string name;
+        while (begin < source.size()) {
+            auto end = source.find('\n', begin);
+            end = (end == std::string::npos ? source.size() : end + 1);
+            std::string_view line(source.data() + begin, end - begin);
+            begin = end;
+
+            if (parseInclude(line, name)) {
+                auto i = includes.find(name);
+                if (i != includes.end()) {
+                    if (included.insert(name).second) {
+                        inlineIncludes(i->second(), includes, included, out);
+                        out += '\n';
+                    }
+                    continue;
+                }
+            }
+            out.append(line);
+        }
+    }
+
+    void hashDescriptorSetLayout(PipelineCacheHasher& h, const DescriptorSetLayout& layout) {
+        h.value(layout.size());
+        for (const auto& d : layout) {
+            h.value(d._type).value(d._shaderStage).value(d._binding).value(d._count);
+        }
+    }
+
+    void hashRootDescriptorLayout(PipelineCacheHasher& h, const RootDescriptorLayoutPointer& layout) {
+        if (!layout) {
+            h.value(0);
+            return;
+        }
+        const auto& init = layout->_init;
+        hashDescriptorSetLayout(h, init._pushLayout);
+        h.value(init._setLayouts.size());
+        for (const auto& s : init._setLayouts) {
+            hashDescriptorSetLayout(h, s);
+        }
+        hashDescriptorSetLayout(h, init._samplerLayout);
+        h.value(init._pipelineType).value(init._localSignature);
+    }
+
+    // False if a shader of the program was not built through the cache, its content is unknown
+    bool hashProgram(PipelineCacheHasher& h, const ShaderPointer& program) {
+        if (!program) {
+            return false;
+        }
+        const auto& lib = program->getProgramDesc().shaderLib;
+        if (program->getCacheKey() == 0 && lib.empty()) {
+            return false;
+        }
+        h.value(program->getCacheKey()).value(lib.size());
+        for (const auto& [name, shader] : lib) { // ordered map, same order every run
+            if (!shader || shader->getCacheKey() == 0) {
+                return false;
+            }
+            h.string(name).value(shader->getCacheKey());
+        }
+        return true;
+    }
+}
+
+PipelineCacheHasher& PipelineCacheHasher::bytes(const void* data, uint64_t size) {
+    // 64 bits words at a time, the tail bytes are zero padded
+    auto bytes = static_cast<const uint8_t*>(data);
+    uint64_t numWords = size / sizeof(uint64_t);
+    for (uint64_t i = 0; i < numWords; ++i) {
+        uint64_t w;
+        memcpy(&w, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+        mix(w);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + numWords * sizeof(uint64_t), size - numWords * sizeof(uint64_t));
+    mix(tail);
+    mix(size);
+    return *this;
+}
+
+std::string PipelineCacheStats::toString() const {
+    std::ostringstream s;
+    s << numEntries << " entries (" << numBytes << " B) | load " << numLoaded << " in " << loadMs << " ms, " << numRejected << " rejected"
+      << " | " << numHits << " hits, " << numMisses << " misses, " << numStores << " stores";
+    return s.str();
+}
+
+PipelineCache::PipelineCache(const PipelineCacheInit& init) : _init(init) {
+    std::error_code ec;
+    std::filesystem::create_directories(_init.path, ec);
+}
+
+PipelineCache::~PipelineCache() {
+}
+
+std::string PipelineCache::filename(PipelineCacheKey key) const {
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+    return (std::filesystem::path(_init.path) / name).string();
+}
+
+uint32_t PipelineCache::load() {
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(_init.path, ec)) {
+        if (entry.path().extension() == ".bin") {
+            files.emplace_back(entry.path().string());
+        }
+    }
+
+    struct Entry {
+        PipelineCacheKey key{ 0 }; // 0 if rejected
+        PipelineCacheBlob blob;
+    };
+    std::vector<Entry> loaded(files.size());
+    auto read = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            core::MappedFile file;
+            PipelineCacheFileHeader header;
+            if (!file.open(files[i]) || file.size() < sizeof(header)) {
+                continue;
+            }
+            memcpy(&header, file.data(), sizeof(header));
+            if (header.magic != PIPELINE_CACHE_MAGIC || header.format != PIPELINE_CACHE_FORMAT || header.version != _init.version ||
+                header.size != file.size() - sizeof(header)) {
+                continue;
+            }
+            const uint8_t* data = file.data() + sizeof(header);
+            if (evalChecksum(data, header.size) != header.checksum) {
+                continue;
+            }
+            loaded[i].key = header.key;
+            loaded[i].blob.assign(data, data + header.size);
+        }
+    };
+    if (_init.parallelLoad) {
+        core::ThreadPool::shared().parallel_for((uint32_t) files.size(), 4, read);
+    } else {
+        read(0, (uint32_t) files.size());
+    }
+
+    const std::lock_guard<std::mutex> lock(_access);
+    _stats.numLoaded = 0;
+    _stats.numRejected = 0;
+    for (auto& e : loaded) {
+        if (e.key == 0) {
+            _stats.numRejected++;
+            continue;
+        }
+        auto& blob = _entries[e.key];
+        _stats.numBytes += e.blob.size() - blob.size();
+        blob = std::move(e.blob);
+        _stats.numLoaded++;
+    }
+    _stats.numEntries = (uint32_t) _entries.size();
+    _stats.loadMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    if (_stats.numRejected) {
+        picoLogf("pipeline cache {}: {} stale or corrupted files ignored", _init.path, _stats.numRejected);
+    }
+    return _stats.numLoaded;
+}
+
+bool PipelineCache::find(PipelineCacheKey key, PipelineCacheBlob& blob) {
+    const std::lock_guard<std::mutex> lock(_access);
+    auto i = (key ? _entries.find(key) : _entries.end());
+    if (i == _entries.end()) {
+        _stats.numMisses++;
+        return false;
+    }
+    _stats.numHits++;
+    blob = i->second;
+    return true;
+}
+
+bool PipelineCache::store(PipelineCacheKey key, const void* data, uint64_t size) {
+    if (!key) {
+        return false;
+    }
+    static std::atomic<uint32_t> numTemporaries{ 0 };
+    {
+        const std::lock_guard<std::mutex> lock(_access);
+        auto& blob = _entries[key];
+        _stats.numBytes += size - blob.size();
+        blob.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        _stats.numEntries = (uint32_t) _entries.size();
+        _stats.numStores++;
+    }
+
+    // Write aside then rename, an interrupted write never leaves a truncated entry behind
+    auto name = filename(key);
+    auto temporary = name + "." + std::to_string(numTemporaries++) + ".tmp";
+    {
+        PipelineCacheFileHeader header;
+        header.version = _init.version;
+        header.key = key;
+        header.size = size;
+        header.checksum = evalChecksum(data, size);
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) data, size);
+        if (!file.good()) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, name, ec);
+    return !ec;
+}
+
+void PipelineCache::evict(PipelineCacheKey key) {
+    {
+        const std::lock_guard<std::mutex> lock(_access);
+        auto i = _entries.find(key);
+        if (i == _entries.end()) {
+            return;
+        }
+        _stats.numBytes -= i->second.size();
+        _entries.erase(i);
+        _stats.numEntries = (uint32_t) _entries.size();
+    }
+    std::error_code ec;
+    std::filesystem::remove(filename(key), ec);
+}
+
+PipelineCacheStats PipelineCache::stats() const {
+    const std::lock_guard<std::mutex> lock(_access);
+    return _stats;
+}
+
+std::string PipelineCache::preprocessShaderSource(const std::string& source, const ShaderIncludeLib& includes) {
+    std::string out;
+    out.reserve(source.size());
+    std::unordered_set<std::string> included;
+    inlineIncludes(source, includes, included, out);
+    return out;
+}
+
+PipelineCacheKey PipelineCache::evalShaderKey(const ShaderInit& init, const std::string& preprocessedSource, const std::string& target) {
+    PipelineCacheHasher h;
+    h.string(preprocessedSource).string(init.entryPoint).string(target).value(init.type);
+    h.value(init.defines.size());
+    for (const auto& d : init.defines) {
+        h.string(d);
+    }
+    return h.key();
+}
+
+PipelineCacheKey PipelineCache::evalPipelineKey(const GraphicsPipelineStateInit& init) {
+    PipelineCacheHasher h;
+    h.value(PipelineType::GRAPHICS);
+    if (!hashProgram(h, init.program)) {
+        return 0;
+    }
+    hashRootDescriptorLayout(h, init.rootDescriptorLayout);
+
+    const auto& stream = init.streamLayout;
+    h.value(stream.numAttribs());
+    for (uint8_t a = 0; a < stream.numAttribs(); ++a) {
+        auto attrib = stream.getAttrib(a);
+        h.value(attrib->_semantic).value(attrib->_format).value(attrib->_bufferIndex).value(attrib->_packingOffset);
+    }
+    h.value(stream.numBuffers());
+    for (uint8_t b = 0; b < stream.numBuffers(); ++b) {
+        auto view = stream.getBufferView(b);
+        h.value(view->_byteOffset).value(view->_byteLength).value(view->_byteStride);
+    }
+    h.value(init.primitiveTopology);
+
+    const auto& r = init.rasterizer;
+    h.value(r.depthBias).value(r.depthBiasSlopeScale).value(r.fillMode).value(r.cullMode)
+     .value(bool(r.frontFaceClockwise)).value(bool(r.depthClampEnable)).value(bool(r.primitiveDiscardEnable))
+     .value(bool(r.conservativeRasterizerEnable)).value(bool(r.multisampleEnable)).value(bool(r.antialiasedLineEnable))
+     .value(bool(r.alphaToCoverageEnable));
+
+    const auto& ds = init.depthStencil;
+    h.value(ds.depthTest.isEnabled()).value(ds.depthTest.isWriteEnabled()).value(ds.depthTest.getFunction());
+    h.value(ds.stencilActivation.isEnabled()).value(ds.stencilActivation.getWriteMaskFront()).value(ds.stencilActivation.getWriteMaskBack());
+    for (const auto& s : { ds.stencilTestFront, ds.stencilTestBack }) {
+        h.value(s.getFunction()).value(s.getFailOp()).value(s.getDepthFailOp()).value(s.getPassOp())
+         .value(s.getReference()).value(s.getReadMask());
+    }
+
+    const auto& bf = init.blend.blendFunc;
+    h.value(bf.isEnabled()).value(bf.getSourceColor()).value(bf.getDestinationColor()).value(bf.getOperationColor())
+     .value(bf.getSourceAlpha()).value(bf.getDestinationAlpha()).value(bf.getOperationAlpha()).value(init.blend.colorWriteMask);
+
+    h.value(init.colorTargetFormat).value(init.depthStencilFormat);
+    return h.key();
+}
+
+PipelineCacheKey PipelineCache::evalPipelineKey(const ComputePipelineStateInit& init) {
+    PipelineCacheHasher h;
+    h.value(PipelineType::COMPUTE);
+    if (!hashProgram(h, init.program)) {
+        return 0;
+    }
+    hashRootDescriptorLayout(h, init.rootDescriptorLayout);
+    h.value(init.threadGroupX).value(init.threadGroupY).value(init.threadGroupZ);
+    return h.key();
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runPipelineCacheTests() to validate the cache keys and the disk store
+// and runPipelineCacheBenchmarks() to time the startup load and the key evaluation
+// -------------------------------------------------------------------------
+
+#include <cassert>
+
+#include "Device.h"
+
+namespace {
+    std::string testVertexSource = "#include \"./Common_inc.hlsl\"\nfloat4 mainVS(uint v : SV_VertexID) : SV_POSITION { return COLOR; }\n";
+    std::string testPixelSource = "#include \"Common_inc.hlsl\"\nfloat4 mainPS() : SV_Target { return COLOR; }\n";
+    std::string testCommonSource = "#include \"Color_inc.hlsl\"\n#include \"Missing_inc.hlsl\"\n";
+    std::string testColorSource = "#define COLOR float4(1, 0, 0, 1)\n";
+    const std::string& getTestVertexSource() { return testVertexSource; }
+    const std::string& getTestPixelSource() { return testPixelSource; }
+    const std::string& getTestCommonSource() { return testCommonSource; }
+    const std::string& getTestColorSource() { return testColorSource; }
+
+    ShaderIncludeLib testIncludes() {
+        return { { "Common_inc.hlsl", getTestCommonSource }, { "Color_inc.hlsl", getTestColorSource } };
+    }
+
+    std::string testCacheDir(const char* name) {
+        auto dir = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(dir);
+        return dir.string();
+    }
+
+    uint32_t countCacheFiles(const std::string& dir) {
+        uint32_t n = 0;
+        for (const auto& e : std::filesystem::directory_iterator(dir)) {
+            n += (e.path().extension() == ".bin");
+        }
+        return n;
+    }
+
+    struct TestPipeline {
+        ShaderPointer program;
+        RootDescriptorLayoutPointer layout;
+        PipelineStatePointer pipeline;
+    };
+
+    TestPipeline createTestPipeline(const DevicePointer& device) {
+        TestPipeline t;
+        auto vs = device->createShader({ ShaderType::VERTEX, "mainVS", getTestVertexSource, std::string(), testIncludes() });
+        auto ps = device->createShader({ ShaderType::PIXEL, "mainPS", getTestPixelSource, std::string(), testIncludes() });
+        t.program = device->createProgram({ vs, ps });
+        t.layout = device->createRootDescriptorLayout({ { { DescriptorType::PUSH_UNIFORM, ShaderStage::ALL_GRAPHICS, 0, 4 } } });
+        GraphicsPipelineStateInit init;
+        init.program = t.program;
+        init.rootDescriptorLayout = t.layout;
+        init.primitiveTopology = PrimitiveTopology::TRIANGLE;
+        t.pipeline = device->createGraphicsPipelineState(init);
+        return t;
+    }
+}
+
+void runPipelineCacheTests() {
+    picoLog("PipelineCacheTest: starting...");
+
+    // --- Test 1: the includes of the lib are inlined recursively, once, the others are left to the compiler ---
+    {
+        auto includes = testIncludes();
+        auto out = PipelineCache::preprocessShaderSource(testVertexSource + testPixelSource, includes);
+        assert(out.find(testColorSource) != std::string::npos);
+        assert(out.find(testColorSource) == out.rfind(testColorSource));
+        assert(out.find("Common_inc.hlsl") == std::string::npos && out.find("Color_inc.hlsl") == std::string::npos);
+        assert(out.find("#include \"Missing_inc.hlsl\"") != std::string::npos);
+        assert(out.find("mainVS") != std::string::npos && out.find("mainPS") != std::string::npos);
+        picoLog("PipelineCacheTest 1 passed: includes inlined once, unknown includes kept");
+    }
+
+    // --- Test 2: the shader key follows the preprocessed source, the entry point, the target and the defines ---
+    {
+        ShaderInit init(ShaderType::VERTEX, "mainVS", getTestVertexSource, std::string(), testIncludes());
+        auto evalKey = [&](const ShaderInit& i, const std::string& target) {
+            return PipelineCache::evalShaderKey(i, PipelineCache::preprocessShaderSource(i.sourceGetter(), i.includes), target);
+        };
+        auto k0 = evalKey(init, "vs_6_1");
+        assert(k0 != 0 && k0 == evalKey(init, "vs_6_1"));
+        assert(evalKey(init, "vs_6_6") != k0);
+
+        auto defined = init;
+        defined.defines = { "USE_SKIN=1" };
+        auto kd = evalKey(defined, "vs_6_1");
+        assert(kd != k0);
+        defined.defines = { "USE_SKIN=0" };
+        assert(evalKey(defined, "vs_6_1") != kd && evalKey(defined, "vs_6_1") != k0);
+
+        auto entry = init;
+        entry.entryPoint = "mainVS2";
+        assert(evalKey(entry, "vs_6_1") != k0);
+
+        auto color = testColorSource;
+        testColorSource = "#define COLOR float4(0, 1, 0, 1)\n"; // editing an include changes the key
+        assert(evalKey(init, "vs_6_1") != k0);
+        testColorSource = color;
+        assert(evalKey(init, "vs_6_1") == k0);
+        picoLog("PipelineCacheTest 2 passed: shader key follows source, includes, entry, target and defines");
+    }
+
+    // --- Test 3: the pipeline key follows the shaders and every part of the state ---
+    {
+        auto dir = testCacheDir("pico_pipeline_cache_test3");
+        auto device = Device::createDevice({ "Headless", dir });
+        auto t = createTestPipeline(device);
+        assert(t.program->getVertexShader()->getCacheKey() != 0 && t.pipeline->getCacheKey() != 0);
+
+        GraphicsPipelineStateInit init;
+        init.program = t.program;
+        init.rootDescriptorLayout = t.layout;
+        init.primitiveTopology = PrimitiveTopology::TRIANGLE;
+        auto k0 = PipelineCache::evalPipelineKey(init);
+        assert(k0 == t.pipeline->getCacheKey());
+
+        std::vector<GraphicsPipelineStateInit> variants(6, init);
+        variants[0].blend.blendFunc = BlendFunction(true, BlendArg::SRC_ALPHA, BlendOp::ADD, BlendArg::INV_SRC_ALPHA);
+        variants[1].rasterizer.withCullBack();
+        variants[2].depthStencil = DepthStencilState(DepthTest(true, true));
+        variants[3].rootDescriptorLayout = device->createRootDescriptorLayout({ { { DescriptorType::PUSH_UNIFORM, ShaderStage::ALL_GRAPHICS, 0, 8 } } });
+        AttribArray<1> attribs{ {{ AttribSemantic::A, AttribFormat::VEC3, 0 }} };
+        AttribBufferViewArray<1> views{ {0} };
+        variants[4].streamLayout = StreamLayout::build(attribs, views);
+        variants[5].program = device->createProgram({ t.program->getVertexShader(),
+            device->createShader({ ShaderType::PIXEL, "mainPS", getTestPixelSource, std::string(), ShaderIncludeLib() }) });
+
+        std::unordered_set<PipelineCacheKey> keys{ k0 };
+        for (const auto& v : variants) {
+            assert(keys.insert(PipelineCache::evalPipelineKey(v)).second);
+        }
+
+        // The shaders of a device without cache have no key, their pipelines are not cached
+        auto uncached = Device::createDevice({ "Headless" });
+        assert(!uncached->getPipelineCache());
+        auto u = createTestPipeline(uncached);
+        assert(u.pipeline->getCacheKey() == 0);
+        init.program = u.program;
+        assert(PipelineCache::evalPipelineKey(init) == 0);
+        std::filesystem::remove_all(dir);
+        picoLog("PipelineCacheTest 3 passed: pipeline key follows shaders, blend, raster, depth, layout and stream");
+    }
+
+    // --- Test 4: stored entries load back, stale and damaged files are rejected ---
+    {
+        auto dir = testCacheDir("pico_pipeline_cache_test4");
+        std::vector<uint8_t> a(1000), b(33), c(8);
+        for (uint32_t i = 0; i < a.size(); ++i) {
+            a[i] = uint8_t(i * 7);
+        }
+        {
+            PipelineCache cache({ dir });
+            assert(cache.store(1, a.data(), a.size()) && cache.store(2, b.data(), b.size()) && cache.store(3, c.data(), c.size()));
+            assert(!cache.store(0, a.data(), a.size()));
+            assert(cache.store(2, a.data(), a.size())); // replaced
+            assert(cache.stats().numEntries == 3 && cache.stats().numBytes == 2 * a.size() + c.size());
+        }
+        assert(countCacheFiles(dir) == 3);
+
+        {
+            PipelineCache cache({ dir });
+            assert(cache.load() == 3);
+            PipelineCacheBlob blob;
+            assert(cache.find(1, blob) && blob == a);
+            assert(cache.find(2, blob) && blob == a);
+            assert(cache.find(3, blob) && blob == c);
+            assert(!cache.find(4, blob) && !cache.find(0, blob));
+            assert(cache.stats().numHits == 3 && cache.stats().numMisses == 2);
+            cache.evict(3);
+            assert(!cache.find(3, blob) && countCacheFiles(dir) == 2);
+        }
+
+        // Flip a byte of entry 1, truncate entry 2
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx.bin", 1ull);
+        auto file1 = (std::filesystem::path(dir) / name).string();
+        std::vector<uint8_t> bytes(std::filesystem::file_size(file1));
+        std::ifstream(file1, std::ios::binary).read((char*) bytes.data(), bytes.size());
+        bytes[bytes.size() / 2] ^= 1;
+        std::ofstream(file1, std::ios::binary | std::ios::trunc).write((const char*) bytes.data(), bytes.size());
+        snprintf(name, sizeof(name), "%016llx.bin", 2ull);
+        auto file2 = std::filesystem::path(dir) / name;
+        std::filesystem::resize_file(file2, std::filesystem::file_size(file2) - 1);
+        {
+            PipelineCache cache({ dir });
+            assert(cache.load() == 0 && cache.stats().numRejected == 2);
+            cache.store(5, c.data(), c.size());
+        }
+
+        // Another cache version ignores the entries
+        {
+            PipelineCache cache({ dir, 2 });
+            assert(cache.load() == 0 && cache.stats().numRejected == 3);
+        }
+        std::filesystem::remove_all(dir);
+        picoLog("PipelineCacheTest 4 passed: entries reloaded, corrupted, truncated and other version files rejected");
+    }
+
+    // --- Test 5: a second device on the same cache finds every shader and pipeline of the first run ---
+    {
+        auto dir = testCacheDir("pico_pipeline_cache_test5");
+        PipelineCacheStats cold, warm;
+        PipelineCacheKey coldKey = 0;
+        {
+            auto device = Device::createDevice({ "Headless", dir });
+            auto t = createTestPipeline(device);
+            coldKey = t.pipeline->getCacheKey();
+            cold = device->getPipelineCache()->stats();
+        }
+        {
+            auto device = Device::createDevice({ "Headless", dir });
+            auto t = createTestPipeline(device);
+            assert(t.pipeline->getCacheKey() == coldKey);
+            warm = device->getPipelineCache()->stats();
+        }
+        assert(cold.numLoaded == 0 && cold.numMisses == 3 && cold.numStores == 3 && cold.numHits == 0);
+        assert(warm.numLoaded == 3 && warm.numHits == 3 && warm.numMisses == 0 && warm.numStores == 0);
+        std::filesystem::remove_all(dir);
+        picoLog("PipelineCacheTest 5 passed: cold " + cold.toString() + " | warm " + warm.toString());
+    }
+
+    picoLog("PipelineCacheTest: all tests passed");
+}
+
+void runPipelineCacheBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+
+    // Startup load of a cache of typical size: 256 shaders of 12 KB, 128 pipeline blobs of 48 KB
+    {
+        auto dir = testCacheDir("pico_pipeline_cache_bench");
+        {
+            PipelineCache cache({ dir });
+            std::vector<uint8_t> blob(48 * 1024);
+            for (uint32_t e = 0; e < 384; ++e) {
+                for (uint32_t i = 0; i < blob.size(); ++i) {
+                    blob[i] = uint8_t(i * 31 + e);
+                }
+                cache.store(e + 1, blob.data(), (e < 256 ? 12 * 1024 : blob.size()));
+            }
+        }
+        double serialMs = 0.0, parallelMs = 0.0;
+        uint64_t numBytes = 0;
+        const uint32_t numRuns = 5;
+        for (uint32_t r = 0; r < numRuns; ++r) {
+            PipelineCache serial({ dir, 1, false });
+            serial.load();
+            serialMs += serial.stats().loadMs;
+            PipelineCache parallel({ dir, 1, true });
+            parallel.load();
+            parallelMs += parallel.stats().loadMs;
+            numBytes = parallel.stats().numBytes;
+        }
+        picoLogf("PipelineCacheBench load 384 entries ({} KB): serial {:.2f} ms | parallel {:.2f} ms | x{:.2f}",
+            numBytes >> 10, serialMs / numRuns, parallelMs / numRuns, serialMs / parallelMs);
+        std::filesystem::remove_all(dir);
+    }
+
+    // Key of a 64 KB shader source with a 16 KB include, the cost added to every shader creation
+    {
+        std::string source = "#include \"Common_inc.hlsl\"\n";
+        while (source.size() < 64 * 1024) {
+            source += "float4 f" + std::to_string(source.size()) + "(float4 v) { return v * COLOR + v.yzwx; }\n";
+        }
+        auto color = testColorSource;
+        while (testColorSource.size() < 16 * 1024) {
+            testColorSource += "// padding of the include, lorem ipsum dolor sit amet\n";
+        }
+        ShaderInit init(ShaderType::PIXEL, "mainPS", getTestPixelSource, std::string(), testIncludes());
+        const uint32_t numKeys = 200;
+        auto start = clock::now();
+        PipelineCacheKey k = 0;
+        for (uint32_t i = 0; i < numKeys; ++i) {
+            k += PipelineCache::evalShaderKey(init, PipelineCache::preprocessShaderSource(source, init.includes), "ps_6_1");
+        }
+        double keyUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / numKeys;
+        testColorSource = color;
+        picoLogf("PipelineCacheBench shader key of {} KB source: {:.1f} us ({:x})", source.size() >> 10, keyUs, k);
+    }
+
+    // Headless device startup with 64 pipelines, empty then warm cache
+    {
+        auto dir = testCacheDir("pico_pipeline_cache_bench_device");
+        auto startup = [&]() {
+            auto start = clock::now();
+            auto device = Device::createDevice({ "Headless", dir });
+            auto t = createTestPipeline(device);
+            std::vector<PipelineStatePointer> pipelines;
+            for (uint32_t p = 0; p < 64; ++p) {
+                GraphicsPipelineStateInit init;
+                init.program = t.program;
+                init.rootDescriptorLayout = t.layout;
+                init.rasterizer.depthBias = float(p);
+                pipelines.emplace_back(device->createGraphicsPipelineState(init));
+            }
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            return std::make_pair(ms, device->getPipelineCache()->stats());
+        };
+        auto cold = startup();
+        auto warm = startup();
+        picoLogf("PipelineCacheBench headless startup 64 pipelines: cold {:.2f} ms ({} stores) | warm {:.2f} ms ({} hits, load {:.2f} ms)",
+            cold.first, cold.second.numStores, warm.first, warm.second.numHits, warm.second.loadMs);
+        std::filesystem::remove_all(dir);
+    }
+}
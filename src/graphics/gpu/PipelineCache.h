@@ -0,0 +1,145 @@
+// PipelineCache.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+#include "gpu.h"
+#include "Shader.h"
+
+namespace graphics {
+
+    // PipelineCache: the compiled shaders and pipeline blobs persisted on disk between runs.
+    // An entry is addressed by the hash of the content it is built from:
+    // the preprocessed shader source, entry point, target profile and defines for a shader,
+    // the shader keys and the full state description for a pipeline.
+    // Editing a shader or an include changes the key, stale entries are simply never hit again.
+    // Each entry is its own file <key>.bin in the cache directory, all loaded in parallel at startup.
+    // The backends look up the cache before compiling and store what they built on a miss.
+
+    using PipelineCacheKey = uint64_t;
+    using PipelineCacheBlob = std::vector<uint8_t>;
+
+    // Stable 64 bits hash, the same on every run and platform of the same endianness, unlike std::hash.
+    // Hash the description field by field, never the raw bytes of a struct holding padding or bitfields.
+    class VISUALIZATION_API PipelineCacheHasher {
+    public:
+        PipelineCacheHasher(uint64_t seed = 0x9E3779B97F4A7C15ull) : _h(seed) {}
+
+        PipelineCacheHasher& bytes(const void* data, uint64_t size);
+        PipelineCacheHasher& string(const std::string& s) { return bytes(s.data(), s.size()); }
+
+        template <typename T>
+        PipelineCacheHasher& value(T v) {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "PipelineCacheHasher hashes scalar values");
+            uint64_t w = 0;
+            if constexpr (std::is_floating_point_v<T>) {
+                memcpy(&w, &v, sizeof(T));
+            } else {
+                w = static_cast<uint64_t>(v);
+            }
+            mix(w);
+            return *this;
+        }
+
+        // 0 is reserved for "no key"
+        inline PipelineCacheKey key() const { return (_h ? _h : 1); }
+
+    private:
+        inline void mix(uint64_t w) {
+            _h ^= w;
+            _h *= 0xFF51AFD7ED558CCDull;
+            _h ^= _h >> 32;
+        }
+        uint64_t _h;
+    };
+
+    struct VISUALIZATION_API PipelineCacheInit {
+        std::string path;          // directory of the cache files, created if missing
+        uint32_t version{ 1 };     // bump to drop every entry, e.g. on a compiler or driver update
+        bool parallelLoad{ true }; // load the files on the shared thread pool
+    };
+
+    struct VISUALIZATION_API PipelineCacheStats {
+        uint32_t numEntries{ 0 };
+        uint64_t numBytes{ 0 };
+        uint32_t numLoaded{ 0 };   // entries read by the last load
+        uint32_t numRejected{ 0 }; // files of another version, truncated or corrupted
+        double loadMs{ 0.0 };
+        uint32_t numHits{ 0 };
+        uint32_t numMisses{ 0 };
+        uint32_t numStores{ 0 };
+
+        std::string toString() const;
+    };
+
+    class VISUALIZATION_API PipelineCache {
+    public:
+        PipelineCache(const PipelineCacheInit& init);
+        ~PipelineCache();
+
+        // Read every entry of the cache directory, returns the number of entries loaded
+        uint32_t load();
+
+        // Copy the blob of the key, false on a miss
+        bool find(PipelineCacheKey key, PipelineCacheBlob& blob);
+
+        // Keep the blob for the key and write it to its file, replacing a previous one
+        bool store(PipelineCacheKey key, const void* data, uint64_t size);
+
+        // Forget the entry and delete its file, used when the backend rejects a blob
+        void evict(PipelineCacheKey key);
+
+        inline const PipelineCacheInit& init() const { return _init; }
+        PipelineCacheStats stats() const;
+
+        // Inline the #include "name" found in the include lib, recursively, each include once.
+        // The includes not in the lib are left to the compiler.
+        static std::string preprocessShaderSource(const std::string& source, const ShaderIncludeLib& includes);
+
+        // Key of the bytecode compiled from the preprocessed source for the target profile
+        static PipelineCacheKey evalShaderKey(const ShaderInit& init, const std::string& preprocessedSource, const std::string& target);
+
+        // Key of the pipeline, from the keys of its shaders and its state
+        static PipelineCacheKey evalPipelineKey(const GraphicsPipelineStateInit& init);
+        static PipelineCacheKey evalPipelineKey(const ComputePipelineStateInit& init);
+
+    private:
+        std::string filename(PipelineCacheKey key) const;
+
+        PipelineCacheInit _init;
+
+        mutable std::mutex _access;
+        std::unordered_map<PipelineCacheKey, PipelineCacheBlob> _entries;
+        PipelineCacheStats _stats;
+    };
+}
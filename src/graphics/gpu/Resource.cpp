@@ -33,6 +33,9 @@ Resource::Resource() {
 }
 
 Resource::~Resource() {
+    if (_heapPool) {
+        _heapPool->free(_heapAllocation);
+    }
 
 }
 
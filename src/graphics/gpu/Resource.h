@@ -27,14 +27,24 @@
 #pragma once
 
 #include "gpu.h"
+#include "HeapAllocator.h"
 
 #include <vector>
+#include <atomic>
 
 namespace graphics {
 
     class VISUALIZATION_API Resource {
     public:
         virtual ~Resource();
+
+        // The range of a pooled heap where the resource is placed, invalid for a dedicated allocation.
+        // Given back to the pool with the resource.
+        ResourceHeapPoolPointer _heapPool;
+        ResourceHeapAllocation _heapAllocation;
+
+        bool isPlaced() const { return _heapAllocation.isValid(); }
+
     protected:
         Resource();
 
@@ -116,7 +126,7 @@ namespace graphics {
         friend class Device;
         Texture();
 
-        bool _needUpload = true;
+        std::atomic<bool> _needUpload{ true };
 
     public:
         virtual ~Texture();
@@ -139,6 +149,10 @@ namespace graphics {
         // Called internally 
         void notifyUploaded() { _needUpload = false; }
 
+        // true for the one caller taking care of the pending upload,
+        // lets the draws and the streaming queue share a lazily uploaded texture
+        bool claimUpload() { return _needUpload.exchange(false); }
+
         static std::pair<UploadSubresourceLayoutArray, uint64_t> evalUploadSubresourceLayout(const TexturePointer& dest, const std::vector<uint32_t>& subresources = std::vector<uint32_t>());
     };
 
@@ -64,6 +64,8 @@ namespace graphics {
 
         ShaderIncludeLib includes;
 
+        std::vector<std::string> defines; // "NAME" or "NAME=VALUE" passed to the compiler
+
         ShaderInit() {}
 
         ShaderInit(ShaderType t, const std::string& e, const std::string& u, const ShaderIncludeLib& i = ShaderIncludeLib()) :
@@ -124,6 +126,9 @@ namespace graphics {
         const ShaderInit& getShaderDesc() const { return _shaderDesc; }
         const ProgramInit& getProgramDesc() const { return _programDesc; }
 
+        // Key of the compiled bytecode in the PipelineCache, 0 when the device has no cache
+        uint64_t getCacheKey() const { return _cacheKey; }
+
         // shader needs a recompile with a new source
         virtual bool recompile(const std::string& src);
         
@@ -134,6 +139,7 @@ namespace graphics {
        
         ShaderInit _shaderDesc;
         ProgramInit _programDesc;
+        uint64_t _cacheKey{ 0 };
 
         ShaderCompiler _shaderCompiler;
         ProgramLinker _programLinker;
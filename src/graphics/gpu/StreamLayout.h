@@ -27,7 +27,7 @@
 #pragma once
 
 #include <array>
-#include <core/log.h>
+#include <core/Log.h>
 #include "gpu.h"
 
 namespace graphics {
@@ -0,0 +1,360 @@
+// StreamingQueue.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "StreamingQueue.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "Batch.h"
+#include "Resource.h"
+#include "UploadRing.h"
+
+using namespace graphics;
+
+std::string StreamingQueueStats::toString() const {
+    std::ostringstream s;
+    s << "pending " << numPending << " (" << pendingBytes << " B) | frame " << numFrameUploads << " uploads (" << frameBytes << " B)"
+      << " | completed " << numCompleted << " (" << completedBytes << " B)";
+    return s.str();
+}
+
+StreamingQueue::StreamingQueue(const StreamingQueueInit& init) : _init(init) {
+}
+
+StreamingQueue::~StreamingQueue() {
+}
+
+void StreamingQueue::setFrameBudget(uint64_t frameBudget) {
+    const std::lock_guard<std::mutex> lock(_access);
+    _init.frameBudget = frameBudget;
+}
+
+StreamingQueueStats StreamingQueue::stats() const {
+    const std::lock_guard<std::mutex> lock(_access);
+    return _stats;
+}
+
+void StreamingQueue::enqueue(Request&& request, uint8_t priority) {
+    if (request.residency) {
+        request.residency->_numPending.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    const std::lock_guard<std::mutex> lock(_access);
+    _stats.numPending++;
+    _stats.pendingBytes += request.size;
+    _requests[std::min<uint8_t>(priority, LOW_PRIORITY)].emplace_back(std::move(request));
+}
+
+void StreamingQueue::enqueueBuffer(const BufferPointer& dest, const void* data, uint64_t size, uint8_t priority, const StreamResidencyPointer& residency) {
+    if (!dest || !data || size == 0) {
+        return;
+    }
+    Request request;
+    request.buffer = dest;
+    request.data.assign(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size);
+    request.size = size;
+    request.residency = residency;
+    enqueue(std::move(request), priority);
+}
+
+void StreamingQueue::enqueueTexture(const TexturePointer& dest, uint8_t priority, const StreamResidencyPointer& residency) {
+    if (!dest || !dest->_cpuDataBuffer || !dest->claimUpload()) {
+        return;
+    }
+    Request request;
+    request.texture = dest;
+    std::tie(request.subresources, request.size) = Texture::evalUploadSubresourceLayout(dest);
+    request.residency = residency;
+    if (request.subresources.empty()) {
+        dest->notifyUploaded();
+        return;
+    }
+    enqueue(std::move(request), priority);
+}
+
+void StreamingQueue::complete(Request& request) {
+    if (request.buffer) {
+        request.buffer->notifyUploaded();
+    } else {
+        request.texture->notifyUploaded();
+    }
+    if (request.residency) {
+        request.residency->_numPending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    _stats.numPending--;
+    _stats.numCompleted++;
+    _stats.completedBytes += request.size;
+}
+
+uint64_t StreamingQueue::drain(const BatchPointer& batch, UploadRing& ring) {
+    const std::lock_guard<std::mutex> lock(_access);
+    _stats.numFrameUploads = 0;
+    _stats.frameBytes = 0;
+
+    const uint64_t budget = std::max<uint64_t>(_init.frameBudget, 1);
+    // a chunk never takes more than the share of a frame in the ring
+    const uint64_t maxChunk = std::max<uint64_t>(ring.capacity() / ring.numFrames(), 1);
+    uint64_t used = 0;
+    bool full = false; // the ring, or the budget for the next texture subresource
+
+    for (auto& requests : _requests) {
+        while (!requests.empty() && used < budget && !full) {
+            auto& r = requests.front();
+            if (r.buffer) {
+                batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::SHADER_RESOURCE, ResourceState::COPY_DEST, r.buffer);
+                while (r.uploaded < r.size && used < budget) {
+                    uint64_t chunk = std::min({ r.size - r.uploaded, budget - used, maxChunk });
+                    if (!ring.upload(batch, r.buffer, (uint32_t) r.uploaded, r.data.data() + r.uploaded, (uint32_t) chunk)) {
+                        full = true; // the staging of the frames in flight is full, resume on the next frame
+                        break;
+                    }
+                    r.uploaded += chunk;
+                    used += chunk;
+                    _stats.numFrameUploads++;
+                }
+                batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::COPY_DEST, ResourceState::SHADER_RESOURCE, r.buffer);
+                if (r.uploaded < r.size) {
+                    break;
+                }
+            } else {
+                // A subresource is uploaded whole, the first one of the frame whatever its size
+                while (r.uploaded < r.subresources.size()) {
+                    const auto& layout = r.subresources[r.uploaded];
+                    if (used > 0 && used + layout.byteLength > budget) {
+                        break;
+                    }
+                    batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::SHADER_RESOURCE, ResourceState::COPY_DEST, r.texture, layout.subresource);
+                    batch->uploadTexture(r.texture, { layout }, r.texture->_cpuDataBuffer);
+                    batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::COPY_DEST, ResourceState::SHADER_RESOURCE, r.texture, layout.subresource);
+                    r.uploaded++;
+                    used += layout.byteLength;
+                    _stats.numFrameUploads++;
+                }
+                if (r.uploaded < r.subresources.size()) {
+                    full = true;
+                    break;
+                }
+            }
+            complete(r);
+            requests.pop_front();
+        }
+    }
+
+    _stats.frameBytes = used;
+    _stats.pendingBytes -= used;
+    return used;
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runStreamingQueueTests() to validate the priorities,
+// the frame budget and the residency of the streamed buffers and textures,
+// and runStreamingQueueBenchmarks() to measure the cost of the drains
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <numeric>
+
+#include <core/Log.h>
+
+#include "Device.h"
+#include "headless/HeadlessBackend.h"
+
+namespace {
+    using namespace graphics;
+
+    BufferPointer makeDeviceBuffer(const DevicePointer& device, uint32_t size) {
+        BufferInit init;
+        init.usage = ResourceUsage::RESOURCE_BUFFER;
+        init.bufferSize = size;
+        init.firstElement = 0;
+        init.numElements = size / 4;
+        init.structStride = 4;
+        return device->createBuffer(init);
+    }
+
+    std::vector<uint8_t> makeBytes(uint32_t size, uint8_t seed) {
+        std::vector<uint8_t> bytes(size);
+        std::iota(bytes.begin(), bytes.end(), seed);
+        return bytes;
+    }
+
+    bool sameOnGpu(const BufferPointer& buffer, const std::vector<uint8_t>& bytes) {
+        return static_cast<HeadlessBufferBackend*>(buffer.get())->_data == bytes;
+    }
+
+    uint64_t drainFrame(StreamingQueue& queue, UploadRing& ring, const BatchPointer& batch, uint32_t frame) {
+        ring.beginFrame(uint8_t(frame % ring.numFrames()));
+        batch->begin(frame % ring.numFrames());
+        auto bytes = queue.drain(batch, ring);
+        batch->end();
+        return bytes;
+    }
+}
+
+void runStreamingQueueTests() {
+    using namespace graphics;
+    picoLog("StreamingQueueTest: starting...");
+
+    auto device = Device::createDevice({ "Headless" });
+    auto batch = device->createBatch({});
+
+    // --- Test 1: the most urgent requests go first, whatever the order of the enqueues ---
+    {
+        StreamingQueue queue({ 1024 });
+        UploadRing ring(device, { 64 * 1024, 3 });
+        auto low = makeDeviceBuffer(device, 1024);
+        auto high = makeDeviceBuffer(device, 1024);
+        auto lowBytes = makeBytes(1024, 1);
+        auto highBytes = makeBytes(1024, 2);
+        auto lowResidency = std::make_shared<StreamResidency>();
+        auto highResidency = std::make_shared<StreamResidency>();
+
+        queue.enqueueBuffer(low, lowBytes.data(), lowBytes.size(), StreamingQueue::LOW_PRIORITY, lowResidency);
+        queue.enqueueBuffer(high, highBytes.data(), highBytes.size(), StreamingQueue::HIGH_PRIORITY, highResidency);
+        assert(!lowResidency->isResident() && !highResidency->isResident() && queue.stats().pendingBytes == 2048);
+
+        assert(drainFrame(queue, ring, batch, 0) == 1024);
+        assert(highResidency->isResident() && !lowResidency->isResident() && sameOnGpu(high, highBytes));
+        assert(!high->needUpload() && low->needUpload());
+        assert(drainFrame(queue, ring, batch, 1) == 1024);
+        assert(lowResidency->isResident() && sameOnGpu(low, lowBytes) && queue.empty());
+        picoLog("StreamingQueueTest 1 passed: " + queue.stats().toString());
+    }
+
+    // --- Test 2: a buffer bigger than the budget is uploaded in chunks over several frames ---
+    {
+        StreamingQueue queue({ 4096 });
+        UploadRing ring(device, { 64 * 1024, 3 });
+        auto buffer = makeDeviceBuffer(device, 10000);
+        auto bytes = makeBytes(10000, 3);
+        auto residency = std::make_shared<StreamResidency>();
+        queue.enqueueBuffer(buffer, bytes.data(), bytes.size(), StreamingQueue::HIGH_PRIORITY, residency);
+
+        uint32_t numFrames = 0;
+        while (!queue.empty()) {
+            assert(drainFrame(queue, ring, batch, numFrames++) <= 4096);
+            assert(static_cast<HeadlessBatchBackend*>(batch.get())->stats().bytesCopied <= 4096);
+        }
+        assert(numFrames == 3 && residency->isResident() && sameOnGpu(buffer, bytes));
+        assert(queue.stats().completedBytes == 10000 && queue.stats().pendingBytes == 0);
+        picoLog("StreamingQueueTest 2 passed: 10000 bytes streamed in " + std::to_string(numFrames) + " frames");
+    }
+
+    // --- Test 3: the ring full of the frames in flight delays the chunks to the next frames ---
+    {
+        StreamingQueue queue({ 4096 });
+        UploadRing ring(device, { 3 * 1024, 3 });
+        auto buffer = makeDeviceBuffer(device, 8192);
+        auto bytes = makeBytes(8192, 4);
+        queue.enqueueBuffer(buffer, bytes.data(), bytes.size(), StreamingQueue::HIGH_PRIORITY);
+
+        // 3 chunks fill the ring on the first frame, the next ones wait for it to retire
+        std::vector<uint64_t> frameBytes;
+        while (!queue.empty() && frameBytes.size() < 100) {
+            frameBytes.emplace_back(drainFrame(queue, ring, batch, (uint32_t) frameBytes.size()));
+        }
+        assert((frameBytes == std::vector<uint64_t>{ 3072, 0, 0, 3072, 0, 0, 2048 }));
+        assert(sameOnGpu(buffer, bytes) && ring.stats().peakInFlightBytes == ring.capacity());
+        uint32_t numFrames = (uint32_t) frameBytes.size();
+        picoLog("StreamingQueueTest 3 passed: 8192 bytes through a 3 KB ring in " + std::to_string(numFrames) + " frames");
+    }
+
+    // --- Test 4: a texture is uploaded a subresource at a time, the queue owns its upload ---
+    {
+        StreamingQueue queue({ 100 });
+        TextureInit textureInit;
+        textureInit.width = 4;
+        textureInit.height = 4;
+        textureInit.numSlices = 3;
+        textureInit.initData = { std::vector<uint8_t>(64, 1), std::vector<uint8_t>(64, 2), std::vector<uint8_t>(128, 3) };
+        auto texture = device->createTexture(textureInit);
+        auto residency = std::make_shared<StreamResidency>();
+        UploadRing ring(device, { 4096, 3 });
+
+        queue.enqueueTexture(texture, StreamingQueue::LOW_PRIORITY, residency);
+        assert(!texture->needUpload() && !texture->claimUpload()); // no one else uploads it
+        queue.enqueueTexture(texture, StreamingQueue::LOW_PRIORITY, residency); // nothing more to upload
+        assert(residency->numPending() == 1 && queue.stats().numPending == 1);
+
+        assert(drainFrame(queue, ring, batch, 0) == 64);
+        assert(drainFrame(queue, ring, batch, 1) == 64);
+        assert(!residency->isResident());
+        assert(drainFrame(queue, ring, batch, 2) == 128); // bigger than the budget, alone in its frame
+        assert(residency->isResident() && queue.empty());
+
+        auto tex = static_cast<HeadlessTextureBackend*>(texture.get());
+        assert(tex->_subresources.size() == 3 && tex->_subresources == textureInit.initData);
+        picoLog("StreamingQueueTest 4 passed: texture streamed a slice per frame");
+    }
+
+    picoLog("StreamingQueueTest: all tests passed");
+}
+
+void runStreamingQueueBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    auto device = Device::createDevice({ "Headless" });
+    auto batch = device->createBatch({});
+
+    // 4096 buffers of 4 KB to 256 KB streamed at different budgets
+    const uint32_t numBuffers = 4096;
+    std::vector<BufferPointer> buffers;
+    std::vector<std::vector<uint8_t>> bytes;
+    uint64_t totalBytes = 0;
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+        uint32_t size = 4096u << (i % 7);
+        buffers.emplace_back(makeDeviceBuffer(device, size));
+        bytes.emplace_back(makeBytes(size, uint8_t(i)));
+        totalBytes += size;
+    }
+
+    for (uint64_t budget : { 256 * 1024ull, 1024 * 1024ull, 4 * 1024 * 1024ull }) {
+        StreamingQueue queue({ budget });
+        UploadRing ring(device, { 16 * 1024 * 1024, 3 });
+
+        auto start = clock::now();
+        for (uint32_t i = 0; i < numBuffers; ++i) {
+            queue.enqueueBuffer(buffers[i], bytes[i].data(), bytes[i].size(), uint8_t(i % StreamingQueue::NUM_PRIORITIES));
+        }
+        double enqueueMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        uint32_t numFrames = 0;
+        double maxDrainMs = 0.0;
+        start = clock::now();
+        while (!queue.empty()) {
+            auto drainStart = clock::now();
+            drainFrame(queue, ring, batch, numFrames++);
+            maxDrainMs = std::max(maxDrainMs, std::chrono::duration<double, std::milli>(clock::now() - drainStart).count());
+        }
+        double drainMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        picoLogf("StreamingQueueBench {} buffers, {:.1f} MB at {} KB/frame: enqueue {:.2f} ms | {} frames, {:.3f} ms/frame, max {:.3f} ms",
+            numBuffers, totalBytes / (1024.0 * 1024.0), budget / 1024, enqueueMs, numFrames, drainMs / numFrames, maxDrainMs);
+    }
+}
@@ -0,0 +1,121 @@
+// StreamingQueue.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gpu.h"
+
+namespace graphics {
+
+    class UploadRing;
+
+    // StreamingQueue: the uploads of the imported resources spread over the frames.
+    // The imports enqueue the data of their buffers and textures with a priority, thread safe,
+    // the renderer drains the queue once per frame up to a byte budget, the most urgent requests first.
+    // A buffer is uploaded in chunks through the upload ring of the frame,
+    // a texture one subresource at a time from its cpu data buffer.
+    // The requests of a resource group count in a StreamResidency, resident once they are all uploaded,
+    // the drawables check it to draw a placeholder until then.
+
+    class VISUALIZATION_API StreamResidency {
+    public:
+        inline bool isResident() const { return _numPending.load(std::memory_order_acquire) == 0; }
+        inline uint32_t numPending() const { return _numPending.load(std::memory_order_acquire); }
+
+    private:
+        friend class StreamingQueue;
+        std::atomic<uint32_t> _numPending{ 0 };
+    };
+    using StreamResidencyPointer = std::shared_ptr<StreamResidency>;
+
+    struct VISUALIZATION_API StreamingQueueInit {
+        uint64_t frameBudget{ 1024 * 1024 }; // bytes uploaded per frame
+    };
+
+    struct VISUALIZATION_API StreamingQueueStats {
+        uint32_t numPending{ 0 };       // requests not completed
+        uint64_t pendingBytes{ 0 };
+        uint32_t numFrameUploads{ 0 };  // uploads recorded by the last drain
+        uint64_t frameBytes{ 0 };
+        uint32_t numCompleted{ 0 };     // since the creation of the queue
+        uint64_t completedBytes{ 0 };
+
+        std::string toString() const;
+    };
+
+    class VISUALIZATION_API StreamingQueue {
+    public:
+        static const uint8_t NUM_PRIORITIES = 4;
+        static const uint8_t HIGH_PRIORITY = 0;
+        static constexpr uint8_t LOW_PRIORITY = NUM_PRIORITIES - 1;
+
+        StreamingQueue(const StreamingQueueInit& init = StreamingQueueInit());
+        ~StreamingQueue();
+
+        // Upload size bytes of data to the start of the buffer, the data is copied in the request
+        void enqueueBuffer(const BufferPointer& dest, const void* data, uint64_t size, uint8_t priority, const StreamResidencyPointer& residency = nullptr);
+
+        // Upload the init data of the texture, kept in its cpu data buffer.
+        // The queue takes over the upload of the texture (see Texture::claimUpload).
+        void enqueueTexture(const TexturePointer& dest, uint8_t priority, const StreamResidencyPointer& residency = nullptr);
+
+        // Record the uploads of the frame, up to the frame budget. Returns the number of bytes uploaded.
+        // A texture subresource bigger than the budget goes alone in its frame.
+        uint64_t drain(const BatchPointer& batch, UploadRing& ring);
+
+        inline bool empty() const { return stats().numPending == 0; }
+        inline const StreamingQueueInit& init() const { return _init; }
+        void setFrameBudget(uint64_t frameBudget);
+        StreamingQueueStats stats() const;
+
+    private:
+        struct Request {
+            BufferPointer buffer;
+            TexturePointer texture;
+            std::vector<uint8_t> data;       // of the buffer
+            UploadSubresourceLayoutArray subresources; // of the texture
+            uint64_t size{ 0 };
+            uint64_t uploaded{ 0 };          // bytes of the buffer, subresources of the texture
+            StreamResidencyPointer residency;
+        };
+
+        void enqueue(Request&& request, uint8_t priority);
+        void complete(Request& request);
+
+        StreamingQueueInit _init;
+
+        mutable std::mutex _access;
+        std::deque<Request> _requests[NUM_PRIORITIES];
+        StreamingQueueStats _stats;
+    };
+    using StreamingQueuePointer = std::shared_ptr<StreamingQueue>;
+}
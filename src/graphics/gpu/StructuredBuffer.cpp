@@ -0,0 +1,206 @@
+// StructuredBuffer.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "StructuredBuffer.h"
+
+// -------------------------------------------------------------------------
+// Simple test — call runStructuredBufferTests() to validate the dirty page
+// uploads of the sync, and runStructuredBufferBenchmarks() to measure the
+// bytes uploaded for sparse edit patterns
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <random>
+
+#include <core/Log.h>
+
+#include "Device.h"
+#include "headless/HeadlessBackend.h"
+
+namespace {
+    using namespace graphics;
+
+    // 96 bytes, the size of a NodeTransform
+    struct TestElement {
+        float values[24];
+    };
+    using TestBuffer = StructuredBuffer<TestElement>;
+
+    HeadlessBatchBackend* headlessOf(const BatchPointer& batch) {
+        return static_cast<HeadlessBatchBackend*>(batch.get());
+    }
+
+    void fill(TestBuffer& buffer, const DevicePointer& device, uint32_t numElements) {
+        buffer.reserve(device, numElements);
+        for (uint32_t i = 0; i < numElements; ++i) {
+            TestElement e{ { float(i) } };
+            buffer.allocate_element(i, &e);
+        }
+    }
+
+    void edit(TestBuffer& buffer, uint32_t index, float value) {
+        auto [e, l] = buffer.write(index);
+        e->values[0] = value;
+    }
+
+    // Sync in its own batch, returns the stats of the batch
+    HeadlessFrameStats sync(TestBuffer& buffer, const BatchPointer& batch, const TestBuffer::IndexArray* touched = nullptr) {
+        batch->begin(0);
+        if (touched) {
+            buffer.sync_gpu_from_cpu(batch, *touched);
+        } else {
+            buffer.sync_gpu_from_cpu(batch);
+        }
+        batch->end();
+        return headlessOf(batch)->stats();
+    }
+
+    bool sameOnGpu(const TestBuffer& buffer, uint32_t numElements) {
+        return memcmp(buffer.gpu_buffer()->_cpuMappedAddress, buffer.unsafe_data(0), numElements * sizeof(TestElement)) == 0;
+    }
+}
+
+void runStructuredBufferTests() {
+    using namespace graphics;
+    picoLog("StructuredBufferTest: starting...");
+
+    const uint32_t numElements = 100000;
+    const uint32_t pageBytes = TestBuffer::DEFAULT_PAGE_BYTES / sizeof(TestElement) * sizeof(TestElement);
+    auto device = Device::createDevice({ "Headless" });
+    auto batch = device->createBatch({});
+
+    // --- Test 1: the first sync uploads the whole array, then only the pages of the writes ---
+    {
+        TestBuffer buffer;
+        fill(buffer, device, numElements);
+        auto s = sync(buffer, batch);
+        assert(s.bytesUploaded == numElements * sizeof(TestElement) && buffer.last_upload().numRanges == 1);
+        assert(sameOnGpu(buffer, numElements));
+
+        s = sync(buffer, batch);
+        assert(s.numUploads == 0 && s.numBarriers == 0);
+
+        edit(buffer, 0, -1.0f);
+        edit(buffer, numElements - 1, -2.0f);
+        s = sync(buffer, batch);
+        uint32_t lastPageBytes = (numElements % (pageBytes / sizeof(TestElement))) * sizeof(TestElement);
+        assert(s.numUploads == 2 && s.bytesUploaded == pageBytes + lastPageBytes);
+        const auto& log = headlessOf(batch)->commands();
+        // begin, barrier, the 2 uploads, barrier, end
+        assert(log[2].type == HeadlessCommandType::UPLOAD_BUFFER_REGION && log[2].args[0] == 0 && log[2].args[1] == pageBytes);
+        assert(log[3].type == HeadlessCommandType::UPLOAD_BUFFER_REGION && log[3].args[0] + log[3].args[1] == numElements * sizeof(TestElement));
+        assert(sameOnGpu(buffer, numElements));
+        picoLog("StructuredBufferTest 1 passed: first and last elements uploaded in " + std::to_string(s.bytesUploaded) + " bytes");
+    }
+
+    // --- Test 2: the contiguous dirty pages are uploaded in one range, the touched elements in any order ---
+    {
+        TestBuffer buffer;
+        fill(buffer, device, numElements);
+        sync(buffer, batch);
+
+        uint32_t pageSize = pageBytes / sizeof(TestElement);
+        TestBuffer::IndexArray touched = { 4 * pageSize + 1, pageSize, 2 * pageSize - 1, 2 * pageSize };
+        for (auto i : touched) {
+            buffer.unsafe_data(i)->values[1] = 1.0f;
+        }
+        auto s = sync(buffer, batch, &touched);
+        assert(s.numUploads == 2 && s.bytesUploaded == 3 * pageBytes);
+        assert(buffer.last_upload().numRanges == 2 && sameOnGpu(buffer, numElements));
+        picoLog("StructuredBufferTest 2 passed: 4 touched elements in 3 pages uploaded in 2 ranges");
+    }
+
+    // --- Test 3: the page size is configurable, the writes not tracked still reach the gpu ---
+    {
+        TestBuffer buffer;
+        fill(buffer, device, numElements);
+        buffer.set_page_bytes(1024);
+        assert(buffer.page_bytes() == 10 * sizeof(TestElement));
+        sync(buffer, batch);
+
+        edit(buffer, 25, 3.0f);
+        auto s = sync(buffer, batch);
+        assert(s.bytesUploaded == buffer.page_bytes() && headlessOf(batch)->commands()[2].args[0] == 2 * buffer.page_bytes());
+
+        buffer.unsafe_data(numElements / 2)->values[2] = 4.0f;
+        buffer.touch_all();
+        s = sync(buffer, batch);
+        assert(s.bytesUploaded == numElements * sizeof(TestElement) && sameOnGpu(buffer, numElements));
+        picoLog("StructuredBufferTest 3 passed: " + std::to_string(buffer.page_bytes()) + " bytes pages");
+    }
+
+    picoLog("StructuredBufferTest: all tests passed");
+}
+
+void runStructuredBufferBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    const uint32_t numElements = 100000;
+    const uint32_t numFrames = 20;
+    auto device = Device::createDevice({ "Headless" });
+    auto batch = device->createBatch({});
+    std::mt19937 rng(7);
+
+    for (uint32_t numEdits : { 1u, 16u, 256u, 4096u }) {
+        // The previous sync: one memcpy from the first to the last touched element, the whole buffer uploaded
+        std::uniform_int_distribution<uint32_t> pick(0, numElements - 1);
+        uint64_t spanBytes = 0;
+        for (uint32_t f = 0; f < numFrames; ++f) {
+            uint32_t first = numElements, last = 0;
+            for (uint32_t e = 0; e < numEdits; ++e) {
+                uint32_t i = pick(rng);
+                first = std::min(first, i);
+                last = std::max(last, i);
+            }
+            spanBytes += (last - first + 1) * sizeof(TestElement);
+        }
+
+        for (uint32_t pageBytes : { 1024u, TestBuffer::DEFAULT_PAGE_BYTES, 65536u }) {
+            TestBuffer buffer;
+            fill(buffer, device, numElements);
+            buffer.set_page_bytes(pageBytes);
+            sync(buffer, batch);
+
+            uint64_t bytesUploaded = 0, numRanges = 0;
+            double syncMs = 0.0;
+            for (uint32_t f = 0; f < numFrames; ++f) {
+                for (uint32_t e = 0; e < numEdits; ++e) {
+                    edit(buffer, pick(rng), float(f));
+                }
+                auto start = clock::now();
+                auto s = sync(buffer, batch);
+                syncMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+                bytesUploaded += s.bytesUploaded;
+                numRanges += buffer.last_upload().numRanges;
+            }
+            picoLogf("StructuredBufferBench {} random edits of {} elements, {} B pages: {:.1f} KB/frame in {} ranges, {:.3f} ms | previous sync: {:.1f} KB/frame uploaded, {:.1f} KB/frame copied",
+                numEdits, numElements, buffer.page_bytes(), bytesUploaded / 1024.0 / numFrames, numRanges / numFrames, syncMs / numFrames,
+                numElements * sizeof(TestElement) / 1024.0, spanBytes / 1024.0 / numFrames);
+        }
+    }
+}
@@ -27,8 +27,13 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include "Resource.h"
 #include "Batch.h"
+#include "UploadRing.h"
 
 namespace graphics {
 
@@ -41,6 +46,15 @@ namespace graphics {
         using IndexArray = std::vector<Index>;
         using Array = std::vector<T>;
 
+        // The writes are tracked per page of elements, a sync only uploads the dirty pages
+        static const uint32_t DEFAULT_PAGE_BYTES = 4096;
+
+        // What the last sync uploaded
+        struct UploadStats {
+            uint32_t numRanges{ 0 };
+            uint64_t numBytes{ 0 };
+        };
+
     private:
         mutable std::mutex  _cpu_access;
 
@@ -52,6 +66,91 @@ namespace graphics {
         BufferPointer       _gpu_buffer;
         Index               _gpu_capacity{ 0 };
 
+        // One bit per page of _page_size elements of the gpu buffer, set by the writes and cleared by the sync
+        std::vector<std::atomic_uint64_t> _dirty_pages;
+        Index               _page_size{ std::max<Index>(1, DEFAULT_PAGE_BYTES / sizeof(T)) };
+
+        // Scratch of the sync, kept around to avoid reallocating every frame
+        std::vector<uint64_t> _upload_pages;
+        std::vector<std::pair<Index, Index>> _upload_ranges;
+        UploadStats         _last_upload;
+
+        inline void mark_dirty(Index index) {
+            Index page = index / _page_size;
+            if ((page >> 6) < _dirty_pages.size()) {
+                _dirty_pages[page >> 6].fetch_or(1ull << (page & 63), std::memory_order_relaxed);
+            }
+        }
+
+        inline void mark_all_dirty() {
+            for (auto& w : _dirty_pages) {
+                w.store(~0ull, std::memory_order_relaxed);
+            }
+        }
+
+        inline void allocate_dirty_pages() {
+            Index num_pages = (_gpu_capacity + _page_size - 1) / _page_size;
+            _dirty_pages = std::vector<std::atomic_uint64_t>((num_pages + 63) / 64);
+            mark_all_dirty();
+        }
+
+        // Copy the dirty pages to the gpu buffer, the contiguous dirty pages in one upload.
+        // No dirty page at all means the array was written without tracking, then the whole array goes.
+        // With a ring, the pages are staged in the memory of the frame instead of the cpu copy of the gpu buffer
+        // which the frames in flight may still be reading from, the cpu copy is the fallback when the ring is full.
+        inline void upload_dirty_pages(const BatchPointer& batch, UploadRing* ring) {
+            _last_upload = UploadStats();
+
+            _upload_pages.resize(_dirty_pages.size());
+            bool any_dirty = false;
+            for (size_t w = 0; w < _dirty_pages.size(); ++w) {
+                _upload_pages[w] = _dirty_pages[w].exchange(0, std::memory_order_relaxed);
+                any_dirty |= (_upload_pages[w] != 0);
+            }
+            if (!any_dirty) {
+                std::fill(_upload_pages.begin(), _upload_pages.end(), ~0ull);
+            }
+
+            Index num_elements = std::min((Index) _cpu_array.size(), _gpu_capacity);
+            Index num_pages = (num_elements + _page_size - 1) / _page_size;
+            auto is_dirty = [&](Index page) { return (_upload_pages[page >> 6] >> (page & 63)) & 1; };
+
+            _upload_ranges.clear();
+            Index page = 0;
+            while (page < num_pages) {
+                uint64_t bits = _upload_pages[page >> 6] >> (page & 63);
+                if (!bits) {
+                    page = (page | 63) + 1;
+                    continue;
+                }
+                page += std::countr_zero(bits);
+                if (page >= num_pages) {
+                    break;
+                }
+                Index first = page;
+                while (page < num_pages && is_dirty(page)) {
+                    ++page;
+                }
+                _upload_ranges.emplace_back(first * _page_size, std::min(page * _page_size, num_elements));
+            }
+            if (_upload_ranges.empty()) {
+                return;
+            }
+
+            batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, _gpu_buffer);
+            for (const auto& [begin, end] : _upload_ranges) {
+                uint32_t offset = begin * sizeof(T);
+                uint32_t size = (end - begin) * sizeof(T);
+                if (!ring || !ring->upload(batch, _gpu_buffer, offset, _cpu_array.data() + begin, size)) {
+                    memcpy(reinterpret_cast<uint8_t*>(_gpu_buffer->_cpuMappedAddress) + offset, _cpu_array.data() + begin, size);
+                    batch->uploadBufferRegion(_gpu_buffer, offset, size);
+                }
+                _last_upload.numRanges++;
+                _last_upload.numBytes += size;
+            }
+            batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, _gpu_buffer);
+        }
+
     public:
 
         inline const T* unsafe_data(uint32_t index) const {
@@ -61,9 +160,32 @@ namespace graphics {
             return _cpu_array.data() + index;
         }
 
+        // Take note of elements written through unsafe_data, their pages go with the next sync
+        inline void touch(Index index) {
+            ++_cpu_version;
+            mark_dirty(index);
+        }
+        inline void touch(const IndexArray& indices) {
+            ++_cpu_version;
+            for (auto index : indices) {
+                mark_dirty(index);
+            }
+        }
+        inline void touch_range(Index begin, Index end) {
+            ++_cpu_version;
+            for (Index index = begin - begin % _page_size; index < end; index += _page_size) {
+                mark_dirty(index);
+            }
+        }
+        inline void touch_all() {
+            ++_cpu_version;
+            mark_all_dirty();
+        }
+
         inline void allocate_element(Index index, const T* init) {
             const std::lock_guard<std::mutex> access_lock(_cpu_access);
             ++_cpu_version;
+            mark_dirty(index);
             if (index < _cpu_array.size()) {
                 _cpu_array[index] = (init ? *init : T());
             } else {
@@ -75,9 +197,18 @@ namespace graphics {
         inline void set_element(Index index, const T* val) {
             const std::lock_guard<std::mutex> access_lock(_cpu_access);
             ++_cpu_version;
+            mark_dirty(index);
             _cpu_array[index] = (val ? *val : T());
         }
 
+        // Granularity of the dirty tracking, everything is uploaded on the next sync
+        inline void set_page_bytes(uint32_t bytes) {
+            const std::lock_guard<std::mutex> access_lock(_cpu_access);
+            _page_size = std::max<Index>(1, bytes / sizeof(T));
+            allocate_dirty_pages();
+        }
+        inline uint32_t page_bytes() const { return _page_size * sizeof(T); }
+
         inline void reserve(const DevicePointer& device, Index capacity) {
             // cpu array yeah
             if (_cpu_capacity < capacity) {
@@ -102,59 +233,44 @@ namespace graphics {
                 _gpu_buffer = device->createBuffer(items_buffer_init);
 
                 _gpu_capacity = capacity;
+                allocate_dirty_pages();
             }
         }
 
-        inline void sync_gpu_from_cpu(const BatchPointer& batch) {
+        inline void sync_gpu_from_cpu(const BatchPointer& batch, UploadRing* ring = nullptr) {
             // Capture the cpu version right now
             auto cpu_version = _cpu_version.load();
 
             // Schedule copy data from cpu to gpu here if versions are different
-            if (_gpu_version != cpu_version) {             
+            if (_gpu_version != cpu_version) {
                 const std::lock_guard<std::mutex> cpulock(_cpu_access);
 
                 _gpu_version = cpu_version;
 
-                memcpy(_gpu_buffer->_cpuMappedAddress, _cpu_array.data(), _cpu_array.size() * sizeof(T));
-                
-                batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, _gpu_buffer);
-                batch->uploadBuffer(_gpu_buffer);
-                batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, _gpu_buffer);
+                upload_dirty_pages(batch, ring);
             }
         }
 
-        inline void sync_gpu_from_cpu(const BatchPointer& batch, const IndexArray& touchedElementsOrdered) {
+        // Same with the elements written through unsafe_data since the last sync, in any order
+        inline void sync_gpu_from_cpu(const BatchPointer& batch, const IndexArray& touchedElements, UploadRing* ring = nullptr) {
             // Capture the cpu version right now
             auto cpu_version = _cpu_version.load();
 
             // Schedule copy data from cpu to gpu here if versions are different
-            if (touchedElementsOrdered.size() || _gpu_version != cpu_version) {
+            if (touchedElements.size() || _gpu_version != cpu_version) {
                 const std::lock_guard<std::mutex> cpulock(_cpu_access);
 
                 _gpu_version = cpu_version;
 
-                // only copy the touched values              
-                auto begin = 0;
-                auto end = _cpu_array.size();
-
-                if (touchedElementsOrdered.size()) {
-                    begin = touchedElementsOrdered.front();
-                    end = touchedElementsOrdered.back() + 1;
-                }
-                auto count = end - begin;
-                if (count > 0) {
-
-                    auto gpu_p = reinterpret_cast<T*>(_gpu_buffer->_cpuMappedAddress) + begin;
-                    auto cpu_p = _cpu_array.data() + begin;
-                    memcpy(gpu_p, (void*)cpu_p, count * sizeof(T));
+                for (auto index : touchedElements) {
+                    mark_dirty(index);
                 }
-
-                batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, _gpu_buffer);
-                batch->uploadBuffer(_gpu_buffer);
-                batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, _gpu_buffer);
+                upload_dirty_pages(batch, ring);
             }
         }
 
+        inline const UploadStats& last_upload() const { return _last_upload; }
+
         inline BufferPointer gpu_buffer() const { return _gpu_buffer; }
 
         using ReadLock = std::pair< const T*, std::lock_guard<std::mutex>>;
@@ -165,6 +281,7 @@ namespace graphics {
         }
         inline WriteLock write(Index index) {
             ++_cpu_version; // Write access increment cpu version
+            mark_dirty(index);
             return  WriteLock(unsafe_data(index), _cpu_access);
         }
 
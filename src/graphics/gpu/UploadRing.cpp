@@ -0,0 +1,313 @@
+// UploadRing.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "Device.h"
+#include "Batch.h"
+#include "Resource.h"
+
+using namespace graphics;
+
+std::string UploadRingStats::toString() const {
+    std::ostringstream s;
+    s << "frame " << numFrames << " | allocations " << numAllocations << " (" << numBytes << " B, " << numFailed << " failed)"
+      << " | in flight " << inFlightBytes << " B | peak " << peakInFlightBytes << " B";
+    return s.str();
+}
+
+UploadRing::UploadRing(const DevicePointer& device, const UploadRingInit& init) {
+    _capacity = std::max(init.capacity, DEFAULT_ALIGNMENT);
+
+    BufferInit bufferInit;
+    bufferInit.bufferSize = _capacity;
+    bufferInit.hostVisible = true;
+    _buffer = device->createBuffer(bufferInit);
+    _base = reinterpret_cast<uint8_t*>(_buffer->_cpuMappedAddress);
+
+    _frameEnds.assign(std::max(init.numFrames, 1u), NO_FRAME);
+}
+
+UploadRing::~UploadRing() {
+}
+
+void UploadRing::beginFrame(uint8_t frameIndex) {
+    const std::lock_guard<std::mutex> lock(_access);
+
+    // Close the current frame, then release the frame which recorded in the new slot
+    _frameEnds[_currentFrame] = _head;
+    _currentFrame = frameIndex % numFrames();
+    if (_frameEnds[_currentFrame] != NO_FRAME) {
+        _tail = std::max(_tail, _frameEnds[_currentFrame]);
+        _frameEnds[_currentFrame] = NO_FRAME;
+    }
+
+    _stats.numFrames++;
+    _stats.numAllocations = 0;
+    _stats.numBytes = 0;
+    _stats.numFailed = 0;
+}
+
+UploadAllocation UploadRing::allocate(uint32_t size, uint32_t alignment) {
+    const std::lock_guard<std::mutex> lock(_access);
+    if (size == 0 || size > _capacity) {
+        _stats.numFailed++;
+        return {};
+    }
+
+    uint64_t offset = _head % _capacity;
+    uint64_t alignedOffset = (alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset);
+    uint64_t start = _head + (alignedOffset - offset);
+    if (alignedOffset + size > _capacity) {
+        // the allocations are contiguous, skip the end of the buffer
+        start = _head + (_capacity - offset);
+        alignedOffset = 0;
+    }
+    uint64_t end = start + size;
+    if (end - _tail > _capacity) {
+        _stats.numFailed++;
+        return {};
+    }
+
+    _stats.numAllocations++;
+    _stats.numBytes += end - _head;
+    _head = end;
+    _stats.peakInFlightBytes = std::max(_stats.peakInFlightBytes, _head - _tail);
+
+    return { _base + alignedOffset, (uint32_t) alignedOffset, size };
+}
+
+bool UploadRing::upload(const BatchPointer& batch, const BufferPointer& dest, uint32_t destOffset, const void* data, uint32_t size) {
+    auto allocation = allocate(size, 16);
+    if (!allocation.isValid()) {
+        return false;
+    }
+    memcpy(allocation.data, data, size);
+    batch->copyBufferRegion(dest, destOffset, _buffer, allocation.offset, size);
+    return true;
+}
+
+UploadRingStats UploadRing::stats() const {
+    const std::lock_guard<std::mutex> lock(_access);
+    auto s = _stats;
+    s.inFlightBytes = _head - _tail;
+    return s;
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runUploadRingTests() to validate the suballocation and
+// the recycling of the frames, and runUploadRingBenchmarks() to measure the
+// allocation throughput and the peak staging memory of the scene syncs
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <random>
+
+#include <core/Log.h>
+
+#include "StructuredBuffer.h"
+#include "headless/HeadlessBackend.h"
+
+namespace {
+    using namespace graphics;
+
+    // 96 bytes, the size of a NodeTransform
+    struct TestElement {
+        float values[24];
+    };
+    using TestBuffer = StructuredBuffer<TestElement>;
+
+    HeadlessBatchBackend* headlessOf(const BatchPointer& batch) {
+        return static_cast<HeadlessBatchBackend*>(batch.get());
+    }
+
+    void fill(TestBuffer& buffer, const DevicePointer& device, uint32_t numElements) {
+        buffer.reserve(device, numElements);
+        for (uint32_t i = 0; i < numElements; ++i) {
+            TestElement e{ { float(i) } };
+            buffer.allocate_element(i, &e);
+        }
+    }
+
+    bool sameOnGpu(const TestBuffer& buffer, uint32_t numElements) {
+        return memcmp(buffer.gpu_buffer()->_cpuMappedAddress, buffer.unsafe_data(0), numElements * sizeof(TestElement)) == 0;
+    }
+}
+
+void runUploadRingTests() {
+    using namespace graphics;
+    picoLog("UploadRingTest: starting...");
+
+    auto device = Device::createDevice({ "Headless" });
+
+    // --- Test 1: the allocations are aligned and contiguous in the ring ---
+    {
+        UploadRing ring(device, { 4096, 3 });
+        ring.beginFrame(0);
+        auto a = ring.allocate(100);
+        auto b = ring.allocate(4, 4);
+        auto c = ring.allocate(10);
+        assert(a.isValid() && b.isValid() && c.isValid());
+        assert(a.offset == 0 && b.offset == 100 && c.offset == 256);
+        assert(c.data == reinterpret_cast<uint8_t*>(ring.buffer()->_cpuMappedAddress) + 256);
+
+        auto s = ring.stats();
+        assert(s.numAllocations == 3 && s.numBytes == 266 && s.inFlightBytes == 266 && s.numFailed == 0);
+        assert(!ring.allocate(0).isValid() && !ring.allocate(4097).isValid() && ring.stats().numFailed == 2);
+        picoLog("UploadRingTest 1 passed: " + ring.stats().toString());
+    }
+
+    // --- Test 2: the ring fills up with the frames in flight, the memory of a frame comes back when its slot is recorded again ---
+    {
+        UploadRing ring(device, { 1024, 3 });
+        ring.beginFrame(0);
+        for (uint32_t i = 0; i < 3; ++i) {
+            assert(ring.allocate(256).offset == i * 256);
+        }
+        ring.beginFrame(1);
+        assert(ring.allocate(128).offset == 768);
+        assert(!ring.allocate(256).isValid() && ring.stats().numFailed == 1);
+        ring.beginFrame(2);
+        assert(!ring.allocate(256).isValid()); // frames 0 and 1 are still in flight
+
+        // frame 0 retired: its 768 bytes are free, the allocation not fitting at the end of the buffer wraps to the start
+        ring.beginFrame(0);
+        auto s = ring.stats();
+        assert(s.inFlightBytes == 128 && s.numFailed == 0 && s.numAllocations == 0);
+        assert(ring.allocate(512).offset == 0 && ring.stats().numBytes == 640);
+        assert(ring.allocate(256).offset == 512);
+        assert(!ring.allocate(1).isValid());
+        assert(ring.stats().inFlightBytes == 1024 && ring.stats().peakInFlightBytes == 1024);
+
+        // the end of the buffer skipped by the wrap is released with the frame
+        ring.beginFrame(1);
+        ring.beginFrame(2);
+        ring.beginFrame(0);
+        assert(ring.stats().inFlightBytes == 0 && ring.allocate(256).offset == 768);
+        picoLog("UploadRingTest 2 passed: frames recycled, " + ring.stats().toString());
+    }
+
+    // --- Test 3: a StructuredBuffer synced through the ring, back to its own staging when the ring is full ---
+    {
+        const uint32_t numElements = 1000;
+        auto batch = device->createBatch({});
+        TestBuffer buffer;
+        fill(buffer, device, numElements);
+
+        UploadRing ring(device, { 128 * 1024, 3 });
+        ring.beginFrame(0);
+        batch->begin(0);
+        buffer.sync_gpu_from_cpu(batch, &ring);
+        batch->end();
+        const auto& log = headlessOf(batch)->commands();
+        assert(log[2].type == HeadlessCommandType::COPY_BUFFER_REGION && log[2].object == buffer.gpu_buffer().get());
+        assert(log[2].args[2] == numElements * sizeof(TestElement) && headlessOf(batch)->stats().numUploads == 0);
+        assert(sameOnGpu(buffer, numElements));
+
+        // room for one page only, the second falls back to the upload of the cpu double
+        UploadRing small(device, { 6000, 3 });
+        small.beginFrame(0);
+        buffer.unsafe_data(10)->values[0] = -1.0f;
+        buffer.unsafe_data(900)->values[0] = -2.0f;
+        TestBuffer::IndexArray touched = { 900, 10 };
+        batch->begin(0);
+        buffer.sync_gpu_from_cpu(batch, touched, &small);
+        batch->end();
+        auto s = headlessOf(batch)->stats();
+        assert(small.stats().numAllocations == 1 && small.stats().numFailed == 1);
+        assert(s.bytesCopied == buffer.page_bytes() && s.numUploads == 1 && s.bytesUploaded == buffer.page_bytes());
+        assert(sameOnGpu(buffer, numElements));
+        picoLog("UploadRingTest 3 passed: structured buffer synced through the ring");
+    }
+
+    picoLog("UploadRingTest: all tests passed");
+}
+
+void runUploadRingBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    auto device = Device::createDevice({ "Headless" });
+    std::mt19937 rng(7);
+
+    // Allocation throughput, small allocations of a few frames in flight
+    {
+        const uint32_t numFrames = 100;
+        const uint32_t numAllocations = 8000;
+        UploadRing ring(device);
+        std::uniform_int_distribution<uint32_t> pickSize(16, 256);
+        std::vector<uint32_t> sizes(numAllocations);
+        for (auto& s : sizes) s = pickSize(rng);
+
+        uint64_t numFailed = 0;
+        auto start = clock::now();
+        for (uint32_t f = 0; f < numFrames; ++f) {
+            ring.beginFrame(uint8_t(f % ring.numFrames()));
+            for (auto s : sizes) {
+                ring.allocate(s, 16);
+            }
+            numFailed += ring.stats().numFailed;
+        }
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        picoLogf("UploadRingBench {} allocations/frame: {:.1f} M allocations/s, {} failed | peak in flight {:.1f} KB of {} KB",
+            numAllocations, numFrames * numAllocations / ms / 1000.0, numFailed, ring.stats().peakInFlightBytes / 1024.0, ring.capacity() / 1024);
+    }
+
+    // Staging memory of the sparse syncs of a 100000 elements buffer,
+    // against the cpu double of the gpu buffer used by the sync without ring
+    const uint32_t numElements = 100000;
+    const uint32_t numFrames = 30;
+    auto batch = device->createBatch({});
+    std::uniform_int_distribution<uint32_t> pick(0, numElements - 1);
+    for (uint32_t numEdits : { 16u, 256u, 4096u }) {
+        TestBuffer buffer;
+        fill(buffer, device, numElements);
+        UploadRing ring(device);
+
+        double syncMs = 0.0;
+        uint32_t numFailed = 0;
+        for (uint32_t f = 0; f < numFrames; ++f) {
+            for (uint32_t e = 0; e < numEdits; ++e) {
+                auto [el, l] = buffer.write(pick(rng));
+                el->values[0] = float(f);
+            }
+            auto start = clock::now();
+            ring.beginFrame(uint8_t(f % ring.numFrames()));
+            batch->begin(f % ring.numFrames());
+            buffer.sync_gpu_from_cpu(batch, &ring);
+            batch->end();
+            syncMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            numFailed += ring.stats().numFailed;
+        }
+        picoLogf("UploadRingBench {} random edits of {} elements: {:.3f} ms/sync, {} fallbacks | peak staging {:.1f} KB in the ring, {:.1f} KB for the cpu double",
+            numEdits, numElements, syncMs / numFrames, numFailed, ring.stats().peakInFlightBytes / 1024.0, numElements * sizeof(TestElement) / 1024.0);
+    }
+}
@@ -0,0 +1,110 @@
+// UploadRing.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gpu.h"
+
+namespace graphics {
+
+    // UploadRing: the staging memory of the transient per frame data.
+    // One host visible buffer suballocated linearly, the allocations of a frame are recycled
+    // once the frame has retired.
+    // The frames in flight are the slots of the swapchain: beginFrame(currentIndex) is called
+    // once the previous frame recorded with the same index has completed on the gpu
+    // (presentSwapchain waits for it), its allocations are then released all at once.
+    // The data is copied from the ring to its destination with Batch::copyBufferRegion.
+
+    struct VISUALIZATION_API UploadRingInit {
+        uint32_t capacity{ 4 * 1024 * 1024 }; // bytes
+        uint32_t numFrames{ 3 };              // frames in flight, the number of swapchain slots
+    };
+
+    struct VISUALIZATION_API UploadAllocation {
+        uint8_t* data{ nullptr }; // where to write the data
+        uint32_t offset{ 0 };     // of the allocation in the ring buffer
+        uint32_t size{ 0 };
+
+        inline bool isValid() const { return data != nullptr; }
+    };
+
+    struct VISUALIZATION_API UploadRingStats {
+        uint32_t numFrames{ 0 };
+        uint32_t numAllocations{ 0 };   // for the current frame
+        uint64_t numBytes{ 0 };         // allocated for the current frame, alignment included
+        uint32_t numFailed{ 0 };        // allocations not fitting in the ring for the current frame
+        uint64_t inFlightBytes{ 0 };    // of the frames not retired yet, current frame included
+        uint64_t peakInFlightBytes{ 0 }; // since the creation of the ring
+
+        std::string toString() const;
+    };
+
+    class VISUALIZATION_API UploadRing {
+    public:
+        static constexpr uint32_t DEFAULT_ALIGNMENT = 256; // constant buffer placement, and more than any copy needs
+
+        UploadRing(const DevicePointer& device, const UploadRingInit& init = UploadRingInit());
+        ~UploadRing();
+
+        // Start the frame recorded in the slot frameIndex,
+        // the frame previously recorded in the same slot has retired
+        void beginFrame(uint8_t frameIndex);
+
+        // Suballocate size bytes for the current frame, an invalid allocation if the ring is full.
+        // Thread safe.
+        UploadAllocation allocate(uint32_t size, uint32_t alignment = DEFAULT_ALIGNMENT);
+
+        // Copy the data in the ring and record its copy to dest, false if the ring is full
+        bool upload(const BatchPointer& batch, const BufferPointer& dest, uint32_t destOffset, const void* data, uint32_t size);
+
+        inline const BufferPointer& buffer() const { return _buffer; }
+        inline uint32_t capacity() const { return _capacity; }
+        inline uint32_t numFrames() const { return (uint32_t) _frameEnds.size(); }
+        UploadRingStats stats() const;
+
+    private:
+        static constexpr uint64_t NO_FRAME = ~0ull;
+
+        BufferPointer _buffer;
+        uint8_t* _base{ nullptr };
+        uint32_t _capacity{ 0 };
+
+        // Positions in the ring grow forever, the offset in the buffer is position % capacity
+        mutable std::mutex _access;
+        uint64_t _head{ 0 };     // next free byte
+        uint64_t _tail{ 0 };     // first byte still in flight
+        std::vector<uint64_t> _frameEnds; // head at the end of the frame recorded in every slot
+        uint32_t _currentFrame{ 0 };
+
+        UploadRingStats _stats;
+    };
+
+    using UploadRingPointer = std::shared_ptr<UploadRing>;
+}
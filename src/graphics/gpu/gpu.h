@@ -190,6 +190,10 @@ namespace graphics {
     struct UploadSubresourceLayout;
     using UploadSubresourceLayoutArray = std::vector<UploadSubresourceLayout>;
 
+    class ResourceHeapPool;
+    using ResourceHeapPoolPointer = std::shared_ptr<ResourceHeapPool>;
+    struct ResourceHeapPoolInit;
+
     class Geometry;
     using GeometryPointer = std::shared_ptr<Geometry>;
     struct GeometryInit;
@@ -223,6 +227,10 @@ namespace graphics {
     struct ComputePipelineStateInit;
     struct RaytracingPipelineStateInit;
 
+    class PipelineCache;
+    using PipelineCachePointer = std::shared_ptr<PipelineCache>;
+    struct PipelineCacheInit;
+
     struct ShaderEntry;
     struct ShaderTableInit;
     class ShaderTable;
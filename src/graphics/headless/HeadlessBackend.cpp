@@ -0,0 +1,865 @@
+// HeadlessBackend.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HeadlessBackend.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "gpu/PipelineCache.h"
+
+using namespace graphics;
+
+// Factory function, called from Device.cpp via forward declaration
+namespace graphics {
+    DeviceBackend* createHeadlessBackend() {
+        return new HeadlessBackend();
+    }
+}
+
+HeadlessSwapchainBackend::HeadlessSwapchainBackend() {}
+HeadlessSwapchainBackend::~HeadlessSwapchainBackend() {}
+
+HeadlessFramebufferBackend::HeadlessFramebufferBackend() {}
+HeadlessFramebufferBackend::~HeadlessFramebufferBackend() {}
+
+HeadlessBufferBackend::HeadlessBufferBackend() {}
+HeadlessBufferBackend::~HeadlessBufferBackend() {}
+
+HeadlessTextureBackend::HeadlessTextureBackend() {}
+HeadlessTextureBackend::~HeadlessTextureBackend() {}
+
+HeadlessGeometryBackend::HeadlessGeometryBackend() {}
+HeadlessGeometryBackend::~HeadlessGeometryBackend() {}
+
+HeadlessShaderBackend::HeadlessShaderBackend() {}
+HeadlessShaderBackend::~HeadlessShaderBackend() {}
+
+HeadlessSamplerBackend::HeadlessSamplerBackend() {}
+HeadlessSamplerBackend::~HeadlessSamplerBackend() {}
+
+HeadlessPipelineStateBackend::HeadlessPipelineStateBackend() {}
+HeadlessPipelineStateBackend::~HeadlessPipelineStateBackend() {}
+
+HeadlessRootDescriptorLayoutBackend::HeadlessRootDescriptorLayoutBackend() {}
+HeadlessRootDescriptorLayoutBackend::~HeadlessRootDescriptorLayoutBackend() {}
+
+HeadlessDescriptorHeapBackend::HeadlessDescriptorHeapBackend() {}
+HeadlessDescriptorHeapBackend::~HeadlessDescriptorHeapBackend() {}
+
+int32_t HeadlessDescriptorHeapBackend::allocateDescriptors(int32_t numDescriptors) {
+    auto offset = _descriptorCount;
+    _descriptorCount += numDescriptors;
+    return offset;
+}
+
+int32_t HeadlessDescriptorHeapBackend::allocateSamplers(int32_t numSamplers) {
+    auto offset = _samplerCount;
+    _samplerCount += numSamplers;
+    return offset;
+}
+
+HeadlessDescriptorSetBackend::HeadlessDescriptorSetBackend() {}
+HeadlessDescriptorSetBackend::~HeadlessDescriptorSetBackend() {}
+
+HeadlessBatchTimerBackend::HeadlessBatchTimerBackend() {}
+HeadlessBatchTimerBackend::~HeadlessBatchTimerBackend() {}
+
+HeadlessBackend::HeadlessBackend() {
+    _descriptorHeap = createDescriptorHeap({});
+
+    // No memory behind the heaps, a token for the native heap
+    auto createHeap = [](uint64_t size) { return std::make_shared<uint64_t>(size); };
+    _bufferHeapPool = std::make_shared<ResourceHeapPool>(ResourceHeapPoolInit(), createHeap);
+    _textureHeapPool = std::make_shared<ResourceHeapPool>(ResourceHeapPoolInit(), createHeap);
+}
+
+HeadlessBackend::~HeadlessBackend() {
+}
+
+SwapchainPointer HeadlessBackend::createSwapchain(const SwapchainInit& init) {
+    auto swapchain = new HeadlessSwapchainBackend();
+    swapchain->_init = init;
+
+    FramebufferInit_Swapable fbInit;
+    fbInit.width = init.width;
+    fbInit.height = init.height;
+    fbInit.chainLength = CHAIN_NUM_FRAMES;
+    fbInit.depthBuffer = init.depthBuffer;
+    fbInit.colorFormat = init.colorBufferFormat;
+    swapchain->_framebuffer = createFramebuffer(fbInit);
+
+    return SwapchainPointer(swapchain);
+}
+
+void HeadlessBackend::resizeSwapchain(const SwapchainPointer& swapchain, uint32_t width, uint32_t height) {
+    auto sw = static_cast<HeadlessSwapchainBackend*>(swapchain.get());
+    sw->_init.width = width;
+    sw->_init.height = height;
+    sw->_currentIndex = 0;
+    resizeFramebuffer(sw->_framebuffer, width, height);
+}
+
+FramebufferPointer HeadlessBackend::createFramebuffer(const FramebufferInit& init) {
+    auto framebuffer = new HeadlessFramebufferBackend();
+    framebuffer->_init = init;
+
+    auto width = (init.width == 0 ? 0xFFFFFFFF : init.width);
+    auto height = (init.height == 0 ? 0xFFFFFFFF : init.height);
+    for (const auto& tex : init.colorTargets) {
+        width = std::min(width, tex->width());
+        height = std::min(height, tex->height());
+        framebuffer->_colorBuffers.push_back(tex);
+    }
+    if (init.depthStencilTarget) {
+        width = std::min(width, init.depthStencilTarget->width());
+        height = std::min(height, init.depthStencilTarget->height());
+        framebuffer->_depthBuffers.push_back(init.depthStencilTarget);
+    }
+    framebuffer->_init.width = width;
+    framebuffer->_init.height = height;
+
+    return FramebufferPointer(framebuffer);
+}
+
+FramebufferPointer HeadlessBackend::createFramebuffer(const FramebufferInit_Swapable& init) {
+    auto framebuffer = new HeadlessFramebufferBackend();
+    framebuffer->_chainLength = init.chainLength;
+
+    for (uint32_t i = 0; i < init.chainLength; ++i) {
+        TextureInit colorInit;
+        colorInit.usage = ResourceUsage::RENDER_TARGET;
+        colorInit.width = init.width;
+        colorInit.height = init.height;
+        colorInit.format = init.colorFormat;
+        framebuffer->_colorBuffers.push_back(createTexture(colorInit));
+
+        if (init.depthBuffer) {
+            TextureInit depthInit;
+            depthInit.usage = ResourceUsage::RENDER_TARGET;
+            depthInit.width = init.width;
+            depthInit.height = init.height;
+            depthInit.format = init.depthFormat;
+            framebuffer->_depthBuffers.push_back(createTexture(depthInit));
+        }
+    }
+
+    framebuffer->_init.width = init.width;
+    framebuffer->_init.height = init.height;
+
+    return FramebufferPointer(framebuffer);
+}
+
+void HeadlessBackend::resizeFramebuffer(const FramebufferPointer& framebuffer, uint32_t width, uint32_t height) {
+    if (framebuffer->width() == width && framebuffer->height() == height) return;
+
+    auto fb = static_cast<HeadlessFramebufferBackend*>(framebuffer.get());
+    for (auto& tex : fb->_colorBuffers) resizeTexture(tex, width, height);
+    for (auto& tex : fb->_depthBuffers) resizeTexture(tex, width, height);
+
+    fb->_init.width = width;
+    fb->_init.height = height;
+    fb->_currentIndex = 0;
+}
+
+void HeadlessBackend::resizeTexture(const TexturePointer& texture, uint32_t width, uint32_t height) {
+    if (texture->width() == width && texture->height() == height) return;
+
+    auto tex = static_cast<HeadlessTextureBackend*>(texture.get());
+    tex->_init.width = width;
+    tex->_init.height = height;
+    tex->_subresources.clear();
+}
+
+BatchPointer HeadlessBackend::createBatch(const BatchInit& init) {
+    return BatchPointer(new HeadlessBatchBackend());
+}
+
+BatchTimerPointer HeadlessBackend::createBatchTimer(const BatchTimerInit& init) {
+    auto timer = new HeadlessBatchTimerBackend();
+    timer->_init = init;
+
+    // The timer buffer is bound in the view pass descriptor set, it needs to exist
+    BufferInit bufferInit;
+    bufferInit.usage = ResourceUsage::RESOURCE_BUFFER;
+    bufferInit.bufferSize = init.numSamples * 2 * sizeof(uint64_t);
+    bufferInit.hostVisible = true;
+    bufferInit.numElements = init.numSamples * 2;
+    bufferInit.structStride = sizeof(uint64_t);
+    timer->_buffer = _createBuffer(bufferInit, "BatchTimer");
+
+    return BatchTimerPointer(timer);
+}
+
+BufferPointer HeadlessBackend::_createBuffer(const BufferInit& init, const std::string& name) {
+    auto buffer = new HeadlessBufferBackend();
+    buffer->_init = init;
+    buffer->_name = name;
+    buffer->_bufferSize = init.bufferSize;
+    buffer->_data.resize(init.bufferSize);
+    buffer->_cpuMappedAddress = buffer->_data.data();
+
+    // Same as an upload heap buffer, written in place by the cpu
+    if (!init.cpuDouble && init.hostVisible) {
+        buffer->notifyUploaded();
+    } else {
+        buffer->_heapAllocation = _bufferHeapPool->allocate(init.bufferSize, PLACEMENT_ALIGNMENT);
+        if (buffer->_heapAllocation.isValid()) {
+            buffer->_heapPool = _bufferHeapPool;
+        }
+    }
+
+    _allocatedBufferBytes += init.bufferSize;
+    return BufferPointer(buffer);
+}
+
+TexturePointer HeadlessBackend::createTexture(const TextureInit& init) {
+    auto texture = TexturePointer(new HeadlessTextureBackend());
+    texture->_init = init;
+
+    // If init data, allocate a cpu buffer to upload the data
+    if (!init.initData.empty()) {
+        auto layoutAndSize = Texture::evalUploadSubresourceLayout(texture);
+
+        BufferInit bufferInit;
+        bufferInit.bufferSize = layoutAndSize.second;
+        bufferInit.hostVisible = true;
+        texture->_cpuDataBuffer = _createBuffer(bufferInit, "cpu buffer for texture");
+
+        for (const auto& l : layoutAndSize.first) {
+            uint8_t* destmem = (uint8_t*)(texture->_cpuDataBuffer->_cpuMappedAddress) + l.byteOffset;
+            memcpy(destmem, texture->_init.initData[l.subresource].data(), l.byteLength);
+        }
+        _allocatedTextureBytes += layoutAndSize.second;
+
+        if (!(init.usage & (ResourceUsage::RENDER_TARGET | ResourceUsage::RW_RESOURCE_TEXTURE))) {
+            texture->_heapAllocation = _textureHeapPool->allocate(layoutAndSize.second, PLACEMENT_ALIGNMENT);
+            if (texture->_heapAllocation.isValid()) {
+                texture->_heapPool = _textureHeapPool;
+            }
+        }
+    }
+
+    return texture;
+}
+
+GeometryPointer HeadlessBackend::createGeometry(const GeometryInit& init) {
+    auto geometry = new HeadlessGeometryBackend();
+    geometry->_init = init;
+    return GeometryPointer(geometry);
+}
+
+ShaderPointer HeadlessBackend::createShader(const ShaderInit& init) {
+    // Nothing to compile, the shader only keeps its description
+    auto shader = new HeadlessShaderBackend();
+    shader->_shaderDesc = init;
+
+    // The preprocessed source stands for the bytecode, the cache sees the lookups and stores of a gpu backend
+    if (_pipelineCache) {
+        std::string source;
+        if (!init.url.empty()) {
+            std::ifstream file(init.url, std::ifstream::in);
+            source = (std::stringstream() << file.rdbuf()).str();
+        } else if (init.sourceGetter) {
+            source = init.sourceGetter();
+        }
+        auto preprocessed = PipelineCache::preprocessShaderSource(source, init.includes);
+        shader->_cacheKey = PipelineCache::evalShaderKey(init, preprocessed, "headless");
+        PipelineCacheBlob bytecode;
+        if (!_pipelineCache->find(shader->_cacheKey, bytecode)) {
+            _pipelineCache->store(shader->_cacheKey, preprocessed.data(), preprocessed.size());
+        }
+    }
+    return ShaderPointer(shader);
+}
+
+ShaderPointer HeadlessBackend::createProgram(const ProgramInit& init) {
+    auto program = new HeadlessShaderBackend();
+    program->_programDesc = init;
+    program->_shaderDesc.type = (init.type == PipelineType::COMPUTE ? ShaderType::COMPUTE : ShaderType::PROGRAM);
+    return ShaderPointer(program);
+}
+
+SamplerPointer HeadlessBackend::createSampler(const SamplerInit& init) {
+    auto sampler = new HeadlessSamplerBackend();
+    sampler->_state = init;
+    return SamplerPointer(sampler);
+}
+
+PipelineStatePointer HeadlessBackend::createGraphicsPipelineState(const GraphicsPipelineStateInit& init) {
+    auto pipeline = new HeadlessPipelineStateBackend();
+    pipeline->_type = PipelineType::GRAPHICS;
+    pipeline->_graphics = init;
+    pipeline->_program = init.program;
+    pipeline->_rootDescriptorLayout = init.rootDescriptorLayout;
+    if (_pipelineCache) {
+        pipeline->_cacheKey = PipelineCache::evalPipelineKey(init);
+        cachePipeline(pipeline->_cacheKey);
+    }
+    return PipelineStatePointer(pipeline);
+}
+
+PipelineStatePointer HeadlessBackend::createComputePipelineState(const ComputePipelineStateInit& init) {
+    auto pipeline = new HeadlessPipelineStateBackend();
+    pipeline->_type = PipelineType::COMPUTE;
+    pipeline->_compute = init;
+    pipeline->_program = init.program;
+    pipeline->_rootDescriptorLayout = init.rootDescriptorLayout;
+    if (_pipelineCache) {
+        pipeline->_cacheKey = PipelineCache::evalPipelineKey(init);
+        cachePipeline(pipeline->_cacheKey);
+    }
+    return PipelineStatePointer(pipeline);
+}
+
+PipelineStatePointer HeadlessBackend::createRaytracingPipelineState(const RaytracingPipelineStateInit& init) {
+    auto pipeline = new HeadlessPipelineStateBackend();
+    pipeline->_type = PipelineType::RAYTRACING;
+    pipeline->_raytracing = init;
+    pipeline->_program = init.program;
+    pipeline->_rootDescriptorLayout = init.globalRootDescriptorLayout;
+    pipeline->_localRootDescriptorLayout = init.localRootDescriptorLayout;
+    return PipelineStatePointer(pipeline);
+}
+
+void HeadlessBackend::cachePipeline(uint64_t key) {
+    // No native pipeline blob, the key itself is stored in its place
+    PipelineCacheBlob blob;
+    if (key && !_pipelineCache->find(key, blob)) {
+        _pipelineCache->store(key, &key, sizeof(key));
+    }
+}
+
+RootDescriptorLayoutPointer HeadlessBackend::createRootDescriptorLayout(const RootDescriptorLayoutInit& init) {
+    auto layout = new HeadlessRootDescriptorLayoutBackend();
+    layout->_init = init;
+    return RootDescriptorLayoutPointer(layout);
+}
+
+DescriptorHeapPointer HeadlessBackend::createDescriptorHeap(const DescriptorHeapInit& init) {
+    auto heap = new HeadlessDescriptorHeapBackend();
+    heap->_init = init;
+    return DescriptorHeapPointer(heap);
+}
+
+DescriptorHeapPointer HeadlessBackend::getDescriptorHeap() {
+    return _descriptorHeap;
+}
+
+DescriptorSetPointer HeadlessBackend::createDescriptorSet(const DescriptorSetInit& init) {
+    auto descriptorSet = new HeadlessDescriptorSetBackend();
+    descriptorSet->_init = init;
+
+    int32_t numDescriptors = 0;
+    int32_t numSamplers = 0;
+    for (const auto& l : init._descriptorSetLayout) {
+        if (l._type == DescriptorType::SAMPLER) {
+            numSamplers += l._count;
+        } else {
+            numDescriptors += l._count;
+        }
+    }
+    descriptorSet->_numDescriptors = numDescriptors;
+    if (numDescriptors) {
+        descriptorSet->_descriptorOffset = _descriptorHeap->allocateDescriptors(numDescriptors);
+    }
+    if (numSamplers) {
+        descriptorSet->_samplerOffset = _descriptorHeap->allocateSamplers(numSamplers);
+    }
+
+    return DescriptorSetPointer(descriptorSet);
+}
+
+void HeadlessBackend::updateDescriptorSet(DescriptorSetPointer& descriptorSet, DescriptorObjects& objects) {
+    descriptorSet->_objects = objects;
+}
+
+ShaderEntry HeadlessBackend::getShaderEntry(const PipelineStatePointer& pipeline, const std::string& entry) {
+    return {};
+}
+
+ShaderTablePointer HeadlessBackend::createShaderTable(const ShaderTableInit& init) {
+    return nullptr;
+}
+
+void HeadlessBackend::executeBatch(const BatchPointer& batch) {
+    auto hb = static_cast<HeadlessBatchBackend*>(batch.get());
+    _frameStats += hb->stats();
+    if (_recordFrameCommands) {
+        _frameCommands.insert(_frameCommands.end(), hb->commands().begin(), hb->commands().end());
+    }
+}
+
+void HeadlessBackend::presentSwapchain(const SwapchainPointer& swapchain) {
+    auto sw = static_cast<HeadlessSwapchainBackend*>(swapchain.get());
+    sw->_currentIndex = (sw->_currentIndex + 1) % CHAIN_NUM_FRAMES;
+    if (sw->_framebuffer) {
+        sw->_framebuffer->advanceIndex();
+    }
+    endFrame();
+}
+
+void HeadlessBackend::flush() {
+    // Nothing in flight
+}
+
+void HeadlessBackend::endFrame() {
+    _lastFrameStats = _frameStats;
+    _frameStats = HeadlessFrameStats();
+    _lastFrameCommands.swap(_frameCommands);
+    _frameCommands.clear();
+    _numFrames++;
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runHeadlessBackendTests() to validate the recording of
+// the batches and the frame stats, and runHeadlessBackendBenchmarks() to profile
+// the cpu cost of the animation, scene sync and drawcall submission of a model scene
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+#include <core/Log.h>
+#include <core/Job.h>
+
+#include "render/Scene.h"
+#include "render/Camera.h"
+#include "render/Viewport.h"
+#include "drawables/ModelDraw.h"
+#include "HeadlessTestScene.h"
+
+namespace {
+    using namespace graphics;
+
+    HeadlessBackend* headlessOf(const DevicePointer& device) {
+        return static_cast<HeadlessBackend*>(device->nativeDevice());
+    }
+
+    // The same commands in the same order, the objects of 2 scenes matched by their first use
+    bool sameCommands(const HeadlessCommands& a, const HeadlessCommands& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        std::unordered_map<const void*, const void*> aToB, bToA;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const auto& ca = a[i];
+            const auto& cb = b[i];
+            if (ca.type != cb.type || ca.pipelineType != cb.pipelineType || ca.slot != cb.slot
+                || !std::equal(std::begin(ca.args), std::end(ca.args), std::begin(cb.args))) {
+                return false;
+            }
+            auto [ab, newA] = aToB.emplace(ca.object, cb.object);
+            auto [ba, newB] = bToA.emplace(cb.object, ca.object);
+            if (ab->second != cb.object || ba->second != ca.object) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The view pass descriptor set bound by the frame, in the set slot 0
+    const DescriptorSet* viewPassSetOf(const HeadlessCommands& commands) {
+        for (const auto& c : commands) {
+            if (c.type == HeadlessCommandType::BIND_DESCRIPTOR_SET && c.slot == 0) {
+                return static_cast<const DescriptorSet*>(c.object);
+            }
+        }
+        return nullptr;
+    }
+
+    // The textures are uploaded out of the passes, before the drawcalls recorded in the ranges
+    bool uploadsOutOfPasses(const HeadlessCommands& commands) {
+        bool inPass = false;
+        for (const auto& c : commands) {
+            inPass = (c.type == HeadlessCommandType::BEGIN_PASS ? true : (c.type == HeadlessCommandType::END_PASS ? false : inPass));
+            if (inPass && c.type == HeadlessCommandType::UPLOAD_TEXTURE) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void runHeadlessBackendTests() {
+    using namespace graphics;
+    picoLog("HeadlessBackendTest: starting...");
+
+    // --- Test 1: every batch call is logged and counted ---
+    {
+        auto device = Device::createDevice({ "Headless" });
+        assert(device);
+        auto headless = headlessOf(device);
+
+        BufferInit bufferInit;
+        bufferInit.usage = ResourceUsage::RESOURCE_BUFFER;
+        bufferInit.bufferSize = 256;
+        auto buffer = device->createBuffer(bufferInit);
+        assert(buffer->needUpload() && buffer->_cpuMappedAddress);
+        memset(buffer->_cpuMappedAddress, 0xAB, 256);
+
+        auto layout = device->createRootDescriptorLayout({});
+        GraphicsPipelineStateInit pipelineInit;
+        pipelineInit.rootDescriptorLayout = layout;
+        auto pipeline = device->createGraphicsPipelineState(pipelineInit);
+        DescriptorSetInit setInit{ layout, 0, false, { { DescriptorType::RESOURCE_BUFFER, ShaderStage::VERTEX, 0, 1 } } };
+        auto descriptorSet = device->createDescriptorSet(setInit);
+        assert(descriptorSet->_descriptorOffset == 0 && descriptorSet->_numDescriptors == 1);
+
+        auto batch = device->createBatch({});
+        uint32_t pushed = 42;
+        batch->begin(0);
+        batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::SHADER_RESOURCE, ResourceState::COPY_DEST, buffer);
+        batch->uploadBuffer(buffer);
+        batch->resourceBarrierTransition(ResourceBarrierFlag::NONE, ResourceState::COPY_DEST, ResourceState::SHADER_RESOURCE, buffer);
+        for (uint32_t d = 0; d < 3; ++d) {
+            batch->bindPipeline(pipeline);
+            batch->bindDescriptorSet(PipelineType::GRAPHICS, descriptorSet);
+            batch->bindPushUniform(PipelineType::GRAPHICS, 0, pushed + d);
+            batch->draw(300 + d, 0);
+        }
+        batch->end();
+        assert(!buffer->needUpload());
+
+        auto hb = static_cast<HeadlessBatchBackend*>(batch.get());
+        const auto& s = hb->stats();
+        assert(s.numBatches == 1 && s.numCommands == hb->commands().size() && s.numCommands == 2 + 3 + 4 * 3);
+        assert(s.numDraws == 3 && s.numPrimitives == 903 && s.numBarriers == 2);
+        assert(s.numUploads == 1 && s.bytesUploaded == 256);
+        assert(s.numPipelineBinds == 3 && s.numRedundantPipelineBinds == 2);
+        assert(s.numDescriptorSetBinds == 3 && s.numRedundantDescriptorSetBinds == 2);
+        assert(s.numPushUniforms == 3 && s.bytesPushed == 3 * sizeof(uint32_t));
+
+        const auto& log = hb->commands();
+        assert(log.front().type == HeadlessCommandType::BEGIN && log.back().type == HeadlessCommandType::END);
+        assert(log[2].type == HeadlessCommandType::UPLOAD_BUFFER && log[2].object == buffer.get());
+        const auto& draw = log[log.size() - 2];
+        assert(draw.type == HeadlessCommandType::DRAW && draw.args[0] == 302 && draw.object == pipeline.get());
+        const auto& push = log[log.size() - 3];
+        assert(push.type == HeadlessCommandType::BIND_PUSH_UNIFORM && push.args[1] == sizeof(uint32_t));
+        assert(*(const uint32_t*)(hb->pushData().data() + push.args[0]) == pushed + 2);
+
+        // The device accumulates the executed batches until the frame ends
+        device->executeBatch(batch);
+        device->executeBatch(batch);
+        assert(headless->frameStats().numDraws == 6 && headless->frameStats().numBatches == 2);
+        headless->endFrame();
+        assert(headless->frameStats().numDraws == 0 && headless->lastFrameStats().numDraws == 6 && headless->numFrames() == 1);
+        picoLog("HeadlessBackendTest 1 passed: batch calls logged, redundant binds and uploads counted");
+    }
+
+    // --- Test 2: texture init data goes through the cpu buffer into the texture subresources ---
+    {
+        auto device = Device::createDevice({ "Headless" });
+        TextureInit textureInit;
+        textureInit.width = 4;
+        textureInit.height = 4;
+        textureInit.numSlices = 2;
+        textureInit.initData = { std::vector<uint8_t>(64, 1), std::vector<uint8_t>(64, 2) };
+        auto texture = device->createTexture(textureInit);
+        assert(texture->needUpload() && texture->_cpuDataBuffer);
+
+        auto batch = device->createBatch({});
+        batch->begin(0);
+        batch->uploadTexture(texture);
+        batch->end();
+        assert(!texture->needUpload());
+
+        auto tex = static_cast<HeadlessTextureBackend*>(texture.get());
+        assert(tex->_subresources.size() == 2 && tex->_subresources[0] == textureInit.initData[0] && tex->_subresources[1] == textureInit.initData[1]);
+        assert(static_cast<HeadlessBatchBackend*>(batch.get())->stats().bytesUploaded == 128);
+        picoLog("HeadlessBackendTest 2 passed: texture init data uploaded");
+    }
+
+    // --- Test 3: a model scene renders through the viewport, one draw per part instance ---
+    {
+        const uint32_t numInstances = 4;
+        HeadlessTestScene t({ { "../asset/gltf/Duck/Duck.gltf" }, numInstances });
+        assert(t.model());
+        auto headless = headlessOf(t.device);
+        t.viewport->setSceneInstancing(false);
+        // the test scene holds the camera the viewport renders from
+        assert(t.scene->getCamera(t.camera->id()) == t.camera);
+
+        t.renderFrame();
+        auto first = headless->lastFrameStats();
+        uint32_t numPartDraws = numInstances * (uint32_t) t.model()->_parts.size();
+        assert(first.numBatches == 1 && first.numPasses == 1 && first.numClears == 1);
+        assert(first.numDraws == numPartDraws && first.numPushUniforms == numPartDraws);
+        assert(first.numPrimitives == numInstances * t.model()->_indices.size());
+        assert(first.numUploads >= 1 && first.bytesUploaded > 0); // the albedo texture and the scene stores on the first frame
+
+        t.renderFrame();
+        auto second = headless->lastFrameStats();
+        assert(second.numDraws == first.numDraws && second.bytesUploaded < first.bytesUploaded);
+        assert(t.swapchain->currentIndex() == 2 && headless->numFrames() == 2);
+        // the scene stores are staged in the upload ring
+        assert(first.bytesCopied > 0 && t.viewport->getUploadRing()->stats().numFailed == 0);
+        // the device local buffers of the model and the scene are placed in one heap
+        auto heaps = t.device->getBufferHeapPool()->stats();
+        assert(heaps.numHeaps == 1 && heaps.heaps.numAllocations > 0);
+        picoLog("HeadlessBackendTest 3 passed: scene rendered headless, " + second.toString());
+    }
+
+    // --- Test 4: the scene items recorded in parallel ranges give the same frame as a single range, uploads included ---
+    {
+        const uint32_t numInstances = 64;
+        HeadlessTestScene single({ { "../asset/gltf/Duck/Duck.gltf" }, numInstances });
+        HeadlessTestScene ranged({ { "../asset/gltf/Duck/Duck.gltf" }, numInstances });
+        assert(single.model() && ranged.model());
+        auto singleHeadless = headlessOf(single.device);
+        auto rangedHeadless = headlessOf(ranged.device);
+        for (auto* t : { &single, &ranged }) {
+            t->viewport->setSceneInstancing(false); // the ranges would split the instanced draws
+            headlessOf(t->device)->setFrameCommandsRecording(true);
+        }
+        single.viewport->setSceneRecordingGrain(0xFFFFFFFF);
+        ranged.viewport->setSceneRecordingGrain(3);
+
+        // the first frame uploads the textures, the second one only draws
+        for (uint32_t frame = 0; frame < 2; ++frame) {
+            single.renderFrame();
+            ranged.renderFrame();
+            assert(single.viewport->lastNumSceneRanges() == 1 && ranged.viewport->lastNumSceneRanges() > 16);
+            assert(sameCommands(singleHeadless->lastFrameCommands(), rangedHeadless->lastFrameCommands()));
+            assert(uploadsOutOfPasses(rangedHeadless->lastFrameCommands()));
+            assert(singleHeadless->lastFrameStats().toString() == rangedHeadless->lastFrameStats().toString());
+        }
+        auto stats = singleHeadless->lastFrameStats();
+        assert(stats.numPipelineBinds == 1 && stats.numDescriptorSetBinds == 2 && stats.numDraws == numInstances);
+        // every range binds the state of its first parts, the replay filters them out
+        auto singleStream = single.viewport->lastSceneStreamStats();
+        auto rangedStream = ranged.viewport->lastSceneStreamStats();
+        assert(singleStream.numCommands <= rangedStream.numCommands && singleStream.numReplayed == rangedStream.numReplayed);
+        picoLog("HeadlessBackendTest 4 passed: " + std::to_string(ranged.viewport->lastNumSceneRanges()) + " ranges recorded, same commands as 1 range");
+    }
+
+    // --- Test 5: a streamed model shows up once its geometry is resident, with a placeholder until its texture is ---
+    {
+        const uint32_t numInstances = 4;
+        const uint64_t budget = 32 * 1024;
+        HeadlessTestScene t({ { "../asset/gltf/Duck/Duck.gltf" }, numInstances, budget });
+        assert(t.model());
+        auto headless = headlessOf(t.device);
+        auto queue = t.viewport->getStreamingQueue();
+        t.viewport->setSceneInstancing(false);
+        assert(!t.model()->isGeometryResident() && !t.model()->isTextureResident() && !t.model()->getAlbedoTexture()->needUpload());
+
+        uint32_t numPartDraws = numInstances * (uint32_t) t.model()->_parts.size();
+        uint32_t numFrames = 0;
+        uint32_t firstDrawnFrame = 0;
+        while (!queue->empty() && numFrames < 1000) {
+            t.renderFrame();
+            numFrames++;
+            auto frame = headless->lastFrameStats();
+            auto s = queue->stats();
+            // the budget holds but for a texture slice alone in its frame
+            assert(s.frameBytes <= budget || s.numFrameUploads == 1);
+            if (t.model()->isGeometryResident()) {
+                firstDrawnFrame = (firstDrawnFrame ? firstDrawnFrame : numFrames);
+                assert(frame.numDraws == numPartDraws);
+            } else {
+                assert(frame.numDraws == 0);
+            }
+        }
+        assert(queue->empty() && t.model()->isGeometryResident() && t.model()->isTextureResident());
+        assert(firstDrawnFrame > 1 && firstDrawnFrame < numFrames); // the geometry first, then the texture
+
+        t.renderFrame();
+        auto last = headless->lastFrameStats();
+        assert(last.numDraws == numPartDraws && queue->stats().frameBytes == 0);
+        picoLog("HeadlessBackendTest 5 passed: model streamed in " + std::to_string(numFrames) + " frames, drawn from frame "
+            + std::to_string(firstDrawnFrame) + ", " + queue->stats().toString());
+    }
+
+    // --- Test 6: the bounds of the skinned parts follow the pose of each instance ---
+    {
+        HeadlessTestScene t({ { "../asset/gltf/Fox/Fox.gltf" }, 2 });
+        if (!t.model()) {
+            picoLog("HeadlessBackendTest 6 skipped: Fox.gltf not found");
+        } else {
+            assert(!t.model()->_partSkins.empty() && t.model()->_skinnedInstances.size() == t.numInstances);
+            t.viewport->animate(0.7f);
+            t.renderFrame();
+
+            uint32_t numOutOfBindPose = 0;
+            core::vec3_stream positions;
+            for (const auto& instance : t.model()->_skinnedInstances) {
+                for (uint32_t k = 0; k < t.model()->_partSkins.size(); ++k) {
+                    const auto& ps = t.model()->_partSkins[k];
+                    auto item = instance.partSkinItems[k];
+                    assert(item != INVALID_ITEM_ID);
+                    auto bound = t.scene->_items.fetchWorldBound(item);
+                    auto meshWorld = t.scene->_nodes.getNodeTransform(instance.modelNode + 1 + ps.node).world;
+                    auto bindBound = core::aabox_transformFrom(meshWorld, t.model()->_partAABBs[ps.part]);
+
+                    // the skinned vertices are in the bound of the item, not all in the bind pose bound
+                    t.model()->skinPart(k, t.scene->_nodes, instance.modelNode, positions);
+                    const float e = 1e-3f * core::length(bound.half_size);
+                    for (uint32_t i = 0; i < positions.size(); ++i) {
+                        auto p = core::transformFrom(meshWorld, positions.get(i));
+                        auto d = core::abs(p - bound.center) - bound.half_size;
+                        assert(d.x <= e && d.y <= e && d.z <= e);
+                        auto b = core::abs(p - bindBound.center) - bindBound.half_size;
+                        numOutOfBindPose += (b.x > e || b.y > e || b.z > e);
+                    }
+                }
+            }
+            assert(numOutOfBindPose > 0);
+            picoLog("HeadlessBackendTest 6 passed: skinned part bounds contain the posed vertices, "
+                + std::to_string(numOutOfBindPose) + " out of the bind pose bounds");
+        }
+    }
+
+    // --- Test 7: growing the instance buffer leaves the view pass of the other frames in flight untouched ---
+    {
+        HeadlessTestScene t({ { "../asset/gltf/Duck/Duck.gltf" }, 1000 });
+        assert(t.model());
+        auto headless = headlessOf(t.device);
+        headless->setFrameCommandsRecording(true);
+
+        t.renderFrame();
+        auto firstSet = viewPassSetOf(headless->lastFrameCommands());
+        assert(firstSet && firstSet->_objects.size() == Viewport::viewPassLayout.size());
+        auto firstInstances = firstSet->_objects.back()._buffer;
+
+        // more queue entries than the default instance capacity
+        auto root = t.scene->createNode({}).id();
+        for (uint32_t i = 0; i < 4000; ++i) {
+            t.factory->createModelParts(root, t.scene, *t.model());
+        }
+        t.renderFrame();
+        auto grownSet = viewPassSetOf(headless->lastFrameCommands());
+        assert(grownSet && grownSet != firstSet);
+        assert(grownSet->_objects.back()._buffer->numElements() >= 5000);
+        assert(firstSet->_objects.back()._buffer == firstInstances);
+
+        // back to the first slot, its frame is done, its view pass grows then
+        t.renderFrame();
+        t.renderFrame();
+        assert(viewPassSetOf(headless->lastFrameCommands()) == firstSet);
+        assert(firstSet->_objects.back()._buffer != firstInstances && firstSet->_objects.back()._buffer->numElements() >= 5000);
+        picoLog("HeadlessBackendTest 7 passed: instance buffer grown in its own swapchain slot");
+    }
+
+    picoLog("HeadlessBackendTest: all tests passed");
+}
+
+void runHeadlessBackendBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    const char* files[] = {
+        "../asset/gltf/Duck/Duck.gltf",
+        "../asset/gltf/Fox/Fox.gltf",
+        "../asset/gltf/DamagedHelmet/DamagedHelmet.gltf",
+    };
+    const uint32_t numInstances = 1000;
+    const uint32_t numFrames = 20;
+
+    for (const char* f : files) {
+        HeadlessTestScene t({ { f }, numInstances });
+        if (!t.model()) {
+            picoLogf("HeadlessBackendBench {}: failed to load", f);
+            continue;
+        }
+        auto headless = headlessOf(t.device);
+
+        // Let the first frame upload everything
+        t.renderFrame();
+
+        auto start = clock::now();
+        for (uint32_t i = 0; i < numFrames; ++i) {
+            t.viewport->animate(float(i) / 60.0f);
+            t.renderFrame();
+        }
+        double frameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numFrames;
+
+        const auto& s = headless->lastFrameStats();
+        picoLogf("HeadlessBackendBench {} x{}: {:.3f} ms/frame | {} | upload ring {}", f, numInstances, frameMs, s.toString(),
+            t.viewport->getUploadRing()->stats().toString());
+        picoLogf("HeadlessBackendBench {} x{}: buffers {} | textures {}", f, numInstances,
+            t.device->getBufferHeapPool()->stats().toString(), t.device->getTextureHeapPool()->stats().toString());
+    }
+
+    // Time to first frame and upload spikes of a model uploaded at once or streamed
+    for (uint64_t budget : { 0ull, 1024 * 1024ull, 256 * 1024ull }) {
+        auto start = clock::now();
+        HeadlessTestScene t({ { files[2] }, 1, budget });
+        if (!t.model()) {
+            break;
+        }
+        double loadMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        auto headless = headlessOf(t.device);
+        auto queue = t.viewport->getStreamingQueue();
+
+        double firstFrameMs = 0.0;
+        double maxFrameMs = 0.0;
+        uint64_t maxFrameBytes = 0;
+        uint32_t numFrames = 0;
+        do {
+            auto frameStart = clock::now();
+            t.renderFrame();
+            double frameMs = std::chrono::duration<double, std::milli>(clock::now() - frameStart).count();
+            firstFrameMs = (numFrames ? firstFrameMs : frameMs);
+            maxFrameMs = std::max(maxFrameMs, frameMs);
+            const auto& s = headless->lastFrameStats();
+            maxFrameBytes = std::max(maxFrameBytes, s.bytesUploaded + s.bytesCopied);
+            numFrames++;
+        } while (!queue->empty() && numFrames < 10000);
+
+        picoLogf("HeadlessBackendBench {} {}: load {:.1f} ms | first frame {:.3f} ms | resident after {} frames, max {:.3f} ms, {:.1f} KB/frame",
+            files[2], (budget ? "streamed " + std::to_string(budget / 1024) + " KB/frame" : std::string("uploaded at once")),
+            loadMs, firstFrameMs, numFrames, maxFrameMs, maxFrameBytes / 1024.0);
+    }
+
+    // Scene recording, one range against the ranges recorded on the shared pool
+    {
+        const uint32_t numDucks = 20000;
+        HeadlessTestScene t({ { files[0] }, numDucks });
+        if (!t.model()) {
+            return;
+        }
+        t.renderFrame();
+
+        uint32_t grains[] = { 0xFFFFFFFF, Viewport::DEFAULT_SCENE_RECORDING_GRAIN, 256 };
+        double singleMs = 0.0;
+        for (auto grain : grains) {
+            t.viewport->setSceneRecordingGrain(grain);
+            auto start = clock::now();
+            for (uint32_t i = 0; i < numFrames; ++i) {
+                t.renderFrame();
+            }
+            double frameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numFrames;
+            if (grain == grains[0]) singleMs = frameMs;
+            picoLogf("HeadlessBackendBench scene recording {} items, {} threads, {} ranges: {:.3f} ms/frame x{:.2f} | {}",
+                2 * numDucks, core::ThreadPool::shared().threadCount() + 1, t.viewport->lastNumSceneRanges(), frameMs, singleMs / frameMs,
+                t.viewport->lastSceneStreamStats().toString());
+        }
+    }
+}
@@ -0,0 +1,422 @@
+// HeadlessBackend.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "gpu/Device.h"
+#include "gpu/Swapchain.h"
+#include "gpu/Framebuffer.h"
+#include "gpu/Batch.h"
+#include "gpu/Resource.h"
+#include "gpu/Pipeline.h"
+#include "gpu/Shader.h"
+#include "gpu/Descriptor.h"
+#include "gpu/Query.h"
+
+#include <vector>
+#include <string>
+
+// Headless backend: no gpu, every resource lives in cpu memory and every Batch call is recorded
+// in a compact command log. Used to run and profile the render submission path where no gpu api
+// is available (linux, ci) and to count what a frame submits.
+namespace graphics {
+
+    enum class HeadlessCommandType : uint8_t {
+        BEGIN = 0,
+        END,
+        BEGIN_PASS,
+        END_PASS,
+        COPY_TEXTURE,
+        CLEAR,
+        BARRIER_TRANSITION,
+        BARRIER_RW,
+        VIEWPORT,
+        SCISSOR,
+        BIND_FRAMEBUFFER,
+        BIND_ROOT_DESCRIPTOR_LAYOUT,
+        BIND_PIPELINE,
+        BIND_DESCRIPTOR_SET,
+        BIND_PUSH_UNIFORM,
+        BIND_INDEX_BUFFER,
+        BIND_VERTEX_BUFFERS,
+        DRAW,
+        DRAW_INDEXED,
+        DRAW_INSTANCED,
+        UPLOAD_TEXTURE,
+        UPLOAD_BUFFER,
+        UPLOAD_BUFFER_REGION,
+        COPY_BUFFER_REGION,
+        DISPATCH,
+        DISPATCH_RAYS,
+
+        COUNT,
+    };
+    VISUALIZATION_API const char* toString(HeadlessCommandType type);
+
+    // One recorded Batch call, 32 bytes.
+    // The meaning of the args depends on the type:
+    //   DRAW, DRAW_INDEXED:        numPrimitives, startIndex
+    //   DRAW_INSTANCED:            numPrimitives, startIndex, numInstances
+    //   DISPATCH:                  numThreadsX, Y, Z
+    //   BARRIER_TRANSITION:        stateBefore, stateAfter, subresource
+    //   BIND_PUSH_UNIFORM:         offset in the push data, size
+    //   UPLOAD_TEXTURE, UPLOAD_BUFFER: num bytes
+    //   UPLOAD_BUFFER_REGION:      offset, size
+    //   COPY_BUFFER_REGION:        destOffset, srcOffset, size
+    //   VIEWPORT, SCISSOR:         the rect as float bits
+    //   BIND_VERTEX_BUFFERS:       num buffers
+    // object is the resource / pipeline / descriptor set involved, if any
+    struct HeadlessCommand {
+        HeadlessCommandType type{ HeadlessCommandType::COUNT };
+        PipelineType pipelineType{ PipelineType::GRAPHICS };
+        uint16_t slot{ 0 };
+        uint32_t args[4]{ 0, 0, 0, 0 };
+        const void* object{ nullptr };
+    };
+    using HeadlessCommands = std::vector<HeadlessCommand>;
+
+    // What a batch, or a whole frame, submitted
+    struct VISUALIZATION_API HeadlessFrameStats {
+        uint32_t numBatches{ 0 };
+        uint32_t numCommands{ 0 };
+        uint32_t numPasses{ 0 };
+        uint32_t numClears{ 0 };
+        uint32_t numDraws{ 0 };       // draw + drawIndexed + drawInstanced
+        uint64_t numPrimitives{ 0 };  // sum of the numPrimitives of the draws, times the instances
+        uint32_t numInstancedDraws{ 0 };
+        uint64_t numInstances{ 0 };   // sum of the numInstances of the instanced draws
+        uint32_t numDispatches{ 0 };  // dispatch + dispatchRays
+        uint32_t numBarriers{ 0 };
+        uint32_t numPipelineBinds{ 0 };
+        uint32_t numRedundantPipelineBinds{ 0 };      // binding the pipeline already bound
+        uint32_t numRootDescriptorLayoutBinds{ 0 };
+        uint32_t numDescriptorSetBinds{ 0 };
+        uint32_t numRedundantDescriptorSetBinds{ 0 }; // binding the descriptor set already bound at that slot
+        uint32_t numPushUniforms{ 0 };
+        uint32_t numVertexBufferBinds{ 0 };
+        uint32_t numIndexBufferBinds{ 0 };
+        uint32_t numUploads{ 0 };     // uploadBuffer + uploadBufferRegion + uploadTexture
+        uint64_t bytesUploaded{ 0 };
+        uint64_t bytesCopied{ 0 };    // copyBufferRegion
+        uint64_t bytesPushed{ 0 };    // push uniforms
+
+        HeadlessFrameStats& operator+= (const HeadlessFrameStats& s);
+        std::string toString() const;
+    };
+
+    class HeadlessBackend;
+
+    class HeadlessSwapchainBackend : public Swapchain {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessSwapchainBackend();
+        virtual ~HeadlessSwapchainBackend();
+    };
+
+    class HeadlessFramebufferBackend : public Framebuffer {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessFramebufferBackend();
+        virtual ~HeadlessFramebufferBackend();
+    };
+
+    class HeadlessBufferBackend : public Buffer {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessBufferBackend();
+        virtual ~HeadlessBufferBackend();
+
+        // The buffer memory, _cpuMappedAddress points in there whatever the usage
+        std::vector<uint8_t> _data;
+    };
+
+    class HeadlessTextureBackend : public Texture {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessTextureBackend();
+        virtual ~HeadlessTextureBackend();
+
+        // The bytes of the subresources as last uploaded, render targets are not backed
+        std::vector<std::vector<uint8_t>> _subresources;
+    };
+
+    class HeadlessGeometryBackend : public Geometry {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessGeometryBackend();
+        virtual ~HeadlessGeometryBackend();
+    };
+
+    class HeadlessShaderBackend : public Shader {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessShaderBackend();
+        virtual ~HeadlessShaderBackend();
+    };
+
+    class HeadlessSamplerBackend : public Sampler {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessSamplerBackend();
+        virtual ~HeadlessSamplerBackend();
+    };
+
+    class HeadlessPipelineStateBackend : public PipelineState {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessPipelineStateBackend();
+        virtual ~HeadlessPipelineStateBackend();
+    };
+
+    class HeadlessRootDescriptorLayoutBackend : public RootDescriptorLayout {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessRootDescriptorLayoutBackend();
+        virtual ~HeadlessRootDescriptorLayoutBackend();
+    };
+
+    // Hands out consecutive offsets, nothing to store behind them
+    class HeadlessDescriptorHeapBackend : public DescriptorHeap {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessDescriptorHeapBackend();
+        virtual ~HeadlessDescriptorHeapBackend();
+
+        int32_t allocateDescriptors(int32_t numDescriptors) override;
+        int32_t allocateSamplers(int32_t numSamplers) override;
+
+        int32_t _descriptorCount{ 0 };
+        int32_t _samplerCount{ 0 };
+    };
+
+    class HeadlessDescriptorSetBackend : public DescriptorSet {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessDescriptorSetBackend();
+        virtual ~HeadlessDescriptorSetBackend();
+    };
+
+    class HeadlessBatchTimerBackend : public BatchTimer {
+    public:
+        friend class HeadlessBackend;
+
+        HeadlessBatchTimerBackend();
+        virtual ~HeadlessBatchTimerBackend();
+    };
+
+    class HeadlessBatchBackend : public Batch {
+    public:
+        friend class HeadlessBackend;
+
+        static const uint32_t MAX_BOUND_DESCRIPTOR_SETS = 8;
+
+        HeadlessBatchBackend();
+        virtual ~HeadlessBatchBackend();
+
+        void begin(uint8_t currentIndex, const BatchTimerPointer& timer = nullptr) override;
+        void end() override;
+
+        void beginPass(const SwapchainPointer& swapchain, uint8_t currentIndex) override;
+        void beginPass(const FramebufferPointer& framebuffer) override;
+        void endPass() override;
+
+        void copyTexture(const TexturePointer& src, const SwapchainPointer& dst, uint8_t dstIndex) override;
+
+        void clear(const SwapchainPointer& swapchain, uint8_t index, const core::vec4& color, float depth = 0.0f) override;
+        void clear(const FramebufferPointer& framebuffer, const core::vec4& color, float depth = 0.0f) override;
+
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const SwapchainPointer& swapchain, uint8_t currentIndex, uint32_t subresource) override;
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const BufferPointer& buffer) override;
+        void resourceBarrierTransition(
+            ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+            const TexturePointer& texture, uint32_t subresource) override;
+
+        void resourceBarrierRW(ResourceBarrierFlag flag, const BufferPointer& buffer) override;
+        void resourceBarrierRW(ResourceBarrierFlag flag, const TexturePointer& texture, uint32_t subresource) override;
+
+        void bindFramebuffer(const FramebufferPointer& framebuffer) override;
+
+        void bindRootDescriptorLayout(PipelineType type, const RootDescriptorLayoutPointer& rootDescriptorLayout) override;
+        void bindPipeline(const PipelineStatePointer& pipeline) override;
+
+        void bindDescriptorSet(PipelineType type, const DescriptorSetPointer& descriptorSet) override;
+        void bindPushUniform(PipelineType type, uint32_t slot, uint32_t size, const uint8_t* data) override;
+
+        void bindIndexBuffer(const BufferPointer& buffer) override;
+        void bindVertexBuffers(uint32_t num, const BufferPointer* buffers) override;
+
+        void draw(uint32_t numPrimitives, uint32_t startIndex) override;
+        void drawIndexed(uint32_t numPrimitives, uint32_t startIndex) override;
+        void drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) override;
+
+        void uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) override;
+        void uploadBuffer(const BufferPointer& dest) override;
+        void uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) override;
+        void copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) override;
+
+        void dispatch(uint32_t numThreadsX, uint32_t numThreadsY = 1, uint32_t numThreadsZ = 1) override;
+        void dispatchRays(const DispatchRaysArgs& args) override;
+
+        // The log recorded since the last begin
+        const HeadlessCommands& commands() const { return _commands; }
+        const std::vector<uint8_t>& pushData() const { return _pushData; }
+        const HeadlessFrameStats& stats() const { return _stats; }
+
+    protected:
+        void _setViewport(const core::vec4& viewport) override;
+        void _setScissor(const core::vec4& scissor) override;
+
+        inline HeadlessCommand& record(HeadlessCommandType type, const void* object = nullptr) {
+            auto& c = _commands.emplace_back();
+            c.type = type;
+            c.object = object;
+            return c;
+        }
+        void recordRect(HeadlessCommandType type, const core::vec4& rect);
+        void setRootDescriptorLayout(PipelineType type, const RootDescriptorLayout* rootDescriptorLayout);
+
+        HeadlessCommands _commands;
+        std::vector<uint8_t> _pushData;
+        HeadlessFrameStats _stats;
+
+        // Currently bound state, to spot the redundant binds
+        const PipelineState* _boundPipeline{ nullptr };
+        const RootDescriptorLayout* _boundRootDescriptorLayouts[(uint32_t)PipelineType::COUNT]{};
+        const DescriptorSet* _boundDescriptorSets[(uint32_t)PipelineType::COUNT][MAX_BOUND_DESCRIPTOR_SETS]{};
+    };
+
+    class VISUALIZATION_API HeadlessBackend : public DeviceBackend {
+    public:
+        static const uint32_t CHAIN_NUM_FRAMES = 3;
+        static const uint64_t PLACEMENT_ALIGNMENT = 64 * 1024; // same as the d3d12 placed resources
+
+        HeadlessBackend();
+        virtual ~HeadlessBackend();
+
+        SwapchainPointer createSwapchain(const SwapchainInit& init) override;
+        void resizeSwapchain(const SwapchainPointer& swapchain, uint32_t width, uint32_t height) override;
+
+        FramebufferPointer createFramebuffer(const FramebufferInit& init) override;
+        FramebufferPointer createFramebuffer(const FramebufferInit_Swapable& init) override;
+        void resizeFramebuffer(const FramebufferPointer& framebuffer, uint32_t width, uint32_t height) override;
+        void resizeTexture(const TexturePointer& texture, uint32_t width, uint32_t height) override;
+
+        BatchPointer createBatch(const BatchInit& init) override;
+        BatchTimerPointer createBatchTimer(const BatchTimerInit& init) override;
+
+        BufferPointer _createBuffer(const BufferInit& init, const std::string& name) override;
+        TexturePointer createTexture(const TextureInit& init) override;
+
+        GeometryPointer createGeometry(const GeometryInit& init) override;
+
+        ShaderPointer createShader(const ShaderInit& init) override;
+        ShaderPointer createProgram(const ProgramInit& init) override;
+
+        SamplerPointer createSampler(const SamplerInit& init) override;
+
+        PipelineStatePointer createGraphicsPipelineState(const GraphicsPipelineStateInit& init) override;
+        PipelineStatePointer createComputePipelineState(const ComputePipelineStateInit& init) override;
+        PipelineStatePointer createRaytracingPipelineState(const RaytracingPipelineStateInit& init) override;
+
+        RootDescriptorLayoutPointer createRootDescriptorLayout(const RootDescriptorLayoutInit& init) override;
+
+        DescriptorHeapPointer createDescriptorHeap(const DescriptorHeapInit& init) override;
+        DescriptorHeapPointer getDescriptorHeap() override;
+
+        // The resources are placed in the pools the same way as the d3d12 backend does, for the accounting only:
+        // the memory is still the cpu data of every resource
+        ResourceHeapPoolPointer getBufferHeapPool() override { return _bufferHeapPool; }
+        ResourceHeapPoolPointer getTextureHeapPool() override { return _textureHeapPool; }
+
+        DescriptorSetPointer createDescriptorSet(const DescriptorSetInit& init) override;
+
+        ShaderEntry getShaderEntry(const PipelineStatePointer& pipeline, const std::string& entry) override;
+        ShaderTablePointer createShaderTable(const ShaderTableInit& init) override;
+
+        void updateDescriptorSet(DescriptorSetPointer& descriptorSet, DescriptorObjects& objects) override;
+
+        void executeBatch(const BatchPointer& batch) override;
+        void presentSwapchain(const SwapchainPointer& swapchain) override;
+
+        void flush() override;
+
+        // The native device is the backend itself, the way to reach the stats from a Device
+        void* nativeDevice() override { return this; }
+
+        // Close the current frame, done by presentSwapchain.
+        // Call it explicitly when rendering offscreen.
+        void endFrame();
+
+        // Stats of the batches executed since the last endFrame
+        const HeadlessFrameStats& frameStats() const { return _frameStats; }
+        // Stats of the last complete frame
+        const HeadlessFrameStats& lastFrameStats() const { return _lastFrameStats; }
+        uint64_t numFrames() const { return _numFrames; }
+
+        // Keep a copy of the commands of the executed batches, to compare whole frames. Off by default.
+        void setFrameCommandsRecording(bool enabled) { _recordFrameCommands = enabled; }
+        // Commands of the batches executed in the last complete frame, in execution order
+        const HeadlessCommands& lastFrameCommands() const { return _lastFrameCommands; }
+
+        // Cpu memory held by the resources allocated so far
+        uint64_t allocatedBufferBytes() const { return _allocatedBufferBytes; }
+        uint64_t allocatedTextureBytes() const { return _allocatedTextureBytes; }
+
+    protected:
+        // Look up the pipeline key in the cache, store it on a miss
+        void cachePipeline(uint64_t key);
+
+        DescriptorHeapPointer _descriptorHeap;
+        ResourceHeapPoolPointer _bufferHeapPool;
+        ResourceHeapPoolPointer _textureHeapPool;
+
+        HeadlessFrameStats _frameStats;
+        HeadlessFrameStats _lastFrameStats;
+        uint64_t _numFrames{ 0 };
+
+        bool _recordFrameCommands{ false };
+        HeadlessCommands _frameCommands;
+        HeadlessCommands _lastFrameCommands;
+
+        uint64_t _allocatedBufferBytes{ 0 };
+        uint64_t _allocatedTextureBytes{ 0 };
+    };
+}
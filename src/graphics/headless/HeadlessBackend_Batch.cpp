@@ -0,0 +1,377 @@
+// HeadlessBackend_Batch.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HeadlessBackend.h"
+
+#include <sstream>
+#include <cstring>
+
+using namespace graphics;
+
+namespace {
+    inline uint32_t floatBits(float f) {
+        uint32_t u;
+        memcpy(&u, &f, sizeof(float));
+        return u;
+    }
+}
+
+const char* graphics::toString(HeadlessCommandType type) {
+    static const char* names[(uint32_t)HeadlessCommandType::COUNT + 1] = {
+        "BEGIN",
+        "END",
+        "BEGIN_PASS",
+        "END_PASS",
+        "COPY_TEXTURE",
+        "CLEAR",
+        "BARRIER_TRANSITION",
+        "BARRIER_RW",
+        "VIEWPORT",
+        "SCISSOR",
+        "BIND_FRAMEBUFFER",
+        "BIND_ROOT_DESCRIPTOR_LAYOUT",
+        "BIND_PIPELINE",
+        "BIND_DESCRIPTOR_SET",
+        "BIND_PUSH_UNIFORM",
+        "BIND_INDEX_BUFFER",
+        "BIND_VERTEX_BUFFERS",
+        "DRAW",
+        "DRAW_INDEXED",
+        "DRAW_INSTANCED",
+        "UPLOAD_TEXTURE",
+        "UPLOAD_BUFFER",
+        "UPLOAD_BUFFER_REGION",
+        "COPY_BUFFER_REGION",
+        "DISPATCH",
+        "DISPATCH_RAYS",
+        "UNKNOWN",
+    };
+    return names[std::min((uint32_t)type, (uint32_t)HeadlessCommandType::COUNT)];
+}
+
+HeadlessFrameStats& HeadlessFrameStats::operator+= (const HeadlessFrameStats& s) {
+    numBatches += s.numBatches;
+    numCommands += s.numCommands;
+    numPasses += s.numPasses;
+    numClears += s.numClears;
+    numDraws += s.numDraws;
+    numPrimitives += s.numPrimitives;
+    numInstancedDraws += s.numInstancedDraws;
+    numInstances += s.numInstances;
+    numDispatches += s.numDispatches;
+    numBarriers += s.numBarriers;
+    numPipelineBinds += s.numPipelineBinds;
+    numRedundantPipelineBinds += s.numRedundantPipelineBinds;
+    numRootDescriptorLayoutBinds += s.numRootDescriptorLayoutBinds;
+    numDescriptorSetBinds += s.numDescriptorSetBinds;
+    numRedundantDescriptorSetBinds += s.numRedundantDescriptorSetBinds;
+    numPushUniforms += s.numPushUniforms;
+    numVertexBufferBinds += s.numVertexBufferBinds;
+    numIndexBufferBinds += s.numIndexBufferBinds;
+    numUploads += s.numUploads;
+    bytesUploaded += s.bytesUploaded;
+    bytesCopied += s.bytesCopied;
+    bytesPushed += s.bytesPushed;
+    return *this;
+}
+
+std::string HeadlessFrameStats::toString() const {
+    std::ostringstream s;
+    s << "batches " << numBatches << " | commands " << numCommands << " | passes " << numPasses
+      << " | draws " << numDraws << " (" << numPrimitives << " prims, " << numInstancedDraws << " instanced x" << numInstances << ")"
+      << " | dispatches " << numDispatches
+      << " | barriers " << numBarriers
+      << " | pipelines " << numPipelineBinds << " (" << numRedundantPipelineBinds << " redundant)"
+      << " | descriptor sets " << numDescriptorSetBinds << " (" << numRedundantDescriptorSetBinds << " redundant)"
+      << " | push uniforms " << numPushUniforms << " (" << bytesPushed << " B)"
+      << " | uploads " << numUploads << " (" << bytesUploaded << " B) | copied " << bytesCopied << " B";
+    return s.str();
+}
+
+HeadlessBatchBackend::HeadlessBatchBackend() {
+}
+
+HeadlessBatchBackend::~HeadlessBatchBackend() {
+}
+
+void HeadlessBatchBackend::begin(uint8_t currentIndex, const BatchTimerPointer& timer) {
+    _commands.clear();
+    _pushData.clear();
+    _stats = HeadlessFrameStats();
+    _boundPipeline = nullptr;
+    memset(_boundRootDescriptorLayouts, 0, sizeof(_boundRootDescriptorLayouts));
+    memset(_boundDescriptorSets, 0, sizeof(_boundDescriptorSets));
+
+    record(HeadlessCommandType::BEGIN, timer.get()).args[0] = currentIndex;
+}
+
+void HeadlessBatchBackend::end() {
+    record(HeadlessCommandType::END);
+    _stats.numBatches = 1;
+    _stats.numCommands = (uint32_t) _commands.size();
+}
+
+void HeadlessBatchBackend::beginPass(const SwapchainPointer& swapchain, uint8_t currentIndex) {
+    record(HeadlessCommandType::BEGIN_PASS, swapchain.get()).args[0] = currentIndex;
+    _stats.numPasses++;
+}
+
+void HeadlessBatchBackend::beginPass(const FramebufferPointer& framebuffer) {
+    record(HeadlessCommandType::BEGIN_PASS, framebuffer.get()).args[0] = framebuffer->currentIndex();
+    _stats.numPasses++;
+}
+
+void HeadlessBatchBackend::endPass() {
+    record(HeadlessCommandType::END_PASS);
+}
+
+void HeadlessBatchBackend::copyTexture(const TexturePointer& src, const SwapchainPointer& dst, uint8_t dstIndex) {
+    record(HeadlessCommandType::COPY_TEXTURE, src.get()).args[0] = dstIndex;
+}
+
+void HeadlessBatchBackend::clear(const SwapchainPointer& swapchain, uint8_t index, const core::vec4& color, float depth) {
+    record(HeadlessCommandType::CLEAR, swapchain.get()).args[0] = index;
+    _stats.numClears++;
+}
+
+void HeadlessBatchBackend::clear(const FramebufferPointer& framebuffer, const core::vec4& color, float depth) {
+    record(HeadlessCommandType::CLEAR, framebuffer.get()).args[0] = framebuffer->currentIndex();
+    _stats.numClears++;
+}
+
+void HeadlessBatchBackend::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const SwapchainPointer& swapchain, uint8_t currentIndex, uint32_t subresource) {
+    auto& c = record(HeadlessCommandType::BARRIER_TRANSITION, swapchain.get());
+    c.args[0] = (uint32_t) stateBefore;
+    c.args[1] = (uint32_t) stateAfter;
+    c.args[2] = subresource;
+    _stats.numBarriers++;
+}
+
+void HeadlessBatchBackend::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const BufferPointer& buffer) {
+    auto& c = record(HeadlessCommandType::BARRIER_TRANSITION, buffer.get());
+    c.args[0] = (uint32_t) stateBefore;
+    c.args[1] = (uint32_t) stateAfter;
+    _stats.numBarriers++;
+}
+
+void HeadlessBatchBackend::resourceBarrierTransition(
+    ResourceBarrierFlag flag, ResourceState stateBefore, ResourceState stateAfter,
+    const TexturePointer& texture, uint32_t subresource) {
+    auto& c = record(HeadlessCommandType::BARRIER_TRANSITION, texture.get());
+    c.args[0] = (uint32_t) stateBefore;
+    c.args[1] = (uint32_t) stateAfter;
+    c.args[2] = subresource;
+    _stats.numBarriers++;
+}
+
+void HeadlessBatchBackend::resourceBarrierRW(ResourceBarrierFlag flag, const BufferPointer& buffer) {
+    record(HeadlessCommandType::BARRIER_RW, buffer.get());
+    _stats.numBarriers++;
+}
+
+void HeadlessBatchBackend::resourceBarrierRW(ResourceBarrierFlag flag, const TexturePointer& texture, uint32_t subresource) {
+    record(HeadlessCommandType::BARRIER_RW, texture.get()).args[2] = subresource;
+    _stats.numBarriers++;
+}
+
+void HeadlessBatchBackend::recordRect(HeadlessCommandType type, const core::vec4& rect) {
+    auto& c = record(type);
+    c.args[0] = floatBits(rect.x);
+    c.args[1] = floatBits(rect.y);
+    c.args[2] = floatBits(rect.z);
+    c.args[3] = floatBits(rect.w);
+}
+
+void HeadlessBatchBackend::_setViewport(const core::vec4& viewport) {
+    recordRect(HeadlessCommandType::VIEWPORT, viewport);
+}
+
+void HeadlessBatchBackend::_setScissor(const core::vec4& scissor) {
+    recordRect(HeadlessCommandType::SCISSOR, scissor);
+}
+
+void HeadlessBatchBackend::bindFramebuffer(const FramebufferPointer& framebuffer) {
+    record(HeadlessCommandType::BIND_FRAMEBUFFER, framebuffer.get());
+}
+
+void HeadlessBatchBackend::bindRootDescriptorLayout(PipelineType type, const RootDescriptorLayoutPointer& rootDescriptorLayout) {
+    record(HeadlessCommandType::BIND_ROOT_DESCRIPTOR_LAYOUT, rootDescriptorLayout.get()).pipelineType = type;
+    _stats.numRootDescriptorLayoutBinds++;
+    setRootDescriptorLayout(type, rootDescriptorLayout.get());
+}
+
+void HeadlessBatchBackend::setRootDescriptorLayout(PipelineType type, const RootDescriptorLayout* rootDescriptorLayout) {
+    // A different root layout invalidates the descriptor sets bound so far
+    if (_boundRootDescriptorLayouts[(uint32_t)type] != rootDescriptorLayout) {
+        _boundRootDescriptorLayouts[(uint32_t)type] = rootDescriptorLayout;
+        for (auto& s : _boundDescriptorSets[(uint32_t)type]) s = nullptr;
+    }
+}
+
+void HeadlessBatchBackend::bindPipeline(const PipelineStatePointer& pipeline) {
+    auto& c = record(HeadlessCommandType::BIND_PIPELINE, pipeline.get());
+    c.pipelineType = pipeline->getType();
+    _stats.numPipelineBinds++;
+    if (_boundPipeline == pipeline.get()) {
+        _stats.numRedundantPipelineBinds++;
+        return;
+    }
+    _boundPipeline = pipeline.get();
+
+    // Binding a pipeline binds its root descriptor layout too
+    setRootDescriptorLayout(c.pipelineType, pipeline->getRootDescriptorLayout().get());
+}
+
+void HeadlessBatchBackend::bindDescriptorSet(PipelineType type, const DescriptorSetPointer& descriptorSet) {
+    auto& c = record(HeadlessCommandType::BIND_DESCRIPTOR_SET, descriptorSet.get());
+    c.pipelineType = type;
+    c.slot = (uint16_t) descriptorSet->_init._bindSetSlot;
+    _stats.numDescriptorSetBinds++;
+
+    // samplers only sets have no set slot, keep them in the last one
+    uint32_t slot = std::min((uint32_t) descriptorSet->_init._bindSetSlot, MAX_BOUND_DESCRIPTOR_SETS - 1);
+    auto& bound = _boundDescriptorSets[(uint32_t)type][slot];
+    if (bound == descriptorSet.get()) {
+        _stats.numRedundantDescriptorSetBinds++;
+    }
+    bound = descriptorSet.get();
+}
+
+void HeadlessBatchBackend::bindPushUniform(PipelineType type, uint32_t slot, uint32_t size, const uint8_t* data) {
+    auto& c = record(HeadlessCommandType::BIND_PUSH_UNIFORM);
+    c.pipelineType = type;
+    c.slot = (uint16_t) slot;
+    c.args[0] = (uint32_t) _pushData.size();
+    c.args[1] = size;
+    _pushData.insert(_pushData.end(), data, data + size);
+    _stats.numPushUniforms++;
+    _stats.bytesPushed += size;
+}
+
+void HeadlessBatchBackend::bindIndexBuffer(const BufferPointer& buffer) {
+    record(HeadlessCommandType::BIND_INDEX_BUFFER, buffer.get());
+    _stats.numIndexBufferBinds++;
+}
+
+void HeadlessBatchBackend::bindVertexBuffers(uint32_t num, const BufferPointer* buffers) {
+    record(HeadlessCommandType::BIND_VERTEX_BUFFERS, (num ? buffers[0].get() : nullptr)).args[0] = num;
+    _stats.numVertexBufferBinds += num;
+}
+
+void HeadlessBatchBackend::draw(uint32_t numPrimitives, uint32_t startIndex) {
+    auto& c = record(HeadlessCommandType::DRAW, _boundPipeline);
+    c.args[0] = numPrimitives;
+    c.args[1] = startIndex;
+    _stats.numDraws++;
+    _stats.numPrimitives += numPrimitives;
+}
+
+void HeadlessBatchBackend::drawIndexed(uint32_t numPrimitives, uint32_t startIndex) {
+    auto& c = record(HeadlessCommandType::DRAW_INDEXED, _boundPipeline);
+    c.args[0] = numPrimitives;
+    c.args[1] = startIndex;
+    _stats.numDraws++;
+    _stats.numPrimitives += numPrimitives;
+}
+
+void HeadlessBatchBackend::drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) {
+    auto& c = record(HeadlessCommandType::DRAW_INSTANCED, _boundPipeline);
+    c.args[0] = numPrimitives;
+    c.args[1] = startIndex;
+    c.args[2] = numInstances;
+    _stats.numDraws++;
+    _stats.numPrimitives += (uint64_t) numPrimitives * numInstances;
+    _stats.numInstancedDraws++;
+    _stats.numInstances += numInstances;
+}
+
+void HeadlessBatchBackend::uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& subresourceLayout, const BufferPointer& src) {
+    auto dstBackend = static_cast<HeadlessTextureBackend*>(dest.get());
+    auto srcData = (const uint8_t*) src->_cpuMappedAddress;
+
+    uint64_t numBytes = 0;
+    for (const auto& l : subresourceLayout) {
+        if (dstBackend->_subresources.size() <= l.subresource) {
+            dstBackend->_subresources.resize(l.subresource + 1);
+        }
+        dstBackend->_subresources[l.subresource].assign(srcData + l.byteOffset, srcData + l.byteOffset + l.byteLength);
+        numBytes += l.byteLength;
+    }
+
+    record(HeadlessCommandType::UPLOAD_TEXTURE, dest.get()).args[0] = (uint32_t) numBytes;
+    _stats.numUploads++;
+    _stats.bytesUploaded += numBytes;
+}
+
+void HeadlessBatchBackend::uploadBuffer(const BufferPointer& dest) {
+    // The buffer has a single cpu storage, there is nothing to copy
+    record(HeadlessCommandType::UPLOAD_BUFFER, dest.get()).args[0] = (uint32_t) dest->bufferSize();
+    _stats.numUploads++;
+    _stats.bytesUploaded += dest->bufferSize();
+    dest->notifyUploaded();
+}
+
+void HeadlessBatchBackend::uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) {
+    auto& c = record(HeadlessCommandType::UPLOAD_BUFFER_REGION, dest.get());
+    c.args[0] = offset;
+    c.args[1] = size;
+    _stats.numUploads++;
+    _stats.bytesUploaded += size;
+}
+
+void HeadlessBatchBackend::copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) {
+    auto srcBackend = static_cast<HeadlessBufferBackend*>(src.get());
+    auto dstBackend = static_cast<HeadlessBufferBackend*>(dest.get());
+    memmove(dstBackend->_data.data() + destOffset, srcBackend->_data.data() + srcOffset, size);
+
+    auto& c = record(HeadlessCommandType::COPY_BUFFER_REGION, dest.get());
+    c.args[0] = destOffset;
+    c.args[1] = srcOffset;
+    c.args[2] = size;
+    _stats.bytesCopied += size;
+}
+
+void HeadlessBatchBackend::dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) {
+    auto& c = record(HeadlessCommandType::DISPATCH, _boundPipeline);
+    c.pipelineType = PipelineType::COMPUTE;
+    c.args[0] = numThreadsX;
+    c.args[1] = numThreadsY;
+    c.args[2] = numThreadsZ;
+    _stats.numDispatches++;
+}
+
+void HeadlessBatchBackend::dispatchRays(const DispatchRaysArgs& args) {
+    auto& c = record(HeadlessCommandType::DISPATCH_RAYS, args.shaderTable.get());
+    c.pipelineType = PipelineType::RAYTRACING;
+    c.args[0] = args.width;
+    c.args[1] = args.height;
+    c.args[2] = args.depth;
+    _stats.numDispatches++;
+}
@@ -0,0 +1,96 @@
+// HeadlessTestScene.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "HeadlessTestScene.h"
+#include "HeadlessBackend.h"
+
+#include "render/Scene.h"
+#include "render/Camera.h"
+#include "render/Viewport.h"
+
+using namespace graphics;
+
+HeadlessTestScene::HeadlessTestScene(const HeadlessTestSceneInit& init) {
+    uint32_t numItems = (uint32_t) init.modelFiles.size() * init.numInstances * init.capacityPerInstance;
+    device = Device::createDevice({ "Headless" });
+    scene = std::make_shared<Scene>(SceneInit{ device, 10000 + (int32_t) numItems, 10000 + (int32_t) numItems, 1000, 10 });
+
+    camera = scene->createCamera();
+    camera->setViewport(1280.0f, 720.0f, true);
+    viewport = std::make_shared<Viewport>(ViewportInit{ scene, device, nullptr, camera->id() });
+
+    factory = std::make_shared<ModelDrawFactory>(device);
+    if (init.streamingBudget) {
+        viewport->getStreamingQueue()->setFrameBudget(init.streamingBudget);
+        factory->setStreamingQueue(viewport->getStreamingQueue());
+    }
+
+    swapchain = device->createSwapchain({ nullptr, 1280, 720, true });
+
+    for (const auto& f : init.modelFiles) {
+        document::ModelPointer doc = document::model::Model::createFromGLTF(f);
+        if (!doc) {
+            models.clear();
+            return;
+        }
+        auto model = factory->createModel(device, doc);
+        factory->allocateDrawcallObject(device, scene, *model);
+        models.emplace_back(model);
+    }
+
+    auto root = scene->createNode({}).id();
+    for (uint32_t i = 0; i < init.numInstances; ++i) {
+        for (auto model : models) {
+            auto items = factory->createModelParts(root, scene, *model);
+            if (init.spreadInstances) {
+                scene->_nodes.editNodeTransform(scene->_items.getNodeID(items[0]), [&](Transform& rts) {
+                    core::translation(rts, core::vec3(float(i % 32), 0.0f, -1.0f - float(i / 32)));
+                    return true;
+                });
+            }
+        }
+    }
+    if (init.spreadInstances) {
+        scene->_nodes.updateTransforms();
+    }
+    numInstances = init.numInstances;
+}
+
+HeadlessTestScene::~HeadlessTestScene() {
+}
+
+HeadlessBackend* HeadlessTestScene::backend() const {
+    return static_cast<HeadlessBackend*>(device->nativeDevice());
+}
+
+const HeadlessFrameStats& HeadlessTestScene::lastFrameStats() const {
+    return backend()->lastFrameStats();
+}
+
+void HeadlessTestScene::renderFrame() {
+    viewport->render(swapchain);
+    device->presentSwapchain(swapchain);
+}
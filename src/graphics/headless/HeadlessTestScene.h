@@ -0,0 +1,72 @@
+// HeadlessTestScene.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "render/render.h"
+#include "drawables/ModelDraw.h"
+
+#include <vector>
+#include <string>
+
+// The pico_four setup without a window, shared by the tests and benchmarks of the render path:
+// a headless device, a scene, a camera, a viewport, a swapchain and instances of glTF models.
+namespace graphics {
+
+    class HeadlessBackend;
+    struct HeadlessFrameStats;
+
+    struct HeadlessTestSceneInit {
+        std::vector<std::string> modelFiles;
+        uint32_t numInstances{ 1 };     // of every model, interleaved in item order
+        uint64_t streamingBudget{ 0 };  // if not 0, the models are streamed through the queue of the viewport
+        bool spreadInstances{ false };  // place the instances on a grid along the view axis
+        uint32_t capacityPerInstance{ 100 }; // nodes and items reserved in the scene per instance of a model
+    };
+
+    class VISUALIZATION_API HeadlessTestScene {
+    public:
+        HeadlessTestScene(const HeadlessTestSceneInit& init);
+        ~HeadlessTestScene();
+
+        DevicePointer device;
+        ScenePointer scene;
+        CameraPointer camera; // the scene only keeps a weak reference
+        ViewportPointer viewport;
+        SwapchainPointer swapchain;
+        ModelDrawFactoryPointer factory;
+        std::vector<ModelDraw*> models; // empty if one of the model files failed to load
+        uint32_t numInstances{ 0 };
+
+        ModelDraw* model() const { return (models.empty() ? nullptr : models[0]); }
+
+        HeadlessBackend* backend() const;
+        const HeadlessFrameStats& lastFrameStats() const;
+
+        // Render the viewport in the swapchain and present it
+        void renderFrame();
+    };
+}
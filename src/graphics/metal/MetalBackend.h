@@ -282,11 +282,13 @@ public:
     void bindIndexBuffer(const BufferPointer& buffer) override;
     void bindVertexBuffers(uint32_t num, const BufferPointer* buffers) override;
     void draw(uint32_t numPrimitives, uint32_t startIndex) override;
+    void drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) override;
     void drawIndexed(uint32_t numPrimitives, uint32_t startIndex) override;
     void uploadTexture(const TexturePointer& dest, const UploadSubresourceLayoutArray& layout, const BufferPointer& src) override;
     void uploadTexture(const TexturePointer& dest) override;
     void uploadTextureFromInitdata(const DevicePointer& device, const TexturePointer& dest, const std::vector<uint32_t>& subresources) override;
     void uploadBuffer(const BufferPointer& dest) override;
+    void uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) override;
     void copyBufferRegion(const BufferPointer& dest, uint32_t destOffset, const BufferPointer& src, uint32_t srcOffset, uint32_t size) override;
     void dispatch(uint32_t numThreadsX, uint32_t numThreadsY, uint32_t numThreadsZ) override;
     void dispatchRays(const DispatchRaysArgs& args) override;
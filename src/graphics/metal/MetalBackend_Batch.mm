@@ -376,6 +376,17 @@ void MetalBatchBackend::draw(uint32_t numPrimitives, uint32_t startIndex) {
                        vertexCount:numPrimitives];
 }
 
+// ---------------------------------------------------------------------------
+// drawInstanced
+// ---------------------------------------------------------------------------
+void MetalBatchBackend::drawInstanced(uint32_t numPrimitives, uint32_t numInstances, uint32_t startIndex) {
+    if (!_renderEncoder || !_currentPipeline) return;
+    [_renderEncoder drawPrimitives:_currentPipeline->_primitiveType
+                       vertexStart:startIndex
+                       vertexCount:numPrimitives
+                     instanceCount:numInstances];
+}
+
 // ---------------------------------------------------------------------------
 // drawIndexed  (indices are uint32)
 // ---------------------------------------------------------------------------
@@ -531,6 +542,10 @@ void MetalBatchBackend::uploadBuffer(const BufferPointer& dest) {
     if (dest) dest->notifyUploaded();
 }
 
+void MetalBatchBackend::uploadBufferRegion(const BufferPointer& dest, uint32_t offset, uint32_t size) {
+    // Same as uploadBuffer, the shared MTLBuffer already holds the cpu writes
+}
+
 void MetalBatchBackend::copyBufferRegion(const BufferPointer& dst, uint32_t dstOff,
                                           const BufferPointer& src, uint32_t srcOff,
                                           uint32_t size) {
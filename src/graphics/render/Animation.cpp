@@ -30,7 +30,9 @@
 #include "gpu/Resource.h"
 #include "gpu/Device.h"
 
-#include "render/scene.h"
+#include "render/Scene.h"
+
+#include "core/Job.h"
 
 
 #include <algorithm>
@@ -133,12 +135,7 @@ int32_t AnimStore::release(AnimID id) {
 }
 
 void AnimStore::syncGPUBuffer(const BatchPointer& batch) {
-    // Clean the touched elements
-    std::sort(_touchedElements.begin(), _touchedElements.end());
-    auto newEnd = std::unique(_touchedElements.begin(), _touchedElements.end());
-    if (newEnd != _touchedElements.end()) _touchedElements.erase(newEnd);
-
-    // Sync the gpu buffer version
+    // Sync the pages of the touched elements, in any order
     _animInfos.sync_gpu_from_cpu(batch, _touchedElements);
 
     // Start fresh
@@ -280,53 +277,814 @@ std::pair<Key::ClipData, Key::ClipArray> Key::createClipsFromGLTF(document::mode
     return  {clipData, clips};
 }
 
+Key::ClipData Key::compressClips(const ClipData& data, const ClipArray& clips, const Compression& compression) {
+    // The path animated by each sampler picks its tolerance
+    std::vector<int32_t> samplerPaths(data._samplers.size(), Path::NONE);
+    for (const auto& clip : clips) {
+        for (const auto& channel : clip._channels) {
+            samplerPaths[channel._samplerId] = channel._path;
+        }
+    }
+
+    ClipData compressed;
+    compressed._samplers = data._samplers;
+    compressed._compressed.tracks.reserve(data._samplers.size());
+    for (size_t s = 0; s < data._samplers.size(); ++s) {
+        const auto& sampler = data._samplers[s];
+        const auto& in_access = data._accessors[sampler._input];
+        const auto& out_access = data._accessors[sampler._output];
+        const float* times = data.fetch<float>(0, in_access);
+        auto path = samplerPaths[s];
+
+        if (path == Path::TRANSLATION || path == Path::SCALE) {
+            float tolerance = (path == Path::TRANSLATION ? compression.translationTolerance : compression.scaleTolerance);
+            core::keyframe_compress(compressed._compressed, times, data.fetch<core::vec3>(0, out_access), in_access._elementCount, tolerance);
+        }
+        else if (path == Path::ROTATION) {
+            core::keyframe_compress(compressed._compressed, times, data.fetch<core::rotor3>(0, out_access), in_access._elementCount, compression.rotationTolerance);
+        }
+        else {
+            core::keyframe_compressEmpty(compressed._compressed);
+        }
+    }
+    // Short clips barely drop any key and the track headers outweigh the quantization, keep the source then
+    if (compressed.byteSize() >= data.byteSize()) {
+        return data;
+    }
+    return compressed;
+}
+
+namespace {
+    // Find the key interval of every channel in the list and gather the keys in the streams
+    void gatherVec3Channels(const Key::IDs& channels, float time, const Key::Clip& clip, const Key::ClipData& data, std::vector<uint32_t>& keyCursors,
+                            core::vec3_stream& v0s, core::vec3_stream& v1s, core::float_array& params) {
+        uint32_t num = (uint32_t) channels.size();
+        v0s.resize(num);
+        v1s.resize(num);
+        core::stream_resize(params, num);
+        for (uint32_t l = 0; l < num; ++l) {
+            core::vec3 v0, v1;
+            auto c = channels[l];
+            params[l] = data.sampleKeys<core::vec3>(time, clip._channels[c]._samplerId, keyCursors[c], v0, v1);
+            v0s.set(l, v0);
+            v1s.set(l, v1);
+        }
+    }
+
+    // Apply a channel state to the local rts of its target node
+    void applyChannel(core::mat4x3& rts, const Key::ChannelState& channelState) {
+        if (channelState.targetType == Key::TRANSLATION) {
+            core::translation(rts, channelState.translation);
+        }
+        else if (channelState.targetType == Key::ROTATION) {
+            core::rotation_scaling(rts, channelState.rotation, core::scaling(rts));
+        }
+        else if (channelState.targetType == Key::SCALE) {
+            core::scaling(rts, channelState.scale);
+        }
+    }
+}
+
 void Key::animateClip(ClipState& state, AnimState& anim, const ClipArray& clips, const ClipData& data) {
     const auto& clip = clips[anim.clip];
     state.channelStates.resize(clip._channels.size());
+    state.keyCursors.resize(clip._channels.size(), 0);
+
+    // First pass: collect the channels per path
+    state.translationChannels.clear();
+    state.rotationChannels.clear();
+    state.scaleChannels.clear();
     for (int i = 0; i < clip._channels.size(); ++i) {
         const auto& source = clip._channels[i];
         auto& result = state.channelStates[i];
         result.targetId = source._targetId;
         result.targetType = source._path;
         if (source._path == Path::TRANSLATION) {
-            result.translation = data.sampleVec3(anim.time, source._samplerId);
+            state.translationChannels.push_back(i);
         } else if (source._path == Path::ROTATION) {
-            result.rotation = data.sampleRotor3(anim.time, source._samplerId);
+            state.rotationChannels.push_back(i);
+        } else if (source._path == Path::SCALE) {
+            state.scaleChannels.push_back(i);
         }
     }
+
+    // Second pass: find the key interval of every channel and gather the keys in the streams
+    gatherVec3Channels(state.translationChannels, anim.time, clip, data, state.keyCursors, state.translations0, state.translations1, state.translationParams);
+    gatherVec3Channels(state.scaleChannels, anim.time, clip, data, state.keyCursors, state.scales0, state.scales1, state.scaleParams);
+
+    uint32_t numRotations = (uint32_t) state.rotationChannels.size();
+    state.rotations0.resize(numRotations);
+    state.rotations1.resize(numRotations);
+    core::stream_resize(state.rotationParams, numRotations);
+    for (uint32_t l = 0; l < numRotations; ++l) {
+        core::rotor3 r0, r1;
+        auto c = state.rotationChannels[l];
+        state.rotationParams[l] = data.sampleKeys<core::rotor3>(anim.time, clip._channels[c]._samplerId, state.keyCursors[c], r0, r1);
+        state.rotations0.set(l, r0);
+        state.rotations1.set(l, r1);
+    }
+
+    // Interpolate all the channels in one go
+    core::stream_mix(state.translations0, state.translations1, state.translationParams, state.translations);
+    core::stream_slerp(state.rotations0, state.rotations1, state.rotationParams, state.rotations);
+    core::stream_mix(state.scales0, state.scales1, state.scaleParams, state.scales);
+
+    // Scatter back the results in the channel states
+    for (uint32_t l = 0; l < state.translationChannels.size(); ++l) {
+        state.channelStates[state.translationChannels[l]].translation = state.translations.get(l);
+    }
+    for (uint32_t l = 0; l < numRotations; ++l) {
+        state.channelStates[state.rotationChannels[l]].rotation = state.rotations.get(l);
+    }
+    for (uint32_t l = 0; l < state.scaleChannels.size(); ++l) {
+        state.channelStates[state.scaleChannels[l]].scale = state.scales.get(l);
+    }
 }
 
 void Key::animateTransformBranch(NodeID branchRoot, const ClipState& state, NodeStore& transforms) {
+    for (const auto& channelState : state.channelStates) {
+        transforms.editNodeTransform(branchRoot + channelState.targetId, [&](core::mat4x3& rts) -> bool {
+            applyChannel(rts, channelState);
+            return true;
+        });
+    }
+}
 
+uint32_t Key::applyTransformBranch(NodeID branchRoot, const ClipState& state, NodeStore::NodeTransform* transforms, NodeID* touched) {
+    uint32_t numTargets = 0;
     for (const auto& channelState : state.channelStates) {
+        auto node = branchRoot + channelState.targetId;
+        applyChannel(transforms[node].local, channelState);
+        touched[numTargets++] = node;
+    }
+    return numTargets;
+}
 
-        transforms.editNodeTransform(branchRoot + channelState.targetId, [&](core::mat4x3& rts) -> bool {
-            if (channelState.targetType == 0) {
-                core::translation(rts, channelState.translation);
-                //        picoLogf("p= {} {} {}", channelState.translation.x, channelState.translation.y, channelState.translation.z);
-                return true;
-            }
-            else if (channelState.targetType == 1) {
-                core::rotation(rts, channelState.rotation);
-                //         picoLogf("r= {} {} {} {}", channelState.rotation.a, channelState.rotation.b.xy, channelState.rotation.b.xz, channelState.rotation.b.yz);
-                return true;
-            }
-            else {
+Key::Skeleton Key::createSkeleton(const NodeIDs& nodeParents) {
+    int32_t numNodes = (int32_t) nodeParents.size();
+    std::vector<IDs> children(numNodes);
+    Skeleton skeleton;
+    for (int32_t n = 0; n < numNodes; ++n) {
+        if (nodeParents[n] == INVALID_NODE_ID) {
+            skeleton.joints.push_back(n);
+            skeleton.parents.push_back(-1);
+        } else {
+            children[nodeParents[n]].push_back(n);
+        }
+    }
 
-            }
-            return true;
-            });
+    // Breadth first from the roots, the joints get appended after their parent
+    skeleton.numChildren.reserve(numNodes);
+    for (int32_t j = 0; j < (int32_t) skeleton.joints.size(); ++j) {
+        const auto& jointChildren = children[skeleton.joints[j]];
+        skeleton.numChildren.push_back((int32_t) jointChildren.size());
+        for (auto c : jointChildren) {
+            skeleton.joints.push_back(c);
+            skeleton.parents.push_back(j);
+        }
     }
+    return skeleton;
 }
 
-void KeyAnim::animate(NodeID rootNode, AnimateArgs& args) {
+uint32_t Key::poseTransformBranch(NodeID branchRoot, const Skeleton& skeleton, const NodeStore::NodeInfo* infos, NodeStore::NodeTransform* transforms, NodeID* touched) {
+    static const Transform identity;
+    uint32_t numTouched = 0;
+    for (uint32_t j = 0; j < skeleton.joints.size(); ++j) {
+        auto node = branchRoot + skeleton.joints[j];
+        const auto& info = infos[node];
+        auto parent = skeleton.parents[j];
+        const auto& parentWorld = (parent >= 0 ? transforms[branchRoot + skeleton.joints[parent]].world :
+                                  (info.parent == INVALID_NODE_ID ? identity : transforms[info.parent].world));
+        transforms[node].world = core::mul(parentWorld, transforms[node].local);
+
+        // Nodes attached under the joint from outside of the branch are left to updateTransforms
+        if (info.num_children > skeleton.numChildren[j]) {
+            touched[numTouched++] = node;
+        }
+    }
+    return numTouched;
+}
+
+void KeyAnim::sample(NodeID rootNode, AnimateArgs& args) {
     const auto& clip = _key->_clips[_clip];
-    
+
     float currentTime = fmod(args.time, clip._endTime - clip._beginTime) + clip._beginTime;
 
     Key::AnimState animState = { currentTime, _clip };
     Key::animateClip(_state, animState, _key->_clips, _key->_data);
+}
+
+uint32_t KeyAnim::apply(NodeID rootNode, const NodeStore::NodeInfo* infos, NodeStore::NodeTransform* transforms, NodeID* touched, NodeStore::NodeRange& written) const {
+    auto branchRoot = rootNode + 1;
+    uint32_t numTouched = Key::applyTransformBranch(branchRoot, _state, transforms, touched);
+    if (_key->_skeleton.empty()) {
+        if (numTouched) {
+            auto [first, last] = std::minmax_element(touched, touched + numTouched);
+            written = { *first, *last + 1 };
+        }
+        return numTouched;
+    }
+    // Pose the whole branch in one pass, the animated nodes are not walked again by updateTransforms
+    written = { branchRoot, branchRoot + (NodeID) _key->_skeleton.joints.size() };
+    return Key::poseTransformBranch(branchRoot, _key->_skeleton, infos, transforms, touched);
+}
+
+void KeyAnim::animate(NodeID rootNode, AnimateArgs& args) {
+    sample(rootNode, args);
 
     auto targetNodeId = rootNode + 1;
     Key::animateTransformBranch(targetNodeId, _state, args.scene->_nodes);
 }
+
+void AnimStore::animateBatch(const AnimIDs& anims, const NodeIDs& nodes, NodeStore& transforms, AnimArgs& args) {
+    // Split the batched anims from the others which are evaluated in place
+    AnimIDs batched;
+    NodeIDs batchedNodes;
+    batched.reserve(anims.size());
+    batchedNodes.reserve(anims.size());
+    for (size_t i = 0; i < anims.size(); ++i) {
+        const auto& animConcept = _animConcepts[anims[i]];
+        if (!animConcept) continue;
+        if (animConcept->isBatched()) {
+            batched.push_back(anims[i]);
+            batchedNodes.push_back(nodes[i]);
+        } else {
+            animConcept->call(nodes[i], args);
+        }
+    }
+    uint32_t numBatched = (uint32_t) batched.size();
+    if (numBatched == 0) return;
+
+    // An anim shared by the instances of a model appears once per instance, sample it once
+    AnimIDs sampled;
+    NodeIDs sampledNodes;
+    std::vector<uint8_t> isSampled(_animConcepts.size(), 0);
+    for (uint32_t i = 0; i < numBatched; ++i) {
+        if (!isSampled[batched[i]]) {
+            isSampled[batched[i]] = 1;
+            sampled.push_back(batched[i]);
+            sampledNodes.push_back(batchedNodes[i]);
+        }
+    }
+
+    auto& pool = core::ThreadPool::shared();
+    const uint32_t grain = 16;
+
+    // Sample all the clips, each anim only touches its own state
+    pool.parallel_for((uint32_t) sampled.size(), grain, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            _animConcepts[sampled[i]]->sample(sampledNodes[i], args);
+        }
+    });
+
+    // Each anim gets its range in the touched transforms list
+    std::vector<uint32_t> targetOffsets(numBatched + 1, 0);
+    for (uint32_t i = 0; i < numBatched; ++i) {
+        targetOffsets[i + 1] = targetOffsets[i] + _animConcepts[batched[i]]->numTargets();
+    }
+
+    // Write the transforms under a single lock of the node store, apply only reads the sampled state.
+    // The instances drive distinct nodes so the writes never overlap
+    std::vector<uint32_t> numTouched(numBatched, 0);
+    std::vector<NodeStore::NodeRange> writtenRanges(numBatched);
+    auto numNodes = transforms.numAllocatedNodes();
+    transforms.editNodeTransforms([&](const NodeStore::NodeInfo* nodeInfos, NodeStore::NodeTransform* nodeTransforms, NodeIDs& touched, NodeStore::NodeRanges& written) {
+        auto touchedBase = touched.size();
+        touched.resize(touchedBase + targetOffsets[numBatched]);
+        auto touchedBegin = touched.data() + touchedBase;
+
+        // An instance attached under a node of another animated instance (a joint of its skeleton)
+        // poses its branch from the world of that node: it is applied in a later wave than its parent
+        // instance, never concurrently. The wave of an instance is its depth among the animated instances.
+        std::vector<uint32_t> batchedOfRoot(numNodes, INVALID_ANIM_ID);
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            batchedOfRoot[batchedNodes[i]] = i;
+        }
+        std::vector<uint32_t> parentBatched(numBatched, INVALID_ANIM_ID);
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            for (auto n = nodeInfos[batchedNodes[i]].parent; n != INVALID_NODE_ID; n = nodeInfos[n].parent) {
+                if (batchedOfRoot[n] != INVALID_ANIM_ID) {
+                    parentBatched[i] = batchedOfRoot[n];
+                    break;
+                }
+            }
+        }
+        uint32_t numWaves = 1;
+        std::vector<uint32_t> waveOf(numBatched, 0);
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            for (auto p = parentBatched[i]; p != INVALID_ANIM_ID; p = parentBatched[p]) {
+                waveOf[i]++;
+            }
+            numWaves = std::max(numWaves, waveOf[i] + 1);
+        }
+        std::vector<uint32_t> waveOffsets(numWaves + 1, 0);
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            waveOffsets[waveOf[i] + 1]++;
+        }
+        for (uint32_t w = 0; w < numWaves; ++w) {
+            waveOffsets[w + 1] += waveOffsets[w];
+        }
+        std::vector<uint32_t> waveOrder(numBatched);
+        auto waveFill = waveOffsets;
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            waveOrder[waveFill[waveOf[i]]++] = i;
+        }
+
+        NodeIDs chain;
+        for (uint32_t w = 0; w < numWaves; ++w) {
+            // The nodes between the posed parent instance and the root of a nested instance are not animated,
+            // their world is brought up to date serially before the nested pose reads it
+            for (uint32_t k = waveOffsets[w]; w > 0 && k < waveOffsets[w + 1]; ++k) {
+                auto i = waveOrder[k];
+                const auto& parentRange = writtenRanges[parentBatched[i]];
+                auto parentRoot = batchedNodes[parentBatched[i]];
+                chain.clear();
+                for (auto n = batchedNodes[i]; n != parentRoot && !(parentRange.begin <= n && n < parentRange.end); n = nodeInfos[n].parent) {
+                    chain.push_back(n);
+                }
+                for (auto n = chain.rbegin(); n != chain.rend(); ++n) {
+                    nodeTransforms[*n].world = core::mul(nodeTransforms[nodeInfos[*n].parent].world, nodeTransforms[*n].local);
+                    written.push_back({ *n, *n + 1 });
+                }
+            }
+            pool.parallel_for(waveOffsets[w + 1] - waveOffsets[w], grain, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t k = waveOffsets[w] + begin; k < waveOffsets[w] + end; ++k) {
+                    auto i = waveOrder[k];
+                    numTouched[i] = _animConcepts[batched[i]]->apply(batchedNodes[i], nodeInfos, nodeTransforms, touchedBegin + targetOffsets[i], writtenRanges[i]);
+                }
+            });
+        }
+
+        // Only the written branches are uploaded
+        for (const auto& r : writtenRanges) {
+            if (r.begin < r.end) {
+                written.push_back(r);
+            }
+        }
+
+        // Pack the touched ranges, the posed anims touch fewer nodes than their targets
+        auto touchedEnd = touchedBegin;
+        for (uint32_t i = 0; i < numBatched; ++i) {
+            touchedEnd = std::copy_n(touchedBegin + targetOffsets[i], numTouched[i], touchedEnd);
+        }
+        touched.resize(touchedBase + (touchedEnd - touchedBegin));
+    });
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runAnimationTests() to validate the batched evaluation
+// of the AnimStore and runAnimationBenchmarks() to compare it with the
+// per anim evaluation
+// -------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cassert>
+
+namespace {
+    // Key with one clip animating the translation, rotation and scale of numTargets nodes
+    KeyPointer makeTestKey(uint32_t numTargets, uint32_t numKeys) {
+        auto key = std::make_shared<Key>();
+        auto& data = key->_data;
+
+        auto addAccessor = [&](uint32_t elementByteSize, uint32_t type, auto&& fill) {
+            Key::Accessor a;
+            a._byteOffset = data._buffer.size();
+            a._elementCount = numKeys;
+            a._elementByteSize = elementByteSize;
+            a._type = type;
+            data._buffer.resize(data._buffer.size() + a.byteLength());
+            for (uint32_t k = 0; k < numKeys; ++k) {
+                fill(k, data._buffer.data() + a._byteOffset + k * elementByteSize);
+            }
+            data._accessors.push_back(a);
+            return (Key::AccessorID) data._accessors.size() - 1;
+        };
+
+        auto times = addAccessor(4, 0, [](uint32_t k, uint8_t* d) { *(float*) d = float(k); });
+        auto translations = addAccessor(12, 1, [](uint32_t k, uint8_t* d) { *(core::vec3*) d = core::vec3(float(k), 0.5f * k, -1.0f); });
+        auto rotations = addAccessor(16, 2, [](uint32_t k, uint8_t* d) {
+            *(core::rotor3*) d = core::rotor3::make_from_quaternion(core::vec4(0.0f, 0.0f, sin(0.35f * k), cos(0.35f * k)));
+        });
+        auto scales = addAccessor(12, 1, [](uint32_t k, uint8_t* d) { *(core::vec3*) d = core::vec3(1.0f + 0.1f * k, 1.0f, 2.0f - 0.1f * k); });
+
+        for (auto output : { translations, rotations, scales }) {
+            Key::Sampler s;
+            s._input = times;
+            s._output = output;
+            s._beginTime = 0.0f;
+            s._endTime = float(numKeys - 1);
+            data._samplers.push_back(s);
+        }
+
+        Key::Clip clip;
+        clip._name = "test";
+        clip._beginTime = 0.0f;
+        clip._endTime = float(numKeys - 1);
+        for (uint32_t t = 0; t < numTargets; ++t) {
+            clip._channels.push_back({ 0, (NodeID) t, Key::TRANSLATION });
+            clip._channels.push_back({ 1, (NodeID) t, Key::ROTATION });
+            clip._channels.push_back({ 2, (NodeID) t, Key::SCALE });
+        }
+        key->_clips.push_back(clip);
+        return key;
+    }
+
+    // Max error per path over a dense sampling of every channel, source vs compressed clip data
+    void measureCompressionError(const Key::ClipData& source, const Key::ClipData& compressed, const Key::ClipArray& clips, float maxErrors[3]) {
+        for (const auto& clip : clips) {
+            for (const auto& channel : clip._channels) {
+                for (uint32_t s = 0; s <= 500; ++s) {
+                    float t = clip._beginTime + (clip._endTime - clip._beginTime) * (s / 500.0f);
+                    if (channel._path == Key::TRANSLATION || channel._path == Key::SCALE) {
+                        float e = core::length(source.sampleVec3(t, channel._samplerId) - compressed.sampleVec3(t, channel._samplerId));
+                        maxErrors[channel._path] = std::max(maxErrors[channel._path], e);
+                    }
+                    else if (channel._path == Key::ROTATION) {
+                        float e = core::rotor3_angle(source.sampleRotor3(t, channel._samplerId), compressed.sampleRotor3(t, channel._samplerId));
+                        maxErrors[channel._path] = std::max(maxErrors[channel._path], e);
+                    }
+                }
+            }
+        }
+    }
+
+    // A root node per instance followed by the numTargets animated nodes of its branch
+    // Batched anim counting its samples, drives no node
+    struct CountingAnim {
+        std::shared_ptr<std::atomic<uint32_t>> numSamples;
+
+        void animate(NodeID, AnimateArgs&) {}
+        void sample(NodeID, AnimateArgs&) { (*numSamples)++; }
+        uint32_t numTargets() const { return 0; }
+        uint32_t apply(NodeID, const NodeStore::NodeInfo*, NodeStore::NodeTransform*, NodeID*, NodeStore::NodeRange&) const { return 0; }
+    };
+
+    NodeIDs makeTestBranches(NodeStore& nodes, uint32_t numInstances, uint32_t numTargets) {
+        NodeIDs roots;
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            auto root = nodes.createNode({ INVALID_NODE_ID, core::mat4x3(), "root" });
+            for (uint32_t t = 0; t < numTargets; ++t) {
+                nodes.createNode({ root, core::mat4x3(), "target" });
+            }
+            roots.push_back(root);
+        }
+        return roots;
+    }
+
+    // Instances of a branch under a root node each, the branch nodes allocated right after their root
+    NodeIDs makeTestInstances(NodeStore& nodes, uint32_t numInstances, const NodeIDs& parentOffsets, const Transforms& localTransforms) {
+        NodeIDs roots;
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            auto root = nodes.createNode({ INVALID_NODE_ID, core::mat4x3(), "root" });
+            nodes.createNodeBranch({ root, parentOffsets, localTransforms, NodeNames(parentOffsets.size(), "joint") });
+            roots.push_back(root);
+        }
+        return roots;
+    }
+
+    float maxWorldDistance(const NodeStore& a, const NodeStore& b) {
+        auto ta = a.fetchNodeTransforms();
+        auto tb = b.fetchNodeTransforms();
+        float d = 0.0f;
+        for (size_t n = 0; n < ta.size(); ++n) {
+            for (int c = 0; c < 4; ++c) {
+                d = std::max(d, core::length(ta[n].world._columns[c] - tb[n].world._columns[c]));
+            }
+        }
+        return d;
+    }
+}
+
+void runAnimationTests() {
+    picoLog("AnimationTest: starting...");
+
+    const uint32_t numTargets = 5;
+    const uint32_t numInstances = 67;
+    auto key = makeTestKey(numTargets, 8);
+
+    NodeStore serialNodes, batchNodes;
+    auto roots = makeTestBranches(serialNodes, numInstances, numTargets);
+    makeTestBranches(batchNodes, numInstances, numTargets);
+
+    AnimStore anims;
+    AnimIDs animIds;
+    std::vector<KeyAnim> serialAnims(numInstances, KeyAnim{ key, 0 });
+    for (uint32_t i = 0; i < numInstances; ++i) {
+        animIds.push_back(anims.createAnim(KeyAnim{ key, 0 }).id());
+    }
+
+    // --- Test 1: the batched evaluation matches the per anim evaluation ---
+    for (float time : { 0.0f, 1.3f, 2.51f, 6.9f, 9.2f, 3.4f }) {
+        AnimateArgs args{ time };
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            serialAnims[i].sample(roots[i], args);
+            Key::animateTransformBranch(roots[i] + 1, serialAnims[i]._state, serialNodes);
+        }
+        anims.animateBatch(animIds, roots, batchNodes, args);
+
+        auto serialTransforms = serialNodes.fetchNodeTransforms();
+        auto batchTransforms = batchNodes.fetchNodeTransforms();
+        assert(serialTransforms.size() == batchTransforms.size());
+        for (size_t n = 0; n < serialTransforms.size(); ++n) {
+            assert(memcmp(&serialTransforms[n].local, &batchTransforms[n].local, sizeof(core::mat4x3)) == 0);
+        }
+    }
+    picoLog("AnimationTest 1 passed: batched evaluation matches the per anim evaluation");
+
+    // --- Test 2: rotation and scale channels compose in the rts ---
+    {
+        auto local = batchNodes.getNodeTransform(roots[0] + 1).local;
+        auto s = core::scaling(local);
+        // time 3.4 is in the key interval [3, 4]
+        auto expected = core::mix(core::vec3(1.3f, 1.0f, 1.7f), core::vec3(1.4f, 1.0f, 1.6f), 0.4f);
+        assert(core::length(s - expected) < 1e-4f);
+        assert(core::length(local.w() - core::vec3(3.4f, 1.7f, -1.0f)) < 1e-4f);
+    }
+    picoLog("AnimationTest 2 passed: scale channel applied under the rotation");
+
+    // --- Test 3: compressed clips of the test assets, ratio and max error against the source clips ---
+    for (const char* file : { "../asset/gltf/Fox/Fox.gltf", "../asset/gltf/toycar/ToyCar.gltf", "../asset/gltf/Boxes/BoxAnimated.gltf" }) {
+        auto model = document::model::Model::createFromGLTF(file);
+        if (!model) {
+            picoLogf("AnimationTest 3 skipped {}: not found", file);
+            continue;
+        }
+        auto [data, clips] = Key::createClipsFromGLTF(*model);
+        if (clips.empty()) {
+            picoLogf("AnimationTest 3 {}: no animation clip", file);
+            continue;
+        }
+        auto compressed = Key::compressClips(data, clips);
+        float maxErrors[3] = { 0.0f, 0.0f, 0.0f };
+        assert(compressed.byteSize() <= data.byteSize());
+        measureCompressionError(data, compressed, clips, maxErrors);
+        assert(maxErrors[Key::TRANSLATION] < 1e-3f && maxErrors[Key::ROTATION] < 1e-3f && maxErrors[Key::SCALE] < 1e-3f);
+        picoLogf("AnimationTest 3 {}: {} clips {} -> {} bytes (x{:.1f}), max error translation {:.6f} rotation {:.6f} rad scale {:.6f}",
+            file, clips.size(), data.byteSize(), compressed.byteSize(), double(data.byteSize()) / double(compressed.byteSize()),
+            maxErrors[Key::TRANSLATION], maxErrors[Key::ROTATION], maxErrors[Key::SCALE]);
+    }
+    picoLog("AnimationTest 3 passed: compressed clips within tolerance");
+
+    // --- Test 4: the skeleton pose matches the walk of the touched subtrees ---
+    {
+        NodeIDs chain(numTargets);
+        for (uint32_t t = 0; t < numTargets; ++t) {
+            chain[t] = (t == 0 ? INVALID_NODE_ID : t - 1);
+        }
+        auto posedKey = std::make_shared<Key>(*key);
+        posedKey->_skeleton = Key::createSkeleton(chain);
+        assert(posedKey->_skeleton.joints.size() == numTargets && posedKey->_skeleton.parents[0] == -1);
+
+        NodeStore touchedNodes, posedNodes;
+        Transforms locals(numTargets, core::translation(core::vec3(0.0f, 1.0f, 0.0f)));
+        auto chainRoots = makeTestInstances(touchedNodes, numInstances, chain, locals);
+        makeTestInstances(posedNodes, numInstances, chain, locals);
+        // a node attached under the last joint from outside of the branch
+        for (auto r : chainRoots) {
+            touchedNodes.createNode({ r + numTargets, core::translation(core::vec3(1.0f, 0.0f, 0.0f)), "attached" });
+            posedNodes.createNode({ r + numTargets, core::translation(core::vec3(1.0f, 0.0f, 0.0f)), "attached" });
+        }
+        touchedNodes.updateTransforms();
+        posedNodes.updateTransforms();
+
+        AnimStore touchedAnims, posedAnims;
+        AnimIDs touchedIds, posedIds;
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            touchedIds.push_back(touchedAnims.createAnim(KeyAnim{ key, 0 }).id());
+            posedIds.push_back(posedAnims.createAnim(KeyAnim{ posedKey, 0 }).id());
+        }
+        for (float time : { 0.3f, 3.4f, 6.9f }) {
+            AnimateArgs args{ time };
+            touchedAnims.animateBatch(touchedIds, chainRoots, touchedNodes, args);
+            posedAnims.animateBatch(posedIds, chainRoots, posedNodes, args);
+            touchedNodes.updateTransforms();
+            posedNodes.updateTransforms();
+            assert(maxWorldDistance(touchedNodes, posedNodes) < 1e-4f);
+        }
+    }
+    picoLog("AnimationTest 4 passed: skeleton pose matches the touched subtree update");
+
+    // --- Test 5: one anim shared by many roots, as the instances of a model, is sampled once and applied to each ---
+    {
+        NodeStore sharedNodes;
+        auto sharedRoots = makeTestBranches(sharedNodes, numInstances, numTargets);
+        AnimStore sharedAnims;
+        auto sharedId = sharedAnims.createAnim(KeyAnim{ key, 0 }).id();
+        AnimIDs sharedIds(numInstances, sharedId);
+
+        KeyAnim reference{ key, 0 };
+        NodeStore referenceNodes;
+        auto referenceRoots = makeTestBranches(referenceNodes, 1, numTargets);
+        for (float time : { 0.7f, 3.4f, 8.1f }) {
+            AnimateArgs args{ time };
+            sharedAnims.animateBatch(sharedIds, sharedRoots, sharedNodes, args);
+            reference.sample(referenceRoots[0], args);
+            Key::animateTransformBranch(referenceRoots[0] + 1, reference._state, referenceNodes);
+
+            for (auto r : sharedRoots) {
+                for (uint32_t t = 1; t <= numTargets; ++t) {
+                    auto expected = referenceNodes.getNodeTransform(referenceRoots[0] + t).local;
+                    auto local = sharedNodes.getNodeTransform(r + t).local;
+                    assert(memcmp(&expected, &local, sizeof(core::mat4x3)) == 0);
+                }
+            }
+        }
+
+        auto numSamples = std::make_shared<std::atomic<uint32_t>>(0);
+        AnimIDs countingIds(numInstances, sharedAnims.createAnim(CountingAnim{ numSamples }).id());
+        AnimateArgs args{ 1.0f };
+        sharedAnims.animateBatch(countingIds, sharedRoots, sharedNodes, args);
+        assert(numSamples->load() == 1);
+    }
+    picoLog("AnimationTest 5 passed: an anim shared by several roots drives each of them");
+
+    // --- Test 6: only the branches written by the anims are uploaded, among many static nodes ---
+    {
+        const uint32_t numStaticNodes = 20000;
+        NodeIDs chain(numTargets);
+        for (uint32_t t = 0; t < numTargets; ++t) {
+            chain[t] = (t == 0 ? INVALID_NODE_ID : t - 1);
+        }
+        auto posedKey = std::make_shared<Key>(*key);
+        posedKey->_skeleton = Key::createSkeleton(chain);
+
+        auto device = Device::createDevice({ "Headless" });
+        auto batch = device->createBatch({});
+        NodeStore nodes;
+        nodes.reserve(device, numStaticNodes + 2 * (numTargets + 1));
+        for (uint32_t n = 0; n < numStaticNodes; ++n) {
+            nodes.createNode({ INVALID_NODE_ID, core::translation(core::vec3(float(n), 0.0f, 0.0f)), "static" });
+        }
+        auto posedRoots = makeTestInstances(nodes, 1, chain, Transforms(numTargets, core::mat4x3()));
+        auto touchedRoots = makeTestBranches(nodes, 1, numTargets);
+        auto sync = [&]() {
+            batch->begin(0);
+            nodes.syncGPUBuffer(batch);
+            batch->end();
+            return nodes.lastNodeTransformUpload();
+        };
+        auto full = sync();
+
+        AnimStore branchAnims;
+        AnimIDs branchIds = { branchAnims.createAnim(KeyAnim{ posedKey, 0 }).id(), branchAnims.createAnim(KeyAnim{ key, 0 }).id() };
+        NodeIDs branchRoots = { posedRoots[0], touchedRoots[0] };
+        for (float time : { 0.3f, 3.4f }) {
+            AnimateArgs args{ time };
+            branchAnims.animateBatch(branchIds, branchRoots, nodes, args);
+            auto upload = sync();
+            assert(upload.numBytes > 0 && upload.numBytes * 8 < full.numBytes);
+            auto cpu = nodes.fetchNodeTransforms();
+            assert(memcmp(nodes.getNodeTransformGPUBuffer()->_cpuMappedAddress, cpu.data(), cpu.size() * sizeof(NodeStore::NodeTransform)) == 0);
+        }
+        picoLogf("AnimationTest 6 passed: {} B uploaded per animated frame, {} B for the whole array", nodes.lastNodeTransformUpload().numBytes, full.numBytes);
+    }
+
+    // --- Test 7: instances attached under a joint of another posed instance are posed after it ---
+    {
+        NodeIDs chain(numTargets);
+        for (uint32_t t = 0; t < numTargets; ++t) {
+            chain[t] = (t == 0 ? INVALID_NODE_ID : t - 1);
+        }
+        auto posedKey = std::make_shared<Key>(*key);
+        posedKey->_skeleton = Key::createSkeleton(chain);
+        Transforms locals(numTargets, core::translation(core::vec3(0.0f, 1.0f, 0.0f)));
+
+        // 3 levels of nested instances, each one under the last joint of the previous, then independent ones
+        auto makeNested = [&](NodeStore& nodes) {
+            NodeIDs roots;
+            auto parent = INVALID_NODE_ID;
+            for (uint32_t level = 0; level < 3; ++level) {
+                auto root = nodes.createNode({ parent, core::translation(core::vec3(0.5f, 0.0f, 0.0f)), "root" });
+                nodes.createNodeBranch({ root, chain, locals, NodeNames(numTargets, "joint") });
+                roots.push_back(root);
+                parent = root + numTargets;
+            }
+            auto others = makeTestInstances(nodes, numInstances, chain, locals);
+            roots.insert(roots.end(), others.begin(), others.end());
+            // the deepest instance first, the batch order does not matter
+            std::reverse(roots.begin(), roots.begin() + 3);
+            nodes.updateTransforms();
+            return roots;
+        };
+        NodeStore touchedNodes, posedNodes;
+        auto nestedRoots = makeNested(touchedNodes);
+        makeNested(posedNodes);
+
+        AnimStore touchedAnims, posedAnims;
+        AnimIDs touchedIds, posedIds;
+        for (uint32_t i = 0; i < nestedRoots.size(); ++i) {
+            touchedIds.push_back(touchedAnims.createAnim(KeyAnim{ key, 0 }).id());
+            posedIds.push_back(posedAnims.createAnim(KeyAnim{ posedKey, 0 }).id());
+        }
+        for (float time : { 0.3f, 3.4f, 6.9f }) {
+            AnimateArgs args{ time };
+            touchedAnims.animateBatch(touchedIds, nestedRoots, touchedNodes, args);
+            posedAnims.animateBatch(posedIds, nestedRoots, posedNodes, args);
+            touchedNodes.updateTransforms();
+            // the nested poses are complete before any update of the touched subtrees
+            assert(maxWorldDistance(touchedNodes, posedNodes) < 1e-4f);
+            posedNodes.updateTransforms();
+        }
+    }
+    picoLog("AnimationTest 7 passed: nested instances posed after the instance they are attached to");
+
+    picoLog("AnimationTest: all tests passed");
+}
+
+void runAnimationBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+
+    const uint32_t numTargets = 24;
+    const uint32_t numInstances = 4096;
+    const uint32_t numFrames = 32;
+    auto key = makeTestKey(numTargets, 256);
+
+    NodeStore serialNodes, batchNodes;
+    auto roots = makeTestBranches(serialNodes, numInstances, numTargets);
+    makeTestBranches(batchNodes, numInstances, numTargets);
+
+    AnimStore anims;
+    AnimIDs animIds;
+    std::vector<KeyAnim> serialAnims(numInstances, KeyAnim{ key, 0 });
+    for (uint32_t i = 0; i < numInstances; ++i) {
+        animIds.push_back(anims.createAnim(KeyAnim{ key, 0 }).id());
+    }
+
+    // The previous Viewport path: one anim after the other, a lock per channel
+    auto start = clock::now();
+    for (uint32_t f = 0; f < numFrames; ++f) {
+        AnimateArgs args{ f * 0.1f };
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            serialAnims[i].sample(roots[i], args);
+            Key::animateTransformBranch(roots[i] + 1, serialAnims[i]._state, serialNodes);
+        }
+        serialNodes.updateTransforms();
+    }
+    double serialMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    for (uint32_t f = 0; f < numFrames; ++f) {
+        AnimateArgs args{ f * 0.1f };
+        anims.animateBatch(animIds, roots, batchNodes, args);
+        batchNodes.updateTransforms();
+    }
+    double batchMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    double numEvaluated = double(numInstances) * numFrames;
+    picoLogf("AnimationBench {} instances x {} channels, {} threads: serial {:.1f} instances/ms | batched {:.1f} instances/ms | x{:.2f}",
+        numInstances, numTargets * 3, core::ThreadPool::shared().threadCount(), numEvaluated / serialMs, numEvaluated / batchMs, serialMs / batchMs);
+
+    // Multi instance Fox: touching the animated joints vs posing the skeleton in one pass
+    auto fox = document::model::Model::createFromGLTF("../asset/gltf/Fox/Fox.gltf");
+    if (!fox) {
+        picoLog("AnimationBench skeleton pose skipped: Fox not found");
+        return;
+    }
+    auto [foxData, foxClips] = Key::createClipsFromGLTF(*fox);
+    auto foxKey = std::make_shared<Key>();
+    foxKey->_data = std::move(foxData);
+    foxKey->_clips = std::move(foxClips);
+    NodeIDs foxParents;
+    Transforms foxLocals;
+    for (const auto& n : fox->_nodes) {
+        foxParents.push_back(n._parent);
+        foxLocals.push_back(n._transform);
+    }
+    auto posedFoxKey = std::make_shared<Key>(*foxKey);
+    posedFoxKey->_skeleton = Key::createSkeleton(foxParents);
+
+    const uint32_t numFoxes = 2048;
+    NodeStore touchedNodes, posedNodes;
+    auto foxRoots = makeTestInstances(touchedNodes, numFoxes, foxParents, foxLocals);
+    makeTestInstances(posedNodes, numFoxes, foxParents, foxLocals);
+    touchedNodes.updateTransforms();
+    posedNodes.updateTransforms();
+
+    AnimStore touchedAnims, posedAnims;
+    AnimIDs touchedIds, posedIds;
+    for (uint32_t i = 0; i < numFoxes; ++i) {
+        touchedIds.push_back(touchedAnims.createAnim(KeyAnim{ foxKey, 0 }).id());
+        posedIds.push_back(posedAnims.createAnim(KeyAnim{ posedFoxKey, 0 }).id());
+    }
+
+    start = clock::now();
+    for (uint32_t f = 0; f < numFrames; ++f) {
+        AnimateArgs args{ f * 0.1f };
+        touchedAnims.animateBatch(touchedIds, foxRoots, touchedNodes, args);
+        touchedNodes.updateTransforms();
+    }
+    double touchedMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    start = clock::now();
+    for (uint32_t f = 0; f < numFrames; ++f) {
+        AnimateArgs args{ f * 0.1f };
+        posedAnims.animateBatch(posedIds, foxRoots, posedNodes, args);
+        posedNodes.updateTransforms();
+    }
+    double posedMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    double numFoxFrames = double(numFoxes) * numFrames;
+    picoLogf("AnimationBench {} Fox x {} nodes, {} threads: touched joints {:.1f} instances/ms | skeleton pose {:.1f} instances/ms | x{:.2f}",
+        numFoxes, foxParents.size(), core::ThreadPool::shared().threadCount(), numFoxFrames / touchedMs, numFoxFrames / posedMs, touchedMs / posedMs);
+}
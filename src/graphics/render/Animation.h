@@ -27,8 +27,13 @@
 #pragma once
 
 #include <functional>
+#include <concepts>
+#include <algorithm>
 #include <unordered_set>
 #include <core/math/Math3D.h>
+#include <core/math/Stream.h>
+#include <core/math/Keyframe.h>
+#include <core/math/KeyframeCompression.h>
 #include <document/Model.h>
 #include <core/Log.h>
 
@@ -82,6 +87,11 @@ namespace graphics {
             AccessorArray _accessors;
             SamplerArray _samplers;
 
+            // Compressed form, one track per sampler, replaces the buffer and the accessors
+            core::CompressedTracks _compressed;
+            bool isCompressed() const { return !_compressed.tracks.empty(); }
+            uint64_t byteSize() const { return _buffer.size() + _compressed.byteSize(); }
+
             template <typename T> const T* fetch(int32_t i, const Accessor& accessor) const {
                 return ((const T*)(_buffer.data() + accessor._byteOffset + i * accessor._elementByteSize));
             }
@@ -89,43 +99,34 @@ namespace graphics {
             const core::vec3* fetchVec3(int32_t i, AccessorID aid) const { return fetch<core::vec3>(i, _accessors[aid]); }
             const core::rotor3* fetchRotor(int32_t i, AccessorID aid) const { return fetch<core::rotor3>(i, _accessors[aid]); }
 
+            // Find the key interval around t in the input accessor and the interpolation param in it.
+            // The cursor is the key found for the previous sample of this track, playing forward is O(1).
+            float sampleInputTrack(float t, const Accessor& in_access, uint32_t& cursor, int32_t& i0, int32_t& i1) const {
+                return core::keyframe_interval(fetch<float>(0, in_access), in_access._elementCount, t, cursor, i0, i1);
+            }
             float sampleInputTrack(float t, const Accessor& in_access, int32_t& i0, int32_t& i1) const {
-                // First find the current interval from the input accessor
-                int i_idx_0 = 0;
-                int i_idx_1 = i_idx_0;
-                float i_val_0 = *fetch<float>(0, in_access);
-                float i_val_1 = i_val_0;
-                if (t >= i_val_0) {
-                    for (int i = 1; i < in_access._elementCount; ++i) {
-                        float v = *fetch<float>(i, in_access);
-                        if (t < v) {
-                            i_val_1 = v;
-                            i_idx_1 = i;
-                            break;
-                        }
-                        i_val_0 = v;
-                        i_val_1 = v;
-                        i_idx_0 = i;
-                        i_idx_1 = i;
-                    }
-                }
-                float i_param = (i_val_1 - i_val_0);
-                if (i_param > 0.0f) {
-                    i_param = (t - i_val_0) / i_param;
-                }
-                else {
-                    i_idx_1 = i_idx_0;
+                uint32_t cursor = 0;
+                return sampleInputTrack(t, in_access, cursor, i0, i1);
+            }
+
+            // Same as sampleTrack, decoding the keys from the compressed tracks when the clip data is compressed
+            template <typename T> float sampleKeys(float t, SamplerID sid, uint32_t& cursor, T& v0, T& v1) const {
+                if (isCompressed()) {
+                    return core::keyframe_decodeInterval(_compressed, sid, t, cursor, v0, v1);
                 }
-                i0 = i_idx_0;
-                i1 = i_idx_1;
-                return i_param;
+                const T* p0 = nullptr;
+                const T* p1 = nullptr;
+                float p = sampleTrack<T>(t, sid, cursor, &p0, &p1);
+                v0 = *p0;
+                v1 = *p1;
+                return p;
             }
 
-            template <typename T> float sampleTrack(float t, SamplerID sid, const T** v0, const T** v1) const {
+            template <typename T> float sampleTrack(float t, SamplerID sid, uint32_t& cursor, const T** v0, const T** v1) const {
                 const auto& s = _samplers[sid];
                 const auto& in_access = _accessors[s._input];
                 int32_t i0, i1;
-                float p = sampleInputTrack(t, in_access, i0, i1);
+                float p = sampleInputTrack(t, in_access, cursor, i0, i1);
                 // picoLogf("time = {} {} {}", i0, i1, p);
 
                 const auto& out_access = _accessors[s._output];
@@ -135,21 +136,17 @@ namespace graphics {
             }
 
             core::vec3 sampleVec3(float t, SamplerID sid) const {
-                const core::vec3* v0 = nullptr;
-                const core::vec3* v1 = nullptr;
-                float p = sampleTrack<core::vec3>(t, sid, &v0, &v1);
-
-                // picoLogf("pos = {} {} {} : {} {} {}", v0->x, v0->y, v0->z, v1->x, v1->y, v1->z);
-                return core::mix(*v0, *v1, p);
+                core::vec3 v0, v1;
+                uint32_t cursor = 0;
+                float p = sampleKeys<core::vec3>(t, sid, cursor, v0, v1);
+                return core::mix(v0, v1, p);
             }
 
             core::rotor3 sampleRotor3(float t, SamplerID sid) const {
-                const core::rotor3* v0 = nullptr;
-                const core::rotor3* v1 = nullptr;
-                float p = sampleTrack<core::rotor3>(t, sid, &v0, &v1);
-
-                // picoLogf("ori = {} {} {} {} : {} {} {} {}", v0->a, v0->b.xy, v0->b.xz, v0->b.yz, v1->a, v1->b.xy, v1->b.xz, v1->b.yz);
-                return core::slerp(*v0, *v1, p);
+                core::rotor3 v0, v1;
+                uint32_t cursor = 0;
+                float p = sampleKeys<core::rotor3>(t, sid, cursor, v0, v1);
+                return core::slerp(v0, v1, p);
             }
         };
 
@@ -171,6 +168,18 @@ namespace graphics {
 
         static std::pair<ClipData, ClipArray> createClipsFromGLTF(document::model::Model& model);
 
+        // Tolerances of the keyframe reduction, in the units of the channel path (radians for the rotations)
+        struct Compression {
+            float translationTolerance = 1e-4f;
+            float rotationTolerance = 1e-4f;
+            float scaleTolerance = 1e-4f;
+        };
+        // Compress the translation, rotation and scale tracks of the clips, see core/math/KeyframeCompression.h.
+        // The compressed clip data has no buffer nor accessors, the samplers of the other paths are left empty.
+        // When the compressed form is not smaller than the source, the source clip data is returned as is.
+        static ClipData compressClips(const ClipData& data, const ClipArray& clips, const Compression& compression);
+        static ClipData compressClips(const ClipData& data, const ClipArray& clips) { return compressClips(data, clips, Compression()); }
+
         struct ChannelState {
             ChannelState() {};
             int32_t targetId;
@@ -178,10 +187,26 @@ namespace graphics {
             union {
                 core::rotor3 rotation;
                 core::vec3   translation;
+                core::vec3   scale;
             };
         };
         struct ClipState {
             std::vector<ChannelState> channelStates;
+            std::vector<uint32_t> keyCursors; // per channel, the key found by the previous sample
+
+            // SoA scratch of animateClip, the keys of all the channels of a path
+            // are gathered in streams and interpolated in one batch
+            IDs translationChannels;
+            core::vec3_stream translations0, translations1, translations;
+            core::float_array translationParams;
+
+            IDs rotationChannels;
+            core::rotor3_stream rotations0, rotations1, rotations;
+            core::float_array rotationParams;
+
+            IDs scaleChannels;
+            core::vec3_stream scales0, scales1, scales;
+            core::float_array scaleParams;
         };
         struct AnimState {
             float time;
@@ -191,9 +216,32 @@ namespace graphics {
         static void animateClip(ClipState& state, AnimState& anim, const ClipArray& clips, const ClipData& data);
 
         static void animateTransformBranch(NodeID branchRoot, const ClipState& state, NodeStore& transforms);
+
+        // Flattened node hierarchy of the animated branch, every joint is listed after its parent
+        // so the world transforms of a pose are composed in one linear pass.
+        struct Skeleton {
+            IDs joints;      // flattened joint -> node offset in the branch
+            IDs parents;     // flattened joint -> flattened parent joint, -1 for the roots of the branch
+            IDs numChildren; // children of the joint inside the branch
+
+            bool empty() const { return joints.empty(); }
+        };
+        // nodeParents[n] is the offset of the parent of node n in the branch, INVALID_NODE_ID for the roots (see NodeBranchInit)
+        static Skeleton createSkeleton(const NodeIDs& nodeParents);
+
+        // Compose the world transforms of the branch from its local transforms, no lock taken.
+        // touched receives the joints with children attached from outside of the branch, returns their number.
+        static uint32_t poseTransformBranch(NodeID branchRoot, const Skeleton& skeleton, const NodeStore::NodeInfo* infos, NodeStore::NodeTransform* transforms, NodeID* touched);
+
+        // Write the channel states in the local transforms of the branch, no lock taken.
+        // touched receives the target node of every channel, returns the number of channels.
+        static uint32_t applyTransformBranch(NodeID branchRoot, const ClipState& state, NodeStore::NodeTransform* transforms, NodeID* touched);
     
         ClipData _data;
         ClipArray _clips;
+
+        // When defined, the anims of this key pose their whole branch instead of touching the animated nodes
+        Skeleton _skeleton;
     };
     using KeyPointer = std::shared_ptr<Key>;
 
@@ -204,6 +252,11 @@ namespace graphics {
         Key::ClipState  _state;
 
         void animate(NodeID rootNode, AnimateArgs& args);
+
+        // Batched evaluation, see AnimStore::animateBatch
+        void sample(NodeID rootNode, AnimateArgs& args);
+        uint32_t numTargets() const { return (uint32_t) std::max(_state.channelStates.size(), _key->_skeleton.joints.size()); }
+        uint32_t apply(NodeID rootNode, const NodeStore::NodeInfo* infos, NodeStore::NodeTransform* transforms, NodeID* touched, NodeStore::NodeRange& written) const;
     };
 }
 
@@ -225,6 +278,16 @@ namespace graphics {
         return const_cast<T&>(x).animate(node, args);
     }
 
+    // An anim type can opt in the batched evaluation of AnimStore::animateBatch:
+    // sample() runs on worker threads and must only touch the anim own state, once per anim however many
+    // nodes it drives, then apply() reads that state and writes the transforms of its target nodes in bulk,
+    // reports the range of the nodes it wrote and returns the number of touched nodes, at most numTargets().
+    template <typename T> concept BatchedAnim = requires(T & x, const T & cx, NodeID node, AnimArgs & args, const NodeStore::NodeInfo * infos, NodeStore::NodeTransform * transforms, NodeID * touched, NodeStore::NodeRange & written) {
+        x.sample(node, args);
+        { cx.numTargets() } -> std::convertible_to<uint32_t>;
+        { cx.apply(node, infos, transforms, touched, written) } -> std::convertible_to<uint32_t>;
+    };
+
     struct VISUALIZATION_API Anim {
     public:
         static Anim null;
@@ -249,6 +312,11 @@ namespace graphics {
             virtual ~Concept() = default;
             virtual void call(NodeID node, AnimArgs& args) const = 0;
 
+            virtual bool isBatched() const { return false; }
+            virtual void sample(NodeID /*node*/, AnimArgs& /*args*/) const {}
+            virtual uint32_t numTargets() const { return 0; }
+            virtual uint32_t apply(NodeID /*node*/, const NodeStore::NodeInfo* /*infos*/, NodeStore::NodeTransform* /*transforms*/, NodeID* /*touched*/, NodeStore::NodeRange& /*written*/) const { return 0; }
+
         };
         using AnimConcepts = std::vector<std::shared_ptr<const Concept>>;
      
@@ -259,6 +327,18 @@ namespace graphics {
             Model(T x) : _data(std::move(x)) {}
 
             void call(NodeID node, AnimArgs& args) const override { return Anim_call(_data, node, args); };
+
+            bool isBatched() const override { return BatchedAnim<T>; }
+            void sample([[maybe_unused]] NodeID node, [[maybe_unused]] AnimArgs& args) const override {
+                if constexpr (BatchedAnim<T>) const_cast<T&>(_data).sample(node, args);
+            }
+            uint32_t numTargets() const override {
+                if constexpr (BatchedAnim<T>) return _data.numTargets(); else return 0;
+            }
+            uint32_t apply([[maybe_unused]] NodeID node, [[maybe_unused]] const NodeStore::NodeInfo* infos,
+                           [[maybe_unused]] NodeStore::NodeTransform* transforms, [[maybe_unused]] NodeID* touched, [[maybe_unused]] NodeStore::NodeRange& written) const override {
+                if constexpr (BatchedAnim<T>) return _data.apply(node, infos, transforms, touched, written); else return 0;
+            }
         };
 
         std::shared_ptr<const Concept> _self;
@@ -370,6 +450,13 @@ namespace graphics {
             _animConcepts[id]->call(node, args);
         }
 
+        // Animate a list of anims, anims[i] drives the branch under nodes[i].
+        // The BatchedAnims are sampled in parallel on the shared thread pool and their local transforms
+        // written in bulk with a single lock of the node store, the other anims are called one by one.
+        // Two anims must not drive the same node, an anim can drive several branches (the instances of a model):
+        // it is sampled once then applied to each of its nodes.
+        void animateBatch(const AnimIDs& anims, const NodeIDs& nodes, NodeStore& transforms, AnimArgs& args);
+
     public:
         // gpu api
         inline BufferPointer getGPUBuffer() const { return _animInfos.gpu_buffer(); }
@@ -125,7 +125,7 @@ float Camera::getFov(bool vertical) const {
     return fov;
 }
 float Camera::getFovDeg(bool vertical) const {
-    const float radToDeg = 180.f / std::acosf(-1);
+    const float radToDeg = 180.f / std::acos(-1.0f);
     return radToDeg * getFov(vertical);
 }
 
@@ -409,6 +409,6 @@ CameraPointer CameraStore::createCamera() {
 }
 
 
-void CameraStore::syncGPUBuffer(const BatchPointer& batch) {
-    _cameraStructBuffer.sync_gpu_from_cpu(batch);
+void CameraStore::syncGPUBuffer(const BatchPointer& batch, UploadRing* ring) {
+    _cameraStructBuffer.sync_gpu_from_cpu(batch, ring);
 }
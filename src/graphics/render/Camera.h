@@ -169,6 +169,6 @@ namespace graphics {
         inline CameraPointer getCamera(CameraID index) const { return _cameras[index].lock(); }
 
         inline BufferPointer getGPUBuffer() const { return _cameraStructBuffer.gpu_buffer(); }
-        void syncGPUBuffer(const BatchPointer& batch);
+        void syncGPUBuffer(const BatchPointer& batch, UploadRing* ring = nullptr);
     };
 }
@@ -38,7 +38,8 @@ namespace graphics {
         _drawInfos.reserve(device, capacity);
     }
 
-    DrawID DrawStore::allocate(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw) {
+    DrawID DrawStore::allocate(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw, DrawStateKey stateKey, DrawInstancesCallback instancesDrawcall,
+        DrawPrepareCallback preparecall) {
         auto [new_id, recycle] = _indexTable.allocate();
 
         //auto bound = draw.getBound();
@@ -50,18 +51,25 @@ namespace graphics {
         if (recycle) {
             _drawcalls[new_id] = drawcall;
             _drawConcepts[new_id] = draw._self;
+            _stateKeys[new_id] = stateKey;
+            _instancesDrawcalls[new_id] = instancesDrawcall;
+            _preparecalls[new_id] = preparecall;
         }
         else {
             _drawcalls.emplace_back(drawcall);
             _drawConcepts.emplace_back(draw._self);
+            _stateKeys.emplace_back(stateKey);
+            _instancesDrawcalls.emplace_back(instancesDrawcall);
+            _preparecalls.emplace_back(preparecall);
         }
 
         return new_id;
     }
 
 
-    DrawID DrawStore::createDraw(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw) {
-        return allocate(drawcall, bound, draw);
+    DrawID DrawStore::createDraw(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw, DrawStateKey stateKey, DrawInstancesCallback instancesDrawcall,
+        DrawPrepareCallback preparecall) {
+        return allocate(drawcall, bound, draw, stateKey, instancesDrawcall, preparecall);
     }
 
     void DrawStore::free(DrawID id) {
@@ -71,6 +79,9 @@ namespace graphics {
             _touchedElements.push_back(id);
             _drawcalls[id] = nullptr;
             _drawConcepts[id].reset();
+            _stateKeys[id] = UNSORTED_DRAW_STATE_KEY;
+            _instancesDrawcalls[id] = nullptr;
+            _preparecalls[id] = nullptr;
         }
     }
 
@@ -131,14 +142,9 @@ namespace graphics {
         }
     }
 
-    void DrawStore::syncGPUBuffer(const BatchPointer& batch) {
-        // Clean the touched elements
-        std::sort(_touchedElements.begin(), _touchedElements.end());
-        auto newEnd = std::unique(_touchedElements.begin(), _touchedElements.end());
-        if (newEnd != _touchedElements.end()) _touchedElements.erase(newEnd);
-
-        // Sync the gpu buffer version
-        _drawInfos.sync_gpu_from_cpu(batch, _touchedElements);
+    void DrawStore::syncGPUBuffer(const BatchPointer& batch, UploadRing* ring) {
+        // Sync the pages of the touched elements, in any order
+        _drawInfos.sync_gpu_from_cpu(batch, _touchedElements, ring);
 
         // Start fresh
         _touchedElements.clear();
@@ -47,8 +47,34 @@ namespace graphics {
         const NodeID node,
         RenderArgs& args)>;
 
+    // Draw numInstances instances in one drawcall, the node of each instance is read by the shader
+    // from the instance buffer of the viewport at [firstInstance, firstInstance + numInstances)
+    using DrawInstancesCallback = std::function<void(
+        uint32_t firstInstance,
+        uint32_t numInstances,
+        RenderArgs& args)>;
+
+    // Record what the draw needs before the scene pass (the lazy uploads of its resources)
+    // and update its cpu state for the frame, the node transforms are up to date.
+    // Called once per frame for each draw of the render queue, serially and in queue order,
+    // before the drawcalls are recorded concurrently.
+    using DrawPrepareCallback = std::function<void(
+        RenderArgs& args)>;
+
     using DrawBound = core::aabox3;
 
+    // Key of the state (pipeline) bound by a drawcall, the render queue sorts the drawcalls with it.
+    // 0 is for the drawables not sorted, issued after the sorted ones in item order.
+    using DrawStateKey = uint16_t;
+    static const DrawStateKey UNSORTED_DRAW_STATE_KEY = 0;
+
+    // A non zero key for a state object (the pipeline)
+    inline DrawStateKey makeDrawStateKey(const void* state) {
+        auto h = (uint64_t) (uintptr_t) state * 0x9E3779B97F4A7C15ull;
+        auto key = (DrawStateKey) (h >> 48);
+        return (key == UNSORTED_DRAW_STATE_KEY ? 1 : key);
+    }
+
 
     // 
     // Draw class
@@ -59,6 +85,29 @@ namespace graphics {
     template <typename T> DrawObjectCallback drawable_getDrawcall(const T& x) {
         return x.getDrawcall();
     }
+    template <typename T> DrawStateKey drawable_getStateKey(const T& x) {
+        if constexpr (requires { x.getStateKey(); }) {
+            return x.getStateKey();
+        } else {
+            return UNSORTED_DRAW_STATE_KEY;
+        }
+    }
+
+    template <typename T> DrawInstancesCallback drawable_getInstancesDrawcall(const T& x) {
+        if constexpr (requires { x.getInstancesDrawcall(); }) {
+            return x.getInstancesDrawcall();
+        } else {
+            return nullptr;
+        }
+    }
+
+    template <typename T> DrawPrepareCallback drawable_getPreparecall(const T& x) {
+        if constexpr (requires { x.getPreparecall(); }) {
+            return x.getPreparecall();
+        } else {
+            return nullptr;
+        }
+    }
 
     struct VISUALIZATION_API Draw {
     public:
@@ -68,6 +117,9 @@ namespace graphics {
         DrawID id() const { return _self->_id; }
         DrawBound getBound() const { return _self->getBound(); }
         DrawObjectCallback getDrawcall() const { return _self->getDrawcall(); }
+        DrawStateKey getStateKey() const { return _self->getStateKey(); }
+        DrawInstancesCallback getInstancesDrawcall() const { return _self->getInstancesDrawcall(); }
+        DrawPrepareCallback getPreparecall() const { return _self->getPreparecall(); }
 
     private:
         friend class DrawStore;
@@ -86,6 +138,9 @@ namespace graphics {
 
             virtual DrawBound getBound() const = 0;
             virtual DrawObjectCallback getDrawcall() const = 0;
+            virtual DrawStateKey getStateKey() const = 0;
+            virtual DrawInstancesCallback getInstancesDrawcall() const = 0;
+            virtual DrawPrepareCallback getPreparecall() const = 0;
 
         };
         using DrawConcepts = std::vector<std::shared_ptr<const Concept>>;
@@ -98,6 +153,9 @@ namespace graphics {
 
             DrawBound getBound() const override { return drawable_getBound(_data); }
             DrawObjectCallback getDrawcall() const override { return drawable_getDrawcall(_data); }
+            DrawStateKey getStateKey() const override { return drawable_getStateKey(_data); }
+            DrawInstancesCallback getInstancesDrawcall() const override { return drawable_getInstancesDrawcall(_data); }
+            DrawPrepareCallback getPreparecall() const override { return drawable_getPreparecall(_data); }
         };
 
         std::shared_ptr<const Concept> _self;
@@ -136,7 +194,8 @@ namespace graphics {
         using DrawInfos = DrawInfoStructBuffer::Array;
 
     private:
-        DrawID allocate(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw);
+        DrawID allocate(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw, DrawStateKey stateKey, DrawInstancesCallback instancesDrawcall,
+            DrawPrepareCallback preparecall);
 
         core::IndexTable _indexTable;
         mutable DrawInfoStructBuffer _drawInfos;
@@ -166,6 +225,14 @@ namespace graphics {
         using Drawcalls = std::vector< DrawObjectCallback >;
         mutable Drawcalls _drawcalls;
 
+        std::vector<DrawStateKey> _stateKeys;
+
+        using InstancesDrawcalls = std::vector< DrawInstancesCallback >;
+        InstancesDrawcalls _instancesDrawcalls;
+
+        using Preparecalls = std::vector< DrawPrepareCallback >;
+        Preparecalls _preparecalls;
+
         struct DefaultModel : Draw::Concept {
             DefaultModel(DrawStore* store) : Draw::Concept(), _store(store) {}
 
@@ -173,6 +240,9 @@ namespace graphics {
 
             DrawBound getBound() const override { return _store->getDrawBound(_id); }
             DrawObjectCallback getDrawcall() const override { return _store->getDrawcall(_id); }
+            DrawStateKey getStateKey() const override { return _store->getStateKey(_id); }
+            DrawInstancesCallback getInstancesDrawcall() const override { return _store->getInstancesDrawcall(_id); }
+            DrawPrepareCallback getPreparecall() const override { return _store->getPreparecall(_id); }
         };
 
         Draw::DrawConcepts _drawConcepts;
@@ -182,11 +252,12 @@ namespace graphics {
         template <typename T>
         Draw createDraw(T x) {
             auto draw = Draw(std::move(x));
-            draw._self->_id = createDraw(draw.getDrawcall(), draw.getBound(), draw);
+            draw._self->_id = createDraw(draw.getDrawcall(), draw.getBound(), draw, draw.getStateKey(), draw.getInstancesDrawcall(), draw.getPreparecall());
             return draw;
         }
 
-        DrawID createDraw(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw = Draw::null);
+        DrawID createDraw(DrawObjectCallback drawcall, const DrawBound& bound, const Draw& draw = Draw::null, DrawStateKey stateKey = UNSORTED_DRAW_STATE_KEY,
+            DrawInstancesCallback instancesDrawcall = nullptr, DrawPrepareCallback preparecall = nullptr);
         void free(DrawID id);
 
         int32_t reference(DrawID id);
@@ -205,19 +276,26 @@ namespace graphics {
             return *i;
         }
 
-        // Access the drawbounds by reference and avoid any copy of the lambda
-
-        inline const DrawBound& getDrawBound(DrawID id) const { return getDrawInfo(id)._local_box; }
+        // The drawbound is copied out of the DrawInfo read under the lock
+        inline DrawBound getDrawBound(DrawID id) const { return getDrawInfo(id)._local_box; }
 
         // Access the drawcalls by reference and avoid any copy of the lambda
         // THis should be called from a critical section during the rendering pass
         inline const DrawObjectCallback& getDrawcall(DrawID id) const { return _drawcalls[id]; }
 
+        inline DrawStateKey getStateKey(DrawID id) const { return _stateKeys[id]; }
+
+        // The instanced drawcall of the draw, empty if the draw is not instanced
+        inline const DrawInstancesCallback& getInstancesDrawcall(DrawID id) const { return _instancesDrawcalls[id]; }
+
+        // The prepare call of the draw, empty if the draw has nothing to record before the pass
+        inline const DrawPrepareCallback& getPreparecall(DrawID id) const { return _preparecalls[id]; }
+
 
     public:
         // gpu api
         inline BufferPointer getGPUBuffer() const { return _drawInfos.gpu_buffer(); }
-        void syncGPUBuffer(const BatchPointer& batch);
+        void syncGPUBuffer(const BatchPointer& batch, UploadRing* ring = nullptr);
     };
 
     using DrawInfo = DrawStore::DrawInfo;
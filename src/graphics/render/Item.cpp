@@ -47,6 +47,8 @@ namespace graphics {
     ItemID ItemStore::allocate(const ItemInit& init) {
         auto [new_id, recycle] = _indexTable.allocate();
         _itemNames.resize(_indexTable.getNumAllocatedElements());
+        _localBounds.resize(_indexTable.getNumAllocatedElements());
+        _hasLocalBound.resize(_indexTable.getNumAllocatedElements(), 0);
 
         ItemInfo info = { init.node, (uint16_t) init.draw, (uint16_t) init.anim, init.group, IS_VISIBLE };
         _itemInfos.allocate_element(new_id, &info);
@@ -54,6 +56,7 @@ namespace graphics {
         
         // also add the name in the name table:
         _itemNames[new_id] = init.name;
+        _hasLocalBound[new_id] = 0;
 
         return new_id;
     }
@@ -68,6 +71,7 @@ namespace graphics {
             _itemInfos.set_element(index, nullptr);
             _touchedElements.push_back(index);
             _itemNames[index].clear();
+            _hasLocalBound[index] = 0;
         }
     }
 
@@ -133,12 +137,43 @@ namespace graphics {
     core::aabox3 ItemStore::fetchWorldBound(ItemID id) const {
         auto [info, l] = _itemInfos.read(id);
         if ((info->_nodeID != INVALID_NODE_ID) && (info->_drawID != INVALID_DRAW_ID)) {
-            return core::aabox_transformFrom(_scene->_nodes.getNodeTransform(info->_nodeID).world, _scene->_drawables.getDrawBound(info->_drawID));
+            core::aabox3 localBound = (_hasLocalBound[id] ? _localBounds[id] : _scene->_drawables.getDrawBound(info->_drawID));
+            return core::aabox_transformFrom(_scene->_nodes.getNodeTransform(info->_nodeID).world, localBound);
         } else {
             return core::aabox3();
         }
     }
 
+    void ItemStore::setLocalBound(ItemID id, const core::aabox3& bound) {
+        auto [info, l] = _itemInfos.read(id);
+        _localBounds[id] = bound;
+        _hasLocalBound[id] = 1;
+    }
+
+    void ItemStore::resetLocalBound(ItemID id) {
+        auto [info, l] = _itemInfos.read(id);
+        _hasLocalBound[id] = 0;
+    }
+
+    std::vector<core::aabox3> ItemStore::fetchLocalBounds() const {
+        auto drawInfos = _scene->_drawables.fetchDrawInfos();
+
+        // lock the item store info array as a whole
+        // so we can use the unsafe data accessor in the loop
+        auto [begin_info, l] = _itemInfos.read(0);
+        auto itemCount = numAllocatedItems();
+        std::vector<core::aabox3> bounds(itemCount, core::aabox3(core::vec3(0.0f), core::vec3(0.0f)));
+        for (ItemID i = 0; i < itemCount; ++i) {
+            const auto* info = begin_info + i;
+            if (_hasLocalBound[i]) {
+                bounds[i] = _localBounds[i];
+            } else if (info->isValid() && info->_drawID != INVALID_DRAW_ID) {
+                bounds[i] = drawInfos[info->_drawID]._local_box;
+            }
+        }
+        return bounds;
+    }
+
     ItemIDs ItemStore::fetchItemGroup(ItemID groupID) const {
         ItemIDs itemGroup;
         if (groupID != INVALID_ITEM_ID) {
@@ -157,14 +192,9 @@ namespace graphics {
         return itemGroup;
     }
 
-    void ItemStore::syncGPUBuffer(const BatchPointer& batch) {
-        // Clean the touched elements
-        std::sort(_touchedElements.begin(), _touchedElements.end());
-        auto newEnd = std::unique(_touchedElements.begin(), _touchedElements.end());
-        if (newEnd != _touchedElements.end()) _touchedElements.erase(newEnd);
-
-        // Sync the gpu buffer version
-        _itemInfos.sync_gpu_from_cpu(batch, _touchedElements);
+    void ItemStore::syncGPUBuffer(const BatchPointer& batch, UploadRing* ring) {
+        // Sync the pages of the touched elements, in any order
+        _itemInfos.sync_gpu_from_cpu(batch, _touchedElements, ring);
 
         // Start fresh
         _touchedElements.clear();
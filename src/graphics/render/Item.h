@@ -104,6 +104,10 @@ namespace graphics {
 
         ItemNames _itemNames;
 
+        // Local bounds set on the items in place of the bound of their draw, cpu side only
+        std::vector<core::aabox3> _localBounds;
+        std::vector<uint8_t> _hasLocalBound;
+
         const Scene* _scene = nullptr;
 
         using ReadLock = std::pair< const ItemInfo*, std::lock_guard<std::mutex>>;
@@ -228,6 +232,14 @@ namespace graphics {
 
         core::aabox3 fetchWorldBound(ItemID id) const;
 
+        // The bound of an item in its node space is the bound of its draw, unless a local bound is set on the item:
+        // the draw is shared by items of different shapes, the parts of a skinned model in the pose of each instance.
+        // The drawable owning the item updates it every frame, the bound is not uploaded to the gpu.
+        void setLocalBound(ItemID id, const core::aabox3& bound);
+        void resetLocalBound(ItemID id);
+        // The local bound of every item, the bound of its draw when none is set, empty for the items without draw
+        std::vector<core::aabox3> fetchLocalBounds() const;
+
         ItemIDs fetchItemGroup(ItemID ownerID) const;
 
         struct ItemAccessor {
@@ -243,7 +255,7 @@ namespace graphics {
     public:
         // gpu api
         inline BufferPointer getGPUBuffer() const { return _itemInfos.gpu_buffer(); }
-        void syncGPUBuffer(const BatchPointer& batch);
+        void syncGPUBuffer(const BatchPointer& batch, UploadRing* ring = nullptr);
     };
 
     using Item = ItemStore::Item;
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <vector>
+#include <cstring>
 
 #include <core/math/Math3D.h>
 #include "gpu/StreamLayout.h"
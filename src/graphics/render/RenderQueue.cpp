@@ -0,0 +1,557 @@
+// RenderQueue.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <sstream>
+
+#include <core/stl/RadixSort.h>
+
+#include "Scene.h"
+#include "Camera.h"
+
+using namespace graphics;
+
+std::string RenderQueueStats::toString() const {
+    std::ostringstream s;
+    s << "entries " << numEntries << " (" << numSorted << " sorted, " << numStateItems << " state items)"
+      << " | state changes " << numStateChanges << " (" << numUnsortedStateChanges << " in item order)"
+      << " | pipeline changes " << numPipelineChanges
+      << " | drawcalls " << numDrawcalls << " (" << numInstancedDraws << " instanced x" << numInstances << ")"
+      << " | build " << buildMs << " ms | sort " << sortMs << " ms";
+    return s.str();
+}
+
+void RenderQueue::build(const Scene& scene, const CameraPointer& camera, const ItemInfos& items, bool sorted) {
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+
+    _stats = RenderQueueStats();
+    _keys.clear();
+    _items.clear();
+    _depths.clear();
+    _instanceNodes.clear();
+
+    const auto& drawables = scene._drawables;
+    uint32_t numItems = (uint32_t) items.size();
+
+    auto isDrawn = [&](const ItemInfo& info) {
+        return info.isValid() && info.isVisible() && info.isDraw();
+    };
+    auto isSortedDraw = [&](DrawID draw) {
+        return drawables.getStateKey(draw) != UNSORTED_DRAW_STATE_KEY;
+    };
+    // An item is sorted if its draw declares a state key, and the draw of its group too
+    auto isSorted = [&](const ItemInfo& info) {
+        if (!sorted || !isSortedDraw(info._drawID)) {
+            return false;
+        }
+        if (info.isGrouped()) {
+            if (info._groupID >= numItems) {
+                return false;
+            }
+            const auto& group = items[info._groupID];
+            return group.isValid() && group.isDraw() && isSortedDraw(group._drawID);
+        }
+        return true;
+    };
+
+    // The group items of the sorted items are not issued on their own, they bind the state of their parts
+    _isStateItem.assign(numItems, 0);
+    for (ItemID id = 0; id < numItems; ++id) {
+        const auto& info = items[id];
+        if (isDrawn(info) && info.isGrouped() && isSorted(info)) {
+            _isStateItem[info._groupID] = 1;
+        }
+    }
+
+    // Collect the entries and their view depth
+    bool depthSorted = sorted && _depthSorting && camera;
+    core::vec3 eye = (depthSorted ? camera->getEye() : core::vec3());
+    core::vec3 front = (depthSorted ? camera->getFront() : core::vec3());
+    float minDepth = FLT_MAX;
+    float maxDepth = -FLT_MAX;
+    auto collect = [&](const NodeTransform* transforms) {
+        for (ItemID id = 0; id < numItems; ++id) {
+            const auto& info = items[id];
+            if (!isDrawn(info)) {
+                continue;
+            }
+            if (_isStateItem[id]) {
+                _stats.numStateItems++;
+                continue;
+            }
+            float depth = 0.0f;
+            if (transforms && info.hasNode() && isSorted(info)) {
+                depth = core::dot(transforms[info._nodeID].world.w() - eye, front);
+                minDepth = std::min(minDepth, depth);
+                maxDepth = std::max(maxDepth, depth);
+            }
+            _items.emplace_back(id);
+            _depths.emplace_back(depth);
+        }
+    };
+    if (depthSorted) {
+        scene._nodes.readNodeTransforms(collect);
+    } else {
+        collect(nullptr);
+    }
+
+    // Make the keys
+    uint32_t numEntries = (uint32_t) _items.size();
+    float depthScale = (maxDepth > minDepth ? float(DEPTH_MAX) / (maxDepth - minDepth) : 0.0f);
+    _keys.resize(numEntries);
+    for (uint32_t e = 0; e < numEntries; ++e) {
+        const auto& info = items[_items[e]];
+        if (!isSorted(info)) {
+            _keys[e] = (uint64_t) UNSORTED_PASS << PASS_SHIFT;
+            continue;
+        }
+        DrawID stateDraw = (info.isGrouped() ? items[info._groupID]._drawID : info._drawID);
+        uint64_t depthBucket = (uint64_t) std::clamp((_depths[e] - minDepth) * depthScale, 0.0f, float(DEPTH_MAX));
+        _keys[e] = ((uint64_t) SORTED_PASS << PASS_SHIFT)
+            | ((uint64_t) drawables.getStateKey(stateDraw) << STATE_KEY_SHIFT)
+            | ((uint64_t) (stateDraw & 0xFFFF) << STATE_DRAW_SHIFT)
+            | ((uint64_t) (info._drawID & 0xFFFF) << DRAW_SHIFT)
+            | (depthBucket << DEPTH_SHIFT);
+        _stats.numSorted++;
+    }
+    auto keysEnd = clock::now();
+    _stats.buildMs = std::chrono::duration<double, std::milli>(keysEnd - start).count();
+
+    if (_stats.numSorted) {
+        core::radix_sort(_keys, _items, 64);
+    }
+    _stats.sortMs = std::chrono::duration<double, std::milli>(clock::now() - keysEnd).count();
+
+    if (_instancing) {
+        _instanceNodes.resize(numEntries);
+        for (uint32_t e = 0; e < numEntries; ++e) {
+            _instanceNodes[e] = items[_items[e]]._nodeID;
+        }
+    }
+
+    // Count the state changes of the queue order, and of the item order for reference:
+    // in item order every group item and every sorted item without group binds its state
+    _stats.numEntries = numEntries;
+    _stats.numUnsortedStateChanges = _stats.numStateItems;
+    DrawID boundStateDraw = INVALID_DRAW_ID;
+    uint64_t boundStateKey = 0;
+    for (uint32_t e = 0; e < numEntries; ++e) {
+        uint32_t last = instancesEnd(scene, items, e, numEntries);
+        if (last > e) {
+            _stats.numInstancedDraws++;
+            _stats.numInstances += last - e;
+        }
+        _stats.numDrawcalls++;
+
+        if ((_keys[e] >> PASS_SHIFT) != SORTED_PASS) {
+            boundStateDraw = INVALID_DRAW_ID;
+            continue;
+        }
+        const auto& info = items[_items[e]];
+        uint64_t stateKey = (_keys[e] >> STATE_KEY_SHIFT) & 0xFFFF;
+        if (stateKey != boundStateKey) {
+            _stats.numPipelineChanges++;
+            boundStateKey = stateKey;
+        }
+        if (info.isGrouped()) {
+            DrawID stateDraw = items[info._groupID]._drawID;
+            if (stateDraw != boundStateDraw) {
+                _stats.numStateChanges++;
+                boundStateDraw = stateDraw;
+            }
+        } else {
+            _stats.numStateChanges++;
+            _stats.numUnsortedStateChanges++;
+            boundStateDraw = INVALID_DRAW_ID;
+        }
+        if (last > e) {
+            e = last - 1; // the instances share the state of the first one
+        }
+    }
+}
+
+uint32_t RenderQueue::instancesEnd(const Scene& scene, const ItemInfos& items, uint32_t e, uint32_t end) const {
+    // Only the grouped items are instanced, the group drawcall binds the state of all the instances
+    if (!_instancing || (_keys[e] >> PASS_SHIFT) != SORTED_PASS) {
+        return e;
+    }
+    const auto& info = items[_items[e]];
+    if (!info.isGrouped() || !scene._drawables.getInstancesDrawcall(info._drawID)) {
+        return e;
+    }
+    uint64_t run = _keys[e] >> DRAW_SHIFT;
+    uint32_t last = e + 1;
+    while (last < end && (_keys[last] >> DRAW_SHIFT) == run && items[_items[last]]._drawID == info._drawID) {
+        ++last;
+    }
+    return (last - e >= MIN_INSTANCES ? last : e);
+}
+
+void RenderQueue::prepare(const Scene& scene, const ItemInfos& items, RenderArgs& args) {
+    const auto& drawables = scene._drawables;
+    _isPrepared.assign(drawables.numAllocatedDraws(), 0);
+    auto prepareDraw = [&](DrawID draw) {
+        if (_isPrepared[draw]) {
+            return;
+        }
+        _isPrepared[draw] = 1;
+        if (const auto& preparecall = drawables.getPreparecall(draw)) {
+            preparecall(args);
+        }
+    };
+    for (uint32_t e = 0; e < size(); ++e) {
+        const auto& info = items[_items[e]];
+        if (info.isGrouped()) {
+            prepareDraw(items[info._groupID]._drawID);
+        }
+        prepareDraw(info._drawID);
+    }
+}
+
+void RenderQueue::issue(const Scene& scene, const ItemInfos& items, uint32_t begin, uint32_t end, RenderArgs& args) const {
+    const auto& drawables = scene._drawables;
+    DrawID boundStateDraw = INVALID_DRAW_ID;
+    for (uint32_t e = begin; e < end; ++e) {
+        const auto& info = items[_items[e]];
+        uint32_t last = instancesEnd(scene, items, e, end);
+        if ((_keys[e] >> PASS_SHIFT) == SORTED_PASS && info.isGrouped()) {
+            const auto& group = items[info._groupID];
+            if (group._drawID != boundStateDraw) {
+                drawables.getDrawcall(group._drawID)(group._nodeID, args);
+                boundStateDraw = group._drawID;
+            }
+        } else {
+            // the drawcall binds its own state
+            boundStateDraw = INVALID_DRAW_ID;
+        }
+        if (last > e) {
+            drawables.getInstancesDrawcall(info._drawID)(e, last - e, args);
+            e = last - 1;
+        } else {
+            drawables.getDrawcall(info._drawID)(info._nodeID, args);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runRenderQueueTests() to validate the order of the queue
+// and the state drawcalls it issues, and runRenderQueueBenchmarks() to compare
+// the sorted and the item order submission of a 100k items scene,
+// and the instanced and the one by one submission of the model parts
+// -------------------------------------------------------------------------
+
+#include <cassert>
+
+#include <core/Log.h>
+
+#include "Viewport.h"
+#include "drawables/ModelDraw.h"
+#include "headless/HeadlessBackend.h"
+#include "headless/HeadlessTestScene.h"
+
+namespace {
+    using namespace graphics;
+
+    struct TraceEntry {
+        char draw;
+        NodeID node; // the first instance of an instanced drawcall
+        uint32_t numInstances{ 0 };
+    };
+    using Trace = std::vector<TraceEntry>;
+
+    // Every part drawcall ('a', 'b') must come after the state drawcall of its group ('A', 'B')
+    bool checkStates(const Trace& trace) {
+        char bound = 0;
+        for (const auto& t : trace) {
+            if (t.draw == 'A' || t.draw == 'B') {
+                bound = t.draw;
+            } else if ((t.draw == 'a' || t.draw == 'b') && bound != t.draw - 'a' + 'A') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t countDraws(const Trace& trace, char draw) {
+        return (uint32_t) std::count_if(trace.begin(), trace.end(), [draw](const TraceEntry& t) { return t.draw == draw; });
+    }
+}
+
+void runRenderQueueTests() {
+    using namespace graphics;
+    picoLog("RenderQueueTest: starting...");
+
+    // Two states 'A' and 'B' (the model root draws) with their parts 'a' and 'b', and an undeclared draw 'u'
+    const uint32_t numInstances = 4;
+    Trace trace;
+    auto device = Device::createDevice({ "Headless" });
+    auto scene = std::make_shared<Scene>(SceneInit{ device, 1000, 1000, 100, 10 });
+    auto camera = scene->createCamera();
+    camera->setEye(core::vec3(0.0f, 0.0f, 0.0f));
+    camera->setOrientationFromFrontUp(core::vec3(0.0f, 0.0f, -1.0f), core::vec3(0.0f, 1.0f, 0.0f));
+
+    int pipelineA = 0, pipelineB = 0;
+    auto makeDraw = [&](char name, DrawStateKey key) {
+        return scene->_drawables.createDraw([&trace, name](const NodeID node, RenderArgs& args) {
+            trace.push_back({ name, node });
+        }, DrawBound(), Draw::null, key);
+    };
+    DrawID stateA = makeDraw('A', makeDrawStateKey(&pipelineA));
+    DrawID stateB = makeDraw('B', makeDrawStateKey(&pipelineB));
+    DrawID partA = makeDraw('a', makeDrawStateKey(&pipelineA));
+    DrawID partB = makeDraw('b', makeDrawStateKey(&pipelineB));
+    DrawID unsorted = makeDraw('u', UNSORTED_DRAW_STATE_KEY);
+    assert(scene->_drawables.getStateKey(partA) != UNSORTED_DRAW_STATE_KEY && scene->_drawables.getStateKey(unsorted) == UNSORTED_DRAW_STATE_KEY);
+
+    // In item order the instances go from far to near
+    Trace itemOrder;
+    for (uint32_t i = 0; i < numInstances; ++i) {
+        float depth = 10.0f - float(i);
+        auto nodeA = scene->createNode({ ROOT_ID, core::translation(core::vec3(-1.0f, 0.0f, -depth)), "a" }).id();
+        auto nodeB = scene->createNode({ ROOT_ID, core::translation(core::vec3(1.0f, 0.0f, -depth)), "b" }).id();
+        auto nodeU = scene->createNode({ ROOT_ID, core::translation(core::vec3(0.0f, 0.0f, -depth)), "u" }).id();
+        auto groupA = scene->createItem({ nodeA, stateA }).id();
+        scene->createItem({ nodeA, partA, INVALID_ANIM_ID, groupA });
+        auto groupB = scene->createItem({ nodeB, stateB }).id();
+        scene->createItem({ nodeB, partB, INVALID_ANIM_ID, groupB });
+        scene->createItem({ nodeU, unsorted });
+        itemOrder.insert(itemOrder.end(), { { 'A', nodeA }, { 'a', nodeA }, { 'B', nodeB }, { 'b', nodeB }, { 'u', nodeU } });
+    }
+    auto itemInfos = scene->_items.fetchItemInfos();
+
+    // --- Test 1: the state drawcall is issued once per state, the parts follow front to back ---
+    {
+        RenderQueue queue;
+        queue.setDepthSorting(true);
+        queue.build(*scene, camera, itemInfos, true);
+        const auto& s = queue.stats();
+        assert(queue.size() == 3 * numInstances && s.numSorted == 2 * numInstances && s.numStateItems == 2 * numInstances);
+        assert(s.numStateChanges == 2 && s.numPipelineChanges == 2 && s.numUnsortedStateChanges == 2 * numInstances);
+
+        RenderArgs args;
+        trace.clear();
+        queue.issue(*scene, itemInfos, 0, queue.size(), args);
+        assert(trace.size() == 2 + 3 * numInstances);
+        assert(countDraws(trace, 'A') == 1 && countDraws(trace, 'B') == 1 && checkStates(trace));
+        for (uint32_t e = 1; e < 2 * numInstances + 2; ++e) {
+            if (trace[e].draw == trace[e - 1].draw) {
+                assert(trace[e].node < trace[e - 1].node); // the nearest instance was created last
+            }
+        }
+        picoLog("RenderQueueTest 1 passed: " + s.toString());
+    }
+
+    // --- Test 2: the undeclared draws and the unsorted queue keep the item order ---
+    {
+        RenderQueue queue;
+        RenderArgs args;
+        queue.build(*scene, camera, itemInfos, true);
+        trace.clear();
+        queue.issue(*scene, itemInfos, 0, queue.size(), args);
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            const auto& t = trace[trace.size() - numInstances + i];
+            assert(t.draw == 'u' && t.node == itemOrder[5 * i + 4].node);
+        }
+
+        queue.build(*scene, camera, itemInfos, false);
+        assert(queue.stats().numSorted == 0 && queue.stats().numStateItems == 0 && queue.size() == itemOrder.size());
+        trace.clear();
+        queue.issue(*scene, itemInfos, 0, queue.size(), args);
+        assert(trace.size() == itemOrder.size());
+        for (uint32_t i = 0; i < trace.size(); ++i) {
+            assert(trace[i].draw == itemOrder[i].draw && trace[i].node == itemOrder[i].node);
+        }
+        picoLog("RenderQueueTest 2 passed: undeclared draws and unsorted queue issued in item order");
+    }
+
+    // --- Test 3: every range binds the state of its first parts ---
+    {
+        RenderQueue queue;
+        RenderArgs args;
+        queue.build(*scene, camera, itemInfos, true);
+        trace.clear();
+        for (uint32_t e = 0; e < queue.size(); e += 3) {
+            queue.issue(*scene, itemInfos, e, std::min(e + 3, queue.size()), args);
+        }
+        assert(countDraws(trace, 'a') == numInstances && countDraws(trace, 'b') == numInstances && checkStates(trace));
+        picoLog("RenderQueueTest 3 passed: state rebound at the start of the ranges");
+    }
+
+    // --- Test 4: sorted and unsorted viewport frames draw the same, the sorted frame binds less ---
+    {
+        HeadlessTestScene t({ .modelFiles = { "../asset/gltf/Duck/Duck.gltf", "../asset/gltf/Duck/Duck.gltf" }, .numInstances = 32, .spreadInstances = true, .capacityPerInstance = 8 });
+        assert(t.models.size() == 2);
+        t.renderFrame(); // the uploads of the first frame
+
+        t.viewport->setSceneInstancing(false);
+        t.viewport->setSceneSorting(false);
+        t.renderFrame();
+        auto unsortedStats = t.lastFrameStats();
+
+        t.viewport->setSceneSorting(true);
+        t.renderFrame();
+        auto sortedStats = t.lastFrameStats();
+        const auto& queueStats = t.viewport->lastRenderQueueStats();
+
+        assert(sortedStats.numDraws == unsortedStats.numDraws && sortedStats.numPrimitives == unsortedStats.numPrimitives);
+        assert(sortedStats.numPushUniforms == unsortedStats.numPushUniforms);
+        assert(queueStats.numStateChanges == 2 && queueStats.numUnsortedStateChanges == 64);
+        assert(sortedStats.numDescriptorSetBinds < unsortedStats.numDescriptorSetBinds);
+        picoLog("RenderQueueTest 4 passed: descriptor set binds " + std::to_string(unsortedStats.numDescriptorSetBinds) + " -> " + std::to_string(sortedStats.numDescriptorSetBinds));
+    }
+
+    // --- Test 5: a run of the same part is issued as one instanced drawcall, the instance nodes in queue order ---
+    {
+        auto instancedScene = std::make_shared<Scene>(SceneInit{ device, 1000, 1000, 100, 10 });
+        DrawID state = instancedScene->_drawables.createDraw([&trace](const NodeID node, RenderArgs& args) {
+            trace.push_back({ 'A', node });
+        }, DrawBound(), Draw::null, makeDrawStateKey(&pipelineA));
+        DrawID part = instancedScene->_drawables.createDraw([&trace](const NodeID node, RenderArgs& args) {
+            trace.push_back({ 'a', node });
+        }, DrawBound(), Draw::null, makeDrawStateKey(&pipelineA), [&trace](uint32_t firstInstance, uint32_t numInstances, RenderArgs& args) {
+            trace.push_back({ 'i', firstInstance, numInstances });
+        });
+
+        NodeIDs nodes;
+        for (uint32_t i = 0; i < numInstances; ++i) {
+            auto node = instancedScene->createNode({ ROOT_ID, core::translation(core::vec3(0.0f, 0.0f, -1.0f - float(i))), "a" }).id();
+            auto group = instancedScene->createItem({ node, state }).id();
+            instancedScene->createItem({ node, part, INVALID_ANIM_ID, group });
+            nodes.emplace_back(node);
+        }
+        auto instancedInfos = instancedScene->_items.fetchItemInfos();
+
+        RenderQueue queue;
+        RenderArgs args;
+        queue.build(*instancedScene, camera, instancedInfos, true);
+        assert(queue.instanceNodes().empty() && queue.stats().numInstancedDraws == 0);
+
+        queue.setInstancing(true);
+        queue.build(*instancedScene, camera, instancedInfos, true);
+        const auto& s = queue.stats();
+        assert(s.numDrawcalls == 1 && s.numInstancedDraws == 1 && s.numInstances == numInstances);
+        assert(queue.instanceNodes() == nodes);
+        trace.clear();
+        queue.issue(*instancedScene, instancedInfos, 0, queue.size(), args);
+        assert(trace.size() == 2 && trace[0].draw == 'A' && trace[1].draw == 'i');
+        assert(trace[1].node == 0 && trace[1].numInstances == numInstances);
+
+        // The run is cut by the ranges, a single instance left goes through the plain drawcall
+        trace.clear();
+        queue.issue(*instancedScene, instancedInfos, 0, numInstances - 1, args);
+        queue.issue(*instancedScene, instancedInfos, numInstances - 1, numInstances, args);
+        assert(trace.size() == 4 && checkStates(trace));
+        assert(trace[1].draw == 'i' && trace[1].numInstances == numInstances - 1);
+        assert(trace[3].draw == 'a' && trace[3].node == nodes.back());
+        picoLog("RenderQueueTest 5 passed: " + s.toString());
+    }
+
+    // --- Test 6: the instanced viewport frame draws the same primitives with one draw per part ---
+    {
+        const uint32_t numDucks = 64;
+        HeadlessTestScene t({ .modelFiles = { "../asset/gltf/Duck/Duck.gltf" }, .numInstances = numDucks, .spreadInstances = true, .capacityPerInstance = 8 });
+        assert(t.models.size() == 1);
+        t.renderFrame();
+
+        t.viewport->setSceneInstancing(false);
+        t.renderFrame();
+        auto singleStats = t.lastFrameStats();
+
+        t.viewport->setSceneInstancing(true);
+        t.renderFrame();
+        auto instancedStats = t.lastFrameStats();
+
+        uint32_t numParts = (uint32_t) t.models[0]->_parts.size();
+        assert(singleStats.numDraws == numDucks * numParts && singleStats.numInstancedDraws == 0);
+        assert(instancedStats.numDraws == numParts && instancedStats.numInstancedDraws == numParts);
+        assert(instancedStats.numInstances == numDucks * numParts && instancedStats.numPushUniforms == numParts);
+        assert(instancedStats.numPrimitives == singleStats.numPrimitives);
+        picoLog("RenderQueueTest 6 passed: draws " + std::to_string(singleStats.numDraws) + " -> " + std::to_string(instancedStats.numDraws));
+    }
+
+    picoLog("RenderQueueTest: all tests passed");
+}
+
+void runRenderQueueBenchmarks() {
+    using namespace graphics;
+    using clock = std::chrono::high_resolution_clock;
+
+    // 25k ducks and 25k helmets interleaved: 100k items, half of them the model root items
+    const uint32_t numInstances = 25000;
+    const uint32_t numFrames = 10;
+    HeadlessTestScene t({ .modelFiles = { "../asset/gltf/Duck/Duck.gltf", "../asset/gltf/DamagedHelmet/DamagedHelmet.gltf" }, .numInstances = numInstances, .spreadInstances = true, .capacityPerInstance = 8 });
+    if (t.models.empty()) {
+        picoLog("RenderQueueBench: failed to load the models");
+        return;
+    }
+    t.renderFrame();
+
+    struct Mode {
+        const char* name;
+        bool sorted;
+        bool depthSorted;
+        bool instanced;
+    };
+    for (const auto& mode : { Mode{ "item order", false, false, false }, Mode{ "sorted", true, false, false },
+                              Mode{ "sorted + depth", true, true, false }, Mode{ "sorted + instanced", true, false, true } }) {
+        t.viewport->setSceneSorting(mode.sorted);
+        t.viewport->setSceneDepthSorting(mode.depthSorted);
+        t.viewport->setSceneInstancing(mode.instanced);
+        t.renderFrame();
+        auto start = clock::now();
+        for (uint32_t i = 0; i < numFrames; ++i) {
+            t.renderFrame();
+        }
+        double frameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numFrames;
+        const auto& s = t.lastFrameStats();
+        picoLogf("RenderQueueBench {} {} items: {:.3f} ms/frame | pipeline binds {} | descriptor set binds {} | draws {} | queue {}",
+            mode.name, t.scene->_items.numValidItems(), frameMs,
+            s.numPipelineBinds, s.numDescriptorSetBinds, s.numDraws, t.viewport->lastRenderQueueStats().toString());
+    }
+
+    // 1000 ducks and 1000 helmets, their parts drawn one by one or instanced
+    const uint32_t numModels = 1000;
+    HeadlessTestScene m({ .modelFiles = { "../asset/gltf/Duck/Duck.gltf", "../asset/gltf/DamagedHelmet/DamagedHelmet.gltf" }, .numInstances = numModels, .spreadInstances = true, .capacityPerInstance = 8 });
+    m.renderFrame();
+    for (bool instanced : { false, true }) {
+        m.viewport->setSceneInstancing(instanced);
+        m.renderFrame();
+        auto start = clock::now();
+        for (uint32_t i = 0; i < numFrames; ++i) {
+            m.renderFrame();
+        }
+        double frameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numFrames;
+        const auto& s = m.lastFrameStats();
+        picoLogf("RenderQueueBench {} 2x{} models: {:.3f} ms/frame | draws {} ({} instanced x{}) | push uniforms {} | prims {}",
+            (instanced ? "instanced" : "one by one"), numModels, frameMs,
+            s.numDraws, s.numInstancedDraws, s.numInstances, s.numPushUniforms, s.numPrimitives);
+    }
+}
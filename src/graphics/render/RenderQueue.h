@@ -0,0 +1,128 @@
+// RenderQueue.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+#include "render.h"
+#include "Item.h"
+#include "Draw.h"
+
+namespace graphics {
+
+    struct VISUALIZATION_API RenderQueueStats {
+        uint32_t numEntries{ 0 };               // visible draw items issued
+        uint32_t numSorted{ 0 };                // entries sorted by state
+        uint32_t numStateItems{ 0 };            // group items only issued to bind the state of their parts
+        uint32_t numStateChanges{ 0 };          // state drawcalls issued in queue order
+        uint32_t numUnsortedStateChanges{ 0 };  // state drawcalls the same items issue in item order
+        uint32_t numPipelineChanges{ 0 };       // state key changes in queue order
+        uint32_t numDrawcalls{ 0 };             // drawcalls issued for the entries, an instanced draw counts for one
+        uint32_t numInstancedDraws{ 0 };
+        uint32_t numInstances{ 0 };             // entries drawn by the instanced draws
+        double buildMs{ 0.0 };                  // keys and depths
+        double sortMs{ 0.0 };                   // radix sort
+
+        std::string toString() const;
+    };
+
+    // RenderQueue: the visible draw items of a frame in the order they are issued.
+    //
+    // Each item gets a 64 bits key, from msb to lsb:
+    //   pass        4 bits: SORTED_PASS for the drawables declaring a state key, UNSORTED_PASS for the others
+    //   state key  16 bits: the pipeline of the drawable (DrawStore::getStateKey)
+    //   state draw 16 bits: the draw binding the state, the group item's draw for the grouped items (ModelDraw parts)
+    //   draw       16 bits: the draw of the item
+    //   depth      12 bits: view depth bucket, front to back, when depth sorting is enabled
+    // and the keys are radix sorted every frame. The sort is stable, the unsorted pass keeps the item order.
+    //
+    // A grouped item of the sorted pass only does its part of the drawing, the drawcall of its group item binds the state.
+    // The group drawcall is issued when the state draw changes in the queue instead of once per group item.
+    //
+    // With instancing, the grouped items of the sorted pass sharing the same draw end up next to each other:
+    // a run of at least MIN_INSTANCES of them is issued as one instanced drawcall if the draw declares one.
+    // The node of every entry is in instanceNodes() in queue order, the caller uploads it for the shaders
+    // and the instanced drawcall of the run [e, e + n) gets firstInstance e.
+    class VISUALIZATION_API RenderQueue {
+    public:
+        static const uint32_t SORTED_PASS = 0;
+        static const uint32_t UNSORTED_PASS = 1;
+
+        static const uint32_t PASS_SHIFT = 60;
+        static const uint32_t STATE_KEY_SHIFT = 44;
+        static const uint32_t STATE_DRAW_SHIFT = 28;
+        static const uint32_t DRAW_SHIFT = 12;
+        static const uint32_t DEPTH_SHIFT = 0;
+        static const uint32_t DEPTH_MAX = 0xFFF;
+
+        static const uint32_t MIN_INSTANCES = 2;
+
+        // Depth sorting reads the world transform of every sorted item: on the cpu it costs more than the state sort,
+        // it pays off on the gpu with less overdraw of the opaque items. Off by default.
+        void setDepthSorting(bool enabled) { _depthSorting = enabled; }
+        bool isDepthSorting() const { return _depthSorting; }
+
+        // Issue the runs of the same draw as instanced drawcalls. Off by default.
+        void setInstancing(bool enabled) { _instancing = enabled; }
+        bool isInstancing() const { return _instancing; }
+
+        // Collect the visible draw items and sort them, if sorted is false the queue keeps the item order
+        void build(const Scene& scene, const CameraPointer& camera, const ItemInfos& items, bool sorted = true);
+
+        // Call the prepare call of every draw of the queue once into args.batch, the draws of the entries and the group draws binding their state.
+        // Serial and before issue(): what a draw records there is in the batch before any range uses it.
+        void prepare(const Scene& scene, const ItemInfos& items, RenderArgs& args);
+
+        // Issue the drawcalls of the entries [begin, end) into args.batch.
+        // A range starts with no state bound, it can be recorded independently of the other ranges.
+        void issue(const Scene& scene, const ItemInfos& items, uint32_t begin, uint32_t end, RenderArgs& args) const;
+
+        inline uint32_t size() const { return (uint32_t) _items.size(); }
+        inline ItemID item(uint32_t entry) const { return _items[entry]; }
+        inline uint64_t key(uint32_t entry) const { return _keys[entry]; }
+        inline const RenderQueueStats& stats() const { return _stats; }
+
+        // The node of every entry, empty if instancing is off
+        inline const NodeIDs& instanceNodes() const { return _instanceNodes; }
+
+    protected:
+        // End of the run of instances starting at entry e (and not after end), e if the entry is not drawn instanced
+        uint32_t instancesEnd(const Scene& scene, const ItemInfos& items, uint32_t e, uint32_t end) const;
+
+        std::vector<uint64_t> _keys;
+        std::vector<ItemID> _items;
+        std::vector<uint8_t> _isStateItem;
+        std::vector<float> _depths;
+        std::vector<uint8_t> _isPrepared; // per draw, cleared by prepare()
+        NodeIDs _instanceNodes;
+        RenderQueueStats _stats;
+        bool _depthSorting = false;
+        bool _instancing = false;
+    };
+}
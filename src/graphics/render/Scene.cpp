@@ -160,21 +160,31 @@ namespace graphics {
     void Scene::updateBounds() {
         auto itemInfos = _items.fetchItemInfos();
         auto nodeTransforms = _nodes.fetchNodeTransforms();
-        auto drawInfos = _drawables.fetchDrawInfos();
-
-        core::aabox3 b;
-        int i = 0;
-        for (const auto& info : itemInfos) {
+        auto itemBounds = _items.fetchLocalBounds();
+
+        // Gather the item world matrices and local boxes into streams and transform them in one batch
+        core::mat4x3_stream worlds;
+        core::aabox3_stream localBoxes;
+        worlds.resize((uint32_t) itemInfos.size());
+        localBoxes.resize((uint32_t) itemInfos.size());
+        uint32_t i = 0;
+        for (ItemID id = 0; id < (ItemID) itemInfos.size(); ++id) {
+            const auto& info = itemInfos[id];
             if (info._nodeID != INVALID_NODE_ID && info._drawID != INVALID_DRAW_ID) {
-                auto ibw = core::aabox_transformFrom(nodeTransforms[info._nodeID].world, drawInfos[info._drawID]._local_box);
-                if (i == 0) {
-                    b = ibw;
-                } else {
-                    b = core::aabox3::fromBound(b, ibw);
-                } 
+                worlds.set(i, nodeTransforms[info._nodeID].world);
+                localBoxes.set(i, itemBounds[id]);
                 i++;
             }
         }
+        worlds.resize(i);
+        localBoxes.resize(i);
+
+        core::aabox3_stream worldBoxes;
+        core::stream_aabox_transformFrom(worlds, localBoxes, worldBoxes);
+
+        core::aabox3 b;
+        core::stream_aabox_bound(worldBoxes, b);
+
         _bounds._midPos = b.center;
         _bounds._minPos = b.minPos();
         _bounds._maxPos = b.maxPos();
@@ -185,11 +195,11 @@ namespace graphics {
     }
 
 
-    void syncSceneResourcesForFrame(const ScenePointer& scene, const BatchPointer& batch) {
-        scene->_items.syncGPUBuffer(batch);
-        scene->_nodes.syncGPUBuffer(batch);
-        scene->_drawables.syncGPUBuffer(batch);
-        scene->_cameras.syncGPUBuffer(batch);
+    void syncSceneResourcesForFrame(const ScenePointer& scene, const BatchPointer& batch, UploadRing* ring) {
+        scene->_items.syncGPUBuffer(batch, ring);
+        scene->_nodes.syncGPUBuffer(batch, ring);
+        scene->_drawables.syncGPUBuffer(batch, ring);
+        scene->_cameras.syncGPUBuffer(batch, ring);
 
         scene->_sky->updateGPUData(); // arggg
 
@@ -132,5 +132,6 @@ namespace graphics {
     };
 
     // Standard function to synchronise all the gpu resources required by the scene for the frame being constructed
-    void syncSceneResourcesForFrame(const ScenePointer& scene, const BatchPointer& batch);
+    // The changes are staged in the upload ring of the frame when one is provided
+    void syncSceneResourcesForFrame(const ScenePointer& scene, const BatchPointer& batch, UploadRing* ring = nullptr);
 }
\ No newline at end of file
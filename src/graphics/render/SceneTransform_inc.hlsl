@@ -21,6 +21,17 @@ Transform node_getWorldTransform(int nodeID) {
 }
 
 
+//
+// Instance API
+// The node of every instance of the instanced draws of the frame
+//
+StructuredBuffer<uint>  instance_nodes : register(t22);
+
+int instance_getNodeID(int firstInstance, uint instanceID) {
+    return instance_nodes[firstInstance + instanceID];
+}
+
+
 //
 // Draw API
 //
@@ -0,0 +1,546 @@
+// TerrainLod.cpp
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "TerrainLod.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+#include <core/Job.h>
+
+namespace graphics {
+
+    namespace {
+        struct NodeCoord {
+            uint32_t level;
+            uint32_t x;
+            uint32_t y;
+        };
+
+        inline uint32_t divideUp(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+    }
+
+    uint32_t TerrainQuadtree::numNodesX(uint32_t level) const {
+        return std::max(1u, divideUp(std::max(1u, _width - 1), CHUNK_CELLS << level));
+    }
+    uint32_t TerrainQuadtree::numNodesY(uint32_t level) const {
+        return std::max(1u, divideUp(std::max(1u, _height - 1), CHUNK_CELLS << level));
+    }
+
+    void TerrainQuadtree::build(const document::Heightmap& heightmap, float heightScale) {
+        std::vector<float> heights;
+        heightmap.decode(heights);
+        build(heights.data(), heightmap.width(), heightmap.height(), heightmap.spacing(), heightScale);
+    }
+
+    void TerrainQuadtree::build(const float* heights, uint32_t width, uint32_t height, float spacing, float heightScale) {
+        _width = width;
+        _height = height;
+        _spacing = spacing;
+        _levelOffsets.clear();
+        _nodes.clear();
+        if (width == 0 || height == 0) {
+            return;
+        }
+
+        uint32_t lastX = width - 1;
+        uint32_t lastY = height - 1;
+        auto sampleHeight = [&](uint32_t x, uint32_t y) { return heightScale * heights[uint64_t(std::min(y, lastY)) * width + std::min(x, lastX)]; };
+
+        // Levels up to the one with a single node
+        uint32_t numNodes = 0;
+        for (uint32_t level = 0; ; ++level) {
+            _levelOffsets.push_back(numNodes);
+            numNodes += numNodesX(level) * numNodesY(level);
+            if (numNodesX(level) == 1 && numNodesY(level) == 1) break;
+        }
+        _nodes.resize(numNodes);
+
+        auto& pool = core::ThreadPool::shared();
+        for (uint32_t level = 0; level < numLevels(); ++level) {
+            uint32_t nodesX = numNodesX(level);
+            uint32_t nodesY = numNodesY(level);
+            uint32_t step = 1u << level;
+            uint32_t size = CHUNK_CELLS * step;
+
+            pool.parallel_for(nodesY, 1, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t ny = begin; ny < end; ++ny) {
+                    for (uint32_t nx = 0; nx < nodesX; ++nx) {
+                        Node& node = _nodes[_levelOffsets[level] + ny * nodesX + nx];
+                        uint32_t x0 = nx * size, x1 = std::min(x0 + size, lastX);
+                        uint32_t y0 = ny * size, y1 = std::min(y0 + size, lastY);
+
+                        if (level == 0) {
+                            node.minHeight = std::numeric_limits<float>::max();
+                            node.maxHeight = -std::numeric_limits<float>::max();
+                            for (uint32_t y = y0; y <= y1; ++y) {
+                                for (uint32_t x = x0; x <= x1; ++x) {
+                                    float h = sampleHeight(x, y);
+                                    node.minHeight = std::min(node.minHeight, h);
+                                    node.maxHeight = std::max(node.maxHeight, h);
+                                }
+                            }
+                            node.error = 0.0f;
+                            continue;
+                        }
+
+                        // Bound and error of the children, the children of the nodes on the border may not exist
+                        node.minHeight = std::numeric_limits<float>::max();
+                        node.maxHeight = -std::numeric_limits<float>::max();
+                        node.error = 0.0f;
+                        for (uint32_t c = 0; c < 4; ++c) {
+                            uint32_t cx = 2 * nx + (c & 1);
+                            uint32_t cy = 2 * ny + (c >> 1);
+                            if (cx >= numNodesX(level - 1) || cy >= numNodesY(level - 1)) continue;
+                            const auto& child = getNode(level - 1, cx, cy);
+                            node.minHeight = std::min(node.minHeight, child.minHeight);
+                            node.maxHeight = std::max(node.maxHeight, child.maxHeight);
+                            node.error = std::max(node.error, child.error);
+                        }
+
+                        // Distance of the samples to the chunk grid, triangulated along the (0,0)-(1,1) diagonal of the cells
+                        for (uint32_t y = y0; y <= y1; ++y) {
+                            uint32_t j = std::min((y - y0) / step, CHUNK_CELLS - 1);
+                            uint32_t gy0 = y0 + j * step, gy1 = std::min(gy0 + step, lastY);
+                            float v = (gy1 > gy0 ? float(y - gy0) / float(gy1 - gy0) : 0.0f);
+                            for (uint32_t x = x0; x <= x1; ++x) {
+                                uint32_t i = std::min((x - x0) / step, CHUNK_CELLS - 1);
+                                uint32_t gx0 = x0 + i * step, gx1 = std::min(gx0 + step, lastX);
+                                float u = (gx1 > gx0 ? float(x - gx0) / float(gx1 - gx0) : 0.0f);
+
+                                float h00 = sampleHeight(gx0, gy0);
+                                float h10 = sampleHeight(gx1, gy0);
+                                float h01 = sampleHeight(gx0, gy1);
+                                float h11 = sampleHeight(gx1, gy1);
+                                float h = (u >= v ? h00 + u * (h10 - h00) + v * (h11 - h10)
+                                                  : h00 + v * (h01 - h00) + u * (h11 - h01));
+                                node.error = std::max(node.error, fabsf(h - sampleHeight(x, y)));
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    core::aabox3 TerrainQuadtree::evalNodeBound(uint32_t level, uint32_t x, uint32_t y) const {
+        const auto& node = getNode(level, x, y);
+        uint32_t size = CHUNK_CELLS << level;
+        float x0 = float(std::min(x * size, _width - 1)), x1 = float(std::min((x + 1) * size, _width - 1));
+        float y0 = float(std::min(y * size, _height - 1)), y1 = float(std::min((y + 1) * size, _height - 1));
+        float ox = 0.5f * _width, oy = 0.5f * _height;
+        return core::aabox3::fromMinMax(
+            core::vec3((x0 - ox) * _spacing, node.minHeight, (y0 - oy) * _spacing),
+            core::vec3((x1 - ox) * _spacing, node.maxHeight, (y1 - oy) * _spacing));
+    }
+
+    void TerrainQuadtree::chunkSample(const Chunk& chunk, uint32_t i, uint32_t j, uint32_t& sx, uint32_t& sy) const {
+        uint32_t step = 1u << chunk.level;
+        sx = std::min(chunk.x * CHUNK_CELLS * step + i * step, _width - 1);
+        sy = std::min(chunk.y * CHUNK_CELLS * step + j * step, _height - 1);
+    }
+
+    void TerrainQuadtree::chunkIndices(uint8_t stitch, std::vector<uint32_t>& indices) {
+        const uint32_t numVerts = CHUNK_CELLS + 1;
+        auto vertex = [&](uint32_t i, uint32_t j) {
+            // collapse the odd vertices of the stitched edges on their previous even vertex
+            if (((stitch & STITCH_X_NEG) && i == 0) || ((stitch & STITCH_X_POS) && i == CHUNK_CELLS)) j &= ~1u;
+            if (((stitch & STITCH_Y_NEG) && j == 0) || ((stitch & STITCH_Y_POS) && j == CHUNK_CELLS)) i &= ~1u;
+            return j * numVerts + i;
+        };
+
+        indices.clear();
+        indices.reserve(CHUNK_CELLS * CHUNK_CELLS * 6);
+        auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+            if (a == b || b == c || c == a) return;
+            indices.push_back(a);
+            indices.push_back(b);
+            indices.push_back(c);
+        };
+        for (uint32_t j = 0; j < CHUNK_CELLS; ++j) {
+            for (uint32_t i = 0; i < CHUNK_CELLS; ++i) {
+                uint32_t v00 = vertex(i, j), v10 = vertex(i + 1, j), v01 = vertex(i, j + 1), v11 = vertex(i + 1, j + 1);
+                addTriangle(v00, v11, v10);
+                addTriangle(v00, v01, v11);
+            }
+        }
+    }
+
+    void TerrainQuadtree::select(const core::View& view, const core::Projection& projection, float viewportHeight, float maxPixelError, Chunks& chunks) const {
+        chunks.clear();
+        if (_nodes.empty()) {
+            return;
+        }
+        uint32_t topLevel = numLevels() - 1;
+        uint32_t gridX = numNodesX(0);
+        uint32_t gridY = numNodesY(0);
+
+        // Selected level of every level 0 cell
+        std::vector<uint8_t> levels(gridX * gridY, 0);
+        auto fill = [&](uint32_t level, uint32_t x, uint32_t y, uint8_t value) {
+            for (uint32_t cy = y << level; cy < std::min((y + 1) << level, gridY); ++cy) {
+                for (uint32_t cx = x << level; cx < std::min((x + 1) << level, gridX); ++cx) {
+                    levels[cy * gridX + cx] = value;
+                }
+            }
+        };
+
+        // Refine the chunks which error is visible from the eye
+        float pixelsPerError = viewportHeight / (2.0f * projection.fovHalfTan());
+        auto eye = view.eye();
+        std::vector<NodeCoord> stack{ { topLevel, 0, 0 } };
+        while (!stack.empty()) {
+            auto n = stack.back();
+            stack.pop_back();
+            bool refine = false;
+            if (n.level > 0) {
+                auto bound = evalNodeBound(n.level, n.x, n.y);
+                float distance = core::length(eye - core::clamp(eye, bound.minPos(), bound.maxPos()));
+                refine = getNode(n.level, n.x, n.y).error * pixelsPerError > maxPixelError * distance;
+            }
+            if (!refine) {
+                fill(n.level, n.x, n.y, (uint8_t) n.level);
+                continue;
+            }
+            for (uint32_t c = 0; c < 4; ++c) {
+                uint32_t cx = 2 * n.x + (c & 1);
+                uint32_t cy = 2 * n.y + (c >> 1);
+                if (cx < numNodesX(n.level - 1) && cy < numNodesY(n.level - 1)) {
+                    stack.push_back({ n.level - 1, cx, cy });
+                }
+            }
+        }
+
+        // Split the chunks more than one level coarser than a neighbor, until none is left
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t cy = 0; cy < gridY; ++cy) {
+                for (uint32_t cx = 0; cx < gridX; ++cx) {
+                    uint32_t level = levels[cy * gridX + cx];
+                    const int32_t neighbors[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+                    for (const auto& d : neighbors) {
+                        int32_t nx = int32_t(cx) + d[0], ny = int32_t(cy) + d[1];
+                        if (nx < 0 || ny < 0 || nx >= int32_t(gridX) || ny >= int32_t(gridY)) continue;
+                        uint32_t neighborLevel = levels[ny * gridX + nx];
+                        if (neighborLevel > level + 1) {
+                            fill(neighborLevel, uint32_t(nx) >> neighborLevel, uint32_t(ny) >> neighborLevel, uint8_t(neighborLevel - 1));
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Emit the chunks at their first cell, stitch the edges along a coarser neighbor
+        core::vec4 planes[6];
+        core::frustum_planes(view, projection, planes);
+        for (uint32_t cy = 0; cy < gridY; ++cy) {
+            for (uint32_t cx = 0; cx < gridX; ++cx) {
+                uint32_t level = levels[cy * gridX + cx];
+                uint32_t mask = (1u << level) - 1;
+                if ((cx & mask) || (cy & mask)) continue;
+
+                Chunk chunk{ (uint8_t) level, 0, (uint16_t) (cx >> level), (uint16_t) (cy >> level) };
+                uint32_t size = 1u << level;
+                auto coarser = [&](uint32_t x, uint32_t y) { return levels[y * gridX + x] == level + 1; };
+                if (cx > 0 && coarser(cx - 1, cy)) chunk.stitch |= STITCH_X_NEG;
+                if (cx + size < gridX && coarser(cx + size, cy)) chunk.stitch |= STITCH_X_POS;
+                if (cy > 0 && coarser(cx, cy - 1)) chunk.stitch |= STITCH_Y_NEG;
+                if (cy + size < gridY && coarser(cx, cy + size)) chunk.stitch |= STITCH_Y_POS;
+
+                auto bound = evalNodeBound(chunk.level, chunk.x, chunk.y);
+                bool outside = false;
+                for (const auto& p : planes) {
+                    core::vec3 n = p.xyz();
+                    core::vec3 farthest = bound.center + core::vec3(n.x >= 0.0f ? bound.half_size.x : -bound.half_size.x,
+                                                                    n.y >= 0.0f ? bound.half_size.y : -bound.half_size.y,
+                                                                    n.z >= 0.0f ? bound.half_size.z : -bound.half_size.z);
+                    outside |= (core::dot(n, farthest) + p.w < 0.0f);
+                }
+                if (!outside) {
+                    chunks.push_back(chunk);
+                }
+            }
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// Simple test — call runTerrainLodTests() to validate the quadtree errors and
+// the crack free selection, runTerrainLodBenchmarks() to measure the triangles
+// drawn against the pixel error on the DEM assets
+// -------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <core/Log.h>
+
+#include "Scene.h"
+#include "Camera.h"
+#include "drawables/HeightmapDraw.h"
+#include "headless/HeadlessBackend.h"
+#include "headless/HeadlessTestScene.h"
+
+using namespace graphics;
+
+namespace {
+    core::View makeTestView(const TerrainQuadtree& tree, float spacing, float elevation) {
+        // Above a corner of the map, looking at its center
+        core::View view;
+        core::vec3 eye(-0.5f * tree.width() * spacing, elevation, -0.5f * tree.height() * spacing);
+        view.setEye(eye);
+        view.setOrientationFromFrontUp(core::normalize(core::vec3(0.0f) - eye), core::vec3(0.0f, 1.0f, 0.0f));
+        return view;
+    }
+
+    core::Projection makeTestProjection() {
+        core::Projection projection;
+        projection.setFov(acosf(-1.0f) / 3.0f); // 60 deg
+        projection._persFar = 0.0f;
+        return projection;
+    }
+
+    // Count the triangles on every edge of the selected chunks, in heightmap samples.
+    // The terrain is watertight if every edge inside of the map is shared by exactly 2 triangles.
+    uint32_t countOpenEdges(const TerrainQuadtree& tree, const TerrainQuadtree::Chunks& chunks) {
+        std::map<std::pair<uint64_t, uint64_t>, uint32_t> edges;
+        std::vector<uint32_t> indices;
+        for (const auto& chunk : chunks) {
+            TerrainQuadtree::chunkIndices(chunk.stitch, indices);
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                uint64_t samples[3];
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t sx, sy;
+                    tree.chunkSample(chunk, indices[t + k] % (TerrainQuadtree::CHUNK_CELLS + 1), indices[t + k] / (TerrainQuadtree::CHUNK_CELLS + 1), sx, sy);
+                    samples[k] = (uint64_t(sy) << 32) | sx;
+                }
+                if (samples[0] == samples[1] || samples[1] == samples[2] || samples[2] == samples[0]) continue; // clamped on the map border
+                for (int k = 0; k < 3; ++k) {
+                    edges[std::minmax(samples[k], samples[(k + 1) % 3])]++;
+                }
+            }
+        }
+        auto onBorder = [&](uint64_t s) {
+            uint32_t x = uint32_t(s), y = uint32_t(s >> 32);
+            return x == 0 || y == 0 || x == tree.width() - 1 || y == tree.height() - 1;
+        };
+        uint32_t numOpen = 0;
+        for (const auto& [edge, count] : edges) {
+            bool border = onBorder(edge.first) && onBorder(edge.second) &&
+                (uint32_t(edge.first) == uint32_t(edge.second) || (edge.first >> 32) == (edge.second >> 32));
+            numOpen += (count != (border ? 1u : 2u));
+        }
+        return numOpen;
+    }
+
+    // Triangles drawn by the chunks, the ones collapsed by the clamp on the map border are left out
+    uint64_t countTriangles(const TerrainQuadtree& tree, const TerrainQuadtree::Chunks& chunks) {
+        const uint32_t numVerts = TerrainQuadtree::CHUNK_CELLS + 1;
+        std::vector<uint32_t> indices;
+        uint64_t total = 0;
+        for (const auto& chunk : chunks) {
+            TerrainQuadtree::chunkIndices(chunk.stitch, indices);
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                uint32_t sx[3], sy[3];
+                for (int k = 0; k < 3; ++k) {
+                    tree.chunkSample(chunk, indices[t + k] % numVerts, indices[t + k] / numVerts, sx[k], sy[k]);
+                }
+                total += ((int64_t(sx[1]) - sx[0]) * (int64_t(sy[2]) - sy[0]) != (int64_t(sx[2]) - sx[0]) * (int64_t(sy[1]) - sy[0]));
+            }
+        }
+        return total;
+    }
+}
+
+void runTerrainLodTests() {
+    picoLog("TerrainLodTest: starting...");
+
+    const uint32_t width = 300, height = 213;
+    const float spacing = 10.0f;
+    std::vector<float> heights(width * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            heights[y * width + x] = 200.0f * sinf(x * 0.03f) * cosf(y * 0.045f) + 15.0f * sinf(x * 0.4f + y * 0.3f);
+        }
+    }
+    TerrainQuadtree tree;
+    tree.build(heights.data(), width, height, spacing);
+
+    // --- Test 1: levels, bounds and monotonic errors ---
+    {
+        assert(tree.numLevels() == 5 && tree.numNodesX(0) == 10 && tree.numNodesY(0) == 7);
+        assert(tree.numNodesX(tree.numLevels() - 1) == 1 && tree.numNodesY(tree.numLevels() - 1) == 1);
+        const auto& root = tree.getNode(tree.numLevels() - 1, 0, 0);
+        float minHeight = *std::min_element(heights.begin(), heights.end());
+        float maxHeight = *std::max_element(heights.begin(), heights.end());
+        assert(root.minHeight == minHeight && root.maxHeight == maxHeight);
+        for (uint32_t level = 1; level < tree.numLevels(); ++level) {
+            for (uint32_t y = 0; y < tree.numNodesY(level); ++y) {
+                for (uint32_t x = 0; x < tree.numNodesX(level); ++x) {
+                    const auto& node = tree.getNode(level, x, y);
+                    assert(node.error > 0.0f);
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        uint32_t cx = 2 * x + (c & 1), cy = 2 * y + (c >> 1);
+                        if (cx < tree.numNodesX(level - 1) && cy < tree.numNodesY(level - 1)) {
+                            assert(tree.getNode(level - 1, cx, cy).error <= node.error);
+                        }
+                    }
+                }
+            }
+        }
+        assert(tree.getNode(0, 3, 4).error == 0.0f);
+    }
+    picoLog("TerrainLodTest 1 passed: node bounds and errors");
+
+    // --- Test 2: the selection is watertight and deterministic, finer as the threshold shrinks ---
+    {
+        auto view = makeTestView(tree, spacing, 300.0f);
+        auto projection = makeTestProjection();
+        uint64_t previousTriangles = 0;
+        for (float pixelError : { 16.0f, 4.0f, 1.0f, 0.25f }) {
+            TerrainQuadtree::Chunks chunks, again;
+            tree.select(view, projection, 1080.0f, pixelError, chunks);
+            tree.select(view, projection, 1080.0f, pixelError, again);
+            assert(!chunks.empty());
+            assert(chunks.size() == again.size() && memcmp(chunks.data(), again.data(), chunks.size() * sizeof(TerrainQuadtree::Chunk)) == 0);
+            assert(countOpenEdges(tree, chunks) == 0);
+            uint64_t numTriangles = countTriangles(tree, chunks);
+            assert(numTriangles >= previousTriangles);
+            previousTriangles = numTriangles;
+        }
+    }
+    picoLog("TerrainLodTest 2 passed: crack free and deterministic selection");
+
+    // --- Test 3: a tiny threshold selects every level 0 chunk, a huge one the root ---
+    {
+        // looking straight down from high above, the whole map in view
+        core::View view;
+        view.setEye(core::vec3(0.0f, 20000.0f, 0.0f));
+        view.setOrientationFromFrontUp(core::vec3(0.0f, -1.0f, 0.0f), core::vec3(0.0f, 0.0f, -1.0f));
+        auto projection = makeTestProjection();
+        TerrainQuadtree::Chunks chunks;
+        tree.select(view, projection, 1080.0f, 1e-6f, chunks);
+        assert(chunks.size() == tree.numNodesX(0) * tree.numNodesY(0));
+        tree.select(view, projection, 1080.0f, 1e6f, chunks);
+        assert(chunks.size() == 1 && chunks[0].level == tree.numLevels() - 1);
+    }
+    picoLog("TerrainLodTest 3 passed: selection bounds");
+
+    // --- Test 4: the heightmap draw submits the selected chunks with their stitched index ranges ---
+    {
+        HeadlessTestScene t({});
+        auto heightmapFactory = std::make_shared<HeightmapDrawFactory>(t.device);
+        Heightmap heightmap;
+        heightmap.map_width = heightmap.mesh_resolutionX = width;
+        heightmap.map_height = heightmap.mesh_resolutionY = height;
+        heightmap.map_spacing = heightmap.mesh_spacing = spacing;
+        heightmap.heights = heights;
+        auto draw = t.scene->createDraw(heightmapFactory->createHeightmap(t.device, heightmap));
+        auto root = t.scene->createNode({});
+        t.scene->createItem({ .node = root.id(), .draw = draw.id() });
+
+        const auto& quadtree = draw.as<HeightmapDraw>().getQuadtree();
+        assert(quadtree && quadtree->width() == width && quadtree->height() == height);
+
+        auto view = makeTestView(*quadtree, spacing, 60.0f);
+        t.camera->setEye(view.eye());
+        t.camera->setOrientationFromFrontUp(-view.back(), core::vec3(0.0f, 1.0f, 0.0f));
+        t.camera->setFar(10000.0f);
+
+        t.backend()->setFrameCommandsRecording(true);
+        auto drawnIndices = [&]() {
+            std::vector<std::pair<uint32_t, uint32_t>> ranges;
+            for (const auto& c : t.backend()->lastFrameCommands()) {
+                if (c.type == HeadlessCommandType::DRAW_INDEXED) ranges.emplace_back(c.args[0], c.args[1]);
+            }
+            return ranges;
+        };
+
+        heightmapFactory->editUniforms().maxPixelError = 1.0f;
+        t.renderFrame();
+        auto drawn = drawnIndices();
+
+        TerrainQuadtree::Chunks chunks;
+        quadtree->select(t.camera->getView(), t.camera->getProjection(), t.camera->getViewportHeight(), 1.0f, chunks);
+        assert(chunks.size() > 1 && drawn.size() == chunks.size());
+        std::vector<uint32_t> indices;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            TerrainQuadtree::chunkIndices(chunks[c].stitch, indices);
+            assert(drawn[c].first == indices.size());
+        }
+
+        // a coarser threshold draws fewer chunks, the full grid once the chunks are off
+        heightmapFactory->editUniforms().maxPixelError = 16.0f;
+        t.renderFrame();
+        assert(drawnIndices().size() < drawn.size());
+
+        heightmapFactory->editUniforms().chunked = false;
+        t.renderFrame();
+        assert(drawnIndices().empty());
+        heightmapFactory->editUniforms() = HeightmapDrawUniforms();
+    }
+    picoLog("TerrainLodTest 4 passed: heightmap drawn with the selected chunks");
+
+    picoLog("TerrainLodTest: all tests passed");
+}
+
+void runTerrainLodBenchmarks() {
+    using clock = std::chrono::high_resolution_clock;
+    for (const char* file : { "../asset/dem/8955_75m.dem", "../asset/dem/8997_75m.dem", "../asset/dem/9008_75m.dem", "../asset/dem/9502_75m.dem" }) {
+        auto heightmap = document::Heightmap::createFromDEM(file);
+        if (!heightmap) {
+            picoLogf("TerrainLodBench skipped {}: not found", file);
+            continue;
+        }
+        auto start = clock::now();
+        TerrainQuadtree tree;
+        tree.build(*heightmap);
+        double buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        uint64_t fullTriangles = 2ull * (heightmap->width() - 1) * (heightmap->height() - 1);
+        picoLogf("TerrainLodBench {} ({} x {}, {} levels): build {:.2f} ms, full grid {} triangles",
+            file, heightmap->width(), heightmap->height(), tree.numLevels(), buildMs, fullTriangles);
+
+        auto view = makeTestView(tree, heightmap->spacing(), heightmap->maxHeight() + 200.0f);
+        auto projection = makeTestProjection();
+        for (float pixelError : { 8.0f, 4.0f, 2.0f, 1.0f, 0.5f }) {
+            TerrainQuadtree::Chunks chunks;
+            const uint32_t numRuns = 100;
+            start = clock::now();
+            for (uint32_t r = 0; r < numRuns; ++r) {
+                tree.select(view, projection, 1080.0f, pixelError, chunks);
+            }
+            double selectMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / numRuns;
+            uint64_t numTriangles = countTriangles(tree, chunks);
+            picoLogf("TerrainLodBench   {:.1f} px: {} chunks, {} triangles ({:.1f}% of the full grid), select {:.3f} ms",
+                pixelError, chunks.size(), numTriangles, 100.0 * double(numTriangles) / double(fullTriangles), selectMs);
+        }
+    }
+}
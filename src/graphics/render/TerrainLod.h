@@ -0,0 +1,105 @@
+// TerrainLod.h
+//
+// Sam Gateau - October 2026
+//
+// MIT License
+//
+// Copyright (c) 2026 Sam Gateau
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <core/math/Math3D.h>
+#include <core/math/CameraTransform.h>
+#include <document/Heightmap.h>
+
+#include "dllmain.h"
+
+namespace graphics {
+
+    // Chunked LOD terrain: a quadtree of square chunks over a heightmap.
+    // Every chunk is drawn as a grid of CHUNK_CELLS x CHUNK_CELLS cells, the cells of a chunk at level L span 2^L samples.
+    // Level 0 chunks are at the heightmap resolution, the top level is a single chunk over the whole map.
+    //
+    // The sample (x, y) is placed at ((x - width / 2) * spacing, heightScale * h, (y - height / 2) * spacing),
+    // the layout of HeightmapDraw.
+    class VISUALIZATION_API TerrainQuadtree {
+    public:
+        static const uint32_t CHUNK_CELLS = 32;
+
+        struct Node {
+            float minHeight{ 0.0f };
+            float maxHeight{ 0.0f };
+            float error{ 0.0f }; // max vertical distance between the chunk grid and the samples it covers, children included
+        };
+
+        // Edges of a chunk next to a chunk one level coarser, their odd vertices are collapsed on the even ones
+        enum Stitch : uint8_t {
+            STITCH_X_NEG = 0x01,
+            STITCH_X_POS = 0x02,
+            STITCH_Y_NEG = 0x04,
+            STITCH_Y_POS = 0x08,
+        };
+
+        struct Chunk {
+            uint8_t level{ 0 };
+            uint8_t stitch{ 0 };
+            uint16_t x{ 0 };
+            uint16_t y{ 0 };
+        };
+        using Chunks = std::vector<Chunk>;
+
+        void build(const float* heights, uint32_t width, uint32_t height, float spacing, float heightScale = 1.0f);
+        void build(const document::Heightmap& heightmap, float heightScale = 1.0f);
+
+        // Pick the chunks drawing the terrain for a view in the terrain space:
+        // a chunk is refined while its error projects over maxPixelError pixels on a viewport viewportHeight pixels high,
+        // then the chunks are split until the neighbors are at most one level apart and the edges next to a coarser chunk are stitched.
+        // The chunks out of the frustum are culled. The result only depends on the inputs, in row major order of the level 0 grid.
+        void select(const core::View& view, const core::Projection& projection, float viewportHeight, float maxPixelError, Chunks& chunks) const;
+
+        // Triangle list over the (CHUNK_CELLS + 1)^2 vertices of a chunk grid (vertex (i, j) is j * (CHUNK_CELLS + 1) + i),
+        // the stitched edges drop their odd vertices and the triangles collapsing with them.
+        static void chunkIndices(uint8_t stitch, std::vector<uint32_t>& indices);
+
+        // Heightmap sample of the vertex (i, j) of a chunk, clamped to the map
+        void chunkSample(const Chunk& chunk, uint32_t i, uint32_t j, uint32_t& sx, uint32_t& sy) const;
+
+        uint32_t numLevels() const { return (uint32_t) _levelOffsets.size(); }
+        uint32_t numNodesX(uint32_t level) const;
+        uint32_t numNodesY(uint32_t level) const;
+        const Node& getNode(uint32_t level, uint32_t x, uint32_t y) const { return _nodes[_levelOffsets[level] + y * numNodesX(level) + x]; }
+        core::aabox3 evalNodeBound(uint32_t level, uint32_t x, uint32_t y) const;
+
+        uint32_t width() const { return _width; }
+        uint32_t height() const { return _height; }
+
+    private:
+        uint32_t _width{ 0 };
+        uint32_t _height{ 0 };
+        float _spacing{ 1.0f };
+        std::vector<uint32_t> _levelOffsets;
+        std::vector<Node> _nodes;
+    };
+    using TerrainQuadtreePointer = std::shared_ptr<TerrainQuadtree>;
+}
@@ -25,7 +25,7 @@
 // SOFTWARE.
 //
 #include "Transform.h"
-#include <core/log.h>
+#include <core/Log.h>
 #include "gpu/Resource.h"
 #include "gpu/Device.h"
 
@@ -248,15 +248,68 @@ namespace graphics {
 
     NodeIDs NodeStore::updateTransforms() {
         NodeIDs touched;
+        if (_touchedTransforms.empty()) {
+            return touched;
+        }
+
+        // Mark the touched nodes, a touched node below another touched node is recomputed
+        // as part of the ancestor's subtree so only the topmost touched nodes seed the update
+        auto nodeCount = numAllocatedNodes();
+        _dirtyMarks.assign(nodeCount, 0);
         for (auto nodeId : _touchedTransforms) {
-            const auto& info = *_nodeInfos.unsafe_data(nodeId);
-            if (info.parent == INVALID_NODE_ID) {
-                _nodeTransforms.unsafe_data(nodeId)->world = _nodeTransforms.unsafe_data(nodeId)->local;
-            } else {
-                _nodeTransforms.unsafe_data(nodeId)->world = core::mul(_nodeTransforms.unsafe_data(info.parent)->world, _nodeTransforms.unsafe_data(nodeId)->local);
+            _dirtyMarks[nodeId] = 1;
+        }
+
+        NodeIDs level;
+        level.reserve(_touchedTransforms.size());
+        for (auto nodeId : _touchedTransforms) {
+            if (_dirtyMarks[nodeId] != 1) continue; // already seeded
+            bool underDirtyAncestor = false;
+            for (auto p = _nodeInfos.unsafe_data(nodeId)->parent; p != INVALID_NODE_ID; p = _nodeInfos.unsafe_data(p)->parent) {
+                if (_dirtyMarks[p]) { underDirtyAncestor = true; break; }
+            }
+            _dirtyMarks[nodeId] = 2;
+            if (!underDirtyAncestor) {
+                level.push_back(nodeId);
+            }
+        }
+
+        // Then walk the subtrees level by level, all the world transforms of a level
+        // are composed in one batch on the SoA streams.
+        static const Transform identity;
+        NodeIDs nextLevel;
+        bool isRootLevel = true;
+        while (!level.empty()) {
+            uint32_t count = (uint32_t) level.size();
+            _parentWorlds.resize(count);
+            _localTransforms.resize(count);
+
+            nextLevel.clear();
+            for (uint32_t i = 0; i < count; ++i) {
+                auto nodeId = level[i];
+                const auto& info = *_nodeInfos.unsafe_data(nodeId);
+                _parentWorlds.set(i, (info.parent == INVALID_NODE_ID ? identity : _nodeTransforms.unsafe_data(info.parent)->world));
+                _localTransforms.set(i, _nodeTransforms.unsafe_data(nodeId)->local);
+
+                NodeID child_id = info.children_head;
+                for (int c = 0; c < info.num_children; ++c) {
+                    nextLevel.push_back(child_id);
+                    child_id = _nodeInfos.unsafe_data(child_id)->sybling;
+                }
+            }
+
+            core::stream_mul(_parentWorlds, _localTransforms, _worldTransforms);
+
+            for (uint32_t i = 0; i < count; ++i) {
+                _nodeTransforms.unsafe_data(level[i])->world = _worldTransforms.get(i);
+            }
+            _nodeTransforms.touch(level);
+
+            if (!isRootLevel) {
+                touched.insert(touched.end(), level.begin(), level.end());
             }
-            _nodeTransforms.write(nodeId);
-            updateChildrenTransforms(nodeId, touched);
+            isRootLevel = false;
+            std::swap(level, nextLevel);
         }
 
         _touchedTransforms.clear();
@@ -281,6 +334,7 @@ namespace graphics {
         NodeID child_id = info.children_head;
         for (int i = 0; i < info.num_children; ++i) {
             _nodeTransforms.unsafe_data(child_id)->world = core::mul(parent_world_transform, _nodeTransforms.unsafe_data(child_id)->local);
+            _nodeTransforms.touch(child_id);
             touched.push_back(child_id);
 
             const auto& child = *_nodeInfos.unsafe_data(child_id);
@@ -298,11 +352,12 @@ namespace graphics {
     }
 
 
-    void NodeStore::syncGPUBuffer(const BatchPointer& batch) {
+    void NodeStore::syncGPUBuffer(const BatchPointer& batch, UploadRing* ring) {
         updateTransforms();
 
-        _nodeInfos.sync_gpu_from_cpu(batch);
-        _nodeTransforms.sync_gpu_from_cpu(batch);
+        _nodeInfos.sync_gpu_from_cpu(batch, _touchedInfos, ring);
+        _touchedInfos.clear();
+        _nodeTransforms.sync_gpu_from_cpu(batch, ring);
     }
 
     void NodeStore::traverse(TraverseAccessor accessor) const {
@@ -28,6 +28,7 @@
 
 #include <functional>
 #include <core/math/Math3D.h>
+#include <core/math/Stream.h>
 #include <core/stl/IndexTable.h>
 
 #include "dllmain.h"
@@ -79,6 +80,13 @@ namespace graphics {
         using NodeTransformStructBuffer = StructuredBuffer<NodeTransform>;
         using NodeTransforms = NodeTransformStructBuffer::Array;
 
+        // A contiguous range of nodes [begin, end)
+        struct NodeRange {
+            NodeID begin{ 0 };
+            NodeID end{ 0 };
+        };
+        using NodeRanges = std::vector<NodeRange>;
+
     private:
         core::IndexTable _indexTable;
         mutable NodeInfoStructBuffer _nodeInfos;
@@ -87,6 +95,13 @@ namespace graphics {
 
         mutable NodeIDs _touchedInfos;
         mutable NodeIDs _touchedTransforms;
+        NodeRanges _writtenTransforms;
+
+        // Scratch of updateTransforms, kept around to avoid reallocating every frame
+        std::vector<uint8_t> _dirtyMarks;
+        core::mat4x3_stream _parentWorlds;
+        core::mat4x3_stream _localTransforms;
+        core::mat4x3_stream _worldTransforms;
 
         using ReadInfoLock = std::pair< const NodeInfo*, std::lock_guard<std::mutex>>;
         using WriteInfoLock = std::pair< NodeInfo*, std::lock_guard<std::mutex>>;
@@ -206,7 +221,29 @@ namespace graphics {
             if (!editor(t->local)) { _touchedTransforms.pop_back(); }
         }
 
+        // Bulk edit under a single lock: the editor gets the whole transform array (and the node infos, read only)
+        // and must append the ids of the nodes it writes to the touched list.
+        // An editor composing the world transforms of a whole branch itself only appends the nodes
+        // which subtree still needs the walk of updateTransforms.
+        // The editor reports the ranges of the nodes it writes, local or world, only these are uploaded on the next sync.
+        inline void editNodeTransforms(std::function<void(const NodeInfo* infos, NodeTransform* transforms, NodeIDs& touched, NodeRanges& written)> editor) {
+            auto [t, l] = _nodeTransforms.write(0);
+            _writtenTransforms.clear();
+            editor(_nodeInfos.unsafe_data(0), t, _touchedTransforms, _writtenTransforms);
+            for (const auto& r : _writtenTransforms) {
+                _nodeTransforms.touch_range(r.begin, r.end);
+            }
+        }
+
+        // Bulk read under a single lock: the reader gets the whole transform array
+        inline void readNodeTransforms(std::function<void(const NodeTransform* transforms)> reader) const {
+            auto [t, l] = _nodeTransforms.read(0);
+            reader(t);
+        }
+
         // Update and Manage the transform tree once per loop
+        // The touched subtrees are updated breadth first, one batched stream_mul per depth level.
+        // Returns the descendants of the touched nodes that got their world transform recomputed.
         NodeIDs updateTransforms();
         void updateChildrenTransforms(NodeID parent, NodeIDs& touched);
 
@@ -231,7 +268,8 @@ namespace graphics {
         // gpu api
         inline BufferPointer getNodeInfoGPUBuffer() const { return _nodeInfos.gpu_buffer(); }
         inline BufferPointer getNodeTransformGPUBuffer() const { return _nodeTransforms.gpu_buffer(); }
-        void syncGPUBuffer(const BatchPointer& batch);  
+        inline const auto& lastNodeTransformUpload() const { return _nodeTransforms.last_upload(); }
+        void syncGPUBuffer(const BatchPointer& batch, UploadRing* ring = nullptr);
     };
 
     using Node = NodeStore::Node;
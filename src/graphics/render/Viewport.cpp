@@ -33,7 +33,14 @@
 #include "Draw.h"
 #include "gpu/Swapchain.h"
 #include "gpu/Batch.h"
+#include "gpu/CommandStream.h"
 #include "gpu/Query.h"
+#include "gpu/Resource.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <core/Job.h>
 
 
 
@@ -45,6 +52,7 @@ const DescriptorSetLayout Viewport::viewPassLayout = {
     { graphics::DescriptorType::RESOURCE_BUFFER, graphics::ShaderStage::ALL_GRAPHICS, 19, 1},  // Camera
     { graphics::DescriptorType::RESOURCE_BUFFER, graphics::ShaderStage::VERTEX, 20, 1}, // Node Transform
     { graphics::DescriptorType::RESOURCE_BUFFER, graphics::ShaderStage::ALL_GRAPHICS, 21, 1}, // Timer
+    { graphics::DescriptorType::RESOURCE_BUFFER, graphics::ShaderStage::VERTEX, 22, 1}, // Instance nodes
 };
 
 Viewport::Viewport(const ViewportInit& init) :
@@ -63,31 +71,70 @@ Viewport::Viewport(const ViewportInit& init) :
               this->_animateCallback(args);
           });
 
-    DescriptorSetInit dsInit = {
-        nullptr,
-        0, false,
-        viewPassLayout
-    };
-    _viewPassDescriptorSet = _device->createDescriptorSet(dsInit);
+    _renderQueue.setInstancing(true);
+
+    _uploadRing = std::make_shared<UploadRing>(_device);
+    _streamingQueue = std::make_shared<StreamingQueue>();
+}
 
+Viewport::~Viewport() {
+
+}
+
+Viewport::ViewPass& Viewport::beginViewPass(uint8_t currentIndex) {
+    if (_viewPasses.size() <= currentIndex) {
+        _viewPasses.resize(currentIndex + 1);
+    }
+    auto& viewPass = _viewPasses[currentIndex];
+    if (!viewPass.descriptorSet) {
+        DescriptorSetInit dsInit = {
+            nullptr,
+            0, false,
+            viewPassLayout
+        };
+        viewPass.descriptorSet = _device->createDescriptorSet(dsInit);
+        viewPass.instanceBuffer = createInstanceBuffer(DEFAULT_INSTANCE_CAPACITY);
+        viewPass.instanceCapacity = DEFAULT_INSTANCE_CAPACITY;
+        updateViewPassDescriptorSet(viewPass);
+    }
+    _currentViewPass = currentIndex;
+    return viewPass;
+}
+
+void Viewport::updateViewPassDescriptorSet(ViewPass& viewPass) {
     DescriptorObjects descriptorObjects = {
         { graphics::DescriptorType::UNIFORM_BUFFER, _scene->_sky->getGPUBuffer() },
         { graphics::DescriptorType::RESOURCE_BUFFER, _scene->_cameras.getGPUBuffer() },
         { graphics::DescriptorType::RESOURCE_BUFFER, _scene->_nodes.getNodeTransformGPUBuffer()},
         { graphics::DescriptorType::RESOURCE_BUFFER, _batchTimer->getBuffer() },
+        { graphics::DescriptorType::RESOURCE_BUFFER, viewPass.instanceBuffer },
     };
-    _device->updateDescriptorSet(_viewPassDescriptorSet, descriptorObjects);
-
+    _device->updateDescriptorSet(viewPass.descriptorSet, descriptorObjects);
 }
 
-Viewport::~Viewport() {
-
+BufferPointer Viewport::createInstanceBuffer(uint32_t capacity) {
+    BufferInit bufferInit;
+    bufferInit.usage = ResourceUsage::RESOURCE_BUFFER;
+    bufferInit.hostVisible = true;
+    bufferInit.cpuDouble = true;
+    bufferInit.bufferSize = capacity * sizeof(NodeID);
+    bufferInit.numElements = capacity;
+    bufferInit.structStride = sizeof(NodeID);
+    return _device->createBuffer(bufferInit);
 }
 
 core::FrameTimer::Sample Viewport::lastFrameTimerSample() const {
     return _frameTimer.lastSample();
 }
 
+const CommandStreamStats& Viewport::lastSceneStreamStats() const {
+    return _sceneStreamStats;
+}
+
+void Viewport::setSceneRecordingGrain(uint32_t numItems) {
+    _sceneRecordingGrain = numItems;
+}
+
 
 void Viewport::animate(float time) {
     _renderer->animate(time);
@@ -97,13 +144,18 @@ void Viewport::_animateCallback(AnimateArgs& args) {
     args.scene = _scene;
 
     auto itemInfos = _scene->_items.fetchItemInfos();
-    
+
+    // Gather the animated items and evaluate them all in one batch
+    AnimIDs anims;
+    NodeIDs nodes;
     for (int i = 0; i < itemInfos.size(); i++) {
         const auto& info = itemInfos[i];
         if (info.isValid() && info.isVisible() && info.isAnim()) {
-             _scene->_anims.animate(info._animID, info._nodeID, args);
+            anims.push_back(info._animID);
+            nodes.push_back(info._nodeID);
         }
     }
+    _scene->_anims.animateBatch(anims, nodes, _scene->_nodes, args);
 }
 
 void Viewport::render(const SwapchainPointer& swapchain) {
@@ -118,7 +170,16 @@ void Viewport::_renderCallback(RenderArgs& args) {
 
     args.batch->begin(currentIndex, _batchTimer);
 
-    syncSceneResourcesForFrame(_scene, args.batch);
+    // The frame previously recorded in this swapchain slot is done, so is its staging memory
+    _uploadRing->beginFrame(currentIndex);
+    syncSceneResourcesForFrame(_scene, args.batch, _uploadRing.get());
+    // then the streamed resources, in the staging memory left by the frame
+    _streamingQueue->drain(args.batch, *_uploadRing);
+    // and so are the descriptor set and the instance buffer of the slot
+    beginViewPass(currentIndex);
+
+    // The queue is built before the pass, the instance nodes are uploaded with the scene resources
+    this->prepareScene(args);
 
     args.batch->resourceBarrierTransition(
         graphics::ResourceBarrierFlag::NONE,
@@ -155,26 +216,76 @@ void Viewport::_renderCallback(RenderArgs& args) {
     _frameTimer.endFrame();
 }
 
+void Viewport::prepareScene(RenderArgs& args) {
+    _sceneItemInfos = _scene->_items.fetchItemInfos();
+    _renderQueue.build(*_scene, args.camera, _sceneItemInfos, _sceneSorting);
+    // The lazy uploads of the draws go in the frame batch now, the ranges are recorded concurrently later
+    args.scene = _scene;
+    _renderQueue.prepare(*_scene, _sceneItemInfos, args);
+
+    const auto& instanceNodes = _renderQueue.instanceNodes();
+    if (instanceNodes.empty()) {
+        return;
+    }
+    // Only the buffer and the descriptor set of this slot are replaced, the other frames in flight keep theirs
+    auto& viewPass = _viewPasses[_currentViewPass];
+    if (instanceNodes.size() > viewPass.instanceCapacity) {
+        uint32_t capacity = viewPass.instanceCapacity;
+        while (capacity < instanceNodes.size()) {
+            capacity *= 2;
+        }
+        viewPass.instanceBuffer = createInstanceBuffer(capacity);
+        viewPass.instanceCapacity = capacity;
+        updateViewPassDescriptorSet(viewPass);
+    }
+    const auto& instanceBuffer = viewPass.instanceBuffer;
+
+    uint32_t size = (uint32_t) (instanceNodes.size() * sizeof(NodeID));
+    args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::SHADER_RESOURCE, graphics::ResourceState::COPY_DEST, instanceBuffer);
+    if (!_uploadRing->upload(args.batch, instanceBuffer, 0, instanceNodes.data(), size)) {
+        memcpy(instanceBuffer->_cpuMappedAddress, instanceNodes.data(), size);
+        args.batch->uploadBuffer(instanceBuffer);
+    }
+    args.batch->resourceBarrierTransition(graphics::ResourceBarrierFlag::NONE, graphics::ResourceState::COPY_DEST, graphics::ResourceState::SHADER_RESOURCE, instanceBuffer);
+}
+
 void Viewport::renderScene(RenderArgs& args) {
     args.timer = _batchTimer;
-    args.viewPassDescriptorSet = _viewPassDescriptorSet;
+    args.viewPassDescriptorSet = _viewPasses[_currentViewPass].descriptorSet;
     args.scene = _scene;
 
-    auto itemInfos = _scene->_items.fetchItemInfos();
+    const auto& itemInfos = _sceneItemInfos;
+    uint32_t numEntries = _renderQueue.size();
+
+    // The queue is split in ranges, each range is recorded in its own command stream on the shared pool.
+    // The streams are then replayed into the frame batch in the order of the ranges,
+    // dropping the binds repeated from one drawcall to the next (and from one range to the next).
+    // The frame batch is the same whatever the number of ranges or threads.
+    uint32_t grain = std::max(_sceneRecordingGrain, 1u);
+    uint32_t numRanges = std::clamp((numEntries + grain - 1) / grain, 1u, MAX_SCENE_RANGES);
+    uint32_t rangeSize = (numEntries + numRanges - 1) / numRanges;
+    while (_sceneStreams.size() < numRanges) {
+        _sceneStreams.emplace_back(std::make_shared<CommandStream>());
+    }
 
-    for (int i = 0; i < itemInfos.size(); i++) {
-        const auto& info = itemInfos[i];
-        if (info.isValid() && info.isVisible() && info.isDraw()) {
-        //    auto drawcall = _scene->_drawables.getDrawcall(info._drawID);
-            _scene->_drawables.getDrawcall(info._drawID)(info._nodeID, args);
+    core::ThreadPool::shared().parallel_for(numRanges, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t r = begin; r < end; ++r) {
+            const auto& stream = _sceneStreams[r];
+            RenderArgs rangeArgs = args;
+            rangeArgs.batch = stream;
+
+            stream->begin(0);
+            uint32_t first = std::min(numEntries, r * rangeSize);
+            uint32_t last = std::min(numEntries, (r + 1) * rangeSize);
+            _renderQueue.issue(*_scene, itemInfos, first, last, rangeArgs);
+            stream->end();
         }
+    });
+
+    _sceneReplayState.reset();
+    _sceneStreamStats = CommandStreamStats();
+    for (uint32_t r = 0; r < numRanges; ++r) {
+        _sceneStreamStats += _sceneStreams[r]->replay(args.batch, _sceneReplayState);
     }
-/*
-    if (itemInfos.size() > 0) {
-        const auto& info = itemInfos[0];
-        if (info.isValid() && info.isVisible() && info.isDraw()) {
-   //         auto drawcall = _scene->_drawables.getDrawcall(info._drawID);
-            _scene->_drawables.getDrawcall(info._drawID)(info._nodeID, args);
-        }
-    }*/
+    _numSceneRanges = numRanges;
 }
@@ -32,6 +32,10 @@
 #include "Renderer.h"
 
 #include <gpu/Descriptor.h>
+#include <gpu/CommandStream.h>
+#include <gpu/UploadRing.h>
+#include <gpu/StreamingQueue.h>
+#include "RenderQueue.h"
 
 namespace graphics {
 
@@ -54,6 +58,32 @@ namespace graphics {
 
         core::FrameTimer::Sample lastFrameTimerSample() const;
 
+        // Recording and replay stats of the scene drawcalls for the last frame
+        const CommandStreamStats& lastSceneStreamStats() const;
+        uint32_t lastNumSceneRanges() const { return _numSceneRanges; }
+
+        // The scene items are recorded concurrently in ranges of at least 'numItems' items
+        static constexpr uint32_t DEFAULT_SCENE_RECORDING_GRAIN = 1024;
+        static constexpr uint32_t MAX_SCENE_RANGES = 64;
+        void setSceneRecordingGrain(uint32_t numItems);
+        uint32_t getSceneRecordingGrain() const { return _sceneRecordingGrain; }
+
+        // The visible scene items are sorted by state before recording, or issued in item order
+        void setSceneSorting(bool enabled) { _sceneSorting = enabled; }
+        bool isSceneSorting() const { return _sceneSorting; }
+        void setSceneDepthSorting(bool enabled) { _renderQueue.setDepthSorting(enabled); }
+        bool isSceneDepthSorting() const { return _renderQueue.isDepthSorting(); }
+        // The repeated parts of the sorted items are drawn instanced
+        void setSceneInstancing(bool enabled) { _renderQueue.setInstancing(enabled); }
+        bool isSceneInstancing() const { return _renderQueue.isInstancing(); }
+        const RenderQueueStats& lastRenderQueueStats() const { return _renderQueue.stats(); }
+
+        // The scene changes and the instance nodes of the frame are staged in the upload ring
+        const UploadRingPointer& getUploadRing() const { return _uploadRing; }
+
+        // The streamed resources are uploaded at the start of the frame, within the budget of the queue
+        const StreamingQueuePointer& getStreamingQueue() const { return _streamingQueue; }
+
         static const DescriptorSetLayout viewPassLayout;
 
         void animate(float time);
@@ -62,8 +92,10 @@ namespace graphics {
         void _renderCallback(RenderArgs& args);
         void _animateCallback(AnimateArgs& args);
 
+        void prepareScene(RenderArgs& args);
         void renderScene(RenderArgs& args);
 
+
         ScenePointer _scene;
         DevicePointer _device;
         RendererPointer _renderer;
@@ -74,7 +106,35 @@ namespace graphics {
         core::FrameTimer _frameTimer;
         BatchTimerPointer _batchTimer;
 
-        DescriptorSetPointer _viewPassDescriptorSet;
+        // The view pass resources of a swapchain slot, only rewritten when the slot comes back
+        // and the frame previously recorded in it is done
+        struct ViewPass {
+            DescriptorSetPointer descriptorSet;
+            // The node of every entry of the render queue for the instanced drawcalls, grows with the queue
+            BufferPointer instanceBuffer;
+            uint32_t instanceCapacity = 0;
+        };
+        std::vector<ViewPass> _viewPasses;
+        uint8_t _currentViewPass = 0;
+        ViewPass& beginViewPass(uint8_t currentIndex);
+        void updateViewPassDescriptorSet(ViewPass& viewPass);
+
+        // The scene drawcalls are recorded here, one stream per range of items, before going to the frame batch
+        std::vector<CommandStreamPointer> _sceneStreams;
+        CommandStreamReplayState _sceneReplayState;
+        CommandStreamStats _sceneStreamStats;
+        uint32_t _sceneRecordingGrain = DEFAULT_SCENE_RECORDING_GRAIN;
+        uint32_t _numSceneRanges = 0;
+
+        RenderQueue _renderQueue;
+        ItemInfos _sceneItemInfos;
+        bool _sceneSorting = true;
+
+        static constexpr uint32_t DEFAULT_INSTANCE_CAPACITY = 4096;
+        BufferPointer createInstanceBuffer(uint32_t capacity);
+
+        UploadRingPointer _uploadRing;
+        StreamingQueuePointer _streamingQueue;
 
         // Bag of interesting constants for the Viewport ?
         CameraID _cameraID = 0;
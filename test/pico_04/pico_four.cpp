@@ -116,7 +116,7 @@ struct AppState {
 AppState state;
 
 
-graphics::NodeIDs generateModel(document::ModelPointer lmodel, graphics::DevicePointer& gpuDevice, graphics::ScenePointer& scene, graphics::NodeID nodeRoot) {
+graphics::NodeIDs generateModel(const std::string& modelFile, graphics::DevicePointer& gpuDevice, graphics::ScenePointer& scene, graphics::NodeID nodeRoot) {
 
     if (!state._modelDrawFactory) {
         state._modelDrawFactory = std::make_shared<graphics::ModelDrawFactory>(gpuDevice);
@@ -124,8 +124,8 @@ graphics::NodeIDs generateModel(document::ModelPointer lmodel, graphics::DeviceP
     }
 
     graphics::ItemIDs modelItemIDs;
-    if (lmodel) {
-        auto modelDrawPtr = state._modelDrawFactory->createModel(gpuDevice, lmodel);
+    auto modelDrawPtr = state._modelDrawFactory->createModelFromFile(gpuDevice, modelFile);
+    if (modelDrawPtr) {
 
         state._modelDrawFactory->allocateDrawcallObject(gpuDevice, scene, *modelDrawPtr);
 
@@ -158,15 +158,14 @@ graphics::NodeIDs generateModel(document::ModelPointer lmodel, graphics::DeviceP
         }
     }
     else {
-        picoLog("Model document is empty");
+        picoLog("Model <" + modelFile + "> failed to load");
     }
 
     return modelItemIDs;
 }
 
 
-document::ModelPointer loadModel() {
-    document::ModelPointer lmodel;
+std::string modelFilename() {
     //  std::string modelFile("../asset/gltf/toycar/toycar.gltf");
     //   std::string modelFile("../asset/gltf/AntiqueCamera.gltf");
    //    std::string modelFile("../asset/gltf/Sponza.gltf");
@@ -215,11 +214,7 @@ document::ModelPointer loadModel() {
 
 
 
-    lmodel = document::model::Model::createFromGLTF(modelFile);
-    if (!lmodel) {
-        picoLog("Model <" + modelFile + "> document failed to load");
-    }
-    return lmodel;
+    return modelFile;
 }
 
 void logScene() {
@@ -308,8 +303,7 @@ int main(int argc, char *argv[])
     if (showModel)
     {
         state.models.rootNodeID = scene->createNode({}).id();
-        auto modelDocument = loadModel();
-        auto modelItemIDs = generateModel(modelDocument, gpuDevice, state.scene, state.models.rootNodeID);
+        auto modelItemIDs = generateModel(modelFilename(), gpuDevice, state.scene, state.models.rootNodeID);
         if (modelItemIDs.size()) {
             state.models.modelItemID = modelItemIDs[0];
         }
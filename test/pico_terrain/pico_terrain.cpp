@@ -89,13 +89,8 @@ void generateTerrain(uint32_t map_res, float map_spacing, graphics::DevicePointe
     auto HeightmapDrawFactory = std::make_shared<graphics::HeightmapDrawFactory>(gpuDevice);
 
     // a Heightmap draw
-    map_res = lterrain->_resolution;
-    map_spacing = lterrain->_spacing;
-    auto heightmap_draw = scene->createDraw(HeightmapDrawFactory->createHeightmap(gpuDevice, {
-         map_res, map_res, map_spacing,
-         map_res, map_res, map_spacing,
-         lterrain->_heights
-        }));
+    auto heightmap_draw = scene->createDraw(HeightmapDrawFactory->createHeightmap(gpuDevice,
+         graphics::Heightmap::createFromDocument(*lterrain->_heightmap)));
 
     // In an item
     scene->createItem({ .node= root.id(), .draw = heightmap_draw.id()});
@@ -4,6 +4,7 @@
 #include <core/math/Math3D.h>
 #include <graphics/drawables/PrimitiveDraw.h>
 #include <graphics/drawables/HeightmapDraw.h>
+#include <document/Heightmap.h>
 
 
 
@@ -30,6 +31,8 @@ namespace terrain {
         std::vector<float> _heights;
         int32_t _resolution{ 0};
         float _spacing { 1.0f };
+
+        document::HeightmapPointer _heightmap;
     };
 }
 
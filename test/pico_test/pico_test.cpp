@@ -29,12 +29,119 @@
 // pico_test: run core unit tests
 // introducing:
 // core::Job / core::JobGraph / core::JobScheduler
+// core::math streams (SoA batch kernels)
+// core::mesh weld
+//
+// pass "bench" as argument to also run the benchmarks
 
 //--------------------------------------------------------------------------------------
+#include <string>
 
 void runJobTests();
+void runMathStreamTests();
+void runMathStreamBenchmarks();
+void runKeyframeTests();
+void runKeyframeBenchmarks();
+void runKeyframeCompressionTests();
+void runNoiseTests();
+void runNoiseBenchmarks();
+void runMeshWeldTests();
+void runMeshWeldBenchmarks();
+void runMeshAdjacencyTests();
+void runMeshAdjacencyBenchmarks();
+void runMeshVertexCacheTests();
+void runMeshVertexCacheBenchmarks();
+void runMeshletTests();
+void runMeshletBenchmarks();
+void runSkinningTests();
+void runSkinningBenchmarks();
+void runAnimationTests();
+void runAnimationBenchmarks();
+void runModelDrawTests();
+void runModelDrawBenchmarks();
+void runModelDrawCacheTests();
+void runModelDrawCacheBenchmarks();
+void runHeadlessBackendTests();
+void runHeadlessBackendBenchmarks();
+void runCommandStreamTests();
+void runCommandStreamBenchmarks();
+void runStructuredBufferTests();
+void runStructuredBufferBenchmarks();
+void runUploadRingTests();
+void runUploadRingBenchmarks();
+void runStreamingQueueTests();
+void runStreamingQueueBenchmarks();
+void runPipelineCacheTests();
+void runPipelineCacheBenchmarks();
+void runHeapAllocatorTests();
+void runHeapAllocatorBenchmarks();
+void runRenderQueueTests();
+void runRenderQueueBenchmarks();
+void runHeightmapTests();
+void runHeightmapBenchmarks();
+void runFileTreeTests();
+void runFileTreeBenchmarks();
+void runTreemapTests();
+void runTreemapBenchmarks();
+void runTerrainLodTests();
+void runTerrainLodBenchmarks();
 
 int main(int argc, char* argv[]) {
+    bool runBenchmarks = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "bench") runBenchmarks = true;
+    }
+
     runJobTests();
+    runMathStreamTests();
+    runKeyframeTests();
+    runKeyframeCompressionTests();
+    runNoiseTests();
+    runMeshWeldTests();
+    runMeshAdjacencyTests();
+    runMeshVertexCacheTests();
+    runMeshletTests();
+    runSkinningTests();
+    runAnimationTests();
+    runModelDrawTests();
+    runModelDrawCacheTests();
+    runHeadlessBackendTests();
+    runCommandStreamTests();
+    runStructuredBufferTests();
+    runUploadRingTests();
+    runStreamingQueueTests();
+    runPipelineCacheTests();
+    runHeapAllocatorTests();
+    runRenderQueueTests();
+    runHeightmapTests();
+    runFileTreeTests();
+    runTreemapTests();
+    runTerrainLodTests();
+
+    if (runBenchmarks) {
+        runMathStreamBenchmarks();
+        runKeyframeBenchmarks();
+        runNoiseBenchmarks();
+        runMeshWeldBenchmarks();
+        runMeshAdjacencyBenchmarks();
+        runMeshVertexCacheBenchmarks();
+        runMeshletBenchmarks();
+        runSkinningBenchmarks();
+        runAnimationBenchmarks();
+        runModelDrawBenchmarks();
+        runModelDrawCacheBenchmarks();
+        runHeadlessBackendBenchmarks();
+        runCommandStreamBenchmarks();
+        runStructuredBufferBenchmarks();
+        runUploadRingBenchmarks();
+        runStreamingQueueBenchmarks();
+        runPipelineCacheBenchmarks();
+        runHeapAllocatorBenchmarks();
+        runRenderQueueBenchmarks();
+        runHeightmapBenchmarks();
+        runFileTreeBenchmarks();
+        runTreemapBenchmarks();
+        runTerrainLodBenchmarks();
+    }
     return 0;
 }
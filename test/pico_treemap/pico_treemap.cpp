@@ -38,6 +38,9 @@
 #include <graphics/gpu/gpu.h>
 #include <graphics/render/Renderer.h>
 
+#include <document/FileTree.h>
+#include <document/Treemap.h>
+
 #include <uix/Window.h>
 #include <uix/Imgui.h>
 
@@ -46,8 +49,6 @@
 
 #include <vector>
 #include <algorithm>
-#include <filesystem>
-namespace fs = std::filesystem;
 
 //--------------------------------------------------------------------------------------
 // pico treemap: explore our own treemap
@@ -85,43 +86,9 @@ graphics::PipelineStatePointer createPipelineState(const graphics::DevicePointer
 }
 
 using IDs = std::vector<int32_t>;
+using Nodes = document::FileTree::Nodes;
 
-struct Node
-{
-    std::string path;
-    int64_t size;
-    int32_t parent = -1;
-    int32_t sybling = -1;
-    int32_t childBegin = -1;
-    int32_t childEnd = -1;
-};
-using Nodes = std::vector<Node>;
-
-int32_t addNode(Nodes& tree, int32_t parent)
-{
-    int32_t newChild = tree.size();
-
-    if (parent >= 0)
-    {
-        int32_t prevChild = tree[parent].childEnd;
-        if (prevChild < 0)
-        {
-            tree[parent].childBegin = tree[parent].childEnd = newChild;
-        }
-        else
-        {
-            tree[prevChild].sybling = tree[parent].childEnd = newChild;
-        }
-    }
-
-    Node n;
-    n.parent = parent;
-    tree.emplace_back(n);
-
-    return newChild;
-}
-
-int32_t nextNode(Nodes& tree, int32_t current, int32_t& depth, bool visitChildren = true)
+int32_t nextNode(const Nodes& tree, int32_t current, int32_t& depth, bool visitChildren = true)
 {
     if (current < 0)
         return -1;
@@ -142,86 +109,7 @@ int32_t nextNode(Nodes& tree, int32_t current, int32_t& depth, bool visitChildre
     return nextNode(tree, n.parent, depth, false);
 }
 
-Nodes createNodeTree(const std::string& rootPath)
-{
-    Nodes tree = { };
-    std::vector<std::string> queue = { rootPath };
-    IDs traversalParentID = { };
-    IDs traversalNumSubFolders = { };
-
-    while (!queue.empty())
-    {
-        auto currentDirPath = queue.back();
-        queue.pop_back();
-
-        int32_t currentDirID = -1;
-        {
-            int32_t currentDirParentID = -1;
-            if (!traversalParentID.empty()) {
-                currentDirParentID = traversalParentID.back();
-            }
-
-            currentDirID = addNode(tree, currentDirParentID);
-            tree[currentDirID].path = currentDirPath;
-        }
-        int64_t currentDirFilesSize = 0;
-
-        std::vector<std::string> subfolders;
-        for (const auto& entry : fs::directory_iterator(currentDirPath)) {
-            if (entry.is_directory())
-            {
-                subfolders.emplace_back(entry.path().generic_string());
-            }
-            else if (entry.is_regular_file())
-            {
-                int32_t newNodeID = addNode(tree, currentDirID);
-                tree[newNodeID].path = entry.path().generic_string();
-                tree[newNodeID].size = entry.file_size();
-
-                currentDirFilesSize += entry.file_size();
-            }
-            else
-            {
-                picoOut("WTF {}", entry.path().generic_string());
-            }
-        }
-
-        // accumulated size in current dir from local files is propagated up
-        tree[currentDirID].size = currentDirFilesSize;
-        for (auto it = traversalParentID.rbegin(); it != traversalParentID.rend(); ++it)
-        {
-            tree[*it].size += currentDirFilesSize;
-        }
-
-        if (subfolders.size())
-        {
-            // Add the currentDir to the traversal path and add it to the queue dive in
-            traversalParentID.emplace_back(currentDirID);
-            traversalNumSubFolders.emplace_back(subfolders.size());
-
-            for (auto it = subfolders.rbegin(); it != subfolders.rend(); ++it)
-            {
-                queue.emplace_back(*it);
-            }
-        }
-        else if (traversalNumSubFolders.size())
-        {
-            // Just went through a sub folder of the traversalfolder tail
-            // remove one from the count,
-            // if reach 0 then we know we are going back up one level
-            traversalNumSubFolders.back()--;
-            if (traversalNumSubFolders.back() <= 0)
-            {
-                traversalParentID.pop_back();
-                traversalNumSubFolders.pop_back();
-            }
-        }
-    }
-
-    return tree;
-}
-
-void printNodeTree(Nodes& tree)
+void printNodeTree(const Nodes& tree)
 {
 
     int NumNodes = tree.size();
@@ -251,163 +139,6 @@ void printNodeTree(Nodes& tree)
     }
 }
 
-IDs gatherChildren(const Nodes& tree, int32_t node)
-{
-    IDs children;
-    auto& p = tree[node];
-    int32_t next = p.childBegin;
-    while (next >= 0)
-    {
-        children.emplace_back(next);
-
-        if (next == p.childEnd)
-            break;
-
-        next = tree[next].sybling;
-    }
-
-    return children;
-}
-
-using RectAreas = std::vector<double>;
-
-double layoutWorst(const RectAreas& collection, IDs& row, double width, double totalArea)
-{
-    double width2 = width * width;
-    double totalArea2 = totalArea * totalArea;
-
-    double maxArea;
-    double minArea;
-    maxArea = minArea = collection[row[0]];
-
-    for (int i = 1; i < row.size(); ++i)
-    {
-        maxArea = std::max(maxArea, collection[row[i]]);
-        minArea = std::min(minArea, collection[row[i]]);
-    }
-
-    return std::max(width2 * maxArea / totalArea2, totalArea2 / (width2 * minArea));
-}
-
-void layoutRow(std::vector<core::vec4>& treemap, const IDs& collectionIDs, const RectAreas& collectionAreas, const IDs& collectionOrder, const core::vec4& rootRect, int32_t& next, core::vec2& cornerOffset)
-{
-    IDs row = { collectionOrder[next] };
-    double rowArea = collectionAreas[collectionOrder[next]];
-    next++;
-
-    // determine next row direction based on the remaining space shape
-    core::vec2 rootSize(rootRect.z - cornerOffset.x, rootRect.w - cornerOffset.y);
-    int32_t direction = (rootSize.x > rootSize.y ? 1 : 0); // vertical or horizontal growth
-    double rootSide = rootSize[direction];
-
-    // single rect to layout in a row, just skip row placement and occupy the row
-    if (next < collectionIDs.size())
-    {
-        double bestaspectratio = layoutWorst(collectionAreas, row, rootSide, rowArea);
-
-        double newaspectratio = bestaspectratio;
-        while (next < collectionIDs.size())
-        {
-            row.emplace_back(collectionOrder[next]);
-            newaspectratio = layoutWorst(collectionAreas, row, rootSide, rowArea);
-            if (newaspectratio > bestaspectratio)
-            {
-                row.pop_back();
-                break;
-            }
-
-            // keep the rect in the row, add its area to the row
-            bestaspectratio = newaspectratio;
-            rowArea += collectionAreas[collectionOrder[next]];
-
-            next++; // rect at next is in the row and will be kept, move on
-        }
-    }
-
-    // Place the rect in the row
-    int32_t otherDirection = !direction;
-    double rowOtherSide = rowArea / rootSide;
-    double sideOffset = cornerOffset[direction];
-    double otherSideOffset = cornerOffset[otherDirection];
-    for (auto i : row)
-    {
-        int32_t id = collectionIDs[i];
-        double area = collectionAreas[i];
-        double rectSide = rootSide * area / rowArea ;
- 
-        auto & rect = treemap[id];
-
-        rect[direction] = rootRect[direction] + sideOffset;
-        rect[otherDirection] = rootRect[otherDirection] + otherSideOffset;
-        rect[2 + direction] = rectSide;
-        rect[2 + otherDirection] = rowOtherSide;
-
-        sideOffset += rectSide;
-    }
-
-    cornerOffset[otherDirection] += rowOtherSide;
-}
-
-IDs layoutRect(const Nodes& tree, std::vector<core::vec4>& treemap, int32_t root)
-{
-    // collect the children of the root
-    auto collectionIDs = gatherChildren(tree, root);
-    if (collectionIDs.empty())
-        return collectionIDs;
-
-    // allocate the areas of the children rect
-    RectAreas collectionAreas;
-    collectionAreas.reserve(collectionIDs.size());
-    int64_t rootSize = tree[root].size;
-    const auto& rootRect = treemap[root];
-    double rootRectArea = rootRect.z * rootRect.w;
-    double rootSizeInv = rootRectArea / (double)rootSize;
-    for (auto id : collectionIDs)
-    {
-        collectionAreas.emplace_back((double) tree[id].size * rootSizeInv);
-    }
-
-    // sort the collection IDs and Areas in descending order
-    std::vector<int32_t> indices(collectionIDs.size());
-    for (int32_t i = 0; i < indices.size(); ++i) {
-        indices[i] = i;
-    }
-    std::sort(indices.begin(), indices.end(), [&collectionAreas](int32_t a, int32_t b) {
-        return collectionAreas[a] > collectionAreas[b]; // Use < for ascending, > for descending
-    });
-
-
-    // And layout
-    int32_t next = 0;
-    core::vec2 offset = 0;
-    while (next < collectionIDs.size())
-    {
-        layoutRow(treemap, collectionIDs, collectionAreas, indices, rootRect, next, offset);
-    }
-
-    return collectionIDs;
-}
-
-std::vector<core::vec4> buildTreemap(const Nodes& tree, const core::vec2& origin, const core::vec2& size)
-{
-    std::vector<core::vec4> treemap;
-    treemap.resize(tree.size());
-    treemap[0] = { origin.x, origin.y, size.x, size.y };
-
-    IDs queue = { 0 };
-
-    while (queue.size())
-    {
-        auto collection = layoutRect(tree, treemap, queue.back());
-
-        queue.pop_back();
-        queue.insert(queue.begin(), collection.begin(), collection.end());
-    }
-
-
-    return treemap;
-}
-
 //--------------------------------------------------------------------------------------
 int main(int argc, char *argv[])
 {
@@ -422,13 +153,19 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-   // auto tree = createNodeTree("C:/sam/dev/pico/test");
-   //auto tree = createNodeTree("C:/Users/samca/Pictures");
-   // auto tree = createNodeTree("C:/Users/samca/Pictures/Screenshots");
-    auto tree = createNodeTree("C:/Dev/pico");
+   // auto tree = document::FileTree::scan("C:/sam/dev/pico/test");
+   //auto tree = document::FileTree::scan("C:/Users/samca/Pictures");
+   // auto tree = document::FileTree::scan("C:/Users/samca/Pictures/Screenshots");
+    auto tree = document::FileTree::scan("C:/Dev/pico");
+    if (!tree) {
+        return 1;
+    }
 
+    printNodeTree(tree->_nodes);
 
-    printNodeTree(tree);
+    // The children orders are sorted once, a resize only lays out the rects again
+    document::Treemap treemap;
+    treemap.build(*tree);
 
     // Renderer creation
 
@@ -441,7 +178,8 @@ int main(int argc, char *argv[])
 
     // Let's allocate buffer
     // quad
-    std::vector<core::vec4> rectData = buildTreemap(tree, { 0, 0 }, { 640.0, 480.0 });
+    std::vector<core::vec4> rectData;
+    treemap.layout({ 0, 0 }, { 640.0, 480.0 }, rectData);
 
     graphics::BufferInit rectBufferInit{};
     rectBufferInit.usage = graphics::ResourceUsage::RESOURCE_BUFFER;
@@ -593,8 +331,8 @@ int main(int argc, char *argv[])
 
         if (e.done)
         {
-            std::vector<core::vec4> rectLayout = buildTreemap(tree, {0, 0}, { (float)e.width, (float)e.height });
-            memcpy(rectBuffer->_cpuMappedAddress, rectLayout.data(), rectBufferInit.bufferSize);
+            treemap.layout({ 0, 0 }, { (float)e.width, (float)e.height }, rectData);
+            memcpy(rectBuffer->_cpuMappedAddress, rectData.data(), rectBufferInit.bufferSize);
         }
         gpuDevice->resizeSwapchain(swapchain, e.width, e.height);
     };